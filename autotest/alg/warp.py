@@ -1696,6 +1696,282 @@ def warp_52():
 
     return 'success'
 
+###############################################################################
+# Test FILTER_LUT_RESOLUTION warp option (tabulated filter weights)
+
+def warp_53():
+
+    src_ds = gdal.Open('../gcore/data/byte.tif')
+
+    for resampling in [ 'cubicspline', 'lanczos', 'cubic' ]:
+        ref_ds = gdal.Warp('', src_ds, format = 'MEM',
+                           xRes = 45, yRes = 45, resampleAlg = resampling)
+
+        ds = gdal.Warp('', src_ds, format = 'MEM',
+                       xRes = 45, yRes = 45, resampleAlg = resampling,
+                       warpOptions = [ 'FILTER_LUT_RESOLUTION=1024' ])
+        maxdiff = gdaltest.compare_ds(ds, ref_ds, verbose = 0)
+        if maxdiff > 1:
+            gdaltest.post_reason('Image too different from reference')
+            print(resampling)
+            print(maxdiff)
+            return 'fail'
+
+        # Tables too large: option ignored
+        ds = gdal.Warp('', src_ds, format = 'MEM',
+                       xRes = 45, yRes = 45, resampleAlg = resampling,
+                       warpOptions = [ 'FILTER_LUT_RESOLUTION=100000000' ])
+        if ds.GetRasterBand(1).Checksum() != ref_ds.GetRasterBand(1).Checksum():
+            gdaltest.post_reason('fail')
+            print(resampling)
+            return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that the typed resampling of masked sources gives the same results as
+# the general case, and exactly the same results with and without AVX2
+
+def warp_54_warp(src_ds, datatype, resampling, xres, options = []):
+    return gdal.Warp('', src_ds, format = 'MEM',
+                     outputType = datatype, srcNodata = 107,
+                     xRes = xres, yRes = xres,
+                     resampleAlg = resampling,
+                     warpOptions = options)
+
+def warp_54_cases():
+    cases = []
+    for datatype in [ gdal.GDT_Byte, gdal.GDT_Int16, gdal.GDT_UInt16,
+                      gdal.GDT_Float32, gdal.GDT_Float64 ]:
+        for resampling in [ 'bilinear', 'cubic', 'cubicspline', 'lanczos' ]:
+            for xres in [ 45, 150 ]:
+                cases.append( (datatype, resampling, xres) )
+    return cases
+
+# Run in a separate process, as GDAL_USE_AVX2 is only read once
+def warp_54_print_hashes(use_avx2):
+    import hashlib
+    gdal.SetConfigOption('GDAL_USE_AVX2', use_avx2)
+    src_ds = gdal.Open('../gcore/data/byte.tif')
+    for (datatype, resampling, xres) in warp_54_cases():
+        ds = warp_54_warp(src_ds, datatype, resampling, xres)
+        print('%d %s %d %s' % (datatype, resampling, xres,
+              hashlib.md5(ds.ReadRaster()).hexdigest()))
+
+def warp_54():
+
+    src_ds = gdal.Open('../gcore/data/byte.tif')
+
+    for (datatype, resampling, xres) in warp_54_cases():
+        ref_ds = warp_54_warp(src_ds, datatype, resampling, xres,
+                              [ 'USE_GENERAL_CASE=YES' ])
+        ds = warp_54_warp(src_ds, datatype, resampling, xres)
+        maxdiff = gdaltest.compare_ds(ds, ref_ds, verbose = 0)
+        if maxdiff > 1:
+            gdaltest.post_reason('Image too different from reference')
+            print(gdal.GetDataTypeName(datatype))
+            print(resampling)
+            print(xres)
+            print(maxdiff)
+            return 'fail'
+
+    python_exe = sys.executable
+    if sys.platform == 'win32':
+        python_exe = python_exe.replace('\\', '/')
+
+    ret_no_avx2 = gdaltest.runexternal(python_exe + ' warp.py warp_54 NO')
+    ret_avx2 = gdaltest.runexternal(python_exe + ' warp.py warp_54 YES')
+    if len(ret_no_avx2.split('\n')) < len(warp_54_cases()) or \
+       ret_avx2 != ret_no_avx2:
+        gdaltest.post_reason('AVX2 and scalar results differ')
+        print(ret_no_avx2)
+        print(ret_avx2)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that the order of the chunks and the reuse of the source pixels of the
+# previous chunks do not change the result, and that source pixels are
+# actually reused
+
+class warp_55_timing_handler:
+    def __init__(self):
+        self.reused = None
+
+    # Collects the number of reused pixels from the total timing message
+    def handler(self, err_type, err_no, err_msg):
+        if err_type == gdal.CE_Debug and \
+           err_msg.find(' reused from the previous chunks') >= 0:
+            self.reused = int(err_msg.split(', ')[-1].split(' ')[0])
+
+def warp_55():
+
+    src_ds = gdal.Open('../gcore/data/utmsmall.tif')
+
+    for multithread in [ False, True ]:
+        ref_ds = gdal.Warp('', src_ds, format = 'MEM',
+                           xRes = 5, yRes = 5, resampleAlg = 'cubic',
+                           warpMemoryLimit = 100000,
+                           multithread = multithread,
+                           warpOptions = [ 'REUSE_SOURCE_BUFFER=NO' ])
+        ref_cs = ref_ds.GetRasterBand(1).Checksum()
+
+        for options in [ [], [ 'CHUNK_ORDER=HILBERT' ],
+                         [ 'CHUNK_ORDER=HILBERT', 'REUSE_SOURCE_BUFFER=NO' ] ]:
+            timing_handler = warp_55_timing_handler()
+            gdal.PushErrorHandler(timing_handler.handler)
+            gdal.SetConfigOption('CPL_DEBUG', 'WARP_TIMING')
+            ds = gdal.Warp('', src_ds, format = 'MEM',
+                           xRes = 5, yRes = 5, resampleAlg = 'cubic',
+                           warpMemoryLimit = 100000,
+                           multithread = multithread,
+                           warpOptions = options + [ 'REPORT_TIMINGS=YES' ])
+            gdal.SetConfigOption('CPL_DEBUG', None)
+            gdal.PopErrorHandler()
+            cs = ds.GetRasterBand(1).Checksum()
+            if cs != ref_cs:
+                gdaltest.post_reason('fail')
+                print(multithread)
+                print(options)
+                print(cs, ref_cs)
+                return 'fail'
+
+            if 'REUSE_SOURCE_BUFFER=NO' in options:
+                reuse_ok = timing_handler.reused == 0
+            else:
+                reuse_ok = timing_handler.reused is not None and \
+                           timing_handler.reused > 0
+            if not reuse_ok:
+                gdaltest.post_reason('fail')
+                print(multithread)
+                print(options)
+                print(timing_handler.reused)
+                return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that warping several chunks in parallel gives the same result as
+# warping them one at a time, with the same memory per chunk
+
+def warp_56():
+
+    src_ds = gdal.Open('../gcore/data/utmsmall.tif')
+
+    ref_ds = gdal.Warp('', src_ds, format = 'MEM',
+                       xRes = 5, yRes = 5, resampleAlg = 'cubic',
+                       errorThreshold = 0, warpMemoryLimit = 100000)
+    ref_cs = ref_ds.GetRasterBand(1).Checksum()
+
+    for depth in [ 2, 4 ]:
+        ds = gdal.Warp('', src_ds, format = 'MEM',
+                       xRes = 5, yRes = 5, resampleAlg = 'cubic',
+                       errorThreshold = 0, warpMemoryLimit = 100000 * depth,
+                       multithread = True,
+                       warpOptions = [ 'CHUNK_PIPELINE_DEPTH=%d' % depth ])
+        cs = ds.GetRasterBand(1).Checksum()
+        if cs != ref_cs:
+            gdaltest.post_reason('fail')
+            print(depth)
+            print(cs, ref_cs)
+            return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that, with the default pipeline depth, all the chunks in flight fit
+# together in the warp memory limit
+
+class warp_57_chunks_handler:
+    def __init__(self):
+        self.chunks = None
+        self.chunk_size = None
+        self.in_flight = None
+
+    # Collects the number of chunks, the chunk size and the depth from the
+    # pipeline debug message
+    def handler(self, err_type, err_no, err_msg):
+        if err_type == gdal.CE_Debug and err_msg.find(' in flight') >= 0:
+            fields = err_msg.split(' ')
+            self.chunks = int(fields[fields.index('chunks') - 1])
+            self.chunk_size = float(fields[fields.index('bytes,') - 1])
+            self.in_flight = int(fields[fields.index('in') - 1])
+
+def warp_57():
+
+    src_ds = gdal.Open('../gcore/data/utmsmall.tif')
+
+    chunks_handler = warp_57_chunks_handler()
+    gdal.PushErrorHandler(chunks_handler.handler)
+    gdal.SetConfigOption('CPL_DEBUG', 'WARP')
+    ds = gdal.Warp('', src_ds, format = 'MEM',
+                   xRes = 5, yRes = 5, resampleAlg = 'cubic',
+                   errorThreshold = 0, warpMemoryLimit = 600000,
+                   multithread = True)
+    gdal.SetConfigOption('CPL_DEBUG', None)
+    gdal.PopErrorHandler()
+    cs = ds.GetRasterBand(1).Checksum()
+
+    if chunks_handler.chunk_size is None or \
+       chunks_handler.in_flight < 2 or \
+       chunks_handler.chunk_size > 600000 / 2 or \
+       chunks_handler.chunk_size * chunks_handler.in_flight > 600000:
+        gdaltest.post_reason('fail')
+        print(chunks_handler.chunk_size, chunks_handler.in_flight)
+        return 'fail'
+
+    # The chunks are the ones of a single threaded warp with that limit
+    ref_ds = gdal.Warp('', src_ds, format = 'MEM',
+                       xRes = 5, yRes = 5, resampleAlg = 'cubic',
+                       errorThreshold = 0,
+                       warpMemoryLimit = chunks_handler.chunk_size)
+    ref_cs = ref_ds.GetRasterBand(1).Checksum()
+    if cs != ref_cs:
+        gdaltest.post_reason('fail')
+        print(cs, ref_cs)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that the source buffer kept for the next chunk is counted in the warp
+# memory limit, which makes the chunks smaller, without changing the result
+
+def warp_58():
+
+    # Downsampling, so that the source buffers make most of the chunk cost
+    src_ds = gdal.Translate('', '../gcore/data/utmsmall.tif', format = 'MEM',
+                            width = 1000, height = 1000)
+
+    chunks = []
+    checksums = []
+    for reuse in [ 'NO', 'YES' ]:
+        chunks_handler = warp_57_chunks_handler()
+        gdal.PushErrorHandler(chunks_handler.handler)
+        gdal.SetConfigOption('CPL_DEBUG', 'WARP')
+        ds = gdal.Warp('', src_ds, format = 'MEM',
+                       xRes = 60, yRes = 60, resampleAlg = 'average',
+                       errorThreshold = 0, warpMemoryLimit = 600000,
+                       multithread = True,
+                       warpOptions = [ 'REUSE_SOURCE_BUFFER=' + reuse ])
+        gdal.SetConfigOption('CPL_DEBUG', None)
+        gdal.PopErrorHandler()
+        chunks.append(chunks_handler.chunks)
+        checksums.append(ds.GetRasterBand(1).Checksum())
+
+    if chunks[0] is None or chunks[1] is None or chunks[1] <= chunks[0]:
+        gdaltest.post_reason('fail')
+        print(chunks)
+        return 'fail'
+
+    if checksums[1] != checksums[0]:
+        gdaltest.post_reason('fail')
+        print(checksums)
+        return 'fail'
+
+    return 'success'
+
 gdaltest_list = [
     warp_1,
     warp_1_short,
@@ -1765,12 +2041,22 @@ gdaltest_list = [
     warp_49,
     warp_50,
     warp_51,
-    warp_52
+    warp_52,
+    warp_53,
+    warp_54,
+    warp_55,
+    warp_56,
+    warp_57,
+    warp_58
     ]
 
 
 if __name__ == '__main__':
 
+    if len(sys.argv) == 3 and sys.argv[1] == 'warp_54':
+        warp_54_print_hashes(sys.argv[2])
+        sys.exit(0)
+
     gdaltest.setup_run( 'warp' )
 
     gdaltest.run_tests( gdaltest_list )
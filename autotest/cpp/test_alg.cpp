@@ -31,6 +31,11 @@
 #include <tut_gdal.h>
 
 #include <gdal_alg.h>
+#include <cpl_conv.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 namespace tut
 {
@@ -82,4 +87,86 @@ namespace tut
         ensure_approx_equals(data.y, 0.0);
         GDAL_CG_Destroy(hCG);
     }
+
+    static int nPolarCalls = 0;
+
+    // Polar-like mapping around (100, 100), that fails near the pole
+    static int PolarTransform( void *pCBData, int, int nPoints,
+                               double *x, double *y, double *,
+                               int *panSuccess )
+    {
+        if( pCBData != NULL )
+            nPolarCalls++;
+        for( int i = 0; i < nPoints; i++ )
+        {
+            const double dfDX = x[i] - 100.0;
+            const double dfDY = y[i] - 100.0;
+            const double dfR = sqrt(dfDX * dfDX + dfDY * dfDY);
+            panSuccess[i] = dfR > 2.0;
+            x[i] = atan2(dfDY, dfDX) * 360.0 / M_PI;
+            y[i] = 90.0 - dfR * 0.5 - 1e-3 * dfR * dfR;
+        }
+        return TRUE;
+    }
+
+    // Transform nXSize x nYSize pixel centers with the approximate
+    // transformer of PolarTransform(), and return the maximum error
+    static double ApproxPolarTransform( int nXSize, int nYSize,
+                                        double dfMaxError )
+    {
+        void* hApprox = GDALCreateApproxTransformer( PolarTransform,
+                                                     &nPolarCalls,
+                                                     dfMaxError );
+        nPolarCalls = 0;
+        double dfMaxDiff = 0.0;
+        std::vector<double> adfX(nXSize), adfY(nXSize), adfZ(nXSize);
+        std::vector<double> adfXRef(nXSize), adfYRef(nXSize), adfZRef(nXSize);
+        std::vector<int> anSuccess(nXSize), anSuccessRef(nXSize);
+        for( int iY = 0; iY < nYSize; iY++ )
+        {
+            for( int iX = 0; iX < nXSize; iX++ )
+            {
+                adfX[iX] = adfXRef[iX] = iX + 0.5;
+                adfY[iX] = adfYRef[iX] = iY + 0.5;
+                adfZ[iX] = adfZRef[iX] = 0.0;
+            }
+            ensure( GDALApproxTransform( hApprox, TRUE, nXSize,
+                                         &adfX[0], &adfY[0], &adfZ[0],
+                                         &anSuccess[0] ) );
+            PolarTransform( NULL, TRUE, nXSize,
+                            &adfXRef[0], &adfYRef[0], &adfZRef[0],
+                            &anSuccessRef[0] );
+            for( int iX = 0; iX < nXSize; iX++ )
+            {
+                ensure_equals( anSuccess[iX], anSuccessRef[iX] );
+                if( anSuccess[iX] )
+                {
+                    dfMaxDiff = std::max(dfMaxDiff,
+                                         fabs(adfX[iX] - adfXRef[iX]) +
+                                         fabs(adfY[iX] - adfYRef[iX]));
+                }
+            }
+        }
+        GDALDestroyApproxTransformer( hApprox );
+        return dfMaxDiff;
+    }
+
+    // Test the 2D grid mode of the approximate transformer
+    template<>
+    template<>
+    void object::test<2>()
+    {
+        const double dfMaxError = 0.125;
+        ApproxPolarTransform( 300, 200, dfMaxError );
+        const int nScanlineCalls = nPolarCalls;
+
+        CPLSetConfigOption("GDAL_APPROX_TRANSFORMER_GRID", "32");
+        const double dfMaxDiff = ApproxPolarTransform( 300, 200, dfMaxError );
+        CPLSetConfigOption("GDAL_APPROX_TRANSFORMER_GRID", NULL);
+
+        // The error is only checked at the center and on the edges of the
+        // cells, so allow some margin
+        ensure( dfMaxDiff < 2 * dfMaxError );
+        ensure( nPolarCalls * 4 < nScanlineCalls );
+    }
 } // namespace tut
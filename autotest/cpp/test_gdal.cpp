@@ -282,4 +282,104 @@ namespace tut
         GetGDALDriverManager()->DeregisterDriver( poDriver );
         delete poDriver;
     }
+
+    // Test that GDALComputeRasterStatisticsAndHistogram() gives the same
+    // results as GDALComputeRasterStatistics() and GDALGetRasterHistogramEx()
+    template<> template<> void object::test<10>()
+    {
+        const GDALDataType aeTypes[] = { GDT_Byte, GDT_UInt16, GDT_Int16,
+                                         GDT_Float32 };
+        for( size_t iType = 0; iType < sizeof(aeTypes)/sizeof(aeTypes[0]);
+             iType++ )
+        {
+            GDALDatasetH hDS = GDALCreate(GDALGetDriverByName("MEM"), "",
+                                          100, 50, 1, aeTypes[iType], NULL);
+            GDALRasterBandH hBand = GDALGetRasterBand(hDS, 1);
+            double adfLine[100];
+            for( int iY = 0; iY < 50; iY++ )
+            {
+                for( int iX = 0; iX < 100; iX++ )
+                    adfLine[iX] = (iX * 7 + iY * 13) % 97 - 10;
+                GDALRasterIO(hBand, GF_Write, 0, iY, 100, 1, adfLine, 100, 1,
+                             GDT_Float64, 0, 0);
+            }
+            GDALSetRasterNoDataValue(hBand, 3);
+
+            double dfMin, dfMax, dfMean, dfStdDev;
+            ensure_equals( GDALComputeRasterStatistics(hBand, FALSE,
+                                &dfMin, &dfMax, &dfMean, &dfStdDev,
+                                NULL, NULL), CE_None );
+            GUIntBig anHistogram[25];
+            ensure_equals( GDALGetRasterHistogramEx(hBand, -0.5, 99.5, 25,
+                                anHistogram, TRUE, FALSE, NULL, NULL),
+                           CE_None );
+
+            double dfMin2, dfMax2, dfMean2, dfStdDev2;
+            GUIntBig anHistogram2[25];
+            ensure_equals( GDALComputeRasterStatisticsAndHistogram(hBand,
+                                FALSE, &dfMin2, &dfMax2, &dfMean2, &dfStdDev2,
+                                -0.5, 99.5, 25, anHistogram2, TRUE,
+                                NULL, NULL), CE_None );
+            ensure_equals( dfMin2, dfMin );
+            ensure_equals( dfMax2, dfMax );
+            ensure_equals( dfMean2, dfMean );
+            ensure_equals( dfStdDev2, dfStdDev );
+            for( int i = 0; i < 25; i++ )
+                ensure_equals( anHistogram2[i], anHistogram[i] );
+            GDALClose(hDS);
+        }
+    }
+
+    static int nDeferredRegisterCalls = 0;
+
+    static void GDALRegister_DeferredTest()
+    {
+        nDeferredRegisterCalls++;
+        GDALDriver* poDriver = new GDALDriver();
+        poDriver->SetDescription("DeferredTest");
+        GetGDALDriverManager()->RegisterDriver( poDriver );
+    }
+
+    // Test GDALDriverManager::DeclareDeferredDriver()
+    template<> template<> void object::test<11>()
+    {
+        GDALDriverManager* poDM = GetGDALDriverManager();
+        const int nCount = poDM->GetDriverCount();
+        poDM->DeclareDeferredDriver( "DeferredTest",
+                                     GDALRegister_DeferredTest );
+        ensure_equals( poDM->GetDriverCount(), nCount + 1 );
+        ensure_equals( nDeferredRegisterCalls, 0 );
+
+        // The driver is registered at the position of its stub on first use
+        GDALDriver* poDriver = poDM->GetDriver( nCount );
+        ensure_equals( nDeferredRegisterCalls, 1 );
+        ensure( poDriver != NULL );
+        ensure_equals( std::string(poDriver->GetDescription()),
+                       std::string("DeferredTest") );
+        ensure_equals( poDM->GetDriverCount(), nCount + 1 );
+        ensure( poDM->GetDriverByName("DeferredTest") == poDriver );
+        ensure_equals( nDeferredRegisterCalls, 1 );
+        poDM->DeregisterDriver( poDriver );
+        delete poDriver;
+
+        // Lookup by name also registers it
+        poDM->DeclareDeferredDriver( "DeferredTest",
+                                     GDALRegister_DeferredTest );
+        poDriver = poDM->GetDriverByName("DeferredTest");
+        ensure_equals( nDeferredRegisterCalls, 2 );
+        ensure( poDriver != NULL );
+        ensure( poDM->GetDriver( nCount ) == poDriver );
+        poDM->DeregisterDriver( poDriver );
+        delete poDriver;
+
+        // Declaring an already registered driver registers it right away,
+        // so that the register function can deal with the conflict
+        poDM->DeclareDeferredDriver( "GTiff", GDALRegister_DeferredTest );
+        ensure_equals( nDeferredRegisterCalls, 3 );
+        poDriver = poDM->GetDriverByName("DeferredTest");
+        ensure( poDriver != NULL );
+        poDM->DeregisterDriver( poDriver );
+        delete poDriver;
+        ensure_equals( poDM->GetDriverCount(), nCount );
+    }
 } // namespace tut
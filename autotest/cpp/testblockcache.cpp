@@ -33,6 +33,11 @@
 
 #include <stdlib.h>
 #include <assert.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
 #include <vector>
 
 #include "cpl_multiproc.h"
@@ -43,15 +48,16 @@ CPLLock* psLock = NULL;
 void Usage()
 {
     printf("Usage: testblockcache [-threads X] [-loops X] [-max_requests X] [-strategy random|line|block]\n");
-    printf("                      [-migrate] [ filename |\n");
+    printf("                      [-migrate] [-oo key=value]* [ filename |\n");
     printf("                       [[-xsize val] [-ysize val] [-bands val] [-co key=value]*\n");
-    printf("                       [[-memdriver] | [-ondisk]] [-check]] ]\n");
+    printf("                       [[-memdriver] | [-ondisk]] [-check]] ] [-bench]\n");
     exit(1);
 }
 
 int nLoops = 1;
 const char* pszDataset = NULL;
 int bCheck = FALSE;
+GIntBig nTotalRequestedPixels = 0;
 
 typedef enum
 {
@@ -142,6 +148,7 @@ static void AddRequest(Request*& psRequestList, Request*& psRequestLast,
     psRequest->nXWin = nXWin;
     psRequest->nYWin = nYWin;
     psRequest->nBands = nBands;
+    nTotalRequestedPixels += (GIntBig)nXWin * nYWin * nBands;
     if( psRequestLast )
         psRequestLast->psNext = psRequest;
     else
@@ -224,6 +231,20 @@ static void ThreadFuncWithMigration(void* /* _unused */)
     }
 }
 
+static double GetWallTime()
+{
+#ifdef _WIN32
+    LARGE_INTEGER nFrequency, nCounter;
+    QueryPerformanceFrequency(&nFrequency);
+    QueryPerformanceCounter(&nCounter);
+    return static_cast<double>(nCounter.QuadPart) / nFrequency.QuadPart;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+#endif
+}
+
 static int CreateRandomStrategyRequests(GDALDataset* poDS,
                                         int nMaxRequests,
                                         Request*& psRequestList,
@@ -331,6 +352,8 @@ int main(int argc, char* argv[])
     GDALDataset* poMEMDS = NULL;
     int bMigrate = FALSE;
     int nMaxRequests = -1;
+    int bBench = FALSE;
+    char** papszOpenOptions = NULL;
 
     argc = GDALGeneralCmdLineProcessor( argc, &argv, 0 );
 
@@ -408,6 +431,13 @@ int main(int argc, char* argv[])
         }
         else if( EQUAL(argv[i], "-migrate"))
             bMigrate = TRUE;
+        else if( EQUAL(argv[i], "-bench"))
+            bBench = TRUE;
+        else if( EQUAL(argv[i], "-oo") && i + 1 < argc)
+        {
+            i ++;
+            papszOpenOptions = CSLAddString(papszOpenOptions, argv[i]);
+        }
         else if( argv[i][0] == '-' )
             Usage();
         else if( pszDataset == NULL )
@@ -482,7 +512,8 @@ int main(int argc, char* argv[])
             poDS = poMEMDS;
         else
         {
-            poDS = (GDALDataset*)GDALOpen(pszDataset, GA_ReadOnly);
+            poDS = (GDALDataset*)GDALOpenEx(pszDataset, GDAL_OF_RASTER, NULL,
+                                            papszOpenOptions, NULL);
             if( poDS == NULL )
                 exit(1);
         }
@@ -534,6 +565,7 @@ int main(int argc, char* argv[])
         psLock = CPLCreateLock(LOCK_SPIN);
     }
 
+    const double dfStart = GetWallTime();
     for(i = 0; i < nThreads; i++ )
     {
         CPLJoinableThread* pThread;
@@ -545,10 +577,45 @@ int main(int argc, char* argv[])
         apsThreads.push_back(pThread);
     }
     for(i = 0; i < nThreads; i++ )
-    {
         CPLJoinThread(apsThreads[i]);
+    const double dfElapsed = GetWallTime() - dfStart;
+    if( bBench )
+    {
+        printf("threads=%d shards=%s: " CPL_FRMT_GIB " pixels in %.3f s, %.1f Mpixels/s\n",
+               nThreads, CPLGetConfigOption("GDAL_RB_SHARD_COUNT", "1"),
+               nTotalRequestedPixels, dfElapsed,
+               nTotalRequestedPixels / 1e6 / (dfElapsed > 0 ? dfElapsed : 1e-9));
+        GIntBig nHits = 0, nMisses = 0, nEvictions = 0;
+        GDALGetCacheCounters(&nHits, &nMisses, &nEvictions);
+        printf("policy=%s: " CPL_FRMT_GIB " hits, " CPL_FRMT_GIB " misses, "
+               CPL_FRMT_GIB " evictions\n",
+               CPLGetConfigOption("GDAL_RB_EVICTION_POLICY", "LRU"),
+               nHits, nMisses, nEvictions);
+    }
+    for(i = 0; i < nThreads; i++ )
+    {
         if( !bMigrate && poMEMDS == NULL )
-            GDALClose(asThreadDescription[i].poDS);
+        {
+            GDALDataset* poDS = asThreadDescription[i].poDS;
+            GDALCacheStatistics sStats;
+            poDS->GetBlockCacheStatistics(&sStats);
+            CPLDebug("TEST", "Dataset %d: " CPL_FRMT_GIB " bytes in cache, "
+                     CPL_FRMT_GIB " hits, " CPL_FRMT_GIB " misses, "
+                     CPL_FRMT_GIB " evictions", i, sStats.nBytesUsed,
+                     sStats.nHits, sStats.nMisses, sStats.nEvictions);
+            const GIntBig nQuota = poDS->GetBlockCacheQuota();
+            if( nQuota > 0 )
+            {
+                // A request may keep one block per band locked while
+                // the cache is trimmed
+                int nBlockXSize, nBlockYSize;
+                poDS->GetRasterBand(1)->GetBlockSize(&nBlockXSize, &nBlockYSize);
+                assert( sStats.nBytesUsed <= nQuota +
+                        static_cast<GIntBig>(nBlockXSize) * nBlockYSize *
+                        poDS->GetRasterCount() );
+            }
+            GDALClose(poDS);
+        }
     }
     while( psGlobalResourceList != NULL )
     {
@@ -578,6 +645,7 @@ int main(int argc, char* argv[])
 
     GDALDestroyDriverManager();
     CSLDestroy( argv );
+    CSLDestroy( papszOpenOptions );
 
     return 0;
 }
@@ -32,9 +32,76 @@
 #include <time.h>
 
 #include "gdal.h"
+#include "cpl_string.h"
 
-int main(int /* argc */, char* /* argv */ [])
+/************************************************************************/
+/*                       BenchmarkCommonTypes()                         */
+/************************************************************************/
+
+/* Report the throughput of the conversions between packed buffers of the */
+/* types that have vectorized code paths. Run with GDAL_USE_AVX2=NO to    */
+/* compare the AVX2 and SSE2 code paths. */
+
+static void BenchmarkCommonTypes()
 {
+    const GDALDataType aeTypes[] = { GDT_Byte, GDT_UInt16, GDT_Int16,
+                                     GDT_Int32, GDT_Float32, GDT_Float64 };
+    const int nTypes = static_cast<int>(sizeof(aeTypes) / sizeof(aeTypes[0]));
+    const int nWords = 256 * 256;
+    const int nIters = 2000;
+
+    // Values in the [-1000,1000] range, so that all conversions are
+    // exercised with both in range and out of range values.
+    double* padfValues = static_cast<double*>(malloc(nWords * sizeof(double)));
+    for( int i = 0; i < nWords; i++ )
+        padfValues[i] = (i % 2001) - 1000 + 0.25 * (i % 4);
+
+    void* in = malloc(nWords * 8);
+    void* out = malloc(nWords * 8);
+
+    printf("Packed conversions of %d values (Mvalues/s):\n", nWords);
+    for( int i = 0; i < nTypes; i++ )
+    {
+        GDALCopyWords(padfValues, GDT_Float64, 8,
+                      in, aeTypes[i], GDALGetDataTypeSizeBytes(aeTypes[i]),
+                      nWords);
+        for( int j = 0; j < nTypes; j++ )
+        {
+            if( i == j )
+                continue;
+            const clock_t start = clock();
+            for( int iter = 0; iter < nIters; iter++ )
+            {
+                GDALCopyWords(in, aeTypes[i],
+                              GDALGetDataTypeSizeBytes(aeTypes[i]),
+                              out, aeTypes[j],
+                              GDALGetDataTypeSizeBytes(aeTypes[j]),
+                              nWords);
+            }
+            const clock_t end = clock();
+            const double dfSeconds = (end - start) * 1.0 / CLOCKS_PER_SEC;
+            printf("%s -> %s (packed) : %.0f\n",
+                   GDALGetDataTypeName(aeTypes[i]),
+                   GDALGetDataTypeName(aeTypes[j]),
+                   dfSeconds > 0 ?
+                        1e-6 * nWords * nIters / dfSeconds : 0.0);
+        }
+    }
+
+    free(padfValues);
+    free(in);
+    free(out);
+}
+
+int main(int argc, char* argv[])
+{
+    // -common only benchmarks the conversions between common types
+    if( argc == 2 && EQUAL(argv[1], "-common") )
+    {
+        BenchmarkCommonTypes();
+        return 0;
+    }
+
     void* in = calloc(1, 256 * 256 * 16);
     void* out = malloc(256 * 256 * 16);
 
@@ -79,5 +146,7 @@ int main(int /* argc */, char* /* argv */ [])
         }
     }
 
+    BenchmarkCommonTypes();
+
     return 0;
 }
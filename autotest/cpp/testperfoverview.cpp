@@ -0,0 +1,191 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Test performance of GDALRegenerateOverviews().
+ *
+ ******************************************************************************
+ * Copyright (c) 2016, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "gdal.h"
+#include "cpl_conv.h"
+#include "cpl_string.h"
+
+/************************************************************************/
+/*                               Usage()                                */
+/************************************************************************/
+
+static void Usage()
+{
+    printf("Usage: testperfoverview [-size val] [-loops val] [-nodata]\n");
+    printf("                        [-r resampling]* [-ot type]*\n");
+    printf("\n");
+    printf("Report the throughput of GDALRegenerateOverviews() on a MEM\n");
+    printf("band, for each resampling method and data type. Run with\n");
+    printf("--config GDAL_USE_AVX2 NO to compare the AVX2 and SSE2 code paths.\n");
+    exit(1);
+}
+
+/************************************************************************/
+/*                           BenchmarkOne()                             */
+/************************************************************************/
+
+static void BenchmarkOne( GDALDriverH hMemDriver, GDALDataType eType,
+                          const char* pszResampling, int nSize, int nLoops,
+                          bool bNoData )
+{
+    GDALDatasetH hSrcDS =
+        GDALCreate(hMemDriver, "", nSize, nSize, 1, eType, NULL);
+    GDALRasterBandH hSrcBand = GDALGetRasterBand(hSrcDS, 1);
+
+    // Smooth gradient with some noise, so that the values are neither
+    // constant nor completely random
+    float* pafLine = static_cast<float*>(CPLMalloc(nSize * sizeof(float)));
+    for( int iY = 0; iY < nSize; iY++ )
+    {
+        for( int iX = 0; iX < nSize; iX++ )
+        {
+            pafLine[iX] = static_cast<float>(
+                ((iX + iY) % 200) + ((iX * 7 + iY * 13) % 37) * 0.25);
+        }
+        GDALRasterIO(hSrcBand, GF_Write, 0, iY, nSize, 1,
+                     pafLine, nSize, 1, GDT_Float32, 0, 0);
+    }
+    CPLFree(pafLine);
+    if( bNoData )
+        GDALSetRasterNoDataValue(hSrcBand, 17);
+
+    // Overviews by a factor of 2 and 4
+    GDALDatasetH ahOvrDS[2];
+    GDALRasterBandH ahOvrBands[2];
+    for( int i = 0; i < 2; i++ )
+    {
+        const int nOvrSize = (nSize + (2 << i) - 1) / (2 << i);
+        ahOvrDS[i] = GDALCreate(hMemDriver, "", nOvrSize, nOvrSize, 1,
+                                eType, NULL);
+        ahOvrBands[i] = GDALGetRasterBand(ahOvrDS[i], 1);
+    }
+
+    const clock_t start = clock();
+    for( int iLoop = 0; iLoop < nLoops; iLoop++ )
+    {
+        GDALRegenerateOverviews(hSrcBand, 2, ahOvrBands, pszResampling,
+                                NULL, NULL);
+    }
+    const clock_t end = clock();
+    const double dfSeconds = (end - start) * 1.0 / CLOCKS_PER_SEC;
+
+    printf("%-12s %-8s : %.2f s, %.1f Mpixels/s\n",
+           pszResampling, GDALGetDataTypeName(eType), dfSeconds,
+           dfSeconds > 0 ?
+                1e-6 * nSize * nSize * nLoops / dfSeconds : 0.0);
+
+    for( int i = 0; i < 2; i++ )
+        GDALClose(ahOvrDS[i]);
+    GDALClose(hSrcDS);
+}
+
+/************************************************************************/
+/*                                main()                                */
+/************************************************************************/
+
+int main(int argc, char* argv[])
+{
+    int nSize = 4096;
+    int nLoops = 5;
+    bool bNoData = false;
+    char** papszResampling = NULL;
+    char** papszTypes = NULL;
+
+    argc = GDALGeneralCmdLineProcessor(argc, &argv, 0);
+    if( argc < 1 )
+        exit(-argc);
+
+    for( int i = 1; i < argc; i++ )
+    {
+        if( EQUAL(argv[i], "-size") && i + 1 < argc )
+            nSize = atoi(argv[++i]);
+        else if( EQUAL(argv[i], "-loops") && i + 1 < argc )
+            nLoops = atoi(argv[++i]);
+        else if( EQUAL(argv[i], "-nodata") )
+            bNoData = true;
+        else if( EQUAL(argv[i], "-r") && i + 1 < argc )
+            papszResampling = CSLAddString(papszResampling, argv[++i]);
+        else if( EQUAL(argv[i], "-ot") && i + 1 < argc )
+            papszTypes = CSLAddString(papszTypes, argv[++i]);
+        else
+            Usage();
+    }
+    if( nSize <= 0 || nLoops <= 0 )
+        Usage();
+
+    if( papszResampling == NULL )
+    {
+        const char* const apszResampling[] = {
+            "NEAREST", "AVERAGE", "GAUSS", "CUBIC", "CUBICSPLINE", "LANCZOS",
+            "BILINEAR", "MODE", NULL };
+        for( int i = 0; apszResampling[i] != NULL; i++ )
+            papszResampling = CSLAddString(papszResampling, apszResampling[i]);
+    }
+    if( papszTypes == NULL )
+    {
+        papszTypes = CSLAddString(papszTypes, "Byte");
+        papszTypes = CSLAddString(papszTypes, "UInt16");
+        papszTypes = CSLAddString(papszTypes, "Float32");
+    }
+
+    GDALAllRegister();
+    GDALDriverH hMemDriver = GDALGetDriverByName("MEM");
+    if( hMemDriver == NULL )
+    {
+        fprintf(stderr, "MEM driver not available\n");
+        exit(1);
+    }
+
+    printf("%dx%d pixels, %d loops%s\n", nSize, nSize, nLoops,
+           bNoData ? ", with nodata" : "");
+    for( int iType = 0; papszTypes[iType] != NULL; iType++ )
+    {
+        const GDALDataType eType = GDALGetDataTypeByName(papszTypes[iType]);
+        if( eType == GDT_Unknown )
+        {
+            fprintf(stderr, "Unknown data type: %s\n", papszTypes[iType]);
+            exit(1);
+        }
+        for( int iRes = 0; papszResampling[iRes] != NULL; iRes++ )
+        {
+            BenchmarkOne(hMemDriver, eType, papszResampling[iRes],
+                         nSize, nLoops, bNoData);
+        }
+    }
+
+    CSLDestroy(papszResampling);
+    CSLDestroy(papszTypes);
+    CSLDestroy(argv);
+    GDALDestroyDriverManager();
+
+    return 0;
+}
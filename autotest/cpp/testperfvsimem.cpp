@@ -0,0 +1,337 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Test performance and consistency of /vsimem/ under concurrency.
+ *
+ ******************************************************************************
+ * Copyright (c) 2016, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include <vector>
+
+#include "gdal.h"
+#include "cpl_atomic_ops.h"
+#include "cpl_conv.h"
+#include "cpl_multiproc.h"
+#include "cpl_string.h"
+#include "cpl_vsi.h"
+
+/************************************************************************/
+/*                               Usage()                                */
+/************************************************************************/
+
+static void Usage()
+{
+    printf("Usage: testperfvsimem [-threads val] [-files val] [-size val]\n");
+    printf("                      [-loops val]\n");
+    printf("\n");
+    printf("Each thread creates, writes, stats, reads back and unlinks -files\n");
+    printf("/vsimem/ files of -size bytes, -loops times, as a service using\n");
+    printf("/vsimem/ as scratch space would. Then one thread appends to a\n");
+    printf("shared file while the others read it. The content of every read\n");
+    printf("is checked, and the exit status is 1 if any check failed.\n");
+    exit(1);
+}
+
+static volatile int nErrors = 0;
+static volatile int nSharedReads = 0;
+static volatile int bWriterDone = FALSE;
+
+typedef struct
+{
+    int nThread;
+    int nFiles;
+    int nSize;
+    int nLoops;
+} ThreadDescription;
+
+/* Elapsed time in seconds, with a sub-second resolution, since an */
+/* arbitrary origin. */
+static double GetWallTime()
+{
+#ifdef _WIN32
+    LARGE_INTEGER nFrequency, nCounter;
+    QueryPerformanceFrequency(&nFrequency);
+    QueryPerformanceCounter(&nCounter);
+    return static_cast<double>(nCounter.QuadPart) / nFrequency.QuadPart;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+#endif
+}
+
+static void ReportError( const char* pszMsg, const char* pszFilename )
+{
+    if( CPLAtomicInc(&nErrors) <= 10 )
+        fprintf(stderr, "%s: %s\n", pszMsg, pszFilename);
+}
+
+/************************************************************************/
+/*                          ScratchFilesFunc()                          */
+/************************************************************************/
+
+static void ScratchFilesFunc( void* pData )
+{
+    const ThreadDescription* psDesc =
+        static_cast<const ThreadDescription*>(pData);
+    const int nSize = psDesc->nSize;
+    GByte* pabyData = static_cast<GByte*>(CPLMalloc(nSize));
+    GByte* pabyRead = static_cast<GByte*>(CPLMalloc(nSize));
+
+    for( int iLoop = 0; iLoop < psDesc->nLoops; iLoop++ )
+    {
+        for( int iFile = 0; iFile < psDesc->nFiles; iFile++ )
+        {
+            const CPLString osFilename(
+                CPLSPrintf("/vsimem/testperfvsimem/t%d_%d.bin",
+                           psDesc->nThread, iFile));
+            for( int i = 0; i < nSize; i++ )
+                pabyData[i] = static_cast<GByte>(i + iFile + psDesc->nThread);
+
+            // Written in a few chunks, as a tile encoder would
+            VSILFILE* fp = VSIFOpenL(osFilename, "wb");
+            if( fp == NULL )
+            {
+                ReportError("Cannot create", osFilename);
+                continue;
+            }
+            const int nChunk = (nSize + 3) / 4;
+            for( int i = 0; i < nSize; i += nChunk )
+            {
+                const size_t nToWrite = static_cast<size_t>(
+                    (i + nChunk <= nSize) ? nChunk : nSize - i);
+                if( VSIFWriteL(pabyData + i, 1, nToWrite, fp) != nToWrite )
+                    ReportError("Cannot write", osFilename);
+            }
+            VSIFCloseL(fp);
+
+            VSIStatBufL sStat;
+            if( VSIStatL(osFilename, &sStat) != 0 || sStat.st_size != nSize )
+                ReportError("Wrong size", osFilename);
+
+            fp = VSIFOpenL(osFilename, "rb");
+            if( fp == NULL ||
+                VSIFReadL(pabyRead, 1, nSize, fp) != static_cast<size_t>(nSize) ||
+                memcmp(pabyRead, pabyData, nSize) != 0 )
+            {
+                ReportError("Wrong content", osFilename);
+            }
+            if( fp != NULL )
+                VSIFCloseL(fp);
+
+            if( VSIUnlink(osFilename) != 0 )
+                ReportError("Cannot unlink", osFilename);
+        }
+    }
+
+    CPLFree(pabyData);
+    CPLFree(pabyRead);
+}
+
+/************************************************************************/
+/*                          SharedWriterFunc()                          */
+/************************************************************************/
+
+static const char* const pszSharedFilename =
+    "/vsimem/testperfvsimem/shared.bin";
+
+static GByte SharedByte( size_t nOffset )
+{
+    return static_cast<GByte>((nOffset * 7) >> 3);
+}
+
+static void SharedWriterFunc( void* pData )
+{
+    const ThreadDescription* psDesc =
+        static_cast<const ThreadDescription*>(pData);
+    const int nSize = psDesc->nSize;
+    GByte* pabyData = static_cast<GByte*>(CPLMalloc(nSize));
+
+    VSILFILE* fp = VSIFOpenL(pszSharedFilename, "ab");
+    if( fp == NULL )
+        ReportError("Cannot open", pszSharedFilename);
+    size_t nOffset = 0;
+    for( int iFile = 0; fp != NULL && iFile < psDesc->nFiles; iFile++ )
+    {
+        for( int i = 0; i < nSize; i++ )
+            pabyData[i] = SharedByte(nOffset + i);
+        if( VSIFWriteL(pabyData, 1, nSize, fp) != static_cast<size_t>(nSize) )
+            ReportError("Cannot write", pszSharedFilename);
+        nOffset += nSize;
+    }
+    if( fp != NULL )
+        VSIFCloseL(fp);
+
+    CPLFree(pabyData);
+    CPLAtomicInc(&bWriterDone);
+}
+
+/************************************************************************/
+/*                          SharedReaderFunc()                          */
+/************************************************************************/
+
+static void SharedReaderFunc( void* /* pData */ )
+{
+    std::vector<GByte> abyRead;
+    bool bLast = false;
+    while( !bLast )
+    {
+        bLast = CPLAtomicAdd(&bWriterDone, 0) != 0;
+
+        VSILFILE* fp = VSIFOpenL(pszSharedFilename, "rb");
+        if( fp == NULL )
+        {
+            ReportError("Cannot open", pszSharedFilename);
+            break;
+        }
+
+        // The file may grow after the seek: only the bytes up to the
+        // length seen then are checked, as they will not change anymore.
+        VSIFSeekL(fp, 0, SEEK_END);
+        const size_t nLength = static_cast<size_t>(VSIFTellL(fp));
+        VSIFSeekL(fp, 0, SEEK_SET);
+        abyRead.resize(nLength + 1);
+        if( VSIFReadL(&abyRead[0], 1, nLength, fp) != nLength )
+            ReportError("Short read", pszSharedFilename);
+        for( size_t i = 0; i < nLength; i++ )
+        {
+            if( abyRead[i] != SharedByte(i) )
+            {
+                ReportError("Wrong content", pszSharedFilename);
+                break;
+            }
+        }
+        VSIFCloseL(fp);
+        CPLAtomicInc(&nSharedReads);
+    }
+}
+
+/************************************************************************/
+/*                             RunThreads()                             */
+/************************************************************************/
+
+static double RunThreads( int nThreads, CPLThreadFunc pfnFirst,
+                          CPLThreadFunc pfnOthers,
+                          std::vector<ThreadDescription>& asDesc )
+{
+    std::vector<CPLJoinableThread*> apsThreads;
+    // Wall clock time, so that the scaling with the number of threads and
+    // the time spent waiting for locks are visible
+    const double dfStart = GetWallTime();
+    for( int i = 0; i < nThreads; i++ )
+    {
+        apsThreads.push_back(CPLCreateJoinableThread(
+            i == 0 ? pfnFirst : pfnOthers, &asDesc[i]));
+    }
+    for( int i = 0; i < nThreads; i++ )
+        CPLJoinThread(apsThreads[i]);
+    return GetWallTime() - dfStart;
+}
+
+/************************************************************************/
+/*                                main()                                */
+/************************************************************************/
+
+int main(int argc, char* argv[])
+{
+    int nThreads = CPLGetNumCPUs();
+    int nFiles = 1000;
+    int nSize = 16384;
+    int nLoops = 3;
+
+    argc = GDALGeneralCmdLineProcessor(argc, &argv, 0);
+    if( argc < 1 )
+        exit(-argc);
+
+    for( int i = 1; i < argc; i++ )
+    {
+        if( EQUAL(argv[i], "-threads") && i + 1 < argc )
+            nThreads = atoi(argv[++i]);
+        else if( EQUAL(argv[i], "-files") && i + 1 < argc )
+            nFiles = atoi(argv[++i]);
+        else if( EQUAL(argv[i], "-size") && i + 1 < argc )
+            nSize = atoi(argv[++i]);
+        else if( EQUAL(argv[i], "-loops") && i + 1 < argc )
+            nLoops = atoi(argv[++i]);
+        else
+            Usage();
+    }
+    if( nThreads <= 0 || nFiles <= 0 || nSize <= 0 || nLoops <= 0 )
+        Usage();
+
+    std::vector<ThreadDescription> asDesc(nThreads);
+    for( int i = 0; i < nThreads; i++ )
+    {
+        asDesc[i].nThread = i;
+        asDesc[i].nFiles = nFiles;
+        asDesc[i].nSize = nSize;
+        asDesc[i].nLoops = nLoops;
+    }
+
+    VSIMkdir("/vsimem/testperfvsimem", 0755);
+
+    const double dfScratch = RunThreads(nThreads, ScratchFilesFunc,
+                                        ScratchFilesFunc, asDesc);
+    const double dfFileCycles = static_cast<double>(nThreads) * nFiles * nLoops;
+    printf("threads=%d, %d bytes: %.0f files written, read and unlinked "
+           "in %.3f s, %.0f files/s\n",
+           nThreads, nSize, dfFileCycles, dfScratch,
+           dfFileCycles / (dfScratch > 0 ? dfScratch : 1e-9));
+
+    char** papszLeft = VSIReadDir("/vsimem/testperfvsimem");
+    if( CSLCount(papszLeft) != 0 )
+        ReportError("Files left", "/vsimem/testperfvsimem");
+    CSLDestroy(papszLeft);
+
+    // Created beforehand, so that the readers never miss it
+    VSIFCloseL(VSIFOpenL(pszSharedFilename, "wb"));
+    // At least one reader along with the writer
+    const int nSharedThreads = (nThreads > 1) ? nThreads : 2;
+    if( nSharedThreads > nThreads )
+        asDesc.resize(nSharedThreads, asDesc[0]);
+    const double dfShared = RunThreads(nSharedThreads, SharedWriterFunc,
+                                       SharedReaderFunc, asDesc);
+    printf("threads=%d: 1 writer appended %d x %d bytes while %d readers "
+           "read the file %d times in %.3f s\n",
+           nSharedThreads, nFiles, nSize, nSharedThreads - 1,
+           nSharedReads, dfShared);
+    VSIUnlink(pszSharedFilename);
+    VSIRmdir("/vsimem/testperfvsimem");
+
+    if( nErrors != 0 )
+        printf("%d errors\n", nErrors);
+
+    CSLDestroy(argv);
+    GDALDestroyDriverManager();
+
+    return nErrors != 0 ? 1 : 0;
+}
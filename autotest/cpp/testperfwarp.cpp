@@ -0,0 +1,242 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Test performance of the warping kernel.
+ *
+ ******************************************************************************
+ * Copyright (c) 2016, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "gdal.h"
+#include "gdalwarper.h"
+#include "cpl_conv.h"
+#include "cpl_string.h"
+
+/************************************************************************/
+/*                               Usage()                                */
+/************************************************************************/
+
+static void Usage()
+{
+    printf("Usage: testperfwarp [-size val] [-loops val] [-scale val] [-nodata]\n");
+    printf("                    [-r resampling]* [-ot type]* [-wo NAME=VALUE]*\n");
+    printf("\n");
+    printf("Report the throughput of the warping kernel for a rotated and\n");
+    printf("scaled affine transformation between two MEM datasets, for each\n");
+    printf("resampling method and data type. -scale is the ratio of the target\n");
+    printf("pixel size over the source one. Use for example\n");
+    printf("-wo FILTER_LUT_RESOLUTION=1024 to compare warp options, and\n");
+    printf("--config GDAL_USE_AVX2 NO to compare the AVX2 and scalar code paths.\n");
+    exit(1);
+}
+
+/************************************************************************/
+/*                           BenchmarkOne()                             */
+/************************************************************************/
+
+static void BenchmarkOne( GDALDriverH hMemDriver, GDALDataType eType,
+                          const char* pszResampling, int nSize, int nLoops,
+                          double dfScale, bool bNoData,
+                          char** papszWarpOptions )
+{
+    GDALDatasetH hSrcDS =
+        GDALCreate(hMemDriver, "", nSize, nSize, 1, eType, NULL);
+    GDALRasterBandH hSrcBand = GDALGetRasterBand(hSrcDS, 1);
+    double adfSrcGT[6] = { 0.0, 1.0, 0.0, 0.0, 0.0, -1.0 };
+    adfSrcGT[3] = nSize;
+    GDALSetGeoTransform(hSrcDS, adfSrcGT);
+
+    // Smooth gradient with some noise, so that the values are neither
+    // constant nor completely random
+    float* pafLine = static_cast<float*>(CPLMalloc(nSize * sizeof(float)));
+    for( int iY = 0; iY < nSize; iY++ )
+    {
+        for( int iX = 0; iX < nSize; iX++ )
+        {
+            pafLine[iX] = static_cast<float>(
+                ((iX + iY) % 200) + ((iX * 7 + iY * 13) % 37) * 0.25);
+        }
+        CPL_IGNORE_RET_VAL(GDALRasterIO(hSrcBand, GF_Write, 0, iY, nSize, 1,
+                                        pafLine, nSize, 1, GDT_Float32, 0, 0));
+    }
+    CPLFree(pafLine);
+
+    // Target grid rotated by 10 degrees around the center of the source,
+    // so that the sub-pixel offsets of the source positions vary
+    const int nDstSize = static_cast<int>(nSize / dfScale);
+    const double dfAngle = 10.0 * M_PI / 180.0;
+    const double dfCos = cos(dfAngle) * dfScale;
+    const double dfSin = sin(dfAngle) * dfScale;
+    double adfDstGT[6];
+    adfDstGT[1] = dfCos;
+    adfDstGT[2] = dfSin;
+    adfDstGT[4] = dfSin;
+    adfDstGT[5] = -dfCos;
+    adfDstGT[0] = nSize / 2.0 - (adfDstGT[1] + adfDstGT[2]) * nDstSize / 2.0;
+    adfDstGT[3] = nSize / 2.0 - (adfDstGT[4] + adfDstGT[5]) * nDstSize / 2.0;
+    GDALDatasetH hDstDS =
+        GDALCreate(hMemDriver, "", nDstSize, nDstSize, 1, eType, NULL);
+    GDALSetGeoTransform(hDstDS, adfDstGT);
+
+    GDALWarpOptions* psWO = GDALCreateWarpOptions();
+    psWO->hSrcDS = hSrcDS;
+    psWO->hDstDS = hDstDS;
+    psWO->eResampleAlg = GRA_NearestNeighbour;
+    if( EQUAL(pszResampling, "BILINEAR") )
+        psWO->eResampleAlg = GRA_Bilinear;
+    else if( EQUAL(pszResampling, "CUBIC") )
+        psWO->eResampleAlg = GRA_Cubic;
+    else if( EQUAL(pszResampling, "CUBICSPLINE") )
+        psWO->eResampleAlg = GRA_CubicSpline;
+    else if( EQUAL(pszResampling, "LANCZOS") )
+        psWO->eResampleAlg = GRA_Lanczos;
+    psWO->papszWarpOptions = CSLDuplicate(papszWarpOptions);
+    psWO->nBandCount = 1;
+    psWO->panSrcBands = static_cast<int*>(CPLMalloc(sizeof(int)));
+    psWO->panSrcBands[0] = 1;
+    psWO->panDstBands = static_cast<int*>(CPLMalloc(sizeof(int)));
+    psWO->panDstBands[0] = 1;
+    if( bNoData )
+    {
+        psWO->padfSrcNoDataReal =
+            static_cast<double*>(CPLMalloc(sizeof(double)));
+        psWO->padfSrcNoDataReal[0] = 17;
+        psWO->padfSrcNoDataImag =
+            static_cast<double*>(CPLMalloc(sizeof(double)));
+        psWO->padfSrcNoDataImag[0] = 0;
+    }
+    psWO->pTransformerArg =
+        GDALCreateGenImgProjTransformer2(hSrcDS, hDstDS, NULL);
+    psWO->pfnTransformer = GDALGenImgProjTransform;
+
+    GDALWarpOperationH hWarpOp = GDALCreateWarpOperation(psWO);
+    const clock_t start = clock();
+    for( int iLoop = 0; iLoop < nLoops; iLoop++ )
+        GDALChunkAndWarpImage(hWarpOp, 0, 0, nDstSize, nDstSize);
+    const clock_t end = clock();
+    const double dfSeconds = (end - start) * 1.0 / CLOCKS_PER_SEC;
+
+    printf("%-12s %-8s : %.2f s, %.1f Mpixels/s, checksum %d\n",
+           pszResampling, GDALGetDataTypeName(eType), dfSeconds,
+           dfSeconds > 0 ?
+                1e-6 * nDstSize * nDstSize * nLoops / dfSeconds : 0.0,
+           GDALChecksumImage(GDALGetRasterBand(hDstDS, 1), 0, 0,
+                             nDstSize, nDstSize));
+
+    GDALDestroyWarpOperation(hWarpOp);
+    GDALDestroyGenImgProjTransformer(psWO->pTransformerArg);
+    GDALDestroyWarpOptions(psWO);
+    GDALClose(hDstDS);
+    GDALClose(hSrcDS);
+}
+
+/************************************************************************/
+/*                                main()                                */
+/************************************************************************/
+
+int main(int argc, char* argv[])
+{
+    int nSize = 2048;
+    int nLoops = 3;
+    double dfScale = 0.9;
+    bool bNoData = false;
+    char** papszResampling = NULL;
+    char** papszTypes = NULL;
+    char** papszWarpOptions = NULL;
+
+    argc = GDALGeneralCmdLineProcessor(argc, &argv, 0);
+    if( argc < 1 )
+        exit(-argc);
+
+    for( int i = 1; i < argc; i++ )
+    {
+        if( EQUAL(argv[i], "-size") && i + 1 < argc )
+            nSize = atoi(argv[++i]);
+        else if( EQUAL(argv[i], "-loops") && i + 1 < argc )
+            nLoops = atoi(argv[++i]);
+        else if( EQUAL(argv[i], "-scale") && i + 1 < argc )
+            dfScale = CPLAtof(argv[++i]);
+        else if( EQUAL(argv[i], "-nodata") )
+            bNoData = true;
+        else if( EQUAL(argv[i], "-r") && i + 1 < argc )
+            papszResampling = CSLAddString(papszResampling, argv[++i]);
+        else if( EQUAL(argv[i], "-ot") && i + 1 < argc )
+            papszTypes = CSLAddString(papszTypes, argv[++i]);
+        else if( EQUAL(argv[i], "-wo") && i + 1 < argc )
+            papszWarpOptions = CSLAddString(papszWarpOptions, argv[++i]);
+        else
+            Usage();
+    }
+    if( nSize <= 0 || nLoops <= 0 || dfScale <= 0 )
+        Usage();
+
+    if( papszResampling == NULL )
+    {
+        const char* const apszResampling[] = {
+            "NEAREST", "BILINEAR", "CUBIC", "CUBICSPLINE", "LANCZOS", NULL };
+        for( int i = 0; apszResampling[i] != NULL; i++ )
+            papszResampling = CSLAddString(papszResampling, apszResampling[i]);
+    }
+    if( papszTypes == NULL )
+    {
+        papszTypes = CSLAddString(papszTypes, "Byte");
+        papszTypes = CSLAddString(papszTypes, "Float32");
+    }
+
+    GDALAllRegister();
+    GDALDriverH hMemDriver = GDALGetDriverByName("MEM");
+    if( hMemDriver == NULL )
+    {
+        fprintf(stderr, "MEM driver not available\n");
+        exit(1);
+    }
+
+    printf("%dx%d pixels, scale %.3f, %d loops%s\n", nSize, nSize, dfScale,
+           nLoops, bNoData ? ", with nodata" : "");
+    for( int iType = 0; papszTypes[iType] != NULL; iType++ )
+    {
+        const GDALDataType eType = GDALGetDataTypeByName(papszTypes[iType]);
+        if( eType == GDT_Unknown )
+        {
+            fprintf(stderr, "Unknown data type: %s\n", papszTypes[iType]);
+            exit(1);
+        }
+        for( int iRes = 0; papszResampling[iRes] != NULL; iRes++ )
+        {
+            BenchmarkOne(hMemDriver, eType, papszResampling[iRes],
+                         nSize, nLoops, dfScale, bNoData, papszWarpOptions);
+        }
+    }
+
+    CSLDestroy(papszResampling);
+    CSLDestroy(papszTypes);
+    CSLDestroy(papszWarpOptions);
+    CSLDestroy(argv);
+    GDALDestroyDriverManager();
+
+    return 0;
+}
@@ -492,6 +492,73 @@ def stats_dbl_min():
 
     return 'success'
 
+###############################################################################
+# Test the type specialized statistics code paths, with and without nodata,
+# on tiled rasters whose blocks are processed by several threads
+
+def stats_all_types_multi_threaded():
+
+    import struct
+
+    width = 300
+    height = 200
+    values = [ ((i * 37) % 251) for i in range(width * height) ]
+    values[1] = 0
+    values[width * height - 1] = 250
+
+    for (dt, fmt, scale, offset) in [ (gdal.GDT_Byte, 'B', 1, 0),
+                                      (gdal.GDT_UInt16, 'H', 256, 7),
+                                      (gdal.GDT_Int16, 'h', 250, -32000),
+                                      (gdal.GDT_Float32, 'f', 0.5, -10.25),
+                                      (gdal.GDT_Float64, 'd', 1e-3, 1e6) ]:
+        data = [ v * scale + offset for v in values ]
+        nodata = data[0]
+        valid = [ v for v in data if v != nodata ]
+        mean = sum(valid) / float(len(valid))
+        stddev = (sum([ (v - mean) * (v - mean) for v in valid ]) / len(valid)) ** 0.5
+
+        ds = gdal.GetDriverByName('GTiff').Create('/vsimem/stats_all_types.tif', width, height, 1, dt,
+                                                   options = ['TILED=YES', 'BLOCKXSIZE=64', 'BLOCKYSIZE=32'])
+        ds.GetRasterBand(1).WriteRaster(0, 0, width, height, struct.pack(fmt * (width * height), *data))
+        ds = None
+
+        all_stats = []
+        for num_threads in [ None, '3' ]:
+            for use_nodata in [ False, True ]:
+                ds = gdal.Open('/vsimem/stats_all_types.tif')
+                if use_nodata:
+                    ds.GetRasterBand(1).SetNoDataValue(nodata)
+                gdal.SetConfigOption('GDAL_NUM_THREADS', num_threads)
+                stats = ds.GetRasterBand(1).ComputeStatistics(False)
+                minmax = ds.GetRasterBand(1).ComputeRasterMinMax(False)
+                gdal.SetConfigOption('GDAL_NUM_THREADS', None)
+                ds = None
+                all_stats.append(stats)
+
+                if use_nodata:
+                    expected = [ min(valid), max(valid), mean, stddev ]
+                else:
+                    expected = [ min(data), max(data), sum(data) / float(len(data)), None ]
+                if stats[0] != expected[0] or stats[1] != expected[1] or \
+                   minmax != (expected[0], expected[1]) or \
+                   abs(stats[2] - expected[2]) > 1e-10 * abs(expected[2]) + 1e-10 or \
+                   (expected[3] is not None and abs(stats[3] - expected[3]) > 1e-8 * expected[3]):
+                    gdaltest.post_reason('did not get expected stats')
+                    print(gdal.GetDataTypeName(dt), use_nodata, num_threads)
+                    print(stats, minmax, expected)
+                    return 'fail'
+
+        # The result does not depend on the number of threads
+        if all_stats[0:2] != all_stats[2:4]:
+            gdaltest.post_reason('did not get same stats with several threads')
+            print(gdal.GetDataTypeName(dt))
+            print(all_stats)
+            return 'fail'
+
+        gdal.GetDriverByName('GTiff').Delete('/vsimem/stats_all_types.tif')
+
+    return 'success'
+
 ###############################################################################
 # Run tests
 
@@ -515,7 +582,8 @@ gdaltest_list = [
     stats_stddev_huge_values,
     stats_square_shape,
     stats_flt_min,
-    stats_dbl_min
+    stats_dbl_min,
+    stats_all_types_multi_threaded
     ]
 
 if __name__ == '__main__':
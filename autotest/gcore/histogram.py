@@ -30,6 +30,7 @@
 ###############################################################################
 
 import os
+import struct
 import sys
 import shutil
 
@@ -159,13 +160,66 @@ def histogram_6():
 
     return 'success'
 
+###############################################################################
+# Test that the histogram computed with several threads is the same as the
+# one computed by a single thread, with and without nodata.
+
+def histogram_7():
+
+    for (datatype, nodata) in [ (gdal.GDT_Byte, None), (gdal.GDT_Byte, 5),
+                                (gdal.GDT_UInt16, 5), (gdal.GDT_Int16, -3),
+                                (gdal.GDT_Float32, 5) ]:
+        ds = gdal.GetDriverByName('GTiff').Create('/vsimem/histogram_7.tif',
+                        301, 203, 1, datatype,
+                        options = [ 'TILED=YES', 'BLOCKXSIZE=32', 'BLOCKYSIZE=32' ])
+        ds.GetRasterBand(1).Fill(5)
+        ds.GetRasterBand(1).WriteRaster( 10, 20, 3, 2,
+                            struct.pack('d' * 6, -3, 0, 12, 255, 254.5, 100),
+                            buf_type = gdal.GDT_Float64 )
+        if nodata is not None:
+            ds.GetRasterBand(1).SetNoDataValue(nodata)
+        ds = None
+
+        ref_hist = None
+        for num_threads in [ None, '3' ]:
+            gdal.SetConfigOption('GDAL_NUM_THREADS', num_threads)
+            ds = gdal.Open('/vsimem/histogram_7.tif')
+            hist = ds.GetRasterBand(1).GetHistogram( buckets=26, min=-5.5, max=254.5,
+                                                     include_out_of_range = 1,
+                                                     approx_ok = 0 )
+            ds = None
+            gdal.SetConfigOption('GDAL_NUM_THREADS', None)
+            if ref_hist is None:
+                ref_hist = hist
+            elif hist != ref_hist:
+                gdaltest.post_reason( 'did not get expected histogram.' )
+                print(datatype, nodata, num_threads, hist, ref_hist)
+                return 'fail'
+
+        if nodata == 5:
+            expected_count = 6
+        elif nodata == -3:
+            expected_count = 301 * 203 - 1
+        else:
+            expected_count = 301 * 203
+        if sum(ref_hist) != expected_count:
+            gdaltest.post_reason( 'did not get expected histogram.' )
+            print(datatype, nodata, ref_hist)
+            return 'fail'
+
+        gdal.Unlink('/vsimem/histogram_7.tif')
+        gdal.Unlink('/vsimem/histogram_7.tif.aux.xml')
+
+    return 'success'
+
 gdaltest_list = [
     histogram_1,
     histogram_2,
     histogram_3,
     histogram_4,
     histogram_5,
-    histogram_6
+    histogram_6,
+    histogram_7
     ]
 
 if __name__ == '__main__':
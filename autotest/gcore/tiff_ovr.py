@@ -2079,6 +2079,99 @@ def tiff_ovr_52():
 
     return 'success'
 
+###############################################################################
+# Test that overviews computed with GDAL_NUM_THREADS are identical to the
+# ones computed in a single thread
+
+def tiff_ovr_53():
+
+    src_ds = gdal.Translate('', 'data/rgbsmall.tif', format = 'MEM',
+                            width = 1000, height = 700)
+    for resampling in [ 'NEAR', 'AVERAGE', 'GAUSS', 'CUBIC', 'MODE' ]:
+        for external in [ False, True ]:
+            cs_ref = None
+            for num_threads in [ None, '2', '3' ]:
+                gdal.SetConfigOption('GDAL_NUM_THREADS', num_threads)
+                ds = gdaltest.tiff_drv.CreateCopy('/vsimem/tiff_ovr_53.tif',
+                                                  src_ds)
+                if external:
+                    ds = None
+                    ds = gdal.Open('/vsimem/tiff_ovr_53.tif')
+                    # Use GDALRegenerateOverviewsMultiBand()
+                    gdal.SetConfigOption('COMPRESS_OVERVIEW', 'DEFLATE')
+                    gdal.SetConfigOption('INTERLEAVE_OVERVIEW', 'PIXEL')
+                ret = ds.BuildOverviews(resampling, [ 2, 4, 7 ])
+                gdal.SetConfigOption('COMPRESS_OVERVIEW', None)
+                gdal.SetConfigOption('INTERLEAVE_OVERVIEW', None)
+                gdal.SetConfigOption('GDAL_NUM_THREADS', None)
+                if ret != 0:
+                    gdaltest.post_reason('fail')
+                    return 'fail'
+                cs = [ ds.GetRasterBand(i+1).GetOverview(j).Checksum()
+                       for i in range(3) for j in range(3) ]
+                ds = None
+                gdaltest.tiff_drv.Delete('/vsimem/tiff_ovr_53.tif')
+                if cs_ref is None:
+                    cs_ref = cs
+                elif cs != cs_ref:
+                    gdaltest.post_reason('fail')
+                    print(resampling, external, num_threads)
+                    print(cs_ref)
+                    print(cs)
+                    return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that GDAL_OVR_SINGLE_PASS=YES gives the same overviews as the cascading
+# generation, on internal overviews (GDALRegenerateOverviewsMultiBand()) and
+# on external overviews (GDALRegenerateOverviews()), with an alpha band and
+# with nodata.
+
+def tiff_ovr_54():
+
+    src_ds = gdal.Translate('', 'data/rgbsmall.tif', format = 'MEM',
+                            width = 1000, height = 700)
+    src_ds.AddBand(gdal.GDT_Byte)
+    src_ds.GetRasterBand(4).SetColorInterpretation(gdal.GCI_AlphaBand)
+    src_ds.GetRasterBand(4).Fill(255)
+    src_ds.GetRasterBand(4).WriteRaster(100, 50, 300, 200, '\0' * (300 * 200))
+    for resampling in [ 'NEAR', 'AVERAGE', 'GAUSS', 'CUBIC', 'BILINEAR' ]:
+        for alpha in [ True, False ]:
+            for external in [ False, True ]:
+                cs_ref = None
+                for single_pass in [ None, 'YES' ]:
+                    if alpha:
+                        ds = gdaltest.tiff_drv.CreateCopy(
+                            '/vsimem/tiff_ovr_54.tif', src_ds)
+                    else:
+                        ds = gdal.Translate('/vsimem/tiff_ovr_54.tif', src_ds,
+                                            bandList = [ 1, 2, 3 ],
+                                            noData = 0)
+                    if external:
+                        ds = None
+                        ds = gdal.Open('/vsimem/tiff_ovr_54.tif')
+                    gdal.SetConfigOption('GDAL_OVR_SINGLE_PASS', single_pass)
+                    ret = ds.BuildOverviews(resampling, [ 2, 3, 8, 16 ])
+                    gdal.SetConfigOption('GDAL_OVR_SINGLE_PASS', None)
+                    if ret != 0:
+                        gdaltest.post_reason('fail')
+                        return 'fail'
+                    cs = [ ds.GetRasterBand(i+1).GetOverview(j).Checksum()
+                           for i in range(ds.RasterCount) for j in range(4) ]
+                    ds = None
+                    gdaltest.tiff_drv.Delete('/vsimem/tiff_ovr_54.tif')
+                    if cs_ref is None:
+                        cs_ref = cs
+                    elif cs != cs_ref:
+                        gdaltest.post_reason('fail')
+                        print(resampling, alpha, external)
+                        print(cs_ref)
+                        print(cs)
+                        return 'fail'
+
+    return 'success'
+
 ###############################################################################
 # Cleanup
 
@@ -2195,7 +2288,9 @@ for item in gdaltest_list_internal:
 gdaltest_list.append(tiff_ovr_restore_endianness)
 
 gdaltest_list += [ tiff_ovr_51,
-                   tiff_ovr_52 ]
+                   tiff_ovr_52,
+                   tiff_ovr_53,
+                   tiff_ovr_54 ]
 
 if __name__ == '__main__':
 
@@ -2502,6 +2502,75 @@ def tiff_read_one_strip_no_bytecount():
 
     return 'success'
 
+###############################################################################
+# Test multi-threaded decoding of compressed blocks in RasterIO
+
+def tiff_read_multi_threaded():
+
+    src_ds = gdal.Open('data/utmsmall.tif')
+    ref_data = src_ds.ReadRaster()
+    ref_window = src_ds.ReadRaster(5, 7, 80, 60)
+    for options in [ ['TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16', 'COMPRESS=DEFLATE'],
+                     ['BLOCKYSIZE=8', 'COMPRESS=LZW', 'PREDICTOR=2'] ]:
+        gdal.GetDriverByName('GTiff').CreateCopy('/vsimem/tiff_read_multi_threaded.tif',
+                                                 src_ds, options = options)
+        gdal.SetConfigOption('GDAL_NUM_THREADS', '4')
+        ds = gdal.Open('/vsimem/tiff_read_multi_threaded.tif')
+        data = ds.ReadRaster()
+        window = ds.GetRasterBand(1).ReadRaster(5, 7, 80, 60)
+        ds = None
+        gdal.SetConfigOption('GDAL_NUM_THREADS', None)
+        if data != ref_data or window != ref_window:
+            gdaltest.post_reason('fail')
+            print(options)
+            return 'fail'
+
+    gdal.Unlink('/vsimem/tiff_read_multi_threaded.tif')
+
+    return 'success'
+
+###############################################################################
+# Test reading blocks with merged I/O requests
+
+def tiff_read_multirange():
+
+    src_ds = gdal.Open('data/utmsmall.tif')
+    gdal.GetDriverByName('GTiff').CreateCopy('/vsimem/tiff_read_multirange.tif',
+        src_ds, options = ['TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16',
+                           'COMPRESS=DEFLATE', 'INTERLEAVE=BAND'])
+    ref_data = src_ds.ReadRaster(5, 7, 80, 60)
+
+    for gap in [ '-1', '0', '100', '1000000' ]:
+        ds = gdal.OpenEx('/vsimem/tiff_read_multirange.tif',
+                         open_options = ['MULTIRANGE_MAX_GAP=' + gap])
+        data = ds.ReadRaster(5, 7, 80, 60)
+        ds = None
+        if data != ref_data:
+            gdaltest.post_reason('fail')
+            print(gap)
+            return 'fail'
+
+    # Truncated file: errors must be reported as without merged reads
+    f = gdal.VSIFOpenL('/vsimem/tiff_read_multirange.tif', 'rb')
+    content = gdal.VSIFReadL(1, 100000, f)
+    gdal.VSIFCloseL(f)
+    f = gdal.VSIFOpenL('/vsimem/tiff_read_multirange.tif', 'wb')
+    gdal.VSIFWriteL(content[0:len(content) * 2 // 3], 1,
+                    len(content) * 2 // 3, f)
+    gdal.VSIFCloseL(f)
+
+    ds = gdal.Open('/vsimem/tiff_read_multirange.tif')
+    with gdaltest.error_handler():
+        data = ds.ReadRaster()
+    ds = None
+    if data is not None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    gdal.Unlink('/vsimem/tiff_read_multirange.tif')
+
+    return 'success'
+
 ###############################################################################
 
 for item in init_list:
@@ -2564,6 +2633,8 @@ gdaltest_list.append( (tiff_read_logl_as_rgba) )
 gdaltest_list.append( (tiff_read_scanline_more_than_2GB) )
 gdaltest_list.append( (tiff_read_wrong_number_extrasamples) )
 gdaltest_list.append( (tiff_read_one_strip_no_bytecount) )
+gdaltest_list.append( (tiff_read_multi_threaded) )
+gdaltest_list.append( (tiff_read_multirange) )
 
 gdaltest_list.append( (tiff_read_online_1) )
 gdaltest_list.append( (tiff_read_online_2) )
@@ -531,6 +531,154 @@ abc***NEWFILE***:""")
 
     return 'success'
 
+###############################################################################
+# Test reading regular files through a memory mapping (VSI_MMAP=YES)
+
+def vsifile_11():
+
+    filename = 'tmp/vsifile_11.bin'
+    fp = gdal.VSIFOpenL(filename, 'wb')
+    gdal.VSIFWriteL('0123456789', 1, 10, fp)
+    gdal.VSIFCloseL(fp)
+
+    gdal.SetConfigOption('VSI_MMAP', 'YES')
+    fp = gdal.VSIFOpenL(filename, 'rb')
+    gdal.SetConfigOption('VSI_MMAP', None)
+    if fp is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    gdal.VSIFSeekL(fp, 2, 0)
+    buf = gdal.VSIFReadL(1, 3, fp)
+    if buf.decode('ascii') != '234' or gdal.VSIFTellL(fp) != 5:
+        gdaltest.post_reason('fail')
+        print(buf)
+        return 'fail'
+
+    # Read beyond end of file
+    gdal.VSIFSeekL(fp, -2, 2)
+    buf = gdal.VSIFReadL(1, 5, fp)
+    if buf.decode('ascii') != '89' or gdal.VSIFTellL(fp) != 10:
+        gdaltest.post_reason('fail')
+        print(buf)
+        return 'fail'
+
+    if gdal.VSIFWriteL('a', 1, 1, fp) != 0:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    gdal.VSIFCloseL(fp)
+    gdal.Unlink(filename)
+
+    # Drivers reading directly from the mapping
+    for (drv, options) in [ ('GTiff', ['INTERLEAVE=PIXEL', 'BLOCKYSIZE=7']),
+                            ('GTiff', ['INTERLEAVE=BAND', 'BLOCKYSIZE=7']),
+                            ('GTiff', ['TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16']),
+                            ('ENVI', ['INTERLEAVE=BIP']) ]:
+        src_ds = gdal.Open('data/rgbsmall.tif')
+        filename = 'tmp/vsifile_11.img'
+        gdal.GetDriverByName(drv).CreateCopy(filename, src_ds, options = options)
+        src_ds = None
+
+        gdal.SetConfigOption('VSI_MMAP', 'YES')
+        ds = gdal.Open(filename)
+        gdal.SetConfigOption('VSI_MMAP', None)
+        cs = [ ds.GetRasterBand(i+1).Checksum() for i in range(3) ]
+        ds = None
+        gdal.GetDriverByName(drv).Delete(filename)
+        if cs != [ 21212, 21053, 21349 ]:
+            gdaltest.post_reason('fail')
+            print(drv, options, cs)
+            return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test read-ahead of vsicache on sequential reads, and its absence on
+# random access
+
+def vsifile_12_readahead_bytes(fp):
+
+    stats = gdal.VSIFGetCacheStatisticsL(fp)
+    if stats is None:
+        return None
+    for item in stats:
+        if item.startswith('READAHEAD_BYTES='):
+            return int(item[len('READAHEAD_BYTES='):])
+    return None
+
+def vsifile_12():
+
+    ref_data = ''.join(['%08d' % i for i in range(100000)])
+    fp = gdal.VSIFOpenL('tmp/vsifile_12.bin', 'wb')
+    gdal.VSIFWriteL(ref_data, 1, len(ref_data), fp)
+    gdal.VSIFCloseL(fp)
+
+    gdal.SetConfigOption('VSI_CACHE', 'YES')
+    gdal.SetConfigOption('VSI_CACHE_READAHEAD_MAX', '262144')
+
+    for thread in ['NO', 'YES']:
+        gdal.SetConfigOption('VSI_CACHE_READAHEAD_THREAD', thread)
+        fp = gdal.VSIFOpenL('tmp/vsifile_12.bin', 'rb')
+        gdal.SetConfigOption('VSI_CACHE_READAHEAD_THREAD', None)
+
+        # Sequential reads, then a backward seek, then sequential again
+        for (start, size, count) in [ (0, 1000, 500), (4096, 333, 1000),
+                                      (790000, 1000, 20) ]:
+            gdal.VSIFSeekL(fp, start, 0)
+            for i in range(count):
+                data = gdal.VSIFReadL(1, size, fp)
+                offset = start + i * size
+                expected = ref_data[offset:offset+size]
+                if data.decode('ascii') != expected:
+                    gdaltest.post_reason('fail')
+                    print(thread, offset)
+                    gdal.VSIFCloseL(fp)
+                    gdal.SetConfigOption('VSI_CACHE_READAHEAD_MAX', None)
+                    gdal.SetConfigOption('VSI_CACHE', None)
+                    return 'fail'
+                if len(expected) < size:
+                    break
+
+        readahead_bytes = vsifile_12_readahead_bytes(fp)
+        gdal.VSIFCloseL(fp)
+        if readahead_bytes is None or readahead_bytes == 0:
+            gdaltest.post_reason('fail')
+            print(thread, readahead_bytes)
+            gdal.SetConfigOption('VSI_CACHE_READAHEAD_MAX', None)
+            gdal.SetConfigOption('VSI_CACHE', None)
+            return 'fail'
+
+        # Random access, never within a chunk after the previous read: no
+        # read-ahead
+        gdal.SetConfigOption('VSI_CACHE_READAHEAD_THREAD', thread)
+        fp = gdal.VSIFOpenL('tmp/vsifile_12.bin', 'rb')
+        gdal.SetConfigOption('VSI_CACHE_READAHEAD_THREAD', None)
+        for offset in [ 700000, 100000, 500000, 20000, 300000, 650000,
+                        50000, 400000 ]:
+            gdal.VSIFSeekL(fp, offset, 0)
+            data = gdal.VSIFReadL(1, 1000, fp)
+            if data.decode('ascii') != ref_data[offset:offset+1000]:
+                gdaltest.post_reason('fail')
+                print(thread, offset)
+                gdal.VSIFCloseL(fp)
+                gdal.SetConfigOption('VSI_CACHE_READAHEAD_MAX', None)
+                gdal.SetConfigOption('VSI_CACHE', None)
+                return 'fail'
+        readahead_bytes = vsifile_12_readahead_bytes(fp)
+        gdal.VSIFCloseL(fp)
+        if readahead_bytes != 0:
+            gdaltest.post_reason('fail')
+            print(thread, readahead_bytes)
+            gdal.SetConfigOption('VSI_CACHE_READAHEAD_MAX', None)
+            gdal.SetConfigOption('VSI_CACHE', None)
+            return 'fail'
+
+    gdal.SetConfigOption('VSI_CACHE_READAHEAD_MAX', None)
+    gdal.SetConfigOption('VSI_CACHE', None)
+    gdal.Unlink('tmp/vsifile_12.bin')
+
+    return 'success'
+
 gdaltest_list = [ vsifile_1,
                   vsifile_2,
                   vsifile_3,
@@ -540,7 +688,9 @@ gdaltest_list = [ vsifile_1,
                   vsifile_7,
                   vsifile_8,
                   vsifile_9,
-                  vsifile_10 ]
+                  vsifile_10,
+                  vsifile_11,
+                  vsifile_12 ]
 
 if __name__ == '__main__':
 
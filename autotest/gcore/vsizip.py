@@ -29,6 +29,7 @@
 # DEALINGS IN THE SOFTWARE.
 ###############################################################################
 
+import struct
 import sys
 
 sys.path.append( '../pymod' )
@@ -514,6 +515,220 @@ def vsizip_13():
 
     return 'success'
 
+###############################################################################
+# Test the seek index of /vsigzip/ (CPL_VSIL_GZIP_WRITE_INDEX)
+
+class vsizip_14_error_handler:
+
+    def __init__(self):
+        self.msgs = []
+
+    def handler(self, err_type, err_no, err_msg):
+        self.msgs.append(err_msg)
+
+def vsizip_14():
+
+    content = ''.join(['%d,%d,%d\n' % (i, (i * 7919) % 10007, (i * i) % 65521) for i in range(100000)])
+
+    f = gdal.VSIFOpenL('/vsigzip//vsimem/vsizip_14.txt.gz', 'wb')
+    gdal.VSIFWriteL(content, 1, len(content), f)
+    gdal.VSIFCloseL(f)
+
+    # Build the index during a full read
+    gdal.SetConfigOption('CPL_VSIL_GZIP_WRITE_INDEX', 'YES')
+    gdal.SetConfigOption('CPL_VSIL_GZIP_INDEX_SPACING', '65536')
+    f = gdal.VSIFOpenL('/vsigzip//vsimem/vsizip_14.txt.gz', 'rb')
+    data = gdal.VSIFReadL(1, len(content) + 1, f)
+    gdal.VSIFCloseL(f)
+    gdal.SetConfigOption('CPL_VSIL_GZIP_WRITE_INDEX', None)
+    gdal.SetConfigOption('CPL_VSIL_GZIP_INDEX_SPACING', None)
+    if data.decode('ascii') != content:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if gdal.VSIStatL('/vsimem/vsizip_14.txt.gz.idx') is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    f = gdal.VSIFOpenL('/vsigzip//vsimem/vsizip_14_2.txt.gz', 'wb')
+    gdal.VSIFWriteL(content[1:], 1, len(content) - 1, f)
+    gdal.VSIFCloseL(f)
+
+    # Seek with the index, forward and backward
+    for use_index in ['YES', 'NO']:
+        # Open another file, so that the handle of vsizip_14.txt.gz is not
+        # duplicated from the cached one
+        f = gdal.VSIFOpenL('/vsigzip//vsimem/vsizip_14_2.txt.gz', 'rb')
+        gdal.VSIFCloseL(f)
+        gdal.SetConfigOption('CPL_VSIL_GZIP_USE_INDEX', use_index)
+        f = gdal.VSIFOpenL('/vsigzip//vsimem/vsizip_14.txt.gz', 'rb')
+        gdal.SetConfigOption('CPL_VSIL_GZIP_USE_INDEX', None)
+        for offset in [len(content) - 100, 500000, 65536, 0, 1000000]:
+            gdal.VSIFSeekL(f, offset, 0)
+            data = gdal.VSIFReadL(1, 100, f)
+            if data.decode('ascii') != content[offset:offset+100]:
+                gdaltest.post_reason('fail')
+                print(use_index, offset)
+                return 'fail'
+        gdal.VSIFCloseL(f)
+
+    # Check the access points of the index: in the order of the file, and
+    # at least CPL_VSIL_GZIP_INDEX_SPACING uncompressed bytes apart
+    f = gdal.VSIFOpenL('/vsimem/vsizip_14.txt.gz.idx', 'rb')
+    idx = gdal.VSIFReadL(1, 10000000, f)
+    gdal.VSIFCloseL(f)
+    if idx[0:8] != 'GDALGZI1'.encode('ascii'):
+        gdaltest.post_reason('fail')
+        return 'fail'
+    (compressed_size, uncompressed_size, mtime, npoints) = struct.unpack('<QQQI', idx[8:36])
+    if compressed_size != gdal.VSIStatL('/vsimem/vsizip_14.txt.gz').size or \
+       uncompressed_size != len(content) or \
+       npoints < 2 or npoints > len(content) // 65536:
+        gdaltest.post_reason('fail')
+        print(compressed_size, uncompressed_size, npoints)
+        return 'fail'
+    pos = 36
+    last_in = 0
+    last_out = 0
+    for i in range(npoints):
+        (_, _, point_in, point_out, _, window_size, compressed_window_size) = \
+            struct.unpack('<QIQQIII', idx[pos:pos+40])
+        if point_in <= last_in or point_out < last_out + 65536 or \
+           point_out >= len(content) or window_size != 32768:
+            gdaltest.post_reason('fail')
+            print(i, point_in, point_out, window_size)
+            return 'fail'
+        last_in = point_in
+        last_out = point_out
+        last_window_size_pos = pos + 32
+        pos += 40 + compressed_window_size
+    if pos != len(idx):
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    # Check that a seek past the last access point restores it instead of
+    # inflating from the start, by corrupting its window size
+    f = gdal.VSIFOpenL('/vsimem/vsizip_14.txt.gz.idx', 'wb')
+    gdal.VSIFWriteL(idx[0:last_window_size_pos], 1, last_window_size_pos, f)
+    gdal.VSIFWriteL(struct.pack('<I', 1), 1, 4, f)
+    gdal.VSIFWriteL(idx[last_window_size_pos+4:], 1, len(idx) - last_window_size_pos - 4, f)
+    gdal.VSIFCloseL(f)
+    # Opening another file first, so that the index is loaded again
+    # instead of being shared with the last handle of the file
+    gdal.VSIFCloseL(gdal.VSIFOpenL('/vsigzip//vsimem/vsizip_14_2.txt.gz', 'rb'))
+    f = gdal.VSIFOpenL('/vsigzip//vsimem/vsizip_14.txt.gz', 'rb')
+    error_handler = vsizip_14_error_handler()
+    gdal.PushErrorHandler(error_handler.handler)
+    gdal.VSIFSeekL(f, last_out + 100, 0)
+    data = gdal.VSIFReadL(1, 100, f)
+    gdal.PopErrorHandler()
+    gdal.VSIFCloseL(f)
+    if len(data) != 0 or 'Corrupted gzip index' not in error_handler.msgs:
+        gdaltest.post_reason('fail')
+        print(len(data), error_handler.msgs)
+        return 'fail'
+    f = gdal.VSIFOpenL('/vsimem/vsizip_14.txt.gz.idx', 'wb')
+    gdal.VSIFWriteL(idx, 1, len(idx), f)
+    gdal.VSIFCloseL(f)
+
+    # An index that does not match the file is ignored
+    gdal.Rename('/vsimem/vsizip_14.txt.gz.idx', '/vsimem/vsizip_14_2.txt.gz.idx')
+    f = gdal.VSIFOpenL('/vsigzip//vsimem/vsizip_14_2.txt.gz', 'rb')
+    gdal.VSIFSeekL(f, 500000, 0)
+    data = gdal.VSIFReadL(1, 100, f)
+    gdal.VSIFCloseL(f)
+    if data.decode('ascii') != content[500001:500101]:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    # Index written in a cache directory
+    gdal.SetConfigOption('CPL_VSIL_GZIP_WRITE_INDEX', 'YES')
+    gdal.SetConfigOption('CPL_VSIL_GZIP_INDEX_DIR', '/vsimem/vsizip_14_cache')
+    f = gdal.VSIFOpenL('/vsigzip//vsimem/vsizip_14.txt.gz', 'rb')
+    gdal.VSIFReadL(1, len(content) + 1, f)
+    gdal.VSIFCloseL(f)
+    gdal.SetConfigOption('CPL_VSIL_GZIP_WRITE_INDEX', None)
+    lst = gdal.ReadDir('/vsimem/vsizip_14_cache')
+    gdal.SetConfigOption('CPL_VSIL_GZIP_INDEX_DIR', None)
+    if lst is None or len(lst) != 1 or lst[0].find('vsizip_14.txt.gz.') != 0:
+        gdaltest.post_reason('fail')
+        print(lst)
+        return 'fail'
+
+    gdal.Unlink('/vsimem/vsizip_14_cache/' + lst[0])
+    gdal.Unlink('/vsimem/vsizip_14.txt.gz')
+    gdal.Unlink('/vsimem/vsizip_14.txt.gz.properties')
+    gdal.Unlink('/vsimem/vsizip_14_2.txt.gz')
+    gdal.Unlink('/vsimem/vsizip_14_2.txt.gz.idx')
+    gdal.Unlink('/vsimem/vsizip_14_2.txt.gz.properties')
+
+    return 'success'
+
+###############################################################################
+# Test writing BGZF files with CPL_VSIL_GZIP_WRITE_THREADS, and reading them
+
+def vsizip_15():
+
+    content = ''.join(['%d,%d,%d\n' % (i, (i * 7919) % 10007, (i * i) % 65521) for i in range(100000)])
+
+    gdal.SetConfigOption('CPL_VSIL_GZIP_WRITE_THREADS', '2')
+    f = gdal.VSIFOpenL('/vsigzip//vsimem/vsizip_15.txt.gz', 'wb')
+    for i in range(0, len(content), 100000):
+        gdal.VSIFWriteL(content[i:i+100000], 1, len(content[i:i+100000]), f)
+    gdal.VSIFCloseL(f)
+    gdal.SetConfigOption('CPL_VSIL_GZIP_WRITE_THREADS', None)
+
+    # Header of the first member, with its "BC" subfield
+    f = gdal.VSIFOpenL('/vsimem/vsizip_15.txt.gz', 'rb')
+    data = gdal.VSIFReadL(1, 16, f)
+    gdal.VSIFCloseL(f)
+    if data[12:14].decode('ascii') != 'BC':
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    if gdal.VSIStatL('/vsigzip//vsimem/vsizip_15.txt.gz').size != len(content):
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    for read_threads in [None, '2']:
+        gdal.SetConfigOption('CPL_VSIL_GZIP_READ_THREADS', read_threads)
+        f = gdal.VSIFOpenL('/vsigzip//vsimem/vsizip_15.txt.gz', 'rb')
+        for (offset, size) in [(len(content) - 100, 100), (500000, 100),
+                               (65536, 1000000), (1, len(content))]:
+            gdal.VSIFSeekL(f, offset, 0)
+            data = gdal.VSIFReadL(1, size, f)
+            if data.decode('ascii') != content[offset:offset+size]:
+                gdaltest.post_reason('fail')
+                print(read_threads, offset)
+                return 'fail'
+        gdal.VSIFCloseL(f)
+
+        # Small sequential reads (decompressed ahead with threads), with
+        # seeks inside and outside of what has been decompressed
+        f = gdal.VSIFOpenL('/vsigzip//vsimem/vsizip_15.txt.gz', 'rb')
+        offset = 0
+        while offset < len(content):
+            if offset == 700000:
+                gdal.VSIFSeekL(f, 690000, 0)
+                gdal.VSIFReadL(1, 100, f)
+                gdal.VSIFSeekL(f, 9900, 1)
+            elif offset == 1400000:
+                gdal.VSIFSeekL(f, 1500000, 0)
+                gdal.VSIFSeekL(f, offset, 0)
+            data = gdal.VSIFReadL(1, 7000, f)
+            if gdal.VSIFTellL(f) != min(offset + 7000, len(content)) or \
+               data.decode('ascii') != content[offset:offset+7000]:
+                gdaltest.post_reason('fail')
+                print(read_threads, offset)
+                return 'fail'
+            offset += 7000
+        gdal.VSIFCloseL(f)
+        gdal.SetConfigOption('CPL_VSIL_GZIP_READ_THREADS', None)
+
+    gdal.Unlink('/vsimem/vsizip_15.txt.gz')
+    gdal.Unlink('/vsimem/vsizip_15.txt.gz.properties')
+
+    return 'success'
+
 
 gdaltest_list = [ vsizip_1,
                   vsizip_2,
@@ -528,6 +743,8 @@ gdaltest_list = [ vsizip_1,
                   vsizip_11,
                   vsizip_12,
                   vsizip_13,
+                  vsizip_14,
+                  vsizip_15,
                   ]
 
 
@@ -38,6 +38,8 @@
 #include "cpl_list.h"
 #include "cpl_multiproc.h"
 
+#include <algorithm>
+
 CPL_CVSID("$Id$");
 CPL_C_START
 void *GDALDeserializeGCPTransformer( CPLXMLNode *psTree );
@@ -2486,6 +2488,36 @@ GDALDeserializeReprojectionTransformer( CPLXMLNode *psTree )
 /* ==================================================================== */
 /************************************************************************/
 
+/* Cell of the 2D approximation grid, between the columns iX0 and iX1 and */
+/* the rows iY0 and iY1 of the lattice. The corners are in the order top */
+/* left, top right, bottom left, bottom right. */
+typedef struct
+{
+    int               iX0;
+    int               iX1;
+    int               iY0;
+    int               iY1;
+    int               bExact;
+    double            adfX[4];
+    double            adfY[4];
+    double            adfZ[4];
+} ApproxTransformGridCell;
+
+/* Cells covering the rows [iRowTop, iRowTop + nGridCellSize[ of the */
+/* lattice whose columns are at dfXOrigin + i * dfXStep for i in */
+/* [0, nPoints[, and whose rows are at dfYOrigin + j. */
+struct ApproxTransformGrid
+{
+    int               bDstToSrc;
+    int               nPoints;
+    double            dfXOrigin;
+    double            dfXStep;
+    double            dfYOrigin;
+    double            dfZ;
+    int               iRowTop;
+    std::vector<ApproxTransformGridCell> asCells;
+};
+
 typedef struct
 {
     GDALTransformerInfo sTI;
@@ -2495,6 +2527,15 @@ typedef struct
     double	      dfMaxError;
 
     int               bOwnSubtransformer;
+
+    /* Size in pixels of the cells of the 2D approximation grid, or 0 */
+    /* to approximate each row on its own. */
+    int               nGridCellSize;
+    /* Last band of the grid, checked out by GDALApproxTransform() under */
+    /* hGridMutex while in use, as the transformer may be called from */
+    /* several threads at once. */
+    ApproxTransformGrid *psGrid;
+    CPLMutex         *hGridMutex;
 } ApproxTransformInfo;
 
 /************************************************************************/
@@ -2513,6 +2554,8 @@ void* GDALCreateSimilarApproxTransformer( void *hTransformArg, double dfSrcRatio
         CPLMalloc(sizeof(ApproxTransformInfo));
 
     memcpy(psClonedInfo, psInfo, sizeof(ApproxTransformInfo));
+    psClonedInfo->psGrid = NULL;
+    psClonedInfo->hGridMutex = NULL;
     if( psClonedInfo->pBaseCBData )
     {
         psClonedInfo->pBaseCBData = GDALCreateSimilarTransformer( psInfo->pBaseCBData,
@@ -2547,6 +2590,9 @@ GDALSerializeApproxTransformer( void *pTransformArg )
 /* -------------------------------------------------------------------- */
     CPLCreateXMLElementAndValue( psTree, "MaxError",
                                  CPLString().Printf("%g",psInfo->dfMaxError) );
+    if( psInfo->nGridCellSize > 0 )
+        CPLCreateXMLElementAndValue( psTree, "GridCellSize",
+                                     CPLSPrintf("%d", psInfo->nGridCellSize) );
 
 /* -------------------------------------------------------------------- */
 /*      Capture underlying transformer.                                 */
@@ -2596,6 +2642,20 @@ GDALSerializeApproxTransformer( void *pTransformArg )
  * circumstances as little internal validation is done, in order to keep things
  * fast.
  *
+ * Starting with GDAL 2.2, if the GDAL_APPROX_TRANSFORMER_GRID configuration
+ * option is set to YES, or to a cell size in pixels (64 for YES), scanlines of
+ * regularly spaced points are approximated with a 2D grid instead.  The
+ * lattice of cells covering the rows being processed is transformed once, and
+ * each cell is split in 4 until the bilinear interpolation of its corners is
+ * within dfMaxError at its center and at the middle of its edges.  The points
+ * of the following scanlines that fall in the same band of cells are then
+ * interpolated without calling the base transformer, except in the cells that
+ * could not be approximated, where the scanline approximation above is used.
+ * This reduces the number of calls to the base transformer from a few per
+ * scanline to a few per cell.  The transformer can still be called from
+ * several threads at once, if the base transformer can: a thread that finds
+ * the cached band in use by another one builds its own.
+ *
  * @param pfnBaseTransformer the high precision transformer which should be
  * approximated.
  * @param pBaseTransformArg the callback argument for the high precision
@@ -2618,6 +2678,15 @@ void *GDALCreateApproxTransformer( GDALTransformerFunc pfnBaseTransformer,
     psATInfo->pBaseCBData = pBaseTransformArg;
     psATInfo->dfMaxError = dfMaxError;
     psATInfo->bOwnSubtransformer = FALSE;
+    psATInfo->psGrid = NULL;
+    psATInfo->hGridMutex = NULL;
+
+    const char* pszGrid = CPLGetConfigOption("GDAL_APPROX_TRANSFORMER_GRID",
+                                             "NO");
+    if( atoi(pszGrid) > 0 )
+        psATInfo->nGridCellSize = MAX(2, atoi(pszGrid));
+    else
+        psATInfo->nGridCellSize = CPLTestBool(pszGrid) ? 64 : 0;
 
     memcpy( psATInfo->sTI.abySignature, GDAL_GTI2_SIGNATURE, strlen(GDAL_GTI2_SIGNATURE) );
     psATInfo->sTI.pszClassName = "GDALApproxTransformer";
@@ -2665,6 +2734,9 @@ void GDALDestroyApproxTransformer( void * pCBData )
     if( psATInfo->bOwnSubtransformer )
         GDALDestroyTransformer( psATInfo->pBaseCBData );
 
+    delete psATInfo->psGrid;
+    if( psATInfo->hGridMutex != NULL )
+        CPLDestroyMutex( psATInfo->hGridMutex );
     CPLFree( pCBData );
 }
 
@@ -2928,20 +3000,12 @@ static int GDALApproxTransformInternal( void *pCBData, int bDstToSrc, int nPoint
 }
 
 /************************************************************************/
-/*                        GDALApproxTransform()                         */
+/*                       GDALApproxTransformRow()                       */
 /************************************************************************/
 
-/**
- * Perform approximate transformation.
- *
- * Actually performs the approximate transformation described in
- * GDALCreateApproxTransformer().  This function matches the
- * GDALTransformerFunc() signature.  Details of the arguments are described
- * there.
- */
-
-int GDALApproxTransform( void *pCBData, int bDstToSrc, int nPoints,
-                         double *x, double *y, double *z, int *panSuccess )
+static int GDALApproxTransformRow( void *pCBData, int bDstToSrc, int nPoints,
+                                   double *x, double *y, double *z,
+                                   int *panSuccess )
 
 {
     ApproxTransformInfo *psATInfo = (ApproxTransformInfo *) pCBData;
@@ -3002,6 +3066,416 @@ end:
     return bRet;
 }
 
+/************************************************************************/
+/*                    GDALApproxTransformIsGridRow()                    */
+/************************************************************************/
+
+/* Return whether the points are a scanline of regularly spaced points, */
+/* that can be approximated with the 2D grid. */
+static bool GDALApproxTransformIsGridRow( const ApproxTransformInfo *psATInfo,
+                                          int nPoints, const double *x,
+                                          const double *y, const double *z )
+{
+    if( psATInfo->nGridCellSize <= 0 || psATInfo->dfMaxError == 0.0 ||
+        nPoints <= 5 )
+        return false;
+
+    // The row index of the lattice must fit in an int
+    if( !(fabs(y[0]) < INT_MAX / 2) )
+        return false;
+
+    const double dfXStep = x[1] - x[0];
+    if( !(dfXStep != 0.0) )
+        return false;
+    const double dfTolerance = 1e-10 * MAX(1.0, fabs(x[0]) + fabs(x[nPoints-1]));
+    for( int i = 1; i < nPoints; i++ )
+    {
+        if( y[i] != y[0] || z[i] != z[0] ||
+            fabs(x[i] - (x[0] + i * dfXStep)) > dfTolerance )
+            return false;
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                    GDALApproxTransformGridBuild()                    */
+/************************************************************************/
+
+/* Bilinear interpolation of the corners of a cell. */
+static double GDALApproxTransformGridInterpolate( const double adfCorners[4],
+                                                  double dfU, double dfV )
+{
+    const double dfLeft = adfCorners[0] + (adfCorners[2] - adfCorners[0]) * dfV;
+    const double dfRight = adfCorners[1] + (adfCorners[3] - adfCorners[1]) * dfV;
+    return dfLeft + (dfRight - dfLeft) * dfU;
+}
+
+/* Transform the lattice of the band of cells of psGrid, and split the */
+/* cells until they are within the error threshold. */
+static void GDALApproxTransformGridBuild( ApproxTransformInfo *psATInfo,
+                                          ApproxTransformGrid *psGrid )
+{
+    const int nCellSize = psATInfo->nGridCellSize;
+    psGrid->asCells.clear();
+
+/* -------------------------------------------------------------------- */
+/*      Transform the nodes of the top and bottom rows of the band.     */
+/* -------------------------------------------------------------------- */
+    std::vector<int> anColumns;
+    for( int i = 0; i < psGrid->nPoints - 1; i += nCellSize )
+        anColumns.push_back(i);
+    anColumns.push_back(psGrid->nPoints - 1);
+    const int nNodes = static_cast<int>(anColumns.size());
+
+    std::vector<double> adfX(2 * nNodes), adfY(2 * nNodes), adfZ(2 * nNodes);
+    std::vector<int> anSuccess(2 * nNodes);
+    for( int iRow = 0; iRow < 2; iRow++ )
+    {
+        for( int i = 0; i < nNodes; i++ )
+        {
+            adfX[iRow * nNodes + i] =
+                psGrid->dfXOrigin + anColumns[i] * psGrid->dfXStep;
+            adfY[iRow * nNodes + i] =
+                psGrid->dfYOrigin + psGrid->iRowTop + iRow * nCellSize;
+            adfZ[iRow * nNodes + i] = psGrid->dfZ;
+        }
+    }
+    if( !psATInfo->pfnBaseTransformer( psATInfo->pBaseCBData,
+                                       psGrid->bDstToSrc, 2 * nNodes,
+                                       &adfX[0], &adfY[0], &adfZ[0],
+                                       &anSuccess[0] ) )
+    {
+        std::fill(anSuccess.begin(), anSuccess.end(), FALSE);
+    }
+
+    std::vector<ApproxTransformGridCell> asPending;
+    for( int i = 0; i < nNodes - 1; i++ )
+    {
+        ApproxTransformGridCell sCell;
+        sCell.iX0 = anColumns[i];
+        sCell.iX1 = anColumns[i + 1];
+        sCell.iY0 = psGrid->iRowTop;
+        sCell.iY1 = psGrid->iRowTop + nCellSize;
+        const int anNodes[4] = { i, i + 1, nNodes + i, nNodes + i + 1 };
+        sCell.bExact = FALSE;
+        for( int iCorner = 0; iCorner < 4; iCorner++ )
+        {
+            sCell.adfX[iCorner] = adfX[anNodes[iCorner]];
+            sCell.adfY[iCorner] = adfY[anNodes[iCorner]];
+            sCell.adfZ[iCorner] = adfZ[anNodes[iCorner]];
+            if( !anSuccess[anNodes[iCorner]] )
+                sCell.bExact = TRUE;
+        }
+        if( sCell.bExact )
+            psGrid->asCells.push_back(sCell);
+        else
+            asPending.push_back(sCell);
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Check the middle of the edges and the center of the pending     */
+/*      cells, all at once, and split those that are not accurate       */
+/*      enough.  The 5 checked points and the corners of a cell are     */
+/*      the corners of its 4 sub-cells.                                 */
+/* -------------------------------------------------------------------- */
+    // Top, left, center, right and bottom points
+    const int anCheckU[5] = { 1, 0, 1, 2, 1 };
+    const int anCheckV[5] = { 0, 1, 1, 1, 2 };
+    while( !asPending.empty() )
+    {
+        const int nChecks = static_cast<int>(asPending.size()) * 5;
+        adfX.resize(nChecks);
+        adfY.resize(nChecks);
+        adfZ.resize(nChecks);
+        anSuccess.resize(nChecks);
+        for( size_t iCell = 0; iCell < asPending.size(); iCell++ )
+        {
+            const ApproxTransformGridCell& sCell = asPending[iCell];
+            const int aiX[3] = { sCell.iX0, (sCell.iX0 + sCell.iX1) / 2,
+                                 sCell.iX1 };
+            const int aiY[3] = { sCell.iY0, (sCell.iY0 + sCell.iY1) / 2,
+                                 sCell.iY1 };
+            for( int iCheck = 0; iCheck < 5; iCheck++ )
+            {
+                const size_t iPoint = iCell * 5 + iCheck;
+                adfX[iPoint] = psGrid->dfXOrigin +
+                               aiX[anCheckU[iCheck]] * psGrid->dfXStep;
+                adfY[iPoint] = psGrid->dfYOrigin + aiY[anCheckV[iCheck]];
+                adfZ[iPoint] = psGrid->dfZ;
+            }
+        }
+        if( !psATInfo->pfnBaseTransformer( psATInfo->pBaseCBData,
+                                           psGrid->bDstToSrc, nChecks,
+                                           &adfX[0], &adfY[0], &adfZ[0],
+                                           &anSuccess[0] ) )
+        {
+            std::fill(anSuccess.begin(), anSuccess.end(), FALSE);
+        }
+
+        std::vector<ApproxTransformGridCell> asSplit;
+        for( size_t iCell = 0; iCell < asPending.size(); iCell++ )
+        {
+            ApproxTransformGridCell& sCell = asPending[iCell];
+            const int nWidth = sCell.iX1 - sCell.iX0;
+            const int nHeight = sCell.iY1 - sCell.iY0;
+            const int aiX[3] = { sCell.iX0, (sCell.iX0 + sCell.iX1) / 2,
+                                 sCell.iX1 };
+            const int aiY[3] = { sCell.iY0, (sCell.iY0 + sCell.iY1) / 2,
+                                 sCell.iY1 };
+
+            double dfMaxError = 0.0;
+            bool bFailed = false;
+            for( int iCheck = 0; iCheck < 5; iCheck++ )
+            {
+                const size_t iPoint = iCell * 5 + iCheck;
+                if( !anSuccess[iPoint] )
+                {
+                    bFailed = true;
+                    break;
+                }
+                const double dfU = (aiX[anCheckU[iCheck]] - sCell.iX0) /
+                                   static_cast<double>(nWidth);
+                const double dfV = (aiY[anCheckV[iCheck]] - sCell.iY0) /
+                                   static_cast<double>(nHeight);
+                const double dfError =
+                    fabs(GDALApproxTransformGridInterpolate(sCell.adfX,
+                                                            dfU, dfV) -
+                         adfX[iPoint]) +
+                    fabs(GDALApproxTransformGridInterpolate(sCell.adfY,
+                                                            dfU, dfV) -
+                         adfY[iPoint]);
+                dfMaxError = MAX(dfMaxError, dfError);
+            }
+
+            if( !bFailed && dfMaxError <= psATInfo->dfMaxError )
+            {
+                psGrid->asCells.push_back(sCell);
+                continue;
+            }
+
+            // Below 4 pixels, the scanline approximation is as good
+            if( bFailed || nWidth < 8 || nHeight < 8 )
+            {
+                sCell.bExact = TRUE;
+                psGrid->asCells.push_back(sCell);
+                continue;
+            }
+
+            // Transformed values at the 3x3 nodes of the sub-cells
+            double adfNodeX[3][3], adfNodeY[3][3], adfNodeZ[3][3];
+            for( int iCorner = 0; iCorner < 4; iCorner++ )
+            {
+                const int iU = (iCorner % 2) * 2;
+                const int iV = (iCorner / 2) * 2;
+                adfNodeX[iV][iU] = sCell.adfX[iCorner];
+                adfNodeY[iV][iU] = sCell.adfY[iCorner];
+                adfNodeZ[iV][iU] = sCell.adfZ[iCorner];
+            }
+            for( int iCheck = 0; iCheck < 5; iCheck++ )
+            {
+                const size_t iPoint = iCell * 5 + iCheck;
+                adfNodeX[anCheckV[iCheck]][anCheckU[iCheck]] = adfX[iPoint];
+                adfNodeY[anCheckV[iCheck]][anCheckU[iCheck]] = adfY[iPoint];
+                adfNodeZ[anCheckV[iCheck]][anCheckU[iCheck]] = adfZ[iPoint];
+            }
+            for( int iSub = 0; iSub < 4; iSub++ )
+            {
+                const int iU = iSub % 2;
+                const int iV = iSub / 2;
+                ApproxTransformGridCell sSubCell;
+                sSubCell.iX0 = aiX[iU];
+                sSubCell.iX1 = aiX[iU + 1];
+                sSubCell.iY0 = aiY[iV];
+                sSubCell.iY1 = aiY[iV + 1];
+                sSubCell.bExact = FALSE;
+                for( int iCorner = 0; iCorner < 4; iCorner++ )
+                {
+                    const int iNodeU = iU + iCorner % 2;
+                    const int iNodeV = iV + iCorner / 2;
+                    sSubCell.adfX[iCorner] = adfNodeX[iNodeV][iNodeU];
+                    sSubCell.adfY[iCorner] = adfNodeY[iNodeV][iNodeU];
+                    sSubCell.adfZ[iCorner] = adfNodeZ[iNodeV][iNodeU];
+                }
+                asSplit.push_back(sSubCell);
+            }
+        }
+        asPending.swap(asSplit);
+    }
+
+#ifdef DEBUG_APPROX_TRANSFORMER
+    int nExact = 0;
+    for( size_t i = 0; i < psGrid->asCells.size(); i++ )
+        nExact += psGrid->asCells[i].bExact;
+    fprintf(stderr, "grid rows %d: %d cells, %d exact\n", psGrid->iRowTop,
+            static_cast<int>(psGrid->asCells.size()), nExact);
+#endif
+}
+
+/************************************************************************/
+/*                       GDALApproxTransformGrid()                      */
+/************************************************************************/
+
+/* Approximate a scanline accepted by GDALApproxTransformIsGridRow() with */
+/* the cells of the band of the 2D grid that contains it, rebuilding */
+/* psGrid if it holds another band. */
+static int GDALApproxTransformGrid( ApproxTransformInfo *psATInfo,
+                                    ApproxTransformGrid *psGrid,
+                                    int bDstToSrc, int nPoints,
+                                    double *x, double *y, double *z,
+                                    int *panSuccess )
+{
+    const int nCellSize = psATInfo->nGridCellSize;
+    const double dfRow = floor(y[0]);
+    const int iRow = static_cast<int>(dfRow);
+    const int iRowTop = (iRow >= 0 ? iRow / nCellSize :
+                         -((-iRow + nCellSize - 1) / nCellSize)) * nCellSize;
+    const double dfXStep = x[1] - x[0];
+    const double dfYOrigin = y[0] - dfRow;
+
+    if( psGrid->asCells.empty() ||
+        psGrid->bDstToSrc != bDstToSrc ||
+        psGrid->nPoints != nPoints ||
+        psGrid->dfXOrigin != x[0] ||
+        psGrid->dfXStep != dfXStep ||
+        psGrid->dfYOrigin != dfYOrigin ||
+        psGrid->dfZ != z[0] ||
+        psGrid->iRowTop != iRowTop )
+    {
+        psGrid->bDstToSrc = bDstToSrc;
+        psGrid->nPoints = nPoints;
+        psGrid->dfXOrigin = x[0];
+        psGrid->dfXStep = dfXStep;
+        psGrid->dfYOrigin = dfYOrigin;
+        psGrid->dfZ = z[0];
+        psGrid->iRowTop = iRowTop;
+        GDALApproxTransformGridBuild( psATInfo, psGrid );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Interpolate the points in the cells crossed by the scanline,    */
+/*      and collect the spans of the cells that must be computed by     */
+/*      the scanline approximation.  Each cell owns the columns         */
+/*      [iX0, iX1[, except the last one that also owns the last point.  */
+/* -------------------------------------------------------------------- */
+    std::vector<std::pair<int, int> > aoExactSpans;
+    for( size_t iCell = 0; iCell < psGrid->asCells.size(); iCell++ )
+    {
+        const ApproxTransformGridCell& sCell = psGrid->asCells[iCell];
+        if( iRow < sCell.iY0 || iRow >= sCell.iY1 )
+            continue;
+        const int iXEnd = (sCell.iX1 == nPoints - 1) ? nPoints : sCell.iX1;
+        if( sCell.bExact )
+        {
+            aoExactSpans.push_back(std::pair<int, int>(sCell.iX0, iXEnd));
+            continue;
+        }
+
+        const double dfV = (iRow - sCell.iY0) /
+                           static_cast<double>(sCell.iY1 - sCell.iY0);
+        const double dfLeftX =
+            sCell.adfX[0] + (sCell.adfX[2] - sCell.adfX[0]) * dfV;
+        const double dfLeftY =
+            sCell.adfY[0] + (sCell.adfY[2] - sCell.adfY[0]) * dfV;
+        const double dfLeftZ =
+            sCell.adfZ[0] + (sCell.adfZ[2] - sCell.adfZ[0]) * dfV;
+        const double dfInvWidth = 1.0 / (sCell.iX1 - sCell.iX0);
+        const double dfDeltaX =
+            (sCell.adfX[1] + (sCell.adfX[3] - sCell.adfX[1]) * dfV - dfLeftX)
+            * dfInvWidth;
+        const double dfDeltaY =
+            (sCell.adfY[1] + (sCell.adfY[3] - sCell.adfY[1]) * dfV - dfLeftY)
+            * dfInvWidth;
+        const double dfDeltaZ =
+            (sCell.adfZ[1] + (sCell.adfZ[3] - sCell.adfZ[1]) * dfV - dfLeftZ)
+            * dfInvWidth;
+        for( int i = sCell.iX0; i < iXEnd; i++ )
+        {
+            const int nDist = i - sCell.iX0;
+            x[i] = dfLeftX + dfDeltaX * nDist;
+            y[i] = dfLeftY + dfDeltaY * nDist;
+            z[i] = dfLeftZ + dfDeltaZ * nDist;
+            panSuccess[i] = TRUE;
+        }
+    }
+
+    if( aoExactSpans.empty() )
+        return TRUE;
+
+    // Merge the adjacent spans, so that the scanline approximation works
+    // on runs as long as possible
+    std::sort(aoExactSpans.begin(), aoExactSpans.end());
+    int bRet = TRUE;
+    size_t iSpan = 0;
+    while( iSpan < aoExactSpans.size() )
+    {
+        const int iStart = aoExactSpans[iSpan].first;
+        int iEnd = aoExactSpans[iSpan].second;
+        for( iSpan++; iSpan < aoExactSpans.size() &&
+                      aoExactSpans[iSpan].first == iEnd; iSpan++ )
+        {
+            iEnd = aoExactSpans[iSpan].second;
+        }
+        if( !GDALApproxTransformRow( psATInfo, bDstToSrc, iEnd - iStart,
+                                     x + iStart, y + iStart, z + iStart,
+                                     panSuccess + iStart ) )
+            bRet = FALSE;
+    }
+    return bRet;
+}
+
+/************************************************************************/
+/*                        GDALApproxTransform()                         */
+/************************************************************************/
+
+/**
+ * Perform approximate transformation.
+ *
+ * Actually performs the approximate transformation described in
+ * GDALCreateApproxTransformer().  This function matches the
+ * GDALTransformerFunc() signature.  Details of the arguments are described
+ * there.
+ */
+
+int GDALApproxTransform( void *pCBData, int bDstToSrc, int nPoints,
+                         double *x, double *y, double *z, int *panSuccess )
+
+{
+    ApproxTransformInfo *psATInfo = (ApproxTransformInfo *) pCBData;
+
+    if( GDALApproxTransformIsGridRow( psATInfo, nPoints, x, y, z ) )
+    {
+        // Concurrent callers, as the threads of the chunk pipeline of
+        // GDALWarpOperation, must not rebuild the grid under each other:
+        // the one that finds it checked out works on a grid of its own.
+        ApproxTransformGrid *psGrid = NULL;
+        {
+            CPLMutexHolderD( &psATInfo->hGridMutex );
+            psGrid = psATInfo->psGrid;
+            psATInfo->psGrid = NULL;
+        }
+        if( psGrid == NULL )
+            psGrid = new ApproxTransformGrid();
+
+        const int bRet = GDALApproxTransformGrid( psATInfo, psGrid,
+                                                  bDstToSrc, nPoints,
+                                                  x, y, z, panSuccess );
+
+        {
+            CPLMutexHolderD( &psATInfo->hGridMutex );
+            if( psATInfo->psGrid == NULL )
+            {
+                psATInfo->psGrid = psGrid;
+                psGrid = NULL;
+            }
+        }
+        delete psGrid;
+        return bRet;
+    }
+
+    return GDALApproxTransformRow( pCBData, bDstToSrc, nPoints,
+                                   x, y, z, panSuccess );
+}
+
 /************************************************************************/
 /*                  GDALDeserializeApproxTransformer()                  */
 /************************************************************************/
@@ -3036,6 +3510,14 @@ GDALDeserializeApproxTransformer( CPLXMLNode *psTree )
                                                            dfMaxError );
         GDALApproxTransformerOwnsSubtransformer( pApproxCBData, TRUE );
 
+        const char* pszGridCellSize =
+            CPLGetXMLValue( psTree, "GridCellSize", NULL );
+        if( pszGridCellSize != NULL )
+        {
+            ((ApproxTransformInfo *) pApproxCBData)->nGridCellSize =
+                MAX(0, atoi(pszGridCellSize));
+        }
+
         return pApproxCBData;
     }
 }
@@ -934,6 +934,42 @@ GDALWarpDstAlphaMasker( void *pMaskFuncArg, int nBandCount,
  * ratio, the higher the performance will be, since exact
  * reprojections must statistically be done with a frequency of
  * 4*error_threshold/SRC_COORD_PRECISION.
+ *
+ * - FILTER_LUT_RESOLUTION: (GDAL >= 2.2). Advanced setting. Defaults to 0.
+ * If set to a positive value N (1024 is a good choice), the weights of the
+ * bilinear, cubic, cubicspline and lanczos resampling filters are tabulated
+ * once per warped chunk for sub-pixel offsets that are multiples of 1/N
+ * pixel, instead of being evaluated for each target pixel and filter tap.
+ * The offset of each source position is rounded to the nearest tabulated
+ * one, so the result is the same as an exact resampling done at a source
+ * position shifted by at most 1/(2N) pixel along each axis. The option is
+ * ignored if the tables would need more than 16 MB, which may happen with a
+ * very large N combined with a large downsampling factor.
+ *
+ * - CHUNK_ORDER: (GDAL >= 2.2). ROW or HILBERT. Defaults to ROW, where the
+ * chunks are processed from top to bottom, and from left to right for chunks
+ * on the same rows. With HILBERT, they are processed along a Hilbert curve,
+ * so that consecutive chunks are neighbours, which improves the reuse of
+ * the source pixels they have in common and the hit ratio of the block cache
+ * of the source dataset. This option is ignored with STREAMABLE_OUTPUT=YES.
+ *
+ * - REUSE_SOURCE_BUFFER: (GDAL >= 2.2). Defaults to YES. When warping in
+ * several chunks, the source buffer of each chunk is kept until the next
+ * one, whose source pixels in common with it are copied instead of being
+ * read and converted again. The source pixels of the chunks are counted twice
+ * against the warp memory limit, so that the kept buffer fits in it too. The
+ * buffer is not kept if a pre or post warp chunk processor is installed.
+ * With REPORT_TIMINGS=YES, the number of source pixels read and reused is
+ * reported in the WARP_TIMING debug messages.
+ *
+ * - CHUNK_PIPELINE_DEPTH: (GDAL >= 2.2). Number of chunks processed at the
+ * same time by GDALWarpOperation::ChunkAndWarpMulti(), or ALL_CPUS for the
+ * number of CPUs plus one. The chunks are read and written one at a time,
+ * in order, while up to CHUNK_PIPELINE_DEPTH - 1 of them are warped in
+ * parallel, each with its own copy of the transformer. Defaults to 3 (2 on
+ * a single CPU machine). The chunks are sized so that all of them fit in
+ * the warp memory limit. With a depth of 2, a single chunk is warped at a
+ * time, with the NUM_THREADS worker threads.
  */
 
 /************************************************************************/
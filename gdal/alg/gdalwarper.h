@@ -351,6 +351,7 @@ void GWKThreadsEnd(void* psThreadDataIn);
 /************************************************************************/
 
 typedef struct _GDALWarpChunk GDALWarpChunk;
+typedef struct _GDALWarpChunkJob GDALWarpChunkJob;
 
 class CPL_DLL GDALWarpOperation {
 private:
@@ -370,21 +371,68 @@ private:
                                       const char *pszType );
 
     CPLMutex        *hIOMutex;
-    CPLMutex        *hWarpMutex;
 
     int             nChunkListCount;
     int             nChunkListMax;
     GDALWarpChunk  *pasChunkList;
+    double          dfChunkMemoryLimit;
 
     int             bReportTimings;
-    unsigned long   nLastTimeReported;
+    double          dfLastTimeReported;
 
     void           *psThreadData;
 
+    // Source buffer of the last chunk read by ChunkAndWarpImage() or
+    // ChunkAndWarpMulti(), so that the next chunk can reuse the source
+    // pixels they have in common. It is owned by its chunk until it is
+    // warped, and then by the operation.
+    int             bReuseSrcBuffer;
+    GByte          *pabyLastSrcBuffer;
+    int             bLastSrcBufferOwned;
+    int             nLastSrcXOff;
+    int             nLastSrcYOff;
+    int             nLastSrcXSize;
+    int             nLastSrcYSize;
+    GIntBig         nSrcPixelsRead;
+    GIntBig         nSrcPixelsReused;
+
     void            WipeChunkList();
     CPLErr          CollectChunkList( int nDstXOff, int nDstYOff,
                                       int nDstXSize, int nDstYSize );
+    void            SortChunkList( int nDstXOff, int nDstYOff,
+                                   int nDstXSize, int nDstYSize );
+    void            StartSrcBufferReuse();
+    void            EndSrcBufferReuse();
+    CPLErr          ReadSrcBuffer( GByte *pabySrcBuffer,
+                                   int nSrcXOff, int nSrcYOff,
+                                   int nSrcXSize, int nSrcYSize );
+    void            KeepSrcBuffer( GByte *pabySrcBuffer,
+                                   int nSrcXOff, int nSrcYOff,
+                                   int nSrcXSize, int nSrcYSize );
     void            ReportTiming( const char * );
+    void            ReportTotalTiming( double dfStartTime,
+                                       int nChunkCount );
+
+    CPLErr          WarpRegionInternal( int nDstXOff, int nDstYOff,
+                                        int nDstXSize, int nDstYSize,
+                                        int nSrcXOff, int nSrcYOff,
+                                        int nSrcXSize, int nSrcYSize,
+                                        int nSrcXExtraSize, int nSrcYExtraSize,
+                                        double dfProgressBase,
+                                        double dfProgressScale,
+                                        GDALWarpChunkJob *psJob );
+    CPLErr          WarpRegionToBufferInternal( int nDstXOff, int nDstYOff,
+                                                int nDstXSize, int nDstYSize,
+                                                void *pDataBuf,
+                                                int nSrcXOff, int nSrcYOff,
+                                                int nSrcXSize, int nSrcYSize,
+                                                int nSrcXExtraSize,
+                                                int nSrcYExtraSize,
+                                                double dfProgressBase,
+                                                double dfProgressScale,
+                                                GDALWarpChunkJob *psJob );
+
+    static void     ChunkThreadMain( void *pThreadData );
 
 public:
                     GDALWarpOperation();
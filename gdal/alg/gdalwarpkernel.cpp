@@ -43,6 +43,12 @@
 #include <limits>
 #include <new>
 
+#if (defined(__x86_64) || defined(_M_X64)) && defined(HAVE_AVX2_AT_COMPILE_TIME)
+#define USE_AVX2
+#include "cpl_cpu_features.h"
+#include "gdalwarpkernel_avx2.hpp"
+#endif
+
 CPL_CVSID("$Id$");
 
 //#define INSTANTIATE_FLOAT64_SSE2_IMPL
@@ -152,6 +158,11 @@ static CPLErr GWKAverageOrMode( GDALWarpKernel * );
 static CPLErr GWKCubicNoMasksOrDstDensityOnlyUShort( GDALWarpKernel * );
 static CPLErr GWKCubicSplineNoMasksOrDstDensityOnlyUShort( GDALWarpKernel * );
 static CPLErr GWKBilinearNoMasksOrDstDensityOnlyUShort( GDALWarpKernel * );
+static CPLErr GWKResampleByte( GDALWarpKernel * );
+static CPLErr GWKResampleShort( GDALWarpKernel * );
+static CPLErr GWKResampleUShort( GDALWarpKernel * );
+static CPLErr GWKResampleFloat( GDALWarpKernel * );
+static CPLErr GWKResampleDouble( GDALWarpKernel * );
 
 /************************************************************************/
 /*                           GWKJobStruct                               */
@@ -1199,6 +1210,28 @@ CPLErr GDALWarpKernel::PerformWarp()
     if( eResample == GRA_Q3 )
         return GWKAverageOrMode( this );
 
+    // Filters with masks, or without a specialized case above
+    if( (eResample == GRA_Bilinear || eResample == GRA_Cubic ||
+         eResample == GRA_CubicSpline || eResample == GRA_Lanczos)
+        && nSrcXSize > 1 && nSrcYSize > 1 )
+    {
+        switch( eWorkingDataType )
+        {
+            case GDT_Byte:
+                return GWKResampleByte( this );
+            case GDT_Int16:
+                return GWKResampleShort( this );
+            case GDT_UInt16:
+                return GWKResampleUShort( this );
+            case GDT_Float32:
+                return GWKResampleFloat( this );
+            case GDT_Float64:
+                return GWKResampleDouble( this );
+            default:
+                break;
+        }
+    }
+
     return GWKGeneralCase( this );
 }
 
@@ -1682,6 +1715,45 @@ static int GWKGetPixelValue( GDALWarpKernel *poWK, int iBand,
     return *pdfDensity != 0.0;
 }
 
+/************************************************************************/
+/*                       GWKGetPixelRowDensity()                        */
+/************************************************************************/
+
+/* Compute the density of nSrcLen source pixels from the validity masks */
+/* and the unified source density. Return FALSE if none is valid. */
+
+static int GWKGetPixelRowDensity( GDALWarpKernel *poWK, int iBand,
+                                  int iSrcOffset, int nSrcLen,
+                                  double* padfDensity )
+{
+    const GUInt32* panUnifiedSrcValid = poWK->panUnifiedSrcValid;
+    const GUInt32* panBandSrcValid = poWK->papanBandSrcValid != NULL ?
+                            poWK->papanBandSrcValid[iBand] : NULL;
+    const float* pafUnifiedSrcDensity = poWK->pafUnifiedSrcDensity;
+    int     bHasValid = FALSE;
+
+    for ( int i = 0; i < nSrcLen; i++ )
+    {
+        const int iOffset = iSrcOffset + i;
+        double dfDensity;
+        if( (panUnifiedSrcValid != NULL &&
+             !(panUnifiedSrcValid[iOffset>>5] & (0x01 << (iOffset & 0x1f))))
+            || (panBandSrcValid != NULL &&
+             !(panBandSrcValid[iOffset>>5] & (0x01 << (iOffset & 0x1f)))) )
+            dfDensity = 0.0;
+        else if( pafUnifiedSrcDensity != NULL )
+            dfDensity = pafUnifiedSrcDensity[iOffset];
+        else
+            dfDensity = 1.0;
+
+        padfDensity[i] = dfDensity;
+        if( dfDensity > 0.000000001 )
+            bHasValid = TRUE;
+    }
+
+    return bHasValid;
+}
+
 /************************************************************************/
 /*                          GWKGetPixelRow()                            */
 /************************************************************************/
@@ -1697,67 +1769,12 @@ static int GWKGetPixelRow( GDALWarpKernel *poWK, int iBand,
 {
     // We know that nSrcLen is even, so we can *always* unroll loops 2x
     int     nSrcLen = nHalfSrcLen * 2;
-    int     bHasValid = FALSE;
     int     i;
 
-    if( padfDensity != NULL )
-    {
-        // Init the density
-        for ( i = 0; i < nSrcLen; i += 2 )
-        {
-            padfDensity[i] = 1.0;
-            padfDensity[i+1] = 1.0;
-        }
-
-        if ( poWK->panUnifiedSrcValid != NULL )
-        {
-            for ( i = 0; i < nSrcLen; i += 2 )
-            {
-                if(poWK->panUnifiedSrcValid[(iSrcOffset+i)>>5]
-                & (0x01 << ((iSrcOffset+i) & 0x1f)))
-                    bHasValid = TRUE;
-                else
-                    padfDensity[i] = 0.0;
-
-                if(poWK->panUnifiedSrcValid[(iSrcOffset+i+1)>>5]
-                & (0x01 << ((iSrcOffset+i+1) & 0x1f)))
-                    bHasValid = TRUE;
-                else
-                    padfDensity[i+1] = 0.0;
-            }
-
-            // Reset or fail as needed
-            if ( bHasValid )
-                bHasValid = FALSE;
-            else
-                return FALSE;
-        }
-
-        if ( poWK->papanBandSrcValid != NULL
-            && poWK->papanBandSrcValid[iBand] != NULL)
-        {
-            for ( i = 0; i < nSrcLen; i += 2 )
-            {
-                if(poWK->papanBandSrcValid[iBand][(iSrcOffset+i)>>5]
-                & (0x01 << ((iSrcOffset+i) & 0x1f)))
-                    bHasValid = TRUE;
-                else
-                    padfDensity[i] = 0.0;
-
-                if(poWK->papanBandSrcValid[iBand][(iSrcOffset+i+1)>>5]
-                & (0x01 << ((iSrcOffset+i+1) & 0x1f)))
-                    bHasValid = TRUE;
-                else
-                    padfDensity[i+1] = 0.0;
-            }
-
-            // Reset or fail as needed
-            if ( bHasValid )
-                bHasValid = FALSE;
-            else
-                return FALSE;
-        }
-    }
+    if( padfDensity != NULL &&
+        !GWKGetPixelRowDensity( poWK, iBand, iSrcOffset, nSrcLen,
+                                padfDensity ) )
+        return FALSE;
 
     // Fetch data
     switch( poWK->eWorkingDataType )
@@ -1914,44 +1931,7 @@ static int GWKGetPixelRow( GDALWarpKernel *poWK, int iBand,
             return FALSE;
     }
 
-    if( padfDensity == NULL )
-        return TRUE;
-
-    if( poWK->pafUnifiedSrcDensity == NULL )
-    {
-        for ( i = 0; i < nSrcLen; i += 2 )
-        {
-            // Take into account earlier calcs
-            if(padfDensity[i] > 0.000000001)
-            {
-                padfDensity[i] = 1.0;
-                bHasValid = TRUE;
-            }
-
-            if(padfDensity[i+1] > 0.000000001)
-            {
-                padfDensity[i+1] = 1.0;
-                bHasValid = TRUE;
-            }
-        }
-    }
-    else
-    {
-        for ( i = 0; i < nSrcLen; i += 2 )
-        {
-            if(padfDensity[i] > 0.000000001)
-                padfDensity[i] = poWK->pafUnifiedSrcDensity[iSrcOffset+i];
-            if(padfDensity[i] > 0.000000001)
-                bHasValid = TRUE;
-
-            if(padfDensity[i+1] > 0.000000001)
-                padfDensity[i+1] = poWK->pafUnifiedSrcDensity[iSrcOffset+i+1];
-            if(padfDensity[i+1] > 0.000000001)
-                bHasValid = TRUE;
-        }
-    }
-
-    return bHasValid;
+    return TRUE;
 }
 
 /************************************************************************/
@@ -2567,6 +2547,134 @@ static double GWKBSpline4Values( double* padfValues )
     }
     return padfValues[0] + padfValues[1] + padfValues[2] + padfValues[3];
 }
+
+/************************************************************************/
+/*                            GWKFilterLUT                              */
+/************************************************************************/
+
+/* Filter weights tabulated for sub-pixel offsets quantized to            */
+/* 1/nResolution pixel (FILTER_LUT_RESOLUTION warp option). Row q of      */
+/* padfX holds the weights of the taps nFiltInitX..nXRadius for an offset */
+/* dfDeltaX = q / nResolution, i.e. the values of                         */
+/* pfnGetWeight((i - dfDeltaX) * MIN(dfXScale, 1)). Same for padfY.       */
+
+// Keep the tables small enough to be cheaply built for each chunk.
+#define GWK_FILTER_LUT_MAX_SIZE (16 * 1024 * 1024)
+
+typedef struct
+{
+    int      nResolution;
+    int      nXCount;
+    int      nYCount;
+    double  *padfX;
+    double  *padfY;
+} GWKFilterLUT;
+
+static void GWKFilterLUTFill( double* padfLUT, int nResolution,
+                              int nFiltInit, int nCount, double dfScale,
+                              FilterFuncType pfnGetWeight )
+{
+    if( dfScale > 1.0 ) dfScale = 1.0;
+    for( int q = 0; q <= nResolution; q++ )
+    {
+        const double dfDelta = (double)q / nResolution;
+        double* padfRow = padfLUT + (size_t)q * nCount;
+        for( int k = 0; k < nCount; k++ )
+            padfRow[k] = pfnGetWeight((nFiltInit + k - dfDelta) * dfScale);
+    }
+}
+
+/* Only the tables of the axes for which bNeedX and bNeedY are set are */
+/* built, the other ones are left NULL. */
+static GWKFilterLUT* GWKFilterLUTCreate( GDALWarpKernel *poWK,
+                                         bool bNeedX = true,
+                                         bool bNeedY = true )
+{
+    const int nResolution = atoi(CSLFetchNameValueDef(
+        poWK->papszWarpOptions, "FILTER_LUT_RESOLUTION", "0"));
+    FilterFuncType pfnGetWeight = apfGWKFilter[poWK->eResample];
+    if( nResolution <= 0 || pfnGetWeight == NULL || (!bNeedX && !bNeedY) )
+        return NULL;
+
+    const int nXCount = poWK->nXRadius - poWK->nFiltInitX + 1;
+    const int nYCount = poWK->nYRadius - poWK->nFiltInitY + 1;
+    const double dfSize = (nResolution + 1.0) *
+        ((bNeedX ? nXCount : 0) + (bNeedY ? nYCount : 0)) * sizeof(double);
+    if( dfSize > GWK_FILTER_LUT_MAX_SIZE )
+    {
+        CPLDebug("WARP", "FILTER_LUT_RESOLUTION=%d ignored: weight tables "
+                 "would need %.0f bytes", nResolution, dfSize);
+        return NULL;
+    }
+
+    GWKFilterLUT* psLUT = (GWKFilterLUT*)CPLMalloc(sizeof(GWKFilterLUT));
+    psLUT->nResolution = nResolution;
+    psLUT->nXCount = nXCount;
+    psLUT->nYCount = nYCount;
+    psLUT->padfX = NULL;
+    psLUT->padfY = NULL;
+    if( bNeedX )
+    {
+        psLUT->padfX = (double*)CPLMalloc(
+            (size_t)(nResolution + 1) * nXCount * sizeof(double));
+        GWKFilterLUTFill(psLUT->padfX, nResolution, poWK->nFiltInitX, nXCount,
+                         poWK->dfXScale, pfnGetWeight);
+    }
+    if( bNeedY )
+    {
+        psLUT->padfY = (double*)CPLMalloc(
+            (size_t)(nResolution + 1) * nYCount * sizeof(double));
+        GWKFilterLUTFill(psLUT->padfY, nResolution, poWK->nFiltInitY, nYCount,
+                         poWK->dfYScale, pfnGetWeight);
+    }
+    return psLUT;
+}
+
+static void GWKFilterLUTDestroy( GWKFilterLUT* psLUT )
+{
+    if( psLUT == NULL )
+        return;
+    CPLFree( psLUT->padfX );
+    CPLFree( psLUT->padfY );
+    CPLFree( psLUT );
+}
+
+/* Return the weights of the taps nFiltInitX..nXRadius for dfDeltaX in [0,1] */
+static CPL_INLINE const double* GWKFilterLUTGetX( const GWKFilterLUT* psLUT,
+                                                  double dfDeltaX )
+{
+    const int q = (int)(dfDeltaX * psLUT->nResolution + 0.5);
+    return psLUT->padfX + (size_t)q * psLUT->nXCount;
+}
+
+static CPL_INLINE const double* GWKFilterLUTGetY( const GWKFilterLUT* psLUT,
+                                                  double dfDeltaY )
+{
+    const int q = (int)(dfDeltaY * psLUT->nResolution + 0.5);
+    return psLUT->padfY + (size_t)q * psLUT->nYCount;
+}
+
+/************************************************************************/
+/*                           GWKResampleTaps                            */
+/************************************************************************/
+
+/* Source window of the resampling filter around one target pixel, and  */
+/* the weights of its taps, which do not depend on the band.            */
+/* padfWeightsX[i - nFiltInitX] is the weight of the column iSrcX + i,  */
+/* for iMin <= i <= iMax, and likewise for the rows.                    */
+
+typedef struct
+{
+    int           iSrcX;
+    int           iSrcY;
+    int           iMin;
+    int           iMax;
+    int           jMin;
+    int           jMax;
+    const double *padfWeightsX;
+    const double *padfWeightsY;
+} GWKResampleTaps;
+
 /************************************************************************/
 /*                       GWKResampleWrkStruct                           */
 /************************************************************************/
@@ -2598,6 +2706,9 @@ struct _GWKResampleWrkStruct
     double  *padfRowDensity;
     double  *padfRowReal;
     double  *padfRowImag;
+
+    // Tabulated weights, or NULL if FILTER_LUT_RESOLUTION is not set
+    GWKFilterLUT *psFilterLUT;
 };
 
 /************************************************************************/
@@ -2648,6 +2759,15 @@ static GWKResampleWrkStruct* GWKResampleCreateWrkStruct(GDALWarpKernel *poWK)
     psWrkStruct->padfRowReal = (double *)CPLCalloc( nXDist, sizeof(double) );
     psWrkStruct->padfRowImag = (double *)CPLCalloc( nXDist, sizeof(double) );
 
+    // GWKResampleOptimizedLanczos() only uses the tabulated weights along
+    // the axes that are not downsampled: along the other ones, the weights
+    // are computed once below, as they do not depend on the source pixel.
+    if( poWK->eResample == GRA_Lanczos )
+        psWrkStruct->psFilterLUT = GWKFilterLUTCreate(
+            poWK, poWK->dfXScale >= 1.0, poWK->dfYScale >= 1.0 );
+    else
+        psWrkStruct->psFilterLUT = GWKFilterLUTCreate(poWK);
+
     if( poWK->eResample == GRA_Lanczos )
     {
         psWrkStruct->pfnGWKResample = GWKResampleOptimizedLanczos;
@@ -2702,6 +2822,7 @@ static void GWKResampleDeleteWrkStruct(GWKResampleWrkStruct* psWrkStruct)
     CPLFree( psWrkStruct->padfRowDensity );
     CPLFree( psWrkStruct->padfRowReal );
     CPLFree( psWrkStruct->padfRowImag );
+    GWKFilterLUTDestroy( psWrkStruct->psFilterLUT );
     CPLFree( psWrkStruct );
 }
 
@@ -2750,6 +2871,15 @@ static int GWKResample( GDALWarpKernel *poWK, int iBand,
     FilterFuncType pfnGetWeight = apfGWKFilter[poWK->eResample];
     CPLAssert(pfnGetWeight);
 
+    // Tabulated weights of the taps for the quantized offsets, if enabled
+    const double *padfLUTX = NULL;
+    const double *padfLUTY = NULL;
+    if( psWrkStruct->psFilterLUT != NULL )
+    {
+        padfLUTX = GWKFilterLUTGetX(psWrkStruct->psFilterLUT, dfDeltaX);
+        padfLUTY = GWKFilterLUTGetY(psWrkStruct->psFilterLUT, dfDeltaY);
+    }
+
     // Skip sampling over edge of image
     j = poWK->nFiltInitY;
     int jMax= poWK->nYRadius;
@@ -2786,7 +2916,10 @@ static int GWKResample( GDALWarpKernel *poWK, int iBand,
             continue;
 
          // Calculate the Y weight
-        dfWeight1 = ( bYScaleBelow1 ) ?
+        if( padfLUTY != NULL )
+            dfWeight1 = padfLUTY[j - poWK->nFiltInitY];
+        else
+            dfWeight1 = ( bYScaleBelow1 ) ?
                 pfnGetWeight((j - dfDeltaY) * dfYScale):
                 pfnGetWeight(j - dfDeltaY);
 
@@ -2807,7 +2940,11 @@ static int GWKResample( GDALWarpKernel *poWK, int iBand,
                 continue;
 
             // Make or use a cached set of weights for this row
-            if ( panCalcX[i-iMin] )
+            if ( padfLUTX != NULL )
+            {
+                dfWeight2 = padfLUTX[i - poWK->nFiltInitX];
+            }
+            else if ( panCalcX[i-iMin] )
             {
                 // Use saved weight value instead of recomputing it
                 dfWeight2 = padfWeightsX[i-iMin];
@@ -2867,39 +3004,30 @@ static int GWKResample( GDALWarpKernel *poWK, int iBand,
 }
 
 /************************************************************************/
-/*                      GWKResampleOptimizedLanczos()                   */
+/*                   GWKResampleOptimizedLanczosTaps()                  */
 /************************************************************************/
 
-static int GWKResampleOptimizedLanczos( GDALWarpKernel *poWK, int iBand,
-                        double dfSrcX, double dfSrcY,
-                        double *pdfDensity,
-                        double *pdfReal, double *pdfImag,
-                        GWKResampleWrkStruct* psWrkStruct )
+static void GWKResampleOptimizedLanczosTaps( GDALWarpKernel *poWK,
+                                             GWKResampleWrkStruct* psWrkStruct,
+                                             double dfSrcX, double dfSrcY,
+                                             GWKResampleTaps* psTaps )
 
 {
-    // Save as local variables to avoid following pointers in loops
     const int     nSrcXSize = poWK->nSrcXSize;
     const int     nSrcYSize = poWK->nSrcYSize;
 
-    double  dfAccumulatorReal = 0.0, dfAccumulatorImag = 0.0;
-    double  dfAccumulatorDensity = 0.0;
-    double  dfAccumulatorWeight = 0.0;
     const int     iSrcX = (int) floor( dfSrcX - 0.5 );
     const int     iSrcY = (int) floor( dfSrcY - 0.5 );
-    const int     iSrcOffset = iSrcX + iSrcY * nSrcXSize;
     const double  dfDeltaX = dfSrcX - 0.5 - iSrcX;
     const double  dfDeltaY = dfSrcY - 0.5 - iSrcY;
 
     const double  dfXScale = poWK->dfXScale, dfYScale = poWK->dfYScale;
 
-    // Space for saved X weights
-    double  *padfWeightsX = psWrkStruct->padfWeightsX;
-    double  *padfWeightsY = psWrkStruct->padfWeightsY;
-
-    // Space for saving a row of pixels
-    double  *padfRowDensity = psWrkStruct->padfRowDensity;
-    double  *padfRowReal = psWrkStruct->padfRowReal;
-    double  *padfRowImag = psWrkStruct->padfRowImag;
+    // Space for saved X weights. They point to rows of the tabulated
+    // weights instead if FILTER_LUT_RESOLUTION is set and the scale >= 1.
+    const double *padfWeightsX = psWrkStruct->padfWeightsX;
+    const double *padfWeightsY = psWrkStruct->padfWeightsY;
+    const GWKFilterLUT *psFilterLUT = psWrkStruct->psFilterLUT;
 
     // Skip sampling over edge of image
     int jMin = poWK->nFiltInitY, jMax= poWK->nYRadius;
@@ -2929,7 +3057,11 @@ static int GWKResampleOptimizedLanczos( GDALWarpKernel *poWK, int iBand,
         while( iMax - dfDeltaX > 3.0 )
             iMax --;
 
-        if( iSrcX != psWrkStruct->iLastSrcX ||
+        if( psFilterLUT != NULL )
+        {
+            padfWeightsX = GWKFilterLUTGetX(psFilterLUT, dfDeltaX);
+        }
+        else if( iSrcX != psWrkStruct->iLastSrcX ||
             dfDeltaX != psWrkStruct->dfLastDeltaX )
         {
             // Optimisation of GWKLanczosSinc(i - dfDeltaX) based on the following
@@ -2966,9 +3098,9 @@ static int GWKResampleOptimizedLanczos( GDALWarpKernel *poWK, int iBand,
             {
                 const double dfX = i - dfDeltaX;
                 if (dfX == 0.0)
-                    padfWeightsX[i-poWK->nFiltInitX] = 1.0;
+                    psWrkStruct->padfWeightsX[i-poWK->nFiltInitX] = 1.0;
                 else
-                    padfWeightsX[i-poWK->nFiltInitX] =
+                    psWrkStruct->padfWeightsX[i-poWK->nFiltInitX] =
                                             padfCst[(i + 3) % 3] / (dfX * dfX);
                 //CPLAssert(fabs(padfWeightsX[i-poWK->nFiltInitX] - GWKLanczosSinc(dfX, 3.0)) < 1e-10);
             }
@@ -2993,7 +3125,11 @@ static int GWKResampleOptimizedLanczos( GDALWarpKernel *poWK, int iBand,
         while( jMax - dfDeltaY > 3.0 )
             jMax --;
 
-        if( iSrcY != psWrkStruct->iLastSrcY ||
+        if( psFilterLUT != NULL )
+        {
+            padfWeightsY = GWKFilterLUTGetY(psFilterLUT, dfDeltaY);
+        }
+        else if( iSrcY != psWrkStruct->iLastSrcY ||
             dfDeltaY != psWrkStruct->dfLastDeltaY )
         {
             double dfSinPIDeltaYOver3 = sin((-M_PI / 3) * dfDeltaY);
@@ -3019,9 +3155,9 @@ static int GWKResampleOptimizedLanczos( GDALWarpKernel *poWK, int iBand,
             {
                 const double dfY = j - dfDeltaY;
                 if (dfY == 0.0)
-                    padfWeightsY[j-poWK->nFiltInitY] = 1.0;
+                    psWrkStruct->padfWeightsY[j-poWK->nFiltInitY] = 1.0;
                 else
-                    padfWeightsY[j-poWK->nFiltInitY] =
+                    psWrkStruct->padfWeightsY[j-poWK->nFiltInitY] =
                                             padfCst[(j + 3) % 3] / (dfY * dfY);
                 //CPLAssert(fabs(padfWeightsY[j-poWK->nFiltInitY] - GWKLanczosSinc(dfY, 3.0)) < 1e-10);
             }
@@ -3031,6 +3167,126 @@ static int GWKResampleOptimizedLanczos( GDALWarpKernel *poWK, int iBand,
         }
     }
 
+    psTaps->iSrcX = iSrcX;
+    psTaps->iSrcY = iSrcY;
+    psTaps->iMin = iMin;
+    psTaps->iMax = iMax;
+    psTaps->jMin = jMin;
+    psTaps->jMax = jMax;
+    psTaps->padfWeightsX = padfWeightsX;
+    psTaps->padfWeightsY = padfWeightsY;
+}
+
+/************************************************************************/
+/*                        GWKResampleComputeTaps()                      */
+/************************************************************************/
+
+/* Same window and weights as GWKResample() and */
+/* GWKResampleOptimizedLanczos(). */
+
+static void GWKResampleComputeTaps( GDALWarpKernel *poWK,
+                                    GWKResampleWrkStruct* psWrkStruct,
+                                    double dfSrcX, double dfSrcY,
+                                    GWKResampleTaps* psTaps )
+
+{
+    if( poWK->eResample == GRA_Lanczos )
+    {
+        GWKResampleOptimizedLanczosTaps( poWK, psWrkStruct, dfSrcX, dfSrcY,
+                                         psTaps );
+        return;
+    }
+
+    const int     nSrcXSize = poWK->nSrcXSize;
+    const int     nSrcYSize = poWK->nSrcYSize;
+
+    const int     iSrcX = (int) floor( dfSrcX - 0.5 );
+    const int     iSrcY = (int) floor( dfSrcY - 0.5 );
+    const double  dfDeltaX = dfSrcX - 0.5 - iSrcX;
+    const double  dfDeltaY = dfSrcY - 0.5 - iSrcY;
+
+    // Skip sampling over edge of image
+    int jMin = poWK->nFiltInitY, jMax = poWK->nYRadius;
+    if( iSrcY + jMin < 0 )
+        jMin = -iSrcY;
+    if( iSrcY + jMax >= nSrcYSize )
+        jMax = nSrcYSize - iSrcY - 1;
+
+    int iMin = poWK->nFiltInitX, iMax = poWK->nXRadius;
+    if( iSrcX + iMin < 0 )
+        iMin = -iSrcX;
+    if( iSrcX + iMax >= nSrcXSize )
+        iMax = nSrcXSize - iSrcX - 1;
+
+    if( psWrkStruct->psFilterLUT != NULL )
+    {
+        psTaps->padfWeightsX =
+            GWKFilterLUTGetX(psWrkStruct->psFilterLUT, dfDeltaX);
+        psTaps->padfWeightsY =
+            GWKFilterLUTGetY(psWrkStruct->psFilterLUT, dfDeltaY);
+    }
+    else
+    {
+        FilterFuncType pfnGetWeight = apfGWKFilter[poWK->eResample];
+        CPLAssert(pfnGetWeight);
+        const double dfXScale = poWK->dfXScale, dfYScale = poWK->dfYScale;
+
+        for( int i = iMin; i <= iMax; ++i )
+        {
+            psWrkStruct->padfWeightsX[i - poWK->nFiltInitX] =
+                ( dfXScale < 1.0 ) ? pfnGetWeight((i - dfDeltaX) * dfXScale):
+                                     pfnGetWeight(i - dfDeltaX);
+        }
+        for( int j = jMin; j <= jMax; ++j )
+        {
+            psWrkStruct->padfWeightsY[j - poWK->nFiltInitY] =
+                ( dfYScale < 1.0 ) ? pfnGetWeight((j - dfDeltaY) * dfYScale):
+                                     pfnGetWeight(j - dfDeltaY);
+        }
+        psTaps->padfWeightsX = psWrkStruct->padfWeightsX;
+        psTaps->padfWeightsY = psWrkStruct->padfWeightsY;
+    }
+
+    psTaps->iSrcX = iSrcX;
+    psTaps->iSrcY = iSrcY;
+    psTaps->iMin = iMin;
+    psTaps->iMax = iMax;
+    psTaps->jMin = jMin;
+    psTaps->jMax = jMax;
+}
+
+/************************************************************************/
+/*                      GWKResampleOptimizedLanczos()                   */
+/************************************************************************/
+
+static int GWKResampleOptimizedLanczos( GDALWarpKernel *poWK, int iBand,
+                        double dfSrcX, double dfSrcY,
+                        double *pdfDensity,
+                        double *pdfReal, double *pdfImag,
+                        GWKResampleWrkStruct* psWrkStruct )
+
+{
+    // Save as local variables to avoid following pointers in loops
+    const int     nSrcXSize = poWK->nSrcXSize;
+
+    double  dfAccumulatorReal = 0.0, dfAccumulatorImag = 0.0;
+    double  dfAccumulatorDensity = 0.0;
+    double  dfAccumulatorWeight = 0.0;
+
+    GWKResampleTaps sTaps;
+    GWKResampleOptimizedLanczosTaps( poWK, psWrkStruct, dfSrcX, dfSrcY,
+                                     &sTaps );
+    const int     iSrcOffset = sTaps.iSrcX + sTaps.iSrcY * nSrcXSize;
+    const int     iMin = sTaps.iMin, iMax = sTaps.iMax;
+    const int     jMin = sTaps.jMin, jMax = sTaps.jMax;
+    const double *padfWeightsX = sTaps.padfWeightsX;
+    const double *padfWeightsY = sTaps.padfWeightsY;
+
+    // Space for saving a row of pixels
+    double  *padfRowDensity = psWrkStruct->padfRowDensity;
+    double  *padfRowReal = psWrkStruct->padfRowReal;
+    double  *padfRowImag = psWrkStruct->padfRowImag;
+
     int iRowOffset = iSrcOffset + (jMin - 1) * nSrcXSize + iMin;
 
     // If we have no density information, we can simply compute the
@@ -3160,7 +3416,8 @@ static int GWKResampleOptimizedLanczos( GDALWarpKernel *poWK, int iBand,
 template <class T>
 static int GWKResampleNoMasksT( GDALWarpKernel *poWK, int iBand,
                                 double dfSrcX, double dfSrcY,
-                                T *pValue, double *padfWeight )
+                                T *pValue, double *padfWeight,
+                                const GWKFilterLUT *psFilterLUT )
 
 {
     // Commonly used; save locally
@@ -3205,19 +3462,34 @@ static int GWKResampleNoMasksT( GDALWarpKernel *poWK, int iBand,
     if( iSrcX + iMax >= nSrcXSize-1 )
         iMax = nSrcXSize-1 - iSrcX;
     int i, iC;
-    for(iC = 0, i = iMin; i+2 < iMax; i+=4, iC+=4 )
+    const double *padfLUTY = NULL;
+    if( psFilterLUT != NULL )
     {
-        padfWeight[iC] = (i - dfDeltaX) * dfXScale;
-        padfWeight[iC+1] = padfWeight[iC] + dfXScale;
-        padfWeight[iC+2] = padfWeight[iC+1] + dfXScale;
-        padfWeight[iC+3] = padfWeight[iC+2] + dfXScale;
-        dfAccumulatorWeightHorizontal += pfnGetWeight4Values(padfWeight+iC);
+        const double *padfLUTX = GWKFilterLUTGetX(psFilterLUT, dfDeltaX)
+                                                        - poWK->nFiltInitX;
+        for(iC = 0, i = iMin; i <= iMax; ++i, ++iC )
+        {
+            padfWeight[iC] = padfLUTX[i];
+            dfAccumulatorWeightHorizontal += padfLUTX[i];
+        }
+        padfLUTY = GWKFilterLUTGetY(psFilterLUT, dfDeltaY) - poWK->nFiltInitY;
     }
-    for(; i <= iMax; ++i, ++iC )
+    else
     {
-        double dfWeight = pfnGetWeight((i - dfDeltaX) * dfXScale);
-        padfWeight[iC] = dfWeight;
-        dfAccumulatorWeightHorizontal += dfWeight;
+        for(iC = 0, i = iMin; i+2 < iMax; i+=4, iC+=4 )
+        {
+            padfWeight[iC] = (i - dfDeltaX) * dfXScale;
+            padfWeight[iC+1] = padfWeight[iC] + dfXScale;
+            padfWeight[iC+2] = padfWeight[iC+1] + dfXScale;
+            padfWeight[iC+3] = padfWeight[iC+2] + dfXScale;
+            dfAccumulatorWeightHorizontal += pfnGetWeight4Values(padfWeight+iC);
+        }
+        for(; i <= iMax; ++i, ++iC )
+        {
+            double dfWeight = pfnGetWeight((i - dfDeltaX) * dfXScale);
+            padfWeight[iC] = dfWeight;
+            dfAccumulatorWeightHorizontal += dfWeight;
+        }
     }
 
     int j = 1 - nYRadius;
@@ -3258,7 +3530,8 @@ static int GWKResampleNoMasksT( GDALWarpKernel *poWK, int iBand,
         }
 
         // Calculate the Y weight
-        double  dfWeight = pfnGetWeight((j - dfDeltaY) * dfYScale);
+        double  dfWeight = ( padfLUTY != NULL ) ? padfLUTY[j] :
+                                pfnGetWeight((j - dfDeltaY) * dfYScale);
         dfAccumulator += dfWeight * dfAccumulatorLocal;
         dfAccumulatorWeightVertical += dfWeight;
     }
@@ -3283,7 +3556,8 @@ static int GWKResampleNoMasksT( GDALWarpKernel *poWK, int iBand,
 template<class T>
 static int GWKResampleNoMasks_SSE2_T( GDALWarpKernel *poWK, int iBand,
                                       double dfSrcX, double dfSrcY,
-                                      T *pValue, double *padfWeight )
+                                      T *pValue, double *padfWeight,
+                                      const GWKFilterLUT *psFilterLUT )
 {
     // Commonly used; save locally
     int     nSrcXSize = poWK->nSrcXSize;
@@ -3327,19 +3601,34 @@ static int GWKResampleNoMasks_SSE2_T( GDALWarpKernel *poWK, int iBand,
     if( iSrcX + iMax >= nSrcXSize-1 )
         iMax = nSrcXSize-1 - iSrcX;
     int i, iC;
-    for(iC = 0, i = iMin; i+2 < iMax; i+=4, iC+=4 )
+    const double *padfLUTY = NULL;
+    if( psFilterLUT != NULL )
     {
-        padfWeight[iC] = (i - dfDeltaX) * dfXScale;
-        padfWeight[iC+1] = padfWeight[iC] + dfXScale;
-        padfWeight[iC+2] = padfWeight[iC+1] + dfXScale;
-        padfWeight[iC+3] = padfWeight[iC+2] + dfXScale;
-        dfAccumulatorWeightHorizontal += pfnGetWeight4Values(padfWeight+iC);
+        const double *padfLUTX = GWKFilterLUTGetX(psFilterLUT, dfDeltaX)
+                                                        - poWK->nFiltInitX;
+        for(iC = 0, i = iMin; i <= iMax; ++i, ++iC )
+        {
+            padfWeight[iC] = padfLUTX[i];
+            dfAccumulatorWeightHorizontal += padfLUTX[i];
+        }
+        padfLUTY = GWKFilterLUTGetY(psFilterLUT, dfDeltaY) - poWK->nFiltInitY;
     }
-    for(; i <= iMax; ++i, ++iC )
+    else
     {
-        double dfWeight = pfnGetWeight((i - dfDeltaX) * dfXScale);
-        padfWeight[iC] = dfWeight;
-        dfAccumulatorWeightHorizontal += dfWeight;
+        for(iC = 0, i = iMin; i+2 < iMax; i+=4, iC+=4 )
+        {
+            padfWeight[iC] = (i - dfDeltaX) * dfXScale;
+            padfWeight[iC+1] = padfWeight[iC] + dfXScale;
+            padfWeight[iC+2] = padfWeight[iC+1] + dfXScale;
+            padfWeight[iC+3] = padfWeight[iC+2] + dfXScale;
+            dfAccumulatorWeightHorizontal += pfnGetWeight4Values(padfWeight+iC);
+        }
+        for(; i <= iMax; ++i, ++iC )
+        {
+            double dfWeight = pfnGetWeight((i - dfDeltaX) * dfXScale);
+            padfWeight[iC] = dfWeight;
+            dfAccumulatorWeightHorizontal += dfWeight;
+        }
     }
 
     int j = 1 - nYRadius;
@@ -3416,11 +3705,23 @@ static int GWKResampleNoMasks_SSE2_T( GDALWarpKernel *poWK, int iBand,
 
         // Calculate the Y weight
         double adfWeight[4];
-        adfWeight[0] = (j - dfDeltaY) * dfYScale;
-        adfWeight[1] = adfWeight[0] + dfYScale;
-        adfWeight[2] = adfWeight[1] + dfYScale;
-        adfWeight[3] = adfWeight[2] + dfYScale;
-        dfAccumulatorWeightVertical += pfnGetWeight4Values(adfWeight);
+        if( padfLUTY != NULL )
+        {
+            adfWeight[0] = padfLUTY[j];
+            adfWeight[1] = padfLUTY[j+1];
+            adfWeight[2] = padfLUTY[j+2];
+            adfWeight[3] = padfLUTY[j+3];
+            dfAccumulatorWeightVertical +=
+                adfWeight[0] + adfWeight[1] + adfWeight[2] + adfWeight[3];
+        }
+        else
+        {
+            adfWeight[0] = (j - dfDeltaY) * dfYScale;
+            adfWeight[1] = adfWeight[0] + dfYScale;
+            adfWeight[2] = adfWeight[1] + dfYScale;
+            adfWeight[3] = adfWeight[2] + dfYScale;
+            dfAccumulatorWeightVertical += pfnGetWeight4Values(adfWeight);
+        }
         dfAccumulator += adfWeight[0] * dfAccumulatorLocal_1;
         dfAccumulator += adfWeight[1] * dfAccumulatorLocal_2;
         dfAccumulator += adfWeight[2] * dfAccumulatorLocal_3;
@@ -3461,7 +3762,8 @@ static int GWKResampleNoMasks_SSE2_T( GDALWarpKernel *poWK, int iBand,
         }
 
         // Calculate the Y weight
-        double  dfWeight = pfnGetWeight((j - dfDeltaY) * dfYScale);
+        double  dfWeight = ( padfLUTY != NULL ) ? padfLUTY[j] :
+                                pfnGetWeight((j - dfDeltaY) * dfYScale);
         dfAccumulator += dfWeight * dfAccumulatorLocal;
         dfAccumulatorWeightVertical += dfWeight;
     }
@@ -3480,9 +3782,11 @@ static int GWKResampleNoMasks_SSE2_T( GDALWarpKernel *poWK, int iBand,
 template<>
 int GWKResampleNoMasksT<GByte>( GDALWarpKernel *poWK, int iBand,
                                 double dfSrcX, double dfSrcY,
-                                GByte *pValue, double *padfWeight )
+                                GByte *pValue, double *padfWeight,
+                                const GWKFilterLUT *psFilterLUT )
 {
-    return GWKResampleNoMasks_SSE2_T(poWK, iBand, dfSrcX, dfSrcY, pValue, padfWeight);
+    return GWKResampleNoMasks_SSE2_T(poWK, iBand, dfSrcX, dfSrcY, pValue, padfWeight,
+                                     psFilterLUT);
 }
 
 /************************************************************************/
@@ -3492,9 +3796,11 @@ int GWKResampleNoMasksT<GByte>( GDALWarpKernel *poWK, int iBand,
 template<>
 int GWKResampleNoMasksT<GInt16>( GDALWarpKernel *poWK, int iBand,
                                  double dfSrcX, double dfSrcY,
-                                 GInt16 *pValue, double *padfWeight )
+                                 GInt16 *pValue, double *padfWeight,
+                                 const GWKFilterLUT *psFilterLUT )
 {
-    return GWKResampleNoMasks_SSE2_T(poWK, iBand, dfSrcX, dfSrcY, pValue, padfWeight);
+    return GWKResampleNoMasks_SSE2_T(poWK, iBand, dfSrcX, dfSrcY, pValue, padfWeight,
+                                     psFilterLUT);
 }
 
 /************************************************************************/
@@ -3504,9 +3810,11 @@ int GWKResampleNoMasksT<GInt16>( GDALWarpKernel *poWK, int iBand,
 template<>
 int GWKResampleNoMasksT<GUInt16>( GDALWarpKernel *poWK, int iBand,
                                   double dfSrcX, double dfSrcY,
-                                  GUInt16 *pValue, double *padfWeight )
+                                  GUInt16 *pValue, double *padfWeight,
+                                  const GWKFilterLUT *psFilterLUT )
 {
-    return GWKResampleNoMasks_SSE2_T(poWK, iBand, dfSrcX, dfSrcY, pValue, padfWeight);
+    return GWKResampleNoMasks_SSE2_T(poWK, iBand, dfSrcX, dfSrcY, pValue, padfWeight,
+                                     psFilterLUT);
 }
 
 /************************************************************************/
@@ -3516,9 +3824,11 @@ int GWKResampleNoMasksT<GUInt16>( GDALWarpKernel *poWK, int iBand,
 template<>
 int GWKResampleNoMasksT<float>( GDALWarpKernel *poWK, int iBand,
                                  double dfSrcX, double dfSrcY,
-                                 float *pValue, double *padfWeight )
+                                 float *pValue, double *padfWeight,
+                                 const GWKFilterLUT *psFilterLUT )
 {
-    return GWKResampleNoMasks_SSE2_T(poWK, iBand, dfSrcX, dfSrcY, pValue, padfWeight);
+    return GWKResampleNoMasks_SSE2_T(poWK, iBand, dfSrcX, dfSrcY, pValue, padfWeight,
+                                     psFilterLUT);
 }
 
 #ifdef INSTANTIATE_FLOAT64_SSE2_IMPL
@@ -3530,9 +3840,11 @@ int GWKResampleNoMasksT<float>( GDALWarpKernel *poWK, int iBand,
 template<>
 int GWKResampleNoMasksT<double>( GDALWarpKernel *poWK, int iBand,
                                  double dfSrcX, double dfSrcY,
-                                 double *pValue, double *padfWeight )
+                                 double *pValue, double *padfWeight,
+                                 const GWKFilterLUT *psFilterLUT )
 {
-    return GWKResampleNoMasks_SSE2_T(poWK, iBand, dfSrcX, dfSrcY, pValue, padfWeight);
+    return GWKResampleNoMasks_SSE2_T(poWK, iBand, dfSrcX, dfSrcY, pValue, padfWeight,
+                                     psFilterLUT);
 }
 
 #endif /* INSTANTIATE_FLOAT64_SSE2_IMPL */
@@ -3978,53 +4290,51 @@ static CPLErr GWKGeneralCase( GDALWarpKernel *poWK )
     return GWKRun( poWK, "GWKGeneralCase", GWKGeneralCaseThread );
 }
 
-static void GWKGeneralCaseThread( void* pData)
+/************************************************************************/
+/*                     GWKGeneralCaseThreadInternal()                   */
+/*                                                                      */
+/*      Loop over the destination pixels shared by                      */
+/*      GWKGeneralCaseThread() and GWKResampleThread(). The sampler     */
+/*      collects the value of each band at a source location: its       */
+/*      SetPixel() method is called once per destination pixel, before  */
+/*      its Sample() method is called for each band.                    */
+/************************************************************************/
+
+template<class Sampler>
+static void GWKGeneralCaseThreadInternal( GWKJobStruct* psJob,
+                                          Sampler& oSampler )
 
 {
-    GWKJobStruct* psJob = (GWKJobStruct*) pData;
     GDALWarpKernel *poWK = psJob->poWK;
-    int iYMin = psJob->iYMin;
-    int iYMax = psJob->iYMax;
+    const int iYMin = psJob->iYMin;
+    const int iYMax = psJob->iYMax;
 
-    int iDstY;
-    int nDstXSize = poWK->nDstXSize;
-    int nSrcXSize = poWK->nSrcXSize, nSrcYSize = poWK->nSrcYSize;
+    const int nDstXSize = poWK->nDstXSize;
+    const int nSrcXSize = poWK->nSrcXSize, nSrcYSize = poWK->nSrcYSize;
 
 /* -------------------------------------------------------------------- */
 /*      Allocate x,y,z coordinate arrays for transformation ... one     */
 /*      scanlines worth of positions.                                   */
 /* -------------------------------------------------------------------- */
-    double *padfX, *padfY, *padfZ;
-    int    *pabSuccess;
-
-    padfX = (double *) CPLMalloc(sizeof(double) * nDstXSize);
-    padfY = (double *) CPLMalloc(sizeof(double) * nDstXSize);
-    padfZ = (double *) CPLMalloc(sizeof(double) * nDstXSize);
-    pabSuccess = (int *) CPLMalloc(sizeof(int) * nDstXSize);
+    double *padfX = (double *) CPLMalloc(sizeof(double) * nDstXSize);
+    double *padfY = (double *) CPLMalloc(sizeof(double) * nDstXSize);
+    double *padfZ = (double *) CPLMalloc(sizeof(double) * nDstXSize);
+    int    *pabSuccess = (int *) CPLMalloc(sizeof(int) * nDstXSize);
 
-    int bUse4SamplesFormula = (poWK->dfXScale >= 0.95 && poWK->dfYScale >= 0.95);
-
-    GWKResampleWrkStruct* psWrkStruct = NULL;
-    if (poWK->eResample != GRA_NearestNeighbour)
-    {
-        psWrkStruct = GWKResampleCreateWrkStruct(poWK);
-    }
-    double dfSrcCoordPrecision = CPLAtof(
+    const double dfSrcCoordPrecision = CPLAtof(
         CSLFetchNameValueDef(poWK->papszWarpOptions, "SRC_COORD_PRECISION", "0"));
-    double dfErrorThreshold = CPLAtof(
+    const double dfErrorThreshold = CPLAtof(
         CSLFetchNameValueDef(poWK->papszWarpOptions, "ERROR_THRESHOLD", "0"));
 
 /* ==================================================================== */
 /*      Loop over output lines.                                         */
 /* ==================================================================== */
-    for( iDstY = iYMin; iDstY < iYMax; iDstY++ )
+    for( int iDstY = iYMin; iDstY < iYMax; iDstY++ )
     {
-        int iDstX;
-
 /* -------------------------------------------------------------------- */
 /*      Setup points to transform to source image space.                */
 /* -------------------------------------------------------------------- */
-        for( iDstX = 0; iDstX < nDstXSize; iDstX++ )
+        for( int iDstX = 0; iDstX < nDstXSize; iDstX++ )
         {
             padfX[iDstX] = iDstX + 0.5 + poWK->nDstXOff;
             padfY[iDstX] = iDstY + 0.5 + poWK->nDstYOff;
@@ -4051,10 +4361,8 @@ static void GWKGeneralCaseThread( void* pData)
 /* ==================================================================== */
 /*      Loop over pixels in output scanline.                            */
 /* ==================================================================== */
-        for( iDstX = 0; iDstX < nDstXSize; iDstX++ )
+        for( int iDstX = 0; iDstX < nDstXSize; iDstX++ )
         {
-            int iDstOffset;
-
             int iSrcOffset;
             if( !GWKCheckAndComputeSrcOffsets(pabSuccess, iDstX, padfX, padfY,
                                     poWK, nSrcXSize, nSrcYSize, iSrcOffset) )
@@ -4079,14 +4387,17 @@ static void GWKGeneralCaseThread( void* pData)
                      & (0x01 << (iSrcOffset & 0x1f))) )
                 continue;
 
+            const double dfSrcX = padfX[iDstX] - poWK->nSrcXOff;
+            const double dfSrcY = padfY[iDstX] - poWK->nSrcYOff;
+            oSampler.SetPixel( dfSrcX, dfSrcY );
+
 /* ==================================================================== */
 /*      Loop processing each band.                                      */
 /* ==================================================================== */
-            int iBand;
             int bHasFoundDensity = FALSE;
+            const int iDstOffset = iDstX + iDstY * nDstXSize;
 
-            iDstOffset = iDstX + iDstY * nDstXSize;
-            for( iBand = 0; iBand < poWK->nBands; iBand++ )
+            for( int iBand = 0; iBand < poWK->nBands; iBand++ )
             {
                 double dfBandDensity = 0.0;
                 double dfValueReal = 0.0;
@@ -4095,44 +4406,8 @@ static void GWKGeneralCaseThread( void* pData)
 /* -------------------------------------------------------------------- */
 /*      Collect the source value.                                       */
 /* -------------------------------------------------------------------- */
-                if ( poWK->eResample == GRA_NearestNeighbour ||
-                     nSrcXSize == 1 || nSrcYSize == 1)
-                {
-                    // FALSE is returned if dfBandDensity == 0, which is
-                    // checked below
-                    CPL_IGNORE_RET_VAL(GWKGetPixelValue( poWK, iBand, iSrcOffset,
-                                      &dfBandDensity, &dfValueReal, &dfValueImag ));
-                }
-                else if ( poWK->eResample == GRA_Bilinear &&
-                          bUse4SamplesFormula )
-                {
-                    GWKBilinearResample4Sample( poWK, iBand,
-                                         padfX[iDstX]-poWK->nSrcXOff,
-                                         padfY[iDstX]-poWK->nSrcYOff,
-                                         &dfBandDensity,
-                                         &dfValueReal, &dfValueImag );
-                }
-                else if ( poWK->eResample == GRA_Cubic &&
-                          bUse4SamplesFormula )
-                {
-                    GWKCubicResample4Sample( poWK, iBand,
-                                        padfX[iDstX]-poWK->nSrcXOff,
-                                        padfY[iDstX]-poWK->nSrcYOff,
-                                        &dfBandDensity,
-                                        &dfValueReal, &dfValueImag );
-                }
-                else
-#ifdef DEBUG
-                if( psWrkStruct != NULL ) /* only useful for clang static analyzer */
-#endif
-                {
-                    psWrkStruct->pfnGWKResample( poWK, iBand,
-                                 padfX[iDstX]-poWK->nSrcXOff,
-                                 padfY[iDstX]-poWK->nSrcYOff,
-                                 &dfBandDensity,
-                                 &dfValueReal, &dfValueImag, psWrkStruct );
-                }
-
+                oSampler.Sample( iBand, iSrcOffset, dfSrcX, dfSrcY,
+                                 &dfBandDensity, &dfValueReal, &dfValueImag );
 
                 // If we didn't find any valid inputs skip to next band.
                 if ( dfBandDensity < 0.0000000001 )
@@ -4180,8 +4455,375 @@ static void GWKGeneralCaseThread( void* pData)
     CPLFree( padfY );
     CPLFree( padfZ );
     CPLFree( pabSuccess );
-    if (psWrkStruct)
+}
+
+/************************************************************************/
+/*                        GWKGeneralCaseSampler                         */
+/************************************************************************/
+
+/* Sampler of GWKGeneralCaseThread(), for any resampling and data type. */
+
+class GWKGeneralCaseSampler
+{
+    GDALWarpKernel       *poWK;
+    GWKResampleWrkStruct *psWrkStruct;
+    int                   bUse4SamplesFormula;
+
+    GWKGeneralCaseSampler( const GWKGeneralCaseSampler& );
+    GWKGeneralCaseSampler& operator=( const GWKGeneralCaseSampler& );
+
+  public:
+    explicit GWKGeneralCaseSampler( GDALWarpKernel *poWKIn ) :
+        poWK(poWKIn),
+        psWrkStruct(NULL),
+        bUse4SamplesFormula(poWKIn->dfXScale >= 0.95 &&
+                            poWKIn->dfYScale >= 0.95)
+    {
+        if (poWK->eResample != GRA_NearestNeighbour)
+        {
+            psWrkStruct = GWKResampleCreateWrkStruct(poWK);
+        }
+    }
+
+    ~GWKGeneralCaseSampler()
+    {
+        if (psWrkStruct)
+            GWKResampleDeleteWrkStruct(psWrkStruct);
+    }
+
+    void SetPixel( double /* dfSrcX */, double /* dfSrcY */ ) {}
+
+    void Sample( int iBand, int iSrcOffset, double dfSrcX, double dfSrcY,
+                 double *pdfBandDensity,
+                 double *pdfValueReal, double *pdfValueImag )
+    {
+        if ( poWK->eResample == GRA_NearestNeighbour ||
+             poWK->nSrcXSize == 1 || poWK->nSrcYSize == 1)
+        {
+            // FALSE is returned if dfBandDensity == 0, which is
+            // checked by the caller
+            CPL_IGNORE_RET_VAL(GWKGetPixelValue( poWK, iBand, iSrcOffset,
+                              pdfBandDensity, pdfValueReal, pdfValueImag ));
+        }
+        else if ( poWK->eResample == GRA_Bilinear &&
+                  bUse4SamplesFormula )
+        {
+            GWKBilinearResample4Sample( poWK, iBand, dfSrcX, dfSrcY,
+                                        pdfBandDensity,
+                                        pdfValueReal, pdfValueImag );
+        }
+        else if ( poWK->eResample == GRA_Cubic &&
+                  bUse4SamplesFormula )
+        {
+            GWKCubicResample4Sample( poWK, iBand, dfSrcX, dfSrcY,
+                                     pdfBandDensity,
+                                     pdfValueReal, pdfValueImag );
+        }
+        else
+#ifdef DEBUG
+        if( psWrkStruct != NULL ) /* only useful for clang static analyzer */
+#endif
+        {
+            psWrkStruct->pfnGWKResample( poWK, iBand, dfSrcX, dfSrcY,
+                                         pdfBandDensity,
+                                         pdfValueReal, pdfValueImag,
+                                         psWrkStruct );
+        }
+    }
+};
+
+static void GWKGeneralCaseThread( void* pData)
+
+{
+    GWKJobStruct* psJob = (GWKJobStruct*) pData;
+    GWKGeneralCaseSampler oSampler(psJob->poWK);
+    GWKGeneralCaseThreadInternal(psJob, oSampler);
+}
+
+/************************************************************************/
+/*                        GWKAccumulateWindowT()                        */
+/************************************************************************/
+
+/* Accumulate the nXCount x nYCount source values of the filter window, */
+/* weighted by padfWeightsX[i] * padfWeightsY[j]. If padfDensity is not */
+/* NULL, it holds the densities of the window pixels, in rows padded to a */
+/* multiple of 4 values, and the ones below 1e-9 are skipped. padfAcc[0] */
+/* receives the weighted sum of the values, padfAcc[1] the one of the */
+/* densities and padfAcc[2] the sum of the weights. */
+
+template<class T>
+static void GWKAccumulateWindowT( const T* pSrc, int nSrcLineStride,
+                                  const double* padfDensity,
+                                  const double* padfWeightsX, int nXCount,
+                                  const double* padfWeightsY, int nYCount,
+                                  double* padfAcc )
+{
+    double dfAccumulatorReal = 0.0;
+    double dfAccumulatorDensity = 0.0;
+    double dfAccumulatorWeight = 0.0;
+
+    for( int j = 0; j < nYCount; ++j, pSrc += nSrcLineStride )
+    {
+        double dfAccumulatorRealLocal = 0.0;
+        double dfAccumulatorDensityLocal = 0.0;
+        double dfAccumulatorWeightLocal = 0.0;
+
+        if( padfDensity == NULL )
+        {
+            for( int i = 0; i < nXCount; ++i )
+            {
+                dfAccumulatorRealLocal += pSrc[i] * padfWeightsX[i];
+                dfAccumulatorWeightLocal += padfWeightsX[i];
+            }
+        }
+        else
+        {
+            for( int i = 0; i < nXCount; ++i )
+            {
+                // Skip sampling if pixel has zero density
+                if( padfDensity[i] < 0.000000001 )
+                    continue;
+
+                dfAccumulatorRealLocal += pSrc[i] * padfWeightsX[i];
+                dfAccumulatorDensityLocal += padfDensity[i] * padfWeightsX[i];
+                dfAccumulatorWeightLocal += padfWeightsX[i];
+            }
+            padfDensity += (nXCount + 3) & ~3;
+        }
+
+        const double dfWeight1 = padfWeightsY[j];
+        dfAccumulatorReal += dfAccumulatorRealLocal * dfWeight1;
+        dfAccumulatorDensity += dfAccumulatorDensityLocal * dfWeight1;
+        dfAccumulatorWeight += dfAccumulatorWeightLocal * dfWeight1;
+    }
+
+    padfAcc[0] = dfAccumulatorReal;
+    padfAcc[1] = dfAccumulatorDensity;
+    padfAcc[2] = dfAccumulatorWeight;
+}
+
+/************************************************************************/
+/*                          GWKResampleTapsT()                          */
+/************************************************************************/
+
+/* Typed equivalent of GWKResample() and GWKResampleOptimizedLanczos() for */
+/* non-complex data types, with the window and weights already computed */
+/* by GWKResampleComputeTaps(). padfWindowDensity is a work buffer for the */
+/* densities of the window, or NULL if there are no source masks. */
+
+template<class T>
+static int GWKResampleTapsT( GDALWarpKernel *poWK, int iBand,
+                             const GWKResampleTaps* psTaps,
+                             double* padfWindowDensity, bool bUseAVX2,
+                             double *pdfDensity, double *pdfReal )
+{
+    const int nSrcXSize = poWK->nSrcXSize;
+    const int nXCount = psTaps->iMax - psTaps->iMin + 1;
+    const int nYCount = psTaps->jMax - psTaps->jMin + 1;
+    const int iSrcOffset = psTaps->iSrcX + psTaps->iMin +
+                           (psTaps->iSrcY + psTaps->jMin) * nSrcXSize;
+
+    if( nXCount <= 0 || nYCount <= 0 )
+    {
+        *pdfDensity = 0.0;
+        return FALSE;
+    }
+
+    if( padfWindowDensity != NULL )
+    {
+        // Rows padded to a multiple of 4 values, as expected by
+        // GWKAccumulateWindowT() and GWKAccumulateWindowAVX2()
+        const int nDensityStride = (nXCount + 3) & ~3;
+        int bHasValid = FALSE;
+        for( int j = 0; j < nYCount; ++j )
+        {
+            double* padfRowDensity = padfWindowDensity + j * nDensityStride;
+            if( GWKGetPixelRowDensity( poWK, iBand,
+                                       iSrcOffset + j * nSrcXSize, nXCount,
+                                       padfRowDensity ) )
+                bHasValid = TRUE;
+        }
+        if( !bHasValid )
+        {
+            *pdfDensity = 0.0;
+            return FALSE;
+        }
+    }
+
+    const T* pSrc = (const T*) poWK->papabySrcImage[iBand] + iSrcOffset;
+    const double* padfWeightsX =
+        psTaps->padfWeightsX + psTaps->iMin - poWK->nFiltInitX;
+    const double* padfWeightsY =
+        psTaps->padfWeightsY + psTaps->jMin - poWK->nFiltInitY;
+    double adfAcc[3];
+#ifdef USE_AVX2
+    if( bUseAVX2 )
+        GWKAccumulateWindowAVX2( pSrc, nSrcXSize, padfWindowDensity,
+                                 padfWeightsX, nXCount,
+                                 padfWeightsY, nYCount, adfAcc );
+    else
+#else
+    (void)bUseAVX2;
+#endif
+        GWKAccumulateWindowT( pSrc, nSrcXSize, padfWindowDensity,
+                              padfWeightsX, nXCount,
+                              padfWeightsY, nYCount, adfAcc );
+
+    const double dfAccumulatorReal = adfAcc[0];
+    const double dfAccumulatorDensity = adfAcc[1];
+    const double dfAccumulatorWeight = adfAcc[2];
+
+    if ( dfAccumulatorWeight < 0.000001 ||
+         (padfWindowDensity != NULL && dfAccumulatorDensity < 0.000001) )
+    {
+        *pdfDensity = 0.0;
+        return FALSE;
+    }
+
+    // Calculate the output taking into account weighting
+    if ( dfAccumulatorWeight < 0.99999 || dfAccumulatorWeight > 1.00001 )
+    {
+        *pdfReal = dfAccumulatorReal / dfAccumulatorWeight;
+        if( padfWindowDensity != NULL )
+            *pdfDensity = dfAccumulatorDensity / dfAccumulatorWeight;
+        else
+            *pdfDensity = 1.0;
+    }
+    else
+    {
+        *pdfReal = dfAccumulatorReal;
+        if( padfWindowDensity != NULL )
+            *pdfDensity = dfAccumulatorDensity;
+        else
+            *pdfDensity = 1.0;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                          GWKResampleSampler                          */
+/************************************************************************/
+
+/* Sampler of GWKResampleThread(). The filter window and weights are */
+/* computed once per pixel for all the bands. */
+
+template<class T>
+class GWKResampleSampler
+{
+    GDALWarpKernel       *poWK;
+    GWKResampleWrkStruct *psWrkStruct;
+    double               *padfWindowDensity;
+    bool                  bUse4Samples;
+    bool                  bUseAVX2;
+    GWKResampleTaps       sTaps;
+
+    GWKResampleSampler( const GWKResampleSampler& );
+    GWKResampleSampler& operator=( const GWKResampleSampler& );
+
+  public:
+    explicit GWKResampleSampler( GDALWarpKernel *poWKIn ) :
+        poWK(poWKIn),
+        psWrkStruct(GWKResampleCreateWrkStruct(poWKIn)),
+        padfWindowDensity(NULL),
+        bUse4Samples(poWKIn->dfXScale >= 0.95 && poWKIn->dfYScale >= 0.95 &&
+                     (poWKIn->eResample == GRA_Bilinear ||
+                      poWKIn->eResample == GRA_Cubic)),
+#ifdef USE_AVX2
+        bUseAVX2(CPLUseAVX2())
+#else
+        bUseAVX2(false)
+#endif
+    {
+        if( psWrkStruct->padfRowDensity != NULL )
+        {
+            padfWindowDensity = (double *) CPLMalloc(
+                sizeof(double) * ((poWK->nXRadius + 1) * 2 + 3) *
+                                 (poWK->nYRadius + 1) * 2 );
+        }
+        memset( &sTaps, 0, sizeof(sTaps) );
+    }
+
+    ~GWKResampleSampler()
+    {
+        CPLFree( padfWindowDensity );
         GWKResampleDeleteWrkStruct(psWrkStruct);
+    }
+
+    void SetPixel( double dfSrcX, double dfSrcY )
+    {
+        if( !bUse4Samples )
+            GWKResampleComputeTaps( poWK, psWrkStruct, dfSrcX, dfSrcY,
+                                    &sTaps );
+    }
+
+    void Sample( int iBand, int /* iSrcOffset */,
+                 double dfSrcX, double dfSrcY,
+                 double *pdfBandDensity,
+                 double *pdfValueReal, double *pdfValueImag )
+    {
+        if( !bUse4Samples )
+        {
+            GWKResampleTapsT<T>( poWK, iBand, &sTaps, padfWindowDensity,
+                                 bUseAVX2, pdfBandDensity, pdfValueReal );
+        }
+        else if( poWK->eResample == GRA_Bilinear )
+        {
+            GWKBilinearResample4Sample( poWK, iBand, dfSrcX, dfSrcY,
+                                        pdfBandDensity,
+                                        pdfValueReal, pdfValueImag );
+        }
+        else
+        {
+            GWKCubicResample4Sample( poWK, iBand, dfSrcX, dfSrcY,
+                                     pdfBandDensity,
+                                     pdfValueReal, pdfValueImag );
+        }
+    }
+};
+
+/************************************************************************/
+/*                          GWKResampleThread()                         */
+/*                                                                      */
+/*      Same as GWKGeneralCase() for the bilinear, cubic, cubic spline  */
+/*      and lanczos resamplings of the non-complex data types, with     */
+/*      any kind of masks. The filter window and weights are computed   */
+/*      once for all the bands, and the source values are read without  */
+/*      going through the data type switch of GWKGetPixelRow().         */
+/************************************************************************/
+
+template<class T>
+static void GWKResampleThread( void* pData )
+
+{
+    GWKJobStruct* psJob = (GWKJobStruct*) pData;
+    GWKResampleSampler<T> oSampler(psJob->poWK);
+    GWKGeneralCaseThreadInternal(psJob, oSampler);
+}
+
+static CPLErr GWKResampleByte( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKResampleByte", GWKResampleThread<GByte> );
+}
+
+static CPLErr GWKResampleShort( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKResampleShort", GWKResampleThread<GInt16> );
+}
+
+static CPLErr GWKResampleUShort( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKResampleUShort", GWKResampleThread<GUInt16> );
+}
+
+static CPLErr GWKResampleFloat( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKResampleFloat", GWKResampleThread<float> );
+}
+
+static CPLErr GWKResampleDouble( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKResampleDouble", GWKResampleThread<double> );
 }
 
 /************************************************************************/
@@ -4215,6 +4857,9 @@ static void GWKResampleNoMasksOrDstDensityOnlyThreadInternal( void* pData )
 
     int     nXRadius = poWK->nXRadius;
     double  *padfWeight = (double *)CPLCalloc( 1 + nXRadius * 2, sizeof(double) );
+    GWKFilterLUT *psFilterLUT = NULL;
+    if( eResample != GRA_NearestNeighbour && !bUse4SamplesFormula )
+        psFilterLUT = GWKFilterLUTCreate(poWK);
     double dfSrcCoordPrecision = CPLAtof(
         CSLFetchNameValueDef(poWK->papszWarpOptions, "SRC_COORD_PRECISION", "0"));
     double dfErrorThreshold = CPLAtof(
@@ -4297,7 +4942,7 @@ static void GWKResampleNoMasksOrDstDensityOnlyThreadInternal( void* pData )
                                     padfX[iDstX]-poWK->nSrcXOff,
                                     padfY[iDstX]-poWK->nSrcYOff,
                                     &value,
-                                    padfWeight);
+                                    padfWeight, psFilterLUT);
                 ((T *)poWK->papabyDstImage[iBand])[iDstOffset] = value;
             }
 
@@ -4320,6 +4965,7 @@ static void GWKResampleNoMasksOrDstDensityOnlyThreadInternal( void* pData )
     CPLFree( padfZ );
     CPLFree( pabSuccess );
     CPLFree( padfWeight );
+    GWKFilterLUTDestroy( psFilterLUT );
 }
 
 template<class T,GDALResampleAlg eResample>
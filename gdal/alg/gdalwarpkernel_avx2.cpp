@@ -0,0 +1,357 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  High Performance Image Reprojector
+ * Purpose:  AVX2 kernels of the warping resamplers
+ *
+ ******************************************************************************
+ * Copyright (c) 2016, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_port.h"
+#include "gdalwarpkernel_avx2.hpp"
+
+#ifdef HAVE_AVX2_AT_COMPILE_TIME
+#include <immintrin.h>
+
+#include <cstring>
+
+CPL_CVSID("$Id$");
+
+namespace {
+
+/************************************************************************/
+/*                              Load4Val()                              */
+/************************************************************************/
+
+inline __m256d Load4Val( const GByte* ptr )
+{
+    int i;
+    memcpy(&i, ptr, 4);
+    return _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(i)));
+}
+
+inline __m256d Load4Val( const GInt16* ptr )
+{
+    return _mm256_cvtepi32_pd(_mm_cvtepi16_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr))));
+}
+
+inline __m256d Load4Val( const GUInt16* ptr )
+{
+    return _mm256_cvtepi32_pd(_mm_cvtepu16_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr))));
+}
+
+inline __m256d Load4Val( const float* ptr )
+{
+    return _mm256_cvtps_pd(_mm_loadu_ps(ptr));
+}
+
+inline __m256d Load4Val( const double* ptr )
+{
+    return _mm256_loadu_pd(ptr);
+}
+
+/************************************************************************/
+/*                             Transpose()                              */
+/************************************************************************/
+
+/* Transpose the 4x4 matrix whose rows are r0 to r3, so that c0 to c3 */
+/* receive its columns. */
+inline void Transpose( __m256d r0, __m256d r1, __m256d r2, __m256d r3,
+                       __m256d& c0, __m256d& c1, __m256d& c2, __m256d& c3 )
+{
+    const __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    const __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    const __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    const __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    c0 = _mm256_permute2f128_pd(t0, t2, 0x20);
+    c1 = _mm256_permute2f128_pd(t1, t3, 0x20);
+    c2 = _mm256_permute2f128_pd(t0, t2, 0x31);
+    c3 = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
+
+/************************************************************************/
+/*                          AccumulateMasked()                          */
+/************************************************************************/
+
+/* Add to each lane the contribution of one pixel of its row, unless its */
+/* density is below the threshold. The test is written as in the scalar */
+/* code, so that a NaN density is not skipped, and the products are masked */
+/* rather than the weights, so that a NaN value of a skipped pixel is */
+/* ignored. Adding a masked +0 leaves the sums unchanged, as skipping. */
+
+inline void AccumulateMasked( __m256d v_val, __m256d v_density,
+                              __m256d v_weight, __m256d v_threshold,
+                              __m256d& v_acc_real, __m256d& v_acc_density,
+                              __m256d& v_acc_weight )
+{
+    const __m256d v_mask =
+        _mm256_cmp_pd(v_density, v_threshold, _CMP_NLT_UQ);
+    v_acc_real = _mm256_add_pd(v_acc_real,
+                    _mm256_and_pd(v_mask, _mm256_mul_pd(v_val, v_weight)));
+    v_acc_density = _mm256_add_pd(v_acc_density,
+                    _mm256_and_pd(v_mask, _mm256_mul_pd(v_density, v_weight)));
+    v_acc_weight = _mm256_add_pd(v_acc_weight,
+                    _mm256_and_pd(v_mask, v_weight));
+}
+
+/************************************************************************/
+/*                       AccumulateWindowAVX2()                         */
+/************************************************************************/
+
+/* The four lanes of the vectors process four rows of the window, each */
+/* one summing its pixels in increasing order, and the row sums are added */
+/* in increasing row order, which is exactly what the scalar code does. */
+/* Four columns of the four rows are loaded at once and transposed. The */
+/* remaining columns are loaded one by one, and the remaining rows are */
+/* processed as in the scalar code. */
+
+template<class T>
+void AccumulateWindowAVX2( const T* pSrc, int nSrcLineStride,
+                           const double* padfDensity,
+                           const double* padfWeightsX, int nXCount,
+                           const double* padfWeightsY, int nYCount,
+                           double* padfAcc )
+{
+    const int nXCountVec = nXCount & ~3;
+    const int nDensityStride = (nXCount + 3) & ~3;
+    const __m256d v_threshold = _mm256_set1_pd(0.000000001);
+
+    double dfAccumulatorReal = 0.0;
+    double dfAccumulatorDensity = 0.0;
+    double dfAccumulatorWeight = 0.0;
+
+    // Without density, all the rows have the same sum of weights
+    double dfWeightX = 0.0;
+    if( padfDensity == NULL )
+    {
+        for( int i = 0; i < nXCount; ++i )
+            dfWeightX += padfWeightsX[i];
+    }
+
+    int j = 0;
+    for( ; j + 4 <= nYCount; j += 4 )
+    {
+        const T* pSrc0 = pSrc + j * nSrcLineStride;
+        const T* pSrc1 = pSrc0 + nSrcLineStride;
+        const T* pSrc2 = pSrc1 + nSrcLineStride;
+        const T* pSrc3 = pSrc2 + nSrcLineStride;
+        __m256d v_row_real = _mm256_setzero_pd();
+        __m256d v_row_density = _mm256_setzero_pd();
+        __m256d v_row_weight = _mm256_setzero_pd();
+
+        if( padfDensity == NULL )
+        {
+            int i = 0;
+            for( ; i < nXCountVec; i += 4 )
+            {
+                __m256d v_col0, v_col1, v_col2, v_col3;
+                Transpose(Load4Val(pSrc0 + i), Load4Val(pSrc1 + i),
+                          Load4Val(pSrc2 + i), Load4Val(pSrc3 + i),
+                          v_col0, v_col1, v_col2, v_col3);
+                v_row_real = _mm256_add_pd(v_row_real, _mm256_mul_pd(
+                    v_col0, _mm256_set1_pd(padfWeightsX[i])));
+                v_row_real = _mm256_add_pd(v_row_real, _mm256_mul_pd(
+                    v_col1, _mm256_set1_pd(padfWeightsX[i+1])));
+                v_row_real = _mm256_add_pd(v_row_real, _mm256_mul_pd(
+                    v_col2, _mm256_set1_pd(padfWeightsX[i+2])));
+                v_row_real = _mm256_add_pd(v_row_real, _mm256_mul_pd(
+                    v_col3, _mm256_set1_pd(padfWeightsX[i+3])));
+            }
+            for( ; i < nXCount; ++i )
+            {
+                const __m256d v_col = _mm256_setr_pd(
+                    pSrc0[i], pSrc1[i], pSrc2[i], pSrc3[i]);
+                v_row_real = _mm256_add_pd(v_row_real, _mm256_mul_pd(
+                    v_col, _mm256_set1_pd(padfWeightsX[i])));
+            }
+        }
+        else
+        {
+            const double* padfDensity0 = padfDensity + j * nDensityStride;
+            const double* padfDensity1 = padfDensity0 + nDensityStride;
+            const double* padfDensity2 = padfDensity1 + nDensityStride;
+            const double* padfDensity3 = padfDensity2 + nDensityStride;
+            int i = 0;
+            for( ; i < nXCountVec; i += 4 )
+            {
+                __m256d v_col[4];
+                __m256d v_dcol[4];
+                Transpose(Load4Val(pSrc0 + i), Load4Val(pSrc1 + i),
+                          Load4Val(pSrc2 + i), Load4Val(pSrc3 + i),
+                          v_col[0], v_col[1], v_col[2], v_col[3]);
+                Transpose(_mm256_loadu_pd(padfDensity0 + i),
+                          _mm256_loadu_pd(padfDensity1 + i),
+                          _mm256_loadu_pd(padfDensity2 + i),
+                          _mm256_loadu_pd(padfDensity3 + i),
+                          v_dcol[0], v_dcol[1], v_dcol[2], v_dcol[3]);
+                for( int k = 0; k < 4; ++k )
+                {
+                    AccumulateMasked(v_col[k], v_dcol[k],
+                                     _mm256_set1_pd(padfWeightsX[i+k]),
+                                     v_threshold,
+                                     v_row_real, v_row_density, v_row_weight);
+                }
+            }
+            for( ; i < nXCount; ++i )
+            {
+                AccumulateMasked(_mm256_setr_pd(pSrc0[i], pSrc1[i],
+                                                pSrc2[i], pSrc3[i]),
+                                 _mm256_setr_pd(padfDensity0[i],
+                                                padfDensity1[i],
+                                                padfDensity2[i],
+                                                padfDensity3[i]),
+                                 _mm256_set1_pd(padfWeightsX[i]),
+                                 v_threshold,
+                                 v_row_real, v_row_density, v_row_weight);
+            }
+        }
+
+        // Weighted row sums, added in row order
+        const __m256d v_weight_y = _mm256_loadu_pd(padfWeightsY + j);
+        double adfRowReal[4];
+        double adfRowDensity[4];
+        double adfRowWeight[4];
+        _mm256_storeu_pd(adfRowReal, _mm256_mul_pd(v_row_real, v_weight_y));
+        _mm256_storeu_pd(adfRowDensity,
+                         _mm256_mul_pd(v_row_density, v_weight_y));
+        _mm256_storeu_pd(adfRowWeight,
+                         _mm256_mul_pd(v_row_weight, v_weight_y));
+        for( int k = 0; k < 4; ++k )
+        {
+            dfAccumulatorReal += adfRowReal[k];
+            if( padfDensity == NULL )
+            {
+                dfAccumulatorWeight += dfWeightX * padfWeightsY[j+k];
+            }
+            else
+            {
+                dfAccumulatorDensity += adfRowDensity[k];
+                dfAccumulatorWeight += adfRowWeight[k];
+            }
+        }
+    }
+
+    for( ; j < nYCount; ++j )
+    {
+        const T* pSrcRow = pSrc + j * nSrcLineStride;
+        double dfAccumulatorRealLocal = 0.0;
+        double dfAccumulatorDensityLocal = 0.0;
+        double dfAccumulatorWeightLocal = 0.0;
+
+        if( padfDensity == NULL )
+        {
+            for( int i = 0; i < nXCount; ++i )
+            {
+                dfAccumulatorRealLocal += pSrcRow[i] * padfWeightsX[i];
+                dfAccumulatorWeightLocal += padfWeightsX[i];
+            }
+        }
+        else
+        {
+            const double* padfRowDensity = padfDensity + j * nDensityStride;
+            for( int i = 0; i < nXCount; ++i )
+            {
+                if( padfRowDensity[i] < 0.000000001 )
+                    continue;
+
+                dfAccumulatorRealLocal += pSrcRow[i] * padfWeightsX[i];
+                dfAccumulatorDensityLocal +=
+                    padfRowDensity[i] * padfWeightsX[i];
+                dfAccumulatorWeightLocal += padfWeightsX[i];
+            }
+        }
+
+        const double dfWeight1 = padfWeightsY[j];
+        dfAccumulatorReal += dfAccumulatorRealLocal * dfWeight1;
+        dfAccumulatorDensity += dfAccumulatorDensityLocal * dfWeight1;
+        dfAccumulatorWeight += dfAccumulatorWeightLocal * dfWeight1;
+    }
+
+    padfAcc[0] = dfAccumulatorReal;
+    padfAcc[1] = dfAccumulatorDensity;
+    padfAcc[2] = dfAccumulatorWeight;
+}
+
+} // end anonymous namespace
+
+/************************************************************************/
+/*                      GWKAccumulateWindowAVX2()                       */
+/************************************************************************/
+
+void GWKAccumulateWindowAVX2( const GByte* pSrc, int nSrcLineStride,
+                              const double* padfDensity,
+                              const double* padfWeightsX, int nXCount,
+                              const double* padfWeightsY, int nYCount,
+                              double* padfAcc )
+{
+    AccumulateWindowAVX2(pSrc, nSrcLineStride, padfDensity,
+                         padfWeightsX, nXCount, padfWeightsY, nYCount,
+                         padfAcc);
+}
+
+void GWKAccumulateWindowAVX2( const GInt16* pSrc, int nSrcLineStride,
+                              const double* padfDensity,
+                              const double* padfWeightsX, int nXCount,
+                              const double* padfWeightsY, int nYCount,
+                              double* padfAcc )
+{
+    AccumulateWindowAVX2(pSrc, nSrcLineStride, padfDensity,
+                         padfWeightsX, nXCount, padfWeightsY, nYCount,
+                         padfAcc);
+}
+
+void GWKAccumulateWindowAVX2( const GUInt16* pSrc, int nSrcLineStride,
+                              const double* padfDensity,
+                              const double* padfWeightsX, int nXCount,
+                              const double* padfWeightsY, int nYCount,
+                              double* padfAcc )
+{
+    AccumulateWindowAVX2(pSrc, nSrcLineStride, padfDensity,
+                         padfWeightsX, nXCount, padfWeightsY, nYCount,
+                         padfAcc);
+}
+
+void GWKAccumulateWindowAVX2( const float* pSrc, int nSrcLineStride,
+                              const double* padfDensity,
+                              const double* padfWeightsX, int nXCount,
+                              const double* padfWeightsY, int nYCount,
+                              double* padfAcc )
+{
+    AccumulateWindowAVX2(pSrc, nSrcLineStride, padfDensity,
+                         padfWeightsX, nXCount, padfWeightsY, nYCount,
+                         padfAcc);
+}
+
+void GWKAccumulateWindowAVX2( const double* pSrc, int nSrcLineStride,
+                              const double* padfDensity,
+                              const double* padfWeightsX, int nXCount,
+                              const double* padfWeightsY, int nYCount,
+                              double* padfAcc )
+{
+    AccumulateWindowAVX2(pSrc, nSrcLineStride, padfDensity,
+                         padfWeightsX, nXCount, padfWeightsY, nYCount,
+                         padfAcc);
+}
+
+#endif // HAVE_AVX2_AT_COMPILE_TIME
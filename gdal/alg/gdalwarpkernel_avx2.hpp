@@ -0,0 +1,76 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  High Performance Image Reprojector
+ * Purpose:  AVX2 kernels of the warping resamplers
+ *
+ ******************************************************************************
+ * Copyright (c) 2016, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef GDALWARPKERNEL_AVX2_HPP_INCLUDED
+#define GDALWARPKERNEL_AVX2_HPP_INCLUDED
+
+#include "cpl_port.h"
+
+/*
+ * Kernels of GWKResampleTapsT(), implemented in gdalwarpkernel_avx2.cpp,
+ * that must only be called when CPLHaveRuntimeAVX2() is true.
+ */
+
+#ifdef HAVE_AVX2_AT_COMPILE_TIME
+
+/* Same as GWKAccumulateWindowT(): weighted sums over the nXCount x nYCount */
+/* source pixels of the filter window, skipping the pixels whose density */
+/* is below 1e-9 if padfDensity is not NULL. The rows of padfDensity are */
+/* padded to a multiple of 4 values. padfAcc[0] receives the */
+/* sum of the values, padfAcc[1] the one of the densities and padfAcc[2] */
+/* the one of the weights. The sums are done in the same order as in the */
+/* scalar code, so the results are identical. */
+void GWKAccumulateWindowAVX2( const GByte* pSrc, int nSrcLineStride,
+                              const double* padfDensity,
+                              const double* padfWeightsX, int nXCount,
+                              const double* padfWeightsY, int nYCount,
+                              double* padfAcc );
+void GWKAccumulateWindowAVX2( const GInt16* pSrc, int nSrcLineStride,
+                              const double* padfDensity,
+                              const double* padfWeightsX, int nXCount,
+                              const double* padfWeightsY, int nYCount,
+                              double* padfAcc );
+void GWKAccumulateWindowAVX2( const GUInt16* pSrc, int nSrcLineStride,
+                              const double* padfDensity,
+                              const double* padfWeightsX, int nXCount,
+                              const double* padfWeightsY, int nYCount,
+                              double* padfAcc );
+void GWKAccumulateWindowAVX2( const float* pSrc, int nSrcLineStride,
+                              const double* padfDensity,
+                              const double* padfWeightsX, int nXCount,
+                              const double* padfWeightsY, int nYCount,
+                              double* padfAcc );
+void GWKAccumulateWindowAVX2( const double* pSrc, int nSrcLineStride,
+                              const double* padfDensity,
+                              const double* padfWeightsX, int nXCount,
+                              const double* padfWeightsY, int nYCount,
+                              double* padfAcc );
+
+#endif // HAVE_AVX2_AT_COMPILE_TIME
+
+#endif // GDALWARPKERNEL_AVX2_HPP_INCLUDED
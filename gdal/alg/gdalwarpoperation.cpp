@@ -29,12 +29,26 @@
  ****************************************************************************/
 
 #include "gdalwarper.h"
+#include "gdal_alg_priv.h"
 #include "cpl_string.h"
 #include "cpl_multiproc.h"
 #include "ogr_api.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#include <time.h>
+#endif
+
 CPL_CVSID("$Id$");
 
+static double GDALWarpGetTime();
+
 struct _GDALWarpChunk {
     int dx, dy, dsx, dsy;
     int sx, sy, ssx, ssy;
@@ -124,15 +138,25 @@ GDALWarpOperation::GDALWarpOperation()
     psOptions = NULL;
 
     hIOMutex = NULL;
-    hWarpMutex = NULL;
 
     nChunkListCount = 0;
     nChunkListMax = 0;
     pasChunkList = NULL;
+    dfChunkMemoryLimit = 0.0;
 
     bReportTimings = FALSE;
-    nLastTimeReported = 0;
+    dfLastTimeReported = 0.0;
     psThreadData = NULL;
+
+    bReuseSrcBuffer = FALSE;
+    pabyLastSrcBuffer = NULL;
+    bLastSrcBufferOwned = FALSE;
+    nLastSrcXOff = 0;
+    nLastSrcYOff = 0;
+    nLastSrcXSize = 0;
+    nLastSrcYSize = 0;
+    nSrcPixelsRead = 0;
+    nSrcPixelsReused = 0;
 }
 
 /************************************************************************/
@@ -145,12 +169,10 @@ GDALWarpOperation::~GDALWarpOperation()
     WipeOptions();
 
     if( hIOMutex != NULL )
-    {
         CPLDestroyMutex( hIOMutex );
-        CPLDestroyMutex( hWarpMutex );
-    }
 
     WipeChunkList();
+    EndSrcBufferReuse();
     if( psThreadData )
         GWKThreadsEnd(psThreadData);
 }
@@ -627,7 +649,7 @@ void GDALDestroyWarpOperation( GDALWarpOperationH hOperation )
 }
 
 /************************************************************************/
-/*                         ChunkAndWarpImage()                          */
+/*                           SortChunkList()                            */
 /************************************************************************/
 
 static int OrderWarpChunk(const void* _a, const void *_b)
@@ -646,6 +668,78 @@ static int OrderWarpChunk(const void* _a, const void *_b)
         return 0;
 }
 
+/* Distance along the Hilbert curve that covers a square of 2^nBits pixels */
+/* of side, of the pixel (nX, nY). */
+static GUIntBig GDALWarpHilbertIndex( int nBits, GUInt32 nX, GUInt32 nY )
+{
+    const GUInt32 nSide = static_cast<GUInt32>(1) << nBits;
+    GUIntBig nIndex = 0;
+    for( GUInt32 s = nSide / 2; s > 0; s /= 2 )
+    {
+        const GUInt32 rx = (nX & s) ? 1 : 0;
+        const GUInt32 ry = (nY & s) ? 1 : 0;
+        nIndex += static_cast<GUIntBig>(s) * s * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant so that the curve is continuous
+        if( ry == 0 )
+        {
+            if( rx == 1 )
+            {
+                nX = nSide - 1 - nX;
+                nY = nSide - 1 - nY;
+            }
+            std::swap(nX, nY);
+        }
+    }
+    return nIndex;
+}
+
+/* Sort the chunks from top to bottom, and for equal y, from left to right, */
+/* or along a Hilbert curve if CHUNK_ORDER=HILBERT, so that consecutive */
+/* chunks are neighbours in both directions. */
+void GDALWarpOperation::SortChunkList( int nDstXOff, int nDstYOff,
+                                       int nDstXSize, int nDstYSize )
+{
+    if( pasChunkList == NULL )
+        return;
+
+    if( !EQUAL(CSLFetchNameValueDef(psOptions->papszWarpOptions,
+                                    "CHUNK_ORDER", "ROW"), "HILBERT") ||
+        CSLFetchBoolean( psOptions->papszWarpOptions, "STREAMABLE_OUTPUT",
+                         FALSE ) )
+    {
+        qsort(pasChunkList, nChunkListCount, sizeof(GDALWarpChunk),
+              OrderWarpChunk);
+        return;
+    }
+
+    int nBits = 1;
+    while( nBits < 31 && (1 << nBits) < MAX(nDstXSize, nDstYSize) )
+        nBits++;
+
+    std::vector< std::pair<GUIntBig, int> > aoOrder;
+    for( int iChunk = 0; iChunk < nChunkListCount; iChunk++ )
+    {
+        const GDALWarpChunk* psChunk = pasChunkList + iChunk;
+        aoOrder.push_back( std::pair<GUIntBig, int>(
+            GDALWarpHilbertIndex(
+                nBits,
+                static_cast<GUInt32>(psChunk->dx - nDstXOff + psChunk->dsx / 2),
+                static_cast<GUInt32>(psChunk->dy - nDstYOff + psChunk->dsy / 2)),
+            iChunk) );
+    }
+    std::sort(aoOrder.begin(), aoOrder.end());
+
+    std::vector<GDALWarpChunk> asSorted;
+    for( int iChunk = 0; iChunk < nChunkListCount; iChunk++ )
+        asSorted.push_back(pasChunkList[aoOrder[iChunk].second]);
+    memcpy(pasChunkList, &asSorted[0], sizeof(GDALWarpChunk) * nChunkListCount);
+}
+
+/************************************************************************/
+/*                         ChunkAndWarpImage()                          */
+/************************************************************************/
+
 /**
  * \fn CPLErr GDALWarpOperation::ChunkAndWarpImage(
                 int nDstXOff, int nDstYOff,  int nDstXSize, int nDstYSize );
@@ -676,12 +770,12 @@ CPLErr GDALWarpOperation::ChunkAndWarpImage(
 /* -------------------------------------------------------------------- */
 /*      Collect the list of chunks to operate on.                       */
 /* -------------------------------------------------------------------- */
+    const double dfStartTime = GDALWarpGetTime();
     WipeChunkList();
+    dfChunkMemoryLimit = psOptions->dfWarpMemoryLimit;
+    StartSrcBufferReuse();
     CollectChunkList( nDstXOff, nDstYOff, nDstXSize, nDstYSize );
-
-    /* Sort chucks from top to bottom, and for equal y, from left to right */
-    if( pasChunkList )
-        qsort(pasChunkList, nChunkListCount, sizeof(GDALWarpChunk), OrderWarpChunk);
+    SortChunkList( nDstXOff, nDstYOff, nDstXSize, nDstYSize );
 
 /* -------------------------------------------------------------------- */
 /*      Total up output pixels to process.                              */
@@ -720,11 +814,16 @@ CPLErr GDALWarpOperation::ChunkAndWarpImage(
                            dfProgressBase, dfProgressScale);
 
         if( eErr != CE_None )
+        {
+            EndSrcBufferReuse();
             return eErr;
+        }
 
         dfPixelsProcessed += dfChunkPixels;
     }
 
+    EndSrcBufferReuse();
+    ReportTotalTiming( dfStartTime, nChunkListCount );
     WipeChunkList();
 
     psOptions->pfnProgress( 1.00001, "", psOptions->pProgressArg );
@@ -750,65 +849,225 @@ CPLErr GDALChunkAndWarpImage( GDALWarpOperationH hOperation,
 }
 
 /************************************************************************/
-/*                          ChunkThreadMain()                           */
+/*                         GDALWarpChunkJob                             */
 /************************************************************************/
 
+/* State shared by the chunks processed by ChunkAndWarpMulti().  The */
+/* source and destination of each chunk are read, and the destination */
+/* written back, in the order of the chunk list, with the IO mutex held, */
+/* while up to nKernelSlots chunks are warped in parallel. */
 typedef struct
+{
+    CPLMutex          *hIOMutex;
+
+    CPLMutex          *hMutex;
+    CPLCond           *hCond;
+    volatile int       nNextChunkToRead;
+    volatile int       nNextChunkToWrite;
+    volatile int       bStop;
+
+    // Kernel slots.  Each slot has its own transformer when there are
+    // several, so that they can be used at the same time.
+    int                nKernelSlots;
+    volatile int      *pabKernelSlotBusy;
+    void             **papTransformerArg;
+
+    // Progress of the kernels, summed over all the chunks.
+    GDALProgressFunc   pfnProgress;
+    void              *pProgressArg;
+    double             dfProgress;
+} GDALWarpChunkPipeline;
+
+struct _GDALWarpChunkJob
 {
     GDALWarpOperation *poOperation;
+    GDALWarpChunkPipeline *psPipeline;
     GDALWarpChunk     *pasChunkInfo;
+    int                iChunk;
     CPLJoinableThread *hThreadHandle;
     CPLErr             eErr;
     double             dfProgressBase;
     double             dfProgressScale;
-    CPLMutex          *hIOMutex;
+    double             dfProgressDone;
+    int                iKernelSlot;
+};
 
-    CPLMutex          *hCondMutex;
-    volatile int       bIOMutexTaken;
-    CPLCond           *hCond;
-} ChunkThreadData;
+/************************************************************************/
+/*                       GDALWarpChunkWaitTurn()                        */
+/************************************************************************/
+
+/* Wait until *pnNextChunk reaches iChunk.  Must be called with the */
+/* pipeline mutex held.  Returns FALSE if the pipeline was stopped. */
+static int GDALWarpChunkWaitTurn( GDALWarpChunkPipeline *psPipeline,
+                                  volatile int *pnNextChunk, int iChunk )
+{
+    while( !psPipeline->bStop && *pnNextChunk != iChunk )
+        CPLCondWait( psPipeline->hCond, psPipeline->hMutex );
+    return !psPipeline->bStop;
+}
+
+/************************************************************************/
+/*                        GDALWarpChunkEndRead()                        */
+/************************************************************************/
+
+/* Called with the IO mutex held once the chunk has been read: release */
+/* it for the next chunk, and wait for a free kernel slot. */
+static CPLErr GDALWarpChunkEndRead( GDALWarpChunkJob *psJob )
+{
+    GDALWarpChunkPipeline *psPipeline = psJob->psPipeline;
+
+    CPLReleaseMutex( psPipeline->hIOMutex );
+
+    CPLAcquireMutex( psPipeline->hMutex, 1000.0 );
+    psPipeline->nNextChunkToRead = psJob->iChunk + 1;
+    CPLCondBroadcast( psPipeline->hCond );
+
+    psJob->iKernelSlot = -1;
+    while( !psPipeline->bStop )
+    {
+        for( int i = 0; i < psPipeline->nKernelSlots; i++ )
+        {
+            if( !psPipeline->pabKernelSlotBusy[i] )
+            {
+                psPipeline->pabKernelSlotBusy[i] = TRUE;
+                psJob->iKernelSlot = i;
+                break;
+            }
+        }
+        if( psJob->iKernelSlot >= 0 )
+            break;
+        CPLCondWait( psPipeline->hCond, psPipeline->hMutex );
+    }
+    CPLReleaseMutex( psPipeline->hMutex );
+
+    return psJob->iKernelSlot >= 0 ? CE_None : CE_Failure;
+}
 
+/************************************************************************/
+/*                      GDALWarpChunkStartWrite()                       */
+/************************************************************************/
+
+/* Called once the chunk has been warped: release its kernel slot, wait */
+/* for the previous chunks to be written, and take the IO mutex.  The IO */
+/* mutex is taken even if the pipeline was stopped, so that the cleanup */
+/* is done with it held as in the normal case. */
+static CPLErr GDALWarpChunkStartWrite( GDALWarpChunkJob *psJob )
+{
+    GDALWarpChunkPipeline *psPipeline = psJob->psPipeline;
 
-static void ChunkThreadMain( void *pThreadData )
+    CPLAcquireMutex( psPipeline->hMutex, 1000.0 );
+    if( psJob->iKernelSlot >= 0 )
+    {
+        psPipeline->pabKernelSlotBusy[psJob->iKernelSlot] = FALSE;
+        psJob->iKernelSlot = -1;
+        CPLCondBroadcast( psPipeline->hCond );
+    }
+    const int bTurn = GDALWarpChunkWaitTurn( psPipeline,
+                                             &psPipeline->nNextChunkToWrite,
+                                             psJob->iChunk );
+    CPLReleaseMutex( psPipeline->hMutex );
+
+    if( !CPLAcquireMutex( psPipeline->hIOMutex, 600.0 ) )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Failed to acquire IOMutex in WarpRegion()." );
+        return CE_Failure;
+    }
+
+    return bTurn ? CE_None : CE_Failure;
+}
+
+/************************************************************************/
+/*                       GDALWarpChunkProgress()                        */
+/************************************************************************/
 
+/* Progress function of the kernels run by ChunkAndWarpMulti(), that */
+/* reports the sum of the progress of all the chunks, since several of */
+/* them may be warped at the same time. */
+static int CPL_STDCALL GDALWarpChunkProgress( double dfComplete,
+                                              const char *pszMessage,
+                                              void *pProgressArg )
 {
-    volatile ChunkThreadData* psData = (volatile ChunkThreadData*) pThreadData;
+    GDALWarpChunkJob *psJob = static_cast<GDALWarpChunkJob *>(pProgressArg);
+    GDALWarpChunkPipeline *psPipeline = psJob->psPipeline;
 
-    GDALWarpChunk *pasChunkInfo = psData->pasChunkInfo;
+    const double dfDone = std::max(0.0, std::min(psJob->dfProgressScale,
+                                   dfComplete - psJob->dfProgressBase));
+
+    CPLAcquireMutex( psPipeline->hMutex, 1000.0 );
+    if( dfDone > psJob->dfProgressDone )
+    {
+        psPipeline->dfProgress += dfDone - psJob->dfProgressDone;
+        psJob->dfProgressDone = dfDone;
+    }
+    const int bRet = psPipeline->pfnProgress( psPipeline->dfProgress,
+                                              pszMessage,
+                                              psPipeline->pProgressArg );
+    CPLReleaseMutex( psPipeline->hMutex );
+
+    return bRet;
+}
+
+/************************************************************************/
+/*                          ChunkThreadMain()                           */
+/************************************************************************/
+
+void GDALWarpOperation::ChunkThreadMain( void *pThreadData )
+
+{
+    GDALWarpChunkJob *psJob = static_cast<GDALWarpChunkJob *>(pThreadData);
+    GDALWarpChunkPipeline *psPipeline = psJob->psPipeline;
+    GDALWarpChunk *pasChunkInfo = psJob->pasChunkInfo;
 
 /* -------------------------------------------------------------------- */
-/*      Acquire IO mutex.                                               */
+/*      Wait for the previous chunks to be read, and acquire IO mutex.  */
 /* -------------------------------------------------------------------- */
-    if( !CPLAcquireMutex( psData->hIOMutex, 600.0 ) )
+    CPLAcquireMutex( psPipeline->hMutex, 1000.0 );
+    const int bTurn = GDALWarpChunkWaitTurn( psPipeline,
+                                             &psPipeline->nNextChunkToRead,
+                                             psJob->iChunk );
+    CPLReleaseMutex( psPipeline->hMutex );
+
+    if( !bTurn )
+    {
+        psJob->eErr = CE_Failure;
+        return;
+    }
+
+    if( !CPLAcquireMutex( psPipeline->hIOMutex, 600.0 ) )
     {
         CPLError( CE_Failure, CPLE_AppDefined,
                     "Failed to acquire IOMutex in WarpRegion()." );
-        psData->eErr = CE_Failure;
+        psJob->eErr = CE_Failure;
     }
     else
     {
-        if (psData->hCond != NULL)
-        {
-            CPLAcquireMutex( psData->hCondMutex, 1.0 );
-            psData->bIOMutexTaken = TRUE;
-            CPLCondSignal(psData->hCond);
-            CPLReleaseMutex( psData->hCondMutex );
-        }
-
-        psData->eErr = psData->poOperation->WarpRegion(
+        psJob->eErr = psJob->poOperation->WarpRegionInternal(
                                     pasChunkInfo->dx, pasChunkInfo->dy,
                                     pasChunkInfo->dsx, pasChunkInfo->dsy,
                                     pasChunkInfo->sx, pasChunkInfo->sy,
                                     pasChunkInfo->ssx, pasChunkInfo->ssy,
                                     pasChunkInfo->sExtraSx, pasChunkInfo->sExtraSy,
-                                    psData->dfProgressBase,
-                                    psData->dfProgressScale);
+                                    psJob->dfProgressBase,
+                                    psJob->dfProgressScale,
+                                    psJob );
 
     /* -------------------------------------------------------------------- */
     /*      Release the IO mutex.                                           */
     /* -------------------------------------------------------------------- */
-        CPLReleaseMutex( psData->hIOMutex );
+        CPLReleaseMutex( psPipeline->hIOMutex );
     }
+
+/* -------------------------------------------------------------------- */
+/*      Let the next chunk be written, or stop the pipeline on error.   */
+/* -------------------------------------------------------------------- */
+    CPLAcquireMutex( psPipeline->hMutex, 1000.0 );
+    if( psJob->eErr != CE_None )
+        psPipeline->bStop = TRUE;
+    else
+        psPipeline->nNextChunkToWrite = psJob->iChunk + 1;
+    CPLCondBroadcast( psPipeline->hCond );
+    CPLReleaseMutex( psPipeline->hMutex );
 }
 
 /************************************************************************/
@@ -827,6 +1086,12 @@ static void ChunkThreadMain( void *pThreadData )
  * internally this method uses multiple threads to interleave input/output
  * for one region while the processing is being done for another.
  *
+ * The number of chunks in flight is set by the CHUNK_PIPELINE_DEPTH warp
+ * option (GDAL >= 2.2), and defaults to 3 (2 on a single CPU machine).
+ * One of them can be read or written while the others are warped in
+ * parallel.  The chunks are sized so that all of them fit together in
+ * GDALWarpOptions::dfWarpMemoryLimit.
+ *
  * @param nDstXOff X offset to window of destination data to be produced.
  * @param nDstYOff Y offset to window of destination data to be produced.
  * @param nDstXSize Width of output window on destination file to be produced.
@@ -839,127 +1104,191 @@ CPLErr GDALWarpOperation::ChunkAndWarpMulti(
     int nDstXOff, int nDstYOff,  int nDstXSize, int nDstYSize )
 
 {
-    hIOMutex = CPLCreateMutex();
-    hWarpMutex = CPLCreateMutex();
-
-    CPLReleaseMutex( hIOMutex );
-    CPLReleaseMutex( hWarpMutex );
+    const double dfStartTime = GDALWarpGetTime();
+    if( hIOMutex == NULL )
+    {
+        hIOMutex = CPLCreateMutex();
+        CPLReleaseMutex( hIOMutex );
+    }
 
-    CPLCond* hCond = CPLCreateCond();
-    CPLMutex* hCondMutex = CPLCreateMutex();
-    CPLReleaseMutex(hCondMutex);
+/* -------------------------------------------------------------------- */
+/*      How many chunks can be in flight?  By default, two chunks are   */
+/*      warped while another one is read or written.  The chunks are    */
+/*      sized so that all of them fit in the warp memory limit.         */
+/* -------------------------------------------------------------------- */
+    int nDepth = MIN(3, CPLGetNumCPUs() + 1);
+    const char *pszDepth =
+        CSLFetchNameValue( psOptions->papszWarpOptions, "CHUNK_PIPELINE_DEPTH" );
+    if( pszDepth != NULL )
+    {
+        if( EQUAL(pszDepth, "ALL_CPUS") )
+            nDepth = CPLGetNumCPUs() + 1;
+        else
+            nDepth = atoi(pszDepth);
+        nDepth = MAX(2, MIN(128, nDepth));
+    }
+    dfChunkMemoryLimit = psOptions->dfWarpMemoryLimit / nDepth;
 
 /* -------------------------------------------------------------------- */
 /*      Collect the list of chunks to operate on.                       */
 /* -------------------------------------------------------------------- */
     WipeChunkList();
+    StartSrcBufferReuse();
     CollectChunkList( nDstXOff, nDstYOff, nDstXSize, nDstYSize );
+    SortChunkList( nDstXOff, nDstYOff, nDstXSize, nDstYSize );
+    nDepth = MAX(1, MIN(nDepth, nChunkListCount));
+
+/* -------------------------------------------------------------------- */
+/*      Setup the pipeline.  With a single kernel slot, the kernel      */
+/*      uses the transformer of the operation and its NUM_THREADS       */
+/*      worker threads.  Otherwise each slot warps one chunk with a     */
+/*      clone of the transformer.  The chunk processors are not         */
+/*      expected to be reentrant.                                       */
+/* -------------------------------------------------------------------- */
+    GDALWarpChunkPipeline sPipeline;
+    sPipeline.hIOMutex = hIOMutex;
+    sPipeline.hMutex = CPLCreateMutex();
+    CPLReleaseMutex( sPipeline.hMutex );
+    sPipeline.hCond = CPLCreateCond();
+    sPipeline.nNextChunkToRead = 0;
+    sPipeline.nNextChunkToWrite = 0;
+    sPipeline.bStop = FALSE;
+    sPipeline.pfnProgress = psOptions->pfnProgress;
+    sPipeline.pProgressArg = psOptions->pProgressArg;
+    sPipeline.dfProgress = 0.0;
+
+    sPipeline.nKernelSlots = MAX(1, nDepth - 1);
+    if( psOptions->pfnPreWarpChunkProcessor != NULL ||
+        psOptions->pfnPostWarpChunkProcessor != NULL )
+        sPipeline.nKernelSlots = 1;
+    sPipeline.papTransformerArg = static_cast<void **>(
+        CPLCalloc(sizeof(void*), sPipeline.nKernelSlots));
+    if( sPipeline.nKernelSlots == 1 )
+        sPipeline.papTransformerArg[0] = psOptions->pTransformerArg;
+    else
+    {
+        for( int i = 0; i < sPipeline.nKernelSlots; i++ )
+        {
+            sPipeline.papTransformerArg[i] =
+                GDALCloneTransformer( psOptions->pTransformerArg );
+            if( sPipeline.papTransformerArg[i] == NULL )
+            {
+                CPLDebug( "WARP", "Cannot clone the transformer: "
+                          "chunks will be warped one at a time." );
+                for( int j = 0; j < i; j++ )
+                    GDALDestroyTransformer( sPipeline.papTransformerArg[j] );
+                sPipeline.nKernelSlots = 1;
+                sPipeline.papTransformerArg[0] = psOptions->pTransformerArg;
+                break;
+            }
+        }
+    }
+    sPipeline.pabKernelSlotBusy = static_cast<volatile int *>(
+        CPLCalloc(sizeof(int), sPipeline.nKernelSlots));
 
-    /* Sort chucks from top to bottom, and for equal y, from left to right */
-    if( pasChunkList )
-        qsort(pasChunkList, nChunkListCount, sizeof(GDALWarpChunk), OrderWarpChunk);
+    CPLDebug( "WARP", "%d chunks of at most %.0f bytes, %d in flight, "
+              "%d warped in parallel",
+              nChunkListCount, dfChunkMemoryLimit, nDepth,
+              sPipeline.nKernelSlots );
 
 /* -------------------------------------------------------------------- */
 /*      Process them one at a time, updating the progress               */
 /*      information for each region.                                    */
 /* -------------------------------------------------------------------- */
-    ChunkThreadData volatile asThreadData[2];
-    memset((void*)&asThreadData, 0, sizeof(asThreadData));
-    asThreadData[0].poOperation = this;
-    asThreadData[0].hIOMutex = hIOMutex;
-    asThreadData[1].poOperation = this;
-    asThreadData[1].hIOMutex = hIOMutex;
+    std::vector<GDALWarpChunkJob> asJobs(nDepth);
+    for( int iThread = 0; iThread < nDepth; iThread++ )
+    {
+        memset( &asJobs[iThread], 0, sizeof(GDALWarpChunkJob) );
+        asJobs[iThread].poOperation = this;
+        asJobs[iThread].psPipeline = &sPipeline;
+    }
 
     int iChunk;
     double dfPixelsProcessed=0.0, dfTotalPixels = nDstXSize*(double)nDstYSize;
 
     CPLErr eErr = CE_None;
-    for( iChunk = 0; iChunk < nChunkListCount+1; iChunk++ )
+    for( iChunk = 0; pasChunkList != NULL && iChunk < nChunkListCount; iChunk++ )
     {
-        int    iThread = iChunk % 2;
+        GDALWarpChunkJob *psJob = &asJobs[iChunk % nDepth];
 
 /* -------------------------------------------------------------------- */
-/*      Launch thread for this chunk.                                   */
+/*      Wait for the chunk that used this slot to complete.             */
 /* -------------------------------------------------------------------- */
-        if( pasChunkList != NULL && iChunk < nChunkListCount )
+        if( psJob->hThreadHandle != NULL )
         {
-            GDALWarpChunk *pasThisChunk = pasChunkList + iChunk;
-            double dfChunkPixels = pasThisChunk->dsx * (double) pasThisChunk->dsy;
+            CPLJoinThread( psJob->hThreadHandle );
+            psJob->hThreadHandle = NULL;
 
-            asThreadData[iThread].dfProgressBase = dfPixelsProcessed / dfTotalPixels;
-            asThreadData[iThread].dfProgressScale = dfChunkPixels / dfTotalPixels;
+            CPLDebug( "GDAL", "Finished chunk %d.", psJob->iChunk );
 
-            dfPixelsProcessed += dfChunkPixels;
-
-            asThreadData[iThread].pasChunkInfo = pasThisChunk;
-
-            if ( iChunk == 0 )
-            {
-                asThreadData[iThread].hCond = hCond;
-                asThreadData[iThread].hCondMutex = hCondMutex;
-            }
-            else
-            {
-                asThreadData[iThread].hCond = NULL;
-                asThreadData[iThread].hCondMutex = NULL;
-            }
-            asThreadData[iThread].bIOMutexTaken = FALSE;
-
-            CPLDebug( "GDAL", "Start chunk %d.", iChunk );
-            asThreadData[iThread].hThreadHandle =
-                CPLCreateJoinableThread( ChunkThreadMain, (void*) &asThreadData[iThread] );
-            if( asThreadData[iThread].hThreadHandle == NULL )
-            {
-                CPLError( CE_Failure, CPLE_AppDefined,
-                          "CPLCreateJoinableThread() failed in ChunkAndWarpMulti()" );
-                eErr = CE_Failure;
+            eErr = psJob->eErr;
+            if( eErr != CE_None )
                 break;
-            }
-
-            /* Wait that the first thread has acquired the IO mutex before proceeding. */
-            /* (This will ensure that the first thread will run before the second one). */
-            if( iChunk == 0 )
-            {
-                CPLAcquireMutex(hCondMutex, 1.0);
-                while (asThreadData[iThread].bIOMutexTaken == FALSE)
-                    CPLCondWait(hCond, hCondMutex);
-                CPLReleaseMutex(hCondMutex);
-            }
         }
 
 /* -------------------------------------------------------------------- */
-/*      Wait for previous chunks thread to complete.                    */
+/*      Launch thread for this chunk.                                   */
 /* -------------------------------------------------------------------- */
-        if( iChunk > 0 )
-        {
-            iThread = (iChunk-1) % 2;
+        GDALWarpChunk *pasThisChunk = pasChunkList + iChunk;
+        double dfChunkPixels = pasThisChunk->dsx * (double) pasThisChunk->dsy;
 
-            /* Wait for thread to finish. */
-            CPLJoinThread(asThreadData[iThread].hThreadHandle);
-            asThreadData[iThread].hThreadHandle = NULL;
+        psJob->dfProgressBase = dfPixelsProcessed / dfTotalPixels;
+        psJob->dfProgressScale = dfChunkPixels / dfTotalPixels;
+        psJob->dfProgressDone = 0.0;
 
-            CPLDebug( "GDAL", "Finished chunk %d.", iChunk-1 );
+        dfPixelsProcessed += dfChunkPixels;
 
-            eErr = asThreadData[iThread].eErr;
+        psJob->pasChunkInfo = pasThisChunk;
+        psJob->iChunk = iChunk;
+        psJob->iKernelSlot = -1;
 
-            if( eErr != CE_None )
-                break;
+        CPLDebug( "GDAL", "Start chunk %d.", iChunk );
+        psJob->hThreadHandle =
+            CPLCreateJoinableThread( ChunkThreadMain, psJob );
+        if( psJob->hThreadHandle == NULL )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "CPLCreateJoinableThread() failed in ChunkAndWarpMulti()" );
+            eErr = CE_Failure;
+            break;
         }
     }
 
     /* -------------------------------------------------------------------- */
-    /*      Wait for all threads to complete.                               */
+    /*      Wait for all threads to complete, in order.                     */
     /* -------------------------------------------------------------------- */
-    int iThread;
-    for(iThread = 0; iThread < 2; iThread ++)
+    if( eErr != CE_None )
     {
-        if (asThreadData[iThread].hThreadHandle)
-            CPLJoinThread(asThreadData[iThread].hThreadHandle);
+        CPLAcquireMutex( sPipeline.hMutex, 1000.0 );
+        sPipeline.bStop = TRUE;
+        CPLCondBroadcast( sPipeline.hCond );
+        CPLReleaseMutex( sPipeline.hMutex );
+    }
+    for( int i = 0; i < nDepth; i++ )
+    {
+        GDALWarpChunkJob *psJob = &asJobs[(iChunk + i) % nDepth];
+        if( psJob->hThreadHandle != NULL )
+        {
+            CPLJoinThread( psJob->hThreadHandle );
+            psJob->hThreadHandle = NULL;
+            if( eErr == CE_None )
+                eErr = psJob->eErr;
+        }
     }
 
-    CPLDestroyCond(hCond);
-    CPLDestroyMutex(hCondMutex);
+    if( sPipeline.nKernelSlots > 1 )
+    {
+        for( int i = 0; i < sPipeline.nKernelSlots; i++ )
+            GDALDestroyTransformer( sPipeline.papTransformerArg[i] );
+    }
+    CPLFree( sPipeline.papTransformerArg );
+    CPLFree( (void *) sPipeline.pabKernelSlotBusy );
+    CPLDestroyCond( sPipeline.hCond );
+    CPLDestroyMutex( sPipeline.hMutex );
 
+    EndSrcBufferReuse();
+    if( eErr == CE_None )
+        ReportTotalTiming( dfStartTime, nChunkListCount );
     WipeChunkList();
 
     return eErr;
@@ -995,6 +1324,40 @@ void GDALWarpOperation::WipeChunkList()
     nChunkListMax = 0;
 }
 
+/************************************************************************/
+/*                        StartSrcBufferReuse()                         */
+/************************************************************************/
+
+/* Let WarpRegionToBuffer() keep the source buffer of the last chunk read */
+/* for the next one, unless disabled with REUSE_SOURCE_BUFFER=NO, or if the */
+/* chunk processors could modify it.  This must be called before */
+/* CollectChunkList(), which counts the kept buffer in the chunk sizes. */
+/* With ChunkAndWarpMulti(), the next chunk may be read while the previous */
+/* one is being warped, which is safe since the buffers are not modified */
+/* after being read, and are read and released with the IO mutex held. */
+void GDALWarpOperation::StartSrcBufferReuse()
+{
+    bReuseSrcBuffer = CSLFetchBoolean( psOptions->papszWarpOptions,
+                                       "REUSE_SOURCE_BUFFER", TRUE ) &&
+                      psOptions->pfnPreWarpChunkProcessor == NULL &&
+                      psOptions->pfnPostWarpChunkProcessor == NULL;
+    nSrcPixelsRead = 0;
+    nSrcPixelsReused = 0;
+}
+
+/************************************************************************/
+/*                         EndSrcBufferReuse()                          */
+/************************************************************************/
+
+void GDALWarpOperation::EndSrcBufferReuse()
+{
+    bReuseSrcBuffer = FALSE;
+    if( bLastSrcBufferOwned )
+        CPLFree( pabyLastSrcBuffer );
+    pabyLastSrcBuffer = NULL;
+    bLastSrcBufferOwned = FALSE;
+}
+
 /************************************************************************/
 /*                          CollectChunkList()                          */
 /************************************************************************/
@@ -1088,9 +1451,16 @@ CPLErr GDALWarpOperation::CollectChunkList(
 /* -------------------------------------------------------------------- */
     double dfTotalMemoryUse;
 
-    dfTotalMemoryUse =
-        (((double) nSrcPixelCostInBits) * nSrcXSize * nSrcYSize
-         + ((double) nDstPixelCostInBits) * nDstXSize * nDstYSize) / 8.0;
+    double dfSrcMemoryUse =
+        ((double) nSrcPixelCostInBits) * nSrcXSize * nSrcYSize / 8.0;
+
+    // The source buffer that ReadSrcBuffer() keeps for the next chunk is
+    // still allocated while that chunk reads its own one, so count it too.
+    if( bReuseSrcBuffer )
+        dfSrcMemoryUse *= 2;
+
+    dfTotalMemoryUse = dfSrcMemoryUse
+        + ((double) nDstPixelCostInBits) * nDstXSize * nDstYSize / 8.0;
 
     int nBlockXSize = 1, nBlockYSize = 1;
     if (psOptions->hDstDS)
@@ -1108,7 +1478,7 @@ CPLErr GDALWarpOperation::CollectChunkList(
     /*CPLDebug("WARP", "dst=(%d,%d,%d,%d) src=(%d,%d,%d,%d) srcfillratio=%.18g",
              nDstXOff, nDstYOff, nDstXSize, nDstYSize,
              nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize, dfSrcFillRatio);*/
-    if( (dfTotalMemoryUse > psOptions->dfWarpMemoryLimit && (nDstXSize > 2 || nDstYSize > 2)) ||
+    if( (dfTotalMemoryUse > dfChunkMemoryLimit && (nDstXSize > 2 || nDstYSize > 2)) ||
         (dfSrcFillRatio > 0 && dfSrcFillRatio < 0.5 && (nDstXSize > 100 || nDstYSize > 100) &&
          CSLFetchBoolean( psOptions->papszWarpOptions, "SRC_FILL_RATIO_HEURISTICS", TRUE )) )
     {
@@ -1260,6 +1630,31 @@ CPLErr GDALWarpOperation::WarpRegion( int nDstXOff, int nDstYOff,
                                       int nSrcXExtraSize, int nSrcYExtraSize,
                                       double dfProgressBase,
                                       double dfProgressScale)
+{
+    return WarpRegionInternal(nDstXOff, nDstYOff,
+                              nDstXSize, nDstYSize,
+                              nSrcXOff, nSrcYOff,
+                              nSrcXSize, nSrcYSize,
+                              nSrcXExtraSize, nSrcYExtraSize,
+                              dfProgressBase, dfProgressScale, NULL);
+}
+
+/************************************************************************/
+/*                         WarpRegionInternal()                         */
+/************************************************************************/
+
+/* Implementation of WarpRegion().  psJob is set when called by */
+/* ChunkAndWarpMulti(), with the IO mutex held, and then the IO mutex is */
+/* released while the chunk is warped, and held again on return. */
+CPLErr GDALWarpOperation::WarpRegionInternal( int nDstXOff, int nDstYOff,
+                                              int nDstXSize, int nDstYSize,
+                                              int nSrcXOff, int nSrcYOff,
+                                              int nSrcXSize, int nSrcYSize,
+                                              int nSrcXExtraSize,
+                                              int nSrcYExtraSize,
+                                              double dfProgressBase,
+                                              double dfProgressScale,
+                                              GDALWarpChunkJob *psJob )
 
 {
     CPLErr eErr;
@@ -1379,11 +1774,12 @@ CPLErr GDALWarpOperation::WarpRegion( int nDstXOff, int nDstYOff,
 /* -------------------------------------------------------------------- */
 /*      Perform the warp.                                               */
 /* -------------------------------------------------------------------- */
-    eErr = WarpRegionToBuffer( nDstXOff, nDstYOff, nDstXSize, nDstYSize,
-                               pDstBuffer, psOptions->eWorkingDataType,
-                               nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize,
-                               nSrcXExtraSize, nSrcYExtraSize,
-                               dfProgressBase, dfProgressScale);
+    eErr = WarpRegionToBufferInternal( nDstXOff, nDstYOff,
+                                       nDstXSize, nDstYSize, pDstBuffer,
+                                       nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize,
+                                       nSrcXExtraSize, nSrcYExtraSize,
+                                       dfProgressBase, dfProgressScale,
+                                       psJob );
 
 /* -------------------------------------------------------------------- */
 /*      Write the output data back to disk if all went well.            */
@@ -1441,6 +1837,134 @@ CPLErr GDALWarpRegion( GDALWarpOperationH hOperation,
                     nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize);
 }
 
+/************************************************************************/
+/*                           ReadSrcBuffer()                            */
+/************************************************************************/
+
+/* Fill the source buffer of WarpRegionToBuffer(), whose bands are spaced */
+/* by nSrcXSize * nSrcYSize + WARP_EXTRA_ELTS words.  When the window */
+/* intersects the one of the source buffer kept from the previous chunk, */
+/* the common pixels are copied from it, and only the up to 4 rectangles */
+/* around them are read from the source dataset.  The buffer then replaces */
+/* the kept one. */
+CPLErr GDALWarpOperation::ReadSrcBuffer( GByte *pabySrcBuffer,
+                                         int nSrcXOff, int nSrcYOff,
+                                         int nSrcXSize, int nSrcYSize )
+{
+    const int nWordSize = GDALGetDataTypeSizeBytes(psOptions->eWorkingDataType);
+    const GSpacing nBandSpace =
+        static_cast<GSpacing>(nWordSize) * (nSrcXSize * nSrcYSize + WARP_EXTRA_ELTS);
+
+    const int nInterXOff = MAX(nSrcXOff, nLastSrcXOff);
+    const int nInterYOff = MAX(nSrcYOff, nLastSrcYOff);
+    const int nInterXEnd = MIN(nSrcXOff + nSrcXSize,
+                               nLastSrcXOff + nLastSrcXSize);
+    const int nInterYEnd = MIN(nSrcYOff + nSrcYSize,
+                               nLastSrcYOff + nLastSrcYSize);
+    if( pabyLastSrcBuffer == NULL ||
+        nInterXOff >= nInterXEnd || nInterYOff >= nInterYEnd )
+    {
+        nSrcPixelsRead += static_cast<GIntBig>(nSrcXSize) * nSrcYSize;
+        CPLErr eErr = GDALDatasetRasterIO( psOptions->hSrcDS, GF_Read,
+                                           nSrcXOff, nSrcYOff,
+                                           nSrcXSize, nSrcYSize,
+                                           pabySrcBuffer, nSrcXSize, nSrcYSize,
+                                           psOptions->eWorkingDataType,
+                                           psOptions->nBandCount,
+                                           psOptions->panSrcBands,
+                                           0, 0, nBandSpace );
+        if( eErr == CE_None && bReuseSrcBuffer )
+            KeepSrcBuffer( pabySrcBuffer, nSrcXOff, nSrcYOff,
+                           nSrcXSize, nSrcYSize );
+        return eErr;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Copy the pixels in common with the previous chunk.              */
+/* -------------------------------------------------------------------- */
+    const GSpacing nLastBandSpace = static_cast<GSpacing>(nWordSize) *
+        (nLastSrcXSize * nLastSrcYSize + WARP_EXTRA_ELTS);
+    const size_t nLineBytes =
+        static_cast<size_t>(nWordSize) * (nInterXEnd - nInterXOff);
+    for( int iBand = 0; iBand < psOptions->nBandCount; iBand++ )
+    {
+        for( int iY = nInterYOff; iY < nInterYEnd; iY++ )
+        {
+            memcpy( pabySrcBuffer + iBand * nBandSpace +
+                        static_cast<GPtrDiff_t>(nWordSize) *
+                        ((iY - nSrcYOff) * static_cast<GPtrDiff_t>(nSrcXSize) +
+                         (nInterXOff - nSrcXOff)),
+                    pabyLastSrcBuffer + iBand * nLastBandSpace +
+                        static_cast<GPtrDiff_t>(nWordSize) *
+                        ((iY - nLastSrcYOff) *
+                            static_cast<GPtrDiff_t>(nLastSrcXSize) +
+                         (nInterXOff - nLastSrcXOff)),
+                    nLineBytes );
+        }
+    }
+    nSrcPixelsReused += static_cast<GIntBig>(nInterXEnd - nInterXOff) *
+                        (nInterYEnd - nInterYOff);
+
+/* -------------------------------------------------------------------- */
+/*      Read the rectangles above, below, on the left and on the        */
+/*      right of the common pixels.                                     */
+/* -------------------------------------------------------------------- */
+    const int anRectXOff[4] = { nSrcXOff, nSrcXOff, nSrcXOff, nInterXEnd };
+    const int anRectYOff[4] = { nSrcYOff, nInterYEnd, nInterYOff, nInterYOff };
+    const int anRectXSize[4] = { nSrcXSize, nSrcXSize,
+                                 nInterXOff - nSrcXOff,
+                                 nSrcXOff + nSrcXSize - nInterXEnd };
+    const int anRectYSize[4] = { nInterYOff - nSrcYOff,
+                                 nSrcYOff + nSrcYSize - nInterYEnd,
+                                 nInterYEnd - nInterYOff,
+                                 nInterYEnd - nInterYOff };
+    for( int iRect = 0; iRect < 4; iRect++ )
+    {
+        if( anRectXSize[iRect] <= 0 || anRectYSize[iRect] <= 0 )
+            continue;
+        nSrcPixelsRead +=
+            static_cast<GIntBig>(anRectXSize[iRect]) * anRectYSize[iRect];
+        CPLErr eErr = GDALDatasetRasterIO(
+            psOptions->hSrcDS, GF_Read,
+            anRectXOff[iRect], anRectYOff[iRect],
+            anRectXSize[iRect], anRectYSize[iRect],
+            pabySrcBuffer + static_cast<GPtrDiff_t>(nWordSize) *
+                ((anRectYOff[iRect] - nSrcYOff) *
+                    static_cast<GPtrDiff_t>(nSrcXSize) +
+                 (anRectXOff[iRect] - nSrcXOff)),
+            anRectXSize[iRect], anRectYSize[iRect],
+            psOptions->eWorkingDataType,
+            psOptions->nBandCount, psOptions->panSrcBands,
+            nWordSize, static_cast<GSpacing>(nWordSize) * nSrcXSize,
+            nBandSpace );
+        if( eErr != CE_None )
+            return eErr;
+    }
+
+    KeepSrcBuffer( pabySrcBuffer, nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize );
+    return CE_None;
+}
+
+/************************************************************************/
+/*                           KeepSrcBuffer()                            */
+/************************************************************************/
+
+/* Make a source buffer just read the one reused by the next chunk.  It */
+/* remains owned by its chunk, that hands it over when it is warped. */
+void GDALWarpOperation::KeepSrcBuffer( GByte *pabySrcBuffer,
+                                       int nSrcXOff, int nSrcYOff,
+                                       int nSrcXSize, int nSrcYSize )
+{
+    if( bLastSrcBufferOwned )
+        CPLFree( pabyLastSrcBuffer );
+    pabyLastSrcBuffer = pabySrcBuffer;
+    bLastSrcBufferOwned = FALSE;
+    nLastSrcXOff = nSrcXOff;
+    nLastSrcYOff = nSrcYOff;
+    nLastSrcXSize = nSrcXSize;
+    nLastSrcYSize = nSrcYSize;
+}
+
 /************************************************************************/
 /*                            WarpRegionToBuffer()                      */
 /************************************************************************/
@@ -1501,15 +2025,36 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
     int nSrcXOff, int nSrcYOff, int nSrcXSize, int nSrcYSize,
     int nSrcXExtraSize, int nSrcYExtraSize,
     double dfProgressBase, double dfProgressScale)
+{
+    (void) eBufDataType;
+    CPLAssert( eBufDataType == psOptions->eWorkingDataType );
+
+    return WarpRegionToBufferInternal(nDstXOff, nDstYOff, nDstXSize, nDstYSize,
+                                      pDataBuf,
+                                      nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize,
+                                      nSrcXExtraSize, nSrcYExtraSize,
+                                      dfProgressBase, dfProgressScale, NULL);
+}
+
+/************************************************************************/
+/*                     WarpRegionToBufferInternal()                     */
+/************************************************************************/
+
+/* Implementation of WarpRegionToBuffer().  See WarpRegionInternal() for */
+/* psJob. */
+CPLErr GDALWarpOperation::WarpRegionToBufferInternal(
+    int nDstXOff, int nDstYOff, int nDstXSize, int nDstYSize,
+    void *pDataBuf,
+    int nSrcXOff, int nSrcYOff, int nSrcXSize, int nSrcYSize,
+    int nSrcXExtraSize, int nSrcYExtraSize,
+    double dfProgressBase, double dfProgressScale,
+    GDALWarpChunkJob *psJob )
 
 {
     CPLErr eErr = CE_None;
     int    i;
     const int nWordSize = GDALGetDataTypeSizeBytes(psOptions->eWorkingDataType);
 
-    (void) eBufDataType;
-    CPLAssert( eBufDataType == psOptions->eWorkingDataType );
-
 /* -------------------------------------------------------------------- */
 /*      If not given a corresponding source window compute one now.     */
 /* -------------------------------------------------------------------- */
@@ -1583,13 +2128,8 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
             + nWordSize * (nSrcXSize * nSrcYSize + WARP_EXTRA_ELTS) * i;
 
     if( eErr == CE_None && nSrcXSize > 0 && nSrcYSize > 0 )
-        eErr =
-            GDALDatasetRasterIO( psOptions->hSrcDS, GF_Read,
-                                 nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize,
-                                 oWK.papabySrcImage[0], nSrcXSize, nSrcYSize,
-                                 psOptions->eWorkingDataType,
-                                 psOptions->nBandCount, psOptions->panSrcBands,
-                                 0, 0, nWordSize * (nSrcXSize * nSrcYSize + WARP_EXTRA_ELTS) );
+        eErr = ReadSrcBuffer( oWK.papabySrcImage[0],
+                              nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize );
 
     ReportTiming( "Input buffer read" );
 
@@ -1868,16 +2408,26 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
     }
 
 /* -------------------------------------------------------------------- */
-/*      Release IO Mutex, and acquire warper mutex.                     */
+/*      Release IO Mutex, and wait for a kernel slot, that provides     */
+/*      the transformer to use.                                         */
 /* -------------------------------------------------------------------- */
-    if( hIOMutex != NULL )
+    if( psJob != NULL )
     {
-        CPLReleaseMutex( hIOMutex );
-        if( !CPLAcquireMutex( hWarpMutex, 600.0 ) )
+        const CPLErr eErr2 = GDALWarpChunkEndRead( psJob );
+        if( eErr == CE_None )
+            eErr = eErr2;
+
+        GDALWarpChunkPipeline *psPipeline = psJob->psPipeline;
+        if( psJob->iKernelSlot >= 0 && psPipeline->nKernelSlots > 1 )
         {
-            CPLError( CE_Failure, CPLE_AppDefined,
-                      "Failed to acquire WarpMutex in WarpRegion()." );
-            return CE_Failure;
+            oWK.pTransformerArg =
+                psPipeline->papTransformerArg[psJob->iKernelSlot];
+            oWK.psThreadData = NULL;
+        }
+        if( psPipeline->pfnProgress != GDALDummyProgress )
+        {
+            oWK.pfnProgress = GDALWarpChunkProgress;
+            oWK.pProgress = psJob;
         }
     }
 
@@ -1905,17 +2455,14 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
             (void *) &oWK, psOptions->pPostWarpProcessorArg );
 
 /* -------------------------------------------------------------------- */
-/*      Release Warp Mutex, and acquire io mutex.                       */
+/*      Release the kernel slot, and acquire io mutex once the          */
+/*      previous chunks are written.                                    */
 /* -------------------------------------------------------------------- */
-    if( hIOMutex != NULL )
+    if( psJob != NULL )
     {
-        CPLReleaseMutex( hWarpMutex );
-        if( !CPLAcquireMutex( hIOMutex, 600.0 ) )
-        {
-            CPLError( CE_Failure, CPLE_AppDefined,
-                      "Failed to acquire IOMutex in WarpRegion()." );
-            return CE_Failure;
-        }
+        const CPLErr eErr2 = GDALWarpChunkStartWrite( psJob );
+        if( eErr == CE_None )
+            eErr = eErr2;
     }
 
 /* -------------------------------------------------------------------- */
@@ -1934,9 +2481,13 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
     }
 
 /* -------------------------------------------------------------------- */
-/*      Cleanup.                                                        */
+/*      Cleanup, unless the source buffer is kept for the next chunk.   */
 /* -------------------------------------------------------------------- */
-    CPLFree( oWK.papabySrcImage[0] );
+    if( pabyLastSrcBuffer != NULL &&
+        pabyLastSrcBuffer == oWK.papabySrcImage[0] )
+        bLastSrcBufferOwned = TRUE;
+    else
+        CPLFree( oWK.papabySrcImage[0] );
     CPLFree( oWK.papabySrcImage );
     CPLFree( oWK.papabyDstImage );
 
@@ -2401,6 +2952,33 @@ CPLErr GDALWarpOperation::ComputeSourceWindow(int nDstXOff, int nDstYOff,
     return CE_None;
 }
 
+/************************************************************************/
+/*                          GDALWarpGetTime()                           */
+/************************************************************************/
+
+/* Time in seconds since an arbitrary origin, with a sub-second resolution, */
+/* from a clock that is not affected by changes of the system time where */
+/* one is available. */
+static double GDALWarpGetTime()
+{
+#ifdef _WIN32
+    LARGE_INTEGER nFrequency, nCounter;
+    if( QueryPerformanceFrequency(&nFrequency) &&
+        QueryPerformanceCounter(&nCounter) )
+        return static_cast<double>(nCounter.QuadPart) / nFrequency.QuadPart;
+    return GetTickCount() / 1000.0;
+#else
+#ifdef CLOCK_MONOTONIC
+    struct timespec sTime;
+    if( clock_gettime(CLOCK_MONOTONIC, &sTime) == 0 )
+        return sTime.tv_sec + sTime.tv_nsec * 1e-9;
+#endif
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+#endif
+}
+
 /************************************************************************/
 /*                            ReportTiming()                            */
 /************************************************************************/
@@ -2411,13 +2989,31 @@ void GDALWarpOperation::ReportTiming( const char * pszMessage )
     if( !bReportTimings )
         return;
 
-    unsigned long nNewTime = VSITime(NULL);
+    const double dfNewTime = GDALWarpGetTime();
 
     if( pszMessage != NULL )
     {
-        CPLDebug( "WARP_TIMING", "%s: %lds",
-                  pszMessage, (long)(nNewTime - nLastTimeReported) );
+        CPLDebug( "WARP_TIMING", "%s: %.3fs",
+                  pszMessage, dfNewTime - dfLastTimeReported );
     }
 
-    nLastTimeReported = nNewTime;
+    dfLastTimeReported = dfNewTime;
+}
+
+/************************************************************************/
+/*                         ReportTotalTiming()                          */
+/************************************************************************/
+
+void GDALWarpOperation::ReportTotalTiming( double dfStartTime,
+                                           int nChunkCount )
+
+{
+    if( !bReportTimings )
+        return;
+
+    CPLDebug( "WARP_TIMING",
+              "Total: %.3fs for %d chunks, " CPL_FRMT_GIB " source pixels "
+              "read, " CPL_FRMT_GIB " reused from the previous chunks",
+              GDALWarpGetTime() - dfStartTime, nChunkCount,
+              nSrcPixelsRead, nSrcPixelsReused );
 }
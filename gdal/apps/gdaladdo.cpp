@@ -54,6 +54,7 @@ static void Usage(const char* pszErrorMsg = NULL)
             "\n"
             "Useful configuration variables :\n"
             "  --config USE_RRD YES : Use Erdas Imagine format (.aux) as overview format.\n"
+            "  --config GDAL_OVR_SINGLE_PASS YES : Compute all the levels while the dataset is read once.\n"
             "Below, only for external overviews in GeoTIFF format:\n"
             "  --config COMPRESS_OVERVIEW {JPEG,LZW,PACKBITS,DEFLATE} : TIFF compression\n"
             "  --config PHOTOMETRIC_OVERVIEW {RGB,YCBCR,...} : TIFF photometric interp.\n"
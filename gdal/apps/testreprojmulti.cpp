@@ -34,6 +34,12 @@
 #include "cpl_multiproc.h"
 #include "ogr_spatialref.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
 CPL_CVSID("$Id$");
 
 double* padfRefX;
@@ -46,24 +52,34 @@ int bCreateCTInThread = FALSE;
 OGRSpatialReference oSrcSRS, oDstSRS;
 int nCountIter = 10000;
 
-void ReprojFunc(void* unused)
+static double GetWallTime()
+{
+#ifdef _WIN32
+    return GetTickCount() / 1000.0;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+#endif
+}
+
+static void ReprojFunc(void* /* unused */)
 {
     double* padfResultX;
     double* padfResultY;
     padfResultX = (double*)CPLMalloc(1024 * sizeof(double));
     padfResultY = (double*)CPLMalloc(1024 * sizeof(double));
-    OGRCoordinateTransformation *poCTInThread;
+    OGRCoordinateTransformation *poCTInThread = NULL;
     if (!bCreateCTInThread)
         poCTInThread = poCT;
-    while( true )
+    while( CPLAtomicInc(&nIter) <= nCountIter )
     {
         if (bCreateCTInThread)
             poCTInThread = OGRCreateCoordinateTransformation(&oSrcSRS,&oDstSRS);
 
-        CPLAtomicInc(&nIter);
         memcpy(padfResultX, padfRefX, 1024 * sizeof(double));
         memcpy(padfResultY, padfRefY, 1024 * sizeof(double));
-        poCT->TransformEx( 1024, padfResultX, padfResultY, NULL, NULL );
+        poCTInThread->TransformEx( 1024, padfResultX, padfResultY, NULL, NULL );
 
         /* Check that the results are consistent with the reference results */
         assert(memcmp(padfResultX, padfRefResultX, 1024 * sizeof(double)) == 0);
@@ -72,11 +88,36 @@ void ReprojFunc(void* unused)
         if (bCreateCTInThread)
             OGRCoordinateTransformation::DestroyCT(poCTInThread);
     }
+    CPLFree(padfResultX);
+    CPLFree(padfResultY);
+}
+
+/************************************************************************/
+/*                              RunWith()                               */
+/*                                                                      */
+/*      Run nCountIter transformations of 1024 points with nThreads    */
+/*      threads, and return the elapsed time.                           */
+/************************************************************************/
+
+static double RunWith(int nThreads)
+{
+    CPLJoinableThread** pahThreads = (CPLJoinableThread**)
+        CPLMalloc(nThreads * sizeof(CPLJoinableThread*));
+    nIter = 0;
+    const double dfStart = GetWallTime();
+    for(int i=0;i<nThreads;i++)
+        pahThreads[i] = CPLCreateJoinableThread(ReprojFunc, NULL);
+    for(int i=0;i<nThreads;i++)
+        CPLJoinThread(pahThreads[i]);
+    const double dfEnd = GetWallTime();
+    CPLFree(pahThreads);
+    return dfEnd - dfStart;
 }
 
 int main(int argc, char* argv[])
 {
     int nThreads = 2;
+    int bScaling = FALSE;
 
     int i;
     for(i=0;i<argc;i++)
@@ -87,7 +128,11 @@ int main(int argc, char* argv[])
             nCountIter = atoi(argv[++i]);
         else if (EQUAL(argv[i], "-createctinthread"))
             bCreateCTInThread = TRUE;
+        else if (EQUAL(argv[i], "-scaling"))
+            bScaling = TRUE;
     }
+    if (nThreads < 1)
+        nThreads = 1;
 
     oSrcSRS.importFromEPSG(4326);
     oDstSRS.importFromEPSG(32631);
@@ -110,11 +155,29 @@ int main(int argc, char* argv[])
 
     poCT->TransformEx( 1024, padfRefResultX, padfRefResultY, NULL, NULL );
 
-    for(i=0;i<nThreads;i++)
-        CPLCreateThread(ReprojFunc, NULL);
+    /* With -scaling, run with 1, 2, 4, ... threads up to nThreads, to */
+    /* check that the throughput grows linearly with the number of threads */
+    double dfRefTime = 0.0;
+    for(int nThisThreads = bScaling ? 1 : nThreads; ; )
+    {
+        const double dfTime = RunWith(nThisThreads);
+        if (dfRefTime == 0.0)
+            dfRefTime = dfTime;
+        printf("%d thread(s): %d iterations in %.3f s, %.0f points/s, "
+               "speedup %.2f\n",
+               nThisThreads, nCountIter, dfTime,
+               dfTime > 0 ? 1024.0 * nCountIter / dfTime : 0.0,
+               dfTime > 0 ? dfRefTime / dfTime : 0.0);
+        if (nThisThreads == nThreads)
+            break;
+        nThisThreads = MIN(nThisThreads * 2, nThreads);
+    }
 
-    while(nIter < nCountIter)
-        CPLSleep(0.001);
+    OGRCoordinateTransformation::DestroyCT(poCT);
+    CPLFree(padfRefX);
+    CPLFree(padfRefY);
+    CPLFree(padfRefResultX);
+    CPLFree(padfRefResultY);
 
     return 0;
 }
@@ -58,6 +58,22 @@ static char *szConfiguredFormats = "GDAL_FORMATS";
  *
  * This function should generally be called once at the beginning of the
  * application.
+ *
+ * If the GDAL_DEFERRED_DRIVER_REGISTRATION configuration option is set to
+ * YES, the built-in drivers are not registered right away: each one is
+ * replaced by a stub holding its short name, that is turned into the actual
+ * driver the first time it is needed, for example when GDALOpenEx() probes
+ * it, or it is requested with GDALGetDriverByName(). This reduces the
+ * start-up time of short-lived processes that only use a few drivers. See
+ * GDALDriverManager::DeclareDeferredDriver().
+ *
+ * The stubs only know the short name of their driver, and cannot tell
+ * whether it would accept a file. GDALOpenEx() therefore loads all the
+ * drivers that come before the one that opens the file, and all of them if
+ * no driver can open it, even when it is given a list of allowed drivers.
+ * Deferring the registration mostly helps processes that open formats
+ * coming early in the driver list, such as GTiff, or that fetch their
+ * drivers with GDALGetDriverByName().
  */
 
 void CPL_STDCALL GDALAllRegister()
@@ -66,335 +82,338 @@ void CPL_STDCALL GDALAllRegister()
     // AutoLoadDrivers is a no-op if compiled with GDAL_NO_AUTOLOAD defined.
     GetGDALDriverManager()->AutoLoadDrivers();
 
+    const bool bDeferred = CPLTestBool(
+        CPLGetConfigOption("GDAL_DEFERRED_DRIVER_REGISTRATION", "NO") );
+
 #ifdef FRMT_vrt
-    GDALRegister_VRT();
+    GDALRegisterOrDeferDriver( bDeferred, "VRT", GDALRegister_VRT );
 #endif
 
 #ifdef FRMT_gtiff
-    GDALRegister_GTiff();
+    GDALRegisterOrDeferDriver( bDeferred, "GTiff", GDALRegister_GTiff );
 #endif
 
 #ifdef FRMT_nitf
-    GDALRegister_NITF();
-    GDALRegister_RPFTOC();
-    GDALRegister_ECRGTOC();
+    GDALRegisterOrDeferDriver( bDeferred, "NITF", GDALRegister_NITF );
+    GDALRegisterOrDeferDriver( bDeferred, "RPFTOC", GDALRegister_RPFTOC );
+    GDALRegisterOrDeferDriver( bDeferred, "ECRGTOC", GDALRegister_ECRGTOC );
 #endif
 
 #ifdef FRMT_hfa
-    GDALRegister_HFA();
+    GDALRegisterOrDeferDriver( bDeferred, "HFA", GDALRegister_HFA );
 #endif
 
 #ifdef FRMT_ceos2
-    GDALRegister_SAR_CEOS();
+    GDALRegisterOrDeferDriver( bDeferred, "SAR_CEOS", GDALRegister_SAR_CEOS );
 #endif
 
 #ifdef FRMT_ceos
-    GDALRegister_CEOS();
+    GDALRegisterOrDeferDriver( bDeferred, "CEOS", GDALRegister_CEOS );
 #endif
 
 #ifdef FRMT_jaxapalsar
-    GDALRegister_PALSARJaxa();
+    GDALRegisterOrDeferDriver( bDeferred, "JAXAPALSAR", GDALRegister_PALSARJaxa );
 #endif
 
 #ifdef FRMT_gff
-    GDALRegister_GFF();
+    GDALRegisterOrDeferDriver( bDeferred, "GFF", GDALRegister_GFF );
 #endif
 
 #ifdef FRMT_elas
-    GDALRegister_ELAS();
+    GDALRegisterOrDeferDriver( bDeferred, "ELAS", GDALRegister_ELAS );
 #endif
 
 #ifdef FRMT_aigrid
 //    GDALRegister_AIGrid2();
-    GDALRegister_AIGrid();
+    GDALRegisterOrDeferDriver( bDeferred, "AIG", GDALRegister_AIGrid );
 #endif
 
 #ifdef FRMT_aaigrid
-    GDALRegister_AAIGrid();
-    GDALRegister_GRASSASCIIGrid();
+    GDALRegisterOrDeferDriver( bDeferred, "AAIGrid", GDALRegister_AAIGrid );
+    GDALRegisterOrDeferDriver( bDeferred, "GRASSASCIIGrid", GDALRegister_GRASSASCIIGrid );
 #endif
 
 #ifdef FRMT_sdts
-    GDALRegister_SDTS();
+    GDALRegisterOrDeferDriver( bDeferred, "SDTS", GDALRegister_SDTS );
 #endif
 
 #ifdef FRMT_ogdi
-    GDALRegister_OGDI();
+    GDALRegisterOrDeferDriver( bDeferred, "OGDI", GDALRegister_OGDI );
 #endif
 
 #ifdef FRMT_dted
-    GDALRegister_DTED();
+    GDALRegisterOrDeferDriver( bDeferred, "DTED", GDALRegister_DTED );
 #endif
 
 #ifdef FRMT_png
-    GDALRegister_PNG();
+    GDALRegisterOrDeferDriver( bDeferred, "PNG", GDALRegister_PNG );
 #endif
 
 #ifdef FRMT_dds
-    GDALRegister_DDS();
+    GDALRegisterOrDeferDriver( bDeferred, "DDS", GDALRegister_DDS );
 #endif
 
 #ifdef FRMT_gta
-    GDALRegister_GTA();
+    GDALRegisterOrDeferDriver( bDeferred, "GTA", GDALRegister_GTA );
 #endif
 
 #ifdef FRMT_jpeg
-    GDALRegister_JPEG();
+    GDALRegisterOrDeferDriver( bDeferred, "JPEG", GDALRegister_JPEG );
 #endif
 
 #ifdef FRMT_mem
-    GDALRegister_MEM();
+    GDALRegisterOrDeferDriver( bDeferred, "MEM", GDALRegister_MEM );
 #endif
 
 #ifdef FRMT_jdem
-    GDALRegister_JDEM();
+    GDALRegisterOrDeferDriver( bDeferred, "JDEM", GDALRegister_JDEM );
 #endif
 
 #ifdef FRMT_rasdaman
-    GDALRegister_RASDAMAN();
+    GDALRegisterOrDeferDriver( bDeferred, "RASDAMAN", GDALRegister_RASDAMAN );
 #endif
 
 #ifdef FRMT_gif
-    GDALRegister_GIF();
-    GDALRegister_BIGGIF();
+    GDALRegisterOrDeferDriver( bDeferred, "GIF", GDALRegister_GIF );
+    GDALRegisterOrDeferDriver( bDeferred, "BIGGIF", GDALRegister_BIGGIF );
 #endif
 
 #ifdef FRMT_envisat
-    GDALRegister_Envisat();
+    GDALRegisterOrDeferDriver( bDeferred, "ESAT", GDALRegister_Envisat );
 #endif
 
 #ifdef FRMT_fits
-    GDALRegister_FITS();
+    GDALRegisterOrDeferDriver( bDeferred, "FITS", GDALRegister_FITS );
 #endif
 
 #ifdef FRMT_bsb
-    GDALRegister_BSB();
+    GDALRegisterOrDeferDriver( bDeferred, "BSB", GDALRegister_BSB );
 #endif
 
 #ifdef FRMT_xpm
-    GDALRegister_XPM();
+    GDALRegisterOrDeferDriver( bDeferred, "XPM", GDALRegister_XPM );
 #endif
 
 #ifdef FRMT_bmp
-    GDALRegister_BMP();
+    GDALRegisterOrDeferDriver( bDeferred, "BMP", GDALRegister_BMP );
 #endif
 
 #ifdef FRMT_dimap
-    GDALRegister_DIMAP();
+    GDALRegisterOrDeferDriver( bDeferred, "DIMAP", GDALRegister_DIMAP );
 #endif
 
 #ifdef FRMT_airsar
-    GDALRegister_AirSAR();
+    GDALRegisterOrDeferDriver( bDeferred, "AirSAR", GDALRegister_AirSAR );
 #endif
 
 #ifdef FRMT_rs2
-    GDALRegister_RS2();
+    GDALRegisterOrDeferDriver( bDeferred, "RS2", GDALRegister_RS2 );
 #endif
 
 #ifdef FRMT_safe
-    GDALRegister_SAFE();
+    GDALRegisterOrDeferDriver( bDeferred, "SAFE", GDALRegister_SAFE );
 #endif
 
 #ifdef FRMT_pcidsk
-    GDALRegister_PCIDSK();
+    GDALRegisterOrDeferDriver( bDeferred, "PCIDSK", GDALRegister_PCIDSK );
 #endif
 
 #ifdef FRMT_pcraster
-    GDALRegister_PCRaster();
+    GDALRegisterOrDeferDriver( bDeferred, "PCRaster", GDALRegister_PCRaster );
 #endif
 
 #ifdef FRMT_ilwis
-    GDALRegister_ILWIS();
+    GDALRegisterOrDeferDriver( bDeferred, "ILWIS", GDALRegister_ILWIS );
 #endif
 
 #ifdef FRMT_sgi
-    GDALRegister_SGI();
+    GDALRegisterOrDeferDriver( bDeferred, "SGI", GDALRegister_SGI );
 #endif
 
 #ifdef FRMT_srtmhgt
-    GDALRegister_SRTMHGT();
+    GDALRegisterOrDeferDriver( bDeferred, "SRTMHGT", GDALRegister_SRTMHGT );
 #endif
 
 #ifdef FRMT_leveller
-    GDALRegister_Leveller();
+    GDALRegisterOrDeferDriver( bDeferred, "Leveller", GDALRegister_Leveller );
 #endif
 
 #ifdef FRMT_terragen
-    GDALRegister_Terragen();
+    GDALRegisterOrDeferDriver( bDeferred, "Terragen", GDALRegister_Terragen );
 #endif
 
 #ifdef FRMT_netcdf
-    GDALRegister_GMT();
-    GDALRegister_netCDF();
+    GDALRegisterOrDeferDriver( bDeferred, "GMT", GDALRegister_GMT );
+    GDALRegisterOrDeferDriver( bDeferred, "netCDF", GDALRegister_netCDF );
 #endif
 
 #ifdef FRMT_hdf4
-    GDALRegister_HDF4();
-    GDALRegister_HDF4Image();
+    GDALRegisterOrDeferDriver( bDeferred, "HDF4", GDALRegister_HDF4 );
+    GDALRegisterOrDeferDriver( bDeferred, "HDF4Image", GDALRegister_HDF4Image );
 #endif
 
 #ifdef FRMT_pds
-    GDALRegister_ISIS3();
-    GDALRegister_ISIS2();
-    GDALRegister_PDS();
-    GDALRegister_VICAR();
+    GDALRegisterOrDeferDriver( bDeferred, "ISIS3", GDALRegister_ISIS3 );
+    GDALRegisterOrDeferDriver( bDeferred, "ISIS2", GDALRegister_ISIS2 );
+    GDALRegisterOrDeferDriver( bDeferred, "PDS", GDALRegister_PDS );
+    GDALRegisterOrDeferDriver( bDeferred, "VICAR", GDALRegister_VICAR );
 #endif
 
 #ifdef FRMT_til
-    GDALRegister_TIL();
+    GDALRegisterOrDeferDriver( bDeferred, "TIL", GDALRegister_TIL );
 #endif
 
 #ifdef FRMT_ers
-    GDALRegister_ERS();
+    GDALRegisterOrDeferDriver( bDeferred, "ERS", GDALRegister_ERS );
 #endif
 
 #ifdef FRMT_jp2kak
 // JPEG2000 support using Kakadu toolkit
-    GDALRegister_JP2KAK();
+    GDALRegisterOrDeferDriver( bDeferred, "JP2KAK", GDALRegister_JP2KAK );
 #endif
 
 #ifdef FRMT_jpipkak
 // JPEG2000 support using Kakadu toolkit
-    GDALRegister_JPIPKAK();
+    GDALRegisterOrDeferDriver( bDeferred, "JPIPKAK", GDALRegister_JPIPKAK );
 #endif
 
 #ifdef FRMT_ecw
-    GDALRegister_ECW();
-    GDALRegister_JP2ECW();
+    GDALRegisterOrDeferDriver( bDeferred, "ECW", GDALRegister_ECW );
+    GDALRegisterOrDeferDriver( bDeferred, "JP2ECW", GDALRegister_JP2ECW );
 #endif
 
 #ifdef FRMT_openjpeg
 // JPEG2000 support using OpenJPEG library
-    GDALRegister_JP2OpenJPEG();
+    GDALRegisterOrDeferDriver( bDeferred, "JP2OpenJPEG", GDALRegister_JP2OpenJPEG );
 #endif
 
 #ifdef FRMT_l1b
-    GDALRegister_L1B();
+    GDALRegisterOrDeferDriver( bDeferred, "L1B", GDALRegister_L1B );
 #endif
 
 #ifdef FRMT_fit
-    GDALRegister_FIT();
+    GDALRegisterOrDeferDriver( bDeferred, "FIT", GDALRegister_FIT );
 #endif
 
 #ifdef FRMT_grib
-    GDALRegister_GRIB();
+    GDALRegisterOrDeferDriver( bDeferred, "GRIB", GDALRegister_GRIB );
 #endif
 
 #ifdef FRMT_mrsid
-    GDALRegister_MrSID();
+    GDALRegisterOrDeferDriver( bDeferred, "MrSID", GDALRegister_MrSID );
 #endif
 
 #ifdef FRMT_jpeg2000
 // JPEG2000 support using JasPer toolkit
 // This one should always be placed after other JasPer supported formats,
 // such as BMP or PNM. In other case we will get bad side effects.
-    GDALRegister_JPEG2000();
+    GDALRegisterOrDeferDriver( bDeferred, "JPEG2000", GDALRegister_JPEG2000 );
 #endif
 
 #ifdef FRMT_mrsid_lidar
-    GDALRegister_MG4Lidar();
+    GDALRegisterOrDeferDriver( bDeferred, "MG4Lidar", GDALRegister_MG4Lidar );
 #endif
 
 #ifdef FRMT_rmf
-    GDALRegister_RMF();
+    GDALRegisterOrDeferDriver( bDeferred, "RMF", GDALRegister_RMF );
 #endif
 
 #ifdef FRMT_wcs
-    GDALRegister_WCS();
+    GDALRegisterOrDeferDriver( bDeferred, "WCS", GDALRegister_WCS );
 #endif
 
 #ifdef FRMT_wms
-    GDALRegister_WMS();
+    GDALRegisterOrDeferDriver( bDeferred, "WMS", GDALRegister_WMS );
 #endif
 
 #ifdef FRMT_sde
-    GDALRegister_SDE();
+    GDALRegisterOrDeferDriver( bDeferred, "SDE", GDALRegister_SDE );
 #endif
 
 #ifdef FRMT_msgn
-    GDALRegister_MSGN();
+    GDALRegisterOrDeferDriver( bDeferred, "MSGN", GDALRegister_MSGN );
 #endif
 
 #ifdef FRMT_msg
-    GDALRegister_MSG();
+    GDALRegisterOrDeferDriver( bDeferred, "MSG", GDALRegister_MSG );
 #endif
 
 #ifdef FRMT_idrisi
-    GDALRegister_IDRISI();
+    GDALRegisterOrDeferDriver( bDeferred, "RST", GDALRegister_IDRISI );
 #endif
 
 #ifdef FRMT_ingr
-    GDALRegister_INGR();
+    GDALRegisterOrDeferDriver( bDeferred, "INGR", GDALRegister_INGR );
 #endif
 
 #ifdef FRMT_gsg
-    GDALRegister_GSAG();
-    GDALRegister_GSBG();
-    GDALRegister_GS7BG();
+    GDALRegisterOrDeferDriver( bDeferred, "GSAG", GDALRegister_GSAG );
+    GDALRegisterOrDeferDriver( bDeferred, "GSBG", GDALRegister_GSBG );
+    GDALRegisterOrDeferDriver( bDeferred, "GS7BG", GDALRegister_GS7BG );
 #endif
 
 #ifdef FRMT_cosar
-    GDALRegister_COSAR();
+    GDALRegisterOrDeferDriver( bDeferred, "COSAR", GDALRegister_COSAR );
 #endif
 
 #ifdef FRMT_tsx
-    GDALRegister_TSX();
+    GDALRegisterOrDeferDriver( bDeferred, "TSX", GDALRegister_TSX );
 #endif
 
 #ifdef FRMT_coasp
-    GDALRegister_COASP();
+    GDALRegisterOrDeferDriver( bDeferred, "COASP", GDALRegister_COASP );
 #endif
 
 #ifdef FRMT_tms
-    GDALRegister_TMS();
+    GDALRegisterOrDeferDriver( bDeferred, "TMS", GDALRegister_TMS );
 #endif
 
 #ifdef FRMT_r
-    GDALRegister_R();
+    GDALRegisterOrDeferDriver( bDeferred, "R", GDALRegister_R );
 #endif
 
 #ifdef FRMT_map
-    GDALRegister_MAP();
+    GDALRegisterOrDeferDriver( bDeferred, "MAP", GDALRegister_MAP );
 #endif
 
 #ifdef FRMT_kmlsuperoverlay
-    GDALRegister_KMLSUPEROVERLAY();
+    GDALRegisterOrDeferDriver( bDeferred, "KMLSUPEROVERLAY", GDALRegister_KMLSUPEROVERLAY );
 #endif
 
 #ifdef FRMT_webp
-    GDALRegister_WEBP();
+    GDALRegisterOrDeferDriver( bDeferred, "WEBP", GDALRegister_WEBP );
 #endif
 
 #ifdef FRMT_pdf
-    GDALRegister_PDF();
+    GDALRegisterOrDeferDriver( bDeferred, "PDF", GDALRegister_PDF );
 #endif
 
 #ifdef FRMT_rasterlite
-    GDALRegister_Rasterlite();
+    GDALRegisterOrDeferDriver( bDeferred, "Rasterlite", GDALRegister_Rasterlite );
 #endif
 
 #ifdef FRMT_mbtiles
-    GDALRegister_MBTiles();
+    GDALRegisterOrDeferDriver( bDeferred, "MBTiles", GDALRegister_MBTiles );
 #endif
 
 #ifdef FRMT_plmosaic
-    GDALRegister_PLMOSAIC();
+    GDALRegisterOrDeferDriver( bDeferred, "PLMOSAIC", GDALRegister_PLMOSAIC );
 #endif
 
 #ifdef FRMT_cals
-    GDALRegister_CALS();
+    GDALRegisterOrDeferDriver( bDeferred, "CALS", GDALRegister_CALS );
 #endif
 
 #ifdef FRMT_wmts
-    GDALRegister_WMTS();
+    GDALRegisterOrDeferDriver( bDeferred, "WMTS", GDALRegister_WMTS );
 #endif
 
 #ifdef FRMT_sentinel2
-    GDALRegister_SENTINEL2();
+    GDALRegisterOrDeferDriver( bDeferred, "SENTINEL2", GDALRegister_SENTINEL2 );
 #endif
 
 #ifdef FRMT_mrf
-    GDALRegister_mrf();
+    GDALRegisterOrDeferDriver( bDeferred, "MRF", GDALRegister_mrf );
 #endif
 
 /* -------------------------------------------------------------------- */
@@ -405,41 +424,41 @@ void CPL_STDCALL GDALAllRegister()
 /* -------------------------------------------------------------------- */
 
 #ifdef FRMT_raw
-    GDALRegister_PNM();
-    GDALRegister_DOQ1();
-    GDALRegister_DOQ2();
-    GDALRegister_GenBin();
-    GDALRegister_PAux();
-    GDALRegister_MFF();
-    GDALRegister_HKV();
-    GDALRegister_FujiBAS();
-    GDALRegister_GSC();
-    GDALRegister_FAST();
-    GDALRegister_BT();
-    GDALRegister_LAN();
-    GDALRegister_CPG();
-    GDALRegister_IDA();
-    GDALRegister_NDF();
-    GDALRegister_EIR();
-    GDALRegister_DIPEx();
-    GDALRegister_LCP();
-    GDALRegister_GTX();
-    GDALRegister_LOSLAS();
-    GDALRegister_NTv2();
-    GDALRegister_CTable2();
-    GDALRegister_ACE2();
-    GDALRegister_SNODAS();
-    GDALRegister_KRO();
-    GDALRegister_ROIPAC();
+    GDALRegisterOrDeferDriver( bDeferred, "PNM", GDALRegister_PNM );
+    GDALRegisterOrDeferDriver( bDeferred, "DOQ1", GDALRegister_DOQ1 );
+    GDALRegisterOrDeferDriver( bDeferred, "DOQ2", GDALRegister_DOQ2 );
+    GDALRegisterOrDeferDriver( bDeferred, "GenBin", GDALRegister_GenBin );
+    GDALRegisterOrDeferDriver( bDeferred, "PAux", GDALRegister_PAux );
+    GDALRegisterOrDeferDriver( bDeferred, "MFF", GDALRegister_MFF );
+    GDALRegisterOrDeferDriver( bDeferred, "MFF2", GDALRegister_HKV );
+    GDALRegisterOrDeferDriver( bDeferred, "FujiBAS", GDALRegister_FujiBAS );
+    GDALRegisterOrDeferDriver( bDeferred, "GSC", GDALRegister_GSC );
+    GDALRegisterOrDeferDriver( bDeferred, "FAST", GDALRegister_FAST );
+    GDALRegisterOrDeferDriver( bDeferred, "BT", GDALRegister_BT );
+    GDALRegisterOrDeferDriver( bDeferred, "LAN", GDALRegister_LAN );
+    GDALRegisterOrDeferDriver( bDeferred, "CPG", GDALRegister_CPG );
+    GDALRegisterOrDeferDriver( bDeferred, "IDA", GDALRegister_IDA );
+    GDALRegisterOrDeferDriver( bDeferred, "NDF", GDALRegister_NDF );
+    GDALRegisterOrDeferDriver( bDeferred, "EIR", GDALRegister_EIR );
+    GDALRegisterOrDeferDriver( bDeferred, "DIPEx", GDALRegister_DIPEx );
+    GDALRegisterOrDeferDriver( bDeferred, "LCP", GDALRegister_LCP );
+    GDALRegisterOrDeferDriver( bDeferred, "GTX", GDALRegister_GTX );
+    GDALRegisterOrDeferDriver( bDeferred, "LOSLAS", GDALRegister_LOSLAS );
+    GDALRegisterOrDeferDriver( bDeferred, "NTv2", GDALRegister_NTv2 );
+    GDALRegisterOrDeferDriver( bDeferred, "CTable2", GDALRegister_CTable2 );
+    GDALRegisterOrDeferDriver( bDeferred, "ACE2", GDALRegister_ACE2 );
+    GDALRegisterOrDeferDriver( bDeferred, "SNODAS", GDALRegister_SNODAS );
+    GDALRegisterOrDeferDriver( bDeferred, "KRO", GDALRegister_KRO );
+    GDALRegisterOrDeferDriver( bDeferred, "ROI_PAC", GDALRegister_ROIPAC );
 
     // Those ones need to look for side car files so put them at end
-    GDALRegister_ENVI();
-    GDALRegister_EHdr();
-    GDALRegister_ISCE();
+    GDALRegisterOrDeferDriver( bDeferred, "ENVI", GDALRegister_ENVI );
+    GDALRegisterOrDeferDriver( bDeferred, "EHdr", GDALRegister_EHdr );
+    GDALRegisterOrDeferDriver( bDeferred, "ISCE", GDALRegister_ISCE );
 #endif
 
 #ifdef FRMT_arg
-    GDALRegister_ARG();
+    GDALRegisterOrDeferDriver( bDeferred, "ARG", GDALRegister_ARG );
 #endif
 
 /* -------------------------------------------------------------------- */
@@ -448,100 +467,100 @@ void CPL_STDCALL GDALAllRegister()
 /* -------------------------------------------------------------------- */
 
 #ifdef FRMT_rik
-    GDALRegister_RIK();
+    GDALRegisterOrDeferDriver( bDeferred, "RIK", GDALRegister_RIK );
 #endif
 
 #ifdef FRMT_usgsdem
-    GDALRegister_USGSDEM();
+    GDALRegisterOrDeferDriver( bDeferred, "USGSDEM", GDALRegister_USGSDEM );
 #endif
 
 #ifdef FRMT_gxf
-    GDALRegister_GXF();
+    GDALRegisterOrDeferDriver( bDeferred, "GXF", GDALRegister_GXF );
 #endif
 
 #ifdef FRMT_grass
-    GDALRegister_GRASS();
+    GDALRegisterOrDeferDriver( bDeferred, "GRASS", GDALRegister_GRASS );
 #endif
 
 #ifdef FRMT_dods
-    GDALRegister_DODS();
+    GDALRegisterOrDeferDriver( bDeferred, "DODS", GDALRegister_DODS );
 #endif
 
 /* Register KEA before HDF5 */
 #ifdef FRMT_kea
-    GDALRegister_KEA();
+    GDALRegisterOrDeferDriver( bDeferred, "KEA", GDALRegister_KEA );
 #endif
 
 #ifdef FRMT_hdf5
-    GDALRegister_BAG();
-    GDALRegister_HDF5();
-    GDALRegister_HDF5Image();
+    GDALRegisterOrDeferDriver( bDeferred, "BAG", GDALRegister_BAG );
+    GDALRegisterOrDeferDriver( bDeferred, "HDF5", GDALRegister_HDF5 );
+    GDALRegisterOrDeferDriver( bDeferred, "HDF5Image", GDALRegister_HDF5Image );
 #endif
 
 #ifdef FRMT_northwood
-    GDALRegister_NWT_GRD();
-    GDALRegister_NWT_GRC();
+    GDALRegisterOrDeferDriver( bDeferred, "NWT_GRD", GDALRegister_NWT_GRD );
+    GDALRegisterOrDeferDriver( bDeferred, "NWT_GRC", GDALRegister_NWT_GRC );
 #endif
 
 #ifdef FRMT_adrg
-    GDALRegister_ADRG();
-    GDALRegister_SRP();
+    GDALRegisterOrDeferDriver( bDeferred, "ADRG", GDALRegister_ADRG );
+    GDALRegisterOrDeferDriver( bDeferred, "SRP", GDALRegister_SRP );
 #endif
 
 #ifdef FRMT_blx
-    GDALRegister_BLX();
+    GDALRegisterOrDeferDriver( bDeferred, "BLX", GDALRegister_BLX );
 #endif
 
 #ifdef FRMT_georaster
-    GDALRegister_GEOR();
+    GDALRegisterOrDeferDriver( bDeferred, "GeoRaster", GDALRegister_GEOR );
 #endif
 
 #ifdef FRMT_epsilon
-    GDALRegister_EPSILON();
+    GDALRegisterOrDeferDriver( bDeferred, "EPSILON", GDALRegister_EPSILON );
 #endif
 
 #ifdef FRMT_postgisraster
-    GDALRegister_PostGISRaster();
+    GDALRegisterOrDeferDriver( bDeferred, "PostGISRaster", GDALRegister_PostGISRaster );
 #endif
 
 #ifdef FRMT_saga
-    GDALRegister_SAGA();
+    GDALRegisterOrDeferDriver( bDeferred, "SAGA", GDALRegister_SAGA );
 #endif
 
 #ifdef FRMT_xyz
-    GDALRegister_XYZ();
+    GDALRegisterOrDeferDriver( bDeferred, "XYZ", GDALRegister_XYZ );
 #endif
 
 #ifdef FRMT_hf2
-    GDALRegister_HF2();
+    GDALRegisterOrDeferDriver( bDeferred, "HF2", GDALRegister_HF2 );
 #endif
 
 #ifdef FRMT_jpegls
-    GDALRegister_JPEGLS();
+    GDALRegisterOrDeferDriver( bDeferred, "JPEGLS", GDALRegister_JPEGLS );
 #endif
 
 #ifdef FRMT_ozi
-    GDALRegister_OZI();
+    GDALRegisterOrDeferDriver( bDeferred, "OZI", GDALRegister_OZI );
 #endif
 
 #ifdef FRMT_ctg
-    GDALRegister_CTG();
+    GDALRegisterOrDeferDriver( bDeferred, "CTG", GDALRegister_CTG );
 #endif
 
 #ifdef FRMT_e00grid
-    GDALRegister_E00GRID();
+    GDALRegisterOrDeferDriver( bDeferred, "E00GRID", GDALRegister_E00GRID );
 #endif
 
 #ifdef FRMT_zmap
-    GDALRegister_ZMap();
+    GDALRegisterOrDeferDriver( bDeferred, "ZMap", GDALRegister_ZMap );
 #endif
 
 #ifdef FRMT_ngsgeoid
-    GDALRegister_NGSGEOID();
+    GDALRegisterOrDeferDriver( bDeferred, "NGSGEOID", GDALRegister_NGSGEOID );
 #endif
 
 #ifdef FRMT_iris
-    GDALRegister_IRIS();
+    GDALRegisterOrDeferDriver( bDeferred, "IRIS", GDALRegister_IRIS );
 #endif
 
 #ifdef GNM_ENABLED
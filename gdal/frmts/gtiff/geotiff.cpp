@@ -38,6 +38,7 @@
 
 #include "cpl_port.h"  // Must be first.
 
+#include <algorithm>
 #include <set>
 
 #include "cpl_csv.h"
@@ -197,6 +198,25 @@ typedef struct
     int           bReady;
 } GTiffCompressionJob;
 
+typedef struct
+{
+    GTiffDataset     *poDS;
+    int               nBlockId;
+    int               nBlockBufSize;
+    int               nBlockReqSize;
+    /* Blocks to fill, one per band for pixel interleaved data, */
+    /* NULL for bands whose block is already cached */
+    GDALRasterBlock **papoBlocks;
+    int               nBlocks;
+    int               bSuccess;
+} GTiffDecodeJob;
+
+typedef struct
+{
+    TIFF         *hTIFF;
+    VSILFILE     *fpL;
+} GTiffDecodeHandle;
+
 class GTiffDataset CPL_FINAL : public GDALPamDataset
 {
     friend class GTiffRasterBand;
@@ -286,7 +306,10 @@ class GTiffDataset CPL_FINAL : public GDALPamDataset
     int         nGCPCount;
     GDAL_GCP    *pasGCPList;
 
-    int         IsBlockAvailable( int nBlockId );
+    int         IsBlockAvailable( int nBlockId,
+                                  vsi_l_offset* pnOffset = NULL,
+                                  vsi_l_offset* pnSize = NULL );
+    const GByte *GetBlockReadView( int nBlockId, int nBlockReqSize );
 
     int         bGeoTIFFInfoChanged;
     int         bForceUnsetGTOrGCPs;
@@ -398,6 +421,27 @@ class GTiffDataset CPL_FINAL : public GDALPamDataset
     int            SubmitCompressionJob(int nStripOrTile, GByte* pabyData,
                                         int cc, int nHeight);
 
+    int            nDecodeThreads;
+    CPLWorkerThreadPool *poDecodeThreadPool;
+    std::vector<GTiffDecodeHandle> asDecodeHandles;
+    CPLMutex      *hDecodeHandlesMutex;
+    CPLWorkerThreadPool* GetDecodeThreadPool();
+    static void    ThreadDecodeFunc(void* pData);
+    bool           AcquireDecodeHandle(GTiffDecodeHandle& sHandle);
+    void           ReleaseDecodeHandle(const GTiffDecodeHandle& sHandle);
+    void           CacheBlocksMultiThreaded( int nXOff, int nYOff,
+                                             int nXSize, int nYSize,
+                                             int nBandCount, int *panBandMap );
+
+    int            nMultiRangeMaxGap;
+    std::vector<void*> apMultiRangeData;
+    std::vector<vsi_l_offset> anMultiRangeOffsets;
+    std::vector<size_t> anMultiRangeSizes;
+    bool           CacheMultiRange( int nXOff, int nYOff,
+                                    int nXSize, int nYSize,
+                                    int nBandCount, int *panBandMap );
+    void           ClearMultiRangeCache();
+
     int            GuessJPEGQuality(int& bOutHasQuantizationTable,
                                     int& bOutHasHuffmanTable);
 
@@ -1882,15 +1926,525 @@ CPLErr GTiffDataset::IRasterIO( GDALRWFlag eRWFlag,
             return (CPLErr)nErr;
     }
 
+    bool bMultiRangeCached = false;
+    if( eRWFlag == GF_Read && nXSize == nBufXSize && nYSize == nBufYSize )
+    {
+        bMultiRangeCached = CacheMultiRange( nXOff, nYOff, nXSize, nYSize,
+                                             nBandCount, panBandMap );
+        CacheBlocksMultiThreaded( nXOff, nYOff, nXSize, nYSize,
+                                  nBandCount, panBandMap );
+    }
+
     nJPEGOverviewVisibilityFlag ++;
     eErr =  GDALPamDataset::IRasterIO(
                 eRWFlag, nXOff, nYOff, nXSize, nYSize,
                 pData, nBufXSize, nBufYSize, eBufType,
                 nBandCount, panBandMap, nPixelSpace, nLineSpace, nBandSpace, psExtraArg);
     nJPEGOverviewVisibilityFlag --;
+
+    if( bMultiRangeCached )
+        ClearMultiRangeCache();
     return eErr;
 }
 
+/************************************************************************/
+/*                        GetDecodeThreadPool()                         */
+/************************************************************************/
+
+/* The pool is shared by the overviews and masks of a dataset, and owned */
+/* by the base dataset. */
+
+CPLWorkerThreadPool* GTiffDataset::GetDecodeThreadPool()
+{
+    if( poBaseDS != NULL )
+        return poBaseDS->GetDecodeThreadPool();
+
+    if( nDecodeThreads < 0 )
+    {
+        nDecodeThreads = 0;
+        const char* pszValue = CPLGetConfigOption("GDAL_NUM_THREADS", NULL);
+        if( pszValue )
+        {
+            if( EQUAL(pszValue, "ALL_CPUS") )
+                nDecodeThreads = CPLGetNumCPUs();
+            else
+                nDecodeThreads = atoi(pszValue);
+        }
+        if( nDecodeThreads > 1 )
+        {
+            CPLDebug("GTiff", "Using %d threads for decompression",
+                     nDecodeThreads);
+            poDecodeThreadPool = new CPLWorkerThreadPool();
+            if( !poDecodeThreadPool->Setup(nDecodeThreads, NULL, NULL) )
+            {
+                delete poDecodeThreadPool;
+                poDecodeThreadPool = NULL;
+            }
+        }
+    }
+    return poDecodeThreadPool;
+}
+
+/************************************************************************/
+/*                        AcquireDecodeHandle()                         */
+/************************************************************************/
+
+/* libtiff handles cannot be used by several threads at once, so each */
+/* decoding job uses its own handle on the file, taken from a pool of */
+/* handles opened on demand. */
+
+bool GTiffDataset::AcquireDecodeHandle( GTiffDecodeHandle& sHandle )
+{
+    bool bFound = false;
+    {
+        CPLMutexHolderD(&hDecodeHandlesMutex);
+        if( !asDecodeHandles.empty() )
+        {
+            sHandle = asDecodeHandles.back();
+            asDecodeHandles.pop_back();
+            bFound = true;
+        }
+    }
+
+    if( !bFound )
+    {
+        // Overviews and masks share the file of their base dataset
+        const GTiffDataset* poRootDS = this;
+        while( poRootDS->osFilename.empty() && poRootDS->poBaseDS != NULL )
+            poRootDS = poRootDS->poBaseDS;
+
+        sHandle.fpL = VSIFOpenL(poRootDS->osFilename, "rb");
+        if( sHandle.fpL == NULL )
+            return false;
+        sHandle.hTIFF = VSI_TIFFOpen(poRootDS->osFilename, "rc", sHandle.fpL);
+        if( sHandle.hTIFF != NULL &&
+            TIFFCurrentDirOffset(sHandle.hTIFF) != nDirOffset &&
+            !TIFFSetSubDirectory(sHandle.hTIFF, nDirOffset) )
+        {
+            XTIFFClose(sHandle.hTIFF);
+            sHandle.hTIFF = NULL;
+        }
+        if( sHandle.hTIFF == NULL )
+        {
+            CPL_IGNORE_RET_VAL(VSIFCloseL(sHandle.fpL));
+            sHandle.fpL = NULL;
+            return false;
+        }
+    }
+
+    // Share the ranges read by CacheMultiRange(), if any. They are only
+    // read by the handles.
+    if( !apMultiRangeData.empty() )
+    {
+        VSI_TIFFSetCachedRanges( TIFFClientdata(sHandle.hTIFF),
+                                 static_cast<int>(apMultiRangeData.size()),
+                                 &apMultiRangeData[0],
+                                 &anMultiRangeOffsets[0],
+                                 &anMultiRangeSizes[0] );
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                        ReleaseDecodeHandle()                         */
+/************************************************************************/
+
+void GTiffDataset::ReleaseDecodeHandle( const GTiffDecodeHandle& sHandle )
+{
+    VSI_TIFFSetCachedRanges( TIFFClientdata(sHandle.hTIFF), 0,
+                             NULL, NULL, NULL );
+    CPLMutexHolderD(&hDecodeHandlesMutex);
+    asDecodeHandles.push_back(sHandle);
+}
+
+/************************************************************************/
+/*                          ThreadDecodeFunc()                          */
+/************************************************************************/
+
+void GTiffDataset::ThreadDecodeFunc( void* pData )
+{
+    GTiffDecodeJob* psJob = static_cast<GTiffDecodeJob*>(pData);
+    GTiffDataset* poDS = psJob->poDS;
+
+    // Errors are reported when the block is read again from the main thread
+    CPLPushErrorHandler(CPLQuietErrorHandler);
+
+    GTiffDecodeHandle sHandle;
+    if( !poDS->AcquireDecodeHandle(sHandle) )
+    {
+        CPLPopErrorHandler();
+        return;
+    }
+
+    GByte* pabyBuffer;
+    if( psJob->nBlocks == 1 )
+        pabyBuffer = static_cast<GByte*>(psJob->papoBlocks[0]->GetDataRef());
+    else
+        pabyBuffer = static_cast<GByte*>(
+                            VSI_MALLOC_VERBOSE(psJob->nBlockBufSize));
+
+    if( pabyBuffer != NULL )
+    {
+        if( psJob->nBlockReqSize < psJob->nBlockBufSize )
+            memset( pabyBuffer, 0, psJob->nBlockBufSize );
+
+        tmsize_t nRet;
+        if( TIFFIsTiled(sHandle.hTIFF) )
+            nRet = TIFFReadEncodedTile( sHandle.hTIFF, psJob->nBlockId,
+                                        pabyBuffer, psJob->nBlockReqSize );
+        else
+            nRet = TIFFReadEncodedStrip( sHandle.hTIFF, psJob->nBlockId,
+                                         pabyBuffer, psJob->nBlockReqSize );
+        psJob->bSuccess = nRet != -1;
+    }
+
+    if( psJob->bSuccess && psJob->nBlocks > 1 )
+    {
+        // Pixel interleaved buffer: dispatch to the blocks of each band
+        const GDALDataType eDT = poDS->GetRasterBand(1)->GetRasterDataType();
+        const int nWordBytes = poDS->nBitsPerSample / 8;
+        const int nValues = psJob->nBlockBufSize / (nWordBytes * psJob->nBlocks);
+        for( int iBand = 0; iBand < psJob->nBlocks; iBand++ )
+        {
+            if( psJob->papoBlocks[iBand] == NULL )
+                continue;
+            GDALCopyWords( pabyBuffer + iBand * nWordBytes, eDT,
+                           psJob->nBlocks * nWordBytes,
+                           psJob->papoBlocks[iBand]->GetDataRef(), eDT,
+                           nWordBytes, nValues );
+        }
+    }
+    if( psJob->nBlocks > 1 )
+        VSIFree(pabyBuffer);
+
+    poDS->ReleaseDecodeHandle(sHandle);
+    CPLPopErrorHandler();
+}
+
+/************************************************************************/
+/*                      CacheBlocksMultiThreaded()                      */
+/************************************************************************/
+
+/* When GDAL_NUM_THREADS is set, decompress the strips or tiles that      */
+/* intersect a read request in worker threads, and put them in the block  */
+/* cache, so that the generic RasterIO() implementation that follows only */
+/* has to copy them to the user buffer. This is a no-op when the request  */
+/* covers a single block, when its blocks do not fit in the block cache,  */
+/* or for layouts that are decoded by specialized band classes.           */
+
+void GTiffDataset::CacheBlocksMultiThreaded( int nXOff, int nYOff,
+                                             int nXSize, int nYSize,
+                                             int nBandCount, int *panBandMap )
+{
+    if( eAccess != GA_ReadOnly || bStreamingIn || nBands == 0 ||
+        bTreatAsRGBA || bTreatAsSplit || bTreatAsSplitBitmap )
+        return;
+    if( nCompression != COMPRESSION_ADOBE_DEFLATE &&
+        nCompression != COMPRESSION_DEFLATE &&
+        nCompression != COMPRESSION_LZW &&
+        nCompression != COMPRESSION_PACKBITS &&
+        nCompression != COMPRESSION_LZMA )
+        return;
+
+    // Bands with odd bit depths or promoted values have their own
+    // IReadBlock() implementation.
+    const GDALDataType eDT = GetRasterBand(1)->GetRasterDataType();
+    const int nDTSize = GDALGetDataTypeSize(eDT) / 8;
+    if( nDTSize * 8 != nBitsPerSample || bPromoteTo8Bits )
+        return;
+    const bool bInterleaved = nPlanarConfig == PLANARCONFIG_CONTIG && nBands > 1;
+    if( bInterleaved && nSamplesPerPixel != nBands )
+        return;
+
+    const int nBlockX1 = nXOff / nBlockXSize;
+    const int nBlockY1 = nYOff / nBlockYSize;
+    const int nBlockX2 = (nXOff + nXSize - 1) / nBlockXSize;
+    const int nBlockY2 = (nYOff + nYSize - 1) / nBlockYSize;
+    const int nXBlocks = nBlockX2 - nBlockX1 + 1;
+    const int nYBlocks = nBlockY2 - nBlockY1 + 1;
+    if( nXBlocks * nYBlocks < 2 )
+        return;
+
+    // All the blocks must fit in the cache at the same time
+    const int nCachedBands = bInterleaved ? nBands : nBandCount;
+    const GIntBig nRequiredMem = static_cast<GIntBig>(nCachedBands) *
+        nXBlocks * nYBlocks * nBlockXSize * nBlockYSize * nDTSize;
+    const GIntBig nCacheMax = GetBlockCacheQuota() > 0 ?
+                        GetBlockCacheQuota() : GDALGetCacheMax64();
+    if( nRequiredMem > nCacheMax / 2 )
+        return;
+
+    CPLWorkerThreadPool* poPool = GetDecodeThreadPool();
+    if( poPool == NULL || !SetDirectory() )
+        return;
+
+    const int nBlockBufSize = TIFFIsTiled(hTIFF) ?
+        static_cast<int>(TIFFTileSize(hTIFF)) :
+        static_cast<int>(TIFFStripSize(hTIFF));
+    if( nBlockBufSize == 0 )
+        return;
+
+/* -------------------------------------------------------------------- */
+/*      Create the cache blocks that are missing, and a decoding job     */
+/*      for each strip or tile that provides at least one of them.      */
+/* -------------------------------------------------------------------- */
+    const int nBandsPerJob = bInterleaved ? nBands : 1;
+    const int nJobsPerBlock = bInterleaved ? 1 : nBandCount;
+    const int nBlocksPerRow = DIV_ROUND_UP(nRasterXSize, nBlockXSize);
+    std::vector<GTiffDecodeJob> asJobs;
+    std::vector<GDALRasterBlock*> apoBlocks(
+        static_cast<size_t>(nXBlocks) * nYBlocks * nJobsPerBlock * nBandsPerJob );
+    asJobs.reserve( static_cast<size_t>(nXBlocks) * nYBlocks * nJobsPerBlock );
+
+    for( int iYBlock = nBlockY1; iYBlock <= nBlockY2; iYBlock++ )
+    {
+        // The bottom most partial tiles and strips are sometimes only
+        // partially encoded (#1179)
+        int nBlockReqSize = nBlockBufSize;
+        if( static_cast<int>((iYBlock+1) * nBlockYSize) > nRasterYSize )
+        {
+            nBlockReqSize = (nBlockBufSize / nBlockYSize)
+                * (nBlockYSize - (((iYBlock+1) * nBlockYSize) % nRasterYSize));
+        }
+
+        for( int iXBlock = nBlockX1; iXBlock <= nBlockX2; iXBlock++ )
+        {
+            for( int iJob = 0; iJob < nJobsPerBlock; iJob++ )
+            {
+                int nBlockId = iXBlock + iYBlock * nBlocksPerRow;
+                if( !bInterleaved && nPlanarConfig == PLANARCONFIG_SEPARATE )
+                    nBlockId += (panBandMap[iJob] - 1) * nBlocksPerBand;
+                if( !IsBlockAvailable(nBlockId) )
+                    continue;
+
+                GDALRasterBlock** papoJobBlocks = &apoBlocks[
+                    asJobs.size() * nBandsPerJob];
+                int nNewBlocks = 0;
+                for( int i = 0; i < nBandsPerJob; i++ )
+                {
+                    GTiffRasterBand* poBand = static_cast<GTiffRasterBand*>(
+                        GetRasterBand(bInterleaved ? i + 1 : panBandMap[iJob]));
+                    GDALRasterBlock* poBlock =
+                        poBand->TryGetLockedBlockRef(iXBlock, iYBlock);
+                    if( poBlock != NULL )
+                    {
+                        poBlock->DropLock();
+                        continue;
+                    }
+                    poBlock = poBand->GetLockedBlockRef(iXBlock, iYBlock, TRUE);
+                    if( poBlock == NULL )
+                        continue;
+                    papoJobBlocks[i] = poBlock;
+                    nNewBlocks ++;
+                }
+                if( nNewBlocks == 0 )
+                    continue;
+
+                GTiffDecodeJob sJob;
+                sJob.poDS = this;
+                sJob.nBlockId = nBlockId;
+                sJob.nBlockBufSize = nBlockBufSize;
+                sJob.nBlockReqSize = nBlockReqSize;
+                sJob.papoBlocks = papoJobBlocks;
+                sJob.nBlocks = nBandsPerJob;
+                sJob.bSuccess = FALSE;
+                asJobs.push_back(sJob);
+            }
+        }
+    }
+
+    if( asJobs.empty() )
+        return;
+
+/* -------------------------------------------------------------------- */
+/*      Decode, and release the blocks. The blocks of failed jobs are   */
+/*      removed from the cache, so that they are read again, and the    */
+/*      error reported, by the regular code path.                       */
+/* -------------------------------------------------------------------- */
+    for( size_t i = 0; i < asJobs.size(); i++ )
+        poPool->SubmitJob(ThreadDecodeFunc, &asJobs[i]);
+    poPool->WaitCompletion();
+
+    for( size_t i = 0; i < asJobs.size(); i++ )
+    {
+        for( int j = 0; j < asJobs[i].nBlocks; j++ )
+        {
+            GDALRasterBlock* poBlock = asJobs[i].papoBlocks[j];
+            if( poBlock == NULL )
+                continue;
+            const int nXBlockOff = poBlock->GetXOff();
+            const int nYBlockOff = poBlock->GetYOff();
+            GDALRasterBand* poBand = poBlock->GetBand();
+            poBlock->DropLock();
+            if( !asJobs[i].bSuccess )
+                poBand->FlushBlock(nXBlockOff, nYBlockOff, FALSE);
+        }
+    }
+}
+
+/************************************************************************/
+/*                          CacheMultiRange()                           */
+/************************************************************************/
+
+/* Read in memory, with as few I/O requests as possible, the strips or    */
+/* tiles that intersect a read request and are not yet in the block       */
+/* cache. The byte ranges of neighbouring blocks are merged when the gap  */
+/* between them is not larger than the MULTIRANGE_MAX_GAP open option, or */
+/* the GTIFF_MULTIRANGE_MAX_GAP configuration option (65536 bytes by      */
+/* default). Libtiff then reads the blocks from memory, until             */
+/* ClearMultiRangeCache() is called. Returns true if ranges were cached.  */
+
+bool GTiffDataset::CacheMultiRange( int nXOff, int nYOff,
+                                    int nXSize, int nYSize,
+                                    int nBandCount, int *panBandMap )
+{
+    if( eAccess != GA_ReadOnly || bStreamingIn || nBands == 0 ||
+        bTreatAsSplit || bTreatAsSplitBitmap ||
+        !apMultiRangeData.empty() )
+        return false;
+
+    const GTiffDataset* poRootDS = this;
+    while( poRootDS->poBaseDS != NULL )
+        poRootDS = poRootDS->poBaseDS;
+    const int nMaxGap = poRootDS->nMultiRangeMaxGap;
+    if( nMaxGap < 0 )
+        return false;
+
+    const int nBlockX1 = nXOff / nBlockXSize;
+    const int nBlockY1 = nYOff / nBlockYSize;
+    const int nBlockX2 = (nXOff + nXSize - 1) / nBlockXSize;
+    const int nBlockY2 = (nYOff + nYSize - 1) / nBlockYSize;
+    if( nBlockX1 == nBlockX2 && nBlockY1 == nBlockY2 )
+        return false;
+
+    if( !SetDirectory() )
+        return false;
+
+/* -------------------------------------------------------------------- */
+/*      Collect the byte ranges of the blocks that must be read.        */
+/* -------------------------------------------------------------------- */
+    const bool bSeparate = nPlanarConfig == PLANARCONFIG_SEPARATE;
+    const int nBlocksPerRow = DIV_ROUND_UP(nRasterXSize, nBlockXSize);
+    const int nCheckedBands = bSeparate ? nBandCount : nBands;
+    std::vector< std::pair<vsi_l_offset, vsi_l_offset> > aoRanges;
+
+    for( int iYBlock = nBlockY1; iYBlock <= nBlockY2; iYBlock++ )
+    {
+        for( int iXBlock = nBlockX1; iXBlock <= nBlockX2; iXBlock++ )
+        {
+            for( int i = 0; i < (bSeparate ? nBandCount : 1); i++ )
+            {
+                int nBlockId = iXBlock + iYBlock * nBlocksPerRow;
+                if( bSeparate )
+                    nBlockId += (panBandMap[i] - 1) * nBlocksPerBand;
+                if( nBlockId == nLoadedBlock )
+                    continue;
+
+                // Skip the blocks whose content is already cached
+                bool bCached = true;
+                for( int j = 0; bCached && j < (bSeparate ? 1 : nCheckedBands); j++ )
+                {
+                    GTiffRasterBand* poBand = static_cast<GTiffRasterBand*>(
+                        GetRasterBand(bSeparate ? panBandMap[i] : j + 1));
+                    GDALRasterBlock* poBlock =
+                        poBand->TryGetLockedBlockRef(iXBlock, iYBlock);
+                    if( poBlock == NULL )
+                        bCached = false;
+                    else
+                        poBlock->DropLock();
+                }
+                if( bCached )
+                    continue;
+
+                vsi_l_offset nOffset = 0;
+                vsi_l_offset nSize = 0;
+                if( !IsBlockAvailable(nBlockId, &nOffset, &nSize) )
+                    continue;
+                aoRanges.push_back(
+                    std::pair<vsi_l_offset, vsi_l_offset>(nOffset, nSize));
+            }
+        }
+    }
+    if( aoRanges.size() < 2 )
+        return false;
+
+/* -------------------------------------------------------------------- */
+/*      Merge the ranges that are close to each other, and read them.   */
+/*      The amount of data read in memory is capped to half of the      */
+/*      block cache size (or quota), and the blocks that do not fit are */
+/*      read from the file as usual.                                    */
+/* -------------------------------------------------------------------- */
+    std::sort(aoRanges.begin(), aoRanges.end());
+
+    const GIntBig nCacheMax = GetBlockCacheQuota() > 0 ?
+                        GetBlockCacheQuota() : GDALGetCacheMax64();
+    GIntBig nRemainingMem = nCacheMax / 2;
+
+    VSILFILE* fp = VSI_TIFFGetVSILFile(TIFFClientdata(hTIFF));
+    const vsi_l_offset nCurOffset = VSIFTellL(fp);
+    size_t iRange = 0;
+    while( iRange < aoRanges.size() )
+    {
+        const vsi_l_offset nStart = aoRanges[iRange].first;
+        vsi_l_offset nEnd = nStart + aoRanges[iRange].second;
+        size_t iNext = iRange + 1;
+        while( iNext < aoRanges.size() &&
+               aoRanges[iNext].first <= nEnd + nMaxGap )
+        {
+            nEnd = std::max(nEnd, aoRanges[iNext].first + aoRanges[iNext].second);
+            iNext ++;
+        }
+        iRange = iNext;
+
+        const vsi_l_offset nSize = nEnd - nStart;
+        if( static_cast<GIntBig>(nSize) > nRemainingMem ||
+            nSize != static_cast<size_t>(nSize) )
+            break;
+        void* pData = VSI_MALLOC_VERBOSE(static_cast<size_t>(nSize));
+        if( pData == NULL )
+            break;
+        if( VSIFSeekL(fp, nStart, SEEK_SET) != 0 ||
+            VSIFReadL(pData, 1, static_cast<size_t>(nSize), fp) != nSize )
+        {
+            // Let the regular code path report the error
+            VSIFree(pData);
+            continue;
+        }
+        nRemainingMem -= nSize;
+        apMultiRangeData.push_back(pData);
+        anMultiRangeOffsets.push_back(nStart);
+        anMultiRangeSizes.push_back(static_cast<size_t>(nSize));
+    }
+    CPL_IGNORE_RET_VAL(VSIFSeekL(fp, nCurOffset, SEEK_SET));
+
+    if( apMultiRangeData.empty() )
+        return false;
+
+    CPLDebug("GTiff", "Read %d blocks with %d I/O requests",
+             static_cast<int>(aoRanges.size()),
+             static_cast<int>(apMultiRangeData.size()));
+    VSI_TIFFSetCachedRanges( TIFFClientdata(hTIFF),
+                             static_cast<int>(apMultiRangeData.size()),
+                             &apMultiRangeData[0],
+                             &anMultiRangeOffsets[0],
+                             &anMultiRangeSizes[0] );
+    return true;
+}
+
+/************************************************************************/
+/*                        ClearMultiRangeCache()                        */
+/************************************************************************/
+
+void GTiffDataset::ClearMultiRangeCache()
+{
+    VSI_TIFFSetCachedRanges( TIFFClientdata(hTIFF), 0, NULL, NULL, NULL );
+    for( size_t i = 0; i < apMultiRangeData.size(); i++ )
+        VSIFree(apMultiRangeData[i]);
+    apMultiRangeData.clear();
+    anMultiRangeOffsets.clear();
+    anMultiRangeSizes.clear();
+}
+
 /************************************************************************/
 /*                        FetchBufferVirtualMemIO                       */
 /************************************************************************/
@@ -3574,6 +4128,16 @@ CPLErr GTiffRasterBand::IRasterIO( GDALRWFlag eRWFlag,
         }
     }
 
+    bool bMultiRangeCached = false;
+    if( eRWFlag == GF_Read && nXSize == nBufXSize && nYSize == nBufYSize )
+    {
+        bMultiRangeCached = poGDS->CacheMultiRange( nXOff, nYOff,
+                                                    nXSize, nYSize,
+                                                    1, &nBand );
+        poGDS->CacheBlocksMultiThreaded( nXOff, nYOff, nXSize, nYSize,
+                                         1, &nBand );
+    }
+
     poGDS->nJPEGOverviewVisibilityFlag ++;
     eErr = GDALPamRasterBand::IRasterIO(eRWFlag, nXOff, nYOff, nXSize, nYSize,
                                         pData, nBufXSize, nBufYSize, eBufType,
@@ -3582,6 +4146,9 @@ CPLErr GTiffRasterBand::IRasterIO( GDALRWFlag eRWFlag,
 
     poGDS->bLoadingOtherBands = FALSE;
 
+    if( bMultiRangeCached )
+        poGDS->ClearMultiRangeCache();
+
     return eErr;
 }
 
@@ -3660,13 +4227,24 @@ CPLErr GTiffRasterBand::IReadBlock( int nBlockXOff, int nBlockYOff,
 /* -------------------------------------------------------------------- */
 /*      Handle simple case (separate, onesampleperpixel)                */
 /* -------------------------------------------------------------------- */
+    const GByte *pabyBlockView = NULL;
+    if( nBlockId != poGDS->nLoadedBlock &&
+        poGDS->nBitsPerSample == GDALGetDataTypeSize(eDataType) )
+    {
+        pabyBlockView = poGDS->GetBlockReadView( nBlockId, nBlockReqSize );
+    }
+
     if( poGDS->nBands == 1
         || poGDS->nPlanarConfig == PLANARCONFIG_SEPARATE )
     {
         if( nBlockReqSize < nBlockBufSize )
             memset( pImage, 0, nBlockBufSize );
 
-        if( TIFFIsTiled( poGDS->hTIFF ) )
+        if( pabyBlockView != NULL )
+        {
+            memcpy( pImage, pabyBlockView, nBlockReqSize );
+        }
+        else if( TIFFIsTiled( poGDS->hTIFF ) )
         {
             if( TIFFReadEncodedTile( poGDS->hTIFF, nBlockId, pImage,
                                      nBlockReqSize ) == -1
@@ -3696,6 +4274,30 @@ CPLErr GTiffRasterBand::IReadBlock( int nBlockXOff, int nBlockYOff,
         return eErr;
     }
 
+    int nWordBytes = poGDS->nBitsPerSample / 8;
+
+/* -------------------------------------------------------------------- */
+/*      Pixel interleaved data that can be accessed in place: extract   */
+/*      our band from it, without loading the block buffer.  The        */
+/*      other bands will do the same from FillCacheForOtherBands().     */
+/* -------------------------------------------------------------------- */
+    if( pabyBlockView != NULL )
+    {
+        const int nPixelBytes = poGDS->nBands * nWordBytes;
+        const int nReqPixels = nBlockReqSize / nPixelBytes;
+        GDALCopyWords(pabyBlockView + (nBand - 1) * nWordBytes, eDataType,
+                      nPixelBytes,
+                      pImage, eDataType, nWordBytes,
+                      nReqPixels);
+        if( nReqPixels < nBlockXSize * nBlockYSize )
+        {
+            memset( static_cast<GByte*>(pImage) + nReqPixels * nWordBytes, 0,
+                    (nBlockXSize * nBlockYSize - nReqPixels) * nWordBytes );
+        }
+
+        return FillCacheForOtherBands(nBlockXOff, nBlockYOff);
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Load desired block                                              */
 /* -------------------------------------------------------------------- */
@@ -3747,7 +4349,6 @@ CPLErr GTiffRasterBand::IReadBlock( int nBlockXOff, int nBlockYOff,
     }
 #endif
 
-    int nWordBytes = poGDS->nBitsPerSample / 8;
     GByte* pabyImage = poGDS->pabyBlockBuf + (nBand - 1) * nWordBytes;
 
     GDALCopyWords(pabyImage, eDataType, poGDS->nBands * nWordBytes,
@@ -6133,6 +6734,10 @@ GTiffDataset::GTiffDataset() :
     papszMetadataFiles = NULL;
     poCompressThreadPool = NULL;
     hCompressThreadPoolMutex = NULL;
+    nDecodeThreads = -1;
+    poDecodeThreadPool = NULL;
+    hDecodeHandlesMutex = NULL;
+    nMultiRangeMaxGap = 65536;
 
     m_pTempBufferForCommonDirectIO = NULL;
     m_nTempBufferForCommonDirectIOSize = 0;
@@ -6224,6 +6829,20 @@ int GTiffDataset::Finalize()
         CPLDestroyMutex(hCompressThreadPoolMutex);
     }
 
+    // Destroy decoding pool and handles. No job can be pending since
+    // CacheBlocksMultiThreaded() waits for their completion.
+    delete poDecodeThreadPool;
+    poDecodeThreadPool = NULL;
+    for( size_t i = 0; i < asDecodeHandles.size(); ++i )
+    {
+        XTIFFClose( asDecodeHandles[i].hTIFF );
+        CPL_IGNORE_RET_VAL(VSIFCloseL( asDecodeHandles[i].fpL ));
+    }
+    asDecodeHandles.clear();
+    if( hDecodeHandlesMutex )
+        CPLDestroyMutex(hDecodeHandlesMutex);
+    hDecodeHandlesMutex = NULL;
+
 /* -------------------------------------------------------------------- */
 /*      If there is still changed metadata, then presumably we want     */
 /*      to push it into PAM.                                            */
@@ -6807,6 +7426,11 @@ void GTiffDataset::InitCreationOrOpenOptions(char** papszOptions)
     InitCompressionThreads(papszOptions);
 
     eGeoTIFFKeysFlavor = GetGTIFFKeysFlavor(papszOptions);
+
+    const char* pszMaxGap = CSLFetchNameValue(papszOptions, "MULTIRANGE_MAX_GAP");
+    if( pszMaxGap == NULL )
+        pszMaxGap = CPLGetConfigOption("GTIFF_MULTIRANGE_MAX_GAP", "65536");
+    nMultiRangeMaxGap = atoi(pszMaxGap);
 }
 
 /************************************************************************/
@@ -7567,9 +8191,13 @@ void GTiffCacheOffsetOrCount(VSILFILE* fp,
 /*      Return TRUE if the indicated strip/tile is available.  We       */
 /*      establish this by testing if the stripbytecount is zero.  If    */
 /*      zero then the block has never been committed to disk.           */
+/*      The offset and size of the block in the file are optionally     */
+/*      returned.                                                       */
 /************************************************************************/
 
-int GTiffDataset::IsBlockAvailable( int nBlockId )
+int GTiffDataset::IsBlockAvailable( int nBlockId,
+                                    vsi_l_offset* pnOffset,
+                                    vsi_l_offset* pnSize )
 
 {
 #ifdef INTERNAL_LIBTIFF
@@ -7675,26 +8303,83 @@ int GTiffDataset::IsBlockAvailable( int nBlockId )
                 return FALSE;
             }
         }
+        if( pnOffset )
+            *pnOffset = hTIFF->tif_dir.td_stripoffset[nBlockId];
+        if( pnSize )
+            *pnSize = hTIFF->tif_dir.td_stripbytecount[nBlockId];
         return hTIFF->tif_dir.td_stripbytecount[nBlockId] != 0;
     }
 #endif /* DEFER_STRILE_LOAD */
 #endif /* INTERNAL_LIBTIFF */
     toff_t *panByteCounts = NULL;
+    toff_t *panOffsets = NULL;
+    const bool bIsTiled = CPL_TO_BOOL( TIFFIsTiled(hTIFF) );
 
-    if( ( TIFFIsTiled( hTIFF )
-          && TIFFGetField( hTIFF, TIFFTAG_TILEBYTECOUNTS, &panByteCounts ) )
-        || ( !TIFFIsTiled( hTIFF )
-          && TIFFGetField( hTIFF, TIFFTAG_STRIPBYTECOUNTS, &panByteCounts ) ) )
+    if( ( bIsTiled
+          && TIFFGetField( hTIFF, TIFFTAG_TILEBYTECOUNTS, &panByteCounts )
+          && (pnOffset == NULL ||
+              TIFFGetField( hTIFF, TIFFTAG_TILEOFFSETS, &panOffsets )) )
+        || ( !bIsTiled
+          && TIFFGetField( hTIFF, TIFFTAG_STRIPBYTECOUNTS, &panByteCounts )
+          && (pnOffset == NULL ||
+              TIFFGetField( hTIFF, TIFFTAG_STRIPOFFSETS, &panOffsets )) ) )
     {
-        if( panByteCounts == NULL )
+        if( panByteCounts == NULL || (pnOffset != NULL && panOffsets == NULL) )
             return FALSE;
-        else
-            return panByteCounts[nBlockId] != 0;
+        if( pnOffset )
+            *pnOffset = panOffsets[nBlockId];
+        if( pnSize )
+            *pnSize = panByteCounts[nBlockId];
+        return panByteCounts[nBlockId] != 0;
     }
     else
         return FALSE;
 }
 
+/************************************************************************/
+/*                          GetBlockReadView()                          */
+/*                                                                      */
+/*      Return a pointer to the content of an uncompressed strip/tile   */
+/*      whose on-disk layout is the decoded one, if the file handle     */
+/*      can expose it (see VSIFGetReadViewL()). NULL otherwise.         */
+/************************************************************************/
+
+const GByte *GTiffDataset::GetBlockReadView( int nBlockId, int nBlockReqSize )
+
+{
+    if( eAccess != GA_ReadOnly || bStreamingIn ||
+        nCompression != COMPRESSION_NONE ||
+        !(nPhotometric == PHOTOMETRIC_MINISBLACK ||
+          nPhotometric == PHOTOMETRIC_RGB ||
+          nPhotometric == PHOTOMETRIC_PALETTE) ||
+        (nBitsPerSample % 8) != 0 ||
+        TIFFIsByteSwapped(hTIFF) )
+    {
+        return NULL;
+    }
+
+    uint16 nFillOrder = FILLORDER_MSB2LSB;
+    TIFFGetFieldDefaulted( hTIFF, TIFFTAG_FILLORDER, &nFillOrder );
+    if( nFillOrder != FILLORDER_MSB2LSB )
+        return NULL;
+
+    vsi_l_offset nOffset = 0;
+    vsi_l_offset nSize = 0;
+    if( !IsBlockAvailable( nBlockId, &nOffset, &nSize ) ||
+        nSize < static_cast<vsi_l_offset>(nBlockReqSize) )
+        return NULL;
+
+    // Overviews and masks share the file handle of their base dataset
+    const GTiffDataset* poRootDS = this;
+    while( poRootDS->fpL == NULL && poRootDS->poBaseDS != NULL )
+        poRootDS = poRootDS->poBaseDS;
+    if( poRootDS->fpL == NULL )
+        return NULL;
+
+    return static_cast<const GByte *>(
+        VSIFGetReadViewL( poRootDS->fpL, nOffset, nBlockReqSize ) );
+}
+
 /************************************************************************/
 /*                             FlushCache()                             */
 /*                                                                      */
@@ -15593,6 +16278,7 @@ void GDALRegister_GTiff()
     poDriver->SetMetadataItem( GDAL_DMD_OPENOPTIONLIST,
 "<OpenOptionList>"
 "   <Option name='NUM_THREADS' type='string' description='Number of worker threads for compression. Can be set to ALL_CPUS' default='1'/>"
+"   <Option name='MULTIRANGE_MAX_GAP' type='int' description='Maximum gap, in bytes, between strips or tiles whose reads are merged. A negative value disables multi-range reads' default='65536'/>"
 "   <Option name='GEOTIFF_KEYS_FLAVOR' type='string-select' default='STANDARD' description='Which flavor of GeoTIFF keys must be used (for writing)'>"
 "       <Value>STANDARD</Value>"
 "       <Value>ESRI_PE</Value>"
@@ -64,12 +64,46 @@ typedef struct
     vsi_l_offset nExpectedPos;
     GByte      *abyWriteBuffer;
     int         nWriteBufferSize;
+
+    // Ranges of the file already read in memory, sorted by offset
+    int           nCachedRanges;
+    void        **ppCachedData;
+    const vsi_l_offset *panCachedOffsets;
+    const size_t *panCachedSizes;
 } GDALTiffHandle;
 
 static tsize_t
 _tiffReadProc(thandle_t th, tdata_t buf, tsize_t size)
 {
     GDALTiffHandle* psGTH = (GDALTiffHandle*) th;
+    if( psGTH->nCachedRanges > 0 && size > 0 )
+    {
+        const vsi_l_offset nCurOffset = VSIFTellL( psGTH->fpL );
+
+        // Find the last range that starts at or before the current offset
+        int iLow = 0;
+        int iHigh = psGTH->nCachedRanges - 1;
+        while( iLow < iHigh )
+        {
+            const int iMid = (iLow + iHigh + 1) / 2;
+            if( psGTH->panCachedOffsets[iMid] <= nCurOffset )
+                iLow = iMid;
+            else
+                iHigh = iMid - 1;
+        }
+
+        const vsi_l_offset nRangeOffset = psGTH->panCachedOffsets[iLow];
+        if( nRangeOffset <= nCurOffset &&
+            nCurOffset + size <= nRangeOffset + psGTH->panCachedSizes[iLow] )
+        {
+            memcpy( buf,
+                    static_cast<GByte*>(psGTH->ppCachedData[iLow]) +
+                        static_cast<size_t>(nCurOffset - nRangeOffset),
+                    size );
+            if( VSIFSeekL( psGTH->fpL, nCurOffset + size, SEEK_SET ) == 0 )
+                return size;
+        }
+    }
     return VSIFReadL( buf, 1, size, psGTH->fpL );
 }
 
@@ -229,6 +263,24 @@ VSILFILE* VSI_TIFFGetVSILFile(thandle_t th)
     return psGTH->fpL;
 }
 
+/*
+ * Serve the reads that fall entirely within one of the ranges from memory.
+ * The arrays are not copied and must remain valid until the ranges are
+ * reset with nRanges = 0. The ranges must be sorted by increasing offset
+ * and must not overlap.
+ */
+void VSI_TIFFSetCachedRanges(thandle_t th, int nRanges,
+                             void** ppData,
+                             const vsi_l_offset* panOffsets,
+                             const size_t* panSizes)
+{
+    GDALTiffHandle* psGTH = (GDALTiffHandle*) th;
+    psGTH->nCachedRanges = nRanges;
+    psGTH->ppCachedData = ppData;
+    psGTH->panCachedOffsets = panOffsets;
+    psGTH->panCachedSizes = panSizes;
+}
+
 int VSI_TIFFFlushBufferedWrite(thandle_t th)
 {
     GDALTiffHandle* psGTH = (GDALTiffHandle*) th;
@@ -280,6 +332,10 @@ TIFF* VSI_TIFFOpen(const char* name, const char* mode,
     psGTH->bAtEndOfFile = FALSE;
     psGTH->abyWriteBuffer = (bAllocBuffer) ? (GByte*)VSIMalloc(BUFFER_SIZE) : NULL;
     psGTH->nWriteBufferSize = 0;
+    psGTH->nCachedRanges = 0;
+    psGTH->ppCachedData = NULL;
+    psGTH->panCachedOffsets = NULL;
+    psGTH->panCachedSizes = NULL;
 
     tif = XTIFFClientOpen(name, mode,
                           (thandle_t) psGTH,
@@ -383,6 +383,31 @@ CPLErr RawRasterBand::IReadBlock( CPL_UNUSED int nBlockXOff,
     if (pLineBuffer == NULL)
         return CE_Failure;
 
+/* -------------------------------------------------------------------- */
+/*      If the file handle exposes the line content, copy from it       */
+/*      directly rather than reading it into the line buffer.           */
+/* -------------------------------------------------------------------- */
+    if( nLoadedScanline != nBlockYOff )
+    {
+        const size_t nLineStartOffset =
+            reinterpret_cast<GByte *>( pLineStart ) -
+            reinterpret_cast<GByte *>( pLineBuffer );
+        const vsi_l_offset nReadStart =
+            nImgOffset + (vsi_l_offset)nBlockYOff * nLineOffset
+            - nLineStartOffset;
+        const size_t nBytesToRead = std::abs(nPixelOffset) * (nBlockXSize - 1)
+            + GDALGetDataTypeSizeBytes(eDataType);
+        const GByte *pabyView = GetReadView( nReadStart, nBytesToRead );
+        if( pabyView != NULL )
+        {
+            GDALCopyWords( pabyView + nLineStartOffset, eDataType, nPixelOffset,
+                           pImage, eDataType,
+                           GDALGetDataTypeSizeBytes(eDataType),
+                           nBlockXSize );
+            return CE_None;
+        }
+    }
+
     const CPLErr eErr = AccessLine( nBlockYOff );
     if( eErr == CE_Failure )
         return eErr;
@@ -740,15 +765,20 @@ CPLErr RawRasterBand::IRasterIO( GDALRWFlag eRWFlag,
                           + static_cast<vsi_l_offset>( iLine * dfSrcYInc ) )
                          * nLineOffset )
                     + nXOff * nPixelOffset;
-                if ( AccessBlock( nOffset,
-                                  nBytesToRW, pabyData ) != CE_None )
+                const GByte *pabySrc = GetReadView( nOffset, nBytesToRW );
+                if( pabySrc == NULL )
                 {
-                    CPLError( CE_Failure, CPLE_FileIO,
-                              "Failed to read " CPL_FRMT_GUIB
-                              " bytes at " CPL_FRMT_GUIB ".",
-                              static_cast<GUIntBig>(nBytesToRW), nOffset );
-                    CPLFree( pabyData );
-                    return CE_Failure;
+                    if ( AccessBlock( nOffset,
+                                      nBytesToRW, pabyData ) != CE_None )
+                    {
+                        CPLError( CE_Failure, CPLE_FileIO,
+                                  "Failed to read " CPL_FRMT_GUIB
+                                  " bytes at " CPL_FRMT_GUIB ".",
+                                  static_cast<GUIntBig>(nBytesToRW), nOffset );
+                        CPLFree( pabyData );
+                        return CE_Failure;
+                    }
+                    pabySrc = pabyData;
                 }
 
 /* -------------------------------------------------------------------- */
@@ -757,7 +787,7 @@ CPLErr RawRasterBand::IRasterIO( GDALRWFlag eRWFlag,
 /* -------------------------------------------------------------------- */
                 if ( nXSize == nBufXSize && nYSize == nBufYSize )
                 {
-                    GDALCopyWords( pabyData, eDataType, nPixelOffset,
+                    GDALCopyWords( pabySrc, eDataType, nPixelOffset,
                                    reinterpret_cast<GByte *>( pData ) +
                                    static_cast<vsi_l_offset>( iLine ) *
                                    nLineSpace,
@@ -769,7 +799,7 @@ CPLErr RawRasterBand::IRasterIO( GDALRWFlag eRWFlag,
                     for ( int iPixel = 0; iPixel < nBufXSize; iPixel++ )
                     {
                         GDALCopyWords(
-                            pabyData +
+                            pabySrc +
                             static_cast<vsi_l_offset>( iPixel * dfSrcXInc ) *
                             nPixelOffset,
                             eDataType, nPixelOffset,
@@ -1060,6 +1090,23 @@ size_t RawRasterBand::Write( void *pBuffer, size_t nSize, size_t nCount )
     return VSIFWrite( pBuffer, nSize, nCount, fpRaw );
 }
 
+/************************************************************************/
+/*                            GetReadView()                             */
+/*                                                                      */
+/*      Return a pointer to the file content of the given range, if     */
+/*      the handle can expose it and no byte swapping is needed.        */
+/************************************************************************/
+
+const GByte *RawRasterBand::GetReadView( vsi_l_offset nOffset, size_t nSize )
+
+{
+    if( !bIsVSIL || (!bNativeOrder && eDataType != GDT_Byte) )
+        return NULL;
+
+    return static_cast<const GByte *>(
+        VSIFGetReadViewL( fpRawL, nOffset, nSize ) );
+}
+
 /************************************************************************/
 /*                          StoreNoDataValue()                          */
 /*                                                                      */
@@ -105,6 +105,7 @@ protected:
     int         Seek( vsi_l_offset, int );
     size_t      Read( void *, size_t, size_t );
     size_t      Write( void *, size_t, size_t );
+    const GByte *GetReadView( vsi_l_offset nOffset, size_t nSize );
 
     CPLErr      AccessBlock( vsi_l_offset nBlockOff, size_t nBlockSize,
                              void * pData );
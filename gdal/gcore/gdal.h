@@ -740,6 +740,12 @@ CPLErr CPL_DLL CPL_STDCALL GDALComputeRasterStatistics(
     GDALRasterBandH, int bApproxOK,
     double *pdfMin, double *pdfMax, double *pdfMean, double *pdfStdDev,
     GDALProgressFunc pfnProgress, void *pProgressData );
+CPLErr CPL_DLL CPL_STDCALL GDALComputeRasterStatisticsAndHistogram(
+    GDALRasterBandH, int bApproxOK,
+    double *pdfMin, double *pdfMax, double *pdfMean, double *pdfStdDev,
+    double dfHistMin, double dfHistMax, int nBuckets, GUIntBig *panHistogram,
+    int bIncludeOutOfRange,
+    GDALProgressFunc pfnProgress, void *pProgressData );
 CPLErr CPL_DLL CPL_STDCALL GDALSetRasterStatistics(
     GDALRasterBandH hBand,
     double dfMin, double dfMax, double dfMean, double dfStdDev );
@@ -1059,6 +1065,35 @@ int CPL_DLL CPL_STDCALL GDALGetCacheUsed(void);
 void CPL_DLL CPL_STDCALL GDALSetCacheMax64( GIntBig nBytes );
 GIntBig CPL_DLL CPL_STDCALL GDALGetCacheMax64(void);
 GIntBig CPL_DLL CPL_STDCALL GDALGetCacheUsed64(void);
+void CPL_DLL CPL_STDCALL GDALGetCacheCounters( GIntBig *pnHits,
+                                               GIntBig *pnMisses,
+                                               GIntBig *pnEvictions );
+void CPL_DLL CPL_STDCALL GDALResetCacheCounters(void);
+
+/** Block cache statistics of a dataset or a raster band.
+ * @see GDALDatasetGetCacheStatistics(), GDALGetRasterCacheStatistics()
+ * @since GDAL 2.2
+ */
+typedef struct
+{
+    /** Number of bytes of the blocks held in the cache */
+    GIntBig nBytesUsed;
+    /** Number of blocks held in the cache */
+    GIntBig nBlocks;
+    /** Number of requested blocks that were found in the cache */
+    GIntBig nHits;
+    /** Number of requested blocks that had to be added to the cache */
+    GIntBig nMisses;
+    /** Number of blocks removed from the cache to make room for others */
+    GIntBig nEvictions;
+} GDALCacheStatistics;
+
+void CPL_DLL GDALDatasetSetCacheQuota( GDALDatasetH hDS, GIntBig nQuotaInBytes );
+GIntBig CPL_DLL GDALDatasetGetCacheQuota( GDALDatasetH hDS );
+void CPL_DLL GDALDatasetGetCacheStatistics( GDALDatasetH hDS,
+                                            GDALCacheStatistics* psStats );
+void CPL_DLL GDALGetRasterCacheStatistics( GDALRasterBandH hBand,
+                                           GDALCacheStatistics* psStats );
 
 int CPL_DLL CPL_STDCALL GDALFlushCacheBlock(void);
 
@@ -50,6 +50,7 @@ class GDALRasterAttributeTable;
 class GDALProxyDataset;
 class GDALProxyRasterBand;
 class GDALAsyncReader;
+struct GDALRasterBlockCacheShard;
 
 /* -------------------------------------------------------------------- */
 /*      Pull in the public declarations.  This gets the C apis, and     */
@@ -414,6 +415,8 @@ class CPL_DLL GDALDataset : public GDALMajorObject
     int          AcquireMutex();
     void         ReleaseMutex();
 
+    GDALRasterBlockCacheShard* GetBlockCachePartition();
+
   public:
     virtual     ~GDALDataset();
 
@@ -424,6 +427,10 @@ class CPL_DLL GDALDataset : public GDALMajorObject
 
     virtual void FlushCache(void);
 
+    void        SetBlockCacheQuota( GIntBig nQuotaInBytes );
+    GIntBig     GetBlockCacheQuota();
+    void        GetBlockCacheStatistics( GDALCacheStatistics* psStats );
+
     virtual const char *GetProjectionRef(void);
     virtual CPLErr SetProjection( const char * );
 
@@ -596,8 +603,14 @@ class CPL_DLL GDALRasterBlock
 
     int                  bMustDetach;
 
+    int                  nList;          // block cache list, or -1
+    GUInt32              nListSeq;       // entry order in its list
+
     void        Detach_unlocked( void );
     void        Touch_unlocked( void );
+    bool        IsRecentlyTouched( const GDALRasterBlockCacheShard* poShard ) const;
+
+    GDALRasterBlockCacheShard* GetShard();
 
     void        RecycleFor( int nXOffIn, int nYOffIn );
 
@@ -647,6 +660,10 @@ class CPL_DLL GDALRasterBlock
     /* Should only be called by GDALDestroyDriverManager() */
     static void DestroyRBMutex();
 
+    /* Cache partitions used for block cache quotas. See GDALDataset::SetBlockCacheQuota() */
+    static GDALRasterBlockCacheShard* CreateCachePartition( GIntBig nQuotaInBytes );
+    static void DestroyCachePartition( GDALRasterBlockCacheShard* poPartition );
+
   private:
     CPL_DISALLOW_COPY_ASSIGN(GDALRasterBlock);
 };
@@ -699,6 +716,18 @@ class CPL_DLL GDALAbstractBandBlockCache
         CPLMutex         *hCondMutex;
         volatile int      nKeepAliveCounter;
 
+        // Cache statistics of the band, protected by hSpinLock, except
+        // nPendingHits which is atomically incremented and folded into
+        // nHits under the lock
+        int               nCachedBlocks;
+        volatile int      nPendingHits;
+        GIntBig           nHits;
+        GIntBig           nMisses;
+        GIntBig           nEvictions;
+
+        // Cache partition of the dataset when it has a quota, or NULL
+        GDALRasterBlockCacheShard* poCachePartition;
+
     protected:
         GDALRasterBand   *poBand;
 
@@ -713,6 +742,17 @@ class CPL_DLL GDALAbstractBandBlockCache
             GDALRasterBlock* CreateBlock(int nXBlockOff, int nYBlockOff);
             void             AddBlockToFreeList( GDALRasterBlock * );
 
+            void             AddCachedBlocks( int nDelta );
+            void             IncrementHits();
+            void             IncrementMisses();
+            void             IncrementEvictions();
+            void             GetStatistics( GDALCacheStatistics* psStats );
+
+            void             SetCachePartition( GDALRasterBlockCacheShard* poPartition )
+                                    { poCachePartition = poPartition; }
+            GDALRasterBlockCacheShard* GetCachePartition() const
+                                    { return poCachePartition; }
+
             virtual bool             Init() = 0;
             virtual bool             IsInitOK() = 0;
             virtual CPLErr           FlushCache() = 0;
@@ -748,6 +788,17 @@ class CPL_DLL GDALRasterBand : public GDALMajorObject
 
     void           Init(int bForceCachedIO);
 
+    CPLErr         ComputeStatisticsInternal( int bApproxOK,
+                                              double *pdfMin, double *pdfMax,
+                                              double *pdfMean,
+                                              double *pdfStdDev,
+                                              double dfHistMin,
+                                              double dfHistMax, int nBuckets,
+                                              GUIntBig *panHistogram,
+                                              int bIncludeOutOfRange,
+                                              GDALProgressFunc pfnProgress,
+                                              void *pProgressData );
+
   protected:
     GDALDataset *poDS;
     int         nBand; /* 1 based */
@@ -853,6 +904,7 @@ class CPL_DLL GDALRasterBand : public GDALMajorObject
     // New OpengIS CV_SampleDimension stuff.
 
     virtual CPLErr FlushCache();
+    void        GetBlockCacheStatistics( GDALCacheStatistics* psStats );
     virtual char **GetCategoryNames();
     virtual double GetNoDataValue( int *pbSuccess = NULL );
     virtual double GetMinimum( int *pbSuccess = NULL );
@@ -883,6 +935,14 @@ class CPL_DLL GDALRasterBand : public GDALMajorObject
     virtual CPLErr SetStatistics( double dfMin, double dfMax,
                                   double dfMean, double dfStdDev );
     virtual CPLErr ComputeRasterMinMax( int, double* );
+    CPLErr ComputeStatisticsAndHistogram( int bApproxOK,
+                                          double *pdfMin, double *pdfMax,
+                                          double *pdfMean, double *pdfStdDev,
+                                          double dfHistMin, double dfHistMax,
+                                          int nBuckets, GUIntBig *panHistogram,
+                                          int bIncludeOutOfRange,
+                                          GDALProgressFunc,
+                                          void *pProgressData );
 
     virtual int HasArbitraryOverviews();
     virtual int GetOverviewCount();
@@ -1149,6 +1209,14 @@ class CPL_DLL GDALDriverManager : public GDALMajorObject
     GDALDriver  *GetDriverByName_unlocked( const char * pszName )
             { return oMapNameToDrivers[CPLString(pszName).toupper()]; }
 
+    // Stubs of the drivers whose registration is deferred, and the function
+    // that registers each of them.
+    std::map<GDALDriver*, void (*)(void)> oMapDeferredDrivers;
+    int         nInsertionIndex;
+
+    void        LoadDeferredDriver( int iDriver );
+    void        LoadDeferredDriver( const char *pszDriverName );
+
  public:
                 GDALDriverManager();
                 ~GDALDriverManager();
@@ -1159,6 +1227,8 @@ class CPL_DLL GDALDriverManager : public GDALMajorObject
 
     int         RegisterDriver( GDALDriver * );
     void        DeregisterDriver( GDALDriver * );
+    void        DeclareDeferredDriver( const char *pszDriverName,
+                                       void (*pfnRegister)(void) );
 
     // AutoLoadDrivers is a no-op if compiled with GDAL_NO_AUTOLOAD defined.
     void        AutoLoadDrivers();
@@ -1169,6 +1239,10 @@ CPL_C_START
 GDALDriverManager CPL_DLL * GetGDALDriverManager( void );
 CPL_C_END
 
+void CPL_DLL GDALRegisterOrDeferDriver( bool bDeferred,
+                                        const char *pszDriverName,
+                                        void (*pfnRegister)(void) );
+
 /* ******************************************************************** */
 /*                          GDALAsyncReader                             */
 /* ******************************************************************** */
@@ -46,7 +46,13 @@ GDALAbstractBandBlockCache::GDALAbstractBandBlockCache(GDALRasterBand* poBandIn)
     psListBlocksToFree(NULL),
     hCond(CPLCreateCond()),
     hCondMutex(CPLCreateMutex()),
-    nKeepAliveCounter(0)
+    nKeepAliveCounter(0),
+    nCachedBlocks(0),
+    nPendingHits(0),
+    nHits(0),
+    nMisses(0),
+    nEvictions(0),
+    poCachePartition(NULL)
 {
     poBand = poBandIn;
     if( hCondMutex )
@@ -188,3 +194,77 @@ GDALRasterBlock* GDALAbstractBandBlockCache::CreateBlock(int nXBlockOff,
             poBand, nXBlockOff, nYBlockOff );
     return poBlock;
 }
+
+/************************************************************************/
+/*                           AddCachedBlocks()                          */
+/*                                                                      */
+/*      Called by GDALRasterBlock when a block of the band starts or    */
+/*      stops being accounted in the block cache.                       */
+/************************************************************************/
+
+void GDALAbstractBandBlockCache::AddCachedBlocks( int nDelta )
+{
+    CPLLockHolderOptionalLockD(hSpinLock);
+    nCachedBlocks += nDelta;
+}
+
+/************************************************************************/
+/*                            IncrementHits()                           */
+/*                                                                      */
+/*      Called on every block cache hit, possibly from several threads, */
+/*      so avoid taking the lock unless the pending counter gets large. */
+/************************************************************************/
+
+void GDALAbstractBandBlockCache::IncrementHits()
+{
+    if( CPLAtomicInc(&nPendingHits) > (1 << 30) )
+    {
+        CPLLockHolderOptionalLockD(hSpinLock);
+        const int nPending = nPendingHits;
+        CPLAtomicAdd(&nPendingHits, -nPending);
+        nHits += nPending;
+    }
+}
+
+/************************************************************************/
+/*                           IncrementMisses()                          */
+/************************************************************************/
+
+void GDALAbstractBandBlockCache::IncrementMisses()
+{
+    CPLLockHolderOptionalLockD(hSpinLock);
+    nMisses ++;
+}
+
+/************************************************************************/
+/*                          IncrementEvictions()                        */
+/************************************************************************/
+
+void GDALAbstractBandBlockCache::IncrementEvictions()
+{
+    CPLLockHolderOptionalLockD(hSpinLock);
+    nEvictions ++;
+}
+
+/************************************************************************/
+/*                            GetStatistics()                           */
+/************************************************************************/
+
+void GDALAbstractBandBlockCache::GetStatistics( GDALCacheStatistics* psStats )
+{
+    int nBlockXSize, nBlockYSize;
+    poBand->GetBlockSize(&nBlockXSize, &nBlockYSize);
+    const GIntBig nBlockBytes = static_cast<GIntBig>(nBlockXSize) *
+        nBlockYSize * (GDALGetDataTypeSize(poBand->GetRasterDataType()) / 8);
+
+    CPLLockHolderOptionalLockD(hSpinLock);
+    const int nPending = nPendingHits;
+    CPLAtomicAdd(&nPendingHits, -nPending);
+    nHits += nPending;
+
+    psStats->nBlocks = nCachedBlocks;
+    psStats->nBytesUsed = nCachedBlocks * nBlockBytes;
+    psStats->nHits = nHits;
+    psStats->nMisses = nMisses;
+    psStats->nEvictions = nEvictions;
+}
@@ -80,9 +80,15 @@ class GDALDatasetPrivate
 #endif
         GDALAllowReadWriteMutexState eStateReadWriteMutex;
 
+        // Block cache partition when the dataset has a quota, or NULL
+        GDALRasterBlockCacheShard* poCachePartition;
+        GIntBig nCacheQuota;
+
         GDALDatasetPrivate() :
             hMutex(NULL),
-            eStateReadWriteMutex(RW_MUTEX_STATE_UNKNOWN) {}
+            eStateReadWriteMutex(RW_MUTEX_STATE_UNKNOWN),
+            poCachePartition(NULL),
+            nCacheQuota(0) {}
 
 };
 
@@ -333,6 +339,9 @@ GDALDataset::~GDALDataset()
     GDALDatasetPrivate* psPrivate = (GDALDatasetPrivate* )m_hPrivateData;
     if( psPrivate != NULL && psPrivate->hMutex != NULL )
         CPLDestroyMutex( psPrivate->hMutex );
+    // The bands, and thus their cached blocks, are gone by now
+    if( psPrivate != NULL )
+        GDALRasterBlock::DestroyCachePartition( psPrivate->poCachePartition );
     delete psPrivate;
 
     CSLDestroy( papszOpenOptions );
@@ -429,6 +438,200 @@ void CPL_STDCALL GDALFlushCache( GDALDatasetH hDS )
     ((GDALDataset *) hDS)->FlushCache();
 }
 
+/************************************************************************/
+/*                         SetBlockCacheQuota()                         */
+/************************************************************************/
+
+/**
+ * \brief Set a block cache quota for the dataset.
+ *
+ * When a quota is set, the blocks of the raster bands of the dataset are
+ * held in a cache partition of their own, whose size is bounded by the
+ * quota. Reading the dataset then only evicts blocks of the same dataset,
+ * and cannot evict the blocks of other datasets from the shared cache.
+ *
+ * The memory of the partition comes in addition to the shared cache, and
+ * is not accounted in GDALGetCacheMax64() nor in GDALGetCacheUsed64().
+ * The quota only applies to the bands of this dataset, not to the bands
+ * of overview datasets that may be managed by the driver.
+ *
+ * The cache of the dataset is flushed before changing the quota. This
+ * method should not be called while other threads access the dataset.
+ *
+ * The quota may also be set at opening time with the CACHE_QUOTA open
+ * option of GDALOpenEx(), in megabytes.
+ *
+ * This method is the same as the C function GDALDatasetSetCacheQuota().
+ *
+ * @param nQuotaInBytes maximum size in bytes of the cached blocks of the
+ * dataset, or 0 to use the shared cache again.
+ *
+ * @since GDAL 2.2
+ */
+
+void GDALDataset::SetBlockCacheQuota( GIntBig nQuotaInBytes )
+
+{
+    GDALDatasetPrivate* psPrivate = (GDALDatasetPrivate* )m_hPrivateData;
+    if( psPrivate == NULL )
+        return;
+    if( nQuotaInBytes < 0 )
+        nQuotaInBytes = 0;
+
+    FlushCache();
+
+    GDALRasterBlockCacheShard* poOldPartition = psPrivate->poCachePartition;
+    psPrivate->poCachePartition = NULL;
+    if( nQuotaInBytes > 0 )
+    {
+        psPrivate->poCachePartition =
+            GDALRasterBlock::CreateCachePartition(nQuotaInBytes);
+        if( psPrivate->poCachePartition == NULL )
+            nQuotaInBytes = 0;
+    }
+    psPrivate->nCacheQuota = nQuotaInBytes;
+
+    for( int i = 0; i < nBands && papoBands != NULL; i++ )
+    {
+        if( papoBands[i] != NULL && papoBands[i]->poBandBlockCache != NULL )
+        {
+            papoBands[i]->poBandBlockCache->SetCachePartition(
+                                            psPrivate->poCachePartition );
+        }
+    }
+
+    GDALRasterBlock::DestroyCachePartition( poOldPartition );
+}
+
+/************************************************************************/
+/*                       GDALDatasetSetCacheQuota()                     */
+/************************************************************************/
+
+/**
+ * \brief Set a block cache quota for the dataset.
+ *
+ * @see GDALDataset::SetBlockCacheQuota()
+ *
+ * @since GDAL 2.2
+ */
+
+void GDALDatasetSetCacheQuota( GDALDatasetH hDS, GIntBig nQuotaInBytes )
+
+{
+    VALIDATE_POINTER0( hDS, "GDALDatasetSetCacheQuota" );
+
+    ((GDALDataset *) hDS)->SetBlockCacheQuota(nQuotaInBytes);
+}
+
+/************************************************************************/
+/*                         GetBlockCacheQuota()                         */
+/************************************************************************/
+
+/**
+ * \brief Return the block cache quota of the dataset.
+ *
+ * This method is the same as the C function GDALDatasetGetCacheQuota().
+ *
+ * @return the quota in bytes, or 0 if the dataset uses the shared cache.
+ *
+ * @since GDAL 2.2
+ */
+
+GIntBig GDALDataset::GetBlockCacheQuota()
+
+{
+    GDALDatasetPrivate* psPrivate = (GDALDatasetPrivate* )m_hPrivateData;
+    return psPrivate ? psPrivate->nCacheQuota : 0;
+}
+
+/************************************************************************/
+/*                       GDALDatasetGetCacheQuota()                     */
+/************************************************************************/
+
+/**
+ * \brief Return the block cache quota of the dataset.
+ *
+ * @see GDALDataset::GetBlockCacheQuota()
+ *
+ * @since GDAL 2.2
+ */
+
+GIntBig GDALDatasetGetCacheQuota( GDALDatasetH hDS )
+
+{
+    VALIDATE_POINTER1( hDS, "GDALDatasetGetCacheQuota", 0 );
+
+    return ((GDALDataset *) hDS)->GetBlockCacheQuota();
+}
+
+/************************************************************************/
+/*                        GetBlockCachePartition()                      */
+/************************************************************************/
+
+GDALRasterBlockCacheShard* GDALDataset::GetBlockCachePartition()
+
+{
+    GDALDatasetPrivate* psPrivate = (GDALDatasetPrivate* )m_hPrivateData;
+    return psPrivate ? psPrivate->poCachePartition : NULL;
+}
+
+/************************************************************************/
+/*                       GetBlockCacheStatistics()                      */
+/************************************************************************/
+
+/**
+ * \brief Fetch block cache statistics of the dataset.
+ *
+ * The statistics are the sum of the statistics of the raster bands of the
+ * dataset, as returned by GDALRasterBand::GetBlockCacheStatistics().
+ *
+ * This method is the same as the C function GDALDatasetGetCacheStatistics().
+ *
+ * @param psStats structure to fill with the statistics.
+ *
+ * @since GDAL 2.2
+ */
+
+void GDALDataset::GetBlockCacheStatistics( GDALCacheStatistics* psStats )
+
+{
+    memset(psStats, 0, sizeof(GDALCacheStatistics));
+    for( int i = 0; i < nBands && papoBands != NULL; i++ )
+    {
+        if( papoBands[i] == NULL )
+            continue;
+        GDALCacheStatistics sBandStats;
+        papoBands[i]->GetBlockCacheStatistics(&sBandStats);
+        psStats->nBytesUsed += sBandStats.nBytesUsed;
+        psStats->nBlocks += sBandStats.nBlocks;
+        psStats->nHits += sBandStats.nHits;
+        psStats->nMisses += sBandStats.nMisses;
+        psStats->nEvictions += sBandStats.nEvictions;
+    }
+}
+
+/************************************************************************/
+/*                    GDALDatasetGetCacheStatistics()                   */
+/************************************************************************/
+
+/**
+ * \brief Fetch block cache statistics of the dataset.
+ *
+ * @see GDALDataset::GetBlockCacheStatistics()
+ *
+ * @since GDAL 2.2
+ */
+
+void GDALDatasetGetCacheStatistics( GDALDatasetH hDS,
+                                    GDALCacheStatistics* psStats )
+
+{
+    VALIDATE_POINTER0( hDS, "GDALDatasetGetCacheStatistics" );
+    VALIDATE_POINTER0( psStats, "GDALDatasetGetCacheStatistics" );
+
+    ((GDALDataset *) hDS)->GetBlockCacheStatistics(psStats);
+}
+
 /************************************************************************/
 /*                        BlockBasedFlushCache()                        */
 /*                                                                      */
@@ -2538,6 +2741,23 @@ GDALOpen( const char * pszFilename, GDALAccess eAccess )
 }
 
 
+/************************************************************************/
+/*                      IsDriverSpecificOpenOption()                    */
+/************************************************************************/
+
+/* Open options handled by GDALOpenEx() for all drivers */
+static const char* const apszGenericOpenOptions[] =
+    { "OVERVIEW_LEVEL", "CACHE_QUOTA", NULL };
+
+static bool IsDriverSpecificOpenOption( GDALDriver* poDriver,
+                                        const char* pszOption )
+{
+    const char* pszOptionList =
+        poDriver->GetMetadataItem(GDAL_DMD_OPENOPTIONLIST);
+    return pszOptionList != NULL &&
+           CPLString(pszOptionList).ifind(pszOption) != std::string::npos;
+}
+
 /************************************************************************/
 /*                             GDALOpenEx()                             */
 /************************************************************************/
@@ -2606,6 +2826,9 @@ GDALOpen( const char * pszFilename, GDALAccess eAccess )
  * OVERVIEW_LEVEL=level, to select a particular overview level of a dataset.
  * The level index starts at 0. The level number can be suffixed by "only" to specify that
  * only this overview level must be visible, and not sub-levels.
+ * Since GDAL 2.2, the CACHE_QUOTA=megabytes option also exists for all drivers,
+ * to hold the blocks of the dataset in a cache partition of that size (see
+ * GDALDataset::SetBlockCacheQuota()).
  * Open options are validated by default, and a warning is emitted in case the
  * option is not recognized. In some scenarios, it might be not desirable (e.g.
  * when not knowing which driver will open the file), so the special open option
@@ -2726,6 +2949,9 @@ GDALDatasetH CPL_STDCALL GDALOpenEx( const char* pszFilename,
         else
         {
             poDriver = poDM->GetDriver( iDriver );
+            // A deferred driver may register nothing when it is loaded.
+            if( poDriver == NULL )
+                continue;
             if (papszAllowedDrivers != NULL &&
                 CSLFindString((char**)papszAllowedDrivers, GDALGetDriverShortName(poDriver)) == -1)
                 continue;
@@ -2740,22 +2966,28 @@ GDALDatasetH CPL_STDCALL GDALOpenEx( const char* pszFilename,
             poDriver->GetMetadataItem(GDAL_DCAP_VECTOR) == NULL )
             continue;
 
-        /* Remove general OVERVIEW_LEVEL open options from list before */
-        /* passing it to the driver, if it isn't a driver specific option already */
+        /* Remove general OVERVIEW_LEVEL and CACHE_QUOTA open options from */
+        /* list before passing it to the driver, if they aren't driver */
+        /* specific options already */
         char** papszTmpOpenOptions = NULL;
         char** papszTmpOpenOptionsToValidate = NULL;
         char** papszOptionsToValidate = (char**) papszOpenOptions;
-        if( CSLFetchNameValue(papszOpenOptionsCleaned, "OVERVIEW_LEVEL") != NULL &&
-            (poDriver->GetMetadataItem(GDAL_DMD_OPENOPTIONLIST) == NULL ||
-             CPLString(poDriver->GetMetadataItem(GDAL_DMD_OPENOPTIONLIST)).ifind("OVERVIEW_LEVEL") == std::string::npos) )
+        for( int iOpt = 0; apszGenericOpenOptions[iOpt] != NULL; iOpt++ )
         {
-            papszTmpOpenOptions = CSLDuplicate(papszOpenOptionsCleaned);
-            papszTmpOpenOptions = CSLSetNameValue(papszTmpOpenOptions, "OVERVIEW_LEVEL", NULL);
-            oOpenInfo.papszOpenOptions = papszTmpOpenOptions;
+            const char* pszOpt = apszGenericOpenOptions[iOpt];
+            if( CSLFetchNameValue(papszOpenOptionsCleaned, pszOpt) == NULL ||
+                IsDriverSpecificOpenOption(poDriver, pszOpt) )
+                continue;
 
-            papszOptionsToValidate = CSLDuplicate(papszOptionsToValidate);
-            papszOptionsToValidate = CSLSetNameValue(papszOptionsToValidate, "OVERVIEW_LEVEL", NULL);
-            papszTmpOpenOptionsToValidate = papszOptionsToValidate;
+            if( papszTmpOpenOptions == NULL )
+            {
+                papszTmpOpenOptions = CSLDuplicate(papszOpenOptionsCleaned);
+                papszTmpOpenOptionsToValidate = CSLDuplicate(papszOptionsToValidate);
+            }
+            papszTmpOpenOptions = CSLSetNameValue(papszTmpOpenOptions, pszOpt, NULL);
+            papszTmpOpenOptionsToValidate = CSLSetNameValue(papszTmpOpenOptionsToValidate, pszOpt, NULL);
+            oOpenInfo.papszOpenOptions = papszTmpOpenOptions;
+            papszOptionsToValidate = papszTmpOpenOptionsToValidate;
         }
 
         int bIdentifyRes =
@@ -2840,8 +3072,7 @@ GDALDatasetH CPL_STDCALL GDALOpenEx( const char* pszFilename,
             /* Deal with generic OVERVIEW_LEVEL open option, unless it is */
             /* driver specific */
             if( CSLFetchNameValue((char**) papszOpenOptions, "OVERVIEW_LEVEL") != NULL &&
-                (poDriver->GetMetadataItem(GDAL_DMD_OPENOPTIONLIST) == NULL ||
-                CPLString(poDriver->GetMetadataItem(GDAL_DMD_OPENOPTIONLIST)).ifind("OVERVIEW_LEVEL") == std::string::npos) )
+                !IsDriverSpecificOpenOption(poDriver, "OVERVIEW_LEVEL") )
             {
                 CPLString osVal(CSLFetchNameValue((char**) papszOpenOptions, "OVERVIEW_LEVEL"));
                 int nOvrLevel = atoi(osVal);
@@ -2863,6 +3094,21 @@ GDALDatasetH CPL_STDCALL GDALOpenEx( const char* pszFilename,
                     poDS = poOvrDS;
                 }
             }
+
+            /* Deal with generic CACHE_QUOTA open option, unless it is */
+            /* driver specific */
+            if( poDS != NULL &&
+                CSLFetchNameValue((char**) papszOpenOptions, "CACHE_QUOTA") != NULL &&
+                !IsDriverSpecificOpenOption(poDriver, "CACHE_QUOTA") )
+            {
+                const char* pszVal = CSLFetchNameValue((char**) papszOpenOptions, "CACHE_QUOTA");
+                const double dfQuotaMB = CPLAtof(pszVal);
+                if( dfQuotaMB > 0 )
+                    poDS->SetBlockCacheQuota(static_cast<GIntBig>(dfQuotaMB * 1024 * 1024));
+                else
+                    CPLError( CE_Warning, CPLE_NotSupported,
+                              "Invalid value for CACHE_QUOTA: %s", pszVal );
+            }
             VSIErrorReset();
 
             CSLDestroy(papszOpenOptionsCleaned);
@@ -94,7 +94,8 @@ GDALDriverManager * GetGDALDriverManager()
 
 GDALDriverManager::GDALDriverManager() :
     nDrivers(0),
-    papoDrivers(NULL)
+    papoDrivers(NULL),
+    nInsertionIndex(-1)
 {
     CPLAssert( poDM == NULL );
 
@@ -183,11 +184,12 @@ GDALDriverManager::~GDALDriverManager()
     }
 
 /* -------------------------------------------------------------------- */
-/*      Destroy the existing drivers.                                   */
+/*      Destroy the existing drivers, without loading the deferred      */
+/*      ones.                                                           */
 /* -------------------------------------------------------------------- */
-    while( GetDriverCount() > 0 )
+    while( nDrivers > 0 )
     {
-        GDALDriver *poDriver = GetDriver(0);
+        GDALDriver *poDriver = papoDrivers[0];
 
         DeregisterDriver(poDriver);
         delete poDriver;
@@ -296,6 +298,9 @@ GDALDriverManager::~GDALDriverManager()
  *
  * This C analog to this is GDALGetDriverCount().
  *
+ * Drivers whose registration is deferred (see DeclareDeferredDriver()) are
+ * counted, without being loaded.
+ *
  * @return the number of registered drivers.
  */
 
@@ -340,7 +345,15 @@ GDALDriver * GDALDriverManager::GetDriver( int iDriver )
 {
     CPLMutexHolderD( &hDMMutex );
 
-    return GetDriver_unlocked(iDriver);
+    GDALDriver *poDriver = GetDriver_unlocked(iDriver);
+    while( poDriver != NULL &&
+           oMapDeferredDrivers.find(poDriver) != oMapDeferredDrivers.end() )
+    {
+        LoadDeferredDriver( iDriver );
+        poDriver = GetDriver_unlocked(iDriver);
+    }
+
+    return poDriver;
 }
 
 /************************************************************************/
@@ -387,6 +400,12 @@ int GDALDriverManager::RegisterDriver( GDALDriver * poDriver )
 {
     CPLMutexHolderD( &hDMMutex );
 
+/* -------------------------------------------------------------------- */
+/*      If a deferred driver has the same name, load it first, so that  */
+/*      the drivers end up in the same order as without deferral.       */
+/* -------------------------------------------------------------------- */
+    LoadDeferredDriver( poDriver->GetDescription() );
+
 /* -------------------------------------------------------------------- */
 /*      If it is already registered, just return the existing           */
 /*      index.                                                          */
@@ -413,7 +432,17 @@ int GDALDriverManager::RegisterDriver( GDALDriver * poDriver )
         return -1;
     papoDrivers = papoNewDrivers;
 
-    papoDrivers[nDrivers] = poDriver;
+    // The drivers registered while a deferred driver is loaded take the
+    // place of its stub.
+    int iResult = nDrivers;
+    if( nInsertionIndex >= 0 && nInsertionIndex <= nDrivers )
+    {
+        iResult = nInsertionIndex++;
+        memmove( papoDrivers + iResult + 1, papoDrivers + iResult,
+                 sizeof(GDALDriver *) * (nDrivers - iResult) );
+    }
+
+    papoDrivers[iResult] = poDriver;
     nDrivers++;
 
     if( poDriver->pfnOpen != NULL ||
@@ -450,8 +479,6 @@ int GDALDriverManager::RegisterDriver( GDALDriver * poDriver )
 
     oMapNameToDrivers[CPLString(poDriver->GetDescription()).toupper()] = poDriver;
 
-    int iResult = nDrivers - 1;
-
     return iResult;
 }
 
@@ -503,6 +530,7 @@ void GDALDriverManager::DeregisterDriver( GDALDriver * poDriver )
     if( i == nDrivers )
         return;
 
+    oMapDeferredDrivers.erase(poDriver);
     oMapNameToDrivers.erase(CPLString(poDriver->GetDescription()).toupper());
     nDrivers--;
     // Move all following drivers down by one to pack the list.
@@ -531,6 +559,134 @@ void CPL_STDCALL GDALDeregisterDriver( GDALDriverH hDriver )
     GetGDALDriverManager()->DeregisterDriver( (GDALDriver *) hDriver );
 }
 
+/************************************************************************/
+/*                       DeclareDeferredDriver()                        */
+/************************************************************************/
+
+/**
+ * \brief Declare a driver whose registration is deferred until it is needed.
+ *
+ * Only a stub with the short name of the driver is registered, that takes
+ * the place of the driver in the list of drivers. The first time the stub
+ * is reached by GetDriver(), for example when GDALOpenEx() probes the
+ * drivers in turn, or the driver is requested with GetDriverByName(),
+ * pfnRegister is called, and the driver(s) it registers replace the stub.
+ * Drivers whose registration is deferred are never exposed as stubs.
+ *
+ * As the stub only knows the short name of the driver, it cannot reject a
+ * file without loading the driver: GDALOpenEx() loads each deferred driver
+ * it probes, until one of them opens the file.
+ *
+ * This is used by GDALAllRegister() when the
+ * GDAL_DEFERRED_DRIVER_REGISTRATION configuration option is set to YES.
+ *
+ * If a driver with the same short name is already registered, or declared,
+ * pfnRegister is called immediately.
+ *
+ * @param pszDriverName the short name of the driver registered by
+ * pfnRegister, such as GTiff.
+ * @param pfnRegister function registering the driver, such as
+ * GDALRegister_GTiff().
+ *
+ * @since GDAL 2.2
+ */
+
+void GDALDriverManager::DeclareDeferredDriver( const char *pszDriverName,
+                                               void (*pfnRegister)(void) )
+
+{
+    CPLMutexHolderD( &hDMMutex );
+
+    // Several drivers sharing the same name cannot be told apart by their
+    // stubs, so register the ones that come after the first one right now.
+    if( GetDriverByName_unlocked( pszDriverName ) != NULL )
+    {
+        pfnRegister();
+        return;
+    }
+
+    GDALDriver** papoNewDrivers = (GDALDriver **)
+        VSI_REALLOC_VERBOSE(papoDrivers, sizeof(GDALDriver *) * (nDrivers+1));
+    if( papoNewDrivers == NULL )
+        return;
+    papoDrivers = papoNewDrivers;
+
+    GDALDriver *poStub = new GDALDriver();
+    poStub->SetDescription( pszDriverName );
+
+    papoDrivers[nDrivers] = poStub;
+    nDrivers++;
+
+    oMapNameToDrivers[CPLString(pszDriverName).toupper()] = poStub;
+    oMapDeferredDrivers[poStub] = pfnRegister;
+}
+
+/************************************************************************/
+/*                     GDALRegisterOrDeferDriver()                      */
+/************************************************************************/
+
+/* Register the driver of pfnRegister, or if bDeferred, only declare a stub */
+/* with its short name, that will call pfnRegister when first needed. Used */
+/* by GDALAllRegister() and OGRRegisterAllInternal(). */
+
+void GDALRegisterOrDeferDriver( bool bDeferred, const char *pszDriverName,
+                                void (*pfnRegister)(void) )
+{
+    if( bDeferred )
+        GetGDALDriverManager()->DeclareDeferredDriver( pszDriverName,
+                                                       pfnRegister );
+    else
+        pfnRegister();
+}
+
+/************************************************************************/
+/*                         LoadDeferredDriver()                         */
+/************************************************************************/
+
+/* Replace the stub at index iDriver by the driver(s) registered by its */
+/* registration function. Must be called with hDMMutex held. */
+
+void GDALDriverManager::LoadDeferredDriver( int iDriver )
+
+{
+    GDALDriver *poStub = papoDrivers[iDriver];
+    void (*pfnRegister)(void) = oMapDeferredDrivers[poStub];
+
+    DeregisterDriver( poStub );
+    delete poStub;
+
+    const int nOldInsertionIndex = nInsertionIndex;
+    nInsertionIndex = iDriver;
+
+    pfnRegister();
+
+    nInsertionIndex = nOldInsertionIndex;
+}
+
+/* Load the deferred driver of name pszDriverName, if there is one. Must */
+/* be called with hDMMutex held. */
+
+void GDALDriverManager::LoadDeferredDriver( const char *pszDriverName )
+
+{
+    if( oMapDeferredDrivers.empty() )
+        return;
+
+    GDALDriver *poDriver = GetDriverByName_unlocked( pszDriverName );
+    if( poDriver == NULL ||
+        oMapDeferredDrivers.find(poDriver) == oMapDeferredDrivers.end() )
+        return;
+
+    for( int i = 0; i < nDrivers; i++ )
+    {
+        if( papoDrivers[i] == poDriver )
+        {
+            LoadDeferredDriver( i );
+            return;
+        }
+    }
+}
+
 
 /************************************************************************/
 /*                          GetDriverByName()                           */
@@ -555,7 +711,9 @@ GDALDriver * GDALDriverManager::GetDriverByName( const char * pszName )
     if( EQUAL(pszName, "CartoDB") )
         pszName = "Carto";
 
-    return oMapNameToDrivers[CPLString(pszName).toupper()];
+    LoadDeferredDriver( pszName );
+
+    return GetDriverByName_unlocked( pszName );
 }
 
 /************************************************************************/
@@ -618,7 +776,14 @@ void GDALDriverManager::AutoSkipDrivers()
     {
         for( int i = 0; apapszList[j] != NULL &&  apapszList[j][i] != NULL; i++ )
         {
-            GDALDriver *poDriver = GetDriverByName( apapszList[j][i] );
+            GDALDriver *poDriver;
+            {
+                // Deferred drivers are skipped without being loaded first
+                CPLMutexHolderD( &hDMMutex );
+                poDriver = GetDriverByName_unlocked( apapszList[j][i] );
+            }
+            if( poDriver == NULL )
+                poDriver = GetDriverByName( apapszList[j][i] );
 
             if( poDriver == NULL )
                 CPLError( CE_Warning, CPLE_AppDefined,
@@ -32,6 +32,15 @@
 #include "gdal_priv.h"
 #include "gdal_rat.h"
 #include "cpl_string.h"
+#include "cpl_worker_thread_pool.h"
+
+#include <climits>
+#include <limits>
+#include <vector>
+
+#if defined(__x86_64) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 CPL_CVSID("$Id$");
 
@@ -806,6 +815,8 @@ int GDALRasterBand::InitBlockInfo()
     }
     if( poBandBlockCache == NULL )
         return FALSE;
+    if( poDS != NULL )
+        poBandBlockCache->SetCachePartition(poDS->GetBlockCachePartition());
     return poBandBlockCache->Init();
 }
 
@@ -882,6 +893,54 @@ CPLErr CPL_STDCALL GDALFlushRasterCache( GDALRasterBandH hBand )
     return ((GDALRasterBand *) hBand)->FlushCache();
 }
 
+/************************************************************************/
+/*                      GetBlockCacheStatistics()                       */
+/************************************************************************/
+
+/**
+ * \brief Fetch block cache statistics of the band.
+ *
+ * The statistics cover the blocks of this band currently held in the block
+ * cache, and the number of cache hits, misses and evictions since the band
+ * block cache was created.
+ *
+ * This method is the same as the C function GDALGetRasterCacheStatistics().
+ *
+ * @param psStats structure to fill with the statistics.
+ *
+ * @since GDAL 2.2
+ */
+
+void GDALRasterBand::GetBlockCacheStatistics( GDALCacheStatistics* psStats )
+
+{
+    memset(psStats, 0, sizeof(GDALCacheStatistics));
+    if( poBandBlockCache != NULL )
+        poBandBlockCache->GetStatistics(psStats);
+}
+
+/************************************************************************/
+/*                    GDALGetRasterCacheStatistics()                    */
+/************************************************************************/
+
+/**
+ * \brief Fetch block cache statistics of the band.
+ *
+ * @see GDALRasterBand::GetBlockCacheStatistics()
+ *
+ * @since GDAL 2.2
+ */
+
+void GDALGetRasterCacheStatistics( GDALRasterBandH hBand,
+                                   GDALCacheStatistics* psStats )
+
+{
+    VALIDATE_POINTER0( hBand, "GDALGetRasterCacheStatistics" );
+    VALIDATE_POINTER0( psStats, "GDALGetRasterCacheStatistics" );
+
+    ((GDALRasterBand *) hBand)->GetBlockCacheStatistics(psStats);
+}
+
 
 /************************************************************************/
 /*                        UnreferenceBlock()                            */
@@ -2641,439 +2700,1454 @@ GDALDatasetH CPL_STDCALL GDALGetBandDataset( GDALRasterBandH hBand )
 }
 
 /************************************************************************/
-/*                            GetHistogram()                            */
+/*                           GDALBandStats                              */
 /************************************************************************/
 
-/**
- * \brief Compute raster histogram.
- *
- * Note that the bucket size is (dfMax-dfMin) / nBuckets.
- *
- * For example to compute a simple 256 entry histogram of eight bit data,
- * the following would be suitable.  The unusual bounds are to ensure that
- * bucket boundaries don't fall right on integer values causing possible errors
- * due to rounding after scaling.
-<pre>
-    GUIntBig anHistogram[256];
+namespace {
 
-    poBand->GetHistogram( -0.5, 255.5, 256, anHistogram, FALSE, FALSE,
-                          GDALDummyProgress, NULL );
-</pre>
- *
- * Note that setting bApproxOK will generally result in a subsampling of the
- * file, and will utilize overviews if available.  It should generally
- * produce a representative histogram for the data that is suitable for use
- * in generating histogram based luts for instance.  Generally bApproxOK is
- * much faster than an exactly computed histogram.
- *
- * This method is the same as the C functions GDALGetRasterHistogram() and
- * GDALGetRasterHistogramEx().
- *
- * @param dfMin the lower bound of the histogram.
- * @param dfMax the upper bound of the histogram.
- * @param nBuckets the number of buckets in panHistogram.
- * @param panHistogram array into which the histogram totals are placed.
- * @param bIncludeOutOfRange if TRUE values below the histogram range will
- * mapped into panHistogram[0], and values above will be mapped into
- * panHistogram[nBuckets-1] otherwise out of range values are discarded.
- * @param bApproxOK TRUE if an approximate, or incomplete histogram OK.
- * @param pfnProgress function to report progress to completion.
- * @param pProgressData application data to pass to pfnProgress.
- *
- * @return CE_None on success, or CE_Failure if something goes wrong.
- */
+/* Statistics of a set of values. The statistics of disjoint sets are    */
+/* merged with the pairwise update of Chan et al., that is numerically   */
+/* stable, so that the blocks of a band can be processed in any order,   */
+/* or in parallel, and merged afterwards. */
 
-CPLErr GDALRasterBand::GetHistogram( double dfMin, double dfMax,
-                                     int nBuckets, GUIntBig *panHistogram,
-                                     int bIncludeOutOfRange, int bApproxOK,
-                                     GDALProgressFunc pfnProgress,
-                                     void *pProgressData )
+struct GDALBandStats
+{
+    GUIntBig nCount;
+    double   dfMin;
+    double   dfMax;
+    double   dfMean;
+    double   dfM2;      // Sum of the squares of the differences to the mean
+
+    GDALBandStats() : nCount(0), dfMin(0.0), dfMax(0.0),
+                      dfMean(0.0), dfM2(0.0) {}
+
+    void Merge( GUIntBig nOtherCount, double dfOtherMin, double dfOtherMax,
+                double dfOtherMean, double dfOtherM2 );
+    void Merge( const GDALBandStats& sOther )
+    {
+        Merge( sOther.nCount, sOther.dfMin, sOther.dfMax,
+               sOther.dfMean, sOther.dfM2 );
+    }
+};
 
+void GDALBandStats::Merge( GUIntBig nOtherCount,
+                           double dfOtherMin, double dfOtherMax,
+                           double dfOtherMean, double dfOtherM2 )
 {
-    CPLAssert( NULL != panHistogram );
+    if( nOtherCount == 0 )
+        return;
+    if( nCount == 0 )
+    {
+        nCount = nOtherCount;
+        dfMin = dfOtherMin;
+        dfMax = dfOtherMax;
+        dfMean = dfOtherMean;
+        dfM2 = dfOtherM2;
+        return;
+    }
 
-    if( pfnProgress == NULL )
-        pfnProgress = GDALDummyProgress;
+    const double dfN1 = static_cast<double>(nCount);
+    const double dfN2 = static_cast<double>(nOtherCount);
+    nCount += nOtherCount;
+    const double dfN = static_cast<double>(nCount);
+    const double dfDelta = dfOtherMean - dfMean;
+    dfMean += dfDelta * dfN2 / dfN;
+    dfM2 += dfOtherM2 + dfDelta * dfDelta * dfN1 * dfN2 / dfN;
+    dfMin = MIN(dfMin, dfOtherMin);
+    dfMax = MAX(dfMax, dfOtherMax);
+}
 
-/* -------------------------------------------------------------------- */
-/*      If we have overviews, use them for the histogram.               */
-/* -------------------------------------------------------------------- */
-    if( bApproxOK && GetOverviewCount() > 0 && !HasArbitraryOverviews() )
-    {
-        // FIXME: should we use the most reduced overview here or use some
-        // minimum number of samples like GDALRasterBand::ComputeStatistics()
-        // does?
-        GDALRasterBand *poBestOverview = GetRasterSampleOverview( 0 );
+/************************************************************************/
+/*                        GDALStatsKernelArgs                           */
+/************************************************************************/
 
-        if( poBestOverview != this )
+struct GDALStatsKernelArgs
+{
+    GDALDataType eDataType;
+    bool         bSignedByte;
+    bool         bMinMaxOnly;
+    bool         bGotNoDataValue;
+    double       dfNoDataValue;
+
+    // For Byte, UInt16 and Int16: the raw value matching the nodata value.
+    bool         bIntNoData;
+    GUInt16      nIntNoData;
+
+    // Use the type-specialized kernels.
+    bool         bFastPath;
+};
+
+} // end anonymous namespace
+
+static void GDALInitStatsKernelArgs( GDALStatsKernelArgs& sArgs,
+                                     GDALDataType eDataType,
+                                     bool bSignedByte, bool bMinMaxOnly,
+                                     bool bGotNoDataValue,
+                                     double dfNoDataValue )
+{
+    sArgs.eDataType = eDataType;
+    sArgs.bSignedByte = bSignedByte;
+    sArgs.bMinMaxOnly = bMinMaxOnly;
+    sArgs.bGotNoDataValue = bGotNoDataValue;
+    sArgs.dfNoDataValue = dfNoDataValue;
+    sArgs.bIntNoData = false;
+    sArgs.nIntNoData = 0;
+
+    if( (eDataType == GDT_Byte && !bSignedByte) ||
+        eDataType == GDT_UInt16 || eDataType == GDT_Int16 )
+    {
+        sArgs.bFastPath = true;
+        // At most one integer value can match the nodata value with the
+        // tolerance of ARE_REAL_EQUAL().
+        const double dfRounded = floor(dfNoDataValue + 0.5);
+        const double dfTypeMin = eDataType == GDT_Int16 ? -32768.0 : 0.0;
+        const double dfTypeMax = eDataType == GDT_Byte ? 255.0 :
+                                 eDataType == GDT_Int16 ? 32767.0 : 65535.0;
+        if( bGotNoDataValue && dfRounded >= dfTypeMin &&
+            dfRounded <= dfTypeMax && ARE_REAL_EQUAL(dfRounded, dfNoDataValue) )
         {
-            return poBestOverview->GetHistogram( dfMin, dfMax, nBuckets,
-                                                 panHistogram,
-                                                 bIncludeOutOfRange, bApproxOK,
-                                                 pfnProgress, pProgressData );
+            sArgs.bIntNoData = true;
+            sArgs.nIntNoData = static_cast<GUInt16>(
+                static_cast<int>(dfRounded) & 0xFFFF);
         }
     }
-
-/* -------------------------------------------------------------------- */
-/*      Read actual data and build histogram.                           */
-/* -------------------------------------------------------------------- */
-    if( !pfnProgress( 0.0, "Compute Histogram", pProgressData ) )
+    else if( eDataType == GDT_Float32 || eDataType == GDT_Float64 )
     {
-        ReportError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
-        return CE_Failure;
+        // ARE_REAL_EQUAL() has special rules for FLT_MIN and DBL_MIN
+        sArgs.bFastPath = !(bGotNoDataValue &&
+            (static_cast<float>(dfNoDataValue) ==
+                static_cast<float>(1.17549435e-38) ||
+             dfNoDataValue == 2.2250738585072014e-308));
+    }
+    else
+    {
+        sArgs.bFastPath = false;
     }
+}
 
-    GDALRasterIOExtraArg sExtraArg;
-    INIT_RASTERIO_EXTRA_ARG(sExtraArg);
+/************************************************************************/
+/*                     GDALComputeIntStatistics()                       */
+/************************************************************************/
 
-    const double dfScale = nBuckets / (dfMax - dfMin);
-    memset( panHistogram, 0, sizeof(GUIntBig) * nBuckets );
+/* Byte, UInt16 and Int16 values are shifted to be non negative, and are  */
+/* accumulated exactly by chunks of at most GDAL_STATS_INT_CHUNK values.  */
+/* n * sum of squares and the square of the sum then fit in 64 bits, so   */
+/* that the variance of a chunk is computed without any cancellation.     */
 
-    int bGotNoDataValue;
-    const double dfNoDataValue = GetNoDataValue( &bGotNoDataValue );
-    bGotNoDataValue = bGotNoDataValue && !CPLIsNan(dfNoDataValue);
-    /* Not advertized. May be removed at any time. Just as a provision if the */
-    /* old behaviour made sense somethimes... */
-    bGotNoDataValue = bGotNoDataValue &&
-        !CPLTestBool(CPLGetConfigOption("GDAL_NODATA_IN_HISTOGRAM", "NO"));
+#define GDAL_STATS_INT_CHUNK 32768
 
-    const char* pszPixelType = GetMetadataItem("PIXELTYPE", "IMAGE_STRUCTURE");
-    const bool bSignedByte = (pszPixelType != NULL && EQUAL(pszPixelType, "SIGNEDBYTE"));
+namespace {
 
-    if ( bApproxOK && HasArbitraryOverviews() )
+struct GDALIntStatsChunk
+{
+    GUIntBig nSum;
+    GUIntBig nSumSq;
+    int      nCount;
+    int      nMin;      // in the shifted domain
+    int      nMax;
+
+    void Reset()
     {
-/* -------------------------------------------------------------------- */
-/*      Figure out how much the image should be reduced to get an       */
-/*      approximate value.                                              */
-/* -------------------------------------------------------------------- */
-        double  dfReduction = sqrt(
-            (double)nRasterXSize * nRasterYSize / GDALSTAT_APPROX_NUMSAMPLES );
+        nSum = 0;
+        nSumSq = 0;
+        nCount = 0;
+        nMin = INT_MAX;
+        nMax = INT_MIN;
+    }
 
-        int     nXReduced, nYReduced;
+    void FlushTo( GDALBandStats& sStats, int nOffset )
+    {
+        if( nCount == 0 )
+            return;
+        const GUIntBig nN = static_cast<GUIntBig>(nCount);
+        const GIntBig nShiftedSum = static_cast<GIntBig>(nSum) +
+                                    static_cast<GIntBig>(nOffset) * nCount;
+        sStats.Merge( nN, nMin + nOffset, nMax + nOffset,
+                      static_cast<double>(nShiftedSum) / nCount,
+                      static_cast<double>(nN * nSumSq - nSum * nSum) / nCount );
+        Reset();
+    }
+};
 
-        if ( dfReduction > 1.0 )
+} // end anonymous namespace
+
+template<bool bMinMaxOnly>
+static void GDALAccumulateByteSpan( const GByte* pabyData, int nCount,
+                                    bool bHasNoData, GByte nNoData,
+                                    GDALIntStatsChunk& sChunk )
+{
+    int i = 0;
+#if defined(__x86_64) || defined(_M_X64)
+    if( nCount >= 16 )
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi8(1);
+        const __m128i vNoData = _mm_set1_epi8(static_cast<char>(nNoData));
+        __m128i vMin = _mm_set1_epi8(static_cast<char>(255));
+        __m128i vMax = zero;
+        __m128i vSum = zero;       // 2 x 64 bit
+        __m128i vSumSq = zero;     // 4 x 32 bit, cannot overflow for 32768 values
+        __m128i vInvalid = zero;   // 2 x 64 bit
+        for( ; i + 16 <= nCount; i += 16 )
         {
-            nXReduced = (int)( nRasterXSize / dfReduction );
-            nYReduced = (int)( nRasterYSize / dfReduction );
+            __m128i v = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(pabyData + i));
+            if( bHasNoData )
+            {
+                const __m128i mask = _mm_cmpeq_epi8(v, vNoData);
+                vMin = _mm_min_epu8(vMin, _mm_or_si128(v, mask));
+                v = _mm_andnot_si128(mask, v);
+                vInvalid = _mm_add_epi64(vInvalid,
+                                _mm_sad_epu8(_mm_and_si128(mask, one), zero));
+            }
+            else
+            {
+                vMin = _mm_min_epu8(vMin, v);
+            }
+            vMax = _mm_max_epu8(vMax, v);
+            if( !bMinMaxOnly )
+            {
+                vSum = _mm_add_epi64(vSum, _mm_sad_epu8(v, zero));
+                const __m128i lo = _mm_unpacklo_epi8(v, zero);
+                const __m128i hi = _mm_unpackhi_epi8(v, zero);
+                vSumSq = _mm_add_epi32(vSumSq,
+                    _mm_add_epi32(_mm_madd_epi16(lo, lo),
+                                  _mm_madd_epi16(hi, hi)));
+            }
+        }
 
-            // Catch the case of huge resizing ratios here
-            if ( nXReduced == 0 )
-                nXReduced = 1;
-            if ( nYReduced == 0 )
-                nYReduced = 1;
+        GUIntBig anTmp64[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(anTmp64), vInvalid);
+        const int nValid = i - static_cast<int>(anTmp64[0] + anTmp64[1]);
+        if( nValid > 0 )
+        {
+            GByte abyMin[16], abyMax[16];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(abyMin), vMin);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(abyMax), vMax);
+            for( int j = 0; j < 16; j++ )
+            {
+                sChunk.nMin = MIN(sChunk.nMin, abyMin[j]);
+                sChunk.nMax = MAX(sChunk.nMax, abyMax[j]);
+            }
+            sChunk.nCount += nValid;
+            if( !bMinMaxOnly )
+            {
+                GUInt32 anTmp32[4];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(anTmp64), vSum);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(anTmp32), vSumSq);
+                sChunk.nSum += anTmp64[0] + anTmp64[1];
+                sChunk.nSumSq += static_cast<GUIntBig>(anTmp32[0]) +
+                    anTmp32[1] + anTmp32[2] + anTmp32[3];
+            }
         }
-        else
+    }
+#endif
+    for( ; i < nCount; i++ )
+    {
+        const int nVal = pabyData[i];
+        if( bHasNoData && nVal == nNoData )
+            continue;
+        sChunk.nCount ++;
+        sChunk.nMin = MIN(sChunk.nMin, nVal);
+        sChunk.nMax = MAX(sChunk.nMax, nVal);
+        if( !bMinMaxOnly )
         {
-            nXReduced = nRasterXSize;
-            nYReduced = nRasterYSize;
+            sChunk.nSum += nVal;
+            sChunk.nSumSq += static_cast<GUIntBig>(nVal * nVal);
         }
+    }
+}
 
-        void *pData =
-            CPLMalloc(
-                GDALGetDataTypeSizeBytes(eDataType) * nXReduced * nYReduced );
+/* UInt16 and Int16 values are read as raw 16 bit words. nShift is the    */
+/* xor mask that gives the shifted (non negative) value: 0 for UInt16 and */
+/* 0x8000 for Int16. */
 
-        CPLErr eErr = IRasterIO( GF_Read, 0, 0, nRasterXSize, nRasterYSize, pData,
-                   nXReduced, nYReduced, eDataType, 0, 0, &sExtraArg );
-        if ( eErr != CE_None )
+template<bool bMinMaxOnly>
+static void GDALAccumulateInt16Span( const GUInt16* panData, int nCount,
+                                     GUInt16 nShift,
+                                     bool bHasNoData, GUInt16 nNoData,
+                                     GDALIntStatsChunk& sChunk )
+{
+    int i = 0;
+#if defined(__x86_64) || defined(_M_X64)
+    if( nCount >= 8 )
+    {
+        // Min and max are computed on signed words, as SSE2 has no unsigned
+        // 16 bit min/max: s = u ^ 0x8000.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i vSignedShift = _mm_set1_epi16(
+            static_cast<short>(nShift ^ 0x8000));
+        const __m128i vBias = _mm_set1_epi16(static_cast<short>(0x8000));
+        const __m128i vNoData = _mm_set1_epi16(static_cast<short>(nNoData));
+        const __m128i vSMax = _mm_set1_epi16(0x7FFF);
+        __m128i vMin = vSMax;
+        __m128i vMax = vBias;
+        __m128i vSum = zero;       // 4 x 32 bit, cannot overflow for 32768 values
+        __m128i vSumSq = zero;     // 2 x 64 bit
+        __m128i vInvalid = zero;   // 8 x 16 bit
+        for( ; i + 8 <= nCount; i += 8 )
         {
-            CPLFree(pData);
-            return eErr;
+            const __m128i raw = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(panData + i));
+            const __m128i s = _mm_xor_si128(raw, vSignedShift);
+            __m128i u;
+            if( bHasNoData )
+            {
+                const __m128i mask = _mm_cmpeq_epi16(raw, vNoData);
+                vMin = _mm_min_epi16(vMin, _mm_or_si128(
+                    _mm_and_si128(mask, vSMax), _mm_andnot_si128(mask, s)));
+                vMax = _mm_max_epi16(vMax, _mm_or_si128(
+                    _mm_and_si128(mask, vBias), _mm_andnot_si128(mask, s)));
+                vInvalid = _mm_sub_epi16(vInvalid, mask);
+                u = _mm_andnot_si128(mask, _mm_xor_si128(s, vBias));
+            }
+            else
+            {
+                vMin = _mm_min_epi16(vMin, s);
+                vMax = _mm_max_epi16(vMax, s);
+                u = _mm_xor_si128(s, vBias);
+            }
+            if( !bMinMaxOnly )
+            {
+                vSum = _mm_add_epi32(vSum,
+                    _mm_add_epi32(_mm_unpacklo_epi16(u, zero),
+                                  _mm_unpackhi_epi16(u, zero)));
+                const __m128i lo = _mm_mullo_epi16(u, u);
+                const __m128i hi = _mm_mulhi_epu16(u, u);
+                const __m128i sq0 = _mm_unpacklo_epi16(lo, hi);
+                const __m128i sq1 = _mm_unpackhi_epi16(lo, hi);
+                vSumSq = _mm_add_epi64(vSumSq,
+                    _mm_add_epi64(_mm_unpacklo_epi32(sq0, zero),
+                                  _mm_unpackhi_epi32(sq0, zero)));
+                vSumSq = _mm_add_epi64(vSumSq,
+                    _mm_add_epi64(_mm_unpacklo_epi32(sq1, zero),
+                                  _mm_unpackhi_epi32(sq1, zero)));
+            }
         }
 
-        /* this isn't the fastest way to do this, but is easier for now */
-        for( int iY = 0; iY < nYReduced; iY++ )
+        GUInt16 anTmp16[8];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(anTmp16), vInvalid);
+        int nInvalid = 0;
+        for( int j = 0; j < 8; j++ )
+            nInvalid += anTmp16[j];
+        const int nValid = i - nInvalid;
+        if( nValid > 0 )
         {
-            for( int iX = 0; iX < nXReduced; iX++ )
+            GInt16 anMin[8], anMax[8];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(anMin), vMin);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(anMax), vMax);
+            for( int j = 0; j < 8; j++ )
             {
-                int    iOffset = iX + iY * nXReduced;
-                double dfValue = 0.0;
-
-                switch( eDataType )
-                {
-                  case GDT_Byte:
-                  {
-                    if (bSignedByte)
-                        dfValue = ((signed char *)pData)[iOffset];
-                    else
-                        dfValue = ((GByte *)pData)[iOffset];
-                    break;
-                  }
-                  case GDT_UInt16:
-                    dfValue = ((GUInt16 *)pData)[iOffset];
-                    break;
-                  case GDT_Int16:
-                    dfValue = ((GInt16 *)pData)[iOffset];
-                    break;
-                  case GDT_UInt32:
-                    dfValue = ((GUInt32 *)pData)[iOffset];
-                    break;
-                  case GDT_Int32:
-                    dfValue = ((GInt32 *)pData)[iOffset];
-                    break;
-                  case GDT_Float32:
-                    dfValue = ((float *)pData)[iOffset];
-                    if (CPLIsNan(dfValue))
-                        continue;
-                    break;
-                  case GDT_Float64:
-                    dfValue = ((double *)pData)[iOffset];
-                    if (CPLIsNan(dfValue))
-                        continue;
-                    break;
-                  case GDT_CInt16:
-                    {
-                        double dfReal = ((GInt16 *)pData)[iOffset*2];
-                        double dfImag = ((GInt16 *)pData)[iOffset*2+1];
-                        if ( CPLIsNan(dfReal) || CPLIsNan(dfImag) )
-                            continue;
-                        dfValue = sqrt( dfReal * dfReal + dfImag * dfImag );
-                    }
-                    break;
-                  case GDT_CInt32:
-                    {
-                        double dfReal = ((GInt32 *)pData)[iOffset*2];
-                        double dfImag = ((GInt32 *)pData)[iOffset*2+1];
-                        if ( CPLIsNan(dfReal) || CPLIsNan(dfImag) )
-                            continue;
-                        dfValue = sqrt( dfReal * dfReal + dfImag * dfImag );
-                    }
-                    break;
-                  case GDT_CFloat32:
-                    {
-                        double dfReal = ((float *)pData)[iOffset*2];
-                        double dfImag = ((float *)pData)[iOffset*2+1];
-                        if ( CPLIsNan(dfReal) || CPLIsNan(dfImag) )
-                            continue;
-                        dfValue = sqrt( dfReal * dfReal + dfImag * dfImag );
-                    }
-                    break;
-                  case GDT_CFloat64:
-                    {
-                        double dfReal = ((double *)pData)[iOffset*2];
-                        double dfImag = ((double *)pData)[iOffset*2+1];
-                        if ( CPLIsNan(dfReal) || CPLIsNan(dfImag) )
-                            continue;
-                        dfValue = sqrt( dfReal * dfReal + dfImag * dfImag );
-                    }
-                    break;
-                  default:
-                    CPLAssert( FALSE );
-                }
-
-                if( bGotNoDataValue && ARE_REAL_EQUAL(dfValue, dfNoDataValue) )
-                    continue;
+                sChunk.nMin = MIN(sChunk.nMin, anMin[j] + 32768);
+                sChunk.nMax = MAX(sChunk.nMax, anMax[j] + 32768);
+            }
+            sChunk.nCount += nValid;
+            if( !bMinMaxOnly )
+            {
+                GUInt32 anTmp32[4];
+                GUIntBig anTmp64[2];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(anTmp32), vSum);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(anTmp64), vSumSq);
+                sChunk.nSum += static_cast<GUIntBig>(anTmp32[0]) +
+                    anTmp32[1] + anTmp32[2] + anTmp32[3];
+                sChunk.nSumSq += anTmp64[0] + anTmp64[1];
+            }
+        }
+    }
+#endif
+    for( ; i < nCount; i++ )
+    {
+        if( bHasNoData && panData[i] == nNoData )
+            continue;
+        const int nVal = panData[i] ^ nShift;
+        sChunk.nCount ++;
+        sChunk.nMin = MIN(sChunk.nMin, nVal);
+        sChunk.nMax = MAX(sChunk.nMax, nVal);
+        if( !bMinMaxOnly )
+        {
+            sChunk.nSum += nVal;
+            sChunk.nSumSq += static_cast<GUIntBig>(nVal) * nVal;
+        }
+    }
+}
 
-                int nIndex = (int) floor((dfValue - dfMin) * dfScale);
+template<bool bMinMaxOnly>
+static void GDALComputeIntStatistics( const void* pData,
+                                      int nXCheck, int nYCheck,
+                                      int nLineStride,
+                                      const GDALStatsKernelArgs& sArgs,
+                                      GDALBandStats& sStats )
+{
+    const int nDTSize = GDALGetDataTypeSizeBytes(sArgs.eDataType);
+    const int nOffset = sArgs.eDataType == GDT_Int16 ? -32768 : 0;
+    const GUInt16 nShift = sArgs.eDataType == GDT_Int16 ? 0x8000 : 0;
+    GDALIntStatsChunk sChunk;
+    sChunk.Reset();
 
-                if( nIndex < 0 )
-                {
-                    if( bIncludeOutOfRange )
-                        panHistogram[0]++;
-                }
-                else if( nIndex >= nBuckets )
-                {
-                    if( bIncludeOutOfRange )
-                        panHistogram[nBuckets-1]++;
-                }
-                else
-                {
-                    panHistogram[nIndex]++;
-                }
+    for( int iY = 0; iY < nYCheck; iY++ )
+    {
+        const GByte* pabyLine = static_cast<const GByte*>(pData) +
+            static_cast<size_t>(iY) * nLineStride * nDTSize;
+        for( int iX = 0; iX < nXCheck; )
+        {
+            const int nSpan = MIN(nXCheck - iX,
+                                  GDAL_STATS_INT_CHUNK - sChunk.nCount);
+            if( nDTSize == 1 )
+            {
+                GDALAccumulateByteSpan<bMinMaxOnly>(
+                    pabyLine + iX, nSpan, sArgs.bIntNoData,
+                    static_cast<GByte>(sArgs.nIntNoData), sChunk );
+            }
+            else
+            {
+                GDALAccumulateInt16Span<bMinMaxOnly>(
+                    reinterpret_cast<const GUInt16*>(pabyLine) + iX, nSpan,
+                    nShift, sArgs.bIntNoData, sArgs.nIntNoData, sChunk );
             }
+            iX += nSpan;
+            if( sChunk.nCount == GDAL_STATS_INT_CHUNK )
+                sChunk.FlushTo( sStats, nOffset );
         }
-
-        CPLFree( pData );
     }
+    sChunk.FlushTo( sStats, nOffset );
+}
 
-    else    // No arbitrary overviews
-    {
+/************************************************************************/
+/*                    GDALComputeFloatStatistics()                      */
+/************************************************************************/
 
-        if( !InitBlockInfo() )
-            return CE_Failure;
+/* Float32 and Float64 values are processed by chunks that fit in the L1 */
+/* cache, with the corrected two-pass algorithm: the mean of the chunk is */
+/* computed first, then the sum of the squared differences to it. */
 
-/* -------------------------------------------------------------------- */
-/*      Figure out the ratio of blocks we will read to get an           */
-/*      approximate value.                                              */
-/* -------------------------------------------------------------------- */
+#define GDAL_STATS_FLOAT_CHUNK 4096
 
-        int nSampleRate;
-        if ( bApproxOK )
-        {
-            nSampleRate =
-                (int) MAX(1,sqrt((double) nBlocksPerRow * nBlocksPerColumn));
-            // We want to avoid probing only the first column of blocks for
-            // a square shaped raster, because it is not unlikely that it may
-            // be padding only (#6378)
-            if( nSampleRate == nBlocksPerRow && nBlocksPerRow > 1 )
-              nSampleRate += 1;
+#if defined(__x86_64) || defined(_M_X64)
+
+static inline void GDALStatsLoad4( const float* pafData,
+                                   __m128d& v0, __m128d& v1 )
+{
+    const __m128 v = _mm_loadu_ps(pafData);
+    v0 = _mm_cvtps_pd(v);
+    v1 = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+}
+
+static inline void GDALStatsLoad4( const double* padfData,
+                                   __m128d& v0, __m128d& v1 )
+{
+    v0 = _mm_loadu_pd(padfData);
+    v1 = _mm_loadu_pd(padfData + 2);
+}
+
+/* Same test as !CPLIsNan(v) && !ARE_REAL_EQUAL(v, dfNoDataValue) */
+
+static inline __m128d GDALStatsValidMask( __m128d v, bool bHasNoData,
+                                          __m128d vNoData, bool bNoDataIsZero )
+{
+    const __m128d vValid = _mm_cmpord_pd(v, v);
+    if( !bHasNoData )
+        return vValid;
+    const __m128d vAbsMask =
+        _mm_castsi128_pd(_mm_set1_epi64x(GINTBIG_MAX));
+    const __m128d vEps = _mm_set1_pd(1e-10);
+    __m128d vEqual = _mm_or_pd(_mm_cmpeq_pd(v, vNoData),
+        _mm_cmplt_pd(_mm_and_pd(_mm_sub_pd(v, vNoData), vAbsMask), vEps));
+    if( !bNoDataIsZero )
+    {
+        vEqual = _mm_or_pd(vEqual, _mm_cmplt_pd(
+            _mm_and_pd(_mm_sub_pd(_mm_set1_pd(1.0), _mm_div_pd(v, vNoData)),
+                       vAbsMask), vEps));
+    }
+    return _mm_andnot_pd(vEqual, vValid);
+}
+
+static inline double GDALStatsHSum( __m128d v )
+{
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+#endif // defined(__x86_64) || defined(_M_X64)
+
+template<class T, bool bMinMaxOnly>
+static void GDALAccumulateFloatSpan( const T* pData, int nCount,
+                                     bool bHasNoData, double dfNoDataValue,
+                                     GDALBandStats& sStats )
+{
+    GUIntBig nValid = 0;
+    double dfSum = 0.0;
+    double dfMin = std::numeric_limits<double>::infinity();
+    double dfMax = -std::numeric_limits<double>::infinity();
+    int i = 0;
+#if defined(__x86_64) || defined(_M_X64)
+    const __m128d vNoData = _mm_set1_pd(dfNoDataValue);
+    const bool bNoDataIsZero = (dfNoDataValue == 0.0);
+    const __m128d vOne = _mm_set1_pd(1.0);
+    const __m128d vInf = _mm_set1_pd(dfMin);
+    const __m128d vMinusInf = _mm_set1_pd(dfMax);
+    if( nCount >= 4 )
+    {
+        __m128d vCount = _mm_setzero_pd();
+        __m128d vSum = _mm_setzero_pd();
+        __m128d vMin = vInf;
+        __m128d vMax = vMinusInf;
+        for( ; i + 4 <= nCount; i += 4 )
+        {
+            __m128d av[2];
+            GDALStatsLoad4(pData + i, av[0], av[1]);
+            for( int j = 0; j < 2; j++ )
+            {
+                const __m128d v = av[j];
+                const __m128d vValid =
+                    GDALStatsValidMask(v, bHasNoData, vNoData, bNoDataIsZero);
+                const __m128d vMasked = _mm_and_pd(vValid, v);
+                vCount = _mm_add_pd(vCount, _mm_and_pd(vValid, vOne));
+                vMin = _mm_min_pd(vMin,
+                        _mm_or_pd(vMasked, _mm_andnot_pd(vValid, vInf)));
+                vMax = _mm_max_pd(vMax,
+                        _mm_or_pd(vMasked, _mm_andnot_pd(vValid, vMinusInf)));
+                if( !bMinMaxOnly )
+                    vSum = _mm_add_pd(vSum, vMasked);
+            }
         }
-        else
-            nSampleRate = 1;
+        nValid = static_cast<GUIntBig>(GDALStatsHSum(vCount));
+        dfSum = GDALStatsHSum(vSum);
+        double adfTmp[2];
+        _mm_storeu_pd(adfTmp, vMin);
+        dfMin = MIN(adfTmp[0], adfTmp[1]);
+        _mm_storeu_pd(adfTmp, vMax);
+        dfMax = MAX(adfTmp[0], adfTmp[1]);
+    }
+#endif
+    for( ; i < nCount; i++ )
+    {
+        const double dfValue = pData[i];
+        if( CPLIsNan(dfValue) ||
+            (bHasNoData && ARE_REAL_EQUAL(dfValue, dfNoDataValue)) )
+            continue;
+        nValid ++;
+        dfSum += dfValue;
+        dfMin = MIN(dfMin, dfValue);
+        dfMax = MAX(dfMax, dfValue);
+    }
+    if( nValid == 0 )
+        return;
+    if( bMinMaxOnly )
+    {
+        sStats.Merge( nValid, dfMin, dfMax, 0.0, 0.0 );
+        return;
+    }
 
-/* -------------------------------------------------------------------- */
-/*      Read the blocks, and add to histogram.                          */
-/* -------------------------------------------------------------------- */
-        for( int iSampleBlock = 0;
-             iSampleBlock < nBlocksPerRow * nBlocksPerColumn;
-             iSampleBlock += nSampleRate )
+    const double dfMean = dfSum / nValid;
+    double dfM2 = 0.0;
+    double dfComp = 0.0;
+    i = 0;
+#if defined(__x86_64) || defined(_M_X64)
+    if( nCount >= 4 )
+    {
+        const __m128d vMean = _mm_set1_pd(dfMean);
+        __m128d vM2 = _mm_setzero_pd();
+        __m128d vComp = _mm_setzero_pd();
+        for( ; i + 4 <= nCount; i += 4 )
         {
-            int  nXCheck, nYCheck;
+            __m128d av[2];
+            GDALStatsLoad4(pData + i, av[0], av[1]);
+            for( int j = 0; j < 2; j++ )
+            {
+                const __m128d vValid = GDALStatsValidMask(
+                    av[j], bHasNoData, vNoData, bNoDataIsZero);
+                const __m128d vDelta =
+                    _mm_and_pd(vValid, _mm_sub_pd(av[j], vMean));
+                vM2 = _mm_add_pd(vM2, _mm_mul_pd(vDelta, vDelta));
+                vComp = _mm_add_pd(vComp, vDelta);
+            }
+        }
+        dfM2 = GDALStatsHSum(vM2);
+        dfComp = GDALStatsHSum(vComp);
+    }
+#endif
+    for( ; i < nCount; i++ )
+    {
+        const double dfValue = pData[i];
+        if( CPLIsNan(dfValue) ||
+            (bHasNoData && ARE_REAL_EQUAL(dfValue, dfNoDataValue)) )
+            continue;
+        const double dfDelta = dfValue - dfMean;
+        dfM2 += dfDelta * dfDelta;
+        dfComp += dfDelta;
+    }
+    dfM2 = MAX(0.0, dfM2 - dfComp * dfComp / nValid);
 
-            if( !pfnProgress( iSampleBlock
-                              / ((double)nBlocksPerRow * nBlocksPerColumn),
-                              "Compute Histogram", pProgressData ) )
-                return CE_Failure;
+    sStats.Merge( nValid, dfMin, dfMax, dfMean, dfM2 );
+}
 
-            int iYBlock = iSampleBlock / nBlocksPerRow;
-            int iXBlock = iSampleBlock - nBlocksPerRow * iYBlock;
+template<class T, bool bMinMaxOnly>
+static void GDALComputeFloatStatistics( const T* pData,
+                                        int nXCheck, int nYCheck,
+                                        int nLineStride,
+                                        const GDALStatsKernelArgs& sArgs,
+                                        GDALBandStats& sStats )
+{
+    for( int iY = 0; iY < nYCheck; iY++ )
+    {
+        const T* pLine = pData + static_cast<size_t>(iY) * nLineStride;
+        for( int iX = 0; iX < nXCheck; iX += GDAL_STATS_FLOAT_CHUNK )
+        {
+            GDALAccumulateFloatSpan<T, bMinMaxOnly>(
+                pLine + iX, MIN(nXCheck - iX, GDAL_STATS_FLOAT_CHUNK),
+                sArgs.bGotNoDataValue, sArgs.dfNoDataValue, sStats );
+        }
+    }
+}
 
-            GDALRasterBlock *poBlock = GetLockedBlockRef( iXBlock, iYBlock );
-            if( poBlock == NULL )
-                return CE_Failure;
+/************************************************************************/
+/*                   GDALComputeGenericStatistics()                     */
+/************************************************************************/
 
-            void *pData = poBlock->GetDataRef();
+/* Welford algorithm ( http://en.wikipedia.org/wiki/Algorithms_for_calculating_variance ) */
+/* for the other data types. */
 
-            if( (iXBlock+1) * nBlockXSize > GetXSize() )
-                nXCheck = GetXSize() - iXBlock * nBlockXSize;
-            else
-                nXCheck = nBlockXSize;
+static void GDALComputeGenericStatistics( const void* pData,
+                                          int nXCheck, int nYCheck,
+                                          int nLineStride,
+                                          const GDALStatsKernelArgs& sArgs,
+                                          GDALBandStats& sStats )
+{
+    const bool bGotNoDataValue = sArgs.bGotNoDataValue;
+    const double dfNoDataValue = sArgs.dfNoDataValue;
+    double dfMin = 0.0, dfMax = 0.0, dfMean = 0.0, dfM2 = 0.0;
+    GUIntBig nSampleCount = 0;
 
-            if( (iYBlock+1) * nBlockYSize > GetYSize() )
-                nYCheck = GetYSize() - iYBlock * nBlockYSize;
-            else
-                nYCheck = nBlockYSize;
+    for( int iY = 0; iY < nYCheck; iY++ )
+    {
+        for( int iX = 0; iX < nXCheck; iX++ )
+        {
+            const GPtrDiff_t iOffset =
+                iX + static_cast<GPtrDiff_t>(iY) * nLineStride;
+            double dfValue = 0.0;
 
-            /* this is a special case for a common situation */
-            if( eDataType == GDT_Byte && !bSignedByte
-                && dfScale == 1.0 && (dfMin >= -0.5 && dfMin <= 0.5)
-                && nYCheck == nBlockYSize && nXCheck == nBlockXSize
-                && nBuckets == 256 )
+            switch( sArgs.eDataType )
             {
-                int    nPixels = nXCheck * nYCheck;
-                GByte  *pabyData = (GByte *) pData;
+              case GDT_Byte:
+              {
+                if (sArgs.bSignedByte)
+                    dfValue = ((signed char *)pData)[iOffset];
+                else
+                    dfValue = ((GByte *)pData)[iOffset];
+                break;
+              }
+              case GDT_UInt16:
+                dfValue = ((GUInt16 *)pData)[iOffset];
+                break;
+              case GDT_Int16:
+                dfValue = ((GInt16 *)pData)[iOffset];
+                break;
+              case GDT_UInt32:
+                dfValue = ((GUInt32 *)pData)[iOffset];
+                break;
+              case GDT_Int32:
+                dfValue = ((GInt32 *)pData)[iOffset];
+                break;
+              case GDT_Float32:
+                dfValue = ((float *)pData)[iOffset];
+                if (CPLIsNan(dfValue))
+                    continue;
+                break;
+              case GDT_Float64:
+                dfValue = ((double *)pData)[iOffset];
+                if (CPLIsNan(dfValue))
+                    continue;
+                break;
+              case GDT_CInt16:
+                dfValue = ((GInt16 *)pData)[iOffset*2];
+                break;
+              case GDT_CInt32:
+                dfValue = ((GInt32 *)pData)[iOffset*2];
+                break;
+              case GDT_CFloat32:
+                dfValue = ((float *)pData)[iOffset*2];
+                if( CPLIsNan(dfValue) )
+                    continue;
+                break;
+              case GDT_CFloat64:
+                dfValue = ((double *)pData)[iOffset*2];
+                if( CPLIsNan(dfValue) )
+                    continue;
+                break;
+              default:
+                CPLAssert( FALSE );
+            }
 
-                for( int i = 0; i < nPixels; i++ )
-                    if (! (bGotNoDataValue && (pabyData[i] == (GByte)dfNoDataValue)))
-                    {
-                        panHistogram[pabyData[i]]++;
-                    }
+            if( bGotNoDataValue && ARE_REAL_EQUAL(dfValue, dfNoDataValue) )
+                continue;
 
-                poBlock->DropLock();
-                continue; /* to next sample block */
+            if( nSampleCount == 0 )
+            {
+                dfMin = dfMax = dfValue;
+            }
+            else
+            {
+                dfMin = MIN(dfMin,dfValue);
+                dfMax = MAX(dfMax,dfValue);
             }
 
-            /* this isn't the fastest way to do this, but is easier for now */
-            for( int iY = 0; iY < nYCheck; iY++ )
+            nSampleCount++;
+            if( !sArgs.bMinMaxOnly )
             {
-                for( int iX = 0; iX < nXCheck; iX++ )
-                {
-                    int    iOffset = iX + iY * nBlockXSize;
-                    int    nIndex;
-                    double dfValue = 0.0;
+                const double dfDelta = dfValue - dfMean;
+                dfMean += dfDelta / nSampleCount;
+                dfM2 += dfDelta * (dfValue - dfMean);
+            }
+        }
+    }
 
-                    switch( eDataType )
-                    {
-                      case GDT_Byte:
-                      {
-                        if (bSignedByte)
-                            dfValue = ((signed char *) pData)[iOffset];
-                        else
-                            dfValue = ((GByte *) pData)[iOffset];
-                        break;
-                      }
-                      case GDT_UInt16:
-                        dfValue = ((GUInt16 *) pData)[iOffset];
-                        break;
-                      case GDT_Int16:
-                        dfValue = ((GInt16 *) pData)[iOffset];
-                        break;
-                      case GDT_UInt32:
-                        dfValue = ((GUInt32 *) pData)[iOffset];
-                        break;
-                      case GDT_Int32:
-                        dfValue = ((GInt32 *) pData)[iOffset];
-                        break;
-                      case GDT_Float32:
-                        dfValue = ((float *) pData)[iOffset];
-                        if (CPLIsNan(dfValue))
-                            continue;
-                        break;
-                      case GDT_Float64:
-                        dfValue = ((double *) pData)[iOffset];
-                        if (CPLIsNan(dfValue))
-                            continue;
-                        break;
-                      case GDT_CInt16:
-                        {
-                            double  dfReal =
-                                ((GInt16 *) pData)[iOffset*2];
-                            double  dfImag =
-                                ((GInt16 *) pData)[iOffset*2+1];
-                            dfValue = sqrt( dfReal * dfReal + dfImag * dfImag );
-                        }
-                        break;
-                      case GDT_CInt32:
-                        {
-                            double  dfReal =
-                                ((GInt32 *) pData)[iOffset*2];
-                            double  dfImag =
-                                ((GInt32 *) pData)[iOffset*2+1];
-                            dfValue = sqrt( dfReal * dfReal + dfImag * dfImag );
-                        }
-                        break;
-                      case GDT_CFloat32:
-                        {
-                            double  dfReal =
-                                ((float *) pData)[iOffset*2];
-                            double  dfImag =
-                                ((float *) pData)[iOffset*2+1];
-                            if ( CPLIsNan(dfReal) || CPLIsNan(dfImag) )
-                                continue;
-                            dfValue = sqrt( dfReal * dfReal + dfImag * dfImag );
-                        }
-                        break;
-                      case GDT_CFloat64:
-                        {
-                            double  dfReal =
-                                ((double *) pData)[iOffset*2];
-                            double  dfImag =
-                                ((double *) pData)[iOffset*2+1];
-                            if ( CPLIsNan(dfReal) || CPLIsNan(dfImag) )
-                                continue;
-                            dfValue = sqrt( dfReal * dfReal + dfImag * dfImag );
-                        }
-                        break;
-                      default:
-                        CPLAssert( FALSE );
-                        return CE_Failure;
-                    }
+    sStats.Merge( nSampleCount, dfMin, dfMax, dfMean, dfM2 );
+}
 
-                    if( bGotNoDataValue && ARE_REAL_EQUAL(dfValue, dfNoDataValue) )
-                        continue;
+/************************************************************************/
+/*                    GDALComputeBufferStatistics()                     */
+/************************************************************************/
 
-                    nIndex = (int) floor((dfValue - dfMin) * dfScale);
+/* Accumulate in sStats the statistics of a nXCheck x nYCheck window of a */
+/* buffer whose lines are nLineStride pixels apart. */
 
-                    if( nIndex < 0 )
-                    {
-                        if( bIncludeOutOfRange )
-                            panHistogram[0]++;
-                    }
-                    else if( nIndex >= nBuckets )
-                    {
-                        if( bIncludeOutOfRange )
-                            panHistogram[nBuckets-1]++;
-                    }
-                    else
-                    {
-                        panHistogram[nIndex]++;
-                    }
-                }
+static void GDALComputeBufferStatistics( const void* pData,
+                                         int nXCheck, int nYCheck,
+                                         int nLineStride,
+                                         const GDALStatsKernelArgs& sArgs,
+                                         GDALBandStats& sStats )
+{
+    if( !sArgs.bFastPath )
+    {
+        GDALComputeGenericStatistics( pData, nXCheck, nYCheck, nLineStride,
+                                      sArgs, sStats );
+    }
+    else if( sArgs.eDataType == GDT_Float32 )
+    {
+        if( sArgs.bMinMaxOnly )
+            GDALComputeFloatStatistics<float, true>(
+                static_cast<const float*>(pData), nXCheck, nYCheck,
+                nLineStride, sArgs, sStats );
+        else
+            GDALComputeFloatStatistics<float, false>(
+                static_cast<const float*>(pData), nXCheck, nYCheck,
+                nLineStride, sArgs, sStats );
+    }
+    else if( sArgs.eDataType == GDT_Float64 )
+    {
+        if( sArgs.bMinMaxOnly )
+            GDALComputeFloatStatistics<double, true>(
+                static_cast<const double*>(pData), nXCheck, nYCheck,
+                nLineStride, sArgs, sStats );
+        else
+            GDALComputeFloatStatistics<double, false>(
+                static_cast<const double*>(pData), nXCheck, nYCheck,
+                nLineStride, sArgs, sStats );
+    }
+    else
+    {
+        if( sArgs.bMinMaxOnly )
+            GDALComputeIntStatistics<true>( pData, nXCheck, nYCheck,
+                                            nLineStride, sArgs, sStats );
+        else
+            GDALComputeIntStatistics<false>( pData, nXCheck, nYCheck,
+                                             nLineStride, sArgs, sStats );
+    }
+}
+
+/************************************************************************/
+/*                          GDALHistogramArgs                           */
+/************************************************************************/
+
+namespace {
+
+struct GDALHistogramArgs
+{
+    GDALDataType eDataType;
+    bool         bSignedByte;
+    double       dfMin;
+    double       dfScale;
+    int          nBuckets;
+    bool         bIncludeOutOfRange;
+    bool         bGotNoDataValue;
+    double       dfNoDataValue;
+
+    // For Byte, UInt16 and Int16: the occurrences of each raw value are
+    // counted, and only mapped to the buckets at the end. 0 otherwise.
+    int          nRawValues;
+};
+
+} // end anonymous namespace
+
+static void GDALInitHistogramArgs( GDALHistogramArgs& sArgs,
+                                   GDALDataType eDataType,
+                                   bool bSignedByte,
+                                   double dfMin, double dfMax, int nBuckets,
+                                   bool bIncludeOutOfRange,
+                                   bool bGotNoDataValue,
+                                   double dfNoDataValue )
+{
+    sArgs.eDataType = eDataType;
+    sArgs.bSignedByte = bSignedByte;
+    sArgs.dfMin = dfMin;
+    sArgs.dfScale = nBuckets / (dfMax - dfMin);
+    sArgs.nBuckets = nBuckets;
+    sArgs.bIncludeOutOfRange = bIncludeOutOfRange;
+    sArgs.bGotNoDataValue = bGotNoDataValue;
+    sArgs.dfNoDataValue = dfNoDataValue;
+
+    if( eDataType == GDT_Byte )
+        sArgs.nRawValues = 256;
+    else if( eDataType == GDT_UInt16 || eDataType == GDT_Int16 )
+        sArgs.nRawValues = 65536;
+    else
+        sArgs.nRawValues = 0;
+}
+
+/* Number of counters into which GDALComputeBufferHistogram() accumulates. */
+static int GDALGetHistogramCounterCount( const GDALHistogramArgs& sArgs )
+{
+    return sArgs.nRawValues > 0 ? sArgs.nRawValues : sArgs.nBuckets;
+}
+
+static inline void GDALAddToHistogram( double dfValue, GUIntBig nCount,
+                                       const GDALHistogramArgs& sArgs,
+                                       GUIntBig* panHistogram )
+{
+    if( sArgs.bGotNoDataValue && ARE_REAL_EQUAL(dfValue, sArgs.dfNoDataValue) )
+        return;
+
+    const int nIndex =
+        static_cast<int>(floor((dfValue - sArgs.dfMin) * sArgs.dfScale));
+
+    if( nIndex < 0 )
+    {
+        if( sArgs.bIncludeOutOfRange )
+            panHistogram[0] += nCount;
+    }
+    else if( nIndex >= sArgs.nBuckets )
+    {
+        if( sArgs.bIncludeOutOfRange )
+            panHistogram[sArgs.nBuckets-1] += nCount;
+    }
+    else
+    {
+        panHistogram[nIndex] += nCount;
+    }
+}
+
+/************************************************************************/
+/*                     GDALComputeBufferHistogram()                     */
+/************************************************************************/
+
+static void GDALCountByteValues( const GByte* pabyData,
+                                 int nXCheck, int nYCheck, int nLineStride,
+                                 GUIntBig* panCounts )
+{
+    // Four sets of counters, so that runs of identical values do not
+    // serialize on the increments of a single counter.
+    GUInt32 anCounts[4][256];
+    memset( anCounts, 0, sizeof(anCounts) );
+
+    for( int iY = 0; iY < nYCheck; iY++ )
+    {
+        const GByte* pabyLine =
+            pabyData + static_cast<size_t>(iY) * nLineStride;
+        int iX = 0;
+        for( ; iX + 4 <= nXCheck; iX += 4 )
+        {
+            anCounts[0][pabyLine[iX]] ++;
+            anCounts[1][pabyLine[iX+1]] ++;
+            anCounts[2][pabyLine[iX+2]] ++;
+            anCounts[3][pabyLine[iX+3]] ++;
+        }
+        for( ; iX < nXCheck; iX++ )
+            anCounts[0][pabyLine[iX]] ++;
+    }
+
+    for( int i = 0; i < 256; i++ )
+        panCounts[i] += static_cast<GUIntBig>(anCounts[0][i]) +
+            anCounts[1][i] + anCounts[2][i] + anCounts[3][i];
+}
+
+static void GDALCountUInt16Values( const GUInt16* panData,
+                                   int nXCheck, int nYCheck, int nLineStride,
+                                   GUIntBig* panCounts )
+{
+    for( int iY = 0; iY < nYCheck; iY++ )
+    {
+        const GUInt16* panLine =
+            panData + static_cast<size_t>(iY) * nLineStride;
+        for( int iX = 0; iX < nXCheck; iX++ )
+            panCounts[panLine[iX]] ++;
+    }
+}
+
+template<class T>
+static void GDALAccumulateHistogram( const T* pData,
+                                     int nXCheck, int nYCheck, int nLineStride,
+                                     const GDALHistogramArgs& sArgs,
+                                     GUIntBig* panHistogram )
+{
+    for( int iY = 0; iY < nYCheck; iY++ )
+    {
+        const T* pLine = pData + static_cast<size_t>(iY) * nLineStride;
+        for( int iX = 0; iX < nXCheck; iX++ )
+        {
+            const double dfValue = pLine[iX];
+            if( CPLIsNan(dfValue) )
+                continue;
+            GDALAddToHistogram( dfValue, 1, sArgs, panHistogram );
+        }
+    }
+}
+
+/* The histogram of complex values is the one of their magnitude. */
+template<class T>
+static void GDALAccumulateComplexHistogram( const T* pData,
+                                            int nXCheck, int nYCheck,
+                                            int nLineStride,
+                                            const GDALHistogramArgs& sArgs,
+                                            GUIntBig* panHistogram )
+{
+    for( int iY = 0; iY < nYCheck; iY++ )
+    {
+        const T* pLine = pData + static_cast<size_t>(iY) * nLineStride * 2;
+        for( int iX = 0; iX < nXCheck; iX++ )
+        {
+            const double dfReal = pLine[iX*2];
+            const double dfImag = pLine[iX*2+1];
+            if( CPLIsNan(dfReal) || CPLIsNan(dfImag) )
+                continue;
+            GDALAddToHistogram( sqrt( dfReal * dfReal + dfImag * dfImag ), 1,
+                                sArgs, panHistogram );
+        }
+    }
+}
+
+/* Accumulate in panCounts the histogram of a nXCheck x nYCheck window of */
+/* a buffer whose lines are nLineStride pixels apart. panCounts has       */
+/* GDALGetHistogramCounterCount() elements, and must be converted with    */
+/* GDALHistogramCountsToBuckets() once all the data has been processed.   */
+
+static void GDALComputeBufferHistogram( const void* pData,
+                                        int nXCheck, int nYCheck,
+                                        int nLineStride,
+                                        const GDALHistogramArgs& sArgs,
+                                        GUIntBig* panCounts )
+{
+    switch( sArgs.eDataType )
+    {
+      case GDT_Byte:
+        GDALCountByteValues( static_cast<const GByte*>(pData),
+                             nXCheck, nYCheck, nLineStride, panCounts );
+        break;
+      case GDT_UInt16:
+      case GDT_Int16:
+        GDALCountUInt16Values( static_cast<const GUInt16*>(pData),
+                               nXCheck, nYCheck, nLineStride, panCounts );
+        break;
+      case GDT_UInt32:
+        GDALAccumulateHistogram( static_cast<const GUInt32*>(pData),
+                                 nXCheck, nYCheck, nLineStride,
+                                 sArgs, panCounts );
+        break;
+      case GDT_Int32:
+        GDALAccumulateHistogram( static_cast<const GInt32*>(pData),
+                                 nXCheck, nYCheck, nLineStride,
+                                 sArgs, panCounts );
+        break;
+      case GDT_Float32:
+        GDALAccumulateHistogram( static_cast<const float*>(pData),
+                                 nXCheck, nYCheck, nLineStride,
+                                 sArgs, panCounts );
+        break;
+      case GDT_Float64:
+        GDALAccumulateHistogram( static_cast<const double*>(pData),
+                                 nXCheck, nYCheck, nLineStride,
+                                 sArgs, panCounts );
+        break;
+      case GDT_CInt16:
+        GDALAccumulateComplexHistogram( static_cast<const GInt16*>(pData),
+                                        nXCheck, nYCheck, nLineStride,
+                                        sArgs, panCounts );
+        break;
+      case GDT_CInt32:
+        GDALAccumulateComplexHistogram( static_cast<const GInt32*>(pData),
+                                        nXCheck, nYCheck, nLineStride,
+                                        sArgs, panCounts );
+        break;
+      case GDT_CFloat32:
+        GDALAccumulateComplexHistogram( static_cast<const float*>(pData),
+                                        nXCheck, nYCheck, nLineStride,
+                                        sArgs, panCounts );
+        break;
+      case GDT_CFloat64:
+        GDALAccumulateComplexHistogram( static_cast<const double*>(pData),
+                                        nXCheck, nYCheck, nLineStride,
+                                        sArgs, panCounts );
+        break;
+      default:
+        CPLAssert( FALSE );
+        break;
+    }
+}
+
+/************************************************************************/
+/*                    GDALHistogramCountsToBuckets()                    */
+/************************************************************************/
+
+/* Add the counters accumulated by GDALComputeBufferHistogram() to the   */
+/* nBuckets elements of panHistogram. */
+
+static void GDALHistogramCountsToBuckets( const GDALHistogramArgs& sArgs,
+                                          const GUIntBig* panCounts,
+                                          GUIntBig* panHistogram )
+{
+    if( sArgs.nRawValues == 0 )
+    {
+        for( int i = 0; i < sArgs.nBuckets; i++ )
+            panHistogram[i] += panCounts[i];
+        return;
+    }
+
+    // Map each raw value exactly as if its pixels had been processed one
+    // by one.
+    for( int i = 0; i < sArgs.nRawValues; i++ )
+    {
+        if( panCounts[i] == 0 )
+            continue;
+
+        double dfValue;
+        if( sArgs.eDataType == GDT_Int16 )
+            dfValue = static_cast<GInt16>(i);
+        else if( sArgs.bSignedByte )
+            dfValue = static_cast<signed char>(i);
+        else
+            dfValue = i;
+
+        GDALAddToHistogram( dfValue, panCounts[i], sArgs, panHistogram );
+    }
+}
+
+/************************************************************************/
+/*                     GDALComputeBlockStatistics()                     */
+/************************************************************************/
+
+namespace {
+
+struct GDALStatsBlock
+{
+    const void*                 pData;
+    int                         nXCheck;
+    int                         nYCheck;
+    int                         nLineStride;
+    GDALBandStats               sStats;
+};
+
+/* A job processes the blocks iFirstBlock, iFirstBlock + nBlockStep, ...  */
+/* of a batch, and accumulates their histogram into its own counters. */
+struct GDALStatsJob
+{
+    GDALStatsBlock*             pasBlocks;
+    int                         nBlocks;
+    int                         iFirstBlock;
+    int                         nBlockStep;
+    const GDALStatsKernelArgs*  psStatsArgs;
+    const GDALHistogramArgs*    psHistArgs;
+    GUIntBig*                   panHistCounts;
+};
+
+} // end anonymous namespace
+
+static void GDALComputeStatsJobFunc( void* pData )
+{
+    GDALStatsJob* psJob = static_cast<GDALStatsJob*>(pData);
+    for( int i = psJob->iFirstBlock; i < psJob->nBlocks;
+         i += psJob->nBlockStep )
+    {
+        GDALStatsBlock& sBlock = psJob->pasBlocks[i];
+        if( psJob->psStatsArgs != NULL )
+            GDALComputeBufferStatistics( sBlock.pData, sBlock.nXCheck,
+                                         sBlock.nYCheck, sBlock.nLineStride,
+                                         *(psJob->psStatsArgs),
+                                         sBlock.sStats );
+        if( psJob->psHistArgs != NULL )
+            GDALComputeBufferHistogram( sBlock.pData, sBlock.nXCheck,
+                                        sBlock.nYCheck, sBlock.nLineStride,
+                                        *(psJob->psHistArgs),
+                                        psJob->panHistCounts );
+    }
+}
+
+/* Accumulate, in a single pass over one block every nSampleRate blocks   */
+/* of a band, the statistics into *psStats if psStatsArgs is not NULL,    */
+/* and the histogram into panHistCounts if psHistArgs is not NULL. The    */
+/* blocks are read by the calling thread. When GDAL_NUM_THREADS is set,   */
+/* they are processed by batches in a pool of worker threads, each one    */
+/* with private histogram counters that are summed at the end. The        */
+/* statistics of the blocks are always merged in the same order, so the   */
+/* result does not depend on the number of threads. Blocks that cannot be */
+/* read are skipped if bSkipFailedBlocks is set. Returns false on error,  */
+/* or if interrupted by the progress function. */
+
+static bool GDALComputeBlockStatistics( GDALRasterBand* poBand,
+                                        int nSampleRate,
+                                        const GDALStatsKernelArgs* psStatsArgs,
+                                        GDALBandStats* psStats,
+                                        const GDALHistogramArgs* psHistArgs,
+                                        GUIntBig* panHistCounts,
+                                        bool bSkipFailedBlocks,
+                                        const char* pszMessage,
+                                        GDALProgressFunc pfnProgress,
+                                        void* pProgressData )
+{
+    int nBlockXSize = 0, nBlockYSize = 0;
+    poBand->GetBlockSize( &nBlockXSize, &nBlockYSize );
+    const int nXSize = poBand->GetXSize();
+    const int nYSize = poBand->GetYSize();
+    const int nBlocksPerRow = DIV_ROUND_UP(nXSize, nBlockXSize);
+    const int nBlocksPerColumn = DIV_ROUND_UP(nYSize, nBlockYSize);
+    const int nBlocks = nBlocksPerRow * nBlocksPerColumn;
+    const int nSampledBlocks = DIV_ROUND_UP(nBlocks, nSampleRate);
+
+    int nThreads = 0;
+    const char* pszValue = CPLGetConfigOption("GDAL_NUM_THREADS", NULL);
+    if( pszValue )
+    {
+        if( EQUAL(pszValue, "ALL_CPUS") )
+            nThreads = CPLGetNumCPUs();
+        else
+            nThreads = atoi(pszValue);
+    }
+    nThreads = MIN(nThreads, nSampledBlocks);
+
+    // The blocks of a batch are locked in the block cache at the same time
+    const GIntBig nBlockBytes = static_cast<GIntBig>(nBlockXSize) *
+        nBlockYSize * GDALGetDataTypeSizeBytes(poBand->GetRasterDataType());
+    int nBatchSize = 1;
+    CPLWorkerThreadPool* poPool = NULL;
+    if( nThreads > 1 )
+    {
+        nBatchSize = static_cast<int>(MIN(static_cast<GIntBig>(2 * nThreads),
+            MAX(1, GDALGetCacheMax64() / 4 / MAX(1, nBlockBytes))));
+    }
+    if( nBatchSize > 1 )
+    {
+        poPool = new CPLWorkerThreadPool();
+        if( !poPool->Setup(nThreads, NULL, NULL) )
+        {
+            delete poPool;
+            poPool = NULL;
+            nBatchSize = 1;
+        }
+    }
+
+    // Each job but the first one, that uses panHistCounts directly, has its
+    // own histogram counters.
+    const int nJobs = (poPool != NULL) ? MIN(nThreads, nBatchSize) : 1;
+    const int nCounters =
+        (psHistArgs != NULL) ? GDALGetHistogramCounterCount(*psHistArgs) : 0;
+    std::vector<GUIntBig> anJobCounters(
+        static_cast<size_t>(nJobs - 1) * nCounters, 0 );
+
+    std::vector<GDALStatsBlock> asBlocks(nBatchSize);
+    std::vector<GDALRasterBlock*> apoBlocks(nBatchSize);
+    std::vector<GDALStatsJob> asJobs(nJobs);
+    std::vector<void*> apJobs;
+    for( int i = 0; i < nJobs; i++ )
+    {
+        GDALStatsJob& sJob = asJobs[i];
+        sJob.pasBlocks = &asBlocks[0];
+        sJob.nBlocks = 0;
+        sJob.iFirstBlock = i;
+        sJob.nBlockStep = nJobs;
+        sJob.psStatsArgs = psStatsArgs;
+        sJob.psHistArgs = psHistArgs;
+        if( psHistArgs == NULL )
+            sJob.panHistCounts = NULL;
+        else if( i == 0 )
+            sJob.panHistCounts = panHistCounts;
+        else
+            sJob.panHistCounts =
+                &anJobCounters[static_cast<size_t>(i - 1) * nCounters];
+    }
+
+    bool bRet = true;
+
+    int iSampleBlock = 0;
+    while( bRet && iSampleBlock < nBlocks )
+    {
+        int nBatchBlocks = 0;
+        int iLastBlock = iSampleBlock;
+        for( ; nBatchBlocks < nBatchSize && iSampleBlock < nBlocks;
+               iSampleBlock += nSampleRate )
+        {
+            const int iYBlock = iSampleBlock / nBlocksPerRow;
+            const int iXBlock = iSampleBlock - nBlocksPerRow * iYBlock;
+            iLastBlock = iSampleBlock;
+
+            GDALRasterBlock* poBlock = poBand->GetLockedBlockRef( iXBlock,
+                                                                  iYBlock );
+            if( poBlock == NULL )
+            {
+                if( bSkipFailedBlocks )
+                    continue;
+                bRet = false;
+                break;
             }
 
-            poBlock->DropLock();
+            GDALStatsBlock& sBlock = asBlocks[nBatchBlocks];
+            sBlock.pData = poBlock->GetDataRef();
+            sBlock.nXCheck = MIN(nBlockXSize, nXSize - iXBlock * nBlockXSize);
+            sBlock.nYCheck = MIN(nBlockYSize, nYSize - iYBlock * nBlockYSize);
+            sBlock.nLineStride = nBlockXSize;
+            sBlock.sStats = GDALBandStats();
+            apoBlocks[nBatchBlocks] = poBlock;
+            nBatchBlocks ++;
+        }
+
+        if( bRet )
+        {
+            const int nActiveJobs = MIN(nJobs, nBatchBlocks);
+            for( int i = 0; i < nActiveJobs; i++ )
+                asJobs[i].nBlocks = nBatchBlocks;
+
+            if( nActiveJobs > 1 )
+            {
+                apJobs.resize(nActiveJobs);
+                for( int i = 0; i < nActiveJobs; i++ )
+                    apJobs[i] = &asJobs[i];
+                poPool->SubmitJobs( GDALComputeStatsJobFunc, apJobs );
+                poPool->WaitCompletion();
+            }
+            else if( nActiveJobs == 1 )
+            {
+                GDALComputeStatsJobFunc( &asJobs[0] );
+            }
+
+            if( psStats != NULL )
+            {
+                for( int i = 0; i < nBatchBlocks; i++ )
+                    psStats->Merge( asBlocks[i].sStats );
+            }
+        }
+
+        for( int i = 0; i < nBatchBlocks; i++ )
+            apoBlocks[i]->DropLock();
+
+        if( bRet && !pfnProgress( iLastBlock / static_cast<double>(nBlocks),
+                                  pszMessage, pProgressData ) )
+        {
+            poBand->ReportError( CE_Failure, CPLE_UserInterrupt,
+                                 "User terminated" );
+            bRet = false;
+        }
+    }
+
+    delete poPool;
+
+    for( int i = 1; i < nJobs && psHistArgs != NULL; i++ )
+    {
+        const GUIntBig* panCounts =
+            &anJobCounters[static_cast<size_t>(i - 1) * nCounters];
+        for( int j = 0; j < nCounters; j++ )
+            panHistCounts[j] += panCounts[j];
+    }
+
+    return bRet;
+}
+
+/************************************************************************/
+/*                            GetHistogram()                            */
+/************************************************************************/
+
+/**
+ * \brief Compute raster histogram.
+ *
+ * Note that the bucket size is (dfMax-dfMin) / nBuckets.
+ *
+ * For example to compute a simple 256 entry histogram of eight bit data,
+ * the following would be suitable.  The unusual bounds are to ensure that
+ * bucket boundaries don't fall right on integer values causing possible errors
+ * due to rounding after scaling.
+<pre>
+    GUIntBig anHistogram[256];
+
+    poBand->GetHistogram( -0.5, 255.5, 256, anHistogram, FALSE, FALSE,
+                          GDALDummyProgress, NULL );
+</pre>
+ *
+ * Note that setting bApproxOK will generally result in a subsampling of the
+ * file, and will utilize overviews if available.  It should generally
+ * produce a representative histogram for the data that is suitable for use
+ * in generating histogram based luts for instance.  Generally bApproxOK is
+ * much faster than an exactly computed histogram.
+ *
+ * This method is the same as the C functions GDALGetRasterHistogram() and
+ * GDALGetRasterHistogramEx().
+ *
+ * @param dfMin the lower bound of the histogram.
+ * @param dfMax the upper bound of the histogram.
+ * @param nBuckets the number of buckets in panHistogram.
+ * @param panHistogram array into which the histogram totals are placed.
+ * @param bIncludeOutOfRange if TRUE values below the histogram range will
+ * mapped into panHistogram[0], and values above will be mapped into
+ * panHistogram[nBuckets-1] otherwise out of range values are discarded.
+ * @param bApproxOK TRUE if an approximate, or incomplete histogram OK.
+ * @param pfnProgress function to report progress to completion.
+ * @param pProgressData application data to pass to pfnProgress.
+ *
+ * @return CE_None on success, or CE_Failure if something goes wrong.
+ */
+
+CPLErr GDALRasterBand::GetHistogram( double dfMin, double dfMax,
+                                     int nBuckets, GUIntBig *panHistogram,
+                                     int bIncludeOutOfRange, int bApproxOK,
+                                     GDALProgressFunc pfnProgress,
+                                     void *pProgressData )
+
+{
+    CPLAssert( NULL != panHistogram );
+
+    if( pfnProgress == NULL )
+        pfnProgress = GDALDummyProgress;
+
+/* -------------------------------------------------------------------- */
+/*      If we have overviews, use them for the histogram.               */
+/* -------------------------------------------------------------------- */
+    if( bApproxOK && GetOverviewCount() > 0 && !HasArbitraryOverviews() )
+    {
+        // FIXME: should we use the most reduced overview here or use some
+        // minimum number of samples like GDALRasterBand::ComputeStatistics()
+        // does?
+        GDALRasterBand *poBestOverview = GetRasterSampleOverview( 0 );
+
+        if( poBestOverview != this )
+        {
+            return poBestOverview->GetHistogram( dfMin, dfMax, nBuckets,
+                                                 panHistogram,
+                                                 bIncludeOutOfRange, bApproxOK,
+                                                 pfnProgress, pProgressData );
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Read actual data and build histogram.                           */
+/* -------------------------------------------------------------------- */
+    if( !pfnProgress( 0.0, "Compute Histogram", pProgressData ) )
+    {
+        ReportError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+        return CE_Failure;
+    }
+
+    GDALRasterIOExtraArg sExtraArg;
+    INIT_RASTERIO_EXTRA_ARG(sExtraArg);
+
+    memset( panHistogram, 0, sizeof(GUIntBig) * nBuckets );
+
+    int bGotNoDataValue;
+    const double dfNoDataValue = GetNoDataValue( &bGotNoDataValue );
+    bGotNoDataValue = bGotNoDataValue && !CPLIsNan(dfNoDataValue);
+    /* Not advertized. May be removed at any time. Just as a provision if the */
+    /* old behaviour made sense somethimes... */
+    bGotNoDataValue = bGotNoDataValue &&
+        !CPLTestBool(CPLGetConfigOption("GDAL_NODATA_IN_HISTOGRAM", "NO"));
+
+    const char* pszPixelType = GetMetadataItem("PIXELTYPE", "IMAGE_STRUCTURE");
+    const bool bSignedByte = (pszPixelType != NULL && EQUAL(pszPixelType, "SIGNEDBYTE"));
+
+    GDALHistogramArgs sHistArgs;
+    GDALInitHistogramArgs( sHistArgs, eDataType, bSignedByte,
+                           dfMin, dfMax, nBuckets,
+                           CPL_TO_BOOL(bIncludeOutOfRange),
+                           CPL_TO_BOOL(bGotNoDataValue), dfNoDataValue );
+
+    std::vector<GUIntBig> anCounts(
+        MAX(1, GDALGetHistogramCounterCount(sHistArgs)), 0 );
+
+    if ( bApproxOK && HasArbitraryOverviews() )
+    {
+/* -------------------------------------------------------------------- */
+/*      Figure out how much the image should be reduced to get an       */
+/*      approximate value.                                              */
+/* -------------------------------------------------------------------- */
+        double  dfReduction = sqrt(
+            (double)nRasterXSize * nRasterYSize / GDALSTAT_APPROX_NUMSAMPLES );
+
+        int     nXReduced, nYReduced;
+
+        if ( dfReduction > 1.0 )
+        {
+            nXReduced = (int)( nRasterXSize / dfReduction );
+            nYReduced = (int)( nRasterYSize / dfReduction );
+
+            // Catch the case of huge resizing ratios here
+            if ( nXReduced == 0 )
+                nXReduced = 1;
+            if ( nYReduced == 0 )
+                nYReduced = 1;
+        }
+        else
+        {
+            nXReduced = nRasterXSize;
+            nYReduced = nRasterYSize;
+        }
+
+        void *pData =
+            CPLMalloc(
+                GDALGetDataTypeSizeBytes(eDataType) * nXReduced * nYReduced );
+
+        CPLErr eErr = IRasterIO( GF_Read, 0, 0, nRasterXSize, nRasterYSize, pData,
+                   nXReduced, nYReduced, eDataType, 0, 0, &sExtraArg );
+        if ( eErr != CE_None )
+        {
+            CPLFree(pData);
+            return eErr;
+        }
+
+        GDALComputeBufferHistogram( pData, nXReduced, nYReduced, nXReduced,
+                                    sHistArgs, &anCounts[0] );
+
+        CPLFree( pData );
+    }
+
+    else    // No arbitrary overviews
+    {
+
+        if( !InitBlockInfo() )
+            return CE_Failure;
+
+/* -------------------------------------------------------------------- */
+/*      Figure out the ratio of blocks we will read to get an           */
+/*      approximate value.                                              */
+/* -------------------------------------------------------------------- */
+
+        int nSampleRate;
+        if ( bApproxOK )
+        {
+            nSampleRate =
+                (int) MAX(1,sqrt((double) nBlocksPerRow * nBlocksPerColumn));
+            // We want to avoid probing only the first column of blocks for
+            // a square shaped raster, because it is not unlikely that it may
+            // be padding only (#6378)
+            if( nSampleRate == nBlocksPerRow && nBlocksPerRow > 1 )
+              nSampleRate += 1;
         }
+        else
+            nSampleRate = 1;
+
+/* -------------------------------------------------------------------- */
+/*      Read the blocks, and add to histogram.                          */
+/* -------------------------------------------------------------------- */
+        if( !GDALComputeBlockStatistics( this, nSampleRate, NULL, NULL,
+                                         &sHistArgs, &anCounts[0], false,
+                                         "Compute Histogram",
+                                         pfnProgress, pProgressData ) )
+            return CE_Failure;
     }
 
+    GDALHistogramCountsToBuckets( sHistArgs, &anCounts[0], panHistogram );
+
     pfnProgress( 1.0, "Compute Histogram", pProgressData );
 
     return CE_None;
@@ -3610,34 +4684,186 @@ GDALRasterBand::ComputeStatistics( int bApproxOK,
                                               pfnProgress, pProgressData );
     }
 
+    return ComputeStatisticsInternal( bApproxOK, pdfMin, pdfMax,
+                                      pdfMean, pdfStdDev,
+                                      0.0, 0.0, 0, NULL, FALSE,
+                                      pfnProgress, pProgressData );
+}
+
+/************************************************************************/
+/*                    GDALComputeRasterStatistics()                     */
+/************************************************************************/
+
+/**
+  * \brief Compute image statistics.
+  *
+  * @see GDALRasterBand::ComputeStatistics()
+  */
+
+CPLErr CPL_STDCALL GDALComputeRasterStatistics(
+        GDALRasterBandH hBand, int bApproxOK,
+        double *pdfMin, double *pdfMax, double *pdfMean, double *pdfStdDev,
+        GDALProgressFunc pfnProgress, void *pProgressData )
+
+{
+    VALIDATE_POINTER1( hBand, "GDALComputeRasterStatistics", CE_Failure );
+
+    GDALRasterBand *poBand = static_cast<GDALRasterBand*>(hBand);
+
+    return poBand->ComputeStatistics(
+        bApproxOK, pdfMin, pdfMax, pdfMean, pdfStdDev,
+        pfnProgress, pProgressData );
+}
+
+/************************************************************************/
+/*                   ComputeStatisticsAndHistogram()                    */
+/************************************************************************/
+
+/**
+ * \brief Compute image statistics and histogram in a single pass.
+ *
+ * This is equivalent to calling ComputeStatistics() and GetHistogram(),
+ * except that the pixel values are only read once, and that when
+ * approximate results are acceptable, both are computed from the same
+ * overview or subset of tiles. As ComputeStatistics() does, the computed
+ * statistics are "set" back on the raster band using SetStatistics().
+ *
+ * Note that the generic implementation is always used, even for drivers
+ * that override ComputeStatistics() or GetHistogram().
+ *
+ * This method is the same as the C function
+ * GDALComputeRasterStatisticsAndHistogram().
+ *
+ * @param bApproxOK If TRUE statistics and histogram may be computed based on
+ * overviews or a subset of all tiles.
+ * @param pdfMin Location into which to load image minimum (may be NULL).
+ * @param pdfMax Location into which to load image maximum (may be NULL).
+ * @param pdfMean Location into which to load image mean (may be NULL).
+ * @param pdfStdDev Location into which to load image standard deviation
+ * (may be NULL).
+ * @param dfHistMin the lower bound of the histogram.
+ * @param dfHistMax the upper bound of the histogram.
+ * @param nBuckets the number of buckets in panHistogram.
+ * @param panHistogram array into which the histogram totals are placed.
+ * @param bIncludeOutOfRange if TRUE values below the histogram range will
+ * mapped into panHistogram[0], and values above will be mapped into
+ * panHistogram[nBuckets-1] otherwise out of range values are discarded.
+ * @param pfnProgress a function to call to report progress, or NULL.
+ * @param pProgressData application data to pass to the progress function.
+ *
+ * @return CE_None on success, or CE_Failure if an error occurs or processing
+ * is terminated by the user.
+ *
+ * @since GDAL 2.2
+ */
+
+CPLErr
+GDALRasterBand::ComputeStatisticsAndHistogram( int bApproxOK,
+                                               double *pdfMin, double *pdfMax,
+                                               double *pdfMean,
+                                               double *pdfStdDev,
+                                               double dfHistMin,
+                                               double dfHistMax,
+                                               int nBuckets,
+                                               GUIntBig *panHistogram,
+                                               int bIncludeOutOfRange,
+                                               GDALProgressFunc pfnProgress,
+                                               void *pProgressData )
+
+{
+    CPLAssert( NULL != panHistogram );
+
+    if( pfnProgress == NULL )
+        pfnProgress = GDALDummyProgress;
+
 /* -------------------------------------------------------------------- */
-/*      Read actual data and compute statistics.                        */
+/*      If we have overview bands, use them.                            */
 /* -------------------------------------------------------------------- */
-    double      dfMin = 0.0, dfMax = 0.0;
-    bool bFirstValue = true;
-    /* Using Welford algorithm ( http://en.wikipedia.org/wiki/Algorithms_for_calculating_variance ) */
-    /* to compute standard deviation in a more numerically robust way than */
-    /* the difference of the sum of square values with the square of the sum */
-    /* dfMean and dfM2 are updated at each sample */
-    /* dfM2 is the sum of square of differences to the current mean */
-    double      dfMean = 0.0, dfM2 = 0.0;
-    GIntBig     nSampleCount = 0;
+    if( bApproxOK && GetOverviewCount() > 0 && !HasArbitraryOverviews() )
+    {
+        GDALRasterBand *poBand
+            = GetRasterSampleOverview( GDALSTAT_APPROX_NUMSAMPLES );
 
-    GDALRasterIOExtraArg sExtraArg;
-    INIT_RASTERIO_EXTRA_ARG(sExtraArg);
+        if( poBand != this )
+            return poBand->ComputeStatisticsAndHistogram(
+                FALSE, pdfMin, pdfMax, pdfMean, pdfStdDev,
+                dfHistMin, dfHistMax, nBuckets, panHistogram,
+                bIncludeOutOfRange, pfnProgress, pProgressData );
+    }
+
+    return ComputeStatisticsInternal( bApproxOK, pdfMin, pdfMax,
+                                      pdfMean, pdfStdDev,
+                                      dfHistMin, dfHistMax, nBuckets,
+                                      panHistogram, bIncludeOutOfRange,
+                                      pfnProgress, pProgressData );
+}
+
+/************************************************************************/
+/*                     ComputeStatisticsInternal()                      */
+/************************************************************************/
 
+/* Read the data of the band, once the overviews have been considered, and */
+/* compute its statistics, and also its histogram if panHistogram is not */
+/* NULL. Shared by ComputeStatistics() and ComputeStatisticsAndHistogram(). */
+/* Without histogram, the blocks that cannot be read are skipped, as */
+/* ComputeStatistics() always did, while GetHistogram() fails on them. */
+
+CPLErr
+GDALRasterBand::ComputeStatisticsInternal( int bApproxOK,
+                                           double *pdfMin, double *pdfMax,
+                                           double *pdfMean, double *pdfStdDev,
+                                           double dfHistMin, double dfHistMax,
+                                           int nBuckets,
+                                           GUIntBig *panHistogram,
+                                           int bIncludeOutOfRange,
+                                           GDALProgressFunc pfnProgress,
+                                           void *pProgressData )
+
+{
+/* -------------------------------------------------------------------- */
+/*      Read actual data and compute statistics and histogram.          */
+/* -------------------------------------------------------------------- */
     if( !pfnProgress( 0.0, "Compute Statistics", pProgressData ) )
     {
         ReportError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
         return CE_Failure;
     }
 
+    GDALRasterIOExtraArg sExtraArg;
+    INIT_RASTERIO_EXTRA_ARG(sExtraArg);
+
+    if( panHistogram != NULL )
+        memset( panHistogram, 0, sizeof(GUIntBig) * nBuckets );
+
     int bGotNoDataValue;
     const double dfNoDataValue = GetNoDataValue( &bGotNoDataValue );
     bGotNoDataValue = bGotNoDataValue && !CPLIsNan(dfNoDataValue);
+    // See GetHistogram()
+    const bool bNoDataInHistogram =
+        CPLTestBool(CPLGetConfigOption("GDAL_NODATA_IN_HISTOGRAM", "NO"));
 
     const char* pszPixelType = GetMetadataItem("PIXELTYPE", "IMAGE_STRUCTURE");
-    int bSignedByte = (pszPixelType != NULL && EQUAL(pszPixelType, "SIGNEDBYTE"));
+    const bool bSignedByte =
+        pszPixelType != NULL && EQUAL(pszPixelType, "SIGNEDBYTE");
+
+    GDALStatsKernelArgs sArgs;
+    GDALInitStatsKernelArgs( sArgs, eDataType, bSignedByte, false,
+                             CPL_TO_BOOL(bGotNoDataValue), dfNoDataValue );
+    GDALBandStats sStats;
+
+    GDALHistogramArgs sHistArgs;
+    memset( &sHistArgs, 0, sizeof(sHistArgs) );
+    std::vector<GUIntBig> anCounts;
+    if( panHistogram != NULL )
+    {
+        GDALInitHistogramArgs( sHistArgs, eDataType, bSignedByte,
+                               dfHistMin, dfHistMax, nBuckets,
+                               CPL_TO_BOOL(bIncludeOutOfRange),
+                               bGotNoDataValue && !bNoDataInHistogram,
+                               dfNoDataValue );
+        anCounts.resize(
+            MAX(1, GDALGetHistogramCounterCount(sHistArgs)), 0 );
+    }
 
     if ( bApproxOK && HasArbitraryOverviews() )
     {
@@ -3645,7 +4871,6 @@ GDALRasterBand::ComputeStatistics( int bApproxOK,
 /*      Figure out how much the image should be reduced to get an       */
 /*      approximate value.                                              */
 /* -------------------------------------------------------------------- */
-        void    *pData;
         int     nXReduced, nYReduced;
         double  dfReduction = sqrt(
             (double)nRasterXSize * nRasterYSize / GDALSTAT_APPROX_NUMSAMPLES );
@@ -3667,7 +4892,7 @@ GDALRasterBand::ComputeStatistics( int bApproxOK,
             nYReduced = nRasterYSize;
         }
 
-        pData =
+        void *pData =
             CPLMalloc(
                 GDALGetDataTypeSizeBytes(eDataType) * nXReduced * nYReduced );
 
@@ -3679,86 +4904,11 @@ GDALRasterBand::ComputeStatistics( int bApproxOK,
             return eErr;
         }
 
-        /* this isn't the fastest way to do this, but is easier for now */
-        for( int iY = 0; iY < nYReduced; iY++ )
-        {
-            for( int iX = 0; iX < nXReduced; iX++ )
-            {
-                int    iOffset = iX + iY * nXReduced;
-                double dfValue = 0.0;
-
-                switch( eDataType )
-                {
-                  case GDT_Byte:
-                  {
-                    if (bSignedByte)
-                        dfValue = ((signed char *)pData)[iOffset];
-                    else
-                        dfValue = ((GByte *)pData)[iOffset];
-                    break;
-                  }
-                  case GDT_UInt16:
-                    dfValue = ((GUInt16 *)pData)[iOffset];
-                    break;
-                  case GDT_Int16:
-                    dfValue = ((GInt16 *)pData)[iOffset];
-                    break;
-                  case GDT_UInt32:
-                    dfValue = ((GUInt32 *)pData)[iOffset];
-                    break;
-                  case GDT_Int32:
-                    dfValue = ((GInt32 *)pData)[iOffset];
-                    break;
-                  case GDT_Float32:
-                    dfValue = ((float *)pData)[iOffset];
-                    if (CPLIsNan(dfValue))
-                        continue;
-                    break;
-                  case GDT_Float64:
-                    dfValue = ((double *)pData)[iOffset];
-                    if (CPLIsNan(dfValue))
-                        continue;
-                    break;
-                  case GDT_CInt16:
-                    dfValue = ((GInt16 *)pData)[iOffset*2];
-                    break;
-                  case GDT_CInt32:
-                    dfValue = ((GInt32 *)pData)[iOffset*2];
-                    break;
-                  case GDT_CFloat32:
-                    dfValue = ((float *)pData)[iOffset*2];
-                    if( CPLIsNan(dfValue) )
-                        continue;
-                    break;
-                  case GDT_CFloat64:
-                    dfValue = ((double *)pData)[iOffset*2];
-                    if( CPLIsNan(dfValue) )
-                        continue;
-                    break;
-                  default:
-                    CPLAssert( FALSE );
-                }
-
-                if( bGotNoDataValue && ARE_REAL_EQUAL(dfValue, dfNoDataValue) )
-                    continue;
-
-                if( bFirstValue )
-                {
-                    dfMin = dfMax = dfValue;
-                    bFirstValue = false;
-                }
-                else
-                {
-                    dfMin = MIN(dfMin,dfValue);
-                    dfMax = MAX(dfMax,dfValue);
-                }
-
-                nSampleCount++;
-                double dfDelta = dfValue - dfMean;
-                dfMean += dfDelta / nSampleCount;
-                dfM2 += dfDelta * (dfValue - dfMean);
-            }
-        }
+        GDALComputeBufferStatistics( pData, nXReduced, nYReduced, nXReduced,
+                                     sArgs, sStats );
+        if( panHistogram != NULL )
+            GDALComputeBufferHistogram( pData, nXReduced, nYReduced,
+                                        nXReduced, sHistArgs, &anCounts[0] );
 
         CPLFree( pData );
     }
@@ -3786,126 +4936,18 @@ GDALRasterBand::ComputeStatistics( int bApproxOK,
         else
             nSampleRate = 1;
 
-        for( int iSampleBlock = 0;
-             iSampleBlock < nBlocksPerRow * nBlocksPerColumn;
-             iSampleBlock += nSampleRate )
-        {
-            int  iXBlock, iYBlock, nXCheck, nYCheck;
-            GDALRasterBlock *poBlock;
-            void* pData;
-
-            iYBlock = iSampleBlock / nBlocksPerRow;
-            iXBlock = iSampleBlock - nBlocksPerRow * iYBlock;
-
-            poBlock = GetLockedBlockRef( iXBlock, iYBlock );
-            if( poBlock == NULL )
-                continue;
-
-            pData = poBlock->GetDataRef();
-
-            if( (iXBlock+1) * nBlockXSize > GetXSize() )
-                nXCheck = GetXSize() - iXBlock * nBlockXSize;
-            else
-                nXCheck = nBlockXSize;
-
-            if( (iYBlock+1) * nBlockYSize > GetYSize() )
-                nYCheck = GetYSize() - iYBlock * nBlockYSize;
-            else
-                nYCheck = nBlockYSize;
-
-            /* this isn't the fastest way to do this, but is easier for now */
-            for( int iY = 0; iY < nYCheck; iY++ )
-            {
-                for( int iX = 0; iX < nXCheck; iX++ )
-                {
-                    int    iOffset = iX + iY * nBlockXSize;
-                    double dfValue = 0.0;
-
-                    switch( eDataType )
-                    {
-                      case GDT_Byte:
-                      {
-                        if (bSignedByte)
-                            dfValue = ((signed char *)pData)[iOffset];
-                        else
-                            dfValue = ((GByte *)pData)[iOffset];
-                        break;
-                      }
-                      case GDT_UInt16:
-                        dfValue = ((GUInt16 *)pData)[iOffset];
-                        break;
-                      case GDT_Int16:
-                        dfValue = ((GInt16 *)pData)[iOffset];
-                        break;
-                      case GDT_UInt32:
-                        dfValue = ((GUInt32 *)pData)[iOffset];
-                        break;
-                      case GDT_Int32:
-                        dfValue = ((GInt32 *)pData)[iOffset];
-                        break;
-                      case GDT_Float32:
-                        dfValue = ((float *)pData)[iOffset];
-                        if (CPLIsNan(dfValue))
-                            continue;
-                        break;
-                      case GDT_Float64:
-                        dfValue = ((double *)pData)[iOffset];
-                        if (CPLIsNan(dfValue))
-                            continue;
-                        break;
-                      case GDT_CInt16:
-                        dfValue = ((GInt16 *)pData)[iOffset*2];
-                        break;
-                      case GDT_CInt32:
-                        dfValue = ((GInt32 *)pData)[iOffset*2];
-                        break;
-                      case GDT_CFloat32:
-                        dfValue = ((float *)pData)[iOffset*2];
-                        if( CPLIsNan(dfValue) )
-                            continue;
-                        break;
-                      case GDT_CFloat64:
-                        dfValue = ((double *)pData)[iOffset*2];
-                        if( CPLIsNan(dfValue) )
-                            continue;
-                        break;
-                      default:
-                        CPLAssert( FALSE );
-                    }
-
-                    if( bGotNoDataValue && ARE_REAL_EQUAL(dfValue, dfNoDataValue) )
-                        continue;
-
-                    if( bFirstValue )
-                    {
-                        dfMin = dfMax = dfValue;
-                        bFirstValue = false;
-                    }
-                    else
-                    {
-                        dfMin = MIN(dfMin,dfValue);
-                        dfMax = MAX(dfMax,dfValue);
-                    }
-
-                    nSampleCount++;
-                    double dfDelta = dfValue - dfMean;
-                    dfMean += dfDelta / nSampleCount;
-                    dfM2 += dfDelta * (dfValue - dfMean);
-                }
-            }
-
-            poBlock->DropLock();
-
-            if ( !pfnProgress(iSampleBlock
-                              / ((double)(nBlocksPerRow*nBlocksPerColumn)),
-                              "Compute Statistics", pProgressData) )
-            {
-                ReportError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
-                return CE_Failure;
-            }
-        }
+        if( !GDALComputeBlockStatistics(
+                this, nSampleRate, &sArgs, &sStats,
+                panHistogram != NULL ? &sHistArgs : NULL,
+                panHistogram != NULL ? &anCounts[0] : NULL,
+                panHistogram == NULL, "Compute Statistics",
+                pfnProgress, pProgressData ) )
+            return CE_Failure;
     }
 
+    if( panHistogram != NULL )
+        GDALHistogramCountsToBuckets( sHistArgs, &anCounts[0], panHistogram );
+
     if( !pfnProgress( 1.0, "Compute Statistics", pProgressData ) )
     {
         ReportError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
@@ -3915,57 +4957,64 @@ GDALRasterBand::ComputeStatistics( int bApproxOK,
 /* -------------------------------------------------------------------- */
 /*      Save computed information.                                      */
 /* -------------------------------------------------------------------- */
-    const double dfStdDev = (nSampleCount > 0) ? sqrt(dfM2 / nSampleCount) : 0.0;
+    const GUIntBig nSampleCount = sStats.nCount;
+    const double dfStdDev =
+        (nSampleCount > 0) ? sqrt(sStats.dfM2 / nSampleCount) : 0.0;
 
     if( nSampleCount > 0 )
-        SetStatistics( dfMin, dfMax, dfMean, dfStdDev );
+        SetStatistics( sStats.dfMin, sStats.dfMax, sStats.dfMean, dfStdDev );
 
 /* -------------------------------------------------------------------- */
 /*      Record results.                                                 */
 /* -------------------------------------------------------------------- */
     if( pdfMin != NULL )
-        *pdfMin = dfMin;
+        *pdfMin = sStats.dfMin;
     if( pdfMax != NULL )
-        *pdfMax = dfMax;
+        *pdfMax = sStats.dfMax;
 
     if( pdfMean != NULL )
-        *pdfMean = dfMean;
+        *pdfMean = sStats.dfMean;
 
     if( pdfStdDev != NULL )
         *pdfStdDev = dfStdDev;
 
     if( nSampleCount > 0 )
         return CE_None;
-    else
-    {
-        ReportError( CE_Failure, CPLE_AppDefined,
+
+    ReportError( CE_Failure, CPLE_AppDefined,
         "Failed to compute statistics, no valid pixels found in sampling." );
-        return CE_Failure;
-    }
+    return CE_Failure;
 }
 
 /************************************************************************/
-/*                    GDALComputeRasterStatistics()                     */
+/*              GDALComputeRasterStatisticsAndHistogram()               */
 /************************************************************************/
 
 /**
-  * \brief Compute image statistics.
+  * \brief Compute image statistics and histogram in a single pass.
   *
-  * @see GDALRasterBand::ComputeStatistics()
+  * @see GDALRasterBand::ComputeStatisticsAndHistogram()
+  * @since GDAL 2.2
   */
 
-CPLErr CPL_STDCALL GDALComputeRasterStatistics(
+CPLErr CPL_STDCALL GDALComputeRasterStatisticsAndHistogram(
         GDALRasterBandH hBand, int bApproxOK,
         double *pdfMin, double *pdfMax, double *pdfMean, double *pdfStdDev,
+        double dfHistMin, double dfHistMax, int nBuckets,
+        GUIntBig *panHistogram, int bIncludeOutOfRange,
         GDALProgressFunc pfnProgress, void *pProgressData )
 
 {
-    VALIDATE_POINTER1( hBand, "GDALComputeRasterStatistics", CE_Failure );
+    VALIDATE_POINTER1( hBand, "GDALComputeRasterStatisticsAndHistogram",
+                       CE_Failure );
+    VALIDATE_POINTER1( panHistogram, "GDALComputeRasterStatisticsAndHistogram",
+                       CE_Failure );
 
     GDALRasterBand *poBand = static_cast<GDALRasterBand*>(hBand);
 
-    return poBand->ComputeStatistics(
+    return poBand->ComputeStatisticsAndHistogram(
         bApproxOK, pdfMin, pdfMax, pdfMean, pdfStdDev,
+        dfHistMin, dfHistMax, nBuckets, panHistogram, bIncludeOutOfRange,
         pfnProgress, pProgressData );
 }
 
@@ -4105,13 +5154,18 @@ CPLErr GDALRasterBand::ComputeRasterMinMax( int bApproxOK,
 /*      Read actual data and compute minimum and maximum.               */
 /* -------------------------------------------------------------------- */
     int bGotNoDataValue;
-    bool bFirstValue = true;
 
     const double dfNoDataValue = GetNoDataValue( &bGotNoDataValue );
     bGotNoDataValue = bGotNoDataValue && !CPLIsNan(dfNoDataValue);
 
     const char* pszPixelType = GetMetadataItem("PIXELTYPE", "IMAGE_STRUCTURE");
-    int bSignedByte = (pszPixelType != NULL && EQUAL(pszPixelType, "SIGNEDBYTE"));
+    const bool bSignedByte =
+        pszPixelType != NULL && EQUAL(pszPixelType, "SIGNEDBYTE");
+
+    GDALStatsKernelArgs sArgs;
+    GDALInitStatsKernelArgs( sArgs, eDataType, bSignedByte, true,
+                             CPL_TO_BOOL(bGotNoDataValue), dfNoDataValue );
+    GDALBandStats sStats;
 
     GDALRasterIOExtraArg sExtraArg;
     INIT_RASTERIO_EXTRA_ARG(sExtraArg);
@@ -4156,81 +5210,8 @@ CPLErr GDALRasterBand::ComputeRasterMinMax( int bApproxOK,
             return eErr;
         }
 
-        /* this isn't the fastest way to do this, but is easier for now */
-        for( int iY = 0; iY < nYReduced; iY++ )
-        {
-            for( int iX = 0; iX < nXReduced; iX++ )
-            {
-                int    iOffset = iX + iY * nXReduced;
-                double dfValue = 0.0;
-
-                switch( eDataType )
-                {
-                  case GDT_Byte:
-                  {
-                    if (bSignedByte)
-                        dfValue = ((signed char *)pData)[iOffset];
-                    else
-                        dfValue = ((GByte *)pData)[iOffset];
-                    break;
-                  }
-                  case GDT_UInt16:
-                    dfValue = ((GUInt16 *)pData)[iOffset];
-                    break;
-                  case GDT_Int16:
-                    dfValue = ((GInt16 *)pData)[iOffset];
-                    break;
-                  case GDT_UInt32:
-                    dfValue = ((GUInt32 *)pData)[iOffset];
-                    break;
-                  case GDT_Int32:
-                    dfValue = ((GInt32 *)pData)[iOffset];
-                    break;
-                  case GDT_Float32:
-                    dfValue = ((float *)pData)[iOffset];
-                    if (CPLIsNan(dfValue))
-                        continue;
-                    break;
-                  case GDT_Float64:
-                    dfValue = ((double *)pData)[iOffset];
-                    if (CPLIsNan(dfValue))
-                        continue;
-                    break;
-                  case GDT_CInt16:
-                    dfValue = ((GInt16 *)pData)[iOffset*2];
-                    break;
-                  case GDT_CInt32:
-                    dfValue = ((GInt32 *)pData)[iOffset*2];
-                    break;
-                  case GDT_CFloat32:
-                    dfValue = ((float *)pData)[iOffset*2];
-                    if( CPLIsNan(dfValue) )
-                        continue;
-                    break;
-                  case GDT_CFloat64:
-                    dfValue = ((double *)pData)[iOffset*2];
-                    if( CPLIsNan(dfValue) )
-                        continue;
-                    break;
-                  default:
-                    CPLAssert( FALSE );
-                }
-
-                if( bGotNoDataValue && ARE_REAL_EQUAL(dfValue, dfNoDataValue) )
-                    continue;
-
-                if( bFirstValue )
-                {
-                    dfMin = dfMax = dfValue;
-                    bFirstValue = false;
-                }
-                else
-                {
-                    dfMin = MIN(dfMin,dfValue);
-                    dfMax = MAX(dfMax,dfValue);
-                }
-            }
-        }
+        GDALComputeBufferStatistics( pData, nXReduced, nYReduced, nXReduced,
+                                     sArgs, sStats );
 
         CPLFree( pData );
     }
@@ -4259,114 +5240,16 @@ CPLErr GDALRasterBand::ComputeRasterMinMax( int bApproxOK,
         else
             nSampleRate = 1;
 
-        for( int iSampleBlock = 0;
-             iSampleBlock < nBlocksPerRow * nBlocksPerColumn;
-             iSampleBlock += nSampleRate )
-        {
-            int iYBlock = iSampleBlock / nBlocksPerRow;
-            int iXBlock = iSampleBlock - nBlocksPerRow * iYBlock;
-
-            GDALRasterBlock *poBlock = GetLockedBlockRef( iXBlock, iYBlock );
-            if( poBlock == NULL )
-                continue;
-
-            void *pData = poBlock->GetDataRef();
-
-            int nXCheck, nYCheck;
-            if( (iXBlock+1) * nBlockXSize > GetXSize() )
-                nXCheck = GetXSize() - iXBlock * nBlockXSize;
-            else
-                nXCheck = nBlockXSize;
-
-            if( (iYBlock+1) * nBlockYSize > GetYSize() )
-                nYCheck = GetYSize() - iYBlock * nBlockYSize;
-            else
-                nYCheck = nBlockYSize;
-
-            /* this isn't the fastest way to do this, but is easier for now */
-            for( int iY = 0; iY < nYCheck; iY++ )
-            {
-                for( int iX = 0; iX < nXCheck; iX++ )
-                {
-                    int    iOffset = iX + iY * nBlockXSize;
-                    double dfValue = 0.0;
-
-                    switch( eDataType )
-                    {
-                      case GDT_Byte:
-                      {
-                        if (bSignedByte)
-                            dfValue = ((signed char *) pData)[iOffset];
-                        else
-                            dfValue = ((GByte *) pData)[iOffset];
-                        break;
-                      }
-                      case GDT_UInt16:
-                        dfValue = ((GUInt16 *) pData)[iOffset];
-                        break;
-                      case GDT_Int16:
-                        dfValue = ((GInt16 *) pData)[iOffset];
-                        break;
-                      case GDT_UInt32:
-                        dfValue = ((GUInt32 *) pData)[iOffset];
-                        break;
-                      case GDT_Int32:
-                        dfValue = ((GInt32 *) pData)[iOffset];
-                        break;
-                      case GDT_Float32:
-                        dfValue = ((float *) pData)[iOffset];
-                        if( CPLIsNan(dfValue) )
-                            continue;
-                        break;
-                      case GDT_Float64:
-                        dfValue = ((double *) pData)[iOffset];
-                        if( CPLIsNan(dfValue) )
-                            continue;
-                        break;
-                      case GDT_CInt16:
-                        dfValue = ((GInt16 *) pData)[iOffset*2];
-                        break;
-                      case GDT_CInt32:
-                        dfValue = ((GInt32 *) pData)[iOffset*2];
-                        break;
-                      case GDT_CFloat32:
-                        dfValue = ((float *) pData)[iOffset*2];
-                        if( CPLIsNan(dfValue) )
-                            continue;
-                        break;
-                      case GDT_CFloat64:
-                        dfValue = ((double *) pData)[iOffset*2];
-                        if( CPLIsNan(dfValue) )
-                            continue;
-                        break;
-                      default:
-                        CPLAssert( FALSE );
-                    }
-
-                    if( bGotNoDataValue && ARE_REAL_EQUAL(dfValue, dfNoDataValue) )
-                        continue;
-
-                    if( bFirstValue )
-                    {
-                        dfMin = dfMax = dfValue;
-                        bFirstValue = false;
-                    }
-                    else
-                    {
-                        dfMin = MIN(dfMin,dfValue);
-                        dfMax = MAX(dfMax,dfValue);
-                    }
-                }
-            }
-
-            poBlock->DropLock();
-        }
+        if( !GDALComputeBlockStatistics( this, nSampleRate, &sArgs, &sStats,
+                                         NULL, NULL, true, NULL,
+                                         GDALDummyProgress, NULL ) )
+            return CE_Failure;
     }
 
-    adfMinMax[0] = dfMin;
-    adfMinMax[1] = dfMax;
+    adfMinMax[0] = sStats.dfMin;
+    adfMinMax[1] = sStats.dfMax;
 
-    if (bFirstValue)
+    if( sStats.nCount == 0 )
     {
         ReportError( CE_Failure, CPLE_AppDefined,
             "Failed to compute min/max, no valid pixels found in sampling." );
@@ -36,19 +36,73 @@ CPL_CVSID("$Id$");
 
 static bool bCacheMaxInitialized = false;
 static GIntBig nCacheMax = 40 * 1024*1024; /* Will later be overridden by the default 5% if GDAL_CACHEMAX not defined */
-static volatile GIntBig nCacheUsed = 0;
 
-static GDALRasterBlock *poOldest = NULL;    /* tail */
-static GDALRasterBlock *poNewest = NULL;    /* head */
+/* -------------------------------------------------------------------- */
+/*      The block cache is split into one or several shards, each       */
+/*      with its own LRU list, byte counter and lock. A block always    */
+/*      lives in the shard selected by hashing its band and offsets,    */
+/*      so that threads working on different blocks rarely contend on   */
+/*      the same lock. The GDAL_CACHEMAX limit remains global and       */
+/*      applies to the sum of the shard counters.                       */
+/*                                                                      */
+/*      Each shard has two lists. With the LRU eviction policy, only    */
+/*      the main list is used. With the 2Q policy (simplified 2Q of     */
+/*      Johnson & Shasha), new blocks enter the probation list, which   */
+/*      is a FIFO, and are promoted to the main LRU list when they      */
+/*      are accessed again later. Blocks that are only read once, for   */
+/*      example by a full raster scan, are then evicted before the      */
+/*      frequently used ones.                                           */
+/*                                                                      */
+/*      Datasets with a block cache quota get their own shard, called   */
+/*      a partition, whose size is bounded by the quota instead of      */
+/*      GDAL_CACHEMAX. Blocks of such datasets never evict blocks of    */
+/*      other datasets.                                                 */
+/* -------------------------------------------------------------------- */
 
-#if 0
-static CPLMutex *hRBLock = NULL;
-#define INITIALIZE_LOCK         CPLMutexHolderD( &hRBLock )
-#define TAKE_LOCK               CPLMutexHolderOptionalLockD( hRBLock )
-#define DESTROY_LOCK            CPLDestroyMutex( hRBLock )
-#else
+#define GDAL_RB_MAX_SHARDS      256
+
+#define RB_LIST_MAIN            0
+#define RB_LIST_PROBATION       1
+
+typedef enum
+{
+    RB_POLICY_LRU,
+    RB_POLICY_2Q
+} GDALRasterBlockEvictionPolicy;
+
+typedef struct
+{
+    GDALRasterBlock  *poOldest;    /* tail */
+    GDALRasterBlock  *poNewest;    /* head */
+    int               nCount;
+    GIntBig           nBytes;
+    /* Number of blocks that have been put at the head of the list */
+    GUInt32           nInsertions;
+} GDALRasterBlockList;
+
+struct GDALRasterBlockCacheShard
+{
+    CPLLock          *hLock;
+    GDALRasterBlockList asLists[2];
+    volatile GIntBig  nCacheUsed;
+    /* Hits counted without the lock, folded into nHits under the lock */
+    volatile int      nPendingHits;
+    GIntBig           nHits;
+    GIntBig           nMisses;
+    GIntBig           nEvictions;
+    /* Maximum size of a partition, or 0 for the shards of the shared cache */
+    GIntBig           nQuota;
+    /* Avoid false sharing between the locks of neighbouring shards */
+    GByte             abyPadding[64];
+};
+
+static GDALRasterBlockCacheShard asShards[GDAL_RB_MAX_SHARDS];
+/* 0 until the GDAL_RB_SHARD_COUNT configuration option has been read. */
+/* Never changes afterwards, since it determines where blocks live. */
+static int nShardCount = 0;
+static volatile int nFlushShardCursor = 0;
+static GDALRasterBlockEvictionPolicy eEvictionPolicy = RB_POLICY_LRU;
 
-static CPLLock* hRBLock = NULL;
 static int bDebugContention = FALSE;
 static bool bSleepsForBockCacheDebug = false;
 static CPLLockType GetLockType()
@@ -75,12 +129,129 @@ static CPLLockType GetLockType()
     return (CPLLockType) nLockType;
 }
 
-#define INITIALIZE_LOCK         CPLLockHolderD( &hRBLock, GetLockType() ); \
-                                CPLLockSetDebugPerf(hRBLock, bDebugContention)
-#define TAKE_LOCK               CPLLockHolderOptionalLockD( hRBLock )
-#define DESTROY_LOCK            CPLDestroyLock( hRBLock )
+/************************************************************************/
+/*                        GetShardCountFromConfig()                     */
+/************************************************************************/
 
-#endif
+static int GetShardCountFromConfig()
+{
+    const char* pszShardCount = CPLGetConfigOption("GDAL_RB_SHARD_COUNT", "1");
+    int nCount;
+    if( EQUAL(pszShardCount, "ALL_CPUS") )
+        nCount = CPLGetNumCPUs();
+    else
+        nCount = atoi(pszShardCount);
+    if( nCount < 1 || nCount > GDAL_RB_MAX_SHARDS )
+    {
+        CPLError(CE_Warning, CPLE_NotSupported,
+                 "GDAL_RB_SHARD_COUNT=%s not supported. "
+                 "Should be ALL_CPUS or a value between 1 and %d. "
+                 "Falling back to 1",
+                 pszShardCount, GDAL_RB_MAX_SHARDS);
+        nCount = 1;
+    }
+    CPLDebug("GDAL", "Using %d block cache shard(s)", nCount);
+    return nCount;
+}
+
+/************************************************************************/
+/*                     GetEvictionPolicyFromConfig()                    */
+/************************************************************************/
+
+static GDALRasterBlockEvictionPolicy GetEvictionPolicyFromConfig()
+{
+    const char* pszPolicy = CPLGetConfigOption("GDAL_RB_EVICTION_POLICY", "LRU");
+    if( EQUAL(pszPolicy, "LRU") )
+        return RB_POLICY_LRU;
+    if( EQUAL(pszPolicy, "2Q") )
+        return RB_POLICY_2Q;
+    CPLError(CE_Warning, CPLE_NotSupported,
+             "GDAL_RB_EVICTION_POLICY=%s not supported. Falling back to LRU",
+             pszPolicy);
+    return RB_POLICY_LRU;
+}
+
+/************************************************************************/
+/*                          InitializeShards()                          */
+/************************************************************************/
+
+/* Creates the locks of the shards if not already done. Must be called */
+/* before any block is added to the cache. */
+static void InitializeShards()
+{
+    /* The lock of the first shard serializes the creation of the others */
+    CPLLockHolderD( &asShards[0].hLock, GetLockType() );
+    CPLLockSetDebugPerf(asShards[0].hLock, bDebugContention);
+
+    if( nShardCount == 0 )
+    {
+        eEvictionPolicy = GetEvictionPolicyFromConfig();
+        nShardCount = GetShardCountFromConfig();
+    }
+    for( int i = 1; i < nShardCount; i++ )
+    {
+        if( asShards[i].hLock == NULL )
+        {
+            asShards[i].hLock = CPLCreateLock(GetLockType());
+            CPLLockSetDebugPerf(asShards[i].hLock, bDebugContention);
+        }
+    }
+}
+
+/************************************************************************/
+/*                          GetTotalCacheUsed()                         */
+/************************************************************************/
+
+/* The sum is done without taking the shard locks, so it is only exact */
+/* when no other thread is modifying the cache. */
+static GIntBig GetTotalCacheUsed()
+{
+    GIntBig nTotal = asShards[0].nCacheUsed;
+    for( int i = 1; i < nShardCount; i++ )
+        nTotal += asShards[i].nCacheUsed;
+    return nTotal;
+}
+
+/************************************************************************/
+/*                          GetEvictionOrder()                          */
+/************************************************************************/
+
+/* Returns in which order the lists of a shard must be scanned for */
+/* blocks to evict. */
+static void GetEvictionOrder( const GDALRasterBlockCacheShard* poShard,
+                              GIntBig nCurCacheMax, int anListOrder[2] )
+{
+    anListOrder[0] = RB_LIST_MAIN;
+    anListOrder[1] = RB_LIST_PROBATION;
+    if( eEvictionPolicy != RB_POLICY_2Q )
+        return;
+
+    // The probation list is allowed a quarter of the cache share of the
+    // shard. Above that, or if the main list is empty, evict from it first.
+    const GIntBig nShardMax = poShard->nQuota > 0 ?
+        poShard->nQuota : nCurCacheMax / MAX(1, nShardCount);
+    const GIntBig nProbationMax = nShardMax / 4;
+    if( poShard->asLists[RB_LIST_PROBATION].nBytes > nProbationMax ||
+        poShard->asLists[RB_LIST_MAIN].poOldest == NULL )
+    {
+        anListOrder[0] = RB_LIST_PROBATION;
+        anListOrder[1] = RB_LIST_MAIN;
+    }
+}
+
+#define TAKE_SHARD_LOCK(poShard)    CPLLockHolderOptionalLockD( (poShard)->hLock )
+
+/************************************************************************/
+/*                          FoldPendingHits()                           */
+/************************************************************************/
+
+/* Must be called with the shard lock held */
+static void FoldPendingHits( GDALRasterBlockCacheShard* poShard )
+{
+    const int nPending = poShard->nPendingHits;
+    CPLAtomicAdd(&poShard->nPendingHits, -nPending);
+    poShard->nHits += nPending;
+}
 
 //#define ENABLE_DEBUG
 
@@ -138,9 +309,7 @@ void CPL_STDCALL GDALSetCacheMax64( GIntBig nNewSizeInBytes )
     }
 #endif
 
-    {
-        INITIALIZE_LOCK;
-    }   
+    InitializeShards();
     bCacheMaxInitialized = true;
     nCacheMax = nNewSizeInBytes;
 
@@ -148,13 +317,13 @@ void CPL_STDCALL GDALSetCacheMax64( GIntBig nNewSizeInBytes )
 /*      Flush blocks till we are under the new limit or till we         */
 /*      can't seem to flush anymore.                                    */
 /* -------------------------------------------------------------------- */
-    while( nCacheUsed > nCacheMax )
+    while( GetTotalCacheUsed() > nCacheMax )
     {
-        GIntBig nOldCacheUsed = nCacheUsed;
+        GIntBig nOldCacheUsed = GetTotalCacheUsed();
 
         GDALFlushCacheBlock();
 
-        if( nCacheUsed == nOldCacheUsed )
+        if( GetTotalCacheUsed() == nOldCacheUsed )
             break;
     }
 }
@@ -224,9 +393,7 @@ GIntBig CPL_STDCALL GDALGetCacheMax64()
 {
     if( !bCacheMaxInitialized )
     {
-        {
-            INITIALIZE_LOCK;
-        }
+        InitializeShards();
         bSleepsForBockCacheDebug = CPLTestBool(CPLGetConfigOption("GDAL_DEBUG_BLOCK_CACHE", "NO"));
 
         const char* pszCacheMax = CPLGetConfigOption("GDAL_CACHEMAX","5%");
@@ -289,6 +456,7 @@ GIntBig CPL_STDCALL GDALGetCacheMax64()
 
 int CPL_STDCALL GDALGetCacheUsed()
 {
+    const GIntBig nCacheUsed = GetTotalCacheUsed();
     if (nCacheUsed > INT_MAX)
     {
         static bool bHasWarned = false;
@@ -319,7 +487,76 @@ int CPL_STDCALL GDALGetCacheUsed()
 
 GIntBig CPL_STDCALL GDALGetCacheUsed64()
 {
-    return nCacheUsed;
+    return GetTotalCacheUsed();
+}
+
+/************************************************************************/
+/*                        GDALGetCacheCounters()                        */
+/************************************************************************/
+
+/**
+ * \brief Get block cache access counters.
+ *
+ * Returns the number of cache hits (a block requested by a raster band was
+ * found in the cache), of cache misses (a block had to be added to the cache)
+ * and of evictions (a block was removed from the cache to make room for
+ * others or by GDALFlushCacheBlock()) since the start of the process or the
+ * last call to GDALResetCacheCounters().
+ *
+ * Those counters can be used to compare the eviction policies that can be
+ * selected with the GDAL_RB_EVICTION_POLICY configuration option.
+ *
+ * @param pnHits pointer to the number of hits, or NULL.
+ * @param pnMisses pointer to the number of misses, or NULL.
+ * @param pnEvictions pointer to the number of evictions, or NULL.
+ *
+ * @since GDAL 2.2
+ */
+
+void CPL_STDCALL GDALGetCacheCounters( GIntBig* pnHits, GIntBig* pnMisses,
+                                       GIntBig* pnEvictions )
+{
+    GIntBig nHits = 0;
+    GIntBig nMisses = 0;
+    GIntBig nEvictions = 0;
+    for( int i = 0; i < MAX(1, nShardCount); i++ )
+    {
+        TAKE_SHARD_LOCK(&asShards[i]);
+        FoldPendingHits(&asShards[i]);
+        nHits += asShards[i].nHits;
+        nMisses += asShards[i].nMisses;
+        nEvictions += asShards[i].nEvictions;
+    }
+    if( pnHits )
+        *pnHits = nHits;
+    if( pnMisses )
+        *pnMisses = nMisses;
+    if( pnEvictions )
+        *pnEvictions = nEvictions;
+}
+
+/************************************************************************/
+/*                       GDALResetCacheCounters()                       */
+/************************************************************************/
+
+/**
+ * \brief Reset block cache access counters.
+ *
+ * @see GDALGetCacheCounters()
+ *
+ * @since GDAL 2.2
+ */
+
+void CPL_STDCALL GDALResetCacheCounters()
+{
+    for( int i = 0; i < MAX(1, nShardCount); i++ )
+    {
+        TAKE_SHARD_LOCK(&asShards[i]);
+        FoldPendingHits(&asShards[i]);
+        asShards[i].nHits = 0;
+        asShards[i].nMisses = 0;
+        asShards[i].nEvictions = 0;
+    }
 }
 
 /************************************************************************/
@@ -359,6 +596,20 @@ int CPL_STDCALL GDALFlushCacheBlock()
  * a least recently used (LRU) list and an upper cache limit (see
  * GDALSetCacheMax()) under which the cache size is normally kept.
  *
+ * Starting with GDAL 2.2, the GDAL_RB_SHARD_COUNT configuration option
+ * can be set to a number of shards (or ALL_CPUS) to split the cache into
+ * several independent LRU lists, each protected by its own lock. This
+ * reduces lock contention when many threads read from the cache, at the
+ * expense of an approximate global LRU ordering. The upper cache limit
+ * still applies to the whole cache. The default is a single shard.
+ *
+ * Starting with GDAL 2.2, the GDAL_RB_EVICTION_POLICY configuration option
+ * selects how blocks are chosen for eviction. LRU (the default) evicts the
+ * least recently used block. 2Q keeps blocks accessed only once in a
+ * separate probation list, limited to a quarter of the cache, so that
+ * reading a whole raster once does not evict blocks that are frequently
+ * re-read. GDALGetCacheCounters() can be used to compare the hit rates.
+ *
  * Some blocks in the cache may be modified relative to the state on disk
  * (they are marked "Dirty") and must be flushed to disk before they can
  * be discarded.  Other (Clean) blocks may just be discarded if their memory
@@ -399,31 +650,56 @@ int CPL_STDCALL GDALFlushCacheBlock()
 int GDALRasterBlock::FlushCacheBlock(int bDirtyBlocksOnly)
 
 {
-    GDALRasterBlock *poTarget;
+    InitializeShards();
 
+    /* Start from a different shard at each call so that repeated calls */
+    /* do not always drain the same shard. */
+    int iShard = 0;
+    if( nShardCount > 1 )
+        iShard = static_cast<int>(
+            static_cast<unsigned int>(CPLAtomicInc(&nFlushShardCursor)) %
+                                      static_cast<unsigned int>(nShardCount));
+
+    GDALRasterBlock *poTarget = NULL;
+    const GIntBig nCurCacheMax = nCacheMax;
+
+    for( int iIter = 0; poTarget == NULL && iIter < nShardCount;
+         iIter++, iShard = (iShard + 1) % nShardCount )
     {
-        INITIALIZE_LOCK;
-        poTarget = poOldest;
+        GDALRasterBlockCacheShard* poShard = &asShards[iShard];
+        TAKE_SHARD_LOCK(poShard);
 
-        while( poTarget != NULL )
+        int anListOrder[2];
+        GetEvictionOrder(poShard, nCurCacheMax, anListOrder);
+        for( int iList = 0; poTarget == NULL && iList < 2; iList++ )
         {
-            if( !bDirtyBlocksOnly || poTarget->GetDirty() )
+            poTarget = poShard->asLists[anListOrder[iList]].poOldest;
+
+            while( poTarget != NULL )
             {
-                if( CPLAtomicCompareAndExchange(&(poTarget->nLockCount), 0, -1) )
-                    break;
+                if( !bDirtyBlocksOnly || poTarget->GetDirty() )
+                {
+                    if( CPLAtomicCompareAndExchange(&(poTarget->nLockCount), 0, -1) )
+                        break;
+                }
+                poTarget = poTarget->poPrevious;
             }
-            poTarget = poTarget->poPrevious;
         }
 
         if( poTarget == NULL )
-            return FALSE;
+            continue;
         if( bSleepsForBockCacheDebug )
             CPLSleep(CPLAtof(CPLGetConfigOption("GDAL_RB_FLUSHBLOCK_SLEEP_AFTER_DROP_LOCK", "0")));
 
+        poShard->nEvictions ++;
+        poTarget->GetBand()->poBandBlockCache->IncrementEvictions();
         poTarget->Detach_unlocked();
         poTarget->GetBand()->UnreferenceBlock(poTarget);
     }
 
+    if( poTarget == NULL )
+        return FALSE;
+
     if( bSleepsForBockCacheDebug )
         CPLSleep(CPLAtof(CPLGetConfigOption("GDAL_RB_FLUSHBLOCK_SLEEP_AFTER_RB_LOCK", "0")));
 
@@ -505,6 +781,8 @@ GDALRasterBlock::GDALRasterBlock( GDALRasterBand *poBandIn,
     nLockCount = 0;
 
     poNext = poPrevious = NULL;
+    nList = -1;
+    nListSeq = 0;
 
     nXOff = nXOffIn;
     nYOff = nYOffIn;
@@ -540,6 +818,8 @@ GDALRasterBlock::GDALRasterBlock( int nXOffIn, int nYOffIn )
     nLockCount = 0;
 
     poNext = poPrevious = NULL;
+    nList = -1;
+    nListSeq = 0;
 
     nXOff = nXOffIn;
     nYOff = nYOffIn;
@@ -564,6 +844,8 @@ void GDALRasterBlock::RecycleFor( int nXOffIn, int nYOffIn )
     nLockCount = 0;
 
     poNext = poPrevious = NULL;
+    nList = -1;
+    nListSeq = 0;
 
     nXOff = nXOffIn;
     nYOff = nYOffIn;
@@ -597,6 +879,29 @@ GDALRasterBlock::~GDALRasterBlock()
 #endif
 }
 
+/************************************************************************/
+/*                              GetShard()                              */
+/************************************************************************/
+
+/* Returns the shard, or the cache partition, where the block lives */
+GDALRasterBlockCacheShard* GDALRasterBlock::GetShard()
+{
+    GDALRasterBlockCacheShard* poPartition =
+        poBand->poBandBlockCache->GetCachePartition();
+    if( poPartition != NULL )
+        return poPartition;
+
+    if( nShardCount <= 1 )
+        return &asShards[0];
+
+    const GUIntBig nBandKey = static_cast<GUIntBig>(
+                reinterpret_cast<size_t>(poBand)) >> 4;
+    const GUInt32 nHash = static_cast<GUInt32>(nBandKey * 2654435761U) ^
+                          (static_cast<GUInt32>(nXOff) * 73856093U) ^
+                          (static_cast<GUInt32>(nYOff) * 19349663U);
+    return &asShards[nHash % static_cast<GUInt32>(nShardCount)];
+}
+
 /************************************************************************/
 /*                               Detach()                               */
 /************************************************************************/
@@ -615,19 +920,29 @@ void GDALRasterBlock::Detach()
 {
     if( bMustDetach )
     {
-        TAKE_LOCK;
+        TAKE_SHARD_LOCK(GetShard());
         Detach_unlocked();
     }
 }
 
 void GDALRasterBlock::Detach_unlocked()
 {
-    if( poOldest == this )
-        poOldest = poPrevious;
+    GDALRasterBlockCacheShard* poShard = GetShard();
 
-    if( poNewest == this )
+    if( nList >= 0 )
     {
-        poNewest = poNext;
+        GDALRasterBlockList* poList = &poShard->asLists[nList];
+        if( poList->poOldest == this )
+            poList->poOldest = poPrevious;
+
+        if( poList->poNewest == this )
+        {
+            poList->poNewest = poNext;
+        }
+
+        poList->nCount --;
+        poList->nBytes -= GetBlockSize();
+        nList = -1;
     }
 
     if( poPrevious != NULL )
@@ -641,7 +956,10 @@ void GDALRasterBlock::Detach_unlocked()
     bMustDetach = FALSE;
 
     if( pData )
-        nCacheUsed -= GetBlockSize();
+    {
+        poShard->nCacheUsed -= GetBlockSize();
+        poBand->poBandBlockCache->AddCachedBlocks(-1);
+    }
 
 #ifdef ENABLE_DEBUG
     Verify();
@@ -661,27 +979,41 @@ void GDALRasterBlock::Detach_unlocked()
 void GDALRasterBlock::Verify()
 
 {
-    TAKE_LOCK;
-
-    CPLAssert( (poNewest == NULL && poOldest == NULL)
-               || (poNewest != NULL && poOldest != NULL) );
-
-    if( poNewest != NULL )
+    for( int iShard = 0; iShard < nShardCount; iShard++ )
     {
-        CPLAssert( poNewest->poPrevious == NULL );
-        CPLAssert( poOldest->poNext == NULL );
+        GDALRasterBlockCacheShard* poShard = &asShards[iShard];
+        TAKE_SHARD_LOCK(poShard);
 
-        GDALRasterBlock* poLast = NULL;
-        for( GDALRasterBlock *poBlock = poNewest;
-             poBlock != NULL;
-             poBlock = poBlock->poNext )
+        for( int iList = 0; iList < 2; iList++ )
         {
-            CPLAssert( poBlock->poPrevious == poLast );
+            GDALRasterBlockList* poList = &poShard->asLists[iList];
 
-            poLast = poBlock;
-        }
+            CPLAssert( (poList->poNewest == NULL && poList->poOldest == NULL)
+                       || (poList->poNewest != NULL && poList->poOldest != NULL) );
+
+            int nCount = 0;
+            if( poList->poNewest != NULL )
+            {
+                CPLAssert( poList->poNewest->poPrevious == NULL );
+                CPLAssert( poList->poOldest->poNext == NULL );
 
-        CPLAssert( poOldest == poLast );
+                GDALRasterBlock* poLast = NULL;
+                for( GDALRasterBlock *poBlock = poList->poNewest;
+                     poBlock != NULL;
+                     poBlock = poBlock->poNext )
+                {
+                    CPLAssert( poBlock->poPrevious == poLast );
+                    CPLAssert( poBlock->nList == iList );
+                    CPLAssert( poBlock->GetShard() == poShard );
+
+                    poLast = poBlock;
+                    nCount ++;
+                }
+
+                CPLAssert( poList->poOldest == poLast );
+            }
+            CPLAssert( poList->nCount == nCount );
+        }
     }
 }
 
@@ -692,8 +1024,12 @@ void GDALRasterBlock::Verify() {}
 #if 0
 void GDALRasterBlock::CheckNonOrphanedBlocks(GDALRasterBand* poBand)
 {
-    TAKE_LOCK;
-    for( GDALRasterBlock *poBlock = poNewest;
+    for( int iShard = 0; iShard < nShardCount; iShard++ )
+    {
+    TAKE_SHARD_LOCK(&asShards[iShard]);
+    for( int iList = 0; iList < 2; iList++ )
+    {
+    for( GDALRasterBlock *poBlock = asShards[iShard].asLists[iList].poNewest;
                           poBlock != NULL;
                           poBlock = poBlock->poNext )
     {
@@ -712,6 +1048,8 @@ void GDALRasterBlock::CheckNonOrphanedBlocks(GDALRasterBand* poBand)
                 printf("Dataset : %s\n", poBand->GetDataset()->GetDescription());
         }
     }
+    }
+    }
 }
 #endif
 
@@ -765,7 +1103,7 @@ CPLErr GDALRasterBlock::Write()
 void GDALRasterBlock::Touch()
 
 {
-    TAKE_LOCK;
+    TAKE_SHARD_LOCK(GetShard());
     Touch_unlocked();
 }
 
@@ -773,7 +1111,34 @@ void GDALRasterBlock::Touch()
 void GDALRasterBlock::Touch_unlocked()
 
 {
-    if( poNewest == this )
+    GDALRasterBlockCacheShard* poShard = GetShard();
+
+/* -------------------------------------------------------------------- */
+/*      Determine the list where the block must go.                     */
+/* -------------------------------------------------------------------- */
+    int nTargetList = RB_LIST_MAIN;
+    if( eEvictionPolicy == RB_POLICY_2Q )
+    {
+        if( nList < 0 )
+        {
+            nTargetList = RB_LIST_PROBATION;
+        }
+        else if( nList == RB_LIST_PROBATION )
+        {
+            // The probation list is a FIFO. A block is only promoted if it
+            // is accessed again once it is in the older half of the list,
+            // so that repeated accesses in a short period of time, like
+            // reading all the lines of a tile, do not count as reuse.
+            const GUInt32 nAge =
+                poShard->asLists[RB_LIST_PROBATION].nInsertions - nListSeq;
+            if( nAge <= static_cast<GUInt32>(
+                    poShard->asLists[RB_LIST_PROBATION].nCount / 2) )
+                return;
+        }
+    }
+
+    GDALRasterBlockList* poTargetList = &poShard->asLists[nTargetList];
+    if( poTargetList->poNewest == this )
         return;
 
     // In theory, we should not try to touch a block that has been detached
@@ -781,13 +1146,26 @@ void GDALRasterBlock::Touch_unlocked()
     if( !bMustDetach )
     {
         if( pData )
-            nCacheUsed += GetBlockSize();
+        {
+            poShard->nCacheUsed += GetBlockSize();
+            poBand->poBandBlockCache->AddCachedBlocks(1);
+        }
 
         bMustDetach = TRUE;
     }
 
-    if( poOldest == this )
-        poOldest = this->poPrevious;
+    if( nList >= 0 )
+    {
+        GDALRasterBlockList* poList = &poShard->asLists[nList];
+        if( poList->poOldest == this )
+            poList->poOldest = this->poPrevious;
+
+        if( poList->poNewest == this )
+            poList->poNewest = this->poNext;
+
+        poList->nCount --;
+        poList->nBytes -= GetBlockSize();
+    }
 
     if( poPrevious != NULL )
         poPrevious->poNext = poNext;
@@ -796,20 +1174,26 @@ void GDALRasterBlock::Touch_unlocked()
         poNext->poPrevious = poPrevious;
 
     poPrevious = NULL;
-    poNext = poNewest;
+    poNext = poTargetList->poNewest;
 
-    if( poNewest != NULL )
+    if( poTargetList->poNewest != NULL )
     {
-        CPLAssert( poNewest->poPrevious == NULL );
-        poNewest->poPrevious = this;
+        CPLAssert( poTargetList->poNewest->poPrevious == NULL );
+        poTargetList->poNewest->poPrevious = this;
     }
-    poNewest = this;
+    poTargetList->poNewest = this;
 
-    if( poOldest == NULL )
+    if( poTargetList->poOldest == NULL )
     {
         CPLAssert( poPrevious == NULL && poNext == NULL );
-        poOldest = this;
+        poTargetList->poOldest = this;
     }
+
+    poTargetList->nCount ++;
+    poTargetList->nBytes += GetBlockSize();
+    nListSeq = ++poTargetList->nInsertions;
+    nList = nTargetList;
+
 #ifdef ENABLE_DEBUG
     Verify();
 #endif
@@ -838,78 +1222,100 @@ CPLErr GDALRasterBlock::Internalize()
 
     CPLAssert( pData == NULL );
 
-    // This call will initialize the hRBLock mutex. Other call places can
+    // This call will initialize the shard locks. Other call places can
     // only be called if we have go through there.
     GIntBig     nCurCacheMax = GDALGetCacheMax64();
 
     /* No risk of overflow as it is checked in GDALRasterBand::InitBlockInfo() */
     nSizeInBytes = GetBlockSize();
 
+    GDALRasterBlockCacheShard* poShard = GetShard();
+    {
+        TAKE_SHARD_LOCK(poShard);
+        poShard->nCacheUsed += nSizeInBytes;
+        poShard->nMisses ++;
+    }
+    poBand->poBandBlockCache->IncrementMisses();
+    poBand->poBandBlockCache->AddCachedBlocks(1);
+
 /* -------------------------------------------------------------------- */
 /*      Flush old blocks if we are nearing our memory limit.            */
+/*      Candidates are first searched in the shard of this block, and   */
+/*      then in the other shards when it has no evictable block left.   */
+/*      Blocks in a cache partition only evict blocks of the same       */
+/*      partition, to stay under its quota.                             */
 /* -------------------------------------------------------------------- */
-    bool bFirstIter = true;
-    bool bLoopAgain = false;
-    do
+    const bool bPartition = poShard->nQuota > 0;
+    const int nVictimShards = bPartition ? 1 : nShardCount;
+    int iVictimShard = bPartition ? 0 : static_cast<int>(poShard - asShards);
+    int nExhaustedShards = 0;
+    GIntBig nExcess;
+    while( nExhaustedShards < nVictimShards &&
+           (nExcess = bPartition ? poShard->nCacheUsed - poShard->nQuota :
+                                   GetTotalCacheUsed() - nCurCacheMax) > 0 )
     {
-        bLoopAgain = false;
         GDALRasterBlock* apoBlocksToFree[64];
         int nBlocksToFree = 0;
         {
-            TAKE_LOCK;
-
-            if( bFirstIter )
-                nCacheUsed += nSizeInBytes;
-            GDALRasterBlock *poTarget = poOldest;
-            while( nCacheUsed > nCurCacheMax )
+            GDALRasterBlockCacheShard* poVictimShard =
+                bPartition ? poShard : &asShards[iVictimShard];
+            TAKE_SHARD_LOCK(poVictimShard);
+
+            int anListOrder[2];
+            GetEvictionOrder(poVictimShard, nCurCacheMax, anListOrder);
+            int iList = 0;
+            GDALRasterBlock *poTarget =
+                poVictimShard->asLists[anListOrder[iList]].poOldest;
+            while( nExcess > 0 )
             {
-                while( poTarget != NULL )
+                while( true )
                 {
-                    if( CPLAtomicCompareAndExchange(&(poTarget->nLockCount), 0, -1) )
+                    while( poTarget != NULL )
+                    {
+                        if( CPLAtomicCompareAndExchange(&(poTarget->nLockCount), 0, -1) )
+                            break;
+                        poTarget = poTarget->poPrevious;
+                    }
+                    if( poTarget != NULL || iList == 1 )
                         break;
-                    poTarget = poTarget->poPrevious;
+                    iList ++;
+                    poTarget = poVictimShard->asLists[anListOrder[iList]].poOldest;
                 }
 
-                if( poTarget != NULL )
+                if( poTarget == NULL )
                 {
-                    if( bSleepsForBockCacheDebug )
-                        CPLSleep(CPLAtof(CPLGetConfigOption("GDAL_RB_INTERNALIZE_SLEEP_AFTER_DROP_LOCK", "0")));
+                    nExhaustedShards ++;
+                    iVictimShard = (iVictimShard + 1) % nVictimShards;
+                    break;
+                }
 
-                    GDALRasterBlock* _poPrevious = poTarget->poPrevious;
+                if( bSleepsForBockCacheDebug )
+                    CPLSleep(CPLAtof(CPLGetConfigOption("GDAL_RB_INTERNALIZE_SLEEP_AFTER_DROP_LOCK", "0")));
 
-                    poTarget->Detach_unlocked();
-                    poTarget->GetBand()->UnreferenceBlock(poTarget);
+                GDALRasterBlock* _poPrevious = poTarget->poPrevious;
 
-                    apoBlocksToFree[nBlocksToFree++] = poTarget;
-                    if( poTarget->GetDirty() )
-                    {
-                        // Only free one dirty block at a time so that
-                        // other dirty blocks of other bands with the same coordinates
-                        // can be found with TryGetLockedBlock()
-                        bLoopAgain = ( nCacheUsed > nCurCacheMax );
-                        break;
-                    }
-                    if( nBlocksToFree == 64 )
-                    {
-                        bLoopAgain = ( nCacheUsed > nCurCacheMax );
-                        break;
-                    }
+                if( poTarget->pData )
+                    nExcess -= poTarget->GetBlockSize();
+                poVictimShard->nEvictions ++;
+                poTarget->GetBand()->poBandBlockCache->IncrementEvictions();
+                poTarget->Detach_unlocked();
+                poTarget->GetBand()->UnreferenceBlock(poTarget);
 
-                    poTarget = _poPrevious;
+                apoBlocksToFree[nBlocksToFree++] = poTarget;
+                if( poTarget->GetDirty() )
+                {
+                    // Only free one dirty block at a time so that
+                    // other dirty blocks of other bands with the same coordinates
+                    // can be found with TryGetLockedBlock()
+                    break;
                 }
-                else
+                if( nBlocksToFree == 64 )
                     break;
-            }
 
-        /* -------------------------------------------------------------------- */
-        /*      Add this block to the list.                                     */
-        /* -------------------------------------------------------------------- */
-            if( !bLoopAgain )
-                Touch_unlocked();
+                poTarget = _poPrevious;
+            }
         }
 
-        bFirstIter = false;
-
         /* Now free blocks we have detached and removed from their band */
         for(int i=0;i<nBlocksToFree;i++)
         {
@@ -941,7 +1347,14 @@ CPLErr GDALRasterBlock::Internalize()
             poBlock->GetBand()->AddBlockToFreeList(poBlock);
         }
     }
-    while(bLoopAgain);
+
+/* -------------------------------------------------------------------- */
+/*      Add this block to the list.                                     */
+/* -------------------------------------------------------------------- */
+    {
+        TAKE_SHARD_LOCK(poShard);
+        Touch_unlocked();
+    }
 
     if( pNewData == NULL )
     {
@@ -999,9 +1412,64 @@ void GDALRasterBlock::MarkClean()
 
 void GDALRasterBlock::DestroyRBMutex()
 {
-    if( hRBLock != NULL )
-        DESTROY_LOCK;
-    hRBLock = NULL;
+    for( int i = 0; i < GDAL_RB_MAX_SHARDS; i++ )
+    {
+        if( asShards[i].hLock != NULL )
+            CPLDestroyLock( asShards[i].hLock );
+        asShards[i].hLock = NULL;
+    }
+}
+
+/************************************************************************/
+/*                        CreateCachePartition()                        */
+/************************************************************************/
+
+/**
+ * Create a cache partition, that is a set of LRU lists whose size is bounded
+ * by its own quota instead of GDAL_CACHEMAX.
+ *
+ * Should only be used by GDALDataset::SetBlockCacheQuota()
+ */
+
+GDALRasterBlockCacheShard* GDALRasterBlock::CreateCachePartition(
+                                                    GIntBig nQuotaInBytes )
+{
+    CPLAssert( nQuotaInBytes > 0 );
+
+    // Make sure the eviction policy is known
+    InitializeShards();
+
+    GDALRasterBlockCacheShard* poPartition =
+        static_cast<GDALRasterBlockCacheShard*>(
+            VSI_CALLOC_VERBOSE(1, sizeof(GDALRasterBlockCacheShard)));
+    if( poPartition == NULL )
+        return NULL;
+    poPartition->hLock = CPLCreateLock(GetLockType());
+    CPLLockSetDebugPerf(poPartition->hLock, bDebugContention);
+    poPartition->nQuota = nQuotaInBytes;
+    return poPartition;
+}
+
+/************************************************************************/
+/*                        DestroyCachePartition()                       */
+/************************************************************************/
+
+/**
+ * Destroy a cache partition. It must not contain any block.
+ *
+ * Should only be used by GDALDataset
+ */
+
+void GDALRasterBlock::DestroyCachePartition(
+                                    GDALRasterBlockCacheShard* poPartition )
+{
+    if( poPartition == NULL )
+        return;
+    CPLAssert( poPartition->asLists[RB_LIST_MAIN].poNewest == NULL );
+    CPLAssert( poPartition->asLists[RB_LIST_PROBATION].poNewest == NULL );
+    if( poPartition->hLock )
+        CPLDestroyLock(poPartition->hLock);
+    CPLFree(poPartition);
 }
 
 /************************************************************************/
@@ -1037,14 +1505,60 @@ int GDALRasterBlock::TakeLock()
         DropLock();
 
         // wait for the block having been unreferenced
-        TAKE_LOCK;
+        TAKE_SHARD_LOCK(GetShard());
 
         return FALSE;
     }
-    Touch();
+
+    poBand->poBandBlockCache->IncrementHits();
+
+    // The block is now pinned, so it cannot be evicted. If it is already
+    // close to the head of its list, there is no need to take the shard
+    // lock to move it: this is the common case of read-mostly workloads.
+    GDALRasterBlockCacheShard* poShard = GetShard();
+    if( IsRecentlyTouched(poShard) )
+    {
+        if( CPLAtomicInc(&poShard->nPendingHits) <= (1 << 30) )
+            return TRUE;
+    }
+
+    TAKE_SHARD_LOCK(poShard);
+    FoldPendingHits(poShard);
+    poShard->nHits ++;
+    Touch_unlocked();
     return TRUE;
 }
 
+/************************************************************************/
+/*                          IsRecentlyTouched()                         */
+/************************************************************************/
+
+/* Return whether Touch_unlocked() would not move the block or would only */
+/* move it slightly. This is evaluated without the shard lock, so the     */
+/* block must be pinned. The answer can be stale, which at worst causes   */
+/* a useless Touch_unlocked() or a small deviation from LRU order.        */
+
+bool GDALRasterBlock::IsRecentlyTouched(
+                            const GDALRasterBlockCacheShard* poShard ) const
+{
+    const int nCurList = nList;
+    if( nCurList < 0 || !bMustDetach )
+        return false;
+
+    // Number of blocks put at the head of the list since this one was.
+    // The block can be at most that far from the head.
+    const GDALRasterBlockList* poList = &poShard->asLists[nCurList];
+    const GUInt32 nAge = poList->nInsertions - nListSeq;
+    const GUInt32 nCount = static_cast<GUInt32>(poList->nCount);
+
+    // In the probation list, this is the condition for Touch_unlocked()
+    // not to promote the block. In the main list, the block stays in the
+    // most recently used quarter of the list.
+    if( nCurList == RB_LIST_PROBATION )
+        return nAge <= nCount / 2;
+    return nAge <= nCount / 4;
+}
+
 /************************************************************************/
 /*                      DropLockForRemovalFromStorage()                 */
 /************************************************************************/
@@ -1071,7 +1585,7 @@ int GDALRasterBlock::DropLockForRemovalFromStorage()
 #endif
 
     // Wait for the block for having been unreferenced
-    TAKE_LOCK;
+    TAKE_SHARD_LOCK(GetShard());
 
     return FALSE;
 }
@@ -1080,14 +1594,20 @@ int GDALRasterBlock::DropLockForRemovalFromStorage()
 void GDALRasterBlock::DumpAll()
 {
     int iBlock = 0;
-    for( GDALRasterBlock *poBlock = poNewest;
-                            poBlock != NULL;
-                            poBlock = poBlock->poNext )
+    for( int iShard = 0; iShard < nShardCount; iShard++ )
     {
-        printf("Block %d\n", iBlock);
-        poBlock->DumpBlock();
-        printf("\n");
-        iBlock ++;
+        for( int iList = 0; iList < 2; iList++ )
+        {
+            for( GDALRasterBlock *poBlock = asShards[iShard].asLists[iList].poNewest;
+                                    poBlock != NULL;
+                                    poBlock = poBlock->poNext )
+            {
+                printf("Block %d (shard %d, list %d)\n", iBlock, iShard, iList);
+                poBlock->DumpBlock();
+                printf("\n");
+                iBlock ++;
+            }
+        }
     }
 }
 
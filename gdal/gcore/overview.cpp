@@ -29,9 +29,20 @@
  ****************************************************************************/
 
 #include <limits>
+#include <vector>
 
 #include "gdal_priv.h"
 #include "gdalwarper.h"
+#include "cpl_multiproc.h"
+#include "cpl_worker_thread_pool.h"
+
+/* The AVX2 kernels of overview_avx2.cpp give the same results as the SSE2 */
+/* code, which is only used on 64bit processors */
+#if (defined(__x86_64) || defined(_M_X64)) && defined(HAVE_AVX2_AT_COMPILE_TIME)
+#define USE_AVX2
+#include "cpl_cpu_features.h"
+#include "overview_avx2.hpp"
+#endif
 
 CPL_CVSID("$Id$");
 
@@ -283,6 +294,13 @@ GDALResampleChunk32R_AverageT( double dfXRatioDstToSrc,
 /* ==================================================================== */
     int iDstPixel;
     bool bSrcXSpacingIsTwo = true;
+    bool bFactor2FastPath = (eWrkDataType == GDT_Byte || eWrkDataType == GDT_UInt16);
+#ifdef USE_AVX2
+    const bool bUseAVX2 = CPLUseAVX2();
+    /* The AVX2 kernel computes the float average like the general case */
+    if( bUseAVX2 && eWrkDataType == GDT_Float32 )
+        bFactor2FastPath = true;
+#endif
     for( iDstPixel = nDstXOff; iDstPixel < nDstXOff2; iDstPixel++ )
     {
         int   nSrcXOff, nSrcXOff2;
@@ -339,10 +357,19 @@ GDALResampleChunk32R_AverageT( double dfXRatioDstToSrc,
         if (poColorTable == NULL)
         {
             if (bSrcXSpacingIsTwo && nSrcYOff2 == nSrcYOff + 2 &&
-                pabyChunkNodataMask == NULL && (eWrkDataType == GDT_Byte || eWrkDataType == GDT_UInt16))
+                pabyChunkNodataMask == NULL && bFactor2FastPath)
             {
                 /* Optimized case : no nodata, overview by a factor of 2 and regular x and y src spacing */
                 T* pSrcScanlineShifted = pChunk + panSrcXOffShifted[0] + (nSrcYOff - nChunkYOff) * nChunkXSize;
+#ifdef USE_AVX2
+                if( bUseAVX2 )
+                {
+                    GDALResampleAverageBy2AVX2(pSrcScanlineShifted,
+                                               pSrcScanlineShifted + nChunkXSize,
+                                               pDstScanline, nDstXWidth);
+                }
+                else
+#endif
                 for( iDstPixel = 0; iDstPixel < nDstXWidth; iDstPixel++ )
                 {
                     Tsum nTotal;
@@ -1442,6 +1469,9 @@ GDALResampleChunk32R_ConvolutionT( double dfXRatioDstToSrc, double dfYRatioDstTo
     int nChunkRightXOff = nChunkXOff + nChunkXSize;
 #ifdef USE_SSE2
     bool bSrcPixelCountLess8 = dfXScaledRadius < 4;
+#endif
+#ifdef USE_AVX2
+    const bool bUseAVX2 = CPLUseAVX2();
 #endif
     for( int iDstPixel = nDstXOff; iDstPixel < nDstXOff2; iDstPixel++ )
     {
@@ -1496,6 +1526,16 @@ GDALResampleChunk32R_ConvolutionT( double dfXRatioDstToSrc, double dfYRatioDstTo
                 for(int i=0;i<nSrcPixelCount;i++)
                     padfWeights[i] *= dfInvWeightSum;
             }
+#ifdef USE_AVX2
+            if( bUseAVX2 )
+            {
+                GDALResampleConvolutionHorizontalAVX2(
+                    pChunk + (nSrcPixelStart - nChunkXOff), nChunkXSize, nHeight,
+                    padfWeights, nSrcPixelCount, bSrcPixelCountLess8,
+                    padfHorizontalFiltered + iDstPixel - nDstXOff, nDstXSize);
+                continue;
+            }
+#endif
             int iSrcLineOff = 0;
 #ifdef USE_SSE2
             if( bSrcPixelCountLess8 )
@@ -1538,6 +1578,19 @@ GDALResampleChunk32R_ConvolutionT( double dfXRatioDstToSrc, double dfYRatioDstTo
         }
         else
         {
+#ifdef USE_AVX2
+            if( bUseAVX2 )
+            {
+                GDALResampleConvolutionHorizontalWithMaskAVX2(
+                    pChunk + (nSrcPixelStart - nChunkXOff),
+                    pabyChunkNodataMask + (nSrcPixelStart - nChunkXOff),
+                    nChunkXSize, nHeight, padfWeights, nSrcPixelCount,
+                    padfHorizontalFiltered + iDstPixel - nDstXOff,
+                    pabyChunkNodataMaskHorizontalFiltered + iDstPixel - nDstXOff,
+                    nDstXSize);
+                continue;
+            }
+#endif
             for( int iSrcLineOff = 0; iSrcLineOff < nHeight; iSrcLineOff ++ )
             {
                 double dfVal;
@@ -1621,6 +1674,27 @@ GDALResampleChunk32R_ConvolutionT( double dfXRatioDstToSrc, double dfYRatioDstTo
             }
         }
 
+#ifdef USE_AVX2
+        if( bUseAVX2 )
+        {
+            const int j = (nSrcLineStart - nChunkYOff) * nDstXSize;
+            if( pabyChunkNodataMask == NULL )
+            {
+                GDALResampleConvolutionVerticalAVX2(
+                    padfHorizontalFilteredBand + j, nDstXSize,
+                    padfWeights, nSrcLineCount, pafDstScanline, nDstXSize);
+            }
+            else
+            {
+                GDALResampleConvolutionVerticalWithMaskAVX2(
+                    padfHorizontalFilteredBand + j,
+                    pabyChunkNodataMaskHorizontalFiltered + j, nDstXSize,
+                    padfWeights, nSrcLineCount, fNoDataValue,
+                    pafDstScanline, nDstXSize);
+            }
+        }
+        else
+#endif
         if( pabyChunkNodataMask == NULL )
         {
             int iFilteredPixelOff = 0;
@@ -2258,61 +2332,15 @@ GDALDataType GDALGetOvrWorkDataType(const char* pszResampling,
 }
 
 /************************************************************************/
-/*                      GDALRegenerateOverviews()                       */
+/*                     GDALGetOverviewColorTable()                      */
 /************************************************************************/
 
-/**
- * \brief Generate downsampled overviews.
- *
- * This function will generate one or more overview images from a base
- * image using the requested downsampling algorithm.  It's primary use
- * is for generating overviews via GDALDataset::BuildOverviews(), but it
- * can also be used to generate downsampled images in one file from another
- * outside the overview architecture.
- *
- * The output bands need to exist in advance.
- *
- * The full set of resampling algorithms is documented in
- * GDALDataset::BuildOverviews().
- *
- * This function will honour properly NODATA_VALUES tuples (special dataset metadata) so
- * that only a given RGB triplet (in case of a RGB image) will be considered as the
- * nodata value and not each value of the triplet independently per band.
- *
- * @param hSrcBand the source (base level) band.
- * @param nOverviewCount the number of downsampled bands being generated.
- * @param pahOvrBands the list of downsampled bands to be generated.
- * @param pszResampling Resampling algorithm (e.g. "AVERAGE").
- * @param pfnProgress progress report function.
- * @param pProgressData progress function callback data.
- * @return CE_None on success or CE_Failure on failure.
- */
-CPLErr
-GDALRegenerateOverviews( GDALRasterBandH hSrcBand,
-                         int nOverviewCount, GDALRasterBandH *pahOvrBands,
-                         const char * pszResampling,
-                         GDALProgressFunc pfnProgress, void * pProgressData )
+/* Return the color table to take into account to resample poSrcBand, or */
+/* NULL. */
 
+static GDALColorTable* GDALGetOverviewColorTable( GDALRasterBand* poSrcBand,
+                                                  const char* pszResampling )
 {
-    GDALRasterBand *poSrcBand = (GDALRasterBand *) hSrcBand;
-    GDALRasterBand **papoOvrBands = (GDALRasterBand **) pahOvrBands;
-
-    if( pfnProgress == NULL )
-        pfnProgress = GDALDummyProgress;
-
-    if( EQUAL(pszResampling,"NONE") )
-        return CE_None;
-
-    int nKernelRadius;
-    GDALResampleFunction pfnResampleFn
-        = GDALGetResampleFunction(pszResampling, &nKernelRadius);
-
-    if (pfnResampleFn == NULL)
-        return CE_Failure;
-
-/* -------------------------------------------------------------------- */
-/*      Check color tables...                                           */
-/* -------------------------------------------------------------------- */
     GDALColorTable* poColorTable = NULL;
 
     if ((STARTS_WITH_CI(pszResampling, "AVER")
@@ -2352,220 +2380,1492 @@ GDALRegenerateOverviews( GDALRasterBandH hSrcBand,
                     "will probably lead to unexpected results.", pszResampling);
     }
 
+    return poColorTable;
+}
 
-    /* If we have a nodata mask and we are doing something more complicated */
-    /* than nearest neighbouring, we have to fetch to nodata mask */
+/************************************************************************/
+/*                      GDALPromoteBit2Grayscale()                      */
+/************************************************************************/
 
-    GDALRasterBand* poMaskBand = NULL;
-    int nMaskFlags = 0;
-    bool bUseNoDataMask = false;
+/* Promote 1bit data to 8bit 0/255 values for the AVERAGE_BIT2GRAYSCALE */
+/* resampling methods. */
 
-    if( !STARTS_WITH_CI(pszResampling, "NEAR") )
+static void GDALPromoteBit2Grayscale( const char* pszResampling,
+                                      GDALDataType eType, void* pChunk,
+                                      int nCount )
+{
+    if( EQUAL(pszResampling,"AVERAGE_BIT2GRAYSCALE") )
     {
-        /* Special case if we are the alpha band. We want it to be considered */
-        /* as the mask band to avoid alpha=0 to be taken into account in average */
-        /* computation */
-        if( poSrcBand->GetColorInterpretation() == GCI_AlphaBand )
+        if (eType == GDT_Float32)
         {
-            poMaskBand = poSrcBand;
-            nMaskFlags = GMF_ALPHA | GMF_PER_DATASET;
+            float* pafChunk = (float*)pChunk;
+            for( int i = nCount - 1; i >= 0; i-- )
+            {
+                if( pafChunk[i] == 1.0 )
+                    pafChunk[i] = 255.0;
+            }
         }
-        else
+        else if (eType == GDT_Byte)
         {
-            poMaskBand = poSrcBand->GetMaskBand();
-            nMaskFlags = poSrcBand->GetMaskFlags();
+            GByte* pabyChunk = (GByte*)pChunk;
+            for( int i = nCount - 1; i >= 0; i-- )
+            {
+                if( pabyChunk[i] == 1 )
+                    pabyChunk[i] = 255;
+            }
+        }
+        else if (eType == GDT_UInt16)
+        {
+            GUInt16* pasChunk = (GUInt16*)pChunk;
+            for( int i = nCount - 1; i >= 0; i-- )
+            {
+                if( pasChunk[i] == 1 )
+                    pasChunk[i] = 255;
+            }
+        }
+        else {
+            CPLAssert(0);
+        }
+    }
+    else if( EQUAL(pszResampling,"AVERAGE_BIT2GRAYSCALE_MINISWHITE") )
+    {
+        if (eType == GDT_Float32)
+        {
+            float* pafChunk = (float*)pChunk;
+            for( int i = nCount - 1; i >= 0; i-- )
+            {
+                if( pafChunk[i] == 1.0 )
+                    pafChunk[i] = 0.0;
+                else if( pafChunk[i] == 0.0 )
+                    pafChunk[i] = 255.0;
+            }
+        }
+        else if (eType == GDT_Byte)
+        {
+            GByte* pabyChunk = (GByte*)pChunk;
+            for( int i = nCount - 1; i >= 0; i-- )
+            {
+                if( pabyChunk[i] == 1 )
+                    pabyChunk[i] = 0;
+                else if( pabyChunk[i] == 0 )
+                    pabyChunk[i] = 255;
+            }
+        }
+        else if (eType == GDT_UInt16)
+        {
+            GUInt16* pasChunk = (GUInt16*)pChunk;
+            for( int i = nCount - 1; i >= 0; i-- )
+            {
+                if( pasChunk[i] == 1 )
+                    pasChunk[i] = 0;
+                else if( pasChunk[i] == 0 )
+                    pasChunk[i] = 255;
+            }
+        }
+        else {
+            CPLAssert(0);
         }
-
-        bUseNoDataMask = ((nMaskFlags & GMF_ALL_VALID) == 0);
     }
+}
 
-/* -------------------------------------------------------------------- */
-/*      If we are operating on multiple overviews, and using            */
-/*      averaging, lets do them in cascading order to reduce the        */
-/*      amount of computation.                                          */
-/* -------------------------------------------------------------------- */
+/************************************************************************/
+/*                         GDALOverviewJobBand                          */
+/************************************************************************/
 
-    /* In case the mask made be computed from another band of the dataset, */
-    /* we can't use cascaded generation, as the computation of the overviews */
-    /* of the band used for the mask band may not have yet occurred (#3033) */
-    if( (STARTS_WITH_CI(pszResampling, "AVER") |
-         STARTS_WITH_CI(pszResampling, "GAUSS") ||
-         EQUAL(pszResampling,"CUBIC") ||
-         EQUAL(pszResampling,"CUBICSPLINE") ||
-         EQUAL(pszResampling,"LANCZOS") ||
-         EQUAL(pszResampling,"BILINEAR")) && nOverviewCount > 1
-         && !(bUseNoDataMask && nMaskFlags != GMF_NODATA))
-        return GDALRegenerateCascadingOverviews( poSrcBand,
-                                                 nOverviewCount, papoOvrBands,
-                                                 pszResampling,
-                                                 pfnProgress,
-                                                 pProgressData );
+/* Band standing for an overview while a chunk of it is resampled in a    */
+/* worker thread. It has the dimensions, data type, nodata value and      */
+/* NBITS of the overview, and keeps in memory the lines that the          */
+/* resampling function writes in the window of the chunk, until the       */
+/* calling thread writes them to the overview with WriteToOverview(), line */
+/* by line and with the data type used by the resampling function, as it  */
+/* would have done. The lines can also be read back, with the values they */
+/* have once written to the overview, to compute the next overview level. */
 
-/* -------------------------------------------------------------------- */
-/*      Setup one horizontal swath to read from the raw buffer.         */
-/* -------------------------------------------------------------------- */
-    int nFRXBlockSize, nFRYBlockSize;
-    poSrcBand->GetBlockSize( &nFRXBlockSize, &nFRYBlockSize );
+class GDALOverviewJobBand : public GDALRasterBand
+{
+    GDALRasterBand *poOverview;
+    int             nWinXOff;
+    int             nWinYOff;
+    int             nWinXSize;
+    int             nWinYSize;
+    GDALDataType    eWinDataType;
+    GByte          *pabyWinData;
+    size_t          nWinDataAlloc;
+    int             bHasNoData;
+    double          dfNoDataValue;
+
+  protected:
+    virtual CPLErr IReadBlock( int, int, void * );
+    virtual CPLErr IRasterIO( GDALRWFlag, int, int, int, int,
+                              void *, int, int, GDALDataType,
+                              GSpacing, GSpacing,
+                              GDALRasterIOExtraArg* psExtraArg );
+
+  public:
+    explicit    GDALOverviewJobBand( GDALRasterBand *poOverview );
+    virtual    ~GDALOverviewJobBand();
+
+    virtual double GetNoDataValue( int *pbSuccess = NULL );
+
+    GDALRasterBand *GetTargetOverview() { return poOverview; }
+    void        SetWindow( int nXOff, int nYOff, int nXSize, int nYSize );
+    CPLErr      WriteToOverview();
+};
+
+GDALOverviewJobBand::GDALOverviewJobBand( GDALRasterBand *poOverviewIn ) :
+    GDALRasterBand(FALSE),
+    poOverview(poOverviewIn),
+    nWinXOff(0),
+    nWinYOff(0),
+    nWinXSize(0),
+    nWinYSize(0),
+    eWinDataType(GDT_Unknown),
+    pabyWinData(NULL),
+    nWinDataAlloc(0),
+    bHasNoData(FALSE),
+    dfNoDataValue(0.0)
+{
+    nRasterXSize = poOverview->GetXSize();
+    nRasterYSize = poOverview->GetYSize();
+    eDataType = poOverview->GetRasterDataType();
+    eAccess = GA_Update;
+    nBlockXSize = nRasterXSize;
+    nBlockYSize = 1;
+
+    // Used by the convolution kernels to clamp the values
+    const char* pszNBITS =
+        poOverview->GetMetadataItem("NBITS", "IMAGE_STRUCTURE");
+    if( pszNBITS != NULL )
+        SetMetadataItem("NBITS", pszNBITS, "IMAGE_STRUCTURE");
+
+    dfNoDataValue = poOverview->GetNoDataValue(&bHasNoData);
+}
 
-    int nFullResYChunk;
-    if( nFRYBlockSize < 16 || nFRYBlockSize > 256 )
-        nFullResYChunk = 64;
-    else
-        nFullResYChunk = nFRYBlockSize;
+GDALOverviewJobBand::~GDALOverviewJobBand()
+{
+    CPLFree(pabyWinData);
+}
 
-    GDALDataType eType;
-    if( GDALDataTypeIsComplex( poSrcBand->GetRasterDataType() ) )
-        eType = GDT_CFloat32;
-    else
-        eType = GDALGetOvrWorkDataType(pszResampling, poSrcBand->GetRasterDataType());
+/* Blocks are whole lines */
 
-    const int nWidth = poSrcBand->GetXSize();
-    const int nHeight = poSrcBand->GetYSize();
+CPLErr GDALOverviewJobBand::IReadBlock( int /* nXBlockOff */, int nYBlockOff,
+                                        void *pImage )
+{
+    return IRasterIO( GF_Read, 0, nYBlockOff,
+                      nBlockXSize, nBlockYSize, pImage,
+                      nBlockXSize, nBlockYSize, eDataType,
+                      GDALGetDataTypeSizeBytes(eDataType),
+                      static_cast<GSpacing>(nBlockXSize) *
+                                    GDALGetDataTypeSizeBytes(eDataType),
+                      NULL );
+}
 
-    int nMaxOvrFactor = 1;
-    for( int iOverview = 0; iOverview < nOverviewCount; iOverview ++ )
+double GDALOverviewJobBand::GetNoDataValue( int *pbSuccess )
+{
+    if( pbSuccess )
+        *pbSuccess = bHasNoData;
+    return dfNoDataValue;
+}
+
+void GDALOverviewJobBand::SetWindow( int nXOff, int nYOff,
+                                     int nXSize, int nYSize )
+{
+    nWinXOff = nXOff;
+    nWinYOff = nYOff;
+    nWinXSize = nXSize;
+    nWinYSize = nYSize;
+    eWinDataType = GDT_Unknown;
+}
+
+CPLErr GDALOverviewJobBand::IRasterIO( GDALRWFlag eRWFlag,
+                                       int nXOff, int nYOff,
+                                       int nXSize, int nYSize,
+                                       void * pData,
+                                       int nBufXSize, int nBufYSize,
+                                       GDALDataType eBufType,
+                                       GSpacing nPixelSpace,
+                                       GSpacing nLineSpace,
+                                       GDALRasterIOExtraArg* /* psExtraArg */ )
+{
+    if( nBufXSize != nXSize || nBufYSize != nYSize ||
+        nXOff < nWinXOff || nXOff + nXSize > nWinXOff + nWinXSize ||
+        nYOff < nWinYOff || nYOff + nYSize > nWinYOff + nWinYSize ||
+        (eRWFlag == GF_Read && eWinDataType == GDT_Unknown) )
     {
-        const int nDstWidth = papoOvrBands[iOverview]->GetXSize();
-        const int nDstHeight = papoOvrBands[iOverview]->GetYSize();
-        nMaxOvrFactor = MAX( nMaxOvrFactor, (int)((double)nWidth / nDstWidth + 0.5) );
-        nMaxOvrFactor = MAX( nMaxOvrFactor, (int)((double)nHeight / nDstHeight + 0.5) );
+        CPLError(CE_Failure, CPLE_NotSupported,
+                 "GDALOverviewJobBand::IRasterIO(): unsupported request");
+        return CE_Failure;
     }
-    const int nMaxChunkYSizeQueried = nFullResYChunk + 2 * nKernelRadius * nMaxOvrFactor;
 
-    GByte *pabyChunkNodataMask = NULL;
-    void *pChunk =
-        VSI_MALLOC3_VERBOSE(
-            GDALGetDataTypeSizeBytes(eType), nMaxChunkYSizeQueried, nWidth );
-    if (bUseNoDataMask)
+    if( eRWFlag == GF_Read )
     {
-        pabyChunkNodataMask =
-            (GByte*) VSI_MALLOC2_VERBOSE( nMaxChunkYSizeQueried, nWidth );
+        // Go through the data type of the overview, as when reading it
+        const int nWinDTSize = GDALGetDataTypeSizeBytes(eWinDataType);
+        const int nDTSize = GDALGetDataTypeSizeBytes(eDataType);
+        GByte* pabyLine = static_cast<GByte*>(
+            VSI_MALLOC2_VERBOSE(nXSize, nDTSize) );
+        if( pabyLine == NULL )
+            return CE_Failure;
+        for( int iY = 0; iY < nYSize; iY++ )
+        {
+            GDALCopyWords( pabyWinData +
+                            (static_cast<size_t>(nYOff + iY - nWinYOff) *
+                                nWinXSize + nXOff - nWinXOff) * nWinDTSize,
+                           eWinDataType, nWinDTSize,
+                           pabyLine, eDataType, nDTSize,
+                           nXSize );
+            GDALCopyWords( pabyLine, eDataType, nDTSize,
+                           static_cast<GByte*>(pData) + iY * nLineSpace,
+                           eBufType, static_cast<int>(nPixelSpace),
+                           nXSize );
+        }
+        CPLFree(pabyLine);
+        return CE_None;
     }
 
-    if( pChunk == NULL || (bUseNoDataMask && pabyChunkNodataMask == NULL))
+    // The lines are stored with the data type of the first write
+    if( eWinDataType == GDT_Unknown )
     {
-        CPLFree(pChunk);
-        CPLFree(pabyChunkNodataMask);
-        return CE_Failure;
+        const size_t nNeeded = static_cast<size_t>(nWinXSize) * nWinYSize *
+                                    GDALGetDataTypeSizeBytes(eBufType);
+        if( nNeeded > nWinDataAlloc )
+        {
+            GByte* pabyNew = static_cast<GByte*>(
+                VSI_REALLOC_VERBOSE(pabyWinData, nNeeded) );
+            if( pabyNew == NULL )
+                return CE_Failure;
+            pabyWinData = pabyNew;
+            nWinDataAlloc = nNeeded;
+        }
+        eWinDataType = eBufType;
     }
 
-    int bHasNoData;
-    const float fNoDataValue = (float) poSrcBand->GetNoDataValue(&bHasNoData);
+    const int nDTSize = GDALGetDataTypeSizeBytes(eWinDataType);
+    for( int iY = 0; iY < nYSize; iY++ )
+    {
+        GDALCopyWords( static_cast<GByte*>(pData) + iY * nLineSpace,
+                       eBufType, static_cast<int>(nPixelSpace),
+                       pabyWinData +
+                        (static_cast<size_t>(nYOff + iY - nWinYOff) *
+                            nWinXSize + nXOff - nWinXOff) * nDTSize,
+                       eWinDataType, nDTSize,
+                       nXSize );
+    }
 
-/* -------------------------------------------------------------------- */
-/*      Loop over image operating on chunks.                            */
-/* -------------------------------------------------------------------- */
-    int  nChunkYOff = 0;
+    return CE_None;
+}
+
+/* The resampling functions write all the lines of their destination */
+/* window, so they are all written to the overview. */
+
+CPLErr GDALOverviewJobBand::WriteToOverview()
+{
+    if( eWinDataType == GDT_Unknown )
+        return CE_None;
+
+    const int nDTSize = GDALGetDataTypeSizeBytes(eWinDataType);
     CPLErr eErr = CE_None;
+    for( int iY = 0; iY < nWinYSize && eErr == CE_None; iY++ )
+    {
+        eErr = poOverview->RasterIO( GF_Write, nWinXOff, nWinYOff + iY,
+                                     nWinXSize, 1,
+                                     pabyWinData + static_cast<size_t>(iY) *
+                                                    nWinXSize * nDTSize,
+                                     nWinXSize, 1, eWinDataType,
+                                     0, 0, NULL );
+    }
+    return eErr;
+}
 
-    for( nChunkYOff = 0;
-         nChunkYOff < nHeight && eErr == CE_None;
-         nChunkYOff += nFullResYChunk )
+/************************************************************************/
+/*                        GDALOverviewPipeline                          */
+/************************************************************************/
+
+struct GDALOverviewChunk;
+class GDALOverviewPipeline;
+
+/* One call of a resampling function, on the chunk of a source band, to */
+/* compute a window of an overview. */
+
+struct GDALOverviewResampleJob
+{
+    // NULL to use GDALResampleChunkC32R()
+    GDALResampleFunction pfnResampleFn;
+    double          dfXRatioDstToSrc;
+    double          dfYRatioDstToSrc;
+    GDALDataType    eWrkDataType;
+    void           *pChunk;
+    GByte          *pabyChunkNodataMask;
+    int             nSrcWidth;
+    int             nSrcHeight;
+    int             nChunkXOff;
+    int             nChunkXSize;
+    int             nChunkYOff;
+    int             nChunkYSize;
+    int             nDstXOff;
+    int             nDstXOff2;
+    int             nDstYOff;
+    int             nDstYOff2;
+    GDALRasterBand *poOverview;
+    const char     *pszResampling;
+    int             bHasNoData;
+    float           fNoDataValue;
+    GDALColorTable *poColorTable;
+    GDALDataType    eSrcDataType;
+
+    // Set when the job runs in a worker thread
+    GDALOverviewJobBand *poJobBand;
+    GDALOverviewChunk *psChunk;
+    CPLErr          eErr;
+
+    GDALOverviewResampleJob() :
+        pfnResampleFn(NULL), dfXRatioDstToSrc(1.0), dfYRatioDstToSrc(1.0),
+        eWrkDataType(GDT_Unknown), pChunk(NULL), pabyChunkNodataMask(NULL),
+        nSrcWidth(0), nSrcHeight(0),
+        nChunkXOff(0), nChunkXSize(0), nChunkYOff(0), nChunkYSize(0),
+        nDstXOff(0), nDstXOff2(0), nDstYOff(0), nDstYOff2(0),
+        poOverview(NULL), pszResampling(NULL), bHasNoData(FALSE),
+        fNoDataValue(0.0f), poColorTable(NULL), eSrcDataType(GDT_Unknown),
+        poJobBand(NULL), psChunk(NULL), eErr(CE_None) {}
+
+    CPLErr Run( GDALRasterBand* poDstBand ) const;
+};
+
+CPLErr GDALOverviewResampleJob::Run( GDALRasterBand* poDstBand ) const
+{
+    if( pfnResampleFn == NULL )
+        return GDALResampleChunkC32R( nSrcWidth, nSrcHeight,
+                                      static_cast<float*>(pChunk),
+                                      nChunkYOff, nChunkYSize,
+                                      nDstYOff, nDstYOff2,
+                                      poDstBand, pszResampling );
+
+    return pfnResampleFn( dfXRatioDstToSrc, dfYRatioDstToSrc,
+                          0.0, 0.0,
+                          eWrkDataType,
+                          pChunk,
+                          pabyChunkNodataMask,
+                          nChunkXOff, nChunkXSize,
+                          nChunkYOff, nChunkYSize,
+                          nDstXOff, nDstXOff2,
+                          nDstYOff, nDstYOff2,
+                          poDstBand, pszResampling,
+                          bHasNoData, fNoDataValue, poColorTable,
+                          eSrcDataType );
+}
+
+/* Source buffers of a chunk, one per band, and the resampling jobs that */
+/* use them. */
+
+struct GDALOverviewChunk
+{
+    std::vector<void*>   apBuffers;
+    GByte               *pabyNodataMask;
+    std::vector<GDALOverviewResampleJob> asJobs;
+    std::vector<GDALOverviewJobBand*> apoJobBands;
+    int                  nPendingJobs;
+    GDALOverviewPipeline *poPipeline;
+
+    GDALOverviewChunk() : pabyNodataMask(NULL), nPendingJobs(0),
+                          poPipeline(NULL) {}
+};
+
+/* Runs the resampling jobs of the chunks of an overview generation in a */
+/* pool of worker threads, when GDAL_NUM_THREADS is set, while the        */
+/* calling thread reads the next chunks. The resampled chunks are written */
+/* by the calling thread, in the order they were submitted, with the same */
+/* write requests as in the single-threaded case, so that the output does */
+/* not depend on the number of threads. Without a thread pool, the jobs   */
+/* are run, and write directly to the overviews, when submitted.          */
+
+class GDALOverviewPipeline
+{
+    CPLWorkerThreadPool *poPool;
+    CPLMutex        *hMutex;
+    CPLCond         *hCond;
+    std::vector<GDALOverviewChunk> asChunks;
+    int              iOldestChunk;
+    int              nQueuedChunks;
+    CPLErr           eErr;
+
+    static void      ResampleJobFunc( void* pData );
+    void             WriteOldestChunk();
+    void             FreeBuffers();
+
+  public:
+                     GDALOverviewPipeline();
+                    ~GDALOverviewPipeline();
+
+    bool             Init( int nBands, GDALDataType eWrkDataType,
+                           int nChunkXSize, int nChunkYSize,
+                           bool bNodataMask );
+    GDALOverviewChunk *GetFreeChunk();
+    CPLErr           Submit( GDALOverviewChunk* psChunk );
+    CPLErr           Finish();
+};
+
+GDALOverviewPipeline::GDALOverviewPipeline() :
+    poPool(NULL),
+    hMutex(NULL),
+    hCond(NULL),
+    iOldestChunk(0),
+    nQueuedChunks(0),
+    eErr(CE_None)
+{
+    int nThreads = 0;
+    const char* pszValue = CPLGetConfigOption("GDAL_NUM_THREADS", NULL);
+    if( pszValue )
     {
-        if( !pfnProgress( nChunkYOff / (double) nHeight,
-                          NULL, pProgressData ) )
+        if( EQUAL(pszValue, "ALL_CPUS") )
+            nThreads = CPLGetNumCPUs();
+        else
+            nThreads = atoi(pszValue);
+    }
+    if( nThreads > 1 )
+    {
+        poPool = new CPLWorkerThreadPool();
+        if( !poPool->Setup(nThreads, NULL, NULL) )
         {
-            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
-            eErr = CE_Failure;
+            delete poPool;
+            poPool = NULL;
         }
+    }
 
-        if( nFullResYChunk + nChunkYOff > nHeight )
-            nFullResYChunk = nHeight - nChunkYOff;
+    // One chunk more than threads, so that the next chunk is read while
+    // the other ones are resampled.
+    if( poPool != NULL )
+    {
+        hMutex = CPLCreateMutex();
+        CPLReleaseMutex(hMutex);
+        hCond = CPLCreateCond();
+        asChunks.resize(nThreads + 1);
+    }
+    else
+        asChunks.resize(1);
+    for( size_t i = 0; i < asChunks.size(); i++ )
+        asChunks[i].poPipeline = this;
+}
 
-        int nChunkYOffQueried = nChunkYOff - nKernelRadius * nMaxOvrFactor;
-        int nChunkYSizeQueried = nFullResYChunk + 2 * nKernelRadius * nMaxOvrFactor;
-        if( nChunkYOffQueried < 0 )
-        {
-            nChunkYSizeQueried += nChunkYOffQueried;
-            nChunkYOffQueried = 0;
-        }
-        if( nChunkYOffQueried + nChunkYSizeQueried > nHeight )
-            nChunkYSizeQueried = nHeight - nChunkYOffQueried;
+GDALOverviewPipeline::~GDALOverviewPipeline()
+{
+    if( poPool != NULL )
+        poPool->WaitCompletion();
+    delete poPool;
+    if( hCond != NULL )
+        CPLDestroyCond(hCond);
+    if( hMutex != NULL )
+        CPLDestroyMutex(hMutex);
+
+    FreeBuffers();
+    for( size_t i = 0; i < asChunks.size(); i++ )
+    {
+        for( size_t j = 0; j < asChunks[i].apoJobBands.size(); j++ )
+            delete asChunks[i].apoJobBands[j];
+    }
+}
 
-        /* read chunk */
-        if (eErr == CE_None)
-            eErr = poSrcBand->RasterIO( GF_Read, 0, nChunkYOffQueried, nWidth, nChunkYSizeQueried,
-                                pChunk, nWidth, nChunkYSizeQueried, eType,
-                                0, 0, NULL );
-        if (eErr == CE_None && bUseNoDataMask)
-            eErr = poMaskBand->RasterIO( GF_Read, 0, nChunkYOffQueried, nWidth, nChunkYSizeQueried,
-                                pabyChunkNodataMask, nWidth, nChunkYSizeQueried, GDT_Byte,
-                                0, 0, NULL );
+void GDALOverviewPipeline::FreeBuffers()
+{
+    for( size_t i = 0; i < asChunks.size(); i++ )
+    {
+        for( size_t j = 0; j < asChunks[i].apBuffers.size(); j++ )
+            CPLFree(asChunks[i].apBuffers[j]);
+        asChunks[i].apBuffers.clear();
+        CPLFree(asChunks[i].pabyNodataMask);
+        asChunks[i].pabyNodataMask = NULL;
+    }
+}
 
-        /* special case to promote 1bit data to 8bit 0/255 values */
-        if( EQUAL(pszResampling,"AVERAGE_BIT2GRAYSCALE") )
+/* (Re)allocate the buffers of the chunks. Must be called when no chunk is */
+/* queued. */
+
+bool GDALOverviewPipeline::Init( int nBands, GDALDataType eWrkDataType,
+                                 int nChunkXSize, int nChunkYSize,
+                                 bool bNodataMask )
+{
+    CPLAssert( nQueuedChunks == 0 );
+    FreeBuffers();
+    for( size_t i = 0; i < asChunks.size(); i++ )
+    {
+        for( int iBand = 0; iBand < nBands; iBand++ )
+        {
+            void* pBuffer = VSI_MALLOC3_VERBOSE(
+                GDALGetDataTypeSizeBytes(eWrkDataType),
+                nChunkYSize, nChunkXSize );
+            if( pBuffer == NULL )
+                return false;
+            asChunks[i].apBuffers.push_back(pBuffer);
+        }
+        if( bNodataMask )
         {
-            if (eType == GDT_Float32)
+            asChunks[i].pabyNodataMask = static_cast<GByte*>(
+                VSI_MALLOC2_VERBOSE(nChunkYSize, nChunkXSize) );
+            if( asChunks[i].pabyNodataMask == NULL )
+                return false;
+        }
+    }
+    return true;
+}
+
+void GDALOverviewPipeline::ResampleJobFunc( void* pData )
+{
+    GDALOverviewResampleJob* psJob =
+        static_cast<GDALOverviewResampleJob*>(pData);
+    psJob->eErr = psJob->Run( psJob->poJobBand );
+
+    GDALOverviewPipeline* poThis = psJob->psChunk->poPipeline;
+    CPLAcquireMutex(poThis->hMutex, 1000.0);
+    if( --psJob->psChunk->nPendingJobs == 0 )
+        CPLCondBroadcast(poThis->hCond);
+    CPLReleaseMutex(poThis->hMutex);
+}
+
+/* Wait for the resampling of the oldest queued chunk, and write it to the */
+/* overviews, unless an error occurred before. */
+
+void GDALOverviewPipeline::WriteOldestChunk()
+{
+    GDALOverviewChunk& sChunk = asChunks[iOldestChunk];
+
+    CPLAcquireMutex(hMutex, 1000.0);
+    while( sChunk.nPendingJobs > 0 )
+        CPLCondWait(hCond, hMutex);
+    CPLReleaseMutex(hMutex);
+
+    for( size_t i = 0; i < sChunk.asJobs.size() && eErr == CE_None; i++ )
+    {
+        eErr = sChunk.asJobs[i].eErr;
+        if( eErr == CE_None )
+            eErr = sChunk.asJobs[i].poJobBand->WriteToOverview();
+    }
+
+    iOldestChunk = (iOldestChunk + 1) % static_cast<int>(asChunks.size());
+    nQueuedChunks--;
+}
+
+/* Return a chunk whose buffers can be filled, and whose list of jobs is */
+/* empty, or NULL if an error occurred. */
+
+GDALOverviewChunk *GDALOverviewPipeline::GetFreeChunk()
+{
+    if( nQueuedChunks == static_cast<int>(asChunks.size()) )
+        WriteOldestChunk();
+    if( eErr != CE_None )
+        return NULL;
+
+    GDALOverviewChunk* psChunk = &asChunks[(iOldestChunk + nQueuedChunks) %
+                                           static_cast<int>(asChunks.size())];
+    psChunk->asJobs.resize(0);
+    return psChunk;
+}
+
+CPLErr GDALOverviewPipeline::Submit( GDALOverviewChunk* psChunk )
+{
+    if( poPool == NULL )
+    {
+        for( size_t i = 0; i < psChunk->asJobs.size() && eErr == CE_None; i++ )
+            eErr = psChunk->asJobs[i].Run( psChunk->asJobs[i].poOverview );
+        return eErr;
+    }
+
+    // Reuse the job bands of the previous jobs of this chunk, that are
+    // normally for the same overviews.
+    std::vector<void*> apJobs;
+    for( size_t i = 0; i < psChunk->asJobs.size(); i++ )
+    {
+        GDALOverviewResampleJob& sJob = psChunk->asJobs[i];
+        if( i == psChunk->apoJobBands.size() )
+            psChunk->apoJobBands.push_back(NULL);
+        if( psChunk->apoJobBands[i] == NULL ||
+            psChunk->apoJobBands[i]->GetTargetOverview() != sJob.poOverview )
+        {
+            delete psChunk->apoJobBands[i];
+            psChunk->apoJobBands[i] = new GDALOverviewJobBand(sJob.poOverview);
+        }
+        sJob.poJobBand = psChunk->apoJobBands[i];
+        sJob.poJobBand->SetWindow(
+            sJob.pfnResampleFn ? sJob.nDstXOff : 0, sJob.nDstYOff,
+            sJob.pfnResampleFn ? sJob.nDstXOff2 - sJob.nDstXOff
+                               : sJob.poOverview->GetXSize(),
+            sJob.nDstYOff2 - sJob.nDstYOff );
+        sJob.psChunk = psChunk;
+        sJob.eErr = CE_None;
+        apJobs.push_back(&sJob);
+    }
+
+    psChunk->nPendingJobs = static_cast<int>(apJobs.size());
+    nQueuedChunks++;
+    if( !apJobs.empty() )
+        poPool->SubmitJobs(ResampleJobFunc, apJobs);
+
+    return eErr;
+}
+
+/* Write the chunks that are still queued, and return the first error. */
+
+CPLErr GDALOverviewPipeline::Finish()
+{
+    while( nQueuedChunks > 0 )
+        WriteOldestChunk();
+    return eErr;
+}
+
+/************************************************************************/
+/*                          GDALOverviewStream                          */
+/************************************************************************/
+
+/* State of an overview level while the overviews are computed in a single */
+/* pass on the source bands (GDAL_OVR_SINGLE_PASS=YES). A level is computed */
+/* from the base bands or from the previous level, with the same chunks of  */
+/* its source as the cascading generation, but the rows of the source are   */
+/* received as soon as they are read or resampled, instead of being read    */
+/* back once the previous level is complete, and only the ones still needed */
+/* by the next chunk are kept. */
+
+struct GDALOverviewStreamLevel
+{
+    std::vector<GDALRasterBand*> apoOverviews;
+    const char     *pszResampling;
+    GDALDataType    eWrkDataType;
+    GDALDataType    eSrcDataType;
+    int             nSrcWidth;
+    int             nSrcHeight;
+    int             nMargin;
+    std::vector<int> abHasNoData;
+    std::vector<float> afNoDataValue;
+    std::vector<GDALColorTable*> apoColorTables;
+    bool            bUseNoDataMask;
+
+    // A chunk is either nChunkYSize rows of the source, as in
+    // GDALRegenerateOverviews(), or the rows of the source of nChunkYSize
+    // rows of the overview, as in GDALRegenerateOverviewsMultiBand().
+    bool            bDstChunks;
+    int             nChunkYSize;
+    // First row of the next chunk, in the source or in the overview
+    int             nNextChunk;
+    // Columns of the overview computed from the same window of the source
+    int             nChunkXSize;
+
+    // Rows of the source bands, in eWrkDataType, and their nodata mask,
+    // starting at row nRowsYOff.
+    std::vector< std::vector<GByte> > aabyRows;
+    std::vector<GByte> abyMask;
+    int             nRowsYOff;
+    int             nRows;
+    // Window of the rows given to the resampling function
+    std::vector<GByte> abyChunk;
+    std::vector<GByte> abyChunkMask;
+
+    // Receive the resampled rows of each band
+    std::vector<GDALOverviewJobBand*> apoJobBands;
+    // Nodata mask of the resampled rows, for the next level
+    GDALRasterBand *poJobMaskBand;
+    bool            bOwnJobMaskBand;
+
+    GDALOverviewStreamLevel() :
+        pszResampling(NULL),
+        eWrkDataType(GDT_Unknown),
+        eSrcDataType(GDT_Unknown),
+        nSrcWidth(0),
+        nSrcHeight(0),
+        nMargin(0),
+        bUseNoDataMask(false),
+        bDstChunks(false),
+        nChunkYSize(0),
+        nNextChunk(0),
+        nChunkXSize(0),
+        nRowsYOff(0),
+        nRows(0),
+        poJobMaskBand(NULL),
+        bOwnJobMaskBand(false) {}
+};
+
+/* Chunk size matching the blocks of a band, as in GDALRegenerateOverviews() */
+
+static int GDALGetOverviewChunkYSize( GDALRasterBand* poSrcBand )
+{
+    int nFRXBlockSize, nFRYBlockSize;
+    poSrcBand->GetBlockSize( &nFRXBlockSize, &nFRYBlockSize );
+    if( nFRYBlockSize < 16 || nFRYBlockSize > 256 )
+        return 64;
+    return nFRYBlockSize;
+}
+
+static int GDALGetOverviewMargin( int nKernelRadius,
+                                  int nSrcWidth, int nSrcHeight,
+                                  GDALRasterBand* poOverview )
+{
+    int nMaxOvrFactor = 1;
+    nMaxOvrFactor = MAX( nMaxOvrFactor,
+        (int)((double)nSrcWidth / poOverview->GetXSize() + 0.5) );
+    nMaxOvrFactor = MAX( nMaxOvrFactor,
+        (int)((double)nSrcHeight / poOverview->GetYSize() + 0.5) );
+    return nKernelRadius * nMaxOvrFactor;
+}
+
+static void GDALDestroyOverviewStream(
+                            std::vector<GDALOverviewStreamLevel>& asLevels )
+{
+    for( size_t i = 0; i < asLevels.size(); i++ )
+    {
+        if( asLevels[i].bOwnJobMaskBand )
+            delete asLevels[i].poJobMaskBand;
+        asLevels[i].poJobMaskBand = NULL;
+        for( size_t j = 0; j < asLevels[i].apoJobBands.size(); j++ )
+            delete asLevels[i].apoJobBands[j];
+        asLevels[i].apoJobBands.clear();
+    }
+}
+
+/* Make room for nYSize more rows of the source of a level, and return the */
+/* index of the first one. */
+
+static int GDALAddOverviewStreamRows( GDALOverviewStreamLevel& sLevel,
+                                      int nYSize )
+{
+    const int iFirstRow = sLevel.nRows;
+    sLevel.nRows += nYSize;
+    for( size_t iBand = 0; iBand < sLevel.aabyRows.size(); iBand++ )
+        sLevel.aabyRows[iBand].resize(
+            static_cast<size_t>(sLevel.nRows) * sLevel.nSrcWidth *
+            GDALGetDataTypeSizeBytes(sLevel.eWrkDataType) );
+    if( sLevel.bUseNoDataMask )
+        sLevel.abyMask.resize( static_cast<size_t>(sLevel.nRows) *
+                               sLevel.nSrcWidth );
+    return iFirstRow;
+}
+
+/* Resample the chunks of the source of level iLevel whose rows are all */
+/* available, write them, and pass the resampled rows down to the next  */
+/* level. */
+
+static CPLErr GDALResampleOverviewStream(
+                            std::vector<GDALOverviewStreamLevel>& asLevels,
+                            size_t iLevel,
+                            GDALResampleFunction pfnResampleFn )
+{
+    GDALOverviewStreamLevel& sLevel = asLevels[iLevel];
+    const int nBands = static_cast<int>(sLevel.apoOverviews.size());
+    const int nSrcWidth = sLevel.nSrcWidth;
+    const int nSrcHeight = sLevel.nSrcHeight;
+    const int nDstWidth = sLevel.apoOverviews[0]->GetXSize();
+    const int nDstHeight = sLevel.apoOverviews[0]->GetYSize();
+    const double dfXRatioDstToSrc = (double)nSrcWidth / nDstWidth;
+    const double dfYRatioDstToSrc = (double)nSrcHeight / nDstHeight;
+    const size_t nLineBytes = static_cast<size_t>(nSrcWidth) *
+                                GDALGetDataTypeSizeBytes(sLevel.eWrkDataType);
+
+    while( true )
+    {
+        int nChunkYOff, nChunkYOff2, nDstYOff, nDstYOff2;
+        if( sLevel.bDstChunks )
+        {
+            nDstYOff = sLevel.nNextChunk;
+            if( nDstYOff >= nDstHeight )
+                break;
+            nDstYOff2 = MIN(nDstYOff + sLevel.nChunkYSize, nDstHeight);
+            nChunkYOff = (int) (0.5 + nDstYOff * dfYRatioDstToSrc);
+            nChunkYOff2 = (int) (0.5 + nDstYOff2 * dfYRatioDstToSrc);
+            if( nChunkYOff2 > nSrcHeight || nDstYOff2 == nDstHeight )
+                nChunkYOff2 = nSrcHeight;
+        }
+        else
+        {
+            nChunkYOff = sLevel.nNextChunk;
+            if( nChunkYOff >= nSrcHeight )
+                break;
+            nChunkYOff2 = MIN(nChunkYOff + sLevel.nChunkYSize, nSrcHeight);
+            nDstYOff = (int) (0.5 + nChunkYOff/dfYRatioDstToSrc);
+            nDstYOff2 = (int) (0.5 + nChunkYOff2/dfYRatioDstToSrc);
+            if( nChunkYOff2 == nSrcHeight )
+                nDstYOff2 = nDstHeight;
+        }
+
+        int nChunkYOffQueried = nChunkYOff - sLevel.nMargin;
+        int nChunkYSizeQueried = nChunkYOff2 - nChunkYOff + 2 * sLevel.nMargin;
+        if( nChunkYOffQueried < 0 )
+        {
+            nChunkYSizeQueried += nChunkYOffQueried;
+            nChunkYOffQueried = 0;
+        }
+        if( nChunkYOffQueried + nChunkYSizeQueried > nSrcHeight )
+            nChunkYSizeQueried = nSrcHeight - nChunkYOffQueried;
+
+        if( sLevel.nRowsYOff + sLevel.nRows <
+                                    nChunkYOffQueried + nChunkYSizeQueried )
+            return CE_None;
+
+        // Discard the rows that are not needed any more
+        const int nDiscarded = nChunkYOffQueried - sLevel.nRowsYOff;
+        if( nDiscarded > 0 )
+        {
+            for( int iBand = 0; iBand < nBands; iBand++ )
+                sLevel.aabyRows[iBand].erase(
+                    sLevel.aabyRows[iBand].begin(),
+                    sLevel.aabyRows[iBand].begin() + nDiscarded * nLineBytes );
+            if( sLevel.bUseNoDataMask )
+                sLevel.abyMask.erase(
+                    sLevel.abyMask.begin(),
+                    sLevel.abyMask.begin() +
+                        nDiscarded * static_cast<size_t>(nSrcWidth) );
+            sLevel.nRowsYOff += nDiscarded;
+            sLevel.nRows -= nDiscarded;
+        }
+
+        for( int iBand = 0; iBand < nBands; iBand++ )
+            sLevel.apoJobBands[iBand]->SetWindow( 0, nDstYOff, nDstWidth,
+                                                  nDstYOff2 - nDstYOff );
+
+        CPLErr eErr = CE_None;
+        for( int nDstXOff = 0; nDstXOff < nDstWidth && eErr == CE_None;
+             nDstXOff += sLevel.nChunkXSize )
+        {
+            const int nDstXOff2 = MIN(nDstXOff + sLevel.nChunkXSize,
+                                      nDstWidth);
+            int nChunkXOff = (int) (0.5 + nDstXOff * dfXRatioDstToSrc);
+            int nChunkXOff2 = (int) (0.5 + nDstXOff2 * dfXRatioDstToSrc);
+            if( nChunkXOff2 > nSrcWidth || nDstXOff2 == nDstWidth )
+                nChunkXOff2 = nSrcWidth;
+
+            int nChunkXOffQueried = nChunkXOff - sLevel.nMargin;
+            int nChunkXSizeQueried =
+                nChunkXOff2 - nChunkXOff + 2 * sLevel.nMargin;
+            if( nChunkXOffQueried < 0 )
             {
-                float* pafChunk = (float*)pChunk;
-                for( int i = nChunkYSizeQueried*nWidth - 1; i >= 0; i-- )
-                {
-                    if( pafChunk[i] == 1.0 )
-                        pafChunk[i] = 255.0;
-                }
+                nChunkXSizeQueried += nChunkXOffQueried;
+                nChunkXOffQueried = 0;
             }
-            else if (eType == GDT_Byte)
+            if( nChunkXOffQueried + nChunkXSizeQueried > nSrcWidth )
+                nChunkXSizeQueried = nSrcWidth - nChunkXOffQueried;
+
+            // Copy the columns of the chunk if it is narrower than the rows
+            const bool bCopy = nChunkXSizeQueried != nSrcWidth;
+            const size_t nRowOffset =
+                static_cast<size_t>(nChunkYOffQueried - sLevel.nRowsYOff) *
+                                                                nSrcWidth;
+            GByte* pabyMask = NULL;
+            if( sLevel.bUseNoDataMask && bCopy )
             {
-                GByte* pabyChunk = (GByte*)pChunk;
-                for( int i = nChunkYSizeQueried*nWidth - 1; i >= 0; i-- )
-                {
-                    if( pabyChunk[i] == 1 )
-                        pabyChunk[i] = 255;
-                }
+                sLevel.abyChunkMask.resize(
+                    static_cast<size_t>(nChunkXSizeQueried) *
+                                                    nChunkYSizeQueried );
+                for( int iY = 0; iY < nChunkYSizeQueried; iY++ )
+                    memcpy( &sLevel.abyChunkMask[static_cast<size_t>(iY) *
+                                                    nChunkXSizeQueried],
+                            &sLevel.abyMask[nRowOffset +
+                                static_cast<size_t>(iY) * nSrcWidth +
+                                nChunkXOffQueried],
+                            nChunkXSizeQueried );
+                pabyMask = &sLevel.abyChunkMask[0];
             }
-            else if (eType == GDT_UInt16)
+            else if( sLevel.bUseNoDataMask )
+                pabyMask = &sLevel.abyMask[nRowOffset];
+
+            for( int iBand = 0; iBand < nBands && eErr == CE_None; iBand++ )
             {
-                GUInt16* pasChunk = (GUInt16*)pChunk;
-                for( int i = nChunkYSizeQueried*nWidth - 1; i >= 0; i-- )
+                const int nDTSize =
+                    GDALGetDataTypeSizeBytes(sLevel.eWrkDataType);
+                GByte* pabyChunk = NULL;
+                if( bCopy )
                 {
-                    if( pasChunk[i] == 1 )
-                        pasChunk[i] = 255;
+                    sLevel.abyChunk.resize(
+                        static_cast<size_t>(nChunkXSizeQueried) *
+                                            nChunkYSizeQueried * nDTSize );
+                    for( int iY = 0; iY < nChunkYSizeQueried; iY++ )
+                        memcpy( &sLevel.abyChunk[static_cast<size_t>(iY) *
+                                            nChunkXSizeQueried * nDTSize],
+                                &sLevel.aabyRows[iBand][(nRowOffset +
+                                    static_cast<size_t>(iY) * nSrcWidth +
+                                    nChunkXOffQueried) * nDTSize],
+                                static_cast<size_t>(nChunkXSizeQueried) *
+                                                                nDTSize );
+                    pabyChunk = &sLevel.abyChunk[0];
                 }
+                else
+                    pabyChunk = &sLevel.aabyRows[iBand][nRowOffset * nDTSize];
+
+                eErr = pfnResampleFn( dfXRatioDstToSrc, dfYRatioDstToSrc,
+                                      0.0, 0.0,
+                                      sLevel.eWrkDataType,
+                                      pabyChunk, pabyMask,
+                                      nChunkXOffQueried, nChunkXSizeQueried,
+                                      nChunkYOffQueried, nChunkYSizeQueried,
+                                      nDstXOff, nDstXOff2,
+                                      nDstYOff, nDstYOff2,
+                                      sLevel.apoJobBands[iBand],
+                                      sLevel.pszResampling,
+                                      sLevel.abHasNoData[iBand],
+                                      sLevel.afNoDataValue[iBand],
+                                      sLevel.apoColorTables[iBand],
+                                      sLevel.eSrcDataType );
+            }
+        }
+
+        for( int iBand = 0; iBand < nBands && eErr == CE_None; iBand++ )
+            eErr = sLevel.apoJobBands[iBand]->WriteToOverview();
+
+        if( eErr == CE_None && iLevel + 1 < asLevels.size() &&
+            nDstYOff2 > nDstYOff )
+        {
+            GDALOverviewStreamLevel& sNext = asLevels[iLevel + 1];
+            CPLAssert( sNext.nRowsYOff + sNext.nRows == nDstYOff );
+            const int nYSize = nDstYOff2 - nDstYOff;
+            const int iFirstRow = GDALAddOverviewStreamRows( sNext, nYSize );
+            const size_t nOffset = static_cast<size_t>(iFirstRow) * nDstWidth;
+            for( int iBand = 0; iBand < nBands && eErr == CE_None; iBand++ )
+            {
+                eErr = sLevel.apoJobBands[iBand]->RasterIO( GF_Read,
+                        0, nDstYOff, nDstWidth, nYSize,
+                        &sNext.aabyRows[iBand][nOffset *
+                            GDALGetDataTypeSizeBytes(sNext.eWrkDataType)],
+                        nDstWidth, nYSize, sNext.eWrkDataType,
+                        0, 0, NULL );
+            }
+            if( eErr == CE_None && sNext.bUseNoDataMask )
+            {
+                eErr = sLevel.poJobMaskBand->RasterIO( GF_Read,
+                        0, nDstYOff, nDstWidth, nYSize,
+                        &sNext.abyMask[nOffset],
+                        nDstWidth, nYSize, GDT_Byte,
+                        0, 0, NULL );
+                sLevel.poJobMaskBand->FlushCache();
             }
-            else {
-                CPLAssert(0);
+            if( eErr == CE_None )
+                eErr = GDALResampleOverviewStream( asLevels, iLevel + 1,
+                                                   pfnResampleFn );
+        }
+        if( eErr != CE_None )
+            return eErr;
+
+        sLevel.nNextChunk = sLevel.bDstChunks ? nDstYOff2 : nChunkYOff2;
+    }
+
+    return CE_None;
+}
+
+/* Set up the levels to compute the overviews of poSrcBand with a cascading */
+/* resampling method, as GDALRegenerateCascadingOverviews() does. Return    */
+/* false if the overviews cannot be computed in a single pass. */
+
+static bool GDALSetupOverviewStream(
+                            GDALRasterBand *poSrcBand,
+                            int nOverviews,
+                            GDALRasterBand **papoOvrBands,
+                            const char *pszResampling,
+                            int nKernelRadius,
+                            bool bUseNoDataMask,
+                            std::vector<GDALOverviewStreamLevel>& asLevels )
+{
+    // The magnitude of the overviews would have to be corrected once they
+    // are complete.
+    if( EQUAL(pszResampling, "AVERAGE_MP") )
+        return false;
+
+/* -------------------------------------------------------------------- */
+/*      Put the overviews in order from largest to smallest, as         */
+/*      GDALRegenerateCascadingOverviews().                             */
+/* -------------------------------------------------------------------- */
+    for( int i = 0; i < nOverviews-1; i++ )
+    {
+        for( int j = 0; j < nOverviews - i - 1; j++ )
+        {
+            if( papoOvrBands[j]->GetXSize()
+                * (float) papoOvrBands[j]->GetYSize() <
+                papoOvrBands[j+1]->GetXSize()
+                * (float) papoOvrBands[j+1]->GetYSize() )
+            {
+                GDALRasterBand *poTempBand = papoOvrBands[j];
+                papoOvrBands[j] = papoOvrBands[j+1];
+                papoOvrBands[j+1] = poTempBand;
             }
         }
-        else if( EQUAL(pszResampling,"AVERAGE_BIT2GRAYSCALE_MINISWHITE") )
+    }
+
+    asLevels.resize(nOverviews);
+    for( int i = 0; i < nOverviews; i++ )
+    {
+        GDALOverviewStreamLevel& sLevel = asLevels[i];
+        GDALRasterBand* poLevelSrcBand = (i == 0) ? poSrcBand
+                                                  : papoOvrBands[i-1];
+
+        sLevel.eSrcDataType = poLevelSrcBand->GetRasterDataType();
+        if( GDALDataTypeIsComplex(sLevel.eSrcDataType) )
+            break;
+
+        // The mask of the previous level must be computed from its values
+        if( i > 0 )
         {
-            if (eType == GDT_Float32)
+            GDALOverviewStreamLevel& sPrev = asLevels[i-1];
+            if( poLevelSrcBand->GetColorInterpretation() == GCI_AlphaBand )
             {
-                float* pafChunk = (float*)pChunk;
-                for( int i = nChunkYSizeQueried*nWidth - 1; i >= 0; i-- )
-                {
-                    if( pafChunk[i] == 1.0 )
-                        pafChunk[i] = 0.0;
-                    else if( pafChunk[i] == 0.0 )
-                        pafChunk[i] = 255.0;
-                }
+                sLevel.bUseNoDataMask = true;
+                sPrev.poJobMaskBand = sPrev.apoJobBands[0];
             }
-            else if (eType == GDT_Byte)
+            else
             {
-                GByte* pabyChunk = (GByte*)pChunk;
-                for( int i = nChunkYSizeQueried*nWidth - 1; i >= 0; i-- )
+                const int nMaskFlags = poLevelSrcBand->GetMaskFlags();
+                sLevel.bUseNoDataMask = ((nMaskFlags & GMF_ALL_VALID) == 0);
+                if( sLevel.bUseNoDataMask && nMaskFlags != GMF_NODATA )
+                    break;
+                if( sLevel.bUseNoDataMask )
                 {
-                    if( pabyChunk[i] == 1 )
-                        pabyChunk[i] = 0;
-                    else if( pabyChunk[i] == 0 )
-                        pabyChunk[i] = 255;
+                    sPrev.poJobMaskBand =
+                        new GDALNoDataMaskBand( sPrev.apoJobBands[0] );
+                    sPrev.bOwnJobMaskBand = true;
                 }
             }
-            else if (eType == GDT_UInt16)
+        }
+        else
+            sLevel.bUseNoDataMask = bUseNoDataMask;
+
+        sLevel.apoOverviews.push_back( papoOvrBands[i] );
+        // we only do the bit2grayscale promotion on the base band
+        sLevel.pszResampling =
+            (i > 0 && STARTS_WITH_CI(pszResampling, "AVERAGE_BIT2G")) ?
+                "AVERAGE" : pszResampling;
+        sLevel.eWrkDataType = GDALGetOvrWorkDataType(sLevel.pszResampling,
+                                                     sLevel.eSrcDataType);
+        sLevel.nSrcWidth = poLevelSrcBand->GetXSize();
+        sLevel.nSrcHeight = poLevelSrcBand->GetYSize();
+        sLevel.nMargin = GDALGetOverviewMargin( nKernelRadius,
+                                                sLevel.nSrcWidth,
+                                                sLevel.nSrcHeight,
+                                                papoOvrBands[i] );
+        int bHasNoData;
+        sLevel.afNoDataValue.push_back(
+            (float) poLevelSrcBand->GetNoDataValue(&bHasNoData) );
+        sLevel.abHasNoData.push_back( bHasNoData );
+        sLevel.apoColorTables.push_back(
+            GDALGetOverviewColorTable( poLevelSrcBand,
+                                       sLevel.pszResampling ) );
+        sLevel.bDstChunks = false;
+        sLevel.nChunkYSize = GDALGetOverviewChunkYSize( poLevelSrcBand );
+        sLevel.nChunkXSize = papoOvrBands[i]->GetXSize();
+        sLevel.aabyRows.resize( 1 );
+        sLevel.apoJobBands.push_back(
+                            new GDALOverviewJobBand( papoOvrBands[i] ) );
+    }
+
+    if( asLevels.back().apoJobBands.empty() )
+    {
+        GDALDestroyOverviewStream( asLevels );
+        return false;
+    }
+    return true;
+}
+
+/* Set up the levels to compute the overviews of papoSrcBands as         */
+/* GDALRegenerateOverviewsMultiBand() does, each one from the previous   */
+/* one. Return false if the overviews cannot be computed in a single pass. */
+
+static bool GDALSetupOverviewStreamMultiBand(
+                            int nBands,
+                            GDALRasterBand **papoSrcBands,
+                            int nOverviews,
+                            GDALRasterBand ***papapoOverviewBands,
+                            const char *pszResampling,
+                            int nKernelRadius,
+                            std::vector<GDALOverviewStreamLevel>& asLevels )
+{
+    const GDALDataType eDataType = papoSrcBands[0]->GetRasterDataType();
+    const bool bUseNoDataMask =
+        (!STARTS_WITH_CI(pszResampling, "NEAR") &&
+         (papoSrcBands[0]->GetMaskFlags() & GMF_ALL_VALID) == 0);
+
+    asLevels.resize(nOverviews);
+    for( int i = 0; i < nOverviews; i++ )
+    {
+        GDALOverviewStreamLevel& sLevel = asLevels[i];
+        GDALRasterBand* poOverview = papapoOverviewBands[0][i];
+        GDALRasterBand* poLevelSrcBand = papoSrcBands[0];
+
+        if( i > 0 )
+        {
+            // Levels that are not smaller than the previous one are
+            // computed from the source bands.
+            GDALOverviewStreamLevel& sPrev = asLevels[i-1];
+            poLevelSrcBand = papapoOverviewBands[0][i-1];
+            if( poLevelSrcBand->GetXSize() <= poOverview->GetXSize() )
+                break;
+
+            // The mask of the previous level must be computed from its
+            // values
+            if( bUseNoDataMask )
             {
-                GUInt16* pasChunk = (GUInt16*)pChunk;
-                for( int i = nChunkYSizeQueried*nWidth - 1; i >= 0; i-- )
+                const int nMaskFlags = poLevelSrcBand->GetMaskFlags();
+                if( (nMaskFlags & GMF_ALL_VALID) != 0 )
                 {
-                    if( pasChunk[i] == 1 )
-                        pasChunk[i] = 0;
-                    else if( pasChunk[i] == 0 )
-                        pasChunk[i] = 255;
+                    sPrev.poJobMaskBand =
+                        new GDALAllValidMaskBand( sPrev.apoJobBands[0] );
+                    sPrev.bOwnJobMaskBand = true;
+                }
+                else if( nMaskFlags == GMF_NODATA )
+                {
+                    sPrev.poJobMaskBand =
+                        new GDALNoDataMaskBand( sPrev.apoJobBands[0] );
+                    sPrev.bOwnJobMaskBand = true;
+                }
+                else
+                {
+                    GDALRasterBand* poMaskBand =
+                        poLevelSrcBand->GetMaskBand();
+                    for( int iBand = 0; iBand < nBands; iBand++ )
+                    {
+                        if( papapoOverviewBands[iBand][i-1] == poMaskBand )
+                            sPrev.poJobMaskBand = sPrev.apoJobBands[iBand];
+                    }
+                    if( sPrev.poJobMaskBand == NULL )
+                        break;
                 }
             }
-            else {
-                CPLAssert(0);
-            }
         }
 
+        for( int iBand = 0; iBand < nBands; iBand++ )
+        {
+            sLevel.apoOverviews.push_back( papapoOverviewBands[iBand][i] );
+            int bHasNoData;
+            sLevel.afNoDataValue.push_back(
+                (float) papoSrcBands[iBand]->GetNoDataValue(&bHasNoData) );
+            sLevel.abHasNoData.push_back( bHasNoData );
+            sLevel.apoColorTables.push_back( NULL );
+        }
+        sLevel.pszResampling = pszResampling;
+        sLevel.eSrcDataType = eDataType;
+        sLevel.eWrkDataType = GDALGetOvrWorkDataType(pszResampling, eDataType);
+        sLevel.nSrcWidth = poLevelSrcBand->GetXSize();
+        sLevel.nSrcHeight = poLevelSrcBand->GetYSize();
+        sLevel.nMargin = GDALGetOverviewMargin( nKernelRadius,
+                                                sLevel.nSrcWidth,
+                                                sLevel.nSrcHeight,
+                                                poOverview );
+        sLevel.bUseNoDataMask = bUseNoDataMask;
+        int nDstBlockXSize, nDstBlockYSize;
+        poOverview->GetBlockSize( &nDstBlockXSize, &nDstBlockYSize );
+        sLevel.bDstChunks = true;
+        sLevel.nChunkYSize = nDstBlockYSize;
+        sLevel.nChunkXSize = nDstBlockXSize;
+        sLevel.aabyRows.resize( nBands );
+        for( int iBand = 0; iBand < nBands; iBand++ )
+            sLevel.apoJobBands.push_back(
+                new GDALOverviewJobBand( papapoOverviewBands[iBand][i] ) );
+    }
+
+    if( asLevels.back().apoJobBands.empty() )
+    {
+        GDALDestroyOverviewStream( asLevels );
+        return false;
+    }
+    return true;
+}
+
+/* Read the source bands once, by chunks, and push the rows down the levels */
+/* as soon as they are read. */
+
+static CPLErr GDALRunOverviewStream(
+                            std::vector<GDALOverviewStreamLevel>& asLevels,
+                            GDALRasterBand **papoSrcBands,
+                            GDALRasterBand *poMaskBand,
+                            const char *pszResampling,
+                            GDALResampleFunction pfnResampleFn,
+                            GDALProgressFunc pfnProgress,
+                            void *pProgressData )
+{
+    GDALOverviewStreamLevel& sFirst = asLevels[0];
+    const int nBands = static_cast<int>(sFirst.apoOverviews.size());
+    const int nWidth = sFirst.nSrcWidth;
+    const int nHeight = sFirst.nSrcHeight;
+    const int nDTSize = GDALGetDataTypeSizeBytes(sFirst.eWrkDataType);
+    const int nFullResYChunk = GDALGetOverviewChunkYSize( papoSrcBands[0] );
+    CPLErr eErr = CE_None;
+
+    for( int nYOff = 0; nYOff < nHeight && eErr == CE_None;
+         nYOff += nFullResYChunk )
+    {
+        if( !pfnProgress( nYOff / (double) nHeight, NULL, pProgressData ) )
+        {
+            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+            eErr = CE_Failure;
+            break;
+        }
+
+        const int nYSize = MIN(nFullResYChunk, nHeight - nYOff);
+        const int iFirstRow = GDALAddOverviewStreamRows( sFirst, nYSize );
+        const size_t nOffset = static_cast<size_t>(iFirstRow) * nWidth;
+        for( int iBand = 0; iBand < nBands && eErr == CE_None; iBand++ )
+        {
+            void* pRows = &sFirst.aabyRows[iBand][nOffset * nDTSize];
+            eErr = papoSrcBands[iBand]->RasterIO( GF_Read,
+                                                  0, nYOff, nWidth, nYSize,
+                                                  pRows, nWidth, nYSize,
+                                                  sFirst.eWrkDataType,
+                                                  0, 0, NULL );
+            if( eErr == CE_None )
+                GDALPromoteBit2Grayscale( pszResampling, sFirst.eWrkDataType,
+                                          pRows, nYSize * nWidth );
+        }
+        if( eErr == CE_None && sFirst.bUseNoDataMask )
+            eErr = poMaskBand->RasterIO( GF_Read, 0, nYOff, nWidth, nYSize,
+                                         &sFirst.abyMask[nOffset],
+                                         nWidth, nYSize, GDT_Byte,
+                                         0, 0, NULL );
+        if( eErr == CE_None )
+            eErr = GDALResampleOverviewStream( asLevels, 0, pfnResampleFn );
+    }
+
+    GDALDestroyOverviewStream( asLevels );
+
+/* -------------------------------------------------------------------- */
+/*      It can be important to flush out data to overviews.             */
+/* -------------------------------------------------------------------- */
+    for( size_t i = 0; eErr == CE_None && i < asLevels.size(); i++ )
+    {
+        for( int iBand = 0; eErr == CE_None && iBand < nBands; iBand++ )
+            eErr = asLevels[i].apoOverviews[iBand]->FlushCache();
+    }
+
+    if (eErr == CE_None)
+        pfnProgress( 1.0, NULL, pProgressData );
+
+    return eErr;
+}
+
+/************************************************************************/
+/*                      GDALRegenerateOverviews()                       */
+/************************************************************************/
+
+/**
+ * \brief Generate downsampled overviews.
+ *
+ * This function will generate one or more overview images from a base
+ * image using the requested downsampling algorithm.  It's primary use
+ * is for generating overviews via GDALDataset::BuildOverviews(), but it
+ * can also be used to generate downsampled images in one file from another
+ * outside the overview architecture.
+ *
+ * The output bands need to exist in advance.
+ *
+ * The full set of resampling algorithms is documented in
+ * GDALDataset::BuildOverviews().
+ *
+ * This function will honour properly NODATA_VALUES tuples (special dataset metadata) so
+ * that only a given RGB triplet (in case of a RGB image) will be considered as the
+ * nodata value and not each value of the triplet independently per band.
+ *
+ * Starting with GDAL 2.2, the GDAL_NUM_THREADS configuration option can be set
+ * to a number of threads, or ALL_CPUS, to resample the chunks of the source
+ * band in a pool of worker threads, while the next chunks are read. The
+ * result is identical to the one computed in a single thread.
+ *
+ * Starting with GDAL 2.2, when several overviews are computed with a
+ * cascading method (AVERAGE, GAUSS, CUBIC, ...), the GDAL_OVR_SINGLE_PASS
+ * configuration option can be set to YES to compute all of them while the
+ * source band is read, each level from the rows of the previous one as
+ * soon as they are resampled, instead of reading back each level once it
+ * is complete. Only a few rows of each level are then kept in memory. The
+ * result is the same as with the default cascading generation, unless the
+ * overviews do not store the values exactly (lossy compression, NBITS),
+ * since the next level is then computed from the values before they are
+ * stored. With the nearest method, all the overviews are already computed
+ * from a single read of the source band.
+ *
+ * @param hSrcBand the source (base level) band.
+ * @param nOverviewCount the number of downsampled bands being generated.
+ * @param pahOvrBands the list of downsampled bands to be generated.
+ * @param pszResampling Resampling algorithm (e.g. "AVERAGE").
+ * @param pfnProgress progress report function.
+ * @param pProgressData progress function callback data.
+ * @return CE_None on success or CE_Failure on failure.
+ */
+CPLErr
+GDALRegenerateOverviews( GDALRasterBandH hSrcBand,
+                         int nOverviewCount, GDALRasterBandH *pahOvrBands,
+                         const char * pszResampling,
+                         GDALProgressFunc pfnProgress, void * pProgressData )
+
+{
+    GDALRasterBand *poSrcBand = (GDALRasterBand *) hSrcBand;
+    GDALRasterBand **papoOvrBands = (GDALRasterBand **) pahOvrBands;
+
+    if( pfnProgress == NULL )
+        pfnProgress = GDALDummyProgress;
+
+    if( EQUAL(pszResampling,"NONE") )
+        return CE_None;
+
+    int nKernelRadius;
+    GDALResampleFunction pfnResampleFn
+        = GDALGetResampleFunction(pszResampling, &nKernelRadius);
+
+    if (pfnResampleFn == NULL)
+        return CE_Failure;
+
+/* -------------------------------------------------------------------- */
+/*      Check color tables...                                           */
+/* -------------------------------------------------------------------- */
+    GDALColorTable* poColorTable =
+        GDALGetOverviewColorTable( poSrcBand, pszResampling );
+
+
+    /* If we have a nodata mask and we are doing something more complicated */
+    /* than nearest neighbouring, we have to fetch to nodata mask */
+
+    GDALRasterBand* poMaskBand = NULL;
+    int nMaskFlags = 0;
+    bool bUseNoDataMask = false;
+
+    if( !STARTS_WITH_CI(pszResampling, "NEAR") )
+    {
+        /* Special case if we are the alpha band. We want it to be considered */
+        /* as the mask band to avoid alpha=0 to be taken into account in average */
+        /* computation */
+        if( poSrcBand->GetColorInterpretation() == GCI_AlphaBand )
+        {
+            poMaskBand = poSrcBand;
+            nMaskFlags = GMF_ALPHA | GMF_PER_DATASET;
+        }
+        else
+        {
+            poMaskBand = poSrcBand->GetMaskBand();
+            nMaskFlags = poSrcBand->GetMaskFlags();
+        }
+
+        bUseNoDataMask = ((nMaskFlags & GMF_ALL_VALID) == 0);
+    }
+
+/* -------------------------------------------------------------------- */
+/*      If we are operating on multiple overviews, and using            */
+/*      averaging, lets do them in cascading order to reduce the        */
+/*      amount of computation.                                          */
+/* -------------------------------------------------------------------- */
+
+    /* In case the mask made be computed from another band of the dataset, */
+    /* we can't use cascaded generation, as the computation of the overviews */
+    /* of the band used for the mask band may not have yet occurred (#3033) */
+    if( (STARTS_WITH_CI(pszResampling, "AVER") |
+         STARTS_WITH_CI(pszResampling, "GAUSS") ||
+         EQUAL(pszResampling,"CUBIC") ||
+         EQUAL(pszResampling,"CUBICSPLINE") ||
+         EQUAL(pszResampling,"LANCZOS") ||
+         EQUAL(pszResampling,"BILINEAR")) && nOverviewCount > 1
+         && !(bUseNoDataMask && nMaskFlags != GMF_NODATA))
+    {
+        if( CPLTestBool(CPLGetConfigOption("GDAL_OVR_SINGLE_PASS", "NO")) )
+        {
+            std::vector<GDALOverviewStreamLevel> asLevels;
+            if( GDALSetupOverviewStream( poSrcBand,
+                                         nOverviewCount, papoOvrBands,
+                                         pszResampling, nKernelRadius,
+                                         bUseNoDataMask, asLevels ) )
+                return GDALRunOverviewStream( asLevels, &poSrcBand,
+                                              poMaskBand, pszResampling,
+                                              pfnResampleFn,
+                                              pfnProgress, pProgressData );
+            CPLDebug( "GDAL", "Cannot compute the overviews in a single "
+                      "pass. Using cascading generation." );
+        }
+        return GDALRegenerateCascadingOverviews( poSrcBand,
+                                                 nOverviewCount, papoOvrBands,
+                                                 pszResampling,
+                                                 pfnProgress,
+                                                 pProgressData );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Setup one horizontal swath to read from the raw buffer.         */
+/* -------------------------------------------------------------------- */
+    int nFRXBlockSize, nFRYBlockSize;
+    poSrcBand->GetBlockSize( &nFRXBlockSize, &nFRYBlockSize );
+
+    int nFullResYChunk;
+    if( nFRYBlockSize < 16 || nFRYBlockSize > 256 )
+        nFullResYChunk = 64;
+    else
+        nFullResYChunk = nFRYBlockSize;
+
+    GDALDataType eType;
+    if( GDALDataTypeIsComplex( poSrcBand->GetRasterDataType() ) )
+        eType = GDT_CFloat32;
+    else
+        eType = GDALGetOvrWorkDataType(pszResampling, poSrcBand->GetRasterDataType());
+
+    const int nWidth = poSrcBand->GetXSize();
+    const int nHeight = poSrcBand->GetYSize();
+
+    int nMaxOvrFactor = 1;
+    for( int iOverview = 0; iOverview < nOverviewCount; iOverview ++ )
+    {
+        const int nDstWidth = papoOvrBands[iOverview]->GetXSize();
+        const int nDstHeight = papoOvrBands[iOverview]->GetYSize();
+        nMaxOvrFactor = MAX( nMaxOvrFactor, (int)((double)nWidth / nDstWidth + 0.5) );
+        nMaxOvrFactor = MAX( nMaxOvrFactor, (int)((double)nHeight / nDstHeight + 0.5) );
+    }
+    const int nMaxChunkYSizeQueried = nFullResYChunk + 2 * nKernelRadius * nMaxOvrFactor;
+
+    GDALOverviewPipeline oPipeline;
+    if( !oPipeline.Init( 1, eType, nWidth, nMaxChunkYSizeQueried,
+                         bUseNoDataMask ) )
+        return CE_Failure;
+
+    int bHasNoData;
+    const float fNoDataValue = (float) poSrcBand->GetNoDataValue(&bHasNoData);
+
+/* -------------------------------------------------------------------- */
+/*      Loop over image operating on chunks.                            */
+/* -------------------------------------------------------------------- */
+    int  nChunkYOff = 0;
+    CPLErr eErr = CE_None;
+
+    for( nChunkYOff = 0;
+         nChunkYOff < nHeight && eErr == CE_None;
+         nChunkYOff += nFullResYChunk )
+    {
+        if( !pfnProgress( nChunkYOff / (double) nHeight,
+                          NULL, pProgressData ) )
+        {
+            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+            eErr = CE_Failure;
+        }
+
+        if( nFullResYChunk + nChunkYOff > nHeight )
+            nFullResYChunk = nHeight - nChunkYOff;
+
+        int nChunkYOffQueried = nChunkYOff - nKernelRadius * nMaxOvrFactor;
+        int nChunkYSizeQueried = nFullResYChunk + 2 * nKernelRadius * nMaxOvrFactor;
+        if( nChunkYOffQueried < 0 )
+        {
+            nChunkYSizeQueried += nChunkYOffQueried;
+            nChunkYOffQueried = 0;
+        }
+        if( nChunkYOffQueried + nChunkYSizeQueried > nHeight )
+            nChunkYSizeQueried = nHeight - nChunkYOffQueried;
+
+        GDALOverviewChunk* psChunk = NULL;
+        if( eErr == CE_None )
+        {
+            psChunk = oPipeline.GetFreeChunk();
+            if( psChunk == NULL )
+                eErr = CE_Failure;
+        }
+        if( eErr != CE_None )
+            break;
+        void* pChunk = psChunk->apBuffers[0];
+        GByte* pabyChunkNodataMask = psChunk->pabyNodataMask;
+
+        /* read chunk */
+        if (eErr == CE_None)
+            eErr = poSrcBand->RasterIO( GF_Read, 0, nChunkYOffQueried, nWidth, nChunkYSizeQueried,
+                                pChunk, nWidth, nChunkYSizeQueried, eType,
+                                0, 0, NULL );
+        if (eErr == CE_None && bUseNoDataMask)
+            eErr = poMaskBand->RasterIO( GF_Read, 0, nChunkYOffQueried, nWidth, nChunkYSizeQueried,
+                                pabyChunkNodataMask, nWidth, nChunkYSizeQueried, GDT_Byte,
+                                0, 0, NULL );
+
+        /* special case to promote 1bit data to 8bit 0/255 values */
+        if( eErr == CE_None )
+            GDALPromoteBit2Grayscale( pszResampling, eType, pChunk,
+                                      nChunkYSizeQueried * nWidth );
+
         for( int iOverview = 0; iOverview < nOverviewCount && eErr == CE_None; iOverview++ )
         {
             const int nDstWidth = papoOvrBands[iOverview]->GetXSize();
@@ -2588,30 +3888,41 @@ GDALRegenerateOverviews( GDALRasterBandH hSrcBand,
                 nDstYOff2 = nDstHeight;
             //CPLDebug("GDAL", "nDstYOff=%d, nDstYOff2=%d", nDstYOff, nDstYOff2);
 
+            GDALOverviewResampleJob sJob;
             if( eType == GDT_Byte || eType == GDT_UInt16 || eType == GDT_Float32 )
-                eErr = pfnResampleFn(dfXRatioDstToSrc, dfYRatioDstToSrc,
-                                       0.0, 0.0,
-                                              eType,
-                                              pChunk,
-                                              pabyChunkNodataMask,
-                                              0, nWidth,
-                                              nChunkYOffQueried, nChunkYSizeQueried,
-                                              0, nDstWidth,
-                                              nDstYOff, nDstYOff2,
-                                              papoOvrBands[iOverview], pszResampling,
-                                              bHasNoData, fNoDataValue, poColorTable,
-                                              poSrcBand->GetRasterDataType());
-            else
-                eErr = GDALResampleChunkC32R(nWidth, nHeight,
-                                               (float*)pChunk,
-                                               nChunkYOffQueried, nChunkYSizeQueried,
-                                               nDstYOff, nDstYOff2,
-                                               papoOvrBands[iOverview], pszResampling);
+                sJob.pfnResampleFn = pfnResampleFn;
+            sJob.dfXRatioDstToSrc = dfXRatioDstToSrc;
+            sJob.dfYRatioDstToSrc = dfYRatioDstToSrc;
+            sJob.eWrkDataType = eType;
+            sJob.pChunk = pChunk;
+            sJob.pabyChunkNodataMask = pabyChunkNodataMask;
+            sJob.nSrcWidth = nWidth;
+            sJob.nSrcHeight = nHeight;
+            sJob.nChunkXOff = 0;
+            sJob.nChunkXSize = nWidth;
+            sJob.nChunkYOff = nChunkYOffQueried;
+            sJob.nChunkYSize = nChunkYSizeQueried;
+            sJob.nDstXOff = 0;
+            sJob.nDstXOff2 = nDstWidth;
+            sJob.nDstYOff = nDstYOff;
+            sJob.nDstYOff2 = nDstYOff2;
+            sJob.poOverview = papoOvrBands[iOverview];
+            sJob.pszResampling = pszResampling;
+            sJob.bHasNoData = bHasNoData;
+            sJob.fNoDataValue = fNoDataValue;
+            sJob.poColorTable = poColorTable;
+            sJob.eSrcDataType = poSrcBand->GetRasterDataType();
+            psChunk->asJobs.push_back(sJob);
         }
+
+        /* resample the chunk for all the overviews */
+        if( eErr == CE_None )
+            eErr = oPipeline.Submit( psChunk );
     }
 
-    VSIFree( pChunk );
-    VSIFree( pabyChunkNodataMask );
+    const CPLErr eFinishErr = oPipeline.Finish();
+    if( eErr == CE_None )
+        eErr = eFinishErr;
 
 /* -------------------------------------------------------------------- */
 /*      Renormalized overview mean / stddev if needed.                  */
@@ -2673,6 +3984,14 @@ GDALRegenerateOverviews( GDALRasterBandH hSrcBand,
  * that only a given RGB triplet (in case of a RGB image) will be considered as the
  * nodata value and not each value of the triplet independently per band.
  *
+ * Starting with GDAL 2.2, the GDAL_NUM_THREADS configuration option can be set
+ * to resample the blocks of the overviews in a pool of worker threads, like
+ * with GDALRegenerateOverviews().
+ *
+ * Starting with GDAL 2.2, the GDAL_OVR_SINGLE_PASS configuration option can
+ * be set to YES to compute all the overview levels while the source bands
+ * are read, like with GDALRegenerateOverviews().
+ *
  * @param nBands the number of bands, size of papoSrcBands and size of
  *               first dimension of papapoOverviewBands
  * @param papoSrcBands the list of source bands to downsample
@@ -2760,6 +4079,22 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
         }
     }
 
+    if( nOverviews > 1 &&
+        CPLTestBool(CPLGetConfigOption("GDAL_OVR_SINGLE_PASS", "NO")) )
+    {
+        std::vector<GDALOverviewStreamLevel> asLevels;
+        if( GDALSetupOverviewStreamMultiBand( nBands, papoSrcBands,
+                                              nOverviews, papapoOverviewBands,
+                                              pszResampling, nKernelRadius,
+                                              asLevels ) )
+            return GDALRunOverviewStream( asLevels, papoSrcBands,
+                                          papoSrcBands[0]->GetMaskBand(),
+                                          pszResampling, pfnResampleFn,
+                                          pfnProgress, pProgressData );
+        CPLDebug( "GDAL", "Cannot compute the overviews in a single "
+                  "pass. Using cascading generation." );
+    }
+
     /* First pass to compute the total number of pixels to read */
     double dfTotalPixelCount = 0;
     for(int iOverview=0;iOverview<nOverviews;iOverview++)
@@ -2805,6 +4140,7 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
     }
 
     /* Second pass to do the real job ! */
+    GDALOverviewPipeline oPipeline;
     double dfCurPixelCount = 0;
     CPLErr eErr = CE_None;
     for(int iOverview=0;iOverview<nOverviews && eErr == CE_None;iOverview++)
@@ -2840,45 +4176,14 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
         int nFullResXChunkQueried = nFullResXChunk + 2 * nKernelRadius * nOvrFactor;
         int nFullResYChunkQueried = nFullResYChunk + 2 * nKernelRadius * nOvrFactor;
 
-        void** papaChunk = (void**) VSI_MALLOC_VERBOSE(nBands * sizeof(void*));
-        if( papaChunk == NULL )
+        if( !oPipeline.Init( nBands, eWrkDataType,
+                             nFullResXChunkQueried, nFullResYChunkQueried,
+                             bUseNoDataMask ) )
         {
             CPLFree(pabHasNoData);
             CPLFree(pafNoDataValue);
             return CE_Failure;
         }
-        GByte* pabyChunkNoDataMask = NULL;
-        for(int iBand=0;iBand<nBands;iBand++)
-        {
-            papaChunk[iBand] = VSI_MALLOC3_VERBOSE(
-                nFullResXChunkQueried,
-                nFullResYChunkQueried,
-                GDALGetDataTypeSizeBytes(eWrkDataType) );
-            if( papaChunk[iBand] == NULL )
-            {
-                while ( --iBand >= 0)
-                    CPLFree(papaChunk[iBand]);
-                CPLFree(papaChunk);
-                CPLFree(pabHasNoData);
-                CPLFree(pafNoDataValue);
-                return CE_Failure;
-            }
-        }
-        if (bUseNoDataMask)
-        {
-            pabyChunkNoDataMask = (GByte*) VSI_MALLOC2_VERBOSE(nFullResXChunkQueried, nFullResYChunkQueried);
-            if( pabyChunkNoDataMask == NULL )
-            {
-                for(int iBand=0;iBand<nBands;iBand++)
-                {
-                    CPLFree(papaChunk[iBand]);
-                }
-                CPLFree(papaChunk);
-                CPLFree(pabHasNoData);
-                CPLFree(pafNoDataValue);
-                return CE_Failure;
-            }
-        }
 
         int nDstYOff;
         /* Iterate on destination overview, block by block */
@@ -2946,6 +4251,15 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
                          nChunkXOff, nChunkYOff, nXCount, nYCount,
                          nDstXOff, nDstYOff, nDstXCount, nDstYCount);*/
 
+                GDALOverviewChunk* psChunk = oPipeline.GetFreeChunk();
+                if( psChunk == NULL )
+                {
+                    eErr = CE_Failure;
+                    break;
+                }
+                void** papaChunk = &psChunk->apBuffers[0];
+                GByte* pabyChunkNoDataMask = psChunk->pabyNodataMask;
+
                 /* Read the source buffers for all the bands */
                 for(int iBand=0;iBand<nBands && eErr == CE_None;iBand++)
                 {
@@ -2980,35 +4294,45 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
                 /* Compute the resulting overview block */
                 for(int iBand=0;iBand<nBands && eErr == CE_None;iBand++)
                 {
-                    eErr = pfnResampleFn(   dfXRatioDstToSrc, dfYRatioDstToSrc,
-                                            0.0, 0.0,
-                                            eWrkDataType,
-                                            papaChunk[iBand],
-                                            pabyChunkNoDataMask,
-                                            nChunkXOffQueried, nChunkXSizeQueried,
-                                            nChunkYOffQueried, nChunkYSizeQueried,
-                                            nDstXOff, nDstXOff + nDstXCount,
-                                            nDstYOff, nDstYOff + nDstYCount,
-                                            papapoOverviewBands[iBand][iOverview],
-                                            pszResampling,
-                                            pabHasNoData[iBand],
-                                            pafNoDataValue[iBand],
-                                            /*poColorTable*/ NULL,
-                                            eDataType);
+                    GDALOverviewResampleJob sJob;
+                    sJob.pfnResampleFn = pfnResampleFn;
+                    sJob.dfXRatioDstToSrc = dfXRatioDstToSrc;
+                    sJob.dfYRatioDstToSrc = dfYRatioDstToSrc;
+                    sJob.eWrkDataType = eWrkDataType;
+                    sJob.pChunk = papaChunk[iBand];
+                    sJob.pabyChunkNodataMask = pabyChunkNoDataMask;
+                    sJob.nChunkXOff = nChunkXOffQueried;
+                    sJob.nChunkXSize = nChunkXSizeQueried;
+                    sJob.nChunkYOff = nChunkYOffQueried;
+                    sJob.nChunkYSize = nChunkYSizeQueried;
+                    sJob.nDstXOff = nDstXOff;
+                    sJob.nDstXOff2 = nDstXOff + nDstXCount;
+                    sJob.nDstYOff = nDstYOff;
+                    sJob.nDstYOff2 = nDstYOff + nDstYCount;
+                    sJob.poOverview = papapoOverviewBands[iBand][iOverview];
+                    sJob.pszResampling = pszResampling;
+                    sJob.bHasNoData = pabHasNoData[iBand];
+                    sJob.fNoDataValue = pafNoDataValue[iBand];
+                    sJob.eSrcDataType = eDataType;
+                    psChunk->asJobs.push_back(sJob);
                 }
+                if( eErr == CE_None )
+                    eErr = oPipeline.Submit( psChunk );
             }
 
             dfCurPixelCount += (double)nYCount * nSrcWidth;
         }
 
+        /* Write the blocks that are still being computed */
+        const CPLErr eFinishErr = oPipeline.Finish();
+        if( eErr == CE_None )
+            eErr = eFinishErr;
+
         /* Flush the data to overviews */
         for(int iBand=0;iBand<nBands;iBand++)
         {
-            CPLFree(papaChunk[iBand]);
             papapoOverviewBands[iBand][iOverview]->FlushCache();
         }
-        CPLFree(papaChunk);
-        CPLFree(pabyChunkNoDataMask);
 
     }
 
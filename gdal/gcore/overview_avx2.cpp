@@ -0,0 +1,904 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  AVX2 kernels of the convolution and average overview resamplers
+ *
+ ******************************************************************************
+ * Copyright (c) 2016, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_port.h"
+#include "overview_avx2.hpp"
+
+#ifdef HAVE_AVX2_AT_COMPILE_TIME
+#include <immintrin.h>
+
+#include <cstring>
+
+CPL_CVSID("$Id$");
+
+/* This file must be compiled with -mavx2 (or /arch:AVX2), but not with */
+/* -mfma: fused multiply-adds would round differently from the SSE2 and  */
+/* scalar code of overview.cpp. */
+
+namespace {
+
+/************************************************************************/
+/*                              Load4Val()                              */
+/************************************************************************/
+
+inline __m256d Load4Val( const GByte* ptr )
+{
+    int i;
+    memcpy(&i, ptr, 4);
+    return _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(i)));
+}
+
+inline __m256d Load4Val( const GUInt16* ptr )
+{
+    return _mm256_cvtepi32_pd(_mm_cvtepu16_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr))));
+}
+
+/************************************************************************/
+/*                           AddLowAndHigh()                            */
+/************************************************************************/
+
+/* Same reduction as XMMReg4Double::AddLowAndHigh() : (v0+v2)+(v1+v3) */
+
+inline double AddLowAndHigh( __m256d v )
+{
+    __m128d xmm = _mm_add_pd(_mm256_castpd256_pd128(v),
+                             _mm256_extractf128_pd(v, 1));
+    xmm = _mm_add_sd(xmm, _mm_unpackhi_pd(xmm, xmm));
+    return _mm_cvtsd_f64(xmm);
+}
+
+/************************************************************************/
+/*                    Transpose4Rows() / Load4Rows()                    */
+/************************************************************************/
+
+/* Load 4 consecutive float values from 4 rows, and return in padfCol[k] */
+/* the values of column k of the 4 rows. */
+
+inline void Load4Rows( const float* pRow0, const float* pRow1,
+                       const float* pRow2, const float* pRow3,
+                       __m256d padfCol[4] )
+{
+    __m128 r0 = _mm_loadu_ps(pRow0);
+    __m128 r1 = _mm_loadu_ps(pRow1);
+    __m128 r2 = _mm_loadu_ps(pRow2);
+    __m128 r3 = _mm_loadu_ps(pRow3);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    padfCol[0] = _mm256_cvtps_pd(r0);
+    padfCol[1] = _mm256_cvtps_pd(r1);
+    padfCol[2] = _mm256_cvtps_pd(r2);
+    padfCol[3] = _mm256_cvtps_pd(r3);
+}
+
+inline void Load4Rows( const GByte* pRow0, const GByte* pRow1,
+                       const GByte* pRow2, const GByte* pRow3,
+                       __m256d padfCol[4] )
+{
+    int an[4];
+    memcpy(&an[0], pRow0, 4);
+    memcpy(&an[1], pRow1, 4);
+    memcpy(&an[2], pRow2, 4);
+    memcpy(&an[3], pRow3, 4);
+    const __m128i xmm = _mm_shuffle_epi8(
+        _mm_set_epi32(an[3], an[2], an[1], an[0]),
+        _mm_set_epi8(15, 11, 7, 3, 14, 10, 6, 2, 13, 9, 5, 1, 12, 8, 4, 0));
+    padfCol[0] = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(xmm));
+    padfCol[1] = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_srli_si128(xmm, 4)));
+    padfCol[2] = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_srli_si128(xmm, 8)));
+    padfCol[3] = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_srli_si128(xmm, 12)));
+}
+
+inline __m256d Load1Col( const float* pRow0, const float* pRow1,
+                         const float* pRow2, const float* pRow3 )
+{
+    return _mm256_cvtps_pd(_mm_set_ps(*pRow3, *pRow2, *pRow1, *pRow0));
+}
+
+inline __m256d Load1Col( const GByte* pRow0, const GByte* pRow1,
+                         const GByte* pRow2, const GByte* pRow3 )
+{
+    return _mm256_set_pd(*pRow3, *pRow2, *pRow1, *pRow0);
+}
+
+inline void Store4Rows( __m256d v, double* padfDst, int nDstStride )
+{
+    double adf[4];
+    _mm256_storeu_pd(adf, v);
+    padfDst[0] = adf[0];
+    padfDst[nDstStride] = adf[1];
+    padfDst[2 * nDstStride] = adf[2];
+    padfDst[3 * nDstStride] = adf[3];
+}
+
+/************************************************************************/
+/*                 ConvolutionHorizontal_3rows_Integer()                */
+/************************************************************************/
+
+/* Same as GDALResampleConvolutionHorizontal_3rows_SSE2() */
+
+template<class T> void ConvolutionHorizontal_3rows_Integer(
+    const T* pChunkRow1, const T* pChunkRow2, const T* pChunkRow3,
+    const double* padfWeights, int nSrcPixelCount,
+    double& dfRes1, double& dfRes2, double& dfRes3 )
+{
+    __m256d v_acc1 = _mm256_setzero_pd();
+    __m256d v_acc2 = _mm256_setzero_pd();
+    __m256d v_acc3 = _mm256_setzero_pd();
+    int i = 0;
+    for( ; i + 7 < nSrcPixelCount; i += 8 )
+    {
+        const __m256d v_weight1 = _mm256_loadu_pd(padfWeights + i);
+        const __m256d v_weight2 = _mm256_loadu_pd(padfWeights + i + 4);
+
+        v_acc1 = _mm256_add_pd(v_acc1,
+                    _mm256_mul_pd(Load4Val(pChunkRow1 + i), v_weight1));
+        v_acc1 = _mm256_add_pd(v_acc1,
+                    _mm256_mul_pd(Load4Val(pChunkRow1 + i + 4), v_weight2));
+        v_acc2 = _mm256_add_pd(v_acc2,
+                    _mm256_mul_pd(Load4Val(pChunkRow2 + i), v_weight1));
+        v_acc2 = _mm256_add_pd(v_acc2,
+                    _mm256_mul_pd(Load4Val(pChunkRow2 + i + 4), v_weight2));
+        v_acc3 = _mm256_add_pd(v_acc3,
+                    _mm256_mul_pd(Load4Val(pChunkRow3 + i), v_weight1));
+        v_acc3 = _mm256_add_pd(v_acc3,
+                    _mm256_mul_pd(Load4Val(pChunkRow3 + i + 4), v_weight2));
+    }
+
+    dfRes1 = AddLowAndHigh(v_acc1);
+    dfRes2 = AddLowAndHigh(v_acc2);
+    dfRes3 = AddLowAndHigh(v_acc3);
+    for( ; i < nSrcPixelCount; i++ )
+    {
+        dfRes1 += pChunkRow1[i] * padfWeights[i];
+        dfRes2 += pChunkRow2[i] * padfWeights[i];
+        dfRes3 += pChunkRow3[i] * padfWeights[i];
+    }
+}
+
+/************************************************************************/
+/*         ConvolutionHorizontalPixelCountLess8_3rows_Integer()         */
+/************************************************************************/
+
+/* Same as GDALResampleConvolutionHorizontalPixelCountLess8_3rows_SSE2() */
+
+template<class T> void ConvolutionHorizontalPixelCountLess8_3rows_Integer(
+    const T* pChunkRow1, const T* pChunkRow2, const T* pChunkRow3,
+    const double* padfWeights, int nSrcPixelCount,
+    double& dfRes1, double& dfRes2, double& dfRes3 )
+{
+    __m256d v_acc1 = _mm256_setzero_pd();
+    __m256d v_acc2 = _mm256_setzero_pd();
+    __m256d v_acc3 = _mm256_setzero_pd();
+    int i = 0;
+    for( ; i + 3 < nSrcPixelCount; i += 4 )
+    {
+        const __m256d v_weight = _mm256_loadu_pd(padfWeights + i);
+
+        v_acc1 = _mm256_add_pd(v_acc1,
+                    _mm256_mul_pd(Load4Val(pChunkRow1 + i), v_weight));
+        v_acc2 = _mm256_add_pd(v_acc2,
+                    _mm256_mul_pd(Load4Val(pChunkRow2 + i), v_weight));
+        v_acc3 = _mm256_add_pd(v_acc3,
+                    _mm256_mul_pd(Load4Val(pChunkRow3 + i), v_weight));
+    }
+
+    dfRes1 = AddLowAndHigh(v_acc1);
+    dfRes2 = AddLowAndHigh(v_acc2);
+    dfRes3 = AddLowAndHigh(v_acc3);
+    for( ; i < nSrcPixelCount; i++ )
+    {
+        dfRes1 += pChunkRow1[i] * padfWeights[i];
+        dfRes2 += pChunkRow2[i] * padfWeights[i];
+        dfRes3 += pChunkRow3[i] * padfWeights[i];
+    }
+}
+
+/************************************************************************/
+/*                   ConvolutionHorizontal_Integer()                    */
+/************************************************************************/
+
+/* Same as GDALResampleConvolutionHorizontalSSE2() */
+
+template<class T> double ConvolutionHorizontal_Integer(
+    const T* pChunk, const double* padfWeights, int nSrcPixelCount )
+{
+    __m256d v_acc1 = _mm256_setzero_pd();
+    __m256d v_acc2 = _mm256_setzero_pd();
+    int i = 0;
+    for( ; i + 7 < nSrcPixelCount; i += 8 )
+    {
+        v_acc1 = _mm256_add_pd(v_acc1,
+                    _mm256_mul_pd(Load4Val(pChunk + i),
+                                  _mm256_loadu_pd(padfWeights + i)));
+        v_acc2 = _mm256_add_pd(v_acc2,
+                    _mm256_mul_pd(Load4Val(pChunk + i + 4),
+                                  _mm256_loadu_pd(padfWeights + i + 4)));
+    }
+
+    double dfVal = AddLowAndHigh(_mm256_add_pd(v_acc1, v_acc2));
+    for( ; i < nSrcPixelCount; i++ )
+    {
+        dfVal += pChunk[i] * padfWeights[i];
+    }
+    return dfVal;
+}
+
+/************************************************************************/
+/*                ConvolutionHorizontalRows_Integer()                   */
+/************************************************************************/
+
+/* Dispatch the rows like GDALResampleChunk32R_ConvolutionT() does: by */
+/* groups of 3 rows, and then one row at a time. */
+
+template<class T> void ConvolutionHorizontalRows_Integer(
+    const T* pChunk, int nChunkXSize, int nRows,
+    const double* padfWeights, int nSrcPixelCount, bool bSrcPixelCountLess8,
+    double* padfDst, int nDstStride )
+{
+    int iRow = 0;
+    for( ; iRow + 2 < nRows; iRow += 3 )
+    {
+        const T* pChunkRow1 = pChunk + static_cast<size_t>(iRow) * nChunkXSize;
+        double dfRes1, dfRes2, dfRes3;
+        if( bSrcPixelCountLess8 )
+        {
+            ConvolutionHorizontalPixelCountLess8_3rows_Integer(
+                pChunkRow1, pChunkRow1 + nChunkXSize,
+                pChunkRow1 + 2 * nChunkXSize,
+                padfWeights, nSrcPixelCount, dfRes1, dfRes2, dfRes3);
+        }
+        else
+        {
+            ConvolutionHorizontal_3rows_Integer(
+                pChunkRow1, pChunkRow1 + nChunkXSize,
+                pChunkRow1 + 2 * nChunkXSize,
+                padfWeights, nSrcPixelCount, dfRes1, dfRes2, dfRes3);
+        }
+        padfDst[static_cast<size_t>(iRow) * nDstStride] = dfRes1;
+        padfDst[static_cast<size_t>(iRow + 1) * nDstStride] = dfRes2;
+        padfDst[static_cast<size_t>(iRow + 2) * nDstStride] = dfRes3;
+    }
+    for( ; iRow < nRows; iRow++ )
+    {
+        padfDst[static_cast<size_t>(iRow) * nDstStride] =
+            ConvolutionHorizontal_Integer(
+                pChunk + static_cast<size_t>(iRow) * nChunkXSize,
+                padfWeights, nSrcPixelCount);
+    }
+}
+
+/************************************************************************/
+/*               ConvolutionHorizontalWithMask_Integer()                */
+/************************************************************************/
+
+/* Same as GDALResampleConvolutionHorizontalWithMaskSSE2() */
+
+template<class T> void ConvolutionHorizontalWithMask_Integer(
+    const T* pChunk, const GByte* pabyMask,
+    const double* padfWeights, int nSrcPixelCount,
+    double& dfVal, double& dfWeightSum )
+{
+    __m256d v_acc = _mm256_setzero_pd();
+    __m256d v_acc_weight = _mm256_setzero_pd();
+    int i = 0;
+    for( ; i + 3 < nSrcPixelCount; i += 4 )
+    {
+        const __m256d v_weight = _mm256_mul_pd(
+            _mm256_loadu_pd(padfWeights + i), Load4Val(pabyMask + i));
+        v_acc = _mm256_add_pd(v_acc,
+                    _mm256_mul_pd(Load4Val(pChunk + i), v_weight));
+        v_acc_weight = _mm256_add_pd(v_acc_weight, v_weight);
+    }
+    dfVal = AddLowAndHigh(v_acc);
+    dfWeightSum = AddLowAndHigh(v_acc_weight);
+    for( ; i < nSrcPixelCount; i++ )
+    {
+        const double dfWeight = padfWeights[i] * pabyMask[i];
+        dfVal += pChunk[i] * dfWeight;
+        dfWeightSum += dfWeight;
+    }
+}
+
+/************************************************************************/
+/*                     StoreHorizontalWithMask()                        */
+/************************************************************************/
+
+inline void StoreHorizontalWithMask( double dfVal, double dfWeightSum,
+                                     double* padfDst, GByte* pabyDstMask )
+{
+    if( dfWeightSum > 0.0 )
+    {
+        *padfDst = dfVal / dfWeightSum;
+        *pabyDstMask = 1;
+    }
+    else
+    {
+        *padfDst = 0.0;
+        *pabyDstMask = 0;
+    }
+}
+
+/************************************************************************/
+/*              ConvolutionHorizontalRowsWithMask_Integer()             */
+/************************************************************************/
+
+template<class T> void ConvolutionHorizontalRowsWithMask_Integer(
+    const T* pChunk, const GByte* pabyMask, int nChunkXSize, int nRows,
+    const double* padfWeights, int nSrcPixelCount,
+    double* padfDst, GByte* pabyDstMask, int nDstStride )
+{
+    for( int iRow = 0; iRow < nRows; iRow++ )
+    {
+        const size_t nSrcOffset = static_cast<size_t>(iRow) * nChunkXSize;
+        const size_t nDstOffset = static_cast<size_t>(iRow) * nDstStride;
+        double dfVal, dfWeightSum;
+        ConvolutionHorizontalWithMask_Integer(
+            pChunk + nSrcOffset, pabyMask + nSrcOffset,
+            padfWeights, nSrcPixelCount, dfVal, dfWeightSum);
+        StoreHorizontalWithMask(dfVal, dfWeightSum,
+                                padfDst + nDstOffset, pabyDstMask + nDstOffset);
+    }
+}
+
+/************************************************************************/
+/*                    ConvolutionHorizontal_Float()                     */
+/************************************************************************/
+
+/* Same as the scalar GDALResampleConvolutionHorizontal(), computed on 4 */
+/* rows at once, one row per lane. */
+
+inline double ConvolutionHorizontal_Float(
+    const float* pChunk, const double* padfWeights, int nSrcPixelCount )
+{
+    double dfVal1 = 0.0, dfVal2 = 0.0;
+    int i = 0;
+    for( ; i + 3 < nSrcPixelCount; i += 4 )
+    {
+        dfVal1 += pChunk[i] * padfWeights[i];
+        dfVal1 += pChunk[i+1] * padfWeights[i+1];
+        dfVal2 += pChunk[i+2] * padfWeights[i+2];
+        dfVal2 += pChunk[i+3] * padfWeights[i+3];
+    }
+    for( ; i < nSrcPixelCount; i++ )
+    {
+        dfVal1 += pChunk[i] * padfWeights[i];
+    }
+    return dfVal1 + dfVal2;
+}
+
+void ConvolutionHorizontalRows_Float(
+    const float* pChunk, int nChunkXSize, int nRows,
+    const double* padfWeights, int nSrcPixelCount,
+    double* padfDst, int nDstStride )
+{
+    int iRow = 0;
+    for( ; iRow + 3 < nRows; iRow += 4 )
+    {
+        const float* pRow0 = pChunk + static_cast<size_t>(iRow) * nChunkXSize;
+        const float* pRow1 = pRow0 + nChunkXSize;
+        const float* pRow2 = pRow1 + nChunkXSize;
+        const float* pRow3 = pRow2 + nChunkXSize;
+        __m256d v_acc1 = _mm256_setzero_pd();
+        __m256d v_acc2 = _mm256_setzero_pd();
+        int i = 0;
+        for( ; i + 3 < nSrcPixelCount; i += 4 )
+        {
+            __m256d v_cols[4];
+            Load4Rows(pRow0 + i, pRow1 + i, pRow2 + i, pRow3 + i, v_cols);
+            v_acc1 = _mm256_add_pd(v_acc1, _mm256_mul_pd(v_cols[0],
+                                    _mm256_set1_pd(padfWeights[i])));
+            v_acc1 = _mm256_add_pd(v_acc1, _mm256_mul_pd(v_cols[1],
+                                    _mm256_set1_pd(padfWeights[i+1])));
+            v_acc2 = _mm256_add_pd(v_acc2, _mm256_mul_pd(v_cols[2],
+                                    _mm256_set1_pd(padfWeights[i+2])));
+            v_acc2 = _mm256_add_pd(v_acc2, _mm256_mul_pd(v_cols[3],
+                                    _mm256_set1_pd(padfWeights[i+3])));
+        }
+        for( ; i < nSrcPixelCount; i++ )
+        {
+            v_acc1 = _mm256_add_pd(v_acc1, _mm256_mul_pd(
+                Load1Col(pRow0 + i, pRow1 + i, pRow2 + i, pRow3 + i),
+                _mm256_set1_pd(padfWeights[i])));
+        }
+        Store4Rows(_mm256_add_pd(v_acc1, v_acc2),
+                   padfDst + static_cast<size_t>(iRow) * nDstStride,
+                   nDstStride);
+    }
+    for( ; iRow < nRows; iRow++ )
+    {
+        padfDst[static_cast<size_t>(iRow) * nDstStride] =
+            ConvolutionHorizontal_Float(
+                pChunk + static_cast<size_t>(iRow) * nChunkXSize,
+                padfWeights, nSrcPixelCount);
+    }
+}
+
+/************************************************************************/
+/*                ConvolutionHorizontalWithMask_Float()                 */
+/************************************************************************/
+
+/* Same as the scalar GDALResampleConvolutionHorizontalWithMask() */
+
+inline void ConvolutionHorizontalWithMask_Float(
+    const float* pChunk, const GByte* pabyMask,
+    const double* padfWeights, int nSrcPixelCount,
+    double& dfVal, double& dfWeightSum )
+{
+    dfVal = 0;
+    dfWeightSum = 0;
+    int i = 0;
+    for( ; i + 3 < nSrcPixelCount; i += 4 )
+    {
+        const double dfWeight0 = padfWeights[i] * pabyMask[i];
+        const double dfWeight1 = padfWeights[i+1] * pabyMask[i+1];
+        const double dfWeight2 = padfWeights[i+2] * pabyMask[i+2];
+        const double dfWeight3 = padfWeights[i+3] * pabyMask[i+3];
+        dfVal += pChunk[i] * dfWeight0;
+        dfVal += pChunk[i+1] * dfWeight1;
+        dfVal += pChunk[i+2] * dfWeight2;
+        dfVal += pChunk[i+3] * dfWeight3;
+        dfWeightSum += dfWeight0 + dfWeight1 + dfWeight2 + dfWeight3;
+    }
+    for( ; i < nSrcPixelCount; i++ )
+    {
+        const double dfWeight = padfWeights[i] * pabyMask[i];
+        dfVal += pChunk[i] * dfWeight;
+        dfWeightSum += dfWeight;
+    }
+}
+
+void ConvolutionHorizontalRowsWithMask_Float(
+    const float* pChunk, const GByte* pabyMask, int nChunkXSize, int nRows,
+    const double* padfWeights, int nSrcPixelCount,
+    double* padfDst, GByte* pabyDstMask, int nDstStride )
+{
+    int iRow = 0;
+    for( ; iRow + 3 < nRows; iRow += 4 )
+    {
+        const size_t nSrcOffset = static_cast<size_t>(iRow) * nChunkXSize;
+        const float* pRow0 = pChunk + nSrcOffset;
+        const float* pRow1 = pRow0 + nChunkXSize;
+        const float* pRow2 = pRow1 + nChunkXSize;
+        const float* pRow3 = pRow2 + nChunkXSize;
+        const GByte* pabyRow0 = pabyMask + nSrcOffset;
+        const GByte* pabyRow1 = pabyRow0 + nChunkXSize;
+        const GByte* pabyRow2 = pabyRow1 + nChunkXSize;
+        const GByte* pabyRow3 = pabyRow2 + nChunkXSize;
+        __m256d v_acc = _mm256_setzero_pd();
+        __m256d v_acc_weight = _mm256_setzero_pd();
+        int i = 0;
+        for( ; i + 3 < nSrcPixelCount; i += 4 )
+        {
+            __m256d v_cols[4];
+            __m256d v_masks[4];
+            Load4Rows(pRow0 + i, pRow1 + i, pRow2 + i, pRow3 + i, v_cols);
+            Load4Rows(pabyRow0 + i, pabyRow1 + i, pabyRow2 + i, pabyRow3 + i,
+                      v_masks);
+            __m256d v_weights[4];
+            for( int k = 0; k < 4; k++ )
+            {
+                v_weights[k] = _mm256_mul_pd(
+                    _mm256_set1_pd(padfWeights[i+k]), v_masks[k]);
+                v_acc = _mm256_add_pd(v_acc,
+                            _mm256_mul_pd(v_cols[k], v_weights[k]));
+            }
+            v_acc_weight = _mm256_add_pd(v_acc_weight,
+                _mm256_add_pd(_mm256_add_pd(
+                    _mm256_add_pd(v_weights[0], v_weights[1]),
+                    v_weights[2]), v_weights[3]));
+        }
+        for( ; i < nSrcPixelCount; i++ )
+        {
+            const __m256d v_weight = _mm256_mul_pd(
+                _mm256_set1_pd(padfWeights[i]),
+                Load1Col(pabyRow0 + i, pabyRow1 + i, pabyRow2 + i,
+                         pabyRow3 + i));
+            v_acc = _mm256_add_pd(v_acc, _mm256_mul_pd(
+                Load1Col(pRow0 + i, pRow1 + i, pRow2 + i, pRow3 + i),
+                v_weight));
+            v_acc_weight = _mm256_add_pd(v_acc_weight, v_weight);
+        }
+
+        double adfVal[4], adfWeightSum[4];
+        _mm256_storeu_pd(adfVal, v_acc);
+        _mm256_storeu_pd(adfWeightSum, v_acc_weight);
+        for( int k = 0; k < 4; k++ )
+        {
+            const size_t nDstOffset =
+                static_cast<size_t>(iRow + k) * nDstStride;
+            StoreHorizontalWithMask(adfVal[k], adfWeightSum[k],
+                                    padfDst + nDstOffset,
+                                    pabyDstMask + nDstOffset);
+        }
+    }
+    for( ; iRow < nRows; iRow++ )
+    {
+        const size_t nSrcOffset = static_cast<size_t>(iRow) * nChunkXSize;
+        const size_t nDstOffset = static_cast<size_t>(iRow) * nDstStride;
+        double dfVal, dfWeightSum;
+        ConvolutionHorizontalWithMask_Float(
+            pChunk + nSrcOffset, pabyMask + nSrcOffset,
+            padfWeights, nSrcPixelCount, dfVal, dfWeightSum);
+        StoreHorizontalWithMask(dfVal, dfWeightSum,
+                                padfDst + nDstOffset, pabyDstMask + nDstOffset);
+    }
+}
+
+/************************************************************************/
+/*                     ConvolutionVertical4Cols()                       */
+/************************************************************************/
+
+/* Same as the scalar GDALResampleConvolutionVertical(), computed on 4 */
+/* columns at once. */
+
+inline __m256d ConvolutionVertical4Cols( const double* padfSrc, int nStride,
+                                         const double* padfWeights,
+                                         int nSrcLineCount )
+{
+    __m256d v_acc1 = _mm256_setzero_pd();
+    __m256d v_acc2 = _mm256_setzero_pd();
+    int i = 0;
+    size_t j = 0;
+    for( ; i + 3 < nSrcLineCount; i += 4, j += 4 * static_cast<size_t>(nStride) )
+    {
+        v_acc1 = _mm256_add_pd(v_acc1, _mm256_mul_pd(
+            _mm256_loadu_pd(padfSrc + j),
+            _mm256_set1_pd(padfWeights[i])));
+        v_acc1 = _mm256_add_pd(v_acc1, _mm256_mul_pd(
+            _mm256_loadu_pd(padfSrc + j + nStride),
+            _mm256_set1_pd(padfWeights[i+1])));
+        v_acc2 = _mm256_add_pd(v_acc2, _mm256_mul_pd(
+            _mm256_loadu_pd(padfSrc + j + 2 * nStride),
+            _mm256_set1_pd(padfWeights[i+2])));
+        v_acc2 = _mm256_add_pd(v_acc2, _mm256_mul_pd(
+            _mm256_loadu_pd(padfSrc + j + 3 * nStride),
+            _mm256_set1_pd(padfWeights[i+3])));
+    }
+    for( ; i < nSrcLineCount; i++, j += nStride )
+    {
+        v_acc1 = _mm256_add_pd(v_acc1, _mm256_mul_pd(
+            _mm256_loadu_pd(padfSrc + j),
+            _mm256_set1_pd(padfWeights[i])));
+    }
+    return _mm256_add_pd(v_acc1, v_acc2);
+}
+
+} // end anonymous namespace
+
+/************************************************************************/
+/*               GDALResampleConvolutionHorizontalAVX2()                */
+/************************************************************************/
+
+void GDALResampleConvolutionHorizontalAVX2( const GByte* pChunk,
+                                            int nChunkXSize, int nRows,
+                                            const double* padfWeights,
+                                            int nSrcPixelCount,
+                                            bool bSrcPixelCountLess8,
+                                            double* padfDst, int nDstStride )
+{
+    ConvolutionHorizontalRows_Integer(pChunk, nChunkXSize, nRows,
+                                      padfWeights, nSrcPixelCount,
+                                      bSrcPixelCountLess8,
+                                      padfDst, nDstStride);
+}
+
+void GDALResampleConvolutionHorizontalAVX2( const GUInt16* pChunk,
+                                            int nChunkXSize, int nRows,
+                                            const double* padfWeights,
+                                            int nSrcPixelCount,
+                                            bool bSrcPixelCountLess8,
+                                            double* padfDst, int nDstStride )
+{
+    ConvolutionHorizontalRows_Integer(pChunk, nChunkXSize, nRows,
+                                      padfWeights, nSrcPixelCount,
+                                      bSrcPixelCountLess8,
+                                      padfDst, nDstStride);
+}
+
+void GDALResampleConvolutionHorizontalAVX2( const float* pChunk,
+                                            int nChunkXSize, int nRows,
+                                            const double* padfWeights,
+                                            int nSrcPixelCount,
+                                            bool /* bSrcPixelCountLess8 */,
+                                            double* padfDst, int nDstStride )
+{
+    ConvolutionHorizontalRows_Float(pChunk, nChunkXSize, nRows,
+                                    padfWeights, nSrcPixelCount,
+                                    padfDst, nDstStride);
+}
+
+/************************************************************************/
+/*           GDALResampleConvolutionHorizontalWithMaskAVX2()            */
+/************************************************************************/
+
+void GDALResampleConvolutionHorizontalWithMaskAVX2( const GByte* pChunk,
+                                                    const GByte* pabyMask,
+                                                    int nChunkXSize, int nRows,
+                                                    const double* padfWeights,
+                                                    int nSrcPixelCount,
+                                                    double* padfDst,
+                                                    GByte* pabyDstMask,
+                                                    int nDstStride )
+{
+    ConvolutionHorizontalRowsWithMask_Integer(pChunk, pabyMask,
+                                              nChunkXSize, nRows,
+                                              padfWeights, nSrcPixelCount,
+                                              padfDst, pabyDstMask,
+                                              nDstStride);
+}
+
+void GDALResampleConvolutionHorizontalWithMaskAVX2( const GUInt16* pChunk,
+                                                    const GByte* pabyMask,
+                                                    int nChunkXSize, int nRows,
+                                                    const double* padfWeights,
+                                                    int nSrcPixelCount,
+                                                    double* padfDst,
+                                                    GByte* pabyDstMask,
+                                                    int nDstStride )
+{
+    ConvolutionHorizontalRowsWithMask_Integer(pChunk, pabyMask,
+                                              nChunkXSize, nRows,
+                                              padfWeights, nSrcPixelCount,
+                                              padfDst, pabyDstMask,
+                                              nDstStride);
+}
+
+void GDALResampleConvolutionHorizontalWithMaskAVX2( const float* pChunk,
+                                                    const GByte* pabyMask,
+                                                    int nChunkXSize, int nRows,
+                                                    const double* padfWeights,
+                                                    int nSrcPixelCount,
+                                                    double* padfDst,
+                                                    GByte* pabyDstMask,
+                                                    int nDstStride )
+{
+    ConvolutionHorizontalRowsWithMask_Float(pChunk, pabyMask,
+                                            nChunkXSize, nRows,
+                                            padfWeights, nSrcPixelCount,
+                                            padfDst, pabyDstMask,
+                                            nDstStride);
+}
+
+/************************************************************************/
+/*                GDALResampleConvolutionVerticalAVX2()                 */
+/************************************************************************/
+
+void GDALResampleConvolutionVerticalAVX2( const double* padfSrc, int nStride,
+                                          const double* padfWeights,
+                                          int nSrcLineCount,
+                                          float* pafDst, int nDstXSize )
+{
+    int iCol = 0;
+    for( ; iCol + 3 < nDstXSize; iCol += 4 )
+    {
+        _mm_storeu_ps(pafDst + iCol, _mm256_cvtpd_ps(
+            ConvolutionVertical4Cols(padfSrc + iCol, nStride,
+                                     padfWeights, nSrcLineCount)));
+    }
+    for( ; iCol < nDstXSize; iCol++ )
+    {
+        double dfVal1 = 0.0, dfVal2 = 0.0;
+        int i = 0;
+        size_t j = iCol;
+        for( ; i + 3 < nSrcLineCount; i += 4, j += 4 * static_cast<size_t>(nStride) )
+        {
+            dfVal1 += padfSrc[j] * padfWeights[i];
+            dfVal1 += padfSrc[j + nStride] * padfWeights[i+1];
+            dfVal2 += padfSrc[j + 2 * nStride] * padfWeights[i+2];
+            dfVal2 += padfSrc[j + 3 * nStride] * padfWeights[i+3];
+        }
+        for( ; i < nSrcLineCount; i++, j += nStride )
+        {
+            dfVal1 += padfSrc[j] * padfWeights[i];
+        }
+        pafDst[iCol] = static_cast<float>(dfVal1 + dfVal2);
+    }
+}
+
+/************************************************************************/
+/*            GDALResampleConvolutionVerticalWithMaskAVX2()             */
+/************************************************************************/
+
+void GDALResampleConvolutionVerticalWithMaskAVX2( const double* padfSrc,
+                                                  const GByte* pabyMask,
+                                                  int nStride,
+                                                  const double* padfWeights,
+                                                  int nSrcLineCount,
+                                                  float fNoDataValue,
+                                                  float* pafDst,
+                                                  int nDstXSize )
+{
+    const __m256d v_nodata = _mm256_set1_pd(fNoDataValue);
+    int iCol = 0;
+    for( ; iCol + 3 < nDstXSize; iCol += 4 )
+    {
+        __m256d v_acc = _mm256_setzero_pd();
+        __m256d v_acc_weight = _mm256_setzero_pd();
+        size_t j = iCol;
+        for( int i = 0; i < nSrcLineCount; i++, j += nStride )
+        {
+            const __m256d v_weight = _mm256_mul_pd(
+                _mm256_set1_pd(padfWeights[i]), Load4Val(pabyMask + j));
+            v_acc = _mm256_add_pd(v_acc,
+                _mm256_mul_pd(_mm256_loadu_pd(padfSrc + j), v_weight));
+            v_acc_weight = _mm256_add_pd(v_acc_weight, v_weight);
+        }
+        const __m256d v_valid = _mm256_cmp_pd(v_acc_weight,
+                                              _mm256_setzero_pd(),
+                                              _CMP_GT_OQ);
+        _mm_storeu_ps(pafDst + iCol, _mm256_cvtpd_ps(_mm256_blendv_pd(
+            v_nodata, _mm256_div_pd(v_acc, v_acc_weight), v_valid)));
+    }
+    for( ; iCol < nDstXSize; iCol++ )
+    {
+        double dfVal = 0.0;
+        double dfWeightSum = 0.0;
+        size_t j = iCol;
+        for( int i = 0; i < nSrcLineCount; i++, j += nStride )
+        {
+            const double dfWeight = padfWeights[i] * pabyMask[j];
+            dfVal += padfSrc[j] * dfWeight;
+            dfWeightSum += dfWeight;
+        }
+        if( dfWeightSum > 0.0 )
+            pafDst[iCol] = static_cast<float>(dfVal / dfWeightSum);
+        else
+            pafDst[iCol] = fNoDataValue;
+    }
+}
+
+/************************************************************************/
+/*                    GDALResampleAverageBy2AVX2()                      */
+/************************************************************************/
+
+/* The integer versions compute (a + b + c + d + 2) / 4 like the scalar */
+/* code of GDALResampleChunk32R_AverageT(). The float version computes  */
+/* the sum in double, in the same order as the general case. */
+
+void GDALResampleAverageBy2AVX2( const GByte* pSrcRow0, const GByte* pSrcRow1,
+                                 GByte* pDst, int nDstCount )
+{
+    const __m256i ones = _mm256_set1_epi8(1);
+    const __m256i two = _mm256_set1_epi16(2);
+    int i = 0;
+    for( ; i + 31 < nDstCount; i += 32 )
+    {
+        const __m256i* pSrc0 = reinterpret_cast<const __m256i*>(pSrcRow0 + 2 * i);
+        const __m256i* pSrc1 = reinterpret_cast<const __m256i*>(pSrcRow1 + 2 * i);
+        // Sums of the pairs of horizontally adjacent pixels, on 16 bits
+        __m256i lo = _mm256_add_epi16(
+            _mm256_maddubs_epi16(_mm256_loadu_si256(pSrc0), ones),
+            _mm256_maddubs_epi16(_mm256_loadu_si256(pSrc1), ones));
+        __m256i hi = _mm256_add_epi16(
+            _mm256_maddubs_epi16(_mm256_loadu_si256(pSrc0 + 1), ones),
+            _mm256_maddubs_epi16(_mm256_loadu_si256(pSrc1 + 1), ones));
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, two), 2);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, two), 2);
+        // packus works within 128 bit lanes
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i),
+            _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi),
+                                     _MM_SHUFFLE(3,1,2,0)));
+    }
+    for( ; i < nDstCount; i++ )
+    {
+        const int nTotal = pSrcRow0[2 * i] + pSrcRow0[2 * i + 1] +
+                           pSrcRow1[2 * i] + pSrcRow1[2 * i + 1];
+        pDst[i] = static_cast<GByte>((nTotal + 2) / 4);
+    }
+}
+
+void GDALResampleAverageBy2AVX2( const GUInt16* pSrcRow0,
+                                 const GUInt16* pSrcRow1,
+                                 GUInt16* pDst, int nDstCount )
+{
+    const __m256i mask = _mm256_set1_epi32(0xFFFF);
+    const __m256i two = _mm256_set1_epi32(2);
+    int i = 0;
+    for( ; i + 15 < nDstCount; i += 16 )
+    {
+        const __m256i* pSrc0 = reinterpret_cast<const __m256i*>(pSrcRow0 + 2 * i);
+        const __m256i* pSrc1 = reinterpret_cast<const __m256i*>(pSrcRow1 + 2 * i);
+        __m256i aSums[2];
+        for( int k = 0; k < 2; k++ )
+        {
+            const __m256i v0 = _mm256_loadu_si256(pSrc0 + k);
+            const __m256i v1 = _mm256_loadu_si256(pSrc1 + k);
+            // Sums of the even and odd pixels, on 32 bits
+            __m256i sum = _mm256_add_epi32(
+                _mm256_add_epi32(_mm256_and_si256(v0, mask),
+                                 _mm256_srli_epi32(v0, 16)),
+                _mm256_add_epi32(_mm256_and_si256(v1, mask),
+                                 _mm256_srli_epi32(v1, 16)));
+            aSums[k] = _mm256_srli_epi32(_mm256_add_epi32(sum, two), 2);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i),
+            _mm256_permute4x64_epi64(_mm256_packus_epi32(aSums[0], aSums[1]),
+                                     _MM_SHUFFLE(3,1,2,0)));
+    }
+    for( ; i < nDstCount; i++ )
+    {
+        const GUInt32 nTotal = pSrcRow0[2 * i] + pSrcRow0[2 * i + 1] +
+                               pSrcRow1[2 * i] + pSrcRow1[2 * i + 1];
+        pDst[i] = static_cast<GUInt16>((nTotal + 2) / 4);
+    }
+}
+
+void GDALResampleAverageBy2AVX2( const float* pSrcRow0, const float* pSrcRow1,
+                                 float* pDst, int nDstCount )
+{
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d four = _mm256_set1_pd(4.0);
+    int i = 0;
+    for( ; i + 7 < nDstCount; i += 8 )
+    {
+        __m256 aEven[2], aOdd[2];
+        const float* apSrc[2] = { pSrcRow0 + 2 * i, pSrcRow1 + 2 * i };
+        for( int k = 0; k < 2; k++ )
+        {
+            const __m256 v0 = _mm256_loadu_ps(apSrc[k]);
+            const __m256 v1 = _mm256_loadu_ps(apSrc[k] + 8);
+            // shuffle_ps works within 128 bit lanes, so reorder the pairs
+            aEven[k] = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(
+                _mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(2,0,2,0))),
+                _MM_SHUFFLE(3,1,2,0)));
+            aOdd[k] = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(
+                _mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(3,1,3,1))),
+                _MM_SHUFFLE(3,1,2,0)));
+        }
+        __m128 aRes[2];
+        for( int k = 0; k < 2; k++ )
+        {
+            __m256d sum = _mm256_add_pd(zero, _mm256_cvtps_pd(
+                k == 0 ? _mm256_castps256_ps128(aEven[0])
+                       : _mm256_extractf128_ps(aEven[0], 1)));
+            sum = _mm256_add_pd(sum, _mm256_cvtps_pd(
+                k == 0 ? _mm256_castps256_ps128(aOdd[0])
+                       : _mm256_extractf128_ps(aOdd[0], 1)));
+            sum = _mm256_add_pd(sum, _mm256_cvtps_pd(
+                k == 0 ? _mm256_castps256_ps128(aEven[1])
+                       : _mm256_extractf128_ps(aEven[1], 1)));
+            sum = _mm256_add_pd(sum, _mm256_cvtps_pd(
+                k == 0 ? _mm256_castps256_ps128(aOdd[1])
+                       : _mm256_extractf128_ps(aOdd[1], 1)));
+            aRes[k] = _mm256_cvtpd_ps(_mm256_div_pd(sum, four));
+        }
+        _mm_storeu_ps(pDst + i, aRes[0]);
+        _mm_storeu_ps(pDst + i + 4, aRes[1]);
+    }
+    for( ; i < nDstCount; i++ )
+    {
+        double dfTotal = 0;
+        dfTotal += pSrcRow0[2 * i];
+        dfTotal += pSrcRow0[2 * i + 1];
+        dfTotal += pSrcRow1[2 * i];
+        dfTotal += pSrcRow1[2 * i + 1];
+        pDst[i] = static_cast<float>(dfTotal / 4);
+    }
+}
+
+#endif // HAVE_AVX2_AT_COMPILE_TIME
@@ -0,0 +1,126 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  AVX2 kernels of the convolution and average overview resamplers
+ *
+ ******************************************************************************
+ * Copyright (c) 2016, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef OVERVIEW_AVX2_HPP_INCLUDED
+#define OVERVIEW_AVX2_HPP_INCLUDED
+
+#include "cpl_port.h"
+
+/*
+ * Kernels of GDALResampleChunk32R_ConvolutionT() and
+ * GDALResampleChunk32R_AverageT(), implemented in overview_avx2.cpp, that
+ * must only be called when CPLHaveRuntimeAVX2() is true.
+ *
+ * They do the same double precision operations, in the same order, as the
+ * SSE2 and scalar code of overview.cpp, so that the overviews are identical
+ * whether AVX2 is used or not.
+ */
+
+#ifdef HAVE_AVX2_AT_COMPILE_TIME
+
+/* Horizontal filter of nRows rows of nChunkXSize pixels, for one target */
+/* pixel. pChunk points to the first source pixel of the first row, and */
+/* the result of row i is written in padfDst[i * nDstStride]. */
+void GDALResampleConvolutionHorizontalAVX2( const GByte* pChunk,
+                                            int nChunkXSize, int nRows,
+                                            const double* padfWeights,
+                                            int nSrcPixelCount,
+                                            bool bSrcPixelCountLess8,
+                                            double* padfDst, int nDstStride );
+void GDALResampleConvolutionHorizontalAVX2( const GUInt16* pChunk,
+                                            int nChunkXSize, int nRows,
+                                            const double* padfWeights,
+                                            int nSrcPixelCount,
+                                            bool bSrcPixelCountLess8,
+                                            double* padfDst, int nDstStride );
+void GDALResampleConvolutionHorizontalAVX2( const float* pChunk,
+                                            int nChunkXSize, int nRows,
+                                            const double* padfWeights,
+                                            int nSrcPixelCount,
+                                            bool bSrcPixelCountLess8,
+                                            double* padfDst, int nDstStride );
+
+/* Same as above, with a validity mask of the source pixels. The filtered */
+/* value is normalized by the sum of the weights of the valid pixels, and */
+/* pabyDstMask[i * nDstStride] is set to 0 if there is none. */
+void GDALResampleConvolutionHorizontalWithMaskAVX2( const GByte* pChunk,
+                                                    const GByte* pabyMask,
+                                                    int nChunkXSize, int nRows,
+                                                    const double* padfWeights,
+                                                    int nSrcPixelCount,
+                                                    double* padfDst,
+                                                    GByte* pabyDstMask,
+                                                    int nDstStride );
+void GDALResampleConvolutionHorizontalWithMaskAVX2( const GUInt16* pChunk,
+                                                    const GByte* pabyMask,
+                                                    int nChunkXSize, int nRows,
+                                                    const double* padfWeights,
+                                                    int nSrcPixelCount,
+                                                    double* padfDst,
+                                                    GByte* pabyDstMask,
+                                                    int nDstStride );
+void GDALResampleConvolutionHorizontalWithMaskAVX2( const float* pChunk,
+                                                    const GByte* pabyMask,
+                                                    int nChunkXSize, int nRows,
+                                                    const double* padfWeights,
+                                                    int nSrcPixelCount,
+                                                    double* padfDst,
+                                                    GByte* pabyDstMask,
+                                                    int nDstStride );
+
+/* Vertical filter of nDstXSize columns of nSrcLineCount lines, spaced by */
+/* nStride, into a scanline. */
+void GDALResampleConvolutionVerticalAVX2( const double* padfSrc, int nStride,
+                                          const double* padfWeights,
+                                          int nSrcLineCount,
+                                          float* pafDst, int nDstXSize );
+
+/* Same as above, with a validity mask of the horizontally filtered values. */
+/* fNoDataValue is written for the columns without any valid value. */
+void GDALResampleConvolutionVerticalWithMaskAVX2( const double* padfSrc,
+                                                  const GByte* pabyMask,
+                                                  int nStride,
+                                                  const double* padfWeights,
+                                                  int nSrcLineCount,
+                                                  float fNoDataValue,
+                                                  float* pafDst,
+                                                  int nDstXSize );
+
+/* Average of 2x2 source pixels, for the overviews by a factor of 2 without */
+/* mask. pSrcRow0 and pSrcRow1 point to 2 * nDstCount pixels. */
+void GDALResampleAverageBy2AVX2( const GByte* pSrcRow0, const GByte* pSrcRow1,
+                                 GByte* pDst, int nDstCount );
+void GDALResampleAverageBy2AVX2( const GUInt16* pSrcRow0,
+                                 const GUInt16* pSrcRow1,
+                                 GUInt16* pDst, int nDstCount );
+void GDALResampleAverageBy2AVX2( const float* pSrcRow0, const float* pSrcRow1,
+                                 float* pDst, int nDstCount );
+
+#endif // HAVE_AVX2_AT_COMPILE_TIME
+
+#endif // OVERVIEW_AVX2_HPP_INCLUDED
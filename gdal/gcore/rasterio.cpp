@@ -38,6 +38,8 @@
 #include <stdexcept>
 #include <limits>
 #include "gdal_priv_templates.hpp"
+#include "rasterio_simd.hpp"
+#include "cpl_cpu_features.h"
 
 CPL_CVSID("$Id$");
 
@@ -2199,6 +2201,179 @@ static inline void GDALFastByteCopy(GByte* CPL_RESTRICT pabyDest,
     }
 }
 
+/************************************************************************/
+/*                        GDALCopyWordsSSE2Ops                          */
+/************************************************************************/
+
+#if defined(__x86_64) || defined(_M_X64)
+
+#include <emmintrin.h>
+
+namespace {
+
+/* SSE2 primitives for the packed conversions of rasterio_simd.hpp */
+
+struct GDALCopyWordsSSE2Ops
+{
+    enum { N = 4 };
+    typedef __m128i IVec;
+    typedef __m128 FVec;
+    struct DVec { __m128d lo; __m128d hi; };
+
+    static inline IVec LoadInt( const GByte* p )
+    {
+        GInt32 nVal;
+        memcpy(&nVal, p, sizeof(nVal));
+        const __m128i zero = _mm_setzero_si128();
+        return _mm_unpacklo_epi16(
+            _mm_unpacklo_epi8(_mm_cvtsi32_si128(nVal), zero), zero);
+    }
+    static inline IVec LoadInt( const GUInt16* p )
+    {
+        return _mm_unpacklo_epi16(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)),
+            _mm_setzero_si128());
+    }
+    static inline IVec LoadInt( const GInt16* p )
+    {
+        const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    }
+    static inline IVec LoadInt( const GInt32* p )
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    static inline FVec LoadF( const float* p ) { return _mm_loadu_ps(p); }
+    static inline DVec LoadD( const double* p )
+    {
+        DVec d;
+        d.lo = _mm_loadu_pd(p);
+        d.hi = _mm_loadu_pd(p + 2);
+        return d;
+    }
+
+    static inline void StoreInt( IVec v, GByte* p )
+    {
+        v = _mm_and_si128(v, _mm_set1_epi32(0xFF));
+        v = _mm_packs_epi32(v, v);
+        v = _mm_packus_epi16(v, v);
+        const GInt32 nVal = _mm_cvtsi128_si32(v);
+        memcpy(p, &nVal, sizeof(nVal));
+    }
+    static inline void StoreInt16( IVec v, void* p )
+    {
+        // Sign extend the 16 least significant bits, so that packs_epi32
+        // does not saturate
+        v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+        _mm_storel_epi64(static_cast<__m128i*>(p), _mm_packs_epi32(v, v));
+    }
+    static inline void StoreInt( IVec v, GUInt16* p ) { StoreInt16(v, p); }
+    static inline void StoreInt( IVec v, GInt16* p ) { StoreInt16(v, p); }
+    static inline void StoreInt( IVec v, GInt32* p )
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+    }
+    static inline void StoreF( FVec f, float* p ) { _mm_storeu_ps(p, f); }
+    static inline void StoreD( const DVec& d, double* p )
+    {
+        _mm_storeu_pd(p, d.lo);
+        _mm_storeu_pd(p + 2, d.hi);
+    }
+
+    static inline FVec IntToF( IVec v ) { return _mm_cvtepi32_ps(v); }
+    static inline DVec IntToD( IVec v )
+    {
+        DVec d;
+        d.lo = _mm_cvtepi32_pd(v);
+        d.hi = _mm_cvtepi32_pd(_mm_shuffle_epi32(v, _MM_SHUFFLE(3,2,3,2)));
+        return d;
+    }
+    static inline DVec FToD( FVec f )
+    {
+        DVec d;
+        d.lo = _mm_cvtps_pd(f);
+        d.hi = _mm_cvtps_pd(_mm_movehl_ps(f, f));
+        return d;
+    }
+    static inline FVec DToF( const DVec& d )
+    {
+        return _mm_movelh_ps(_mm_cvtpd_ps(d.lo), _mm_cvtpd_ps(d.hi));
+    }
+
+    static inline FVec SetF( float f ) { return _mm_set1_ps(f); }
+    static inline DVec SetD( double df )
+    {
+        DVec d;
+        d.lo = _mm_set1_pd(df);
+        d.hi = d.lo;
+        return d;
+    }
+    static inline FVec AddF( FVec a, FVec b ) { return _mm_add_ps(a, b); }
+    static inline DVec AddD( const DVec& a, const DVec& b )
+    {
+        DVec d;
+        d.lo = _mm_add_pd(a.lo, b.lo);
+        d.hi = _mm_add_pd(a.hi, b.hi);
+        return d;
+    }
+    static inline FVec RoundAwayF( FVec f )
+    {
+        const FVec sign = _mm_and_ps(f, _mm_set1_ps(-0.0f));
+        return _mm_add_ps(f, _mm_or_ps(sign, _mm_set1_ps(0.5f)));
+    }
+    static inline DVec RoundAwayD( const DVec& a )
+    {
+        const __m128d half = _mm_set1_pd(0.5);
+        const __m128d signmask = _mm_set1_pd(-0.0);
+        DVec d;
+        d.lo = _mm_add_pd(a.lo, _mm_or_pd(_mm_and_pd(a.lo, signmask), half));
+        d.hi = _mm_add_pd(a.hi, _mm_or_pd(_mm_and_pd(a.hi, signmask), half));
+        return d;
+    }
+
+    // max/min return their second operand when one of them is NaN
+    static inline FVec ClampF( FVec f, float fMin, float fMax )
+    {
+        return _mm_min_ps(_mm_set1_ps(fMax), _mm_max_ps(_mm_set1_ps(fMin), f));
+    }
+    static inline DVec ClampD( const DVec& a, double dfMin, double dfMax )
+    {
+        const __m128d vmin = _mm_set1_pd(dfMin);
+        const __m128d vmax = _mm_set1_pd(dfMax);
+        DVec d;
+        d.lo = _mm_min_pd(vmax, _mm_max_pd(vmin, a.lo));
+        d.hi = _mm_min_pd(vmax, _mm_max_pd(vmin, a.hi));
+        return d;
+    }
+    static inline IVec ClampInt( IVec v, int nMin, int nMax )
+    {
+        const __m128i vmin = _mm_set1_epi32(nMin);
+        const __m128i vmax = _mm_set1_epi32(nMax);
+        __m128i mask = _mm_cmpgt_epi32(v, vmax);
+        v = _mm_or_si128(_mm_and_si128(mask, vmax), _mm_andnot_si128(mask, v));
+        mask = _mm_cmplt_epi32(v, vmin);
+        return _mm_or_si128(_mm_and_si128(mask, vmin), _mm_andnot_si128(mask, v));
+    }
+
+    static inline IVec TruncF( FVec f ) { return _mm_cvttps_epi32(f); }
+    static inline IVec TruncD( const DVec& d )
+    {
+        return _mm_unpacklo_epi64(_mm_cvttpd_epi32(d.lo),
+                                  _mm_cvttpd_epi32(d.hi));
+    }
+    static inline IVec OverflowToIntMax( FVec f, IVec v )
+    {
+        const __m128i mask = _mm_castps_si128(
+            _mm_cmpge_ps(f, _mm_set1_ps(2147483648.0f)));
+        return _mm_or_si128(_mm_and_si128(mask, _mm_set1_epi32(INT_MAX)),
+                            _mm_andnot_si128(mask, v));
+    }
+};
+
+} // end anonymous namespace
+
+#endif //  defined(__x86_64) || defined(_M_X64)
+
 /************************************************************************/
 /*                           GDALCopyWords()                            */
 /************************************************************************/
@@ -2336,6 +2511,45 @@ GDALCopyWords( const void * CPL_RESTRICT pSrcData, GDALDataType eSrcType, int nS
         }
     }
 
+#if defined(HAVE_AVX2_AT_COMPILE_TIME) || defined(__x86_64) || defined(_M_X64)
+    // Vectorized conversion of packed buffers
+    if( nWordCount >= 16 && eSrcType != eDstType &&
+        nSrcPixelStride == nSrcDataTypeSize &&
+        nDstPixelStride == GDALGetDataTypeSizeBytes(eDstType) )
+    {
+        int nDone = 0;
+#ifdef HAVE_AVX2_AT_COMPILE_TIME
+        if( CPLUseAVX2() )
+        {
+            nDone = GDALCopyWordsPackedAVX2(pSrcData, eSrcType,
+                                            pDstData, eDstType, nWordCount);
+        }
+#endif
+#if defined(__x86_64) || defined(_M_X64)
+        if( nDone == 0 )
+        {
+            nDone = GDALCopyWordsPacked<GDALCopyWordsSSE2Ops>(
+                pSrcData, eSrcType, pDstData, eDstType, nWordCount);
+        }
+#endif
+        if( nDone > 0 )
+        {
+            // Convert the remaining values with the scalar code
+            if( nDone < nWordCount )
+            {
+                GDALCopyWords( static_cast<const GByte*>(pSrcData) +
+                                    nDone * nSrcPixelStride,
+                               eSrcType, nSrcPixelStride,
+                               static_cast<GByte*>(pDstData) +
+                                    nDone * nDstPixelStride,
+                               eDstType, nDstPixelStride,
+                               nWordCount - nDone );
+            }
+            return;
+        }
+    }
+#endif
+
     // Handle the more general case -- deals with conversion of data types
     // directly.
     switch (eSrcType)
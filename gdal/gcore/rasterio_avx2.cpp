@@ -0,0 +1,229 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  AVX2 versions of the packed conversions of GDALCopyWords()
+ *
+ ******************************************************************************
+ * Copyright (c) 2016, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_port.h"
+#include "rasterio_simd.hpp"
+
+#ifdef HAVE_AVX2_AT_COMPILE_TIME
+#include <immintrin.h>
+
+#include <climits>
+#include <cstring>
+
+CPL_CVSID("$Id$");
+
+namespace {
+
+/************************************************************************/
+/*                        GDALCopyWordsAVX2Ops                          */
+/************************************************************************/
+
+/* This file must be compiled with -mavx2 (or /arch:AVX2), and its code */
+/* is only run when CPLHaveRuntimeAVX2() is true. */
+
+struct GDALCopyWordsAVX2Ops
+{
+    enum { N = 8 };
+    typedef __m256i IVec;
+    typedef __m256 FVec;
+    struct DVec { __m256d lo; __m256d hi; };
+
+    static inline IVec LoadInt( const GByte* p )
+    {
+        return _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+    }
+    static inline IVec LoadInt( const GUInt16* p )
+    {
+        return _mm256_cvtepu16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+    static inline IVec LoadInt( const GInt16* p )
+    {
+        return _mm256_cvtepi16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+    static inline IVec LoadInt( const GInt32* p )
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    static inline FVec LoadF( const float* p ) { return _mm256_loadu_ps(p); }
+    static inline DVec LoadD( const double* p )
+    {
+        DVec d;
+        d.lo = _mm256_loadu_pd(p);
+        d.hi = _mm256_loadu_pd(p + 4);
+        return d;
+    }
+
+    // Gather the least significant byte (resp. word) of each value in the
+    // first 8 (resp. 16) bytes of the register.
+    static inline void StoreInt( IVec v, GByte* p )
+    {
+        const __m256i shuffle = _mm256_setr_epi8(
+            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        v = _mm256_shuffle_epi8(v, shuffle);
+        v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 4, 0, 0,
+                                                              0, 0, 0, 0));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p),
+                         _mm256_castsi256_si128(v));
+    }
+    static inline void StoreInt16( IVec v, void* p )
+    {
+        const __m256i shuffle = _mm256_setr_epi8(
+            0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1,
+            0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+        v = _mm256_shuffle_epi8(v, shuffle);
+        v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 4, 5,
+                                                              0, 0, 0, 0));
+        _mm_storeu_si128(static_cast<__m128i*>(p), _mm256_castsi256_si128(v));
+    }
+    static inline void StoreInt( IVec v, GUInt16* p ) { StoreInt16(v, p); }
+    static inline void StoreInt( IVec v, GInt16* p ) { StoreInt16(v, p); }
+    static inline void StoreInt( IVec v, GInt32* p )
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+    }
+    static inline void StoreF( FVec f, float* p ) { _mm256_storeu_ps(p, f); }
+    static inline void StoreD( const DVec& d, double* p )
+    {
+        _mm256_storeu_pd(p, d.lo);
+        _mm256_storeu_pd(p + 4, d.hi);
+    }
+
+    static inline FVec IntToF( IVec v ) { return _mm256_cvtepi32_ps(v); }
+    static inline DVec IntToD( IVec v )
+    {
+        DVec d;
+        d.lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v));
+        d.hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1));
+        return d;
+    }
+    static inline DVec FToD( FVec f )
+    {
+        DVec d;
+        d.lo = _mm256_cvtps_pd(_mm256_castps256_ps128(f));
+        d.hi = _mm256_cvtps_pd(_mm256_extractf128_ps(f, 1));
+        return d;
+    }
+    static inline FVec DToF( const DVec& d )
+    {
+        return _mm256_insertf128_ps(
+            _mm256_castps128_ps256(_mm256_cvtpd_ps(d.lo)),
+            _mm256_cvtpd_ps(d.hi), 1);
+    }
+
+    static inline FVec SetF( float f ) { return _mm256_set1_ps(f); }
+    static inline DVec SetD( double df )
+    {
+        DVec d;
+        d.lo = _mm256_set1_pd(df);
+        d.hi = d.lo;
+        return d;
+    }
+    static inline FVec AddF( FVec a, FVec b ) { return _mm256_add_ps(a, b); }
+    static inline DVec AddD( const DVec& a, const DVec& b )
+    {
+        DVec d;
+        d.lo = _mm256_add_pd(a.lo, b.lo);
+        d.hi = _mm256_add_pd(a.hi, b.hi);
+        return d;
+    }
+    static inline FVec RoundAwayF( FVec f )
+    {
+        const FVec sign = _mm256_and_ps(f, _mm256_set1_ps(-0.0f));
+        return _mm256_add_ps(f, _mm256_or_ps(sign, _mm256_set1_ps(0.5f)));
+    }
+    static inline DVec RoundAwayD( const DVec& a )
+    {
+        const __m256d half = _mm256_set1_pd(0.5);
+        const __m256d signmask = _mm256_set1_pd(-0.0);
+        DVec d;
+        d.lo = _mm256_add_pd(a.lo,
+                    _mm256_or_pd(_mm256_and_pd(a.lo, signmask), half));
+        d.hi = _mm256_add_pd(a.hi,
+                    _mm256_or_pd(_mm256_and_pd(a.hi, signmask), half));
+        return d;
+    }
+
+    // max/min return their second operand when one of them is NaN
+    static inline FVec ClampF( FVec f, float fMin, float fMax )
+    {
+        return _mm256_min_ps(_mm256_set1_ps(fMax),
+                             _mm256_max_ps(_mm256_set1_ps(fMin), f));
+    }
+    static inline DVec ClampD( const DVec& a, double dfMin, double dfMax )
+    {
+        const __m256d vmin = _mm256_set1_pd(dfMin);
+        const __m256d vmax = _mm256_set1_pd(dfMax);
+        DVec d;
+        d.lo = _mm256_min_pd(vmax, _mm256_max_pd(vmin, a.lo));
+        d.hi = _mm256_min_pd(vmax, _mm256_max_pd(vmin, a.hi));
+        return d;
+    }
+    static inline IVec ClampInt( IVec v, int nMin, int nMax )
+    {
+        return _mm256_min_epi32(_mm256_set1_epi32(nMax),
+                                _mm256_max_epi32(_mm256_set1_epi32(nMin), v));
+    }
+
+    static inline IVec TruncF( FVec f ) { return _mm256_cvttps_epi32(f); }
+    static inline IVec TruncD( const DVec& d )
+    {
+        return _mm256_insertf128_si256(
+            _mm256_castsi128_si256(_mm256_cvttpd_epi32(d.lo)),
+            _mm256_cvttpd_epi32(d.hi), 1);
+    }
+    static inline IVec OverflowToIntMax( FVec f, IVec v )
+    {
+        const __m256 mask =
+            _mm256_cmp_ps(f, _mm256_set1_ps(2147483648.0f), _CMP_GE_OQ);
+        return _mm256_castps_si256(
+            _mm256_blendv_ps(_mm256_castsi256_ps(v),
+                             _mm256_castsi256_ps(_mm256_set1_epi32(INT_MAX)),
+                             mask));
+    }
+};
+
+} // end anonymous namespace
+
+/************************************************************************/
+/*                      GDALCopyWordsPackedAVX2()                       */
+/************************************************************************/
+
+int GDALCopyWordsPackedAVX2( const void * CPL_RESTRICT pSrcData,
+                             GDALDataType eSrcType,
+                             void * CPL_RESTRICT pDstData,
+                             GDALDataType eDstType, int nWordCount )
+{
+    return GDALCopyWordsPacked<GDALCopyWordsAVX2Ops>(
+        pSrcData, eSrcType, pDstData, eDstType, nWordCount);
+}
+
+#endif // HAVE_AVX2_AT_COMPILE_TIME
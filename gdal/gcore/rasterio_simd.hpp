@@ -0,0 +1,289 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Vectorized conversions between packed buffers for GDALCopyWords()
+ *
+ ******************************************************************************
+ * Copyright (c) 2016, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef RASTERIO_SIMD_HPP_INCLUDED
+#define RASTERIO_SIMD_HPP_INCLUDED
+
+#include "gdal.h"
+
+#include <limits>
+
+/*
+ * The conversion kernels are written once, against an "ops" class that
+ * provides the instruction set specific primitives, and are instantiated in
+ * rasterio.cpp with SSE2 and in rasterio_avx2.cpp with AVX2. An ops class
+ * defines :
+ *  - N, the number of values processed at once, and the IVec, FVec and DVec
+ *    types holding N int32, float and double values.
+ *  - LoadInt() from GByte, GUInt16, GInt16 and GInt32 buffers, LoadF() and
+ *    LoadD().
+ *  - StoreInt() to GByte, GUInt16, GInt16 and GInt32 buffers, keeping the
+ *    least significant bits of each value, StoreF() and StoreD().
+ *  - the IntToF(), IntToD(), FToD() and DToF() conversions.
+ *  - RoundAwayF() / RoundAwayD(), that add 0.5 with the sign of the value,
+ *    AddF() / AddD() and SetF() / SetD().
+ *  - ClampF() / ClampD(), that propagate NaN, and ClampInt().
+ *  - TruncF() / TruncD(), that convert to int32 with truncation, and
+ *    OverflowToIntMax() that sets to INT_MAX the values whose float source
+ *    is >= 2^31.
+ *
+ * The results are identical to the ones of the GDALCopyWord() scalar
+ * versions, including for out of range and NaN values. The kernels of this
+ * file have internal linkage, and do not call the inline functions of
+ * gdal_priv_templates.hpp, so that code compiled with different instruction
+ * sets cannot be mixed up by the linker.
+ */
+
+namespace {
+
+struct GDALSIMDIntTag {};
+struct GDALSIMDFloatTag {};
+struct GDALSIMDDoubleTag {};
+
+template<class T> struct GDALSIMDKind { typedef GDALSIMDIntTag Kind; };
+template<> struct GDALSIMDKind<float> { typedef GDALSIMDFloatTag Kind; };
+template<> struct GDALSIMDKind<double> { typedef GDALSIMDDoubleTag Kind; };
+
+/************************************************************************/
+/*                        GDALSIMDRoundToInt()                          */
+/************************************************************************/
+
+/* Same rounding and clamping as GDALCopyWord(float/double, Tout) */
+
+template<class V, class Tout>
+inline typename V::IVec GDALSIMDRoundToInt( typename V::FVec f )
+{
+    if( !std::numeric_limits<Tout>::is_signed )
+    {
+        return V::TruncF(V::ClampF(V::AddF(f, V::SetF(0.5f)), 0.0f,
+                   static_cast<float>(std::numeric_limits<Tout>::max())));
+    }
+    if( sizeof(Tout) == sizeof(GInt32) )
+        return V::OverflowToIntMax(f, V::TruncF(V::RoundAwayF(f)));
+    return V::TruncF(V::ClampF(V::RoundAwayF(f),
+                   static_cast<float>(std::numeric_limits<Tout>::min()),
+                   static_cast<float>(std::numeric_limits<Tout>::max())));
+}
+
+template<class V, class Tout>
+inline typename V::IVec GDALSIMDRoundToInt( const typename V::DVec& d )
+{
+    if( !std::numeric_limits<Tout>::is_signed )
+    {
+        return V::TruncD(V::ClampD(V::AddD(d, V::SetD(0.5)), 0.0,
+                   static_cast<double>(std::numeric_limits<Tout>::max())));
+    }
+    return V::TruncD(V::ClampD(V::RoundAwayD(d),
+                   static_cast<double>(std::numeric_limits<Tout>::min()),
+                   static_cast<double>(std::numeric_limits<Tout>::max())));
+}
+
+/************************************************************************/
+/*                          GDALSIMDConvert()                           */
+/************************************************************************/
+
+/* Convert V::N values, dispatching on the kind of the input and output */
+/* types. */
+
+template<class V, class Tin, class Tout>
+inline void GDALSIMDConvert( const Tin* pIn, Tout* pOut,
+                             GDALSIMDIntTag, GDALSIMDIntTag )
+{
+    typename V::IVec v = V::LoadInt(pIn);
+    // Clamp only if the input range does not fit in the output one
+    if( static_cast<double>(std::numeric_limits<Tin>::min()) <
+            static_cast<double>(std::numeric_limits<Tout>::min()) ||
+        static_cast<double>(std::numeric_limits<Tin>::max()) >
+            static_cast<double>(std::numeric_limits<Tout>::max()) )
+    {
+        v = V::ClampInt(v, static_cast<int>(std::numeric_limits<Tout>::min()),
+                           static_cast<int>(std::numeric_limits<Tout>::max()));
+    }
+    V::StoreInt(v, pOut);
+}
+
+template<class V, class Tin>
+inline void GDALSIMDConvert( const Tin* pIn, float* pOut,
+                             GDALSIMDIntTag, GDALSIMDFloatTag )
+{
+    V::StoreF(V::IntToF(V::LoadInt(pIn)), pOut);
+}
+
+template<class V, class Tin>
+inline void GDALSIMDConvert( const Tin* pIn, double* pOut,
+                             GDALSIMDIntTag, GDALSIMDDoubleTag )
+{
+    V::StoreD(V::IntToD(V::LoadInt(pIn)), pOut);
+}
+
+template<class V, class Tout>
+inline void GDALSIMDConvert( const float* pIn, Tout* pOut,
+                             GDALSIMDFloatTag, GDALSIMDIntTag )
+{
+    V::StoreInt(GDALSIMDRoundToInt<V, Tout>(V::LoadF(pIn)), pOut);
+}
+
+template<class V>
+inline void GDALSIMDConvert( const float* pIn, float* pOut,
+                             GDALSIMDFloatTag, GDALSIMDFloatTag )
+{
+    V::StoreF(V::LoadF(pIn), pOut);
+}
+
+template<class V>
+inline void GDALSIMDConvert( const float* pIn, double* pOut,
+                             GDALSIMDFloatTag, GDALSIMDDoubleTag )
+{
+    V::StoreD(V::FToD(V::LoadF(pIn)), pOut);
+}
+
+template<class V, class Tout>
+inline void GDALSIMDConvert( const double* pIn, Tout* pOut,
+                             GDALSIMDDoubleTag, GDALSIMDIntTag )
+{
+    V::StoreInt(GDALSIMDRoundToInt<V, Tout>(V::LoadD(pIn)), pOut);
+}
+
+template<class V>
+inline void GDALSIMDConvert( const double* pIn, float* pOut,
+                             GDALSIMDDoubleTag, GDALSIMDFloatTag )
+{
+    V::StoreF(V::DToF(V::LoadD(pIn)), pOut);
+}
+
+template<class V>
+inline void GDALSIMDConvert( const double* pIn, double* pOut,
+                             GDALSIMDDoubleTag, GDALSIMDDoubleTag )
+{
+    V::StoreD(V::LoadD(pIn), pOut);
+}
+
+/************************************************************************/
+/*                      GDALCopyWordsPackedT()                          */
+/************************************************************************/
+
+template<class V, class Tin, class Tout>
+int GDALCopyWordsPackedT( const Tin* const CPL_RESTRICT pSrcData,
+                          Tout* const CPL_RESTRICT pDstData,
+                          int nWordCount )
+{
+    int n = 0;
+    for( ; n <= nWordCount - V::N; n += V::N )
+    {
+        GDALSIMDConvert<V>( pSrcData + n, pDstData + n,
+                            typename GDALSIMDKind<Tin>::Kind(),
+                            typename GDALSIMDKind<Tout>::Kind() );
+    }
+    return n;
+}
+
+template<class V, class Tin>
+int GDALCopyWordsPackedFromT( const Tin* const CPL_RESTRICT pSrcData,
+                              void * CPL_RESTRICT pDstData,
+                              GDALDataType eDstType, int nWordCount )
+{
+    switch( eDstType )
+    {
+        case GDT_Byte:
+            return GDALCopyWordsPackedT<V>(
+                pSrcData, static_cast<GByte*>(pDstData), nWordCount );
+        case GDT_UInt16:
+            return GDALCopyWordsPackedT<V>(
+                pSrcData, static_cast<GUInt16*>(pDstData), nWordCount );
+        case GDT_Int16:
+            return GDALCopyWordsPackedT<V>(
+                pSrcData, static_cast<GInt16*>(pDstData), nWordCount );
+        case GDT_Int32:
+            return GDALCopyWordsPackedT<V>(
+                pSrcData, static_cast<GInt32*>(pDstData), nWordCount );
+        case GDT_Float32:
+            return GDALCopyWordsPackedT<V>(
+                pSrcData, static_cast<float*>(pDstData), nWordCount );
+        case GDT_Float64:
+            return GDALCopyWordsPackedT<V>(
+                pSrcData, static_cast<double*>(pDstData), nWordCount );
+        default:
+            return 0;
+    }
+}
+
+/************************************************************************/
+/*                        GDALCopyWordsPacked()                         */
+/************************************************************************/
+
+/* Convert between packed buffers of Byte, UInt16, Int16, Int32, Float32 */
+/* and Float64 values, by groups of V::N values. Returns the number of    */
+/* values converted, that the caller must complete, or 0 for other types. */
+
+template<class V>
+int GDALCopyWordsPacked( const void * CPL_RESTRICT pSrcData,
+                         GDALDataType eSrcType,
+                         void * CPL_RESTRICT pDstData,
+                         GDALDataType eDstType, int nWordCount )
+{
+    switch( eSrcType )
+    {
+        case GDT_Byte:
+            return GDALCopyWordsPackedFromT<V>(
+                static_cast<const GByte*>(pSrcData), pDstData, eDstType,
+                nWordCount );
+        case GDT_UInt16:
+            return GDALCopyWordsPackedFromT<V>(
+                static_cast<const GUInt16*>(pSrcData), pDstData, eDstType,
+                nWordCount );
+        case GDT_Int16:
+            return GDALCopyWordsPackedFromT<V>(
+                static_cast<const GInt16*>(pSrcData), pDstData, eDstType,
+                nWordCount );
+        case GDT_Int32:
+            return GDALCopyWordsPackedFromT<V>(
+                static_cast<const GInt32*>(pSrcData), pDstData, eDstType,
+                nWordCount );
+        case GDT_Float32:
+            return GDALCopyWordsPackedFromT<V>(
+                static_cast<const float*>(pSrcData), pDstData, eDstType,
+                nWordCount );
+        case GDT_Float64:
+            return GDALCopyWordsPackedFromT<V>(
+                static_cast<const double*>(pSrcData), pDstData, eDstType,
+                nWordCount );
+        default:
+            return 0;
+    }
+}
+
+} // end anonymous namespace
+
+#ifdef HAVE_AVX2_AT_COMPILE_TIME
+int GDALCopyWordsPackedAVX2( const void * CPL_RESTRICT pSrcData,
+                             GDALDataType eSrcType,
+                             void * CPL_RESTRICT pDstData,
+                             GDALDataType eDstType, int nWordCount );
+#endif
+
+#endif // RASTERIO_SIMD_HPP_INCLUDED
@@ -34,6 +34,7 @@
 #include "cpl_conv.h"
 #include "cpl_string.h"
 #include "cpl_multiproc.h"
+#include "cpl_atomic_ops.h"
 
 #ifdef PROJ_STATIC
 #include "proj_api.h"
@@ -115,6 +116,33 @@ void OCTCleanupProjMutex()
     }
 }
 
+/************************************************************************/
+/*                          OGRProj4CTContext                           */
+/************************************************************************/
+
+/* PROJ.4 state of an OGRProj4CT for one thread.  The PROJ.4 handles are */
+/* tied to the context they were created with, that must not be used by */
+/* several threads at the same time. */
+typedef struct
+{
+    projCtx     pjctx;
+    void       *psPJSource;
+    void       *psPJTarget;
+
+    // Buffers for bCheckWithInvertProj.
+    int         nMaxCount;
+    double     *padfOriX;
+    double     *padfOriY;
+    double     *padfOriZ;
+    double     *padfTargetX;
+    double     *padfTargetY;
+    double     *padfTargetZ;
+} OGRProj4CTContext;
+
+/* Maximum number of PROJ.4 contexts kept by a transformation, that is */
+/* of threads that can use it at the same time without a temporary one. */
+#define OGR_PROJ4CT_MAX_CONTEXTS 64
+
 /************************************************************************/
 /*                              OGRProj4CT                              */
 /************************************************************************/
@@ -122,14 +150,12 @@ void OCTCleanupProjMutex()
 class OGRProj4CT : public OGRCoordinateTransformation
 {
     OGRSpatialReference *poSRSSource;
-    void        *psPJSource;
     int         bSourceLatLong;
     double      dfSourceToRadians;
     int         bSourceWrap;
     double      dfSourceWrapLong;
 
     OGRSpatialReference *poSRSTarget;
-    void        *psPJTarget;
     int         bTargetLatLong;
     double      dfTargetFromRadians;
     int         bTargetWrap;
@@ -139,23 +165,30 @@ class OGRProj4CT : public OGRCoordinateTransformation
     //int         bWGS84ToWebMercator;
     int         bWebMercatorToWGS84;
 
-    int         nErrorCount;
+    volatile int nErrorCount;
 
     int         bCheckWithInvertProj;
     double      dfThreshold;
 
-    projCtx     pjctx;
+    // Context created with the transformation, and first one of the pool.
+    OGRProj4CTContext sContext;
+
+    // Pool of contexts checked out by TransformEx() for the duration of a
+    // call, so that the transformation can be used by several threads at
+    // the same time without locking the global PROJ.4 mutex. A slot is
+    // taken by atomically setting its flag, and its context is created on
+    // first use, so the number of contexts is bounded by the number of
+    // concurrent calls and not by the number of threads ever seen.
+    OGRProj4CTContext *apsContextPool[OGR_PROJ4CT_MAX_CONTEXTS];
+    volatile int anContextInUse[OGR_PROJ4CT_MAX_CONTEXTS];
+    CPLString   osSrcProj4Defn;
+    CPLString   osDstProj4Defn;
 
     int         InitializeNoLock( OGRSpatialReference *poSource,
                                   OGRSpatialReference *poTarget );
-
-    int         nMaxCount;
-    double     *padfOriX;
-    double     *padfOriY;
-    double     *padfOriZ;
-    double     *padfTargetX;
-    double     *padfTargetY;
-    double     *padfTargetZ;
+    OGRProj4CTContext *CreateContext();
+    OGRProj4CTContext *CheckOutContext( int *piSlot );
+    void        CheckInContext( OGRProj4CTContext *psContext, int iSlot );
 
 public:
                 OGRProj4CT();
@@ -486,17 +519,46 @@ OCTNewCoordinateTransformation(
 /************************************************************************/
 
 OGRProj4CT::OGRProj4CT() :
-    poSRSSource(NULL), psPJSource(NULL), bSourceLatLong(FALSE),
+    poSRSSource(NULL), bSourceLatLong(FALSE),
     dfSourceToRadians(0.0), bSourceWrap(FALSE), dfSourceWrapLong(0.0),
-    poSRSTarget(NULL), psPJTarget(NULL), bTargetLatLong(FALSE),
+    poSRSTarget(NULL), bTargetLatLong(FALSE),
     dfTargetFromRadians(0.0), bTargetWrap(FALSE), dfTargetWrapLong(0.0),
     bIdentityTransform(FALSE), bWebMercatorToWGS84(FALSE), nErrorCount(0),
-    bCheckWithInvertProj(FALSE), dfThreshold(0.0), pjctx(NULL), nMaxCount(0),
-    padfOriX(NULL), padfOriY(NULL), padfOriZ(NULL), padfTargetX(NULL),
-    padfTargetY(NULL), padfTargetZ(NULL)
+    bCheckWithInvertProj(FALSE), dfThreshold(0.0)
 {
+    memset(&sContext, 0, sizeof(sContext));
     if (pfn_pj_ctx_alloc != NULL)
-        pjctx = pfn_pj_ctx_alloc();
+        sContext.pjctx = pfn_pj_ctx_alloc();
+
+    for( int i = 0; i < OGR_PROJ4CT_MAX_CONTEXTS; i++ )
+    {
+        apsContextPool[i] = NULL;
+        anContextInUse[i] = 0;
+    }
+    apsContextPool[0] = &sContext;
+}
+
+/************************************************************************/
+/*                       OGRProj4CTFreeContext()                        */
+/************************************************************************/
+
+static void OGRProj4CTFreeContext( OGRProj4CTContext *psContext )
+{
+    if( psContext->psPJSource != NULL )
+        pfn_pj_free( psContext->psPJSource );
+
+    if( psContext->psPJTarget != NULL )
+        pfn_pj_free( psContext->psPJTarget );
+
+    if( psContext->pjctx != NULL )
+        pfn_pj_ctx_free( psContext->pjctx );
+
+    CPLFree( psContext->padfOriX );
+    CPLFree( psContext->padfOriY );
+    CPLFree( psContext->padfOriZ );
+    CPLFree( psContext->padfTargetX );
+    CPLFree( psContext->padfTargetY );
+    CPLFree( psContext->padfTargetZ );
 }
 
 /************************************************************************/
@@ -518,33 +580,24 @@ OGRProj4CT::~OGRProj4CT()
             delete poSRSTarget;
     }
 
-    if (pjctx != NULL)
+    if (sContext.pjctx != NULL)
     {
-        pfn_pj_ctx_free(pjctx);
-
-        if( psPJSource != NULL )
-            pfn_pj_free( psPJSource );
-
-        if( psPJTarget != NULL )
-            pfn_pj_free( psPJTarget );
+        OGRProj4CTFreeContext( &sContext );
     }
     else
     {
         CPLMutexHolderD( &hPROJMutex );
-
-        if( psPJSource != NULL )
-            pfn_pj_free( psPJSource );
-
-        if( psPJTarget != NULL )
-            pfn_pj_free( psPJTarget );
+        OGRProj4CTFreeContext( &sContext );
     }
 
-    CPLFree(padfOriX);
-    CPLFree(padfOriY);
-    CPLFree(padfOriZ);
-    CPLFree(padfTargetX);
-    CPLFree(padfTargetY);
-    CPLFree(padfTargetZ);
+    for( int i = 1; i < OGR_PROJ4CT_MAX_CONTEXTS; i++ )
+    {
+        if( apsContextPool[i] != NULL )
+        {
+            OGRProj4CTFreeContext( apsContextPool[i] );
+            delete apsContextPool[i];
+        }
+    }
 }
 
 /************************************************************************/
@@ -561,7 +614,7 @@ int OGRProj4CT::Initialize( OGRSpatialReference * poSourceIn,
     }
 
     CPLLocaleC  oLocaleEnforcer;
-    if (pjctx != NULL)
+    if (sContext.pjctx != NULL)
     {
         return InitializeNoLock(poSourceIn, poTargetIn);
     }
@@ -782,16 +835,16 @@ int OGRProj4CT::InitializeNoLock( OGRSpatialReference * poSourceIn,
 /* -------------------------------------------------------------------- */
     if( !bWebMercatorToWGS84 )
     {
-        if (pjctx)
-            psPJSource = pfn_pj_init_plus_ctx( pjctx, pszSrcProj4Defn );
+        if (sContext.pjctx)
+            sContext.psPJSource = pfn_pj_init_plus_ctx( sContext.pjctx, pszSrcProj4Defn );
         else
-            psPJSource = pfn_pj_init_plus( pszSrcProj4Defn );
+            sContext.psPJSource = pfn_pj_init_plus( pszSrcProj4Defn );
 
-        if( psPJSource == NULL )
+        if( sContext.psPJSource == NULL )
         {
-            if( pjctx != NULL)
+            if( sContext.pjctx != NULL)
             {
-                int pj_errno = pfn_pj_ctx_get_errno(pjctx);
+                int pj_errno = pfn_pj_ctx_get_errno(sContext.pjctx);
 
                 /* pfn_pj_strerrno not yet thread-safe in PROJ 4.8.0 */
                 CPLMutexHolderD(&hPROJMutex);
@@ -820,7 +873,7 @@ int OGRProj4CT::InitializeNoLock( OGRSpatialReference * poSourceIn,
     if( nDebugReportCount < 10 )
         CPLDebug( "OGRCT", "Source: %s", pszSrcProj4Defn );
 
-    if( !bWebMercatorToWGS84 && psPJSource == NULL )
+    if( !bWebMercatorToWGS84 && sContext.psPJSource == NULL )
     {
         CPLFree( pszSrcProj4Defn );
         CPLFree( pszDstProj4Defn );
@@ -832,12 +885,12 @@ int OGRProj4CT::InitializeNoLock( OGRSpatialReference * poSourceIn,
 /* -------------------------------------------------------------------- */
     if( !bWebMercatorToWGS84 )
     {
-        if (pjctx)
-            psPJTarget = pfn_pj_init_plus_ctx( pjctx, pszDstProj4Defn );
+        if (sContext.pjctx)
+            sContext.psPJTarget = pfn_pj_init_plus_ctx( sContext.pjctx, pszDstProj4Defn );
         else
-            psPJTarget = pfn_pj_init_plus( pszDstProj4Defn );
+            sContext.psPJTarget = pfn_pj_init_plus( pszDstProj4Defn );
 
-        if( psPJTarget == NULL )
+        if( sContext.psPJTarget == NULL )
             CPLError( CE_Failure, CPLE_NotSupported,
                     "Failed to initialize PROJ.4 with `%s'.",
                     pszDstProj4Defn );
@@ -848,7 +901,7 @@ int OGRProj4CT::InitializeNoLock( OGRSpatialReference * poSourceIn,
         nDebugReportCount++;
     }
 
-    if( !bWebMercatorToWGS84 && psPJTarget == NULL )
+    if( !bWebMercatorToWGS84 && sContext.psPJTarget == NULL )
     {
         CPLFree( pszSrcProj4Defn );
         CPLFree( pszDstProj4Defn );
@@ -858,6 +911,10 @@ int OGRProj4CT::InitializeNoLock( OGRSpatialReference * poSourceIn,
     /* Determine if we really have a transformation to do */
     bIdentityTransform = (strcmp(pszSrcProj4Defn, pszDstProj4Defn) == 0);
 
+    /* Kept to create the other contexts of the pool */
+    osSrcProj4Defn = pszSrcProj4Defn;
+    osDstProj4Defn = pszDstProj4Defn;
+
 #if 0
     /* In case of identity transform, under the following conditions, */
     /* we can also avoid transforming from degrees <--> radians. */
@@ -896,6 +953,90 @@ OGRSpatialReference *OGRProj4CT::GetTargetCS()
     return poSRSTarget;
 }
 
+/************************************************************************/
+/*                           CreateContext()                            */
+/************************************************************************/
+
+/* Create a PROJ.4 context, with its own source and target projections. */
+OGRProj4CTContext *OGRProj4CT::CreateContext()
+
+{
+    OGRProj4CTContext *psContext = new OGRProj4CTContext;
+    memset(psContext, 0, sizeof(OGRProj4CTContext));
+    psContext->pjctx = pfn_pj_ctx_alloc();
+    if( psContext->pjctx != NULL )
+    {
+        CPLLocaleC *poLocaleEnforcer =
+            bProjLocaleSafe ? NULL : new CPLLocaleC();
+        psContext->psPJSource =
+            pfn_pj_init_plus_ctx( psContext->pjctx, osSrcProj4Defn );
+        psContext->psPJTarget =
+            pfn_pj_init_plus_ctx( psContext->pjctx, osDstProj4Defn );
+        delete poLocaleEnforcer;
+    }
+    if( psContext->psPJSource == NULL || psContext->psPJTarget == NULL )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Failed to initialize PROJ.4 for the current thread." );
+        OGRProj4CTFreeContext( psContext );
+        delete psContext;
+        return NULL;
+    }
+
+    return psContext;
+}
+
+/************************************************************************/
+/*                          CheckOutContext()                           */
+/************************************************************************/
+
+/* Take the first free context of the pool, and create it if that slot */
+/* was never used. When all the slots are busy, a temporary context is */
+/* created, and *piSlot is set to -1. */
+OGRProj4CTContext *OGRProj4CT::CheckOutContext( int *piSlot )
+
+{
+    for( int i = 0; i < OGR_PROJ4CT_MAX_CONTEXTS; i++ )
+    {
+        if( anContextInUse[i] == 0 &&
+            CPLAtomicCompareAndExchange(&anContextInUse[i], 0, 1) )
+        {
+            if( apsContextPool[i] == NULL )
+            {
+                apsContextPool[i] = CreateContext();
+                if( apsContextPool[i] == NULL )
+                {
+                    CPLAtomicDec(&anContextInUse[i]);
+                    return NULL;
+                }
+            }
+            *piSlot = i;
+            return apsContextPool[i];
+        }
+    }
+
+    *piSlot = -1;
+    return CreateContext();
+}
+
+/************************************************************************/
+/*                           CheckInContext()                           */
+/************************************************************************/
+
+void OGRProj4CT::CheckInContext( OGRProj4CTContext *psContext, int iSlot )
+
+{
+    if( iSlot < 0 )
+    {
+        OGRProj4CTFreeContext( psContext );
+        delete psContext;
+    }
+    else
+    {
+        CPLAtomicDec(&anContextInUse[iSlot]);
+    }
+}
+
 /************************************************************************/
 /*                             Transform()                              */
 /*                                                                      */
@@ -1039,14 +1180,28 @@ int OGRProj4CT::TransformEx( int nCount, double *x, double *y, double *z,
         bTransformDone = true;
 
 /* -------------------------------------------------------------------- */
-/*      Do the transformation (or not...) using PROJ.4.                 */
+/*      Do the transformation (or not...) using PROJ.4.  Without        */
+/*      PROJ.4 contexts, the global mutex must be held.  Otherwise,     */
+/*      a context is checked out of the pool for the call.              */
 /* -------------------------------------------------------------------- */
-    if( !bTransformDone && pjctx == NULL )
+    OGRProj4CTContext *psContext = &sContext;
+    int iContextSlot = -1;
+    if( !bTransformDone && sContext.pjctx == NULL )
     {
         /* The mutex has already been created */
         CPLAssert(hPROJMutex != NULL);
         CPLAcquireMutex(hPROJMutex, 1000.0);
     }
+    else if( !bTransformDone )
+    {
+        psContext = CheckOutContext(&iContextSlot);
+        if( psContext == NULL )
+        {
+            if( pabSuccess )
+                memset( pabSuccess, 0, sizeof(int) * nCount );
+            return FALSE;
+        }
+    }
 
     if( bTransformDone )
         err = 0;
@@ -1055,23 +1210,31 @@ int OGRProj4CT::TransformEx( int nCount, double *x, double *y, double *z,
         /* For some projections, we cannot detect if we are trying to reproject */
         /* coordinates outside the validity area of the projection. So let's do */
         /* the reverse reprojection and compare with the source coordinates */
-        if (nCount > nMaxCount)
+        if (nCount > psContext->nMaxCount)
         {
-            nMaxCount = nCount;
-            padfOriX = (double*) CPLRealloc(padfOriX, sizeof(double)*nCount);
-            padfOriY = (double*) CPLRealloc(padfOriY, sizeof(double)*nCount);
-            padfOriZ = (double*) CPLRealloc(padfOriZ, sizeof(double)*nCount);
-            padfTargetX = (double*) CPLRealloc(padfTargetX, sizeof(double)*nCount);
-            padfTargetY = (double*) CPLRealloc(padfTargetY, sizeof(double)*nCount);
-            padfTargetZ = (double*) CPLRealloc(padfTargetZ, sizeof(double)*nCount);
+            psContext->nMaxCount = nCount;
+            psContext->padfOriX = (double*) CPLRealloc(psContext->padfOriX, sizeof(double)*nCount);
+            psContext->padfOriY = (double*) CPLRealloc(psContext->padfOriY, sizeof(double)*nCount);
+            psContext->padfOriZ = (double*) CPLRealloc(psContext->padfOriZ, sizeof(double)*nCount);
+            psContext->padfTargetX = (double*) CPLRealloc(psContext->padfTargetX, sizeof(double)*nCount);
+            psContext->padfTargetY = (double*) CPLRealloc(psContext->padfTargetY, sizeof(double)*nCount);
+            psContext->padfTargetZ = (double*) CPLRealloc(psContext->padfTargetZ, sizeof(double)*nCount);
         }
+        double *padfOriX = psContext->padfOriX;
+        double *padfOriY = psContext->padfOriY;
+        double *padfOriZ = psContext->padfOriZ;
+        double *padfTargetX = psContext->padfTargetX;
+        double *padfTargetY = psContext->padfTargetY;
+        double *padfTargetZ = psContext->padfTargetZ;
+
         memcpy(padfOriX, x, sizeof(double)*nCount);
         memcpy(padfOriY, y, sizeof(double)*nCount);
         if (z)
         {
             memcpy(padfOriZ, z, sizeof(double)*nCount);
         }
-        err = pfn_pj_transform( psPJSource, psPJTarget, nCount, 1, x, y, z );
+        err = pfn_pj_transform( psContext->psPJSource, psContext->psPJTarget,
+                                nCount, 1, x, y, z );
         if (err == 0)
         {
             memcpy(padfTargetX, x, sizeof(double)*nCount);
@@ -1081,7 +1244,8 @@ int OGRProj4CT::TransformEx( int nCount, double *x, double *y, double *z,
                 memcpy(padfTargetZ, z, sizeof(double)*nCount);
             }
 
-            err = pfn_pj_transform( psPJTarget, psPJSource , nCount, 1,
+            err = pfn_pj_transform( psContext->psPJTarget, psContext->psPJSource,
+                                    nCount, 1,
                                     padfTargetX, padfTargetY, (z) ? padfTargetZ : NULL);
             if (err == 0)
             {
@@ -1100,9 +1264,13 @@ int OGRProj4CT::TransformEx( int nCount, double *x, double *y, double *z,
     }
     else
     {
-        err = pfn_pj_transform( psPJSource, psPJTarget, nCount, 1, x, y, z );
+        err = pfn_pj_transform( psContext->psPJSource, psContext->psPJTarget,
+                                nCount, 1, x, y, z );
     }
 
+    if( !bTransformDone && sContext.pjctx != NULL )
+        CheckInContext( psContext, iContextSlot );
+
 /* -------------------------------------------------------------------- */
 /*      Try to report an error through CPL.  Get proj.4 error string    */
 /*      if possible.  Try to avoid reporting thousands of error         */
@@ -1114,9 +1282,10 @@ int OGRProj4CT::TransformEx( int nCount, double *x, double *y, double *z,
         if( pabSuccess )
             memset( pabSuccess, 0, sizeof(int) * nCount );
 
-        if( ++nErrorCount < 20 )
+        const int nErrors = CPLAtomicInc(&nErrorCount);
+        if( nErrors < 20 )
         {
-            if (pjctx != NULL)
+            if (sContext.pjctx != NULL)
                 /* pfn_pj_strerrno not yet thread-safe in PROJ 4.8.0 */
                 CPLAcquireMutex(hPROJMutex, 1000.0);
 
@@ -1131,23 +1300,23 @@ int OGRProj4CT::TransformEx( int nCount, double *x, double *y, double *z,
             else
                 CPLError( CE_Failure, CPLE_AppDefined, "%s", pszError );
 
-            if (pjctx != NULL)
+            if (sContext.pjctx != NULL)
                 /* pfn_pj_strerrno not yet thread-safe in PROJ 4.8.0 */
                 CPLReleaseMutex(hPROJMutex);
         }
-        else if( nErrorCount == 20 )
+        else if( nErrors == 20 )
         {
             CPLError( CE_Failure, CPLE_AppDefined,
                       "Reprojection failed, err = %d, further errors will be suppressed on the transform object.",
                       err );
         }
 
-        if (pjctx == NULL)
+        if (sContext.pjctx == NULL)
             CPLReleaseMutex(hPROJMutex);
         return FALSE;
     }
 
-    if( !bTransformDone && pjctx == NULL )
+    if( !bTransformDone && sContext.pjctx == NULL )
         CPLReleaseMutex(hPROJMutex);
 
 /* -------------------------------------------------------------------- */
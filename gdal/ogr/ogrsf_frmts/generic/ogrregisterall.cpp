@@ -41,261 +41,269 @@ void OGRRegisterAll()
     GDALAllRegister();
 }
 
+/************************************************************************/
+/*                       OGRRegisterAllInternal()                       */
+/************************************************************************/
+
 void OGRRegisterAllInternal()
 {
+    // See GDALAllRegister()
+    const bool bDeferred = CPLTestBool(
+        CPLGetConfigOption("GDAL_DEFERRED_DRIVER_REGISTRATION", "NO") );
+
 #ifdef DB2_ENABLED
-    RegisterOGRDB2();
+    GDALRegisterOrDeferDriver( bDeferred, "DB2ODBC", RegisterOGRDB2 );
 #endif
 #ifdef SHAPE_ENABLED
-    RegisterOGRShape();
+    GDALRegisterOrDeferDriver( bDeferred, "ESRI Shapefile", RegisterOGRShape );
 #endif
 #ifdef TAB_ENABLED
-    RegisterOGRTAB();
+    GDALRegisterOrDeferDriver( bDeferred, "MapInfo File", RegisterOGRTAB );
 #endif
 #ifdef NTF_ENABLED
-    RegisterOGRNTF();
+    GDALRegisterOrDeferDriver( bDeferred, "UK .NTF", RegisterOGRNTF );
 #endif
 #ifdef SDTS_ENABLED
-    RegisterOGRSDTS();
+    GDALRegisterOrDeferDriver( bDeferred, "OGR_SDTS", RegisterOGRSDTS );
 #endif
 #ifdef S57_ENABLED
-    RegisterOGRS57();
+    GDALRegisterOrDeferDriver( bDeferred, "S57", RegisterOGRS57 );
 #endif
 #ifdef DGN_ENABLED
-    RegisterOGRDGN();
+    GDALRegisterOrDeferDriver( bDeferred, "DGN", RegisterOGRDGN );
 #endif
 #ifdef VRT_ENABLED
-    RegisterOGRVRT();
+    GDALRegisterOrDeferDriver( bDeferred, "OGR_VRT", RegisterOGRVRT );
 #endif
 #ifdef REC_ENABLED
-    RegisterOGRREC();
+    GDALRegisterOrDeferDriver( bDeferred, "REC", RegisterOGRREC );
 #endif
 #ifdef MEM_ENABLED
-    RegisterOGRMEM();
+    GDALRegisterOrDeferDriver( bDeferred, "Memory", RegisterOGRMEM );
 #endif
 #ifdef BNA_ENABLED
-    RegisterOGRBNA();
+    GDALRegisterOrDeferDriver( bDeferred, "BNA", RegisterOGRBNA );
 #endif
 #ifdef CSV_ENABLED
-    RegisterOGRCSV();
+    GDALRegisterOrDeferDriver( bDeferred, "CSV", RegisterOGRCSV );
 #endif
 #ifdef NAS_ENABLED
-    RegisterOGRNAS();
+    GDALRegisterOrDeferDriver( bDeferred, "NAS", RegisterOGRNAS );
 #endif
 #ifdef GML_ENABLED
-    RegisterOGRGML();
+    GDALRegisterOrDeferDriver( bDeferred, "GML", RegisterOGRGML );
 #endif
 #ifdef GPX_ENABLED
-    RegisterOGRGPX();
+    GDALRegisterOrDeferDriver( bDeferred, "GPX", RegisterOGRGPX );
 #endif
 #ifdef LIBKML_ENABLED
-    RegisterOGRLIBKML();
+    GDALRegisterOrDeferDriver( bDeferred, "LIBKML", RegisterOGRLIBKML );
 #endif
 #ifdef KML_ENABLED
-    RegisterOGRKML();
+    GDALRegisterOrDeferDriver( bDeferred, "KML", RegisterOGRKML );
 #endif
 #ifdef GEOJSON_ENABLED
-    RegisterOGRGeoJSON();
+    GDALRegisterOrDeferDriver( bDeferred, "GeoJSON", RegisterOGRGeoJSON );
 #endif
 #ifdef ILI_ENABLED
-    RegisterOGRILI1();
-    RegisterOGRILI2();
+    GDALRegisterOrDeferDriver( bDeferred, "Interlis 1", RegisterOGRILI1 );
+    GDALRegisterOrDeferDriver( bDeferred, "Interlis 2", RegisterOGRILI2 );
 #endif
 #ifdef GMT_ENABLED
-    RegisterOGRGMT();
+    GDALRegisterOrDeferDriver( bDeferred, "OGR_GMT", RegisterOGRGMT );
 #endif
 #ifdef SQLITE_ENABLED
-    RegisterOGRGeoPackage();
-    RegisterOGRSQLite();
+    GDALRegisterOrDeferDriver( bDeferred, "GPKG", RegisterOGRGeoPackage );
+    GDALRegisterOrDeferDriver( bDeferred, "SQLite", RegisterOGRSQLite );
 #endif
 #ifdef DODS_ENABLED
-    RegisterOGRDODS();
+    GDALRegisterOrDeferDriver( bDeferred, "OGR_DODS", RegisterOGRDODS );
 #endif
 #ifdef ODBC_ENABLED
-    RegisterOGRODBC();
+    GDALRegisterOrDeferDriver( bDeferred, "ODBC", RegisterOGRODBC );
 #endif
 #ifdef WASP_ENABLED
-    RegisterOGRWAsP();
+    GDALRegisterOrDeferDriver( bDeferred, "WAsP", RegisterOGRWAsP );
 #endif
 
 /* Register before PGeo and Geomedia drivers */
 /* that don't work well on Linux */
 #ifdef MDB_ENABLED
-    RegisterOGRMDB();
+    GDALRegisterOrDeferDriver( bDeferred, "MDB", RegisterOGRMDB );
 #endif
 
 #ifdef PGEO_ENABLED
-    RegisterOGRPGeo();
+    GDALRegisterOrDeferDriver( bDeferred, "PGeo", RegisterOGRPGeo );
 #endif
 #ifdef MSSQLSPATIAL_ENABLED
-    RegisterOGRMSSQLSpatial();
+    GDALRegisterOrDeferDriver( bDeferred, "MSSQLSpatial", RegisterOGRMSSQLSpatial );
 #endif
 #ifdef OGDI_ENABLED
-    RegisterOGROGDI();
+    GDALRegisterOrDeferDriver( bDeferred, "OGR_OGDI", RegisterOGROGDI );
 #endif
 #ifdef PG_ENABLED
-    RegisterOGRPG();
+    GDALRegisterOrDeferDriver( bDeferred, "PostgreSQL", RegisterOGRPG );
 #endif
 #ifdef MYSQL_ENABLED
-    RegisterOGRMySQL();
+    GDALRegisterOrDeferDriver( bDeferred, "MySQL", RegisterOGRMySQL );
 #endif
 #ifdef OCI_ENABLED
-    RegisterOGROCI();
+    GDALRegisterOrDeferDriver( bDeferred, "OCI", RegisterOGROCI );
 #endif
 #ifdef INGRES_ENABLED
-    RegisterOGRIngres();
+    GDALRegisterOrDeferDriver( bDeferred, "Ingres", RegisterOGRIngres );
 #endif
 #ifdef SDE_ENABLED
-    RegisterOGRSDE();
+    GDALRegisterOrDeferDriver( bDeferred, "SDE", RegisterOGRSDE );
 #endif
 /* Register OpenFileGDB before FGDB as it is more capable for read-only */
 #ifdef OPENFILEGDB_ENABLED
-    RegisterOGROpenFileGDB();
+    GDALRegisterOrDeferDriver( bDeferred, "OpenFileGDB", RegisterOGROpenFileGDB );
 #endif
 #ifdef FGDB_ENABLED
-    RegisterOGRFileGDB();
+    GDALRegisterOrDeferDriver( bDeferred, "FileGDB", RegisterOGRFileGDB );
 #endif
 #ifdef XPLANE_ENABLED
-    RegisterOGRXPlane();
+    GDALRegisterOrDeferDriver( bDeferred, "XPlane", RegisterOGRXPlane );
 #endif
 #ifdef DWGDIRECT_ENABLED
-    RegisterOGRDXFDWG();
+    GDALRegisterOrDeferDriver( bDeferred, "DWG", RegisterOGRDXFDWG );
 #endif
 #ifdef DXF_ENABLED
-    RegisterOGRDXF();
+    GDALRegisterOrDeferDriver( bDeferred, "DXF", RegisterOGRDXF );
 #endif
 #ifdef GRASS_ENABLED
-    RegisterOGRGRASS();
+    GDALRegisterOrDeferDriver( bDeferred, "GRASS", RegisterOGRGRASS );
 #endif
 #ifdef FME_ENABLED
-    RegisterOGRFME();
+    GDALRegisterOrDeferDriver( bDeferred, "FMEObjects Gateway", RegisterOGRFME );
 #endif
 #ifdef IDB_ENABLED
-    RegisterOGRIDB();
+    GDALRegisterOrDeferDriver( bDeferred, "IDB", RegisterOGRIDB );
 #endif
 #ifdef GEOCONCEPT_ENABLED
-    RegisterOGRGeoconcept();
+    GDALRegisterOrDeferDriver( bDeferred, "Geoconcept", RegisterOGRGeoconcept );
 #endif
 #ifdef GEORSS_ENABLED
-    RegisterOGRGeoRSS();
+    GDALRegisterOrDeferDriver( bDeferred, "GeoRSS", RegisterOGRGeoRSS );
 #endif
 #ifdef GTM_ENABLED
-    RegisterOGRGTM();
+    GDALRegisterOrDeferDriver( bDeferred, "GPSTrackMaker", RegisterOGRGTM );
 #endif
 #ifdef VFK_ENABLED
-    RegisterOGRVFK();
+    GDALRegisterOrDeferDriver( bDeferred, "VFK", RegisterOGRVFK );
 #endif
 #ifdef PGDUMP_ENABLED
-    RegisterOGRPGDump();
+    GDALRegisterOrDeferDriver( bDeferred, "PGDUMP", RegisterOGRPGDump );
 #endif
 #ifdef OSM_ENABLED
     /* Register before GPSBabel, that could recognize .osm file too */
-    RegisterOGROSM();
+    GDALRegisterOrDeferDriver( bDeferred, "OSM", RegisterOGROSM );
 #endif
 #ifdef GPSBABEL_ENABLED
-    RegisterOGRGPSBabel();
+    GDALRegisterOrDeferDriver( bDeferred, "GPSBabel", RegisterOGRGPSBabel );
 #endif
 #ifdef SUA_ENABLED
-    RegisterOGRSUA();
+    GDALRegisterOrDeferDriver( bDeferred, "SUA", RegisterOGRSUA );
 #endif
 #ifdef OPENAIR_ENABLED
-    RegisterOGROpenAir();
+    GDALRegisterOrDeferDriver( bDeferred, "OpenAir", RegisterOGROpenAir );
 #endif
 #ifdef PDS_ENABLED
-    RegisterOGRPDS();
+    GDALRegisterOrDeferDriver( bDeferred, "OGR_PDS", RegisterOGRPDS );
 #endif
 #ifdef WFS_ENABLED
-    RegisterOGRWFS();
+    GDALRegisterOrDeferDriver( bDeferred, "WFS", RegisterOGRWFS );
 #endif
 #ifdef SOSI_ENABLED
-    RegisterOGRSOSI();
+    GDALRegisterOrDeferDriver( bDeferred, "SOSI", RegisterOGRSOSI );
 #endif
 #ifdef HTF_ENABLED
-    RegisterOGRHTF();
+    GDALRegisterOrDeferDriver( bDeferred, "HTF", RegisterOGRHTF );
 #endif
 #ifdef AERONAVFAA_ENABLED
-    RegisterOGRAeronavFAA();
+    GDALRegisterOrDeferDriver( bDeferred, "AeronavFAA", RegisterOGRAeronavFAA );
 #endif
 #ifdef GEOMEDIA_ENABLED
-    RegisterOGRGeomedia();
+    GDALRegisterOrDeferDriver( bDeferred, "Geomedia", RegisterOGRGeomedia );
 #endif
 #ifdef EDIGEO_ENABLED
-    RegisterOGREDIGEO();
+    GDALRegisterOrDeferDriver( bDeferred, "EDIGEO", RegisterOGREDIGEO );
 #endif
 #ifdef GFT_ENABLED
-    RegisterOGRGFT();
+    GDALRegisterOrDeferDriver( bDeferred, "GFT", RegisterOGRGFT );
 #endif
 #ifdef SVG_ENABLED
-    RegisterOGRSVG();
+    GDALRegisterOrDeferDriver( bDeferred, "SVG", RegisterOGRSVG );
 #endif
 #ifdef COUCHDB_ENABLED
-    RegisterOGRCouchDB();
+    GDALRegisterOrDeferDriver( bDeferred, "CouchDB", RegisterOGRCouchDB );
 #endif
 #ifdef CLOUDANT_ENABLED
-    RegisterOGRCloudant();
+    GDALRegisterOrDeferDriver( bDeferred, "Cloudant", RegisterOGRCloudant );
 #endif
 #ifdef IDRISI_ENABLED
-    RegisterOGRIdrisi();
+    GDALRegisterOrDeferDriver( bDeferred, "Idrisi", RegisterOGRIdrisi );
 #endif
 #ifdef ARCGEN_ENABLED
-    RegisterOGRARCGEN();
+    GDALRegisterOrDeferDriver( bDeferred, "ARCGEN", RegisterOGRARCGEN );
 #endif
 #ifdef SEGUKOOA_ENABLED
-    RegisterOGRSEGUKOOA();
+    GDALRegisterOrDeferDriver( bDeferred, "SEGUKOOA", RegisterOGRSEGUKOOA );
 #endif
 #ifdef SEGY_ENABLED
-    RegisterOGRSEGY();
+    GDALRegisterOrDeferDriver( bDeferred, "SEGY", RegisterOGRSEGY );
 #endif
 #ifdef FREEXL_ENABLED
-    RegisterOGRXLS();
+    GDALRegisterOrDeferDriver( bDeferred, "XLS", RegisterOGRXLS );
 #endif
 #ifdef ODS_ENABLED
-    RegisterOGRODS();
+    GDALRegisterOrDeferDriver( bDeferred, "ODS", RegisterOGRODS );
 #endif
 #ifdef XLSX_ENABLED
-    RegisterOGRXLSX();
+    GDALRegisterOrDeferDriver( bDeferred, "XLSX", RegisterOGRXLSX );
 #endif
 #ifdef ELASTIC_ENABLED
-    RegisterOGRElastic();
+    GDALRegisterOrDeferDriver( bDeferred, "ElasticSearch", RegisterOGRElastic );
 #endif
 #ifdef WALK_ENABLED
-    RegisterOGRWalk();
+    GDALRegisterOrDeferDriver( bDeferred, "Walk", RegisterOGRWalk );
 #endif
 #ifdef CARTO_ENABLED
-    RegisterOGRCarto();
+    GDALRegisterOrDeferDriver( bDeferred, "Carto", RegisterOGRCarto );
 #endif
 #ifdef AMIGOCLOUD_ENABLED
-    RegisterOGRAmigoCloud();
+    GDALRegisterOrDeferDriver( bDeferred, "AmigoCloud", RegisterOGRAmigoCloud );
 #endif
 #ifdef SXF_ENABLED
-    RegisterOGRSXF();
+    GDALRegisterOrDeferDriver( bDeferred, "SXF", RegisterOGRSXF );
 #endif
 #ifdef SELAFIN_ENABLED
-    RegisterOGRSelafin();
+    GDALRegisterOrDeferDriver( bDeferred, "Selafin", RegisterOGRSelafin );
 #endif
 #ifdef JML_ENABLED
-    RegisterOGRJML();
+    GDALRegisterOrDeferDriver( bDeferred, "JML", RegisterOGRJML );
 #endif
 #ifdef PLSCENES_ENABLED
-    RegisterOGRPLSCENES();
+    GDALRegisterOrDeferDriver( bDeferred, "PLSCENES", RegisterOGRPLSCENES );
 #endif
 #ifdef CSW_ENABLED
-    RegisterOGRCSW();
+    GDALRegisterOrDeferDriver( bDeferred, "CSW", RegisterOGRCSW );
 #endif
 #ifdef MONGODB_ENABLED
-    RegisterOGRMongoDB();
+    GDALRegisterOrDeferDriver( bDeferred, "MongoDB", RegisterOGRMongoDB );
 #endif
 #ifdef VDV_ENABLED
-    RegisterOGRVDV();
+    GDALRegisterOrDeferDriver( bDeferred, "VDV", RegisterOGRVDV );
 #endif
 
 /* Put TIGER and AVCBIN at end since they need poOpenInfo->GetSiblingFiles() */
 #ifdef TIGER_ENABLED
-    RegisterOGRTiger();
+    GDALRegisterOrDeferDriver( bDeferred, "TIGER", RegisterOGRTiger );
 #endif
 #ifdef AVCBIN_ENABLED
-    RegisterOGRAVCBin();
-    RegisterOGRAVCE00();
+    GDALRegisterOrDeferDriver( bDeferred, "AVCBin", RegisterOGRAVCBin );
+    GDALRegisterOrDeferDriver( bDeferred, "AVCE00", RegisterOGRAVCE00 );
 #endif
 
 } /* OGRRegisterAll */
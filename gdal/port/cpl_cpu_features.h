@@ -0,0 +1,53 @@
+/**********************************************************************
+ * $Id$
+ *
+ * Project:  CPL - Common Portability Library
+ * Purpose:  Runtime detection of CPU instruction set extensions
+ * Author:   Even Rouault, <even dot rouault at mines-paris dot org>
+ *
+ **********************************************************************
+ * Copyright (c) 2009-2013, Even Rouault <even dot rouault at mines-paris dot org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef CPL_CPU_FEATURES_H_INCLUDED
+#define CPL_CPU_FEATURES_H_INCLUDED
+
+#include "cpl_port.h"
+
+//! @cond Doxygen_Suppress
+
+/* Return TRUE if the running CPU, and the OS, support the instruction set. */
+/* The code that uses it must also have been compiled with the appropriate */
+/* flags (HAVE_xxx_AT_COMPILE_TIME). */
+
+int CPLHaveRuntimeSSE();
+int CPLHaveRuntimeAVX();
+int CPLHaveRuntimeAVX2();
+
+/* Return TRUE if the AVX2 code paths should be used: the CPU supports AVX2 */
+/* and the GDAL_USE_AVX2 configuration option is not set to NO. The option */
+/* is read on the first call only. */
+
+int CPLUseAVX2();
+
+//! @endcond
+
+#endif // CPL_CPU_FEATURES_H_INCLUDED
@@ -175,6 +175,11 @@ int CPL_DLL     VSIIsCaseSensitiveFS( const char * pszFilename );
 
 void CPL_DLL   *VSIFGetNativeFileDescriptorL( VSILFILE* );
 
+const void CPL_DLL *VSIFGetReadViewL( VSILFILE* fp, vsi_l_offset nOffset,
+                                      size_t nSize );
+
+char CPL_DLL  **VSIFGetCacheStatisticsL( VSILFILE* fp );
+
 /* ==================================================================== */
 /*      Memory allocation                                               */
 /* ==================================================================== */
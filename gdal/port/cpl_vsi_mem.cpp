@@ -32,38 +32,50 @@
 #include "cpl_string.h"
 #include "cpl_multiproc.h"
 #include "cpl_atomic_ops.h"
+#include "cpl_hash_set.h"
 #include <time.h>
+#include <algorithm>
 #include <map>
+#include <vector>
 
 CPL_CVSID("$Id$");
 
 /*
 ** Notes on Multithreading:
 **
-** VSIMemFilesystemHandler: This class maintains a mutex to protect
-** access and update of the oFileList array which has all the "files" in
-** the memory filesystem area.  It is expected that multiple threads would
-** want to create and read different files at the same time and so might
-** collide access oFileList without the mutex.
+** VSIMemFilesystemHandler: The "files" of the memory filesystem area are
+** spread over VSIMEM_SHARD_COUNT shards, according to a hash of their
+** name. Each shard has its own file list and its own mutex, so that
+** threads creating, stating and unlinking different files at the same time
+** rarely contend for the same mutex. Operations on a single name only lock
+** the shard of that name. ReadDirEx() locks the shards one after the other,
+** and Rename() locks all of them, in index order, as it may move files
+** between shards.
 **
-** VSIMemFile: In theory we could allow different threads to update the
-** the same memory file, but for simplicity we restrict to single writer,
-** multiple reader as an expectation on the application code (not enforced
-** here), which means we don't need to do any protection of this class.
+** VSIMemFile: Each file has a reader/writer lock. Reads (and the length
+** lookups of Seek() and Stat()) take it in shared mode, and writes and
+** truncations in exclusive mode, so that different threads can read a
+** file while another one appends to it. The lock is taken with a single
+** atomic operation when it is not contended, and only falls back to its
+** mutex and condition when a thread has to wait. A shard mutex may be held
+** while taking a file lock, but never the other way round.
 **
 ** VSIMemHandle: This is essentially a "current location" representing
 ** on accessor to a file, and is inherently intended only to be used in
-** a single thread.
+** a single thread. It remembers the last file length it saw, so that a
+** SEEK_SET or SEEK_CUR within that length does not take the file lock.
 **
 ** In General:
 **
 ** Multiple threads accessing the memory filesystem are ok as long as
 **  1) A given VSIMemHandle (i.e. FILE * at app level) isn't used by multiple
 **     threads at once.
-**  2) A given memory file isn't accessed by more than one thread unless
-**     all threads are just reading.
+**  2) Pointers returned by VSIFGetReadViewL() or VSIGetMemFileBuffer() on a
+**     memory file aren't used while another thread writes to that file.
 */
 
+#define VSIMEM_SHARD_COUNT 64
+
 /************************************************************************/
 /* ==================================================================== */
 /*                              VSIMemFile                              */
@@ -85,10 +97,25 @@ public:
 
     time_t        mTime;
 
+    // Reader/writer lock: nLockState is the number of readers, or -1 when
+    // write locked. The mutex and condition are only used to wait.
+    CPLMutex     *hLockMutex;
+    CPLCond      *hLockCond;
+    volatile int  nLockState;
+    volatile int  nWaitingWriters;
+    volatile int  nWaiters;
+
                   VSIMemFile();
     virtual       ~VSIMemFile();
 
     bool          SetLength( vsi_l_offset nNewSize );
+
+    bool          TryAcquireReadLock();
+    void          WakeWaiters();
+    void          AcquireReadLock();
+    void          ReleaseReadLock();
+    void          AcquireWriteLock();
+    void          ReleaseWriteLock();
 };
 
 /************************************************************************/
@@ -105,9 +132,11 @@ class VSIMemHandle CPL_FINAL : public VSIVirtualHandle
     int           bUpdate;
     int           bEOF;
     int           bExtendFileAtNextWrite;
+    vsi_l_offset  m_nLengthSeen;  // file length at the last locked access
 
                       VSIMemHandle() : poFile(NULL), m_nOffset(0), bUpdate(0),
-                                       bEOF(0), bExtendFileAtNextWrite(0) {}
+                                       bEOF(0), bExtendFileAtNextWrite(0),
+                                       m_nLengthSeen(0) {}
 
     virtual int       Seek( vsi_l_offset nOffset, int nWhence );
     virtual vsi_l_offset Tell();
@@ -116,6 +145,7 @@ class VSIMemHandle CPL_FINAL : public VSIVirtualHandle
     virtual int       Eof();
     virtual int       Close();
     virtual int       Truncate( vsi_l_offset nNewSize );
+    virtual const void *GetReadView( vsi_l_offset nOffset, size_t nSize );
 };
 
 /************************************************************************/
@@ -124,11 +154,16 @@ class VSIMemHandle CPL_FINAL : public VSIVirtualHandle
 /* ==================================================================== */
 /************************************************************************/
 
-class VSIMemFilesystemHandler CPL_FINAL : public VSIFilesystemHandler
+typedef struct
 {
-public:
     std::map<CPLString,VSIMemFile*>   oFileList;
     CPLMutex        *hMutex;
+} VSIMemShard;
+
+class VSIMemFilesystemHandler CPL_FINAL : public VSIFilesystemHandler
+{
+public:
+    VSIMemShard      aoShards[VSIMEM_SHARD_COUNT];
 
                      VSIMemFilesystemHandler();
     virtual          ~VSIMemFilesystemHandler();
@@ -148,6 +183,7 @@ public:
 
     static  void     NormalizePath( CPLString & );
 
+    VSIMemShard     &GetShard( const CPLString &osFilename );
     int              Unlink_unlocked( const char *pszFilename );
 };
 
@@ -167,9 +203,16 @@ VSIMemFile::VSIMemFile() :
     bOwnData(TRUE),
     pabyData(NULL),
     nLength(0),
-    nAllocLength(0)
+    nAllocLength(0),
+    nLockState(0),
+    nWaitingWriters(0),
+    nWaiters(0)
 {
     time(&mTime);
+    hLockMutex = CPLCreateMutex();
+    if( hLockMutex != NULL )
+        CPLReleaseMutex(hLockMutex);
+    hLockCond = CPLCreateCond();
 }
 
 /************************************************************************/
@@ -186,6 +229,108 @@ VSIMemFile::~VSIMemFile()
 
     if( bOwnData && pabyData )
         CPLFree( pabyData );
+
+    if( hLockCond != NULL )
+        CPLDestroyCond( hLockCond );
+    if( hLockMutex != NULL )
+        CPLDestroyMutex( hLockMutex );
+}
+
+/************************************************************************/
+/*                         TryAcquireReadLock()                         */
+/************************************************************************/
+
+bool VSIMemFile::TryAcquireReadLock()
+
+{
+    // Let waiting writers go first, so that a stream of readers cannot
+    // starve them.
+    while( true )
+    {
+        const int nState = nLockState;
+        if( nState < 0 || nWaitingWriters > 0 )
+            return false;
+        if( CPLAtomicCompareAndExchange(&nLockState, nState, nState + 1) )
+            return true;
+    }
+}
+
+/************************************************************************/
+/*                            WakeWaiters()                             */
+/************************************************************************/
+
+/* Called after the lock state changed. A waiter registers itself in */
+/* nWaiters before testing the state under the mutex, so either it sees */
+/* the new state, or it is seen here and woken up. The atomic operation */
+/* that changed the state is a full barrier, so a plain read is enough. */
+void VSIMemFile::WakeWaiters()
+
+{
+    if( nWaiters == 0 )
+        return;
+    CPLAcquireMutex( hLockMutex, 1000.0 );
+    CPLCondBroadcast( hLockCond );
+    CPLReleaseMutex( hLockMutex );
+}
+
+/************************************************************************/
+/*                          AcquireReadLock()                           */
+/************************************************************************/
+
+void VSIMemFile::AcquireReadLock()
+
+{
+    if( TryAcquireReadLock() )
+        return;
+
+    CPLAcquireMutex( hLockMutex, 1000.0 );
+    CPLAtomicInc( &nWaiters );
+    while( !TryAcquireReadLock() )
+        CPLCondWait( hLockCond, hLockMutex );
+    CPLAtomicDec( &nWaiters );
+    CPLReleaseMutex( hLockMutex );
+}
+
+/************************************************************************/
+/*                          ReleaseReadLock()                           */
+/************************************************************************/
+
+void VSIMemFile::ReleaseReadLock()
+
+{
+    if( CPLAtomicDec( &nLockState ) == 0 )
+        WakeWaiters();
+}
+
+/************************************************************************/
+/*                          AcquireWriteLock()                          */
+/************************************************************************/
+
+void VSIMemFile::AcquireWriteLock()
+
+{
+    if( CPLAtomicCompareAndExchange(&nLockState, 0, -1) )
+        return;
+
+    CPLAcquireMutex( hLockMutex, 1000.0 );
+    CPLAtomicInc( &nWaitingWriters );
+    CPLAtomicInc( &nWaiters );
+    while( !CPLAtomicCompareAndExchange(&nLockState, 0, -1) )
+        CPLCondWait( hLockCond, hLockMutex );
+    CPLAtomicDec( &nWaiters );
+    CPLAtomicDec( &nWaitingWriters );
+    CPLReleaseMutex( hLockMutex );
+}
+
+/************************************************************************/
+/*                          ReleaseWriteLock()                          */
+/************************************************************************/
+
+void VSIMemFile::ReleaseWriteLock()
+
+{
+    CPLAtomicInc( &nLockState );
+    WakeWaiters();
 }
 
 /************************************************************************/
@@ -269,30 +414,43 @@ int VSIMemHandle::Seek( vsi_l_offset nOffset, int nWhence )
 
 {
     bExtendFileAtNextWrite = FALSE;
-    if( nWhence == SEEK_CUR )
-        m_nOffset += nOffset;
-    else if( nWhence == SEEK_SET )
-        m_nOffset = nOffset;
-    else if( nWhence == SEEK_END )
-        m_nOffset = poFile->nLength + nOffset;
-    else
+    if( nWhence != SEEK_CUR && nWhence != SEEK_SET && nWhence != SEEK_END )
     {
         errno = EINVAL;
         return -1;
     }
 
+    if( nWhence == SEEK_CUR )
+        m_nOffset += nOffset;
+    else if( nWhence == SEEK_SET )
+        m_nOffset = nOffset;
+
     bEOF = FALSE;
 
-    if( m_nOffset > poFile->nLength )
+    // Within the length this handle already saw, there is nothing to check.
+    // If the file was truncated since, the next Read() hits the end of file,
+    // as it would if the truncation happened right after this Seek().
+    if( nWhence != SEEK_END && m_nOffset <= m_nLengthSeen )
+        return 0;
+
+    poFile->AcquireReadLock();
+    const vsi_l_offset nLength = poFile->nLength;
+    poFile->ReleaseReadLock();
+    m_nLengthSeen = nLength;
+
+    if( nWhence == SEEK_END )
+        m_nOffset = nLength + nOffset;
+
+    if( m_nOffset > nLength )
     {
         if( !bUpdate ) // Read-only files cannot be extended by seek.
         {
             CPLDebug( "VSIMemHandle",
                       "Attempt to extend read-only file '%s' to length " CPL_FRMT_GUIB " from " CPL_FRMT_GUIB ".",
                       poFile->osFilename.c_str(),
-                      m_nOffset, poFile->nLength );
+                      m_nOffset, nLength );
 
-            m_nOffset = poFile->nLength;
+            m_nOffset = nLength;
             errno = EACCES;
             return -1;
         }
@@ -325,10 +483,13 @@ size_t VSIMemHandle::Read( void * pBuffer, size_t nSize, size_t nCount )
     // FIXME: Integer overflow check should be placed here:
     size_t nBytesToRead = nSize * nCount;
 
+    poFile->AcquireReadLock();
+    m_nLengthSeen = poFile->nLength;
     if( nBytesToRead + m_nOffset > poFile->nLength )
     {
         if (poFile->nLength < m_nOffset)
         {
+            poFile->ReleaseReadLock();
             bEOF = TRUE;
             return 0;
         }
@@ -340,11 +501,28 @@ size_t VSIMemHandle::Read( void * pBuffer, size_t nSize, size_t nCount )
 
     if( nBytesToRead )
         memcpy( pBuffer, poFile->pabyData + m_nOffset, (size_t)nBytesToRead );
+    poFile->ReleaseReadLock();
     m_nOffset += nBytesToRead;
 
     return nCount;
 }
 
+/************************************************************************/
+/*                            GetReadView()                             */
+/************************************************************************/
+
+const void *VSIMemHandle::GetReadView( vsi_l_offset nOffset, size_t nSize )
+
+{
+    // The view remains valid until the file is written to or truncated,
+    // which the caller must not do concurrently (see the notes on
+    // multithreading), so there is nothing to lock here.
+    if( nOffset <= poFile->nLength && nSize <= poFile->nLength - nOffset )
+        return poFile->pabyData + nOffset;
+
+    return NULL;
+}
+
 /************************************************************************/
 /*                               Write()                                */
 /************************************************************************/
@@ -357,11 +535,16 @@ size_t VSIMemHandle::Write( const void * pBuffer, size_t nSize, size_t nCount )
         errno = EACCES;
         return 0;
     }
+
+    poFile->AcquireWriteLock();
     if( bExtendFileAtNextWrite )
     {
         bExtendFileAtNextWrite = FALSE;
         if( !poFile->SetLength( m_nOffset ) )
+        {
+            poFile->ReleaseWriteLock();
             return 0;
+        }
     }
 
     // FIXME: Integer overflow check should be placed here:
@@ -370,14 +553,20 @@ size_t VSIMemHandle::Write( const void * pBuffer, size_t nSize, size_t nCount )
     if( nBytesToWrite + m_nOffset > poFile->nLength )
     {
         if( !poFile->SetLength( nBytesToWrite + m_nOffset ) )
+        {
+            poFile->ReleaseWriteLock();
             return 0;
+        }
     }
 
     if( nBytesToWrite )
         memcpy( poFile->pabyData + m_nOffset, pBuffer, nBytesToWrite );
-    m_nOffset += nBytesToWrite;
 
     time(&poFile->mTime);
+    m_nLengthSeen = poFile->nLength;
+    poFile->ReleaseWriteLock();
+
+    m_nOffset += nBytesToWrite;
 
     return nCount;
 }
@@ -405,10 +594,12 @@ int VSIMemHandle::Truncate( vsi_l_offset nNewSize )
     }
 
     bExtendFileAtNextWrite = FALSE;
-    if (poFile->SetLength( nNewSize ))
-        return 0;
-    else
-        return -1;
+    poFile->AcquireWriteLock();
+    const bool bOK = poFile->SetLength( nNewSize );
+    m_nLengthSeen = poFile->nLength;
+    poFile->ReleaseWriteLock();
+
+    return bOK ? 0 : -1;
 }
 
 /************************************************************************/
@@ -421,9 +612,17 @@ int VSIMemHandle::Truncate( vsi_l_offset nNewSize )
 /*                      VSIMemFilesystemHandler()                       */
 /************************************************************************/
 
-VSIMemFilesystemHandler::VSIMemFilesystemHandler() :
-    hMutex(NULL)
-{ }
+VSIMemFilesystemHandler::VSIMemFilesystemHandler()
+{
+    // The shard mutexes are created here rather than lazily with
+    // CPLCreateOrAcquireMutex(), as the latter takes a global mutex each time.
+    for( int i = 0; i < VSIMEM_SHARD_COUNT; i++ )
+    {
+        aoShards[i].hMutex = CPLCreateMutex();
+        if( aoShards[i].hMutex != NULL )
+            CPLReleaseMutex( aoShards[i].hMutex );
+    }
+}
 
 /************************************************************************/
 /*                      ~VSIMemFilesystemHandler()                      */
@@ -432,17 +631,34 @@ VSIMemFilesystemHandler::VSIMemFilesystemHandler() :
 VSIMemFilesystemHandler::~VSIMemFilesystemHandler()
 
 {
-    for( std::map<CPLString,VSIMemFile*>::const_iterator iter = oFileList.begin();
-         iter != oFileList.end();
-         ++iter )
+    for( int i = 0; i < VSIMEM_SHARD_COUNT; i++ )
     {
-        CPLAtomicDec(&(iter->second->nRefCount));
-        delete iter->second;
+        std::map<CPLString,VSIMemFile*>& oFileList = aoShards[i].oFileList;
+        for( std::map<CPLString,VSIMemFile*>::const_iterator iter =
+                                                        oFileList.begin();
+             iter != oFileList.end();
+             ++iter )
+        {
+            CPLAtomicDec(&(iter->second->nRefCount));
+            delete iter->second;
+        }
+
+        if( aoShards[i].hMutex != NULL )
+            CPLDestroyMutex( aoShards[i].hMutex );
+        aoShards[i].hMutex = NULL;
     }
+}
+
+/************************************************************************/
+/*                              GetShard()                              */
+/************************************************************************/
+
+/* Return the shard of a normalized filename */
+VSIMemShard &VSIMemFilesystemHandler::GetShard( const CPLString &osFilename )
 
-    if( hMutex != NULL )
-        CPLDestroyMutex( hMutex );
-    hMutex = NULL;
+{
+    return aoShards[CPLHashSetHashStr(osFilename.c_str()) %
+                    VSIMEM_SHARD_COUNT];
 }
 
 /************************************************************************/
@@ -455,47 +671,63 @@ VSIMemFilesystemHandler::Open( const char *pszFilename,
                                bool bSetError )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
     CPLString osFilename = pszFilename;
     NormalizePath( osFilename );
 
+    VSIMemShard &oShard = GetShard( osFilename );
+    std::map<CPLString,VSIMemFile*>& oFileList = oShard.oFileList;
+    VSIMemFile *poFile;
+    bool bTruncate = false;
+    {
+        CPLMutexHolder oHolder( oShard.hMutex );
+
 /* -------------------------------------------------------------------- */
 /*      Get the filename we are opening, create if needed.              */
 /* -------------------------------------------------------------------- */
-    VSIMemFile *poFile;
-    if( oFileList.find(osFilename) == oFileList.end() )
-        poFile = NULL;
-    else
-        poFile = oFileList[osFilename];
+        std::map<CPLString,VSIMemFile*>::iterator oIter =
+                                                oFileList.find(osFilename);
+        poFile = (oIter == oFileList.end()) ? NULL : oIter->second;
+
+        // If no file and opening in read, error out
+        if( strstr(pszAccess,"w") == NULL
+            && strstr(pszAccess, "a") == NULL
+            && poFile == NULL )
+        {
+            if(bSetError) { VSIError(VSIE_FileError, "No such file or directory"); }
+            errno = ENOENT;
+            return NULL;
+        }
 
-    // If no file and opening in read, error out
-    if( strstr(pszAccess,"w") == NULL
-        && strstr(pszAccess, "a") == NULL
-        && poFile == NULL )
-    {
-        if(bSetError) { VSIError(VSIE_FileError, "No such file or directory"); }
-        errno = ENOENT;
-        return NULL;
-    }
+        // Create
+        if( poFile == NULL )
+        {
+            poFile = new VSIMemFile;
+            poFile->osFilename = osFilename;
+            oFileList[poFile->osFilename] = poFile;
+            CPLAtomicInc(&(poFile->nRefCount)); // for file list
+        }
+        // Overwrite
+        else if( strstr(pszAccess, "w") )
+        {
+            bTruncate = true;
+        }
 
-    // Create
-    if( poFile == NULL )
-    {
-        poFile = new VSIMemFile;
-        poFile->osFilename = osFilename;
-        oFileList[poFile->osFilename] = poFile;
-        CPLAtomicInc(&(poFile->nRefCount)); // for file list
-    }
-    // Overwrite
-    else if( strstr(pszAccess, "w") )
-    {
-        poFile->SetLength(0);
+        if( poFile->bIsDirectory )
+        {
+            errno = EISDIR;
+            return NULL;
+        }
+
+        // Reference taken before the shard is unlocked, so that the file
+        // outlives a concurrent Unlink()
+        CPLAtomicInc(&(poFile->nRefCount));
     }
 
-    if( poFile->bIsDirectory )
+    if( bTruncate )
     {
-        errno = EISDIR;
-        return NULL;
+        poFile->AcquireWriteLock();
+        poFile->SetLength(0);
+        poFile->ReleaseWriteLock();
     }
 
 /* -------------------------------------------------------------------- */
@@ -512,10 +744,11 @@ VSIMemFilesystemHandler::Open( const char *pszFilename,
     else
         poHandle->bUpdate = FALSE;
 
-    CPLAtomicInc(&(poFile->nRefCount));
-
+    poFile->AcquireReadLock();
+    poHandle->m_nLengthSeen = poFile->nLength;
+    poFile->ReleaseReadLock();
     if( strstr(pszAccess,"a") )
-        poHandle->m_nOffset = poFile->nLength;
+        poHandle->m_nOffset = poHandle->m_nLengthSeen;
 
     return poHandle;
 }
@@ -529,8 +762,6 @@ int VSIMemFilesystemHandler::Stat( const char * pszFilename,
                                    int /* nFlags */ )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-
     CPLString osFilename = pszFilename;
     NormalizePath( osFilename );
 
@@ -543,15 +774,18 @@ int VSIMemFilesystemHandler::Stat( const char * pszFilename,
         return 0;
     }
 
-    if( oFileList.find(osFilename) == oFileList.end() )
+    VSIMemShard &oShard = GetShard( osFilename );
+    CPLMutexHolder oHolder( oShard.hMutex );
+
+    std::map<CPLString,VSIMemFile*>::const_iterator oIter =
+                                            oShard.oFileList.find(osFilename);
+    if( oIter == oShard.oFileList.end() )
     {
         errno = ENOENT;
         return -1;
     }
 
-    VSIMemFile *poFile = oFileList[osFilename];
-
-    memset( pStatBuf, 0, sizeof(VSIStatBufL) );
+    VSIMemFile *poFile = oIter->second;
 
     if( poFile->bIsDirectory )
     {
@@ -560,9 +794,11 @@ int VSIMemFilesystemHandler::Stat( const char * pszFilename,
     }
     else
     {
+        poFile->AcquireReadLock();
         pStatBuf->st_size = poFile->nLength;
         pStatBuf->st_mode = S_IFREG;
         pStatBuf->st_mtime = poFile->mTime;
+        poFile->ReleaseReadLock();
     }
 
     return 0;
@@ -575,34 +811,40 @@ int VSIMemFilesystemHandler::Stat( const char * pszFilename,
 int VSIMemFilesystemHandler::Unlink( const char * pszFilename )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-    return Unlink_unlocked(pszFilename);
+    CPLString osFilename = pszFilename;
+    NormalizePath( osFilename );
+
+    CPLMutexHolder oHolder( GetShard(osFilename).hMutex );
+    return Unlink_unlocked(osFilename);
 }
 
 /************************************************************************/
 /*                           Unlink_unlocked()                          */
 /************************************************************************/
 
+/* Must be called with the mutex of the shard of pszFilename held */
 int VSIMemFilesystemHandler::Unlink_unlocked( const char * pszFilename )
 
 {
     CPLString osFilename = pszFilename;
     NormalizePath( osFilename );
 
-
-    if( oFileList.find(osFilename) == oFileList.end() )
+    std::map<CPLString,VSIMemFile*>& oFileList =
+                                            GetShard(osFilename).oFileList;
+    std::map<CPLString,VSIMemFile*>::iterator oIter =
+                                            oFileList.find(osFilename);
+    if( oIter == oFileList.end() )
     {
         errno = ENOENT;
         return -1;
     }
 
-    VSIMemFile *poFile = oFileList[osFilename];
+    VSIMemFile *poFile = oIter->second;
+    oFileList.erase( oIter );
 
     if( CPLAtomicDec(&(poFile->nRefCount)) == 0 )
         delete poFile;
 
-    oFileList.erase( oFileList.find(osFilename) );
-
     return 0;
 }
 
@@ -614,13 +856,14 @@ int VSIMemFilesystemHandler::Mkdir( const char * pszPathname,
                                     long /* nMode */ )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-
     CPLString osPathname = pszPathname;
 
     NormalizePath( osPathname );
 
-    if( oFileList.find(osPathname) != oFileList.end() )
+    VSIMemShard &oShard = GetShard( osPathname );
+    CPLMutexHolder oHolder( oShard.hMutex );
+
+    if( oShard.oFileList.find(osPathname) != oShard.oFileList.end() )
     {
         errno = EEXIST;
         return -1;
@@ -630,7 +873,7 @@ int VSIMemFilesystemHandler::Mkdir( const char * pszPathname,
 
     poFile->osFilename = osPathname;
     poFile->bIsDirectory = TRUE;
-    oFileList[osPathname] = poFile;
+    oShard.oFileList[osPathname] = poFile;
     CPLAtomicInc(&(poFile->nRefCount)); /* referenced by file list */
 
     return 0;
@@ -654,52 +897,53 @@ char **VSIMemFilesystemHandler::ReadDirEx( const char *pszPath,
                                            int nMaxFiles )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-
     CPLString osPath = pszPath;
 
     NormalizePath( osPath );
 
-    std::map<CPLString,VSIMemFile*>::const_iterator iter;
-    char **papszDir = NULL;
     size_t nPathLen = strlen(osPath);
 
     if( nPathLen > 0 && osPath[nPathLen-1] == '/' )
         nPathLen--;
 
-    /* In case of really big number of files in the directory, CSLAddString */
-    /* can be slow (see #2158). We then directly build the list. */
-    int nItems=0;
-    int nAllocatedItems=0;
-
-    for( iter = oFileList.begin(); iter != oFileList.end(); ++iter )
+    /* The children are collected from each shard in turn, and sorted */
+    /* afterwards to return them in the order of their full path. */
+    std::vector<CPLString> aosChildren;
+    for( int i = 0; i < VSIMEM_SHARD_COUNT; i++ )
     {
-        const char *pszFilePath = iter->second->osFilename.c_str();
-        if( EQUALN(osPath,pszFilePath,nPathLen)
-            && pszFilePath[nPathLen] == '/'
-            && strstr(pszFilePath+nPathLen+1,"/") == NULL )
+        CPLMutexHolder oHolder( aoShards[i].hMutex );
+
+        const std::map<CPLString,VSIMemFile*>& oFileList =
+                                                    aoShards[i].oFileList;
+        for( std::map<CPLString,VSIMemFile*>::const_iterator iter =
+                                                        oFileList.begin();
+             iter != oFileList.end(); ++iter )
         {
-            if (nItems == 0)
-            {
-                papszDir = (char**) CPLCalloc(2,sizeof(char*));
-                nAllocatedItems = 1;
-            }
-            else if (nItems >= nAllocatedItems)
+            const char *pszFilePath = iter->second->osFilename.c_str();
+            if( EQUALN(osPath,pszFilePath,nPathLen)
+                && pszFilePath[nPathLen] == '/'
+                && strstr(pszFilePath+nPathLen+1,"/") == NULL )
             {
-                nAllocatedItems = nAllocatedItems * 2;
-                papszDir = (char**)CPLRealloc(papszDir,
-                                              (nAllocatedItems+2)*sizeof(char*));
+                aosChildren.push_back(pszFilePath);
             }
-
-            papszDir[nItems] = CPLStrdup(pszFilePath+nPathLen+1);
-            papszDir[nItems+1] = NULL;
-
-            nItems++;
-            if( nMaxFiles > 0 && nItems > nMaxFiles )
-                break;
         }
     }
 
+    if( aosChildren.empty() )
+        return NULL;
+
+    std::sort(aosChildren.begin(), aosChildren.end());
+
+    /* In case of really big number of files in the directory, CSLAddString */
+    /* can be slow (see #2158). We then directly build the list. */
+    size_t nItems = aosChildren.size();
+    if( nMaxFiles > 0 && nItems > static_cast<size_t>(nMaxFiles) + 1 )
+        nItems = static_cast<size_t>(nMaxFiles) + 1;
+
+    char **papszDir = (char**) CPLCalloc(nItems + 1, sizeof(char*));
+    for( size_t i = 0; i < nItems; i++ )
+        papszDir[i] = CPLStrdup(aosChildren[i].c_str() + nPathLen + 1);
+
     return papszDir;
 }
 
@@ -711,8 +955,6 @@ int VSIMemFilesystemHandler::Rename( const char *pszOldPath,
                                      const char *pszNewPath )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-
     CPLString osOldPath = pszOldPath;
     CPLString osNewPath = pszNewPath;
 
@@ -722,28 +964,54 @@ int VSIMemFilesystemHandler::Rename( const char *pszOldPath,
     if ( osOldPath.compare(osNewPath) == 0 )
         return 0;
 
-    if( oFileList.find(osOldPath) == oFileList.end() )
+    /* The file and its children may be in any shard, and may move to */
+    /* any other one, so lock them all, always in the same order. */
+    for( int i = 0; i < VSIMEM_SHARD_COUNT; i++ )
+        CPLAcquireMutex( aoShards[i].hMutex, 1000.0 );
+
+    int nRet = 0;
+    std::map<CPLString,VSIMemFile*>& oOldFileList =
+                                            GetShard(osOldPath).oFileList;
+    if( oOldFileList.find(osOldPath) == oOldFileList.end() )
     {
         errno = ENOENT;
-        return -1;
+        nRet = -1;
     }
-
-    std::map<CPLString,VSIMemFile*>::iterator it = oFileList.find(osOldPath);
-    while (it != oFileList.end() && it->first.ifind(osOldPath) == 0)
+    else
     {
-        const CPLString osRemainder = it->first.substr(osOldPath.size());
-        if (osRemainder.empty() || osRemainder[0] == '/')
+        std::vector<VSIMemFile*> apoMoved;
+        for( int i = 0; i < VSIMEM_SHARD_COUNT; i++ )
+        {
+            std::map<CPLString,VSIMemFile*>& oFileList =
+                                                    aoShards[i].oFileList;
+            std::map<CPLString,VSIMemFile*>::iterator it =
+                                            oFileList.lower_bound(osOldPath);
+            while (it != oFileList.end() && it->first.ifind(osOldPath) == 0)
+            {
+                const CPLString osRemainder =
+                                        it->first.substr(osOldPath.size());
+                if (osRemainder.empty() || osRemainder[0] == '/')
+                {
+                    it->second->osFilename = osNewPath + osRemainder;
+                    apoMoved.push_back(it->second);
+                    oFileList.erase(it++);
+                }
+                else ++it;
+            }
+        }
+
+        for( size_t i = 0; i < apoMoved.size(); i++ )
         {
-            const CPLString osNewFullPath = osNewPath + osRemainder;
+            const CPLString &osNewFullPath = apoMoved[i]->osFilename;
             Unlink_unlocked(osNewFullPath);
-            oFileList[osNewFullPath] = it->second;
-            it->second->osFilename = osNewFullPath;
-            oFileList.erase(it++);
+            GetShard(osNewFullPath).oFileList[osNewFullPath] = apoMoved[i];
         }
-        else ++it;
     }
 
-    return 0;
+    for( int i = VSIMEM_SHARD_COUNT - 1; i >= 0; i-- )
+        CPLReleaseMutex( aoShards[i].hMutex );
+
+    return nRet;
 }
 
 /************************************************************************/
@@ -890,9 +1158,10 @@ VSILFILE *VSIFileFromMemBuffer( const char *pszFilename,
     poFile->nAllocLength = nDataLength;
 
     {
-        CPLMutexHolder oHolder( &poHandler->hMutex );
+        VSIMemShard &oShard = poHandler->GetShard( osFilename );
+        CPLMutexHolder oHolder( oShard.hMutex );
         poHandler->Unlink_unlocked(osFilename);
-        poHandler->oFileList[poFile->osFilename] = poFile;
+        oShard.oFileList[poFile->osFilename] = poFile;
         CPLAtomicInc(&(poFile->nRefCount));
     }
 
@@ -932,12 +1201,17 @@ GByte *VSIGetMemFileBuffer( const char *pszFilename,
     CPLString osFilename = pszFilename;
     VSIMemFilesystemHandler::NormalizePath( osFilename );
 
-    CPLMutexHolder oHolder( &poHandler->hMutex );
+    VSIMemShard &oShard = poHandler->GetShard( osFilename );
+    CPLMutexHolder oHolder( oShard.hMutex );
 
-    if( poHandler->oFileList.find(osFilename) == poHandler->oFileList.end() )
+    std::map<CPLString,VSIMemFile*>::iterator oIter =
+                                            oShard.oFileList.find(osFilename);
+    if( oIter == oShard.oFileList.end() )
         return NULL;
 
-    VSIMemFile *poFile = poHandler->oFileList[osFilename];
+    // As for VSIFGetReadViewL(), the buffer may not be used while another
+    // thread writes to the file, so locking the file would not help.
+    VSIMemFile *poFile = oIter->second;
     GByte *pabyData = poFile->pabyData;
     if( pnDataLength != NULL )
         *pnDataLength = poFile->nLength;
@@ -950,7 +1224,7 @@ GByte *VSIGetMemFileBuffer( const char *pszFilename,
         else
             poFile->bOwnData = FALSE;
 
-        poHandler->oFileList.erase( poHandler->oFileList.find(osFilename) );
+        oShard.oFileList.erase( oIter );
         CPLAtomicDec(&(poFile->nRefCount));
         delete poFile;
     }
@@ -59,6 +59,9 @@ class CPL_DLL VSIVirtualHandle {
     virtual int       Close() = 0;
     virtual int       Truncate( CPL_UNUSED vsi_l_offset nNewSize ) { return -1; }
     virtual void     *GetNativeFileDescriptor() { return NULL; }
+    virtual const void *GetReadView( CPL_UNUSED vsi_l_offset nOffset,
+                                     CPL_UNUSED size_t nSize ) { return NULL; }
+    virtual char    **GetCacheStatistics() { return NULL; }
     virtual           ~VSIVirtualHandle() { }
 };
 
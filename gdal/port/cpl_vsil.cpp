@@ -1177,6 +1177,80 @@ void *VSIFGetNativeFileDescriptorL( VSILFILE* fp )
     return poFileHandle->GetNativeFileDescriptor();
 }
 
+/************************************************************************/
+/*                          VSIFGetReadViewL()                          */
+/************************************************************************/
+
+/**
+ * \brief Returns a read-only pointer to a byte range of the file.
+ *
+ * This gives access to file content without copying it, for handles that
+ * have it in memory: /vsimem/ files, and regular files opened in read-only
+ * mode with the VSI_MMAP configuration option set to YES. Other handles, or
+ * ranges that extend beyond the end of file, return NULL, in which case the
+ * caller should fall back to VSIFSeekL() and VSIFReadL().
+ *
+ * The returned pointer is only valid until the next operation on the
+ * handle. The file position is not changed.
+ *
+ * @param fp file handle opened with VSIFOpenL().
+ * @param nOffset offset of the start of the range.
+ * @param nSize size of the range, in bytes.
+ *
+ * @return a pointer to the content of the range, or NULL.
+ * @since GDAL 2.2
+ */
+
+const void *VSIFGetReadViewL( VSILFILE* fp, vsi_l_offset nOffset,
+                              size_t nSize )
+{
+    VSIVirtualHandle *poFileHandle = reinterpret_cast<VSIVirtualHandle *>( fp );
+
+    return poFileHandle->GetReadView( nOffset, nSize );
+}
+
+/************************************************************************/
+/*                       VSIFGetCacheStatisticsL()                      */
+/************************************************************************/
+
+/**
+ * \brief Returns statistics about the caching layer of a file handle.
+ *
+ * Files opened with the VSI_CACHE configuration option set to TRUE are read
+ * through a cache of fixed-size chunks, with a read-ahead of the following
+ * chunks when sequential reads are detected. The read-ahead doubles each
+ * time it is issued, up to VSI_CACHE_READAHEAD_MAX bytes (4 MB by default,
+ * and at most a quarter of VSI_CACHE_SIZE; 0 disables it). When
+ * VSI_CACHE_READAHEAD_THREAD is set to YES, it is done by a background
+ * thread.
+ *
+ * The returned list contains the following NAME=VALUE items:
+ * <ul>
+ * <li>BYTES_REQUESTED: number of bytes returned by VSIFReadL().</li>
+ * <li>BYTES_READ: number of bytes read from the underlying file.</li>
+ * <li>CHUNK_HITS, CHUNK_MISSES: number of chunks accessed by VSIFReadL()
+ * that were, or were not, in the cache.</li>
+ * <li>HIT_RATE: ratio of CHUNK_HITS over the number of chunks accessed.</li>
+ * <li>READAHEAD_BYTES: number of bytes loaded by read-ahead.</li>
+ * <li>READAHEAD_BYTES_USED: number of those bytes that were later read.</li>
+ * <li>READAHEAD_EFFICIENCY: ratio of READAHEAD_BYTES_USED over
+ * READAHEAD_BYTES.</li>
+ * </ul>
+ *
+ * @param fp file handle opened with VSIFOpenL().
+ *
+ * @return a list of NAME=VALUE strings to free with CSLDestroy(), or NULL
+ * if the handle is not cached.
+ * @since GDAL 2.2
+ */
+
+char **VSIFGetCacheStatisticsL( VSILFILE* fp )
+{
+    VSIVirtualHandle *poFileHandle = reinterpret_cast<VSIVirtualHandle *>( fp );
+
+    return poFileHandle->GetCacheStatistics();
+}
+
 /************************************************************************/
 /*                      VSIGetDiskFreeSpace()                           */
 /************************************************************************/
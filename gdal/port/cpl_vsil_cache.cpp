@@ -29,6 +29,8 @@
  ****************************************************************************/
 
 #include "cpl_vsi_virtual.h"
+#include "cpl_multiproc.h"
+#include "cpl_string.h"
 #include <map>
 
 CPL_CVSID("$Id$");
@@ -44,6 +46,7 @@ class VSICacheChunk
 public:
   VSICacheChunk() :
       bDirty(FALSE),
+      bReadAhead(false),
       iBlock(0),
       poLRUPrev(NULL),
       poLRUNext(NULL),
@@ -64,6 +67,7 @@ public:
     }
 
     int            bDirty;
+    bool           bReadAhead;  // loaded by read-ahead, and not yet read
     vsi_l_offset   iBlock;
 
     VSICacheChunk *poLRUPrev;
@@ -73,12 +77,34 @@ public:
     GByte          *pabyData;
 };
 
+/************************************************************************/
+/* ==================================================================== */
+/*                         VSICacheReadAheadJob                         */
+/* ==================================================================== */
+/************************************************************************/
+
+/* Read of blocks ahead of the current position, done by a background */
+/* thread, while the base handle is not otherwise used. */
+typedef struct
+{
+    VSIVirtualHandle  *poBase;
+    vsi_l_offset       nStartBlock;
+    size_t             nBlockCount;
+    size_t             nChunkSize;
+    GByte             *pabyBuffer;
+    size_t             nDataRead;
+} VSICacheReadAheadJob;
+
 /************************************************************************/
 /* ==================================================================== */
 /*                             VSICachedFile                            */
 /* ==================================================================== */
 /************************************************************************/
 
+/* Sequential reads trigger a read-ahead of the following blocks, whose */
+/* size doubles each time it is issued, up to VSI_CACHE_READAHEAD_MAX bytes */
+/* (4 MB by default, and at most a quarter of the cache size, 0 to disable). */
+/* With VSI_CACHE_READAHEAD_THREAD=YES, it is done by a background thread. */
 class VSICachedFile CPL_FINAL : public VSIVirtualHandle
 {
   public:
@@ -91,6 +117,9 @@ class VSICachedFile CPL_FINAL : public VSIVirtualHandle
     int           LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
                               void *pBuffer, size_t nBufferSize );
     void          Demote( VSICacheChunk * );
+    bool          IsCached( vsi_l_offset iBlock );
+    void          ReadAhead();
+    void          WaitReadAhead();
 
     VSIVirtualHandle *poBase;
 
@@ -109,6 +138,23 @@ class VSICachedFile CPL_FINAL : public VSIVirtualHandle
 
     int            bEOF;
 
+    /* Sequential access detection and read-ahead */
+    vsi_l_offset   nLastReadEnd;
+    int            nSequentialReads;
+    size_t         nReadAheadSize;
+    size_t         nReadAheadMax;
+    bool           bReadAheadThread;
+    CPLJoinableThread *hReadAheadThread;
+    VSICacheReadAheadJob sReadAheadJob;
+
+    /* Statistics */
+    GUIntBig       nBytesRequested;
+    GUIntBig       nBytesRead;
+    GUIntBig       nChunkHits;
+    GUIntBig       nChunkMisses;
+    GUIntBig       nReadAheadBytes;
+    GUIntBig       nReadAheadBytesUsed;
+
     virtual int       Seek( vsi_l_offset nOffset, int nWhence );
     virtual vsi_l_offset Tell();
     virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb );
@@ -117,6 +163,7 @@ class VSICachedFile CPL_FINAL : public VSIVirtualHandle
     virtual int       Flush();
     virtual int       Close();
     virtual void     *GetNativeFileDescriptor() { return poBase->GetNativeFileDescriptor(); }
+    virtual char    **GetCacheStatistics();
 };
 
 /************************************************************************/
@@ -144,6 +191,25 @@ VSICachedFile::VSICachedFile( VSIVirtualHandle *poBaseHandle, size_t nChunkSize,
 
     nOffset = 0;
     bEOF = FALSE;
+
+    nLastReadEnd = 0;
+    nSequentialReads = 0;
+    nReadAheadSize = 0;
+    const GUIntBig nReadAheadMaxOption = CPLScanUIntBig(
+        CPLGetConfigOption( "VSI_CACHE_READAHEAD_MAX", "4194304" ), 40 );
+    nReadAheadMax = static_cast<size_t>(
+        MIN( nReadAheadMaxOption, nCacheMax / 4 ) );
+    bReadAheadThread = CPLTestBool(
+        CPLGetConfigOption( "VSI_CACHE_READAHEAD_THREAD", "NO" ) );
+    hReadAheadThread = NULL;
+    memset( &sReadAheadJob, 0, sizeof(sReadAheadJob) );
+
+    nBytesRequested = 0;
+    nBytesRead = 0;
+    nChunkHits = 0;
+    nChunkMisses = 0;
+    nReadAheadBytes = 0;
+    nReadAheadBytesUsed = 0;
 }
 
 /************************************************************************/
@@ -153,6 +219,18 @@ VSICachedFile::VSICachedFile( VSIVirtualHandle *poBaseHandle, size_t nChunkSize,
 int VSICachedFile::Close()
 
 {
+    WaitReadAhead();
+
+    if( poBase != NULL && nBytesRequested > 0 )
+    {
+        CPLDebug( "VSI", "VSICachedFile: " CPL_FRMT_GUIB " bytes requested, "
+                  CPL_FRMT_GUIB " read, " CPL_FRMT_GUIB " chunk hits, "
+                  CPL_FRMT_GUIB " misses, " CPL_FRMT_GUIB " read ahead, "
+                  CPL_FRMT_GUIB " of them used",
+                  nBytesRequested, nBytesRead, nChunkHits, nChunkMisses,
+                  nReadAheadBytes, nReadAheadBytesUsed );
+    }
+
     for( std::map<vsi_l_offset, VSICacheChunk*>::iterator oIter = oMapOffsetToCache.begin();
          oIter != oMapOffsetToCache.end(); ++oIter )
     {
@@ -292,6 +370,9 @@ int VSICachedFile::LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
     if( nBlockCount == 0 )
         return 1;
 
+    // The base handle must not be used while it is read ahead.
+    CPLAssert( hReadAheadThread == NULL );
+
 /* -------------------------------------------------------------------- */
 /*      When we want to load only one block, we can directly load it    */
 /*      into the target buffer with no concern about intermediaries.    */
@@ -312,6 +393,7 @@ int VSICachedFile::LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
         poBlock->iBlock = nStartBlock;
         poBlock->nDataFilled = poBase->Read( poBlock->pabyData, 1, m_nChunkSize );
         nCacheUsed += poBlock->nDataFilled;
+        nBytesRead += poBlock->nDataFilled;
 
         // Merges into the LRU list.
         Demote( poBlock );
@@ -350,6 +432,7 @@ int VSICachedFile::LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
 /* -------------------------------------------------------------------- */
 
     size_t nDataRead = poBase->Read( pabyWorkBuffer, 1, nBlockCount*m_nChunkSize);
+    nBytesRead += nDataRead;
 
     if( nBlockCount * m_nChunkSize > nDataRead + m_nChunkSize - 1 )
         nBlockCount = (nDataRead + m_nChunkSize - 1) / m_nChunkSize;
@@ -389,6 +472,171 @@ int VSICachedFile::LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
     return 1;
 }
 
+/************************************************************************/
+/*                              IsCached()                              */
+/************************************************************************/
+
+bool VSICachedFile::IsCached( vsi_l_offset iBlock )
+
+{
+    std::map<vsi_l_offset, VSICacheChunk*>::const_iterator oIter =
+        oMapOffsetToCache.find(iBlock);
+    return oIter != oMapOffsetToCache.end() && oIter->second != NULL;
+}
+
+/************************************************************************/
+/*                       VSICacheReadAheadThread()                      */
+/************************************************************************/
+
+static void VSICacheReadAheadThread( void* pData )
+
+{
+    VSICacheReadAheadJob *psJob = static_cast<VSICacheReadAheadJob *>(pData);
+    if( psJob->poBase->Seek( psJob->nStartBlock * psJob->nChunkSize,
+                             SEEK_SET ) == 0 )
+    {
+        psJob->nDataRead = psJob->poBase->Read(
+            psJob->pabyBuffer, 1, psJob->nBlockCount * psJob->nChunkSize );
+    }
+}
+
+/************************************************************************/
+/*                           WaitReadAhead()                            */
+/*                                                                      */
+/*      Wait for the background read-ahead, if any, and add the         */
+/*      blocks it read to the cache.                                    */
+/************************************************************************/
+
+void VSICachedFile::WaitReadAhead()
+
+{
+    if( hReadAheadThread == NULL )
+        return;
+
+    CPLJoinThread( hReadAheadThread );
+    hReadAheadThread = NULL;
+
+    VSICacheReadAheadJob *psJob = &sReadAheadJob;
+    nBytesRead += psJob->nDataRead;
+    for( size_t i = 0; i < psJob->nBlockCount &&
+                       i * m_nChunkSize < psJob->nDataRead; i++ )
+    {
+        const vsi_l_offset iBlock = psJob->nStartBlock + i;
+        if( IsCached(iBlock) )
+            continue;
+
+        VSICacheChunk *poBlock = new VSICacheChunk();
+        if ( !poBlock->Allocate( m_nChunkSize ) )
+        {
+            delete poBlock;
+            break;
+        }
+
+        poBlock->iBlock = iBlock;
+        poBlock->bReadAhead = true;
+        poBlock->nDataFilled =
+            MIN( m_nChunkSize, psJob->nDataRead - i * m_nChunkSize );
+        memcpy( poBlock->pabyData, psJob->pabyBuffer + i * m_nChunkSize,
+                (size_t) poBlock->nDataFilled );
+        oMapOffsetToCache[iBlock] = poBlock;
+
+        nCacheUsed += poBlock->nDataFilled;
+        nReadAheadBytes += poBlock->nDataFilled;
+
+        // Merges into the LRU list.
+        Demote( poBlock );
+    }
+
+    CPLFree( psJob->pabyBuffer );
+    psJob->pabyBuffer = NULL;
+}
+
+/************************************************************************/
+/*                             ReadAhead()                              */
+/*                                                                      */
+/*      Load the blocks following the current position, if less than   */
+/*      half of the read-ahead size is already cached or being read,    */
+/*      and double that size.                                           */
+/************************************************************************/
+
+void VSICachedFile::ReadAhead()
+
+{
+    if( nReadAheadSize == 0 )
+        nReadAheadSize = MIN( 2 * m_nChunkSize, nReadAheadMax );
+
+/* -------------------------------------------------------------------- */
+/*      Find how much is available ahead of the current position.       */
+/* -------------------------------------------------------------------- */
+    vsi_l_offset iBlock = nOffset / m_nChunkSize;
+    while( true )
+    {
+        if( IsCached(iBlock) )
+            iBlock++;
+        else if( hReadAheadThread != NULL &&
+                 iBlock == sReadAheadJob.nStartBlock )
+            iBlock += sReadAheadJob.nBlockCount;
+        else
+            break;
+    }
+    if( iBlock * m_nChunkSize >= nFileSize ||
+        iBlock * m_nChunkSize >= nOffset + nReadAheadSize / 2 )
+        return;
+
+/* -------------------------------------------------------------------- */
+/*      Read the missing blocks up to the read-ahead size.              */
+/* -------------------------------------------------------------------- */
+    if( hReadAheadThread != NULL )
+    {
+        WaitReadAhead();
+        while( IsCached(iBlock) )
+            iBlock++;
+    }
+
+    const vsi_l_offset nEnd = MIN( nOffset + nReadAheadSize, nFileSize );
+    size_t nBlockCount = 0;
+    while( (iBlock + nBlockCount) * m_nChunkSize < nEnd &&
+           !IsCached(iBlock + nBlockCount) )
+        nBlockCount++;
+
+    nReadAheadSize = MIN( 2 * nReadAheadSize, nReadAheadMax );
+    if( nBlockCount == 0 )
+        return;
+
+    if( bReadAheadThread )
+    {
+        VSICacheReadAheadJob *psJob = &sReadAheadJob;
+        psJob->pabyBuffer = static_cast<GByte *>(
+            VSIMalloc( nBlockCount * m_nChunkSize ) );
+        if( psJob->pabyBuffer == NULL )
+            return;
+        psJob->poBase = poBase;
+        psJob->nStartBlock = iBlock;
+        psJob->nBlockCount = nBlockCount;
+        psJob->nChunkSize = m_nChunkSize;
+        psJob->nDataRead = 0;
+        hReadAheadThread =
+            CPLCreateJoinableThread( VSICacheReadAheadThread, psJob );
+        if( hReadAheadThread == NULL )
+        {
+            CPLFree( psJob->pabyBuffer );
+            psJob->pabyBuffer = NULL;
+        }
+        return;
+    }
+
+    if( !LoadBlocks( iBlock, nBlockCount, NULL, 0 ) )
+        return;
+    for( size_t i = 0; i < nBlockCount; i++ )
+    {
+        VSICacheChunk *poBlock = oMapOffsetToCache[iBlock + i];
+        if( poBlock == NULL )
+            break;
+        poBlock->bReadAhead = true;
+        nReadAheadBytes += poBlock->nDataFilled;
+    }
+}
+
 /************************************************************************/
 /*                                Read()                                */
 /************************************************************************/
@@ -410,14 +658,32 @@ size_t VSICachedFile::Read( void * pBuffer, size_t nSize, size_t nCount )
 
     for( vsi_l_offset iBlock = nStartBlock; iBlock <= nEndBlock; iBlock++ )
     {
-        if( oMapOffsetToCache[iBlock] == NULL )
+        VSICacheChunk *poBlock = oMapOffsetToCache[iBlock];
+        if( poBlock == NULL && hReadAheadThread != NULL )
+        {
+            WaitReadAhead();
+            poBlock = oMapOffsetToCache[iBlock];
+        }
+        if( poBlock != NULL )
+        {
+            nChunkHits++;
+            if( poBlock->bReadAhead )
+            {
+                poBlock->bReadAhead = false;
+                nReadAheadBytesUsed += poBlock->nDataFilled;
+            }
+        }
+        else
         {
+            nChunkMisses++;
             size_t nBlocksToLoad = 1;
             while( iBlock + nBlocksToLoad <= nEndBlock
                    && (oMapOffsetToCache[iBlock+nBlocksToLoad] == NULL) )
                 nBlocksToLoad++;
 
             LoadBlocks( iBlock, nBlocksToLoad, pBuffer, nSize * nCount );
+            nChunkMisses += nBlocksToLoad - 1;
+            iBlock += nBlocksToLoad - 1;
         }
     }
 
@@ -434,6 +700,7 @@ size_t VSICachedFile::Read( void * pBuffer, size_t nSize, size_t nCount )
         {
             /* We can reach that point when the amount to read exceeds */
             /* the cache size */
+            CPLAssert( hReadAheadThread == NULL );
             LoadBlocks( iBlock, 1, ((GByte *) pBuffer) + nAmountCopied,
                         MIN(nSize * nCount - nAmountCopied, m_nChunkSize) );
             poBlock = oMapOffsetToCache[iBlock];
@@ -459,7 +726,24 @@ size_t VSICachedFile::Read( void * pBuffer, size_t nSize, size_t nCount )
         nAmountCopied += nThisCopy;
     }
 
+    const bool bSequential = nOffset >= nLastReadEnd &&
+                             nOffset - nLastReadEnd < m_nChunkSize;
     nOffset += nAmountCopied;
+    nLastReadEnd = nOffset;
+    nBytesRequested += nAmountCopied;
+
+/* -------------------------------------------------------------------- */
+/*      Read ahead after two sequential reads.                          */
+/* -------------------------------------------------------------------- */
+    if( !bSequential )
+    {
+        nSequentialReads = 0;
+        nReadAheadSize = 0;
+    }
+    else if( ++nSequentialReads >= 2 && nReadAheadMax > 0 )
+    {
+        ReadAhead();
+    }
 
 /* -------------------------------------------------------------------- */
 /*      Ensure the cache is reduced to our limit.                       */
@@ -504,6 +788,35 @@ int VSICachedFile::Flush()
     return 0;
 }
 
+/************************************************************************/
+/*                        GetCacheStatistics()                          */
+/************************************************************************/
+
+char **VSICachedFile::GetCacheStatistics()
+
+{
+    char **papszStats = NULL;
+    papszStats = CSLSetNameValue( papszStats, "BYTES_REQUESTED",
+                                  CPLSPrintf(CPL_FRMT_GUIB, nBytesRequested) );
+    papszStats = CSLSetNameValue( papszStats, "BYTES_READ",
+                                  CPLSPrintf(CPL_FRMT_GUIB, nBytesRead) );
+    papszStats = CSLSetNameValue( papszStats, "CHUNK_HITS",
+                                  CPLSPrintf(CPL_FRMT_GUIB, nChunkHits) );
+    papszStats = CSLSetNameValue( papszStats, "CHUNK_MISSES",
+                                  CPLSPrintf(CPL_FRMT_GUIB, nChunkMisses) );
+    papszStats = CSLSetNameValue( papszStats, "HIT_RATE",
+        CPLSPrintf("%.3f", (nChunkHits + nChunkMisses) ?
+            static_cast<double>(nChunkHits) / (nChunkHits + nChunkMisses) : 0.0) );
+    papszStats = CSLSetNameValue( papszStats, "READAHEAD_BYTES",
+                                  CPLSPrintf(CPL_FRMT_GUIB, nReadAheadBytes) );
+    papszStats = CSLSetNameValue( papszStats, "READAHEAD_BYTES_USED",
+                                  CPLSPrintf(CPL_FRMT_GUIB, nReadAheadBytesUsed) );
+    papszStats = CSLSetNameValue( papszStats, "READAHEAD_EFFICIENCY",
+        CPLSPrintf("%.3f", nReadAheadBytes ?
+            static_cast<double>(nReadAheadBytesUsed) / nReadAheadBytes : 0.0) );
+    return papszStats;
+}
+
 /************************************************************************/
 /*                        VSICreateCachedFile()                         */
 /************************************************************************/
@@ -70,6 +70,24 @@
    a .gz.properties file, so that we don't need to seek at the end of the file
    each time a Stat() is done.
 
+   Snapshots are lost when the handle is closed. With CPL_VSIL_GZIP_WRITE_INDEX=YES,
+   the first complete decompression of a .gz file also records "access points"
+   every CPL_VSIL_GZIP_INDEX_SPACING uncompressed bytes, at deflate block
+   boundaries, with the 32 KB of uncompressed data that precede them (as in
+   zlib's examples/zran.c). They are saved in a .gz.idx file (or in
+   CPL_VSIL_GZIP_INDEX_DIR), and later opens of the file use them to seek
+   without decompressing from the start.
+
+   With CPL_VSIL_GZIP_WRITE_THREADS=N (or ALL_CPUS), /vsigzip/ writes BGZF files
+   (the "Blocked GNU Zip Format" of htslib) : a series of gzip members of at most
+   64 KB, whose header records their size, and that regular gunzip can read. The
+   members are compressed in parallel by N threads. When reading a BGZF file,
+   seeks scan the member headers up to their target to map uncompressed offsets
+   to members, so that they only decompress the member they land in. With
+   CPL_VSIL_GZIP_READ_THREADS=N, large reads decompress whole members in
+   parallel, and so do small sequential reads, through a read-ahead buffer. The
+   N threads are shared by all the BGZF files being read.
+
    For .zip and .gz, both reading and writing are supported, but just one mode at a time
    (read-only or write-only)
 */
@@ -78,7 +96,10 @@
 #include "cpl_vsi_virtual.h"
 #include "cpl_string.h"
 #include "cpl_multiproc.h"
+#include "cpl_atomic_ops.h"
+#include "cpl_worker_thread_pool.h"
 #include <map>
+#include <vector>
 
 #include <zlib.h>
 #include "cpl_minizip_unzip.h"
@@ -105,6 +126,40 @@ static int const gz_magic[2] = {0x1f, 0x8b}; /* gzip magic header */
 
 #define ENABLE_DEBUG 0
 
+/* BGZF members: header with a "BC" extra subfield holding the member size */
+/* minus 1, raw deflate data, CRC32 and uncompressed size */
+#define BGZF_BLOCK_SIZE      65536
+#define BGZF_MAX_INPUT_SIZE  0xff00  /* so that even stored data fits in a block */
+#define BGZF_HEADER_SIZE     18
+#define BGZF_TRAILER_SIZE    8
+
+static const GByte abyBGZFHeader[BGZF_HEADER_SIZE] =
+    { 0x1f, 0x8b, 8, EXTRA_FIELD, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0, 0 };
+
+/* Empty member that terminates BGZF files */
+static const GByte abyBGZFEOF[BGZF_HEADER_SIZE + BGZF_TRAILER_SIZE + 2] =
+    { 0x1f, 0x8b, 8, EXTRA_FIELD, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0,
+      0x1b, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+/* Minimum size of a read for the parallel decompression of BGZF members */
+#define BGZF_PARALLEL_READ_MIN  (4 * BGZF_BLOCK_SIZE)
+
+/************************************************************************/
+/*                       VSIGZipGetThreadCount()                        */
+/************************************************************************/
+
+/* Value of a configuration option that is a number of threads or ALL_CPUS, */
+/* or 0 if it is not set */
+static int VSIGZipGetThreadCount( const char* pszConfigOption )
+{
+    const char* pszValue = CPLGetConfigOption(pszConfigOption, NULL);
+    if( pszValue == NULL )
+        return 0;
+    const int nThreads =
+        EQUAL(pszValue, "ALL_CPUS") ? CPLGetNumCPUs() : atoi(pszValue);
+    return MAX(1, MIN(128, nThreads));
+}
+
 /************************************************************************/
 /* ==================================================================== */
 /*                       VSIGZipHandle                                  */
@@ -121,6 +176,259 @@ typedef struct
     vsi_l_offset  out;
 } GZipSnapshot;
 
+/************************************************************************/
+/* ==================================================================== */
+/*                          VSIGZipIndex                                */
+/* ==================================================================== */
+/************************************************************************/
+
+#define GZIP_INDEX_WINDOW_SIZE 32768
+
+/* Point of the compressed stream from which inflation can restart */
+typedef struct
+{
+    vsi_l_offset  nFileOffset;  /* of the first byte that is not fully consumed */
+    int           nBits;        /* number of bits of that byte not yet consumed */
+    vsi_l_offset  in;
+    vsi_l_offset  out;
+    uLong         crc;
+    GUInt32       nWindowSize;
+    std::vector<GByte> abyCompressedWindow;
+    GUInt32       nDeflateSize; /* BGZF: size of the deflate data of the member */
+} GZipIndexPoint;
+
+/* Access points of a whole .gz file, shared between the handles that */
+/* are duplicated from each other once complete. */
+class VSIGZipIndex
+{
+    volatile int nRefCount;
+
+  public:
+    vsi_l_offset nCompressedSize;
+    vsi_l_offset nUncompressedSize;
+    GIntBig      nMTime;
+    bool         bBGZF;  /* points are the non-empty members of a BGZF file */
+    /* A BGZF index is extended as the file is read: until it is complete, */
+    /* nUncompressedSize is the uncompressed offset of the next member */
+    /* to scan, at nNextMemberPos in the file. */
+    bool         bComplete;
+    vsi_l_offset nNextMemberPos;
+    std::vector<GZipIndexPoint> asPoints;
+
+    VSIGZipIndex() : nRefCount(1), nCompressedSize(0),
+                     nUncompressedSize(0), nMTime(0), bBGZF(false),
+                     bComplete(true), nNextMemberPos(0) {}
+
+    void Reference() { CPLAtomicInc(&nRefCount); }
+    void Release() { if( CPLAtomicDec(&nRefCount) == 0 ) delete this; }
+
+    const GZipIndexPoint* FindPoint( vsi_l_offset nOut ) const;
+    bool                  Save( const char* pszFilename ) const;
+    static VSIGZipIndex*  Load( const char* pszFilename );
+};
+
+static const char szGZipIndexMagic[8] = { 'G', 'D', 'A', 'L', 'G', 'Z', 'I', '1' };
+
+/************************************************************************/
+/*                     VSIGZipGetIndexFilename()                        */
+/************************************************************************/
+
+static CPLString VSIGZipGetIndexFilename( const char* pszBaseFileName )
+{
+    const char* pszDir = CPLGetConfigOption("CPL_VSIL_GZIP_INDEX_DIR", NULL);
+    if( pszDir == NULL || pszDir[0] == '\0' )
+        return CPLString(pszBaseFileName) + ".idx";
+
+    /* Add a hash of the full path, so that files with the same name in */
+    /* different directories do not share their index */
+    const unsigned int nHash = static_cast<unsigned int>(
+        crc32(0L, reinterpret_cast<const Bytef*>(pszBaseFileName),
+              static_cast<uInt>(strlen(pszBaseFileName))));
+    return CPLFormFilename(pszDir,
+                           CPLSPrintf("%s.%08X.idx",
+                                      CPLGetFilename(pszBaseFileName), nHash),
+                           NULL);
+}
+
+/************************************************************************/
+/*                            FindPoint()                               */
+/************************************************************************/
+
+/* Return the last access point at or before the uncompressed offset nOut */
+const GZipIndexPoint* VSIGZipIndex::FindPoint( vsi_l_offset nOut ) const
+{
+    size_t nLow = 0;
+    size_t nHigh = asPoints.size();
+    while( nLow < nHigh )
+    {
+        const size_t nMid = (nLow + nHigh) / 2;
+        if( asPoints[nMid].out <= nOut )
+            nLow = nMid + 1;
+        else
+            nHigh = nMid;
+    }
+    return nLow == 0 ? NULL : &asPoints[nLow - 1];
+}
+
+/************************************************************************/
+/*                               Save()                                 */
+/************************************************************************/
+
+static bool VSIGZipIndexWrite64( VSILFILE* fp, GUIntBig nVal )
+{
+    CPL_LSBPTR64(&nVal);
+    return VSIFWriteL(&nVal, 1, sizeof(nVal), fp) == sizeof(nVal);
+}
+
+static bool VSIGZipIndexWrite32( VSILFILE* fp, GUInt32 nVal )
+{
+    CPL_LSBPTR32(&nVal);
+    return VSIFWriteL(&nVal, 1, sizeof(nVal), fp) == sizeof(nVal);
+}
+
+bool VSIGZipIndex::Save( const char* pszFilename ) const
+{
+    /* Write in a temporary file renamed at the end, so that other */
+    /* processes never see a partial index */
+    const CPLString osTmpFilename(
+        CPLSPrintf("%s.tmp" CPL_FRMT_GIB, pszFilename, CPLGetPID()));
+    VSILFILE* fp = VSIFOpenL(osTmpFilename, "wb");
+    if( fp == NULL )
+        return false;
+
+    bool bOK = VSIFWriteL(szGZipIndexMagic, 1, sizeof(szGZipIndexMagic), fp)
+                                                == sizeof(szGZipIndexMagic);
+    bOK &= VSIGZipIndexWrite64(fp, nCompressedSize);
+    bOK &= VSIGZipIndexWrite64(fp, nUncompressedSize);
+    bOK &= VSIGZipIndexWrite64(fp, static_cast<GUIntBig>(nMTime));
+    bOK &= VSIGZipIndexWrite32(fp, static_cast<GUInt32>(asPoints.size()));
+    for( size_t i = 0; bOK && i < asPoints.size(); i++ )
+    {
+        const GZipIndexPoint& oPoint = asPoints[i];
+        bOK &= VSIGZipIndexWrite64(fp, oPoint.nFileOffset);
+        bOK &= VSIGZipIndexWrite32(fp, static_cast<GUInt32>(oPoint.nBits));
+        bOK &= VSIGZipIndexWrite64(fp, oPoint.in);
+        bOK &= VSIGZipIndexWrite64(fp, oPoint.out);
+        bOK &= VSIGZipIndexWrite32(fp, static_cast<GUInt32>(oPoint.crc));
+        bOK &= VSIGZipIndexWrite32(fp, oPoint.nWindowSize);
+        bOK &= VSIGZipIndexWrite32(fp,
+                    static_cast<GUInt32>(oPoint.abyCompressedWindow.size()));
+        if( bOK && !oPoint.abyCompressedWindow.empty() )
+        {
+            bOK = VSIFWriteL(&oPoint.abyCompressedWindow[0], 1,
+                             oPoint.abyCompressedWindow.size(), fp) ==
+                                    oPoint.abyCompressedWindow.size();
+        }
+    }
+    bOK &= VSIFCloseL(fp) == 0;
+
+    if( bOK )
+        bOK = VSIRename(osTmpFilename, pszFilename) == 0;
+    if( !bOK )
+        VSIUnlink(osTmpFilename);
+    return bOK;
+}
+
+/************************************************************************/
+/*                               Load()                                 */
+/************************************************************************/
+
+static bool VSIGZipIndexRead64( VSILFILE* fp, GUIntBig* pnVal )
+{
+    if( VSIFReadL(pnVal, 1, sizeof(*pnVal), fp) != sizeof(*pnVal) )
+        return false;
+    CPL_LSBPTR64(pnVal);
+    return true;
+}
+
+static bool VSIGZipIndexRead32( VSILFILE* fp, GUInt32* pnVal )
+{
+    if( VSIFReadL(pnVal, 1, sizeof(*pnVal), fp) != sizeof(*pnVal) )
+        return false;
+    CPL_LSBPTR32(pnVal);
+    return true;
+}
+
+VSIGZipIndex* VSIGZipIndex::Load( const char* pszFilename )
+{
+    VSIStatBufL sStat;
+    if( VSIStatExL(pszFilename, &sStat, VSI_STAT_EXISTS_FLAG) != 0 )
+        return NULL;
+    VSILFILE* fp = VSIFOpenL(pszFilename, "rb");
+    if( fp == NULL )
+        return NULL;
+
+    VSIGZipIndex* poIndex = new VSIGZipIndex();
+    char szMagic[sizeof(szGZipIndexMagic)];
+    GUIntBig nMTime = 0;
+    GUInt32 nPoints = 0;
+    bool bOK = VSIFReadL(szMagic, 1, sizeof(szMagic), fp) == sizeof(szMagic) &&
+               memcmp(szMagic, szGZipIndexMagic, sizeof(szMagic)) == 0 &&
+               VSIGZipIndexRead64(fp, &poIndex->nCompressedSize) &&
+               VSIGZipIndexRead64(fp, &poIndex->nUncompressedSize) &&
+               VSIGZipIndexRead64(fp, &nMTime) &&
+               VSIGZipIndexRead32(fp, &nPoints);
+    poIndex->nMTime = static_cast<GIntBig>(nMTime);
+
+    for( GUInt32 i = 0; bOK && i < nPoints; i++ )
+    {
+        GZipIndexPoint oPoint;
+        GUInt32 nBits = 0;
+        GUInt32 nCRC = 0;
+        GUInt32 nCompressedWindowSize = 0;
+        bOK = VSIGZipIndexRead64(fp, &oPoint.nFileOffset) &&
+              VSIGZipIndexRead32(fp, &nBits) &&
+              VSIGZipIndexRead64(fp, &oPoint.in) &&
+              VSIGZipIndexRead64(fp, &oPoint.out) &&
+              VSIGZipIndexRead32(fp, &nCRC) &&
+              VSIGZipIndexRead32(fp, &oPoint.nWindowSize) &&
+              VSIGZipIndexRead32(fp, &nCompressedWindowSize) &&
+              nBits < 8 && oPoint.nWindowSize <= GZIP_INDEX_WINDOW_SIZE &&
+              nCompressedWindowSize <= 2 * GZIP_INDEX_WINDOW_SIZE &&
+              (i == 0 || oPoint.out > poIndex->asPoints.back().out);
+        if( !bOK )
+            break;
+        oPoint.nBits = static_cast<int>(nBits);
+        oPoint.crc = nCRC;
+        oPoint.nDeflateSize = 0;
+        poIndex->asPoints.push_back(oPoint);
+        if( nCompressedWindowSize )
+        {
+            std::vector<GByte>& abyWindow =
+                poIndex->asPoints.back().abyCompressedWindow;
+            abyWindow.resize(nCompressedWindowSize);
+            bOK = VSIFReadL(&abyWindow[0], 1, nCompressedWindowSize, fp) ==
+                                                        nCompressedWindowSize;
+        }
+    }
+    CPL_IGNORE_RET_VAL(VSIFCloseL(fp));
+
+    if( !bOK )
+    {
+        CPLDebug("GZIP", "%s is not a valid index", pszFilename);
+        poIndex->Release();
+        return NULL;
+    }
+    return poIndex;
+}
+
+/* Decompression of a BGZF member by a worker thread */
+typedef struct
+{
+    z_stream      sStream;
+    bool          bStreamInit;
+    const GByte  *pabyIn;        /* deflate data, followed by the trailer */
+    size_t        nInSize;       /* of the deflate data */
+    GByte        *pabyOut;
+    size_t        nOutSize;
+    bool          bOK;
+    /* The pool is shared by all the handles: each one waits for its own */
+    /* jobs, counted in *pnPending, which is signaled at 0 */
+    CPLMutex     *hMutex;
+    CPLCond      *hCond;
+    volatile int *pnPending;
+} VSIBGZFInflateJob;
+
 class VSIGZipHandle CPL_FINAL : public VSIVirtualHandle
 {
     VSIVirtualHandle* m_poBaseHandle;
@@ -148,10 +456,47 @@ class VSIGZipHandle CPL_FINAL : public VSIVirtualHandle
     GZipSnapshot* snapshots;
     vsi_l_offset snapshot_byte_interval; /* number of compressed bytes at which we create a "snapshot" */
 
+    VSIGZipIndex* m_poIndex;          /* complete index, or the one being built */
+    bool          m_bBuildIndex;
+    vsi_l_offset  m_nIndexSpacing;    /* uncompressed bytes between access points */
+    GByte        *m_pabyIndexWindow;  /* circular buffer of the last uncompressed bytes */
+    GByte        *m_pabyIndexWork;    /* window and its compressed copy, for UpdateIndex() */
+    size_t        m_nIndexWindowPos;
+    size_t        m_nIndexWindowFill;
+    vsi_l_offset  m_nIndexWindowOut;  /* value of out after the last byte of the window */
+    bool          m_bIndexWindowFromStart;
+
+    bool          m_bBGZF;            /* the first member has a "BC" subfield */
+    CPLWorkerThreadPool *m_poBGZFThreadPool;  /* shared, not owned */
+    VSIBGZFInflateJob   *m_pasBGZFJobs;
+    int                  m_nBGZFJobs;
+    CPLMutex            *m_hBGZFJobMutex;
+    CPLCond             *m_hBGZFJobCond;
+    volatile int         m_nBGZFPendingJobs;
+    std::vector<GByte>   m_abyBGZFBuffer;
+
+    /* Members decompressed ahead of small sequential reads. While the */
+    /* buffer is not empty, the position of the handle is */
+    /* m_nBGZFAheadOut + m_nBGZFAheadPos, and out is at the end of the buffer */
+    std::vector<GByte>   m_abyBGZFAhead;
+    size_t               m_nBGZFAheadPos;
+    vsi_l_offset         m_nBGZFAheadOut;
+    vsi_l_offset         m_nBGZFLastReadEnd;  /* to detect sequential reads */
+
+    void UpdateIndex( const Bytef* pabyNewData, const Bytef* pStart );
+    void SaveIndex();
+    bool RestoreIndexPoint( const GZipIndexPoint& oPoint );
+
+    bool ExtendBGZFIndex( vsi_l_offset nTargetOut );
+    bool InitBGZFThreadPool();
+    size_t ReadBGZF( GByte* pabyBuffer, size_t nToRead );
+    bool FillBGZFReadAhead();
+
     void check_header();
     int get_byte();
     int gzseek( vsi_l_offset nOffset, int nWhence );
     int gzrewind ();
+    size_t gzread( void *pBuffer, size_t nSize, size_t nMemb );
     uLong getLong ();
 
   public:
@@ -185,6 +530,8 @@ class VSIGZipHandle CPL_FINAL : public VSIVirtualHandle
     vsi_l_offset      GetUncompressedSize() { return m_uncompressed_size; }
 
     void              SaveInfo_unlocked();
+
+    void              InitIndex();
 };
 
 
@@ -248,6 +595,13 @@ VSIGZipHandle* VSIGZipHandle::Duplicate()
 
     poHandle->m_nLastReadOffset = m_nLastReadOffset;
 
+    /* A BGZF index that is still being extended belongs to its handle */
+    if( m_poIndex != NULL && !m_bBuildIndex && m_poIndex->bComplete )
+    {
+        m_poIndex->Reference();
+        poHandle->m_poIndex = m_poIndex;
+    }
+
     /* Most important : duplicate the snapshots ! */
 
     for(unsigned int i=0;i<m_compressed_size / snapshot_byte_interval + 1;i++)
@@ -329,6 +683,25 @@ VSIGZipHandle::VSIGZipHandle(VSIVirtualHandle* poBaseHandle,
     m_transparent = transparent;
     startOff = 0;
     snapshots = NULL;
+    m_poIndex = NULL;
+    m_bBuildIndex = false;
+    m_nIndexSpacing = 0;
+    m_pabyIndexWindow = NULL;
+    m_pabyIndexWork = NULL;
+    m_nIndexWindowPos = 0;
+    m_nIndexWindowFill = 0;
+    m_nIndexWindowOut = 0;
+    m_bIndexWindowFromStart = true;
+    m_bBGZF = false;
+    m_poBGZFThreadPool = NULL;
+    m_pasBGZFJobs = NULL;
+    m_nBGZFJobs = 0;
+    m_hBGZFJobMutex = NULL;
+    m_hBGZFJobCond = NULL;
+    m_nBGZFPendingJobs = 0;
+    m_nBGZFAheadPos = 0;
+    m_nBGZFAheadOut = 0;
+    m_nBGZFLastReadEnd = ~((vsi_l_offset)0);
 
     stream.next_in  = inbuf = (Byte*)ALLOC(Z_BUFSIZE);
 
@@ -403,12 +776,577 @@ VSIGZipHandle::~VSIGZipHandle()
         }
         CPLFree(snapshots);
     }
+    if (m_poIndex != NULL)
+        m_poIndex->Release();
+    CPLFree(m_pabyIndexWindow);
+    CPLFree(m_pabyIndexWork);
+    for (int i = 0; i < m_nBGZFJobs; i++)
+    {
+        if (m_pasBGZFJobs[i].bStreamInit)
+            inflateEnd(&m_pasBGZFJobs[i].sStream);
+    }
+    CPLFree(m_pasBGZFJobs);
+    if (m_hBGZFJobCond != NULL)
+        CPLDestroyCond(m_hBGZFJobCond);
+    if (m_hBGZFJobMutex != NULL)
+        CPLDestroyMutex(m_hBGZFJobMutex);
     CPLFree(m_pszBaseFileName);
 
     if (m_poBaseHandle)
         CPL_IGNORE_RET_VAL(VSIFCloseL((VSILFILE*)m_poBaseHandle));
 }
 
+/************************************************************************/
+/*                            InitIndex()                               */
+/************************************************************************/
+
+/* Load the index of the .gz file if there is an up-to-date one, or */
+/* prepare to build it during the first decompression of the file. */
+void VSIGZipHandle::InitIndex()
+{
+    /* BGZF files are indexed by their member headers */
+    if (m_pszBaseFileName == NULL || m_transparent || m_offset != 0 ||
+        out != 0 || m_bBGZF)
+        return;
+
+    VSIStatBufL sStat;
+    if (VSIStatL(m_pszBaseFileName, &sStat) != 0)
+        return;
+    const CPLString osIndexFilename(VSIGZipGetIndexFilename(m_pszBaseFileName));
+
+    if (CPLTestBool(CPLGetConfigOption("CPL_VSIL_GZIP_USE_INDEX", "YES")))
+    {
+        VSIGZipIndex* poIndex = VSIGZipIndex::Load(osIndexFilename);
+        if (poIndex != NULL)
+        {
+            if (poIndex->nCompressedSize == m_compressed_size &&
+                poIndex->nMTime == static_cast<GIntBig>(sStat.st_mtime))
+            {
+                m_poIndex = poIndex;
+                if (m_uncompressed_size == 0)
+                    m_uncompressed_size = poIndex->nUncompressedSize;
+                return;
+            }
+            CPLDebug("GZIP", "%s is out of date", osIndexFilename.c_str());
+            poIndex->Release();
+        }
+    }
+
+    if (CPLTestBool(CPLGetConfigOption("CPL_VSIL_GZIP_WRITE_INDEX", "NO")))
+    {
+        const char* pszSpacing =
+            CPLGetConfigOption("CPL_VSIL_GZIP_INDEX_SPACING", "1048576");
+        m_nIndexSpacing = MAX(GZIP_INDEX_WINDOW_SIZE,
+                              CPLScanUIntBig(pszSpacing,
+                                    static_cast<int>(strlen(pszSpacing))));
+        m_pabyIndexWindow =
+            static_cast<GByte*>(VSI_MALLOC_VERBOSE(GZIP_INDEX_WINDOW_SIZE));
+        if (m_pabyIndexWindow == NULL)
+            return;
+        m_pabyIndexWork =
+            static_cast<GByte*>(VSI_MALLOC_VERBOSE(3 * GZIP_INDEX_WINDOW_SIZE));
+        if (m_pabyIndexWork == NULL)
+        {
+            CPLFree(m_pabyIndexWindow);
+            m_pabyIndexWindow = NULL;
+            return;
+        }
+        m_poIndex = new VSIGZipIndex();
+        m_poIndex->nCompressedSize = m_compressed_size;
+        m_poIndex->nMTime = static_cast<GIntBig>(sStat.st_mtime);
+        m_bBuildIndex = true;
+    }
+}
+
+/************************************************************************/
+/*                           UpdateIndex()                              */
+/************************************************************************/
+
+/* Called after each inflate() call while building the index, with the */
+/* data it has just produced. */
+void VSIGZipHandle::UpdateIndex( const Bytef* pabyNewData, const Bytef* pStart )
+{
+    size_t nNew = static_cast<size_t>(stream.next_out - pabyNewData);
+    if (out - nNew != m_nIndexWindowOut)
+    {
+        /* After a seek: restart the window */
+        m_nIndexWindowFill = 0;
+        m_bIndexWindowFromStart = (out - nNew == 0);
+    }
+    if (nNew > GZIP_INDEX_WINDOW_SIZE)
+    {
+        pabyNewData += nNew - GZIP_INDEX_WINDOW_SIZE;
+        nNew = GZIP_INDEX_WINDOW_SIZE;
+    }
+    const size_t nFirst = MIN(nNew, GZIP_INDEX_WINDOW_SIZE - m_nIndexWindowPos);
+    memcpy(m_pabyIndexWindow + m_nIndexWindowPos, pabyNewData, nFirst);
+    memcpy(m_pabyIndexWindow, pabyNewData + nFirst, nNew - nFirst);
+    m_nIndexWindowPos = (m_nIndexWindowPos + nNew) % GZIP_INDEX_WINDOW_SIZE;
+    m_nIndexWindowFill = MIN(GZIP_INDEX_WINDOW_SIZE, m_nIndexWindowFill + nNew);
+    m_nIndexWindowOut = out;
+
+    /* Add an access point if we are at the end of a block that is not */
+    /* the last one of the deflate stream, with a complete window */
+    if (z_err != Z_OK || (stream.data_type & 128) == 0 ||
+        (stream.data_type & 64) != 0)
+        return;
+    if (m_nIndexWindowFill < GZIP_INDEX_WINDOW_SIZE && !m_bIndexWindowFromStart)
+        return;
+    const vsi_l_offset nLastOut =
+        m_poIndex->asPoints.empty() ? 0 : m_poIndex->asPoints.back().out;
+    if (out < nLastOut + m_nIndexSpacing)
+        return;
+
+    /* The window is made contiguous, then compressed, in m_pabyIndexWork */
+    GByte* const pabyWindow = m_pabyIndexWork;
+    GByte* const pabyCompressedWindow = m_pabyIndexWork + GZIP_INDEX_WINDOW_SIZE;
+    const size_t nCompressedWindowMax = 2 * GZIP_INDEX_WINDOW_SIZE;
+    const size_t nStart = (m_nIndexWindowPos + GZIP_INDEX_WINDOW_SIZE -
+                           m_nIndexWindowFill) % GZIP_INDEX_WINDOW_SIZE;
+    const size_t nFirstPart = MIN(m_nIndexWindowFill,
+                                  GZIP_INDEX_WINDOW_SIZE - nStart);
+    memcpy(pabyWindow, m_pabyIndexWindow + nStart, nFirstPart);
+    memcpy(pabyWindow + nFirstPart, m_pabyIndexWindow,
+           m_nIndexWindowFill - nFirstPart);
+
+    size_t nCompressedSize = 0;
+    if (m_nIndexWindowFill != 0 &&
+        CPLZLibDeflate(pabyWindow, m_nIndexWindowFill, -1,
+                       pabyCompressedWindow, nCompressedWindowMax,
+                       &nCompressedSize) == NULL)
+        return;
+
+    GZipIndexPoint oPoint;
+    oPoint.nFileOffset = VSIFTellL((VSILFILE*)m_poBaseHandle) - stream.avail_in;
+    oPoint.nBits = stream.data_type & 7;
+    oPoint.in = in;
+    oPoint.out = out;
+    oPoint.crc = crc32(crc, pStart, (uInt) (stream.next_out - pStart));
+    oPoint.nWindowSize = static_cast<GUInt32>(m_nIndexWindowFill);
+    oPoint.nDeflateSize = 0;
+    oPoint.abyCompressedWindow.assign(pabyCompressedWindow,
+                                      pabyCompressedWindow + nCompressedSize);
+    m_poIndex->asPoints.push_back(oPoint);
+}
+
+/************************************************************************/
+/*                            SaveIndex()                               */
+/************************************************************************/
+
+/* Called when the end of the file has been reached while building the */
+/* index. */
+void VSIGZipHandle::SaveIndex()
+{
+    m_bBuildIndex = false;
+    m_poIndex->nUncompressedSize = out;
+    if (m_uncompressed_size == 0)
+        m_uncompressed_size = out;
+
+    const CPLString osIndexFilename(VSIGZipGetIndexFilename(m_pszBaseFileName));
+    if (!m_poIndex->asPoints.empty() && !m_poIndex->Save(osIndexFilename))
+    {
+        CPLDebug("GZIP", "Cannot write %s", osIndexFilename.c_str());
+    }
+}
+
+/************************************************************************/
+/*                        RestoreIndexPoint()                           */
+/************************************************************************/
+
+bool VSIGZipHandle::RestoreIndexPoint( const GZipIndexPoint& oPoint )
+{
+    if (m_pabyIndexWindow == NULL && oPoint.nWindowSize != 0)
+    {
+        m_pabyIndexWindow =
+            static_cast<GByte*>(VSI_MALLOC_VERBOSE(GZIP_INDEX_WINDOW_SIZE));
+        if (m_pabyIndexWindow == NULL)
+            return false;
+    }
+    size_t nWindowSize = 0;
+    if (oPoint.nWindowSize != 0 &&
+        (CPLZLibInflate(&oPoint.abyCompressedWindow[0],
+                        oPoint.abyCompressedWindow.size(),
+                        m_pabyIndexWindow, GZIP_INDEX_WINDOW_SIZE,
+                        &nWindowSize) == NULL ||
+         nWindowSize != oPoint.nWindowSize))
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "Corrupted gzip index");
+        return false;
+    }
+
+    const vsi_l_offset nSeekPos = oPoint.nFileOffset - (oPoint.nBits ? 1 : 0);
+    if (VSIFSeekL((VSILFILE*)m_poBaseHandle, nSeekPos, SEEK_SET) != 0)
+        return false;
+    inflateReset(&stream);
+    stream.avail_in = 0;
+    stream.next_in = inbuf;
+    if (oPoint.nBits)
+    {
+        GByte c = 0;
+        if (VSIFReadL(&c, 1, 1, (VSILFILE*)m_poBaseHandle) != 1)
+            return false;
+        inflatePrime(&stream, oPoint.nBits, c >> (8 - oPoint.nBits));
+    }
+    if (nWindowSize != 0 &&
+        inflateSetDictionary(&stream, m_pabyIndexWindow,
+                             static_cast<uInt>(nWindowSize)) != Z_OK)
+        return false;
+
+    z_err = Z_OK;
+    z_eof = 0;
+    crc = oPoint.crc;
+    m_transparent = 0;
+    in = oPoint.in;
+    out = oPoint.out;
+    return true;
+}
+
+/************************************************************************/
+/*                          ExtendBGZFIndex()                           */
+/************************************************************************/
+
+/* Scan the member headers of a BGZF file, to create an access point at */
+/* the start of each member, until there is one after nTargetOut, so that */
+/* a seek does not wait for the scan of the whole file. */
+bool VSIGZipHandle::ExtendBGZFIndex( vsi_l_offset nTargetOut )
+{
+    if (m_poIndex == NULL)
+    {
+        m_poIndex = new VSIGZipIndex();
+        m_poIndex->bBGZF = true;
+        m_poIndex->bComplete = false;
+        m_poIndex->nCompressedSize = m_compressed_size;
+        m_poIndex->nNextMemberPos = m_offset;
+    }
+    VSIGZipIndex* poIndex = m_poIndex;
+    if (poIndex->bComplete ||
+        (!poIndex->asPoints.empty() && poIndex->asPoints.back().out > nTargetOut))
+        return true;
+
+    VSILFILE* fp = (VSILFILE*)m_poBaseHandle;
+    const vsi_l_offset nSavedPos = VSIFTellL(fp);
+
+    vsi_l_offset nPos = poIndex->nNextMemberPos;
+    vsi_l_offset nOut = poIndex->nUncompressedSize;
+    bool bOK = true;
+    while (bOK && nPos < offsetEndCompressedData &&
+           (poIndex->asPoints.empty() || poIndex->asPoints.back().out <= nTargetOut))
+    {
+        GByte abyHeader[BGZF_HEADER_SIZE];
+        bOK = VSIFSeekL(fp, nPos, SEEK_SET) == 0 &&
+              VSIFReadL(abyHeader, 1, BGZF_HEADER_SIZE, fp) == BGZF_HEADER_SIZE &&
+              memcmp(abyHeader, abyBGZFHeader, 4) == 0;
+        if (!bOK)
+            break;
+
+        /* Look for the "BC" subfield in the extra field */
+        const int nXLen = abyHeader[10] | (abyHeader[11] << 8);
+        std::vector<GByte> abyExtra(abyHeader + 12, abyHeader + BGZF_HEADER_SIZE);
+        if (nXLen != 6)
+        {
+            abyExtra.resize(nXLen);
+            bOK = VSIFSeekL(fp, nPos + 12, SEEK_SET) == 0 &&
+                  (nXLen == 0 ||
+                   VSIFReadL(&abyExtra[0], 1, nXLen, fp) == (size_t)nXLen);
+        }
+        int nBlockSize = 0;
+        for (int i = 0; bOK && i + 4 <= nXLen; )
+        {
+            const int nSubLen = abyExtra[i + 2] | (abyExtra[i + 3] << 8);
+            if (abyExtra[i] == 'B' && abyExtra[i + 1] == 'C' && nSubLen == 2 &&
+                i + 6 <= nXLen)
+            {
+                nBlockSize = (abyExtra[i + 4] | (abyExtra[i + 5] << 8)) + 1;
+                break;
+            }
+            i += 4 + nSubLen;
+        }
+        const int nHeaderSize = 12 + nXLen;
+        bOK = bOK && nBlockSize >= nHeaderSize + BGZF_TRAILER_SIZE &&
+              nPos + nBlockSize <= offsetEndCompressedData;
+
+        /* Uncompressed size of the member */
+        GUInt32 nISize = 0;
+        bOK = bOK &&
+              VSIFSeekL(fp, nPos + nBlockSize - 4, SEEK_SET) == 0 &&
+              VSIFReadL(&nISize, 1, 4, fp) == 4;
+        CPL_LSBPTR32(&nISize);
+        bOK = bOK && nISize <= BGZF_BLOCK_SIZE;
+        if (bOK && nISize != 0)
+        {
+            GZipIndexPoint oPoint;
+            oPoint.nFileOffset = nPos + nHeaderSize;
+            oPoint.nBits = 0;
+            oPoint.in = oPoint.nFileOffset - startOff;
+            oPoint.out = nOut;
+            oPoint.crc = crc32(0L, NULL, 0);
+            oPoint.nWindowSize = 0;
+            oPoint.nDeflateSize = nBlockSize - nHeaderSize - BGZF_TRAILER_SIZE;
+            poIndex->asPoints.push_back(oPoint);
+        }
+        nOut += nISize;
+        nPos += nBlockSize;
+    }
+
+    if (VSIFSeekL(fp, nSavedPos, SEEK_SET) != 0)
+        bOK = false;
+    if (!bOK)
+    {
+        /* The file is still read as a regular .gz one */
+        CPLDebug("GZIP", "%s is not a valid BGZF file",
+                 m_pszBaseFileName ? m_pszBaseFileName : "");
+        poIndex->Release();
+        m_poIndex = NULL;
+        m_bBGZF = false;
+        return false;
+    }
+
+    poIndex->nNextMemberPos = nPos;
+    poIndex->nUncompressedSize = nOut;
+    if (nPos >= offsetEndCompressedData)
+    {
+        poIndex->bComplete = true;
+        if (m_uncompressed_size == 0)
+            m_uncompressed_size = nOut;
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                     VSIGZipGetBGZFThreadPool()                       */
+/************************************************************************/
+
+/* Worker threads shared by all the handles reading BGZF files, created */
+/* at first use with CPL_VSIL_GZIP_READ_THREADS threads, and destroyed */
+/* with the /vsigzip/ handler. */
+static CPLMutex* hBGZFThreadPoolMutex = NULL;
+static CPLWorkerThreadPool* poBGZFThreadPool = NULL;
+static int nBGZFThreadPoolThreads = 0;
+
+static CPLWorkerThreadPool* VSIGZipGetBGZFThreadPool( int nThreads )
+{
+    CPLMutexHolderD(&hBGZFThreadPoolMutex);
+    if (poBGZFThreadPool == NULL)
+    {
+        poBGZFThreadPool = new CPLWorkerThreadPool();
+        if (!poBGZFThreadPool->Setup(nThreads, NULL, NULL))
+        {
+            delete poBGZFThreadPool;
+            poBGZFThreadPool = NULL;
+            return NULL;
+        }
+        nBGZFThreadPoolThreads = nThreads;
+    }
+    return poBGZFThreadPool;
+}
+
+static void VSIGZipDestroyBGZFThreadPool()
+{
+    delete poBGZFThreadPool;
+    poBGZFThreadPool = NULL;
+    nBGZFThreadPoolThreads = 0;
+    if (hBGZFThreadPoolMutex != NULL)
+        CPLDestroyMutex(hBGZFThreadPoolMutex);
+    hBGZFThreadPoolMutex = NULL;
+}
+
+/************************************************************************/
+/*                        InitBGZFThreadPool()                          */
+/************************************************************************/
+
+bool VSIGZipHandle::InitBGZFThreadPool()
+{
+    if (m_poBGZFThreadPool != NULL)
+        return true;
+
+    const int nThreads = VSIGZipGetThreadCount("CPL_VSIL_GZIP_READ_THREADS");
+    if (nThreads == 0)
+        return false;
+    m_poBGZFThreadPool = VSIGZipGetBGZFThreadPool(nThreads);
+    if (m_poBGZFThreadPool == NULL)
+        return false;
+    m_hBGZFJobMutex = CPLCreateMutex();
+    CPLReleaseMutex(m_hBGZFJobMutex);
+    m_hBGZFJobCond = CPLCreateCond();
+    /* Up to two members per thread of the pool, that may have been */
+    /* created with another thread count */
+    {
+        CPLMutexHolderD(&hBGZFThreadPoolMutex);
+        m_nBGZFJobs = 2 * nBGZFThreadPoolThreads;
+    }
+    m_pasBGZFJobs = static_cast<VSIBGZFInflateJob*>(
+        CPLCalloc(m_nBGZFJobs, sizeof(VSIBGZFInflateJob)));
+    for (int i = 0; i < m_nBGZFJobs; i++)
+    {
+        m_pasBGZFJobs[i].hMutex = m_hBGZFJobMutex;
+        m_pasBGZFJobs[i].hCond = m_hBGZFJobCond;
+        m_pasBGZFJobs[i].pnPending = &m_nBGZFPendingJobs;
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                          BGZFInflateJob()                            */
+/************************************************************************/
+
+static bool BGZFInflate( VSIBGZFInflateJob* psJob )
+{
+    if (!psJob->bStreamInit)
+    {
+        if (inflateInit2(&psJob->sStream, -MAX_WBITS) != Z_OK)
+            return false;
+        psJob->bStreamInit = true;
+    }
+    else if (inflateReset(&psJob->sStream) != Z_OK)
+        return false;
+
+    /* The trailer is given to inflate() too, as a raw deflate stream */
+    /* needs an extra byte after its end with old zlib versions */
+    psJob->sStream.next_in = (Bytef*)psJob->pabyIn;
+    psJob->sStream.avail_in = static_cast<uInt>(psJob->nInSize + BGZF_TRAILER_SIZE);
+    psJob->sStream.next_out = psJob->pabyOut;
+    psJob->sStream.avail_out = static_cast<uInt>(psJob->nOutSize);
+    if (inflate(&psJob->sStream, Z_FINISH) != Z_STREAM_END ||
+        psJob->sStream.avail_out != 0)
+        return false;
+
+    GUInt32 nCRC = 0;
+    memcpy(&nCRC, psJob->pabyIn + psJob->nInSize, 4);
+    CPL_LSBPTR32(&nCRC);
+    return crc32(0L, psJob->pabyOut,
+                 static_cast<uInt>(psJob->nOutSize)) == nCRC;
+}
+
+static void BGZFInflateJob( void* pData )
+{
+    VSIBGZFInflateJob* psJob = static_cast<VSIBGZFInflateJob*>(pData);
+    const bool bOK = BGZFInflate(psJob);
+
+    CPLAcquireMutex(psJob->hMutex, 1000.0);
+    psJob->bOK = bOK;
+    if (--(*psJob->pnPending) == 0)
+        CPLCondSignal(psJob->hCond);
+    CPLReleaseMutex(psJob->hMutex);
+}
+
+/************************************************************************/
+/*                             ReadBGZF()                               */
+/************************************************************************/
+
+/* Read of a BGZF file, where the members entirely within the requested */
+/* range are decompressed in parallel. */
+size_t VSIGZipHandle::ReadBGZF( GByte* pabyBuffer, size_t nToRead )
+{
+    if (!ExtendBGZFIndex(out + nToRead))
+        return gzread(pabyBuffer, 1, nToRead);
+    const std::vector<GZipIndexPoint>& asPoints = m_poIndex->asPoints;
+    const size_t nPoints = asPoints.size();
+    size_t nRead = 0;
+
+    /* Finish the current member sequentially */
+    const GZipIndexPoint* psPoint = m_poIndex->FindPoint(out);
+    size_t iPoint = (psPoint != NULL) ? (size_t)(psPoint - &asPoints[0]) : 0;
+    if (iPoint < nPoints && asPoints[iPoint].out < out)
+        iPoint++;
+    if (iPoint < nPoints && asPoints[iPoint].out > out)
+    {
+        const size_t nHead =
+            static_cast<size_t>(MIN(nToRead, asPoints[iPoint].out - out));
+        nRead = gzread(pabyBuffer, 1, nHead);
+        if (nRead != nHead)
+            return nRead;
+    }
+
+    while (iPoint < nPoints && z_err == Z_OK)
+    {
+        /* Members that fit in the buffer, up to one per job */
+        int nJobs = 0;
+        size_t nBatchOut = 0;
+        while (nJobs < m_nBGZFJobs && iPoint + nJobs < nPoints)
+        {
+            const size_t i = iPoint + nJobs;
+            /* The size of the last member scanned is only known at the end */
+            if (i + 1 == nPoints && !m_poIndex->bComplete)
+                break;
+            const size_t nBlockOut = static_cast<size_t>(
+                ((i + 1 < nPoints) ? asPoints[i + 1].out
+                                   : m_poIndex->nUncompressedSize) -
+                asPoints[i].out);
+            if (nRead + nBatchOut + nBlockOut > nToRead)
+                break;
+            VSIBGZFInflateJob* psJob = &m_pasBGZFJobs[nJobs];
+            psJob->nInSize = asPoints[i].nDeflateSize;
+            psJob->pabyOut = pabyBuffer + nRead + nBatchOut;
+            psJob->nOutSize = nBlockOut;
+            nBatchOut += nBlockOut;
+            nJobs++;
+        }
+        if (nJobs == 0)
+            break;
+
+        /* Read their compressed data at once */
+        const vsi_l_offset nStart = asPoints[iPoint].nFileOffset;
+        const GZipIndexPoint& oLast = asPoints[iPoint + nJobs - 1];
+        const size_t nCompressed = static_cast<size_t>(
+            oLast.nFileOffset + oLast.nDeflateSize + BGZF_TRAILER_SIZE - nStart);
+        m_abyBGZFBuffer.resize(nCompressed);
+        if (VSIFSeekL((VSILFILE*)m_poBaseHandle, nStart, SEEK_SET) != 0 ||
+            VSIFReadL(&m_abyBGZFBuffer[0], 1, nCompressed,
+                      (VSILFILE*)m_poBaseHandle) != nCompressed)
+        {
+            z_err = Z_ERRNO;
+            break;
+        }
+        m_nBGZFPendingJobs = nJobs;
+        for (int i = 0; i < nJobs; i++)
+        {
+            m_pasBGZFJobs[i].pabyIn = &m_abyBGZFBuffer[0] +
+                static_cast<size_t>(asPoints[iPoint + i].nFileOffset - nStart);
+            if (!m_poBGZFThreadPool->SubmitJob(BGZFInflateJob, &m_pasBGZFJobs[i]))
+                BGZFInflateJob(&m_pasBGZFJobs[i]);
+        }
+        CPLAcquireMutex(m_hBGZFJobMutex, 1000.0);
+        while (m_nBGZFPendingJobs > 0)
+            CPLCondWait(m_hBGZFJobCond, m_hBGZFJobMutex);
+        CPLReleaseMutex(m_hBGZFJobMutex);
+        for (int i = 0; i < nJobs; i++)
+        {
+            if (!m_pasBGZFJobs[i].bOK)
+            {
+                CPLError(CE_Failure, CPLE_FileIO,
+                         "Corrupted BGZF member at offset " CPL_FRMT_GUIB,
+                         asPoints[iPoint + i].nFileOffset);
+                z_err = Z_DATA_ERROR;
+                return nRead;
+            }
+        }
+        nRead += nBatchOut;
+        iPoint += nJobs;
+
+        /* Resume at the next member */
+        if (iPoint < nPoints)
+        {
+            if (!RestoreIndexPoint(asPoints[iPoint]))
+            {
+                z_err = Z_DATA_ERROR;
+                return nRead;
+            }
+        }
+        else
+        {
+            in = m_compressed_size;
+            out = m_poIndex->nUncompressedSize;
+            z_err = Z_STREAM_END;
+        }
+        if (out > m_nLastReadOffset)
+            m_nLastReadOffset = out;
+    }
+
+    if (nRead < nToRead && z_err == Z_OK)
+        nRead += gzread(pabyBuffer + nRead, 1, nToRead - nRead);
+    return nRead;
+}
+
 /************************************************************************/
 /*                      check_header()                                  */
 /************************************************************************/
@@ -464,14 +1402,22 @@ void VSIGZipHandle::check_header()
     /* Discard time, xflags and OS code: */
     for (len = 0; len < 6; len++) (void)get_byte();
 
+    int c = 0;
     if ((flags & EXTRA_FIELD) != 0) { /* skip the extra field */
         len  =  (uInt)get_byte();
         len += ((uInt)get_byte())<<8;
+        /* A first member with a "BC" subfield is the start of a BGZF file */
+        GByte abyExtra[4] = { 0, 0, 0, 0 };
         /* len is garbage if EOF but the loop below will quit anyway */
-        while (len-- != 0 && get_byte() != EOF) ;
+        for (uInt i = 0; len-- != 0 && (c = get_byte()) != EOF; i++)
+        {
+            if (i < 4) abyExtra[i] = (GByte)c;
+        }
+        if (out == 0 && m_offset == 0 && abyExtra[0] == 'B' &&
+            abyExtra[1] == 'C' && abyExtra[2] == 2 && abyExtra[3] == 0)
+            m_bBGZF = true;
     }
 
-    int c = 0;
     if ((flags & ORIG_NAME) != 0) { /* skip the original file name */
         while ((c = get_byte()) != 0 && c != EOF) ;
     }
@@ -538,6 +1484,26 @@ int VSIGZipHandle::gzrewind ()
 
 int VSIGZipHandle::Seek( vsi_l_offset nOffset, int nWhence )
 {
+    if (!m_abyBGZFAhead.empty())
+    {
+        /* Seeks within the read-ahead buffer just move in it */
+        if (nWhence == SEEK_CUR)
+        {
+            nOffset += m_nBGZFAheadOut + m_nBGZFAheadPos;
+            nWhence = SEEK_SET;
+        }
+        if (nWhence == SEEK_SET && nOffset >= m_nBGZFAheadOut &&
+            nOffset - m_nBGZFAheadOut < m_abyBGZFAhead.size())
+        {
+            m_nBGZFAheadPos = static_cast<size_t>(nOffset - m_nBGZFAheadOut);
+            z_eof = 0;
+            return 0;
+        }
+        /* Otherwise it is dropped, out being at its end */
+        m_abyBGZFAhead.clear();
+        m_nBGZFAheadPos = 0;
+    }
+
     /* The semantics of gzseek are different from ::Seek */
     /* It returns the current offset, where as ::Seek should return 0 */
     /* if successful */
@@ -612,6 +1578,9 @@ int VSIGZipHandle::gzseek( vsi_l_offset offset, int whence )
     /* whence == SEEK_END is unsuppored in original gzseek. */
     if (whence == SEEK_END)
     {
+        if (m_uncompressed_size == 0 && m_bBGZF && !m_bBuildIndex)
+            ExtendBGZFIndex(~((vsi_l_offset)0));
+
         /* If we known the uncompressed size, we can fake a jump to */
         /* the end of the stream */
         if (offset == 0 && m_uncompressed_size != 0)
@@ -655,6 +1624,27 @@ int VSIGZipHandle::gzseek( vsi_l_offset offset, int whence )
             return -1L;
     }
 
+    if (m_bBGZF && !m_bBuildIndex && offset != 0)
+        ExtendBGZFIndex(out + offset);
+
+    if (m_poIndex != NULL && !m_bBuildIndex)
+    {
+        const GZipIndexPoint* psPoint = m_poIndex->FindPoint(out + offset);
+        if (psPoint != NULL && psPoint->out > out)
+        {
+            if (ENABLE_DEBUG)
+                CPLDebug("GZIP", "using access point at " CPL_FRMT_GUIB,
+                         psPoint->out);
+            offset = out + offset - psPoint->out;
+            if (!RestoreIndexPoint(*psPoint))
+            {
+                z_err = Z_DATA_ERROR;
+                CPL_VSIL_GZ_RETURN(-1);
+                return -1L;
+            }
+        }
+    }
+
     for(unsigned int i=0;i<m_compressed_size / snapshot_byte_interval + 1;i++)
     {
         if (snapshots[i].uncompressed_pos == 0)
@@ -705,7 +1695,7 @@ int VSIGZipHandle::gzseek( vsi_l_offset offset, int whence )
         int size = Z_BUFSIZE;
         if (offset < Z_BUFSIZE) size = (int)offset;
 
-        int read_size = static_cast<int>(Read(outbuf, 1, (uInt)size));
+        int read_size = static_cast<int>(gzread(outbuf, 1, (uInt)size));
         if (read_size == 0) {
             //CPL_VSIL_GZ_RETURN(-1);
             return -1L;
@@ -763,6 +1753,8 @@ int VSIGZipHandle::gzseek( vsi_l_offset offset, int whence )
 
 vsi_l_offset VSIGZipHandle::Tell()
 {
+    if (!m_abyBGZFAhead.empty())
+        return m_nBGZFAheadOut + m_nBGZFAheadPos;
     if (ENABLE_DEBUG) CPLDebug("GZIP", "Tell() = " CPL_FRMT_GUIB, out);
     return out;
 }
@@ -773,7 +1765,91 @@ vsi_l_offset VSIGZipHandle::Tell()
 
 size_t VSIGZipHandle::Read( void * const buf, size_t const nSize, size_t const nMemb )
 {
-    if (ENABLE_DEBUG) CPLDebug("GZIP", "Read(%p, %d, %d)", buf, (int)nSize, (int)nMemb);
+    const size_t nToRead = nSize * nMemb;
+    if (nToRead == 0)
+        return 0;
+    GByte* const pabyBuf = static_cast<GByte*>(buf);
+    size_t nRead = 0;
+    if (m_nBGZFAheadPos < m_abyBGZFAhead.size())
+    {
+        nRead = MIN(nToRead, m_abyBGZFAhead.size() - m_nBGZFAheadPos);
+        memcpy(pabyBuf, &m_abyBGZFAhead[m_nBGZFAheadPos], nRead);
+        m_nBGZFAheadPos += nRead;
+    }
+
+    if (nRead < nToRead)
+    {
+        m_abyBGZFAhead.resize(0);
+        m_nBGZFAheadPos = 0;
+
+        const bool bBGZFThreads = m_bBGZF && !m_bBuildIndex &&
+                                  z_err == Z_OK && InitBGZFThreadPool();
+        if (bBGZFThreads && nToRead - nRead >= BGZF_PARALLEL_READ_MIN)
+        {
+            nRead += ReadBGZF(pabyBuf + nRead, nToRead - nRead);
+        }
+        /* Small reads that continue the previous one */
+        else if (bBGZFThreads && out == m_nBGZFLastReadEnd &&
+                 FillBGZFReadAhead())
+        {
+            const size_t nCopy = MIN(nToRead - nRead, m_abyBGZFAhead.size());
+            memcpy(pabyBuf + nRead, &m_abyBGZFAhead[0], nCopy);
+            m_nBGZFAheadPos = nCopy;
+            nRead += nCopy;
+        }
+        else
+        {
+            nRead += gzread(pabyBuf + nRead, 1, nToRead - nRead);
+        }
+    }
+
+    m_nBGZFLastReadEnd = Tell();
+    return nRead / nSize;
+}
+
+/************************************************************************/
+/*                         FillBGZFReadAhead()                          */
+/************************************************************************/
+
+/* Decompress in parallel the members that follow the current position, */
+/* up to two per thread, for the next small sequential reads. */
+bool VSIGZipHandle::FillBGZFReadAhead()
+{
+    const vsi_l_offset nTarget =
+        out + static_cast<vsi_l_offset>(m_nBGZFJobs) * BGZF_BLOCK_SIZE;
+    if (!ExtendBGZFIndex(nTarget))
+        return false;
+
+    /* Stop at the start of a member, so that the next fill does not */
+    /* begin with the sequential decompression of its end */
+    size_t nAhead = static_cast<size_t>(nTarget - out);
+    if (m_poIndex->bComplete && nTarget >= m_poIndex->nUncompressedSize)
+    {
+        if (m_poIndex->nUncompressedSize > out)
+            nAhead = static_cast<size_t>(m_poIndex->nUncompressedSize - out);
+    }
+    else
+    {
+        const GZipIndexPoint* psPoint = m_poIndex->FindPoint(nTarget);
+        if (psPoint != NULL && psPoint->out > out)
+            nAhead = static_cast<size_t>(psPoint->out - out);
+    }
+
+    m_nBGZFAheadOut = out;
+    m_abyBGZFAhead.resize(nAhead);
+    const size_t nRead = ReadBGZF(&m_abyBGZFAhead[0], nAhead);
+    m_abyBGZFAhead.resize(nRead);
+    m_nBGZFAheadPos = 0;
+    return nRead != 0;
+}
+
+/************************************************************************/
+/*                              gzread()                                */
+/************************************************************************/
+
+size_t VSIGZipHandle::gzread( void * const buf, size_t const nSize, size_t const nMemb )
+{
+    if (ENABLE_DEBUG) CPLDebug("GZIP", "gzread(%p, %d, %d)", buf, (int)nSize, (int)nMemb);
 
     if  (z_err == Z_DATA_ERROR || z_err == Z_ERRNO)
     {
@@ -880,9 +1956,14 @@ size_t VSIGZipHandle::Read( void * const buf, size_t const nSize, size_t const n
         }
         in += stream.avail_in;
         out += stream.avail_out;
-        z_err = inflate(& (stream), Z_NO_FLUSH);
+        const Bytef* const pabyNewData = stream.next_out;
+        /* Z_BLOCK makes inflate() stop at the end of each deflate block, */
+        /* where access points of the index can be created */
+        z_err = inflate(& (stream), m_bBuildIndex ? Z_BLOCK : Z_NO_FLUSH);
         in -= stream.avail_in;
         out -= stream.avail_out;
+        if (m_bBuildIndex)
+            UpdateIndex(pabyNewData, pStart);
 
         if  (z_err == Z_STREAM_END && m_compressed_size != 2 ) {
             /* Check CRC and original size */
@@ -917,6 +1998,9 @@ size_t VSIGZipHandle::Read( void * const buf, size_t const nSize, size_t const n
                         inflateReset(& (stream));
                         crc = crc32(0L, NULL, 0);
                     }
+                    else if (z_err == Z_STREAM_END && m_bBuildIndex) {
+                        SaveIndex();
+                    }
                 }
             }
         }
@@ -979,6 +2063,8 @@ size_t VSIGZipHandle::Write( CPL_UNUSED const void *pBuffer,
 int VSIGZipHandle::Eof()
 {
     if (ENABLE_DEBUG) CPLDebug("GZIP", "Eof()");
+    if (m_nBGZFAheadPos < m_abyBGZFAhead.size())
+        return 0;
     return z_eof && in == 0;
 }
 
@@ -1269,6 +2355,371 @@ vsi_l_offset VSIGZipWriteHandle::Tell()
     return nCurOffset;
 }
 
+/************************************************************************/
+/* ==================================================================== */
+/*                       VSIBGZFWriteHandle                             */
+/* ==================================================================== */
+/************************************************************************/
+
+class VSIBGZFWriteHandle;
+
+/* Compression of a BGZF member, possibly by a worker thread */
+typedef struct
+{
+    VSIBGZFWriteHandle *poHandle;
+    z_stream            sStream;
+    bool                bStreamInit;
+    GByte              *pabyIn;    /* BGZF_MAX_INPUT_SIZE bytes */
+    size_t              nInSize;
+    GByte              *pabyOut;   /* BGZF_BLOCK_SIZE bytes */
+    size_t              nOutSize;
+    bool                bOK;
+    bool                bReady;    /* protected by hJobMutex */
+} VSIBGZFWriteJob;
+
+class VSIBGZFWriteHandle CPL_FINAL : public VSIVirtualHandle
+{
+    VSIVirtualHandle*    m_poBaseHandle;
+    int                  m_bAutoCloseBaseHandle;
+    CPLWorkerThreadPool *m_poPool;
+    CPLMutex            *m_hJobMutex;
+    std::vector<VSIBGZFWriteJob> m_asJobs;  /* ring of members in progress */
+    GUIntBig             m_nJobsSubmitted;
+    GUIntBig             m_nJobsWritten;
+    vsi_l_offset         m_nCurOffset;
+    bool                 m_bError;
+    bool                 m_bClosed;
+
+    static void          CompressJob( void* pData );
+    VSIBGZFWriteJob*     GetCurrentJob();
+    void                 SubmitCurrentJob();
+    bool                 WriteNextJob();
+
+  public:
+
+    VSIBGZFWriteHandle( VSIVirtualHandle* poBaseHandle, int nThreads,
+                        int bAutoCloseBaseHandle );
+    ~VSIBGZFWriteHandle();
+
+    virtual int       Seek( vsi_l_offset nOffset, int nWhence );
+    virtual vsi_l_offset Tell();
+    virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb );
+    virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb );
+    virtual int       Eof();
+    virtual int       Flush();
+    virtual int       Close();
+};
+
+/************************************************************************/
+/*                         VSIBGZFWriteHandle()                         */
+/************************************************************************/
+
+VSIBGZFWriteHandle::VSIBGZFWriteHandle( VSIVirtualHandle* poBaseHandle,
+                                        int nThreads,
+                                        int bAutoCloseBaseHandle ) :
+    m_poBaseHandle(poBaseHandle),
+    m_bAutoCloseBaseHandle(bAutoCloseBaseHandle),
+    m_poPool(NULL),
+    m_hJobMutex(NULL),
+    m_nJobsSubmitted(0),
+    m_nJobsWritten(0),
+    m_nCurOffset(0),
+    m_bError(false),
+    m_bClosed(false)
+{
+    if( nThreads > 1 )
+    {
+        m_poPool = new CPLWorkerThreadPool();
+        if( !m_poPool->Setup(nThreads, NULL, NULL) )
+        {
+            delete m_poPool;
+            m_poPool = NULL;
+        }
+    }
+    m_hJobMutex = CPLCreateMutex();
+    CPLReleaseMutex(m_hJobMutex);
+
+    /* Twice as many members as threads, so that the threads are kept busy */
+    /* while the members are written in order */
+    m_asJobs.resize(m_poPool ? 2 * nThreads : 1);
+    for( size_t i = 0; i < m_asJobs.size(); i++ )
+    {
+        VSIBGZFWriteJob* psJob = &m_asJobs[i];
+        memset(psJob, 0, sizeof(VSIBGZFWriteJob));
+        psJob->poHandle = this;
+        psJob->pabyIn = static_cast<GByte*>(CPLMalloc(BGZF_MAX_INPUT_SIZE));
+        psJob->pabyOut = static_cast<GByte*>(CPLMalloc(BGZF_BLOCK_SIZE));
+    }
+}
+
+/************************************************************************/
+/*                        ~VSIBGZFWriteHandle()                         */
+/************************************************************************/
+
+VSIBGZFWriteHandle::~VSIBGZFWriteHandle()
+{
+    Close();
+
+    delete m_poPool;
+    for( size_t i = 0; i < m_asJobs.size(); i++ )
+    {
+        if( m_asJobs[i].bStreamInit )
+            deflateEnd(&m_asJobs[i].sStream);
+        CPLFree(m_asJobs[i].pabyIn);
+        CPLFree(m_asJobs[i].pabyOut);
+    }
+    CPLDestroyMutex(m_hJobMutex);
+}
+
+/************************************************************************/
+/*                            CompressJob()                             */
+/************************************************************************/
+
+void VSIBGZFWriteHandle::CompressJob( void* pData )
+{
+    VSIBGZFWriteJob* psJob = static_cast<VSIBGZFWriteJob*>(pData);
+    z_stream* psStream = &psJob->sStream;
+    psJob->bOK = false;
+    if( !psJob->bStreamInit )
+    {
+        psJob->bStreamInit =
+            deflateInit2(psStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                         -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+
+    /* Data that does not compress well enough to fit in a member is */
+    /* stored (level 0) */
+    const int anLevels[2] = { Z_DEFAULT_COMPRESSION, 0 };
+    for( int i = 0; psJob->bStreamInit && !psJob->bOK && i < 2; i++ )
+    {
+        if( deflateReset(psStream) != Z_OK ||
+            deflateParams(psStream, anLevels[i], Z_DEFAULT_STRATEGY) != Z_OK )
+            break;
+        const uInt nMaxDeflateSize =
+            BGZF_BLOCK_SIZE - BGZF_HEADER_SIZE - BGZF_TRAILER_SIZE;
+        psStream->next_in = psJob->pabyIn;
+        psStream->avail_in = static_cast<uInt>(psJob->nInSize);
+        psStream->next_out = psJob->pabyOut + BGZF_HEADER_SIZE;
+        psStream->avail_out = nMaxDeflateSize;
+        if( deflate(psStream, Z_FINISH) != Z_STREAM_END )
+            continue;
+
+        const size_t nDeflateSize = nMaxDeflateSize - psStream->avail_out;
+        psJob->nOutSize = BGZF_HEADER_SIZE + nDeflateSize + BGZF_TRAILER_SIZE;
+        memcpy(psJob->pabyOut, abyBGZFHeader, BGZF_HEADER_SIZE);
+        psJob->pabyOut[16] = static_cast<GByte>((psJob->nOutSize - 1) & 0xff);
+        psJob->pabyOut[17] = static_cast<GByte>((psJob->nOutSize - 1) >> 8);
+        GUInt32 anTrailer[2];
+        anTrailer[0] = CPL_LSBWORD32(static_cast<GUInt32>(
+            crc32(0L, psJob->pabyIn, static_cast<uInt>(psJob->nInSize))));
+        anTrailer[1] = CPL_LSBWORD32(static_cast<GUInt32>(psJob->nInSize));
+        memcpy(psJob->pabyOut + BGZF_HEADER_SIZE + nDeflateSize, anTrailer,
+               BGZF_TRAILER_SIZE);
+        psJob->bOK = true;
+    }
+
+    CPLAcquireMutex(psJob->poHandle->m_hJobMutex, 1000.0);
+    psJob->bReady = true;
+    CPLReleaseMutex(psJob->poHandle->m_hJobMutex);
+}
+
+/************************************************************************/
+/*                           GetCurrentJob()                            */
+/************************************************************************/
+
+/* Return the member being filled, once its slot in the ring is free */
+VSIBGZFWriteJob* VSIBGZFWriteHandle::GetCurrentJob()
+{
+    while( m_nJobsSubmitted - m_nJobsWritten >= m_asJobs.size() )
+    {
+        if( !WriteNextJob() )
+            return NULL;
+    }
+    return &m_asJobs[static_cast<size_t>(m_nJobsSubmitted % m_asJobs.size())];
+}
+
+/************************************************************************/
+/*                          SubmitCurrentJob()                          */
+/************************************************************************/
+
+void VSIBGZFWriteHandle::SubmitCurrentJob()
+{
+    VSIBGZFWriteJob* psJob =
+        &m_asJobs[static_cast<size_t>(m_nJobsSubmitted % m_asJobs.size())];
+    m_nJobsSubmitted++;
+    if( m_poPool )
+        m_poPool->SubmitJob(CompressJob, psJob);
+    else
+        CompressJob(psJob);
+}
+
+/************************************************************************/
+/*                            WriteNextJob()                            */
+/************************************************************************/
+
+/* Wait for the oldest member to be compressed, and write it */
+bool VSIBGZFWriteHandle::WriteNextJob()
+{
+    VSIBGZFWriteJob* psJob =
+        &m_asJobs[static_cast<size_t>(m_nJobsWritten % m_asJobs.size())];
+    if( m_poPool )
+    {
+        /* Jobs may complete out of order: wait until fewer jobs than the */
+        /* ones submitted after this one are pending, and so on */
+        int nMaxRemainingJobs =
+            static_cast<int>(m_nJobsSubmitted - m_nJobsWritten - 1);
+        while( true )
+        {
+            CPLAcquireMutex(m_hJobMutex, 1000.0);
+            const bool bReady = psJob->bReady;
+            CPLReleaseMutex(m_hJobMutex);
+            if( bReady )
+                break;
+            m_poPool->WaitCompletion(nMaxRemainingJobs);
+            if( nMaxRemainingJobs > 0 )
+                nMaxRemainingJobs--;
+        }
+    }
+
+    bool bOK = psJob->bOK;
+    if( !bOK )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "Compression of a BGZF member failed");
+    }
+    else if( m_poBaseHandle->Write(psJob->pabyOut, 1, psJob->nOutSize) !=
+                                                            psJob->nOutSize )
+    {
+        bOK = false;
+    }
+    psJob->nInSize = 0;
+    psJob->bReady = false;
+    m_nJobsWritten++;
+    if( !bOK )
+        m_bError = true;
+    return bOK;
+}
+
+/************************************************************************/
+/*                               Close()                                */
+/************************************************************************/
+
+int VSIBGZFWriteHandle::Close()
+{
+    if( m_bClosed )
+        return 0;
+    m_bClosed = true;
+
+    VSIBGZFWriteJob* psJob = m_bError ? NULL : GetCurrentJob();
+    if( psJob != NULL && psJob->nInSize != 0 )
+        SubmitCurrentJob();
+    while( !m_bError && m_nJobsWritten < m_nJobsSubmitted )
+        WriteNextJob();
+    if( m_poPool )
+        m_poPool->WaitCompletion();
+
+    int nRet = m_bError ? EOF : 0;
+    if( nRet == 0 &&
+        m_poBaseHandle->Write(abyBGZFEOF, 1, sizeof(abyBGZFEOF)) !=
+                                                        sizeof(abyBGZFEOF) )
+        nRet = EOF;
+
+    if( m_bAutoCloseBaseHandle )
+    {
+        if( m_poBaseHandle->Close() != 0 )
+            nRet = EOF;
+        delete m_poBaseHandle;
+    }
+    return nRet;
+}
+
+/************************************************************************/
+/*                                Read()                                */
+/************************************************************************/
+
+size_t VSIBGZFWriteHandle::Read( CPL_UNUSED void *pBuffer,
+                                 CPL_UNUSED size_t nSize,
+                                 CPL_UNUSED size_t nMemb )
+{
+    CPLError(CE_Failure, CPLE_NotSupported,
+             "VSIFReadL is not supported on GZip write streams");
+    return 0;
+}
+
+/************************************************************************/
+/*                               Write()                                */
+/************************************************************************/
+
+size_t VSIBGZFWriteHandle::Write( const void * const pBuffer,
+                                  size_t const nSize, size_t const nMemb )
+{
+    if( m_bError || m_bClosed )
+        return 0;
+
+    const GByte* pabySrc = static_cast<const GByte*>(pBuffer);
+    size_t nRemaining = nSize * nMemb;
+    while( nRemaining > 0 )
+    {
+        VSIBGZFWriteJob* psJob = GetCurrentJob();
+        if( psJob == NULL )
+            return 0;
+        const size_t nChunk =
+            MIN(nRemaining, BGZF_MAX_INPUT_SIZE - psJob->nInSize);
+        memcpy(psJob->pabyIn + psJob->nInSize, pabySrc, nChunk);
+        psJob->nInSize += nChunk;
+        pabySrc += nChunk;
+        nRemaining -= nChunk;
+        m_nCurOffset += nChunk;
+        if( psJob->nInSize == BGZF_MAX_INPUT_SIZE )
+            SubmitCurrentJob();
+    }
+
+    return nMemb;
+}
+
+/************************************************************************/
+/*                               Flush()                                */
+/************************************************************************/
+
+int VSIBGZFWriteHandle::Flush()
+{
+    return 0;
+}
+
+/************************************************************************/
+/*                                Eof()                                 */
+/************************************************************************/
+
+int VSIBGZFWriteHandle::Eof()
+{
+    return 1;
+}
+
+/************************************************************************/
+/*                                Seek()                                */
+/************************************************************************/
+
+int VSIBGZFWriteHandle::Seek( vsi_l_offset nOffset, int nWhence )
+{
+    if( nOffset == 0 && (nWhence == SEEK_END || nWhence == SEEK_CUR) )
+        return 0;
+    else if( nWhence == SEEK_SET && nOffset == m_nCurOffset )
+        return 0;
+
+    CPLError(CE_Failure, CPLE_NotSupported,
+             "Seeking on writable compressed data streams not supported.");
+    return -1;
+}
+
+/************************************************************************/
+/*                                Tell()                                */
+/************************************************************************/
+
+vsi_l_offset VSIBGZFWriteHandle::Tell()
+{
+    return m_nCurOffset;
+}
+
 
 /************************************************************************/
 /* ==================================================================== */
@@ -1297,6 +2748,8 @@ VSIGZipFilesystemHandler::~VSIGZipFilesystemHandler()
     if (poHandleLastGZipFile)
         delete poHandleLastGZipFile;
 
+    VSIGZipDestroyBGZFThreadPool();
+
     if( hMutex != NULL )
         CPLDestroyMutex( hMutex );
     hMutex = NULL;
@@ -1376,8 +2829,11 @@ VSIVirtualHandle* VSIGZipFilesystemHandler::Open( const char *pszFilename,
         if (poVirtualHandle == NULL)
             return NULL;
 
-        else
-            return new VSIGZipWriteHandle( poVirtualHandle, strchr(pszAccess, 'z') != NULL, TRUE );
+        const int nThreads = VSIGZipGetThreadCount("CPL_VSIL_GZIP_WRITE_THREADS");
+        if (nThreads > 0 && strchr(pszAccess, 'z') == NULL)
+            return new VSIBGZFWriteHandle( poVirtualHandle, nThreads, TRUE );
+
+        return new VSIGZipWriteHandle( poVirtualHandle, strchr(pszAccess, 'z') != NULL, TRUE );
     }
 
 /* -------------------------------------------------------------------- */
@@ -1443,6 +2899,7 @@ VSIGZipHandle* VSIGZipFilesystemHandler::OpenGZipReadOnly( const char *pszFilena
         delete poHandle;
         return NULL;
     }
+    poHandle->InitIndex();
     return poHandle;
 }
 
@@ -57,6 +57,7 @@ class VSISubFileHandle : public VSIVirtualHandle
     virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb );
     virtual int       Eof();
     virtual int       Close();
+    virtual const void *GetReadView( vsi_l_offset nOffset, size_t nSize );
 };
 
 /************************************************************************/
@@ -185,6 +186,20 @@ size_t VSISubFileHandle::Read( void * pBuffer, size_t nSize, size_t nCount )
     return nRet;
 }
 
+/************************************************************************/
+/*                            GetReadView()                             */
+/************************************************************************/
+
+const void *VSISubFileHandle::GetReadView( vsi_l_offset nOffset, size_t nSize )
+
+{
+    if( nSubregionSize != 0 &&
+        (nOffset > nSubregionSize || nSize > nSubregionSize - nOffset) )
+        return NULL;
+
+    return VSIFGetReadViewL( fp, nSubregionOffset + nOffset, nSize );
+}
+
 /************************************************************************/
 /*                               Write()                                */
 /************************************************************************/
@@ -64,6 +64,9 @@
 #include <sys/types.h>
 #include <dirent.h>
 #include <errno.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #include <new>
 
 CPL_CVSID("$Id$");
@@ -473,6 +476,209 @@ int VSIUnixStdioHandle::Truncate( vsi_l_offset nNewSize )
 }
 
 
+#ifdef HAVE_MMAP
+
+/************************************************************************/
+/* ==================================================================== */
+/*                       VSIUnixStdioMMapHandle                         */
+/* ==================================================================== */
+/************************************************************************/
+
+/* Read-only handle serving reads from a mapping of the whole file, */
+/* used when VSI_MMAP=YES. */
+class VSIUnixStdioMMapHandle CPL_FINAL : public VSIVirtualHandle
+{
+    FILE          *fp;
+    GByte         *pabyMap;
+    size_t        nMapSize;
+    vsi_l_offset  m_nOffset;
+    bool          bAtEOF;
+
+  public:
+                      VSIUnixStdioMMapHandle( FILE* fpIn, GByte* pabyMapIn,
+                                              size_t nMapSizeIn );
+
+    static VSIUnixStdioMMapHandle *Create( FILE* fpIn );
+
+    virtual int       Seek( vsi_l_offset nOffsetIn, int nWhence );
+    virtual vsi_l_offset Tell();
+    virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb );
+    virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb );
+    virtual int       Eof();
+    virtual int       Close();
+    virtual void     *GetNativeFileDescriptor() {
+        return reinterpret_cast<void *>(static_cast<size_t>(fileno(fp))); }
+    virtual const void *GetReadView( vsi_l_offset nOffset, size_t nSize );
+};
+
+/************************************************************************/
+/*                       VSIUnixStdioMMapHandle()                       */
+/************************************************************************/
+
+VSIUnixStdioMMapHandle::VSIUnixStdioMMapHandle( FILE* fpIn, GByte* pabyMapIn,
+                                                size_t nMapSizeIn ) :
+    fp(fpIn),
+    pabyMap(pabyMapIn),
+    nMapSize(nMapSizeIn),
+    m_nOffset(0),
+    bAtEOF(false)
+{}
+
+/************************************************************************/
+/*                               Create()                               */
+/*                                                                      */
+/*      Map the file. Return NULL, without closing fpIn, if the file    */
+/*      is empty, too large for the address space or cannot be          */
+/*      mapped.                                                         */
+/************************************************************************/
+
+VSIUnixStdioMMapHandle *VSIUnixStdioMMapHandle::Create( FILE* fpIn )
+{
+    if( VSI_FSEEK64( fpIn, 0, SEEK_END ) != 0 )
+        return NULL;
+    const vsi_l_offset nFileSize = VSI_FTELL64( fpIn );
+    if( VSI_FSEEK64( fpIn, 0, SEEK_SET ) != 0 )
+        return NULL;
+    if( nFileSize == 0 ||
+        nFileSize != static_cast<vsi_l_offset>(static_cast<size_t>(nFileSize)) )
+        return NULL;
+
+    const size_t nMapSize = static_cast<size_t>(nFileSize);
+    void* pMap = mmap( NULL, nMapSize, PROT_READ, MAP_SHARED,
+                       fileno(fpIn), 0 );
+    if( pMap == MAP_FAILED )
+    {
+        CPLDebug( "VSI", "mmap() failed: %s", VSIStrerror(errno) );
+        return NULL;
+    }
+
+    VSIUnixStdioMMapHandle *poHandle = new(std::nothrow)
+        VSIUnixStdioMMapHandle( fpIn, static_cast<GByte*>(pMap), nMapSize );
+    if( poHandle == NULL )
+        munmap( pMap, nMapSize );
+    return poHandle;
+}
+
+/************************************************************************/
+/*                               Close()                                */
+/************************************************************************/
+
+int VSIUnixStdioMMapHandle::Close()
+
+{
+    VSIDebug1( "VSIUnixStdioMMapHandle::Close(%p)", fp );
+
+    munmap( pabyMap, nMapSize );
+    return fclose( fp );
+}
+
+/************************************************************************/
+/*                                Seek()                                */
+/************************************************************************/
+
+int VSIUnixStdioMMapHandle::Seek( vsi_l_offset nOffsetIn, int nWhence )
+{
+    bAtEOF = false;
+
+    if( nWhence == SEEK_SET )
+        m_nOffset = nOffsetIn;
+    else if( nWhence == SEEK_CUR )
+        m_nOffset += nOffsetIn;
+    else if( nWhence == SEEK_END )
+        m_nOffset = nMapSize + nOffsetIn;
+    else
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return 0;
+}
+
+/************************************************************************/
+/*                                Tell()                                */
+/************************************************************************/
+
+vsi_l_offset VSIUnixStdioMMapHandle::Tell()
+
+{
+    return m_nOffset;
+}
+
+/************************************************************************/
+/*                                Read()                                */
+/************************************************************************/
+
+size_t VSIUnixStdioMMapHandle::Read( void * pBuffer, size_t nSize,
+                                     size_t nCount )
+
+{
+    if( nSize == 0 || nCount == 0 )
+        return 0;
+
+    if( m_nOffset >= nMapSize )
+    {
+        bAtEOF = true;
+        return 0;
+    }
+
+    // Like fread(), copy a trailing partial item, but do not count it.
+    const size_t nAvailable = nMapSize - static_cast<size_t>(m_nOffset);
+    size_t nBytesToRead;
+    if( nCount <= nAvailable / nSize )
+        nBytesToRead = nSize * nCount;
+    else
+    {
+        nBytesToRead = nAvailable;
+        nCount = nAvailable / nSize;
+        bAtEOF = true;
+    }
+
+    memcpy( pBuffer, pabyMap + static_cast<size_t>(m_nOffset), nBytesToRead );
+    m_nOffset += nBytesToRead;
+
+    return nCount;
+}
+
+/************************************************************************/
+/*                               Write()                                */
+/************************************************************************/
+
+size_t VSIUnixStdioMMapHandle::Write( const void * /* pBuffer */,
+                                      size_t /* nSize */,
+                                      size_t /* nCount */ )
+
+{
+    errno = EBADF;
+    return 0;
+}
+
+/************************************************************************/
+/*                                Eof()                                 */
+/************************************************************************/
+
+int VSIUnixStdioMMapHandle::Eof()
+
+{
+    return bAtEOF ? TRUE : FALSE;
+}
+
+/************************************************************************/
+/*                            GetReadView()                             */
+/************************************************************************/
+
+const void *VSIUnixStdioMMapHandle::GetReadView( vsi_l_offset nOffset,
+                                                 size_t nSize )
+
+{
+    if( nOffset > nMapSize || nSize > nMapSize - static_cast<size_t>(nOffset) )
+        return NULL;
+
+    return pabyMap + static_cast<size_t>(nOffset);
+}
+
+#endif /* HAVE_MMAP */
+
 /************************************************************************/
 /* ==================================================================== */
 /*                       VSIUnixStdioFilesystemHandler                  */
@@ -533,6 +739,25 @@ VSIUnixStdioFilesystemHandler::Open( const char *pszFilename,
 
     const bool bReadOnly =
         strcmp(pszAccess, "rb") == 0 || strcmp(pszAccess, "r") == 0;
+
+#ifdef HAVE_MMAP
+/* -------------------------------------------------------------------- */
+/*      If VSI_MMAP is set, serve reads from a mapping of the file,     */
+/*      unless it cannot be mapped.                                     */
+/* -------------------------------------------------------------------- */
+    if( bReadOnly
+        && CPLTestBool( CPLGetConfigOption( "VSI_MMAP", "NO" ) ) )
+    {
+        VSIUnixStdioMMapHandle *poMMapHandle =
+            VSIUnixStdioMMapHandle::Create( fp );
+        if( poMMapHandle != NULL )
+        {
+            errno = nError;
+            return poMMapHandle;
+        }
+    }
+#endif
+
     VSIUnixStdioHandle *poHandle =
         new(std::nothrow) VSIUnixStdioHandle( this, fp, bReadOnly );
     if( poHandle == NULL )
@@ -515,6 +515,10 @@ long    VSIFTellL( VSILFILE* fp );
 VSI_RETVAL VSIFTruncateL( VSILFILE* fp, long length );
 #endif
 
+%apply (char **CSL) {char **};
+char **VSIFGetCacheStatisticsL( VSILFILE* fp );
+%clear char **;
+
 #if defined(SWIGPYTHON)
 %rename (VSIFWriteL) wrapper_VSIFWriteL;
 %inline {
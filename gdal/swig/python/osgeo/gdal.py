@@ -1354,6 +1354,10 @@ def VSIFTruncateL(*args):
   """VSIFTruncateL(VSILFILE * fp, GIntBig length) -> int"""
   return _gdal.VSIFTruncateL(*args)
 
+def VSIFGetCacheStatisticsL(*args):
+  """VSIFGetCacheStatisticsL(VSILFILE * fp) -> char **"""
+  return _gdal.VSIFGetCacheStatisticsL(*args)
+
 def VSIFWriteL(*args):
   """VSIFWriteL(int nLen, int size, int memb, VSILFILE * fp) -> int"""
   return _gdal.VSIFWriteL(*args)
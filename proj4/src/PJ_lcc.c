@@ -65,6 +65,10 @@ static LP e_inverse (XY xy, PJ *P) {          /* Ellipsoidal, inverse */
     return lp;
 }
 
+FORWARD_ARRAY(e_forward_array, e_forward)
+INVERSE_ARRAY(e_inverse_array, e_inverse)
+
+
 static void special(LP lp, PJ *P, struct FACTORS *fac) {
     struct pj_opaque *Q = P->opaque;
     double rho;
@@ -145,6 +149,8 @@ PJ *PROJECTION(lcc) {
 
     P->inv = e_inverse;
     P->fwd = e_forward;
+    P->inv_array = e_inverse_array;
+    P->fwd_array = e_forward_array;
     P->spc = special;
 
     return P;
@@ -42,6 +42,44 @@ static LP s_inverse (XY xy, PJ *P) {           /* Spheroidal, inverse */
 }
 
 
+/* Batched forward projections, written out so that the compiler sees */
+/* plain loops over the arrays. */
+static void e_forward_array (PJ *P, long n, double *x, double *y, int *status) {
+    const double k0 = P->k0, e = P->e;
+    long i;
+    for (i = 0; i < n; i++) {
+        if (status[i])
+            continue;
+        if (fabs(fabs(y[i]) - M_HALFPI) <= EPS10) {
+            status[i] = -20;
+            continue;
+        }
+        x[i] = k0 * x[i];
+        y[i] = - k0 * log(pj_tsfn(y[i], sin(y[i]), e));
+    }
+}
+
+
+static void s_forward_array (PJ *P, long n, double *x, double *y, int *status) {
+    const double k0 = P->k0;
+    long i;
+    for (i = 0; i < n; i++) {
+        if (status[i])
+            continue;
+        if (fabs(fabs(y[i]) - M_HALFPI) <= EPS10) {
+            status[i] = -20;
+            continue;
+        }
+        x[i] = k0 * x[i];
+        y[i] = k0 * log(tan(M_FORTPI + .5 * y[i]));
+    }
+}
+
+
+INVERSE_ARRAY(e_inverse_array, e_inverse)
+INVERSE_ARRAY(s_inverse_array, s_inverse)
+
+
 static void freeup(PJ *P) {                             /* Destructor */
     pj_dealloc(P);
 }
@@ -61,6 +99,8 @@ PJ *PROJECTION(merc) {
             P->k0 = pj_msfn(sin(phits), cos(phits), P->es);
         P->inv = e_inverse;
         P->fwd = e_forward;
+        P->inv_array = e_inverse_array;
+        P->fwd_array = e_forward_array;
     }
 
     else { /* sphere */
@@ -68,6 +108,8 @@ PJ *PROJECTION(merc) {
             P->k0 = cos(phits);
         P->inv = s_inverse;
         P->fwd = s_forward;
+        P->inv_array = s_inverse_array;
+        P->fwd_array = s_forward_array;
     }
 
     return P;
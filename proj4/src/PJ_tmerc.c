@@ -152,6 +152,12 @@ static LP s_inverse (XY xy, PJ *P) {           /* Spheroidal, inverse */
 }
 
 
+FORWARD_ARRAY(e_forward_array, e_forward)
+FORWARD_ARRAY(s_forward_array, s_forward)
+INVERSE_ARRAY(e_inverse_array, e_inverse)
+INVERSE_ARRAY(s_inverse_array, s_inverse)
+
+
 static void *freeup_new (PJ *P) {                       /* Destructor */
     if (0==P)
         return 0;
@@ -176,11 +182,15 @@ static PJ *setup(PJ *P) {                   /* general initialization */
         Q->esp = P->es / (1. - P->es);
         P->inv = e_inverse;
         P->fwd = e_forward;
+        P->inv_array = e_inverse_array;
+        P->fwd_array = e_forward_array;
     } else {
         Q->esp = P->k0;
         Q->ml0 = .5 * Q->esp;
         P->inv = s_inverse;
         P->fwd = s_forward;
+        P->inv_array = s_inverse_array;
+        P->fwd_array = s_forward_array;
     }
     return P;
 }
@@ -0,0 +1,141 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Regression test of the batched projection path of
+ *           pj_transform() against the per point one.
+ *
+ * Run these tests by configuring with cmake and running "make test".
+ *
+ ******************************************************************************
+ * Copyright (c) 2016, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "proj_api.h"
+
+/* pj_transform() takes the batched path for contiguous arrays of more */
+/* than one point, and calls pj_fwd()/pj_inv() per point otherwise.  The */
+/* same points are transformed both ways, with the output of the batched */
+/* path compared bit for bit, as out of domain points give NaN or */
+/* infinite values that must match too. */
+
+#define NPOINTS 700   /* several blocks of the batched path */
+
+static const char *const defs[] = {
+  "+proj=merc +datum=WGS84",
+  "+proj=merc +R=6370997",
+  "+proj=merc +datum=WGS84 +lat_ts=30 +over",
+  "+proj=tmerc +lat_0=0 +lon_0=9 +k=0.9996 +x_0=500000 +datum=WGS84",
+  "+proj=tmerc +lon_0=-3 +R=6370997 +units=ft",
+  "+proj=utm +zone=31 +datum=WGS84",
+  "+proj=utm +zone=58 +south +ellps=GRS80 +towgs84=1,2,3",
+  "+proj=etmerc +lon_0=15 +k=0.9996 +x_0=500000 +ellps=intl",
+  "+proj=lcc +lat_1=49 +lat_2=44 +lat_0=46.5 +lon_0=3 +x_0=700000 "
+    "+y_0=6600000 +ellps=GRS80 +towgs84=0,0,0",
+  "+proj=lcc +lat_1=33 +lat_2=45 +lat_0=39 +lon_0=-96 +datum=NAD83 +geoc",
+  NULL
+};
+
+/* Fill the arrays with regular points of the domain, interleaved with */
+/* out of domain and special ones. */
+static void fill_points(double *x, double *y, int projected) {
+  int i;
+  for (i = 0; i < NPOINTS; i++) {
+    double u = (i % 37) / 36.0 * 2 - 1, v = (i % 41) / 40.0 * 2 - 1;
+    if (projected) {
+      x[i] = u * 2e7;
+      y[i] = v * 2e7;
+    } else {
+      x[i] = u * 180 * DEG_TO_RAD;
+      y[i] = v * 89 * DEG_TO_RAD;
+    }
+    switch (i % 29) {
+    case 3: x[i] = HUGE_VAL; break;
+    case 5: y[i] = HUGE_VAL; break;
+    case 7: x[i] = y[i] = sqrt(-1.0); break;
+    case 11: y[i] = projected ? 1e30 : 90 * DEG_TO_RAD; break;
+    case 13: y[i] = projected ? -1e10 : -90 * DEG_TO_RAD; break;
+    case 17: x[i] = projected ? 1e8 : 700 * DEG_TO_RAD; break;
+    case 19: y[i] = projected ? y[i] : 95 * DEG_TO_RAD; break;
+    case 23: x[i] = projected ? -6e6 : 179.9999 * DEG_TO_RAD; break;
+    default: break;
+    }
+  }
+}
+
+static int compare(const char *def, const char *dir, int ret_batched,
+                   int ret_point, const double *xb, const double *yb,
+                   const double *xy) {
+  int i, n = 0;
+  if (ret_batched != ret_point) {
+    printf("%s (%s): error %d != %d\n", def, dir, ret_batched, ret_point);
+    n++;
+  }
+  for (i = 0; i < NPOINTS; i++) {
+    if (memcmp(&xb[i], &xy[2 * i], sizeof(double)) != 0 ||
+        memcmp(&yb[i], &xy[2 * i + 1], sizeof(double)) != 0) {
+      if (n < 10)
+        printf("%s (%s): point %d: (%.17g, %.17g) != (%.17g, %.17g)\n",
+               def, dir, i, xb[i], yb[i], xy[2 * i], xy[2 * i + 1]);
+      n++;
+    }
+  }
+  return n;
+}
+
+static int test_def(projPJ latlong, const char *def) {
+  double xb[NPOINTS], yb[NPOINTS], xy[2 * NPOINTS];
+  int i, n = 0, ret_batched, ret_point, projected;
+  projPJ pj = pj_init_plus(def);
+  if (pj == NULL) {
+    printf("%s: cannot initialize: %s\n", def, pj_strerrno(pj_errno));
+    return 1;
+  }
+
+  for (projected = 0; projected <= 1; projected++) {
+    projPJ src = projected ? pj : latlong, dst = projected ? latlong : pj;
+    fill_points(xb, yb, projected);
+    for (i = 0; i < NPOINTS; i++) {
+      xy[2 * i] = xb[i];
+      xy[2 * i + 1] = yb[i];
+    }
+    ret_batched = pj_transform(src, dst, NPOINTS, 1, xb, yb, NULL);
+    ret_point = pj_transform(src, dst, NPOINTS, 2, xy, xy + 1, NULL);
+    n += compare(def, projected ? "inverse" : "forward",
+                 ret_batched, ret_point, xb, yb, xy);
+  }
+
+  pj_free(pj);
+  return n;
+}
+
+int main() {
+  int i, n = 0;
+  projPJ latlong = pj_init_plus("+proj=latlong +datum=WGS84");
+  for (i = 0; defs[i] != NULL; i++)
+    n += test_def(latlong, defs[i]);
+  pj_free(latlong);
+  if (n)
+    printf("%d failure%s\n", n, n > 1 ? "s" : "");
+  return n;
+}
@@ -0,0 +1,12 @@
+set(ARRAYTEST_SRC arraytest.c )
+set(ARRAYTEST_INCLUDE)
+
+source_group("Source Files\\Bin" FILES ${ARRAYTEST_SRC} ${ARRAYTEST_INCLUDE})
+
+#Executable
+add_executable(arraytest ${ARRAYTEST_SRC} ${ARRAYTEST_INCLUDE})
+target_link_libraries(arraytest ${PROJ_LIBRARIES})
+# Do not install
+
+# Instead run as a test
+add_test (NAME array-test COMMAND arraytest)
@@ -44,3 +44,62 @@ pj_fwd(LP lp, PJ *P) {
 	}
 	return xy;
 }
+
+/************************************************************************/
+/*                            pj_fwd_array()                            */
+/*                                                                      */
+/*      Forward projection of n longitude/latitude pairs in place,      */
+/*      for projections that set P->fwd_array.  Each step runs over     */
+/*      the whole arrays, rather than calling pj_fwd() per point, with  */
+/*      the same results.  The points whose status is PJ_ARRAY_SKIP     */
+/*      are left untouched.  The status of the others is set to 0, or   */
+/*      to the error code pj_fwd() would have set, in which case they   */
+/*      are set to HUGE_VAL.                                            */
+/*                                                                      */
+/*      The kernels still project one point at a time with the scalar  */
+/*      formulas, so this only saves the per point call overhead of     */
+/*      pj_fwd(), not the cost of the projection math itself.           */
+/************************************************************************/
+
+void pj_fwd_array(PJ *P, long n, double *x, double *y, int *status) {
+	long i;
+	const double lam0 = P->lam0;
+	const double fr_meter = P->fr_meter, a = P->a;
+	const double x0 = P->x0, y0 = P->y0;
+
+	/* check for latitude or longitude overange, compute del lam */
+	for (i = 0; i < n; i++) {
+		double t;
+
+		if (status[i] == PJ_ARRAY_SKIP)
+			continue;
+		if ((t = fabs(y[i])-M_HALFPI) > EPS || fabs(x[i]) > 10.) {
+			status[i] = -14;
+			continue;
+		}
+		status[i] = 0;
+		if (fabs(t) <= EPS)
+			y[i] = y[i] < 0. ? -M_HALFPI : M_HALFPI;
+		else if (P->geoc)
+			y[i] = atan(P->rone_es * tan(y[i]));
+		x[i] -= lam0;
+		if (!P->over)
+			x[i] = adjlon(x[i]);
+	}
+
+	/* project */
+	P->ctx->last_errno = 0;
+	pj_errno = 0;
+	errno = 0;
+	(*P->fwd_array)(P, n, x, y, status);
+
+	/* adjust for major axis and easting/northings */
+	for (i = 0; i < n; i++) {
+		if (status[i] == 0) {
+			x[i] = fr_meter * (a * x[i] + x0);
+			y[i] = fr_meter * (a * y[i] + y0);
+		}
+		else if (status[i] != PJ_ARRAY_SKIP)
+			x[i] = y[i] = HUGE_VAL;
+	}
+}
@@ -40,3 +40,58 @@ pj_inv(XY xy, PJ *P) {
         }
 	return lp;
 }
+
+/************************************************************************/
+/*                            pj_inv_array()                            */
+/*                                                                      */
+/*      Inverse projection of n x/y pairs in place, for projections     */
+/*      that set P->inv_array.  Each step runs over the whole arrays,   */
+/*      rather than calling pj_inv() per point, with the same results.  */
+/*      The points whose status is PJ_ARRAY_SKIP are left untouched.    */
+/*      The status of the others is set to 0, or to the error code      */
+/*      pj_inv() would have set, in which case they are set to          */
+/*      HUGE_VAL.                                                       */
+/*                                                                      */
+/*      The kernels still project one point at a time with the scalar  */
+/*      formulas, so this only saves the per point call overhead of     */
+/*      pj_inv(), not the cost of the projection math itself.           */
+/************************************************************************/
+
+void pj_inv_array(PJ *P, long n, double *x, double *y, int *status) {
+	long i;
+	const double to_meter = P->to_meter, ra = P->ra;
+	const double x0 = P->x0, y0 = P->y0;
+	const double lam0 = P->lam0;
+
+	/* descale and de-offset */
+	for (i = 0; i < n; i++) {
+		if (status[i] == PJ_ARRAY_SKIP)
+			continue;
+		if (x[i] == HUGE_VAL || y[i] == HUGE_VAL) {
+			status[i] = -15;
+			continue;
+		}
+		status[i] = 0;
+		x[i] = (x[i] * to_meter - x0) * ra;
+		y[i] = (y[i] * to_meter - y0) * ra;
+	}
+
+	/* inverse project */
+	P->ctx->last_errno = 0;
+	pj_errno = 0;
+	errno = 0;
+	(*P->inv_array)(P, n, x, y, status);
+
+	/* reduce from del lam */
+	for (i = 0; i < n; i++) {
+		if (status[i] == 0) {
+			x[i] += lam0;
+			if (!P->over)
+				x[i] = adjlon(x[i]); /* adjust longitude to CM */
+			if (P->geoc && fabs(fabs(y[i])-M_HALFPI) > EPS)
+				y[i] = atan(P->one_es * tan(y[i]));
+		}
+		else if (status[i] != PJ_ARRAY_SKIP)
+			x[i] = y[i] = HUGE_VAL;
+	}
+}
@@ -71,6 +71,68 @@ static const int transient_error[50] = {
     /* 30 to 39 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     /* 40 to 49 */ 0, 0, 0, 0, 0, 0, 0, 0, 1, 0 };
 
+/************************************************************************/
+/*                         pj_transform_array()                         */
+/*                                                                      */
+/*      Run pj_fwd_array() or pj_inv_array() over the points, with      */
+/*      the same results, error code and last_errno as calling pj_fwd() */
+/*      or pj_inv() per point in pj_transform().  This is done by       */
+/*      blocks, so that the points from the first one that fails with   */
+/*      a non transient error can be restored, as the per point loop    */
+/*      stops there.                                                    */
+/*                                                                      */
+/*      Only the projection steps are batched.  The datum shift still   */
+/*      goes through pj_datum_transform(), which handles the points     */
+/*      one by one as before.                                           */
+/************************************************************************/
+
+#define ARRAY_BLOCK_SIZE 256
+
+static int pj_transform_array( PJ *defn,
+                               void (*array_func)(PJ *, long, double *,
+                                                  double *, int *),
+                               long point_count, double *x, double *y )
+
+{
+    double x_saved[ARRAY_BLOCK_SIZE], y_saved[ARRAY_BLOCK_SIZE];
+    int status[ARRAY_BLOCK_SIZE];
+    int last_errno = defn->ctx->last_errno;
+    long start, i;
+
+    for( start = 0; start < point_count; start += ARRAY_BLOCK_SIZE )
+    {
+        const long n = MIN(ARRAY_BLOCK_SIZE, point_count - start);
+        double *bx = x + start, *by = y + start;
+
+        for( i = 0; i < n; i++ )
+            status[i] = (bx[i] == HUGE_VAL) ? PJ_ARRAY_SKIP : 0;
+        memcpy( x_saved, bx, n * sizeof(double) );
+        memcpy( y_saved, by, n * sizeof(double) );
+
+        array_func( defn, n, bx, by, status );
+
+        for( i = 0; i < n; i++ )
+        {
+            const int err = status[i];
+
+            if( err == PJ_ARRAY_SKIP )
+                continue;
+            last_errno = err;
+            if( err != 0 && err != 33 /*EDOM*/ && err != 34 /*ERANGE*/
+                && (err > 0 || err < -44 || transient_error[-err] == 0) )
+            {
+                memcpy( bx + i, x_saved + i, (n - i) * sizeof(double) );
+                memcpy( by + i, y_saved + i, (n - i) * sizeof(double) );
+                pj_ctx_set_errno( defn->ctx, err );
+                return err;
+            }
+        }
+    }
+
+    defn->ctx->last_errno = last_errno;
+    return 0;
+}
+
 /************************************************************************/
 /*                            pj_transform()                            */
 /*                                                                      */
@@ -208,6 +270,15 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
             }
 
         }
+        else if( srcdefn->inv_array != NULL && point_offset == 1
+                 && point_count > 1 )
+        {
+            /* Batched 2d inversion of the whole arrays */
+            int err = pj_transform_array( srcdefn, pj_inv_array,
+                                          point_count, x, y );
+            if( err != 0 )
+                return err;
+        }
         else
         {
             /* Fallback to the original PROJ.4 API 2d inversion - inv */
@@ -379,6 +450,15 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
             }
 
         }
+        else if( dstdefn->fwd_array != NULL && point_offset == 1
+                 && point_count > 1 )
+        {
+            /* Batched 2d projection of the whole arrays */
+            int err = pj_transform_array( dstdefn, pj_fwd_array,
+                                          point_count, x, y );
+            if( err != 0 )
+                return err;
+        }
         else
         {
             for( i = 0; i < point_count; i++ )
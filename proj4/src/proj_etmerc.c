@@ -232,6 +232,10 @@ static LP e_inverse (XY xy, PJ *P) {          /* Ellipsoidal, inverse */
 
 
 
+FORWARD_ARRAY(e_forward_array, e_forward)
+INVERSE_ARRAY(e_inverse_array, e_inverse)
+
+
 static void *freeup_new (PJ *P) {                       /* Destructor */
     if (0==P)
         return 0;
@@ -329,6 +333,8 @@ static PJ *setup(PJ *P) { /* general initialization */
     Q->Zb  = - Q->Qn*(Z + clens(Q->gtu, PROJ_ETMERC_ORDER, 2*Z));
     P->inv = e_inverse;
     P->fwd = e_forward;
+    P->inv_array = e_inverse_array;
+    P->fwd_array = e_forward_array;
 	return P;
 }
 
@@ -265,6 +265,12 @@ typedef struct PJconsts {
     void (*spc)(LP, struct PJconsts *, struct FACTORS *);
     void (*pfree)(struct PJconsts *);
 
+    /* optional batched versions of fwd and inv, used by pj_fwd_array() */
+    /* and pj_inv_array().  They only save the per point call overhead: */
+    /* the points are still projected one at a time */
+    void (*fwd_array)(struct PJconsts *, long, double *, double *, int *);
+    void (*inv_array)(struct PJconsts *, long, double *, double *, int *);
+
     const char *descr;
     paralist *params;           /* parameter list */
     int over;                   /* over-range flag */
@@ -375,6 +381,33 @@ extern struct PJ_PRIME_MERIDIANS pj_prime_meridians[];
 #define FORWARD3D(name) static XYZ name(LPZ lpz, PJ *P) {XYZ xyz = {0.0, 0.0, 0.0}
 #define INVERSE3D(name) static LPZ name(XYZ xyz, PJ *P) {LPZ lpz = {0.0, 0.0, 0.0}
 #define FREEUP static void freeup(PJ *P) {
+/* batched version of a fwd or inv function, that projects in place the */
+/* points of n whose status is 0, and sets the status of the ones that */
+/* fail to their error code */
+#define FORWARD_ARRAY(name, fwd) \
+static void name(PJ *P, long n, double *x, double *y, int *status) { \
+    long i; \
+    for (i = 0; i < n; i++) { \
+        LP lp; XY xy; \
+        if (status[i]) continue; \
+        lp.lam = x[i]; lp.phi = y[i]; \
+        xy = fwd(lp, P); \
+        if (P->ctx->last_errno) { \
+            status[i] = P->ctx->last_errno; P->ctx->last_errno = 0; \
+            continue; } \
+        x[i] = xy.x; y[i] = xy.y; } }
+#define INVERSE_ARRAY(name, inv) \
+static void name(PJ *P, long n, double *x, double *y, int *status) { \
+    long i; \
+    for (i = 0; i < n; i++) { \
+        XY xy; LP lp; \
+        if (status[i]) continue; \
+        xy.x = x[i]; xy.y = y[i]; \
+        lp = inv(xy, P); \
+        if (P->ctx->last_errno) { \
+            status[i] = P->ctx->last_errno; P->ctx->last_errno = 0; \
+            continue; } \
+        x[i] = lp.lam; y[i] = lp.phi; } }
 #define SPECIAL(name) static void name(LP lp, PJ *P, struct FACTORS *fac)
 #define ELLIPSOIDAL(P) ((P->es==0)? (FALSE): (TRUE))
 
@@ -471,6 +504,11 @@ double dmstor_ctx(projCtx ctx, const char *, char **);
 void set_rtodms(int, int);
 char *rtodms(char *, double, int, int);
 double adjlon(double);
+/* status of the points that pj_fwd_array() and pj_inv_array() must leave */
+/* untouched (not an error code) */
+#define PJ_ARRAY_SKIP 0x7fffffff
+void pj_fwd_array(PJ *, long, double *, double *, int *);
+void pj_inv_array(PJ *, long, double *, double *, int *);
 double aacos(projCtx,double), aasin(projCtx,double), asqrt(double), aatan2(double, double);
 PROJVALUE pj_param(projCtx ctx, paralist *, const char *);
 paralist *pj_mkparam(char *);